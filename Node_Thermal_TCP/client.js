@@ -1,380 +1,265 @@
 
-const net = require("net");
+const fs = require("fs");
 const WebSocket = require("ws");
 const express = require("express");
 const http = require("http");
 const path = require("path");
+const { HistoryStore } = require("./history");
+const { Device, RAW_FRAME_SIZE } = require("./device");
+const { startWorker, stopWorker } = require("./fleetWorker");
 
-const FRAME_WIDTH = 80;
-const FRAME_HEIGHT = 62;
-const RAW_FRAME_SIZE = FRAME_WIDTH * FRAME_HEIGHT * 2; // 9920 bytes (actual image)
-const HEADER_ROWS = 1;
-const HEADER_SIZE = FRAME_WIDTH * HEADER_ROWS * 2; // 160 bytes (first row is header)
-const TCP_FRAME_SIZE = FRAME_WIDTH * 64 * 2; // 10240 bytes (80x64 total from ESP32)
-
-let frameBuffer = Buffer.alloc(0);
-let cmdBuffer = Buffer.alloc(0);
-let frameClient = null;
-let cmdClient = null;
-let frameReconnectTimeout = null;
-let cmdReconnectTimeout = null;
-let quadrantPollInterval = null;
-
+// Single camera setup, used when there is no fleet config
 const ESP32_HOST = "192.168.4.213"; // your ESP32 IP
-const FRAME_PORT = 3333;  // Frame streaming
-const CMD_PORT = 3334;    // Commands (WREG/RREG/RRSE)
-
-// Quadrant state
-let quadrantConfig = {
-  xSplit: 40,
-  ySplit: 31,
-  aMax: 0, aCenter: 0,
-  bMax: 0, bCenter: 0,
-  cMax: 0, cCenter: 0,
-  dMax: 0, dCenter: 0
-};
-
-// Pending register read callbacks
-const pendingReads = new Map();
-
-// ============ Protocol Helpers ============
-
-function buildPacket(command, data = "") {
-  const payload = command + data;
-  const length = (payload.length + 4).toString(16).toUpperCase().padStart(4, "0");
-  return `   #${length}${payload}XXXX`;
-}
+const FRAME_TRANSPORT = "tcp"; // "udp" for firmware built with CONFIG_MI_SER_MODE_UDP
+const UDP_MULTICAST_GROUP = null; // e.g. "239.255.83.88" for firmware built with CONFIG_MI_UDP_MULTICAST
+
+// Fleet config: { "workers": 0, "devices": [{ "id": "hood-1", "host": "hood-1.local", "transport": "tcp" }] }
+// With workers > 0 the devices are split over that many worker threads
+const FLEET_CONFIG = process.env.FLEET_CONFIG || path.join(__dirname, "fleet.json");
+
+// Browser messages: an 8 byte header, then a packed payload, all little-endian.
+// Header: [type u8][version u8][device u16][sequence u32], device is the index in /api/devices
+const WS_MSG_HEADER_SIZE = 8;
+const WS_MSG_VERSION = 1;
+const WS_MSG_FRAME = 0x01;    // 80x62 uint16 pixels, sequence is the ESP32 capture sequence
+const WS_MSG_QUADRANT = 0x02; // uint16 xSplit, ySplit, then max and center of A, B, C, D
+const WS_QUADRANT_SIZE = 20;
+const WS_MAX_BUFFERED = 3 * RAW_FRAME_SIZE; // A browser further behind skips frames
+
+// Trends of the quadrant registers and frame min/max, served on /api/history
+const HISTORY_MAX_WINDOW = 7 * 24 * 3600;
+const HISTORY_DEFAULT_POINTS = 600;
+const HISTORY_MAX_POINTS = 5000;
+const QUADRANT_METRICS = ["aMax", "aCenter", "bMax", "bCenter", "cMax", "cCenter", "dMax", "dCenter"];
+
+function loadFleetConfig() {
+  if (!fs.existsSync(FLEET_CONFIG)) {
+    return {
+      workers: 0,
+      devices: [{ id: "esp32", host: ESP32_HOST, transport: FRAME_TRANSPORT, multicastGroup: UDP_MULTICAST_GROUP }]
+    };
+  }
 
-function buildWREG(address, value) {
-  const addr = address.toString(16).toUpperCase().padStart(2, "0");
-  const val = value.toString(16).toUpperCase().padStart(2, "0");
-  return buildPacket("WREG", addr + val);
+  const config = JSON.parse(fs.readFileSync(FLEET_CONFIG, "utf8"));
+  const devices = (config.devices || []).map((d, i) => ({
+    id: String(d.id || d.host || i),
+    host: d.host,
+    transport: d.transport || "tcp",
+    multicastGroup: d.multicastGroup || null,
+    framePort: d.framePort || undefined,
+    cmdPort: d.cmdPort || undefined
+  }));
+  if (devices.length === 0 || devices.some(d => !d.host)) {
+    throw new Error(`${FLEET_CONFIG}: every device needs a host`);
+  }
+  return { workers: Math.max(0, config.workers | 0), devices };
 }
 
-function buildRREG(address) {
-  const addr = address.toString(16).toUpperCase().padStart(2, "0");
-  return buildPacket("RREG", addr);
-}
+// ============ Fleet ============
 
-function buildRRSE(addresses) {
-  const data = addresses.map(a => a.toString(16).toUpperCase().padStart(2, "0")).join("") + "FF";
-  return buildPacket("RRSE", data);
-}
+const fleet = loadFleetConfig();
+const devices = []; // Index is the device number in browser messages
+const workers = [];
 
-function sendCommand(packet) {
-  if (cmdClient && !cmdClient.destroyed) {
-    cmdClient.write(packet);
-  }
-}
+if (fleet.workers > 0) {
+  // Round robin, so each worker gets a similar share of the cameras
+  const shares = Array.from({ length: Math.min(fleet.workers, fleet.devices.length) }, () => []);
+  fleet.devices.forEach((config, i) => shares[i % shares.length].push(config));
 
-function writeRegister(address, value) {
-  sendCommand(buildWREG(address, value));
+  const byId = new Map();
+  for (const share of shares) {
+    const started = startWorker(share);
+    workers.push(started.worker);
+    started.devices.forEach(d => byId.set(d.id, d));
+  }
+  fleet.devices.forEach(config => devices.push(byId.get(config.id)));
+} else {
+  fleet.devices.forEach(config => devices.push(new Device(config)));
 }
 
-function readRegister(address, callback) {
-  pendingReads.set(address, callback);
-  sendCommand(buildRREG(address));
-}
+const deviceIndex = new Map(devices.map((d, i) => [d.id, i]));
+const histories = devices.map(() => new HistoryStore());
+const quadrantSequences = new Uint32Array(devices.length);
 
-function readQuadrantRegisters() {
-  // Read all quadrant registers: C0-C9
-  const addresses = [0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9];
-  sendCommand(buildRRSE(addresses));
+function findDevice(id) {
+  // By id, or by index for ids that are numbers
+  if (deviceIndex.has(id)) return deviceIndex.get(id);
+  const index = Number(id);
+  return Number.isInteger(index) && index >= 0 && index < devices.length ? index : -1;
 }
 
-function parseRRSEResponse(data) {
-  // Parse RRSE response: pairs of [addr][value]
-  // Quadrant registers (C0-C9) return 4-byte values, others return 2-byte values
-  const results = {};
-  let offset = 0;
-
-  while (offset < data.length) {
-    if (offset + 2 > data.length) break;
-    const addrStr = data.substring(offset, offset + 2);
-    const addr = parseInt(addrStr, 16);
-    offset += 2;
-
-    // Quadrant registers (0xC0-0xC9) are 16-bit, others are 8-bit
-    const isQuadrantReg = addr >= 0xC0 && addr <= 0xC9;
-    const valueLen = isQuadrantReg ? 4 : 2;
-
-    if (offset + valueLen > data.length) break;
-    const valueStr = data.substring(offset, offset + valueLen);
-    const value = parseInt(valueStr, 16);
-    offset += valueLen;
-
-    results[addr] = value;
-  }
-
-  return results;
+function buildWsMessage(type, device, sequence, payloadSize) {
+  // A new buffer per message: ws may still be sending the previous one
+  const message = Buffer.allocUnsafe(WS_MSG_HEADER_SIZE + payloadSize);
+  message[0] = type;
+  message[1] = WS_MSG_VERSION;
+  message.writeUInt16LE(device, 2);
+  message.writeUInt32LE(sequence >>> 0, 4);
+  return message;
 }
 
-function updateQuadrantFromRRSE(results) {
-  if (results[0xC0] !== undefined) quadrantConfig.xSplit = results[0xC0];
-  if (results[0xC1] !== undefined) quadrantConfig.ySplit = results[0xC1];
-  if (results[0xC2] !== undefined) quadrantConfig.aMax = results[0xC2];
-  if (results[0xC3] !== undefined) quadrantConfig.aCenter = results[0xC3];
-  if (results[0xC4] !== undefined) quadrantConfig.bMax = results[0xC4];
-  if (results[0xC5] !== undefined) quadrantConfig.bCenter = results[0xC5];
-  if (results[0xC6] !== undefined) quadrantConfig.cMax = results[0xC6];
-  if (results[0xC7] !== undefined) quadrantConfig.cCenter = results[0xC7];
-  if (results[0xC8] !== undefined) quadrantConfig.dMax = results[0xC8];
-  if (results[0xC9] !== undefined) quadrantConfig.dCenter = results[0xC9];
-
-  broadcastQuadrantConfig();
+function buildQuadrantMessage(index) {
+  const q = devices[index].quadrantConfig;
+  const values = [q.xSplit, q.ySplit, q.aMax, q.aCenter, q.bMax, q.bCenter, q.cMax, q.cCenter, q.dMax, q.dCenter];
+  const message = buildWsMessage(WS_MSG_QUADRANT, index, quadrantSequences[index]++, WS_QUADRANT_SIZE);
+  values.forEach((value, i) => message.writeUInt16LE(value & 0xFFFF, WS_MSG_HEADER_SIZE + i * 2));
+  return message;
 }
 
-function broadcastQuadrantConfig() {
-  const message = JSON.stringify({ type: "quadrant", data: quadrantConfig });
+function broadcastQuadrantConfig(index) {
+  const message = buildQuadrantMessage(index);
   for (const wsClient of wss.clients) {
-    if (wsClient.readyState === WebSocket.OPEN) {
+    if (wsClient.readyState === WebSocket.OPEN && wsClient.devices.has(index)) {
       wsClient.send(message);
     }
   }
 }
 
-// Web UI
-const app = express();
-app.use(express.static(path.join(__dirname, "public")));
-const server = http.createServer(app);
-const wss = new WebSocket.Server({ server });
+function broadcastFrame(index, sequence, image) {
+  // One message per frame, shared by every browser watching this device
+  let message = null;
 
-function broadcastFrame(frame) {
-  const message = JSON.stringify({ type: "frame" });
   for (const wsClient of wss.clients) {
-    if (wsClient.readyState === WebSocket.OPEN) {
-      // Send frame as binary
-      wsClient.send(frame);
+    if (wsClient.readyState !== WebSocket.OPEN || !wsClient.devices.has(index)) continue;
+
+    // A slow browser skips frames instead of queueing them in Node
+    if (wsClient.bufferedAmount > WS_MAX_BUFFERED) {
+      wsClient.skippedFrames++;
+      continue;
+    }
+    if (!message) {
+      message = buildWsMessage(WS_MSG_FRAME, index, sequence, RAW_FRAME_SIZE);
+      image.copy(message, WS_MSG_HEADER_SIZE);
     }
+    wsClient.send(message);
   }
 }
 
-// ============ TCP Data Parser ============
+devices.forEach((device, index) => {
+  const history = histories[index];
 
-// The ESP32 sends raw thermal frames as a continuous stream
-// Protocol-wrapped responses (RRSE, RREG, WREG) are interleaved
+  device.on("frame", (sequence, image) => broadcastFrame(index, sequence, image));
 
-function findPacketStart(buffer, startFrom = 0) {
-  // Look for "   #" pattern
-  for (let i = startFrom; i < buffer.length - 3; i++) {
-    if (buffer[i] === 0x20 && buffer[i + 1] === 0x20 && buffer[i + 2] === 0x20 && buffer[i + 3] === 0x23) {
-      return i;
+  device.on("quadrant", (config) => {
+    for (const metric of QUADRANT_METRICS) {
+      history.record(metric, config[metric]);
     }
-  }
-  return -1;
-}
+    broadcastQuadrantConfig(index);
+  });
 
-function processProtocolPacket(buffer) {
-  // Parse a protocol packet starting at buffer position 0
-  // Returns: { consumed: bytes_consumed, command: string } or null if incomplete
+  // The ESP32 already computed the frame range, recording it costs no pixel scan
+  device.on("stats", (min, max) => {
+    history.record("frameMin", min);
+    history.record("frameMax", max);
+  });
+});
 
-  if (buffer.length < 8) return null;
+// Web UI
+const app = express();
+app.use(express.static(path.join(__dirname, "public")));
 
-  const lengthStr = buffer.slice(4, 8).toString("ascii");
-  const payloadLen = parseInt(lengthStr, 16);
+// /api/devices: connection state, throughput and latency of every camera
+app.get("/api/devices", (req, res) => {
+  res.json(devices.map((device, index) => ({ index, ...device.metrics() })));
+});
 
-  if (isNaN(payloadLen) || payloadLen < 8 || payloadLen > 15000) {
-    // Invalid - not a real protocol packet (GFRA frames are ~10248 bytes)
-    return null;
+// /api/history lists the metrics, /api/history?metric=aMax&window=86400&points=600
+// returns the last window seconds as time/min/max/avg arrays from the rollups.
+// device=<id> selects the camera, the first one by default
+app.get("/api/history", (req, res) => {
+  const index = req.query.device === undefined ? 0 : findDevice(String(req.query.device));
+  if (index < 0) {
+    res.status(404).json({ error: "Unknown device" });
+    return;
   }
+  const camera = devices[index].id;
+  const history = histories[index];
 
-  const totalPacketLen = 4 + 4 + payloadLen;
-  if (buffer.length < totalPacketLen) return null;
-
-  const command = buffer.slice(8, 12).toString("ascii");
-
-  if (command === "RRSE") {
-    const data = buffer.slice(12, 8 + payloadLen - 4).toString("ascii");
-    const results = parseRRSEResponse(data);
-    updateQuadrantFromRRSE(results);
-  } else if (command === "RREG") {
-    const data = buffer.slice(12, 8 + payloadLen - 4).toString("ascii");
-    if (data.length >= 4) {
-      const addr = parseInt(data.substring(0, 2), 16);
-      const isQuadrantReg = addr >= 0xC0 && addr <= 0xC9;
-      const valueStr = data.substring(2, isQuadrantReg ? 6 : 4);
-      const value = parseInt(valueStr, 16);
-
-      const callback = pendingReads.get(addr);
-      if (callback) {
-        callback(value);
-        pendingReads.delete(addr);
-      }
-    }
+  if (!req.query.metric) {
+    res.json({ camera, metrics: history.metricNames() });
+    return;
   }
-  // WREG acknowledgments are silently consumed
-
-  return { consumed: totalPacketLen, command };
-}
 
-function processCommandData() {
-  // Process protocol packets from command port
-  let protocolIdx = findPacketStart(cmdBuffer);
-  while (protocolIdx !== -1 && protocolIdx < cmdBuffer.length) {
-    const packetBuffer = cmdBuffer.slice(protocolIdx);
-    const result = processProtocolPacket(packetBuffer);
-
-    if (result) {
-      // Remove the protocol packet from the buffer
-      const before = cmdBuffer.slice(0, protocolIdx);
-      const after = cmdBuffer.slice(protocolIdx + result.consumed);
-      cmdBuffer = Buffer.concat([before, after]);
-      protocolIdx = findPacketStart(cmdBuffer);
-    } else {
-      break;
-    }
-  }
-}
+  const windowSeconds = Math.min(HISTORY_MAX_WINDOW, Math.max(1, Number(req.query.window) || 3600));
+  const points = Math.min(HISTORY_MAX_POINTS, Math.max(1, Number(req.query.points) || HISTORY_DEFAULT_POINTS));
+  const result = history.query(String(req.query.metric), windowSeconds, points);
 
-function processFrameData() {
-  // Process raw thermal frames (ESP32 sends 80x64, first row is header)
-  while (frameBuffer.length >= TCP_FRAME_SIZE) {
-    // Skip header row, copy actual image data
-    const frame = Buffer.from(frameBuffer.slice(HEADER_SIZE, HEADER_SIZE + RAW_FRAME_SIZE));
-    frameBuffer = frameBuffer.slice(TCP_FRAME_SIZE);
-    broadcastFrame(frame);
+  if (!result) {
+    res.status(404).json({ error: "Unknown metric" });
+    return;
   }
-}
-
-function connectFramePort(retryDelay = 3000) {
-  if (frameClient) {
-    frameClient.destroy();
-    frameClient = null;
-  }
-
-  frameClient = new net.Socket();
-
-  frameClient.connect(FRAME_PORT, ESP32_HOST, () => {
-    console.log(`Connected to ESP32 frame port at ${ESP32_HOST}:${FRAME_PORT}`);
-    frameBuffer = Buffer.alloc(0);
-  });
-
-  frameClient.setTimeout(5000);
-
-  frameClient.on("timeout", () => {
-    console.warn("Frame port connection timed out");
-    frameClient.destroy();
-  });
-
-  frameClient.on("data", (data) => {
-    frameBuffer = Buffer.concat([frameBuffer, data]);
-    processFrameData();
-  });
-
-  frameClient.on("error", (err) => {
-    console.error("Frame port error:", err.message);
-    frameClient.destroy();
-  });
+  res.json({ camera, ...result });
+});
+const server = http.createServer(app);
+const wss = new WebSocket.Server({ server });
 
-  frameClient.on("close", () => {
-    console.log("Frame port connection closed");
-    if (!frameReconnectTimeout) {
-      frameReconnectTimeout = setTimeout(() => {
-        frameReconnectTimeout = null;
-        console.log("Reconnecting to frame port...");
-        connectFramePort();
-      }, retryDelay);
+function subscribe(ws, ids) {
+  // Device ids or indexes, "*" for all. Unknown ones are ignored
+  ws.devices = new Set();
+  for (const id of ids) {
+    if (id === "*") {
+      devices.forEach((d, i) => ws.devices.add(i));
+    } else if (findDevice(String(id)) >= 0) {
+      ws.devices.add(findDevice(String(id)));
     }
-  });
-}
-
-function connectCommandPort(retryDelay = 3000) {
-  if (cmdClient) {
-    cmdClient.destroy();
-    cmdClient = null;
   }
+  if (ws.devices.size === 0) ws.devices.add(0);
 
-  if (quadrantPollInterval) {
-    clearInterval(quadrantPollInterval);
-    quadrantPollInterval = null;
+  // Current quadrant config of every subscribed device
+  for (const index of ws.devices) {
+    ws.send(buildQuadrantMessage(index));
   }
-
-  cmdClient = new net.Socket();
-
-  cmdClient.connect(CMD_PORT, ESP32_HOST, () => {
-    console.log(`Connected to ESP32 command port at ${ESP32_HOST}:${CMD_PORT}`);
-    cmdBuffer = Buffer.alloc(0);
-
-    // Start polling quadrant registers
-    setTimeout(() => {
-      readQuadrantRegisters();
-    }, 500);
-
-    quadrantPollInterval = setInterval(() => {
-      readQuadrantRegisters();
-    }, 1000);
-  });
-
-  cmdClient.setTimeout(10000);
-
-  cmdClient.on("timeout", () => {
-    console.warn("Command port connection timed out");
-    cmdClient.destroy();
-  });
-
-  cmdClient.on("data", (data) => {
-    cmdBuffer = Buffer.concat([cmdBuffer, data]);
-    processCommandData();
-  });
-
-  cmdClient.on("error", (err) => {
-    console.error("Command port error:", err.message);
-    cmdClient.destroy();
-  });
-
-  cmdClient.on("close", () => {
-    console.log("Command port connection closed");
-    if (quadrantPollInterval) {
-      clearInterval(quadrantPollInterval);
-      quadrantPollInterval = null;
-    }
-    if (!cmdReconnectTimeout) {
-      cmdReconnectTimeout = setTimeout(() => {
-        cmdReconnectTimeout = null;
-        console.log("Reconnecting to command port...");
-        connectCommandPort();
-      }, retryDelay);
-    }
-  });
 }
 
 // ============ WebSocket Message Handling ============
 
-wss.on("connection", (ws) => {
+wss.on("connection", (ws, req) => {
   console.log("Browser client connected");
+  ws.skippedFrames = 0;
 
-  // Send current quadrant config to new client
-  ws.send(JSON.stringify({ type: "quadrant", data: quadrantConfig }));
+  // ?device=hood-1 or ?devices=hood-1,hood-2 (or "*") picks the cameras, the first one by default
+  const query = new URL(req.url, "http://localhost").searchParams;
+  subscribe(ws, (query.get("devices") || query.get("device") || "").split(",").filter(Boolean));
 
   ws.on("message", (message) => {
     try {
       const msg = JSON.parse(message);
 
+      // Controls act on msg.device, or on the first subscribed camera
+      const index = msg.device !== undefined ? findDevice(String(msg.device)) : ws.devices.values().next().value;
+      if (index < 0) return;
+      const device = devices[index];
+      const quadrantConfig = device.quadrantConfig;
+
       switch (msg.type) {
+        case "subscribe":
+          subscribe(ws, Array.isArray(msg.devices) ? msg.devices : []);
+          break;
+
         case "setXsplit":
           const xVal = Math.max(0, Math.min(80, parseInt(msg.value)));
-          writeRegister(0xC0, xVal);
+          device.writeRegister(0xC0, xVal);
           quadrantConfig.xSplit = xVal;
-          broadcastQuadrantConfig();
+          broadcastQuadrantConfig(index);
           break;
 
         case "setYsplit":
           const yVal = Math.max(0, Math.min(64, parseInt(msg.value)));
-          writeRegister(0xC1, yVal);
+          device.writeRegister(0xC1, yVal);
           quadrantConfig.ySplit = yVal;
-          broadcastQuadrantConfig();
+          broadcastQuadrantConfig(index);
           break;
 
         case "resetDefaults":
-          writeRegister(0xC0, 40);
-          writeRegister(0xC1, 31);
+          device.writeRegister(0xC0, 40);
+          device.writeRegister(0xC1, 31);
           quadrantConfig.xSplit = 40;
           quadrantConfig.ySplit = 31;
-          broadcastQuadrantConfig();
+          broadcastQuadrantConfig(index);
           break;
 
         case "getQuadrantConfig":
-          readQuadrantRegisters();
+          device.readQuadrantRegisters();
           break;
       }
     } catch (e) {
@@ -383,13 +268,25 @@ wss.on("connection", (ws) => {
   });
 
   ws.on("close", () => {
-    console.log("Browser client disconnected");
+    console.log(`Browser client disconnected, ${ws.skippedFrames} frames skipped`);
   });
 });
 
-// Connect to both ESP32 ports
-connectFramePort();
-connectCommandPort();
+// Connect to every ESP32, workers started their own devices
+if (workers.length === 0) {
+  devices.forEach(device => device.start());
+}
+console.log(`Fleet: ${devices.length} camera(s)${workers.length ? ` in ${workers.length} worker thread(s)` : ""}`);
+
+process.on("SIGINT", () => {
+  // UDP devices say goodbye so the ESP32 stops sending at once
+  const stoppers = workers.length
+    ? workers.map(worker => (done) => stopWorker(worker, done))
+    : devices.map(device => (done) => device.stop(done));
+  let pending = stoppers.length;
+  stoppers.forEach(stop => stop(() => { if (--pending === 0) process.exit(0); }));
+  setTimeout(() => process.exit(0), 1000).unref();
+});
 
 server.listen(8080, () => {
   console.log("🌐 WebSocket/HTTP server ready at http://localhost:8080");
@@ -0,0 +1,892 @@
+const net = require("net");
+const dgram = require("dgram");
+const EventEmitter = require("events");
+const { REGISTER_DIGITS } = require("./registers");
+const {
+  STREAM_MAGIC, UDP_CHUNK_MAGIC, UDP_HELLO_MAGIC, UDP_BYE_MAGIC,
+  STREAM_ENCODING_RAW16, STREAM_ENCODING_DELTA, STREAM_ENCODING_DELTA_LZ, STREAM_ENCODING_PACK12, STREAM_ENCODING_PACK8,
+  STREAM_FLAG_KEYFRAME, STREAM_FLAG_STATS, STREAM_FLAG_BLOBS, STREAM_FLAG_UTC,
+  STREAM_HEADER, FRAME_STATS, BLOB_ENTRY, CMD_WREG, CMD_RREG, CMD_RRSE, CMD_SFMT,
+  hexValue, buildPacket, findPacket, decodePacket, PACKET_PREFIX,
+  StreamHeaderView, FrameStatsView, BlobRecordView, UdpChunkHeaderView
+} = require("./protocol");
+
+const FRAME_WIDTH = 80;
+const FRAME_HEIGHT = 62;
+const RAW_FRAME_SIZE = FRAME_WIDTH * FRAME_HEIGHT * 2; // 9920 bytes (actual image)
+const HEADER_ROWS = 1;
+const HEADER_SIZE = FRAME_WIDTH * HEADER_ROWS * 2; // 160 bytes (first row is header)
+const TCP_FRAME_SIZE = FRAME_WIDTH * 64 * 2; // 10240 bytes (80x64 total from ESP32)
+
+const FRAME_PORT = 3333;  // Frame streaming
+const CMD_PORT = 3334;    // Commands (WREG/RREG/RRSE)
+
+// v2 stream format: every frame is preceded by a header, layouts in protocol.js (see protocol.md)
+const STREAM_FORMAT_FRAMED = 0x02;
+const STREAM_HEADER_MIN_SIZE = STREAM_HEADER.STATS; // Fields before the statistics
+const PACK_HEADER_WORDS = 8;  // Frame header words ahead of a packed image
+const PACK_SCALE_SIZE = 4;    // Minimum, shift and bits ahead of the packed pixels
+const PACK_IMAGE_OFFSET = FRAME_WIDTH * 2; // The image starts after the 2 header rows of the device frame
+const STREAM_STATS_MIN_SIZE = STREAM_HEADER.STATS + FRAME_STATS.MEAN; // Up to the frame min and max
+const LZ_MIN_MATCH = 4;
+const STREAM_ENCODING = STREAM_ENCODING_DELTA_LZ; // Encoding requested from the ESP32
+
+// UDP stream: v2 frames split into datagram chunks (see protocol.md)
+const UDP_CHUNK_DATA = 1456; // Frame bytes per chunk
+const UDP_FRAME_MAX = TCP_FRAME_SIZE + 256; // v2 header and raw payload, with room for header growth
+
+// Receive buffers, allocated once per device
+const FRAME_STREAM_SIZE = 65536; // Several v2 frames, even raw ones
+const CMD_STREAM_SIZE = 32768;   // Twice the longest packet
+const FRAME_PIXELS = TCP_FRAME_SIZE / 2;
+
+// Reconnect backoff per socket: doubles from the first delay up to the last
+const RECONNECT_MIN_MS = 1000;
+const RECONNECT_MAX_MS = 30000;
+
+// One timer for every device in this thread: quadrant polls, UDP hellos and the metrics
+const TICK_MS = 1000;
+
+const QUADRANT_REGISTERS = [0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9];
+
+// Fixed size receive buffer, appended at the end and consumed from the front.
+// Unread bytes only move back to the start when the tail runs out of room, so
+// parsing never allocates. When more arrives than fits, the oldest bytes are
+// dropped and the parser resyncs.
+class StreamBuffer {
+  constructor(capacity) {
+    this.buffer = Buffer.allocUnsafe(capacity);
+    this.start = 0;
+    this.end = 0;
+  }
+
+  get length() {
+    return this.end - this.start;
+  }
+
+  // Unread bytes, valid until the next append
+  view() {
+    return this.buffer.subarray(this.start, this.end);
+  }
+
+  // Returns true if unread bytes had to be dropped
+  append(data) {
+    const capacity = this.buffer.length;
+    if (data.length >= capacity) {
+      data.copy(this.buffer, 0, data.length - capacity);
+      this.start = 0;
+      this.end = capacity;
+      return true;
+    }
+
+    let dropped = false;
+    if (this.end + data.length > capacity) {
+      const excess = this.length + data.length - capacity;
+      if (excess > 0) {
+        this.start += excess;
+        dropped = true;
+      }
+      this.buffer.copyWithin(0, this.start, this.end);
+      this.end -= this.start;
+      this.start = 0;
+    }
+
+    data.copy(this.buffer, this.end);
+    this.end += data.length;
+    return dropped;
+  }
+
+  consume(count) {
+    this.start += count;
+    if (this.start >= this.end) {
+      this.start = 0;
+      this.end = 0;
+    }
+  }
+
+  clear() {
+    this.start = 0;
+    this.end = 0;
+  }
+}
+
+// ============ Protocol Helpers ============
+
+function buildWREG(address, value) {
+  const addr = address.toString(16).toUpperCase().padStart(2, "0");
+  const val = value.toString(16).toUpperCase().padStart(2, "0");
+  return buildPacket(CMD_WREG, addr + val);
+}
+
+function buildRREG(address) {
+  const addr = address.toString(16).toUpperCase().padStart(2, "0");
+  return buildPacket(CMD_RREG, addr);
+}
+
+function buildRRSE(addresses) {
+  const data = addresses.map(a => a.toString(16).toUpperCase().padStart(2, "0")).join("") + "FF";
+  return buildPacket(CMD_RRSE, data);
+}
+
+function buildSFMT(format, encoding) {
+  const hex = v => v.toString(16).toUpperCase().padStart(2, "0");
+  return buildPacket(CMD_SFMT, hex(format) + hex(encoding));
+}
+
+const RRSE_QUADRANT = buildRRSE(QUADRANT_REGISTERS);
+
+function parseRRSEResponse(buffer, offset, end) {
+  // Parse RRSE response: pairs of [addr][value]
+  // Firmware registers return 4-byte values, SenXor registers 2-byte values (registers.js)
+  const results = {};
+
+  while (offset + 2 <= end) {
+    const addr = hexValue(buffer, offset, 2);
+    if (addr < 0) break;
+    offset += 2;
+
+    const valueLen = REGISTER_DIGITS[addr];
+
+    if (offset + valueLen > end) break;
+    const value = hexValue(buffer, offset, valueLen);
+    if (value < 0) break;
+    offset += valueLen;
+
+    results[addr] = value;
+  }
+
+  return results;
+}
+
+// Views of the generated layouts, moved over the receive buffer
+const headerView = new StreamHeaderView();
+const statsView = new FrameStatsView();
+const recordView = new BlobRecordView();
+const chunkView = new UdpChunkHeaderView();
+
+function parseStreamHeader(buffer, pos) {
+  // Parse a v2 frame header at pos
+  // Returns: header fields, or null if this is not a valid header
+  const H = headerView.at(buffer, pos);
+  if (buffer.compare(STREAM_MAGIC, 0, 4, pos, pos + 4) !== 0 || H.version !== STREAM_FORMAT_FRAMED) {
+    return null;
+  }
+
+  const headerLength = H.headerLen;
+  const payloadLength = H.payloadLen;
+  const flags = H.flags;
+
+  if (headerLength < STREAM_HEADER_MIN_SIZE || payloadLength === 0 || payloadLength > TCP_FRAME_SIZE) {
+    return null;
+  }
+
+  // Fields past the minimum header are only there when headerLength covers them
+  const hasStats = (flags & STREAM_FLAG_STATS) !== 0 && headerLength >= STREAM_STATS_MIN_SIZE;
+  const stats = hasStats ? statsView.at(buffer, pos + STREAM_HEADER.STATS) : null;
+  return {
+    encoding: H.encoding,
+    headerLength,
+    sequence: H.seq,
+    timestampUs: H.timestampUs,
+    utcUs: (flags & STREAM_FLAG_UTC) !== 0 && headerLength >= STREAM_HEADER.UTC_US + 8 ? H.utcUs : null,
+    payloadLength,
+    flags,
+    hasStats,
+    min: stats ? stats.min : 0,
+    max: stats ? stats.max : 0
+  };
+}
+
+function parseBlobRecord(buffer, pos, end) {
+  // Parse the blob record from pos to end
+  // Returns: { sequence, overflow, blobs }, or null if it does not fit
+  if (end - pos < BlobRecordView.SIZE) return null;
+  const record = recordView.at(buffer, pos);
+  const count = record.count;
+  if (end - pos < BlobRecordView.SIZE + count * BLOB_ENTRY.SIZE) return null;
+
+  const blobs = [];
+  for (let i = 0; i < count; i++) {
+    const entry = record.blobs(i);
+    blobs.push({
+      id: entry.id,
+      isNew: (entry.flags & 0x01) !== 0,
+      isLost: (entry.flags & 0x02) !== 0,
+      area: entry.area,
+      peak: entry.peak,
+      peakX: entry.peakX,
+      peakY: entry.peakY,
+      x: entry.cx / 256,
+      y: entry.cy / 256
+    });
+  }
+  return { sequence: record.seq, overflow: (record.flags & 0x01) !== 0, blobs };
+}
+
+function decodeLZ(input, out) {
+  // LZ4 style block: [token][literal length...][literals][offset LE][match length...]
+  // Returns the decoded length, or -1 if the block is broken
+  const maxOut = out.length;
+  let ip = 0;
+  let op = 0;
+
+  const readLength = (len) => {
+    if (len !== 15) return len;
+    let b;
+    do {
+      if (ip >= input.length) return -1;
+      b = input[ip++];
+      len += b;
+    } while (b === 255);
+    return len;
+  };
+
+  while (ip < input.length) {
+    const token = input[ip++];
+    const litLen = readLength(token >> 4);
+    if (litLen < 0 || ip + litLen > input.length || op + litLen > maxOut) return -1;
+    input.copy(out, op, ip, ip + litLen);
+    ip += litLen;
+    op += litLen;
+
+    if (ip >= input.length) break; // Trailing literals
+
+    if (ip + 2 > input.length) return -1;
+    const offset = input[ip] | (input[ip + 1] << 8);
+    ip += 2;
+    const matchLen = readLength(token & 0x0F);
+    if (matchLen < 0 || offset === 0 || offset > op || op + matchLen + LZ_MIN_MATCH > maxOut) return -1;
+    for (let i = 0; i < matchLen + LZ_MIN_MATCH; i++, op++) {
+      out[op] = out[op - offset]; // Byte by byte, matches may overlap
+    }
+  }
+
+  return op;
+}
+
+function decodeDelta(input, ref, out) {
+  // Zigzag varint residuals, 0x00 starts a zero run
+  // ref is the previous frame, or null for a keyframe (predict from previous pixel)
+  // Returns false if the residuals are broken
+  const pixels = out.length;
+  let ip = 0;
+  let i = 0;
+  let predict = 0;
+
+  const readVarint = () => {
+    let value = 0;
+    let shift = 0;
+    let b;
+    do {
+      if (ip >= input.length || shift > 28) return -1;
+      b = input[ip++];
+      value |= (b & 0x7F) << shift;
+      shift += 7;
+    } while (b & 0x80);
+    return value >>> 0;
+  };
+
+  while (i < pixels) {
+    let zigzag = 0;
+    let count = 1;
+    if (ip >= input.length) return false;
+    if (input[ip] === 0x00) {
+      ip++;
+      count = readVarint() + 1;
+      if (count <= 0 || i + count > pixels) return false;
+    } else {
+      zigzag = readVarint();
+      if (zigzag < 0) return false;
+    }
+    const delta = (zigzag >>> 1) ^ -(zigzag & 1);
+    for (let n = 0; n < count; n++, i++) {
+      if (ref) predict = ref[i];
+      out[i] = (predict + delta) & 0xFFFF;
+      predict = out[i];
+    }
+  }
+
+  return true;
+}
+
+function decodePacked(input, out) {
+  // Header words, then the 80x62 image as an LSB first stream of 8/12/14 bit
+  // values above the frame minimum. Rebuilt into the 80x64 frame layout
+  // Returns false if the payload is broken or not a full image
+  const pixels = FRAME_WIDTH * FRAME_HEIGHT;
+  const start = PACK_HEADER_WORDS * 2 + PACK_SCALE_SIZE;
+  if (input.length < start) return false;
+
+  const min = input.readUInt16LE(start - 4);
+  const shift = input[start - 2];
+  const bits = input[start - 1];
+  if ((bits !== 8 && bits !== 12 && bits !== 14) || input.length < start + Math.ceil(pixels * bits / 8)) return false;
+
+  out.fill(0, 0, PACK_IMAGE_OFFSET);
+  for (let i = 0; i < PACK_HEADER_WORDS; i++) out[i] = input.readUInt16LE(i * 2);
+
+  const mask = (1 << bits) - 1;
+  const half = shift > 0 ? 1 << (shift - 1) : 0; // Middle of the step of a lossy value
+  let acc = 0;
+  let accBits = 0;
+  let ip = start;
+  for (let i = 0; i < pixels; i++) {
+    while (accBits < bits) {
+      acc |= input[ip++] << accBits;
+      accBits += 8;
+    }
+    out[PACK_IMAGE_OFFSET + i] = Math.min(0xFFFF, min + (acc & mask) * (1 << shift) + half);
+    acc >>>= bits;
+    accBits -= bits;
+  }
+  return true;
+}
+
+// ============ Device ============
+
+const activeDevices = new Set();
+let tickTimer = null;
+
+function tickDevices() {
+  const now = Date.now();
+  for (const device of activeDevices) device.tick(now);
+}
+
+// One ESP32 camera: its frame and command sockets, stream decoding, reconnect
+// backoff and throughput/latency metrics. Events:
+//   "frame" (sequence, image)  image is the 80x62 frame as a Buffer, valid until the next frame
+//   "quadrant" (config)        after every RRSE response
+//   "stats" (min, max)         frame range from the v2 header, when the ESP32 sends it
+//   "status" (connected)       command port up or down
+class Device extends EventEmitter {
+  constructor({ id, host, transport = "tcp", multicastGroup = null, framePort = FRAME_PORT, cmdPort = CMD_PORT }) {
+    super();
+    this.id = id;
+    this.host = host;
+    this.framePort = framePort; // Other ports only for emulated cameras, see emulator.js
+    this.cmdPort = cmdPort;
+    this.transport = transport; // "udp" for firmware built with CONFIG_MI_SER_MODE_UDP
+    this.multicastGroup = multicastGroup; // e.g. "239.255.83.88" for CONFIG_MI_UDP_MULTICAST
+
+    this.quadrantConfig = {
+      xSplit: 40,
+      ySplit: 31,
+      aMax: 0, aCenter: 0,
+      bMax: 0, bCenter: 0,
+      cMax: 0, cCenter: 0,
+      dMax: 0, dCenter: 0
+    };
+
+    this.frameStream = new StreamBuffer(FRAME_STREAM_SIZE);
+    this.cmdStream = new StreamBuffer(CMD_STREAM_SIZE);
+    this.packet = { command: 0, dataStart: 0, dataEnd: 0, sumSent: false, sumValid: false }; // Reused by decodePacket
+    this.frameClient = null;
+    this.cmdClient = null;
+    this.frameRetry = { delay: RECONNECT_MIN_MS, timer: null };
+    this.cmdRetry = { delay: RECONNECT_MIN_MS, timer: null };
+    this.udpSocket = null;
+    this.udpReady = false;
+    this.udpFrame = null; // Frame being reassembled from UDP chunks
+    this.udpFrameData = null;
+    this.udpReceived = null;
+    this.pendingReads = new Map();
+    this.running = false;
+
+    // v2 decoding, buffers allocated once. A decoded frame becomes the reference
+    // by swapping the two arrays
+    this.referenceFrame = new Uint16Array(FRAME_PIXELS); // Last decoded 80x64 frame, base of delta frames
+    this.decodedFrame = new Uint16Array(FRAME_PIXELS);
+    this.hasReference = false;
+    this.lzScratch = Buffer.allocUnsafe(TCP_FRAME_SIZE);
+
+    // Stream statistics, counters since start
+    this.lastSequence = null;
+    this.droppedFrames = 0;
+    this.resyncCount = 0;
+    this.incompleteFrames = 0;
+    this.reconnects = 0;
+    this.frames = 0;
+    this.bytes = 0;
+    this.decodeNs = 0n;
+    this.delayUs = 0;
+    this.minOffsetUs = null; // Smallest arrival minus capture time, the clock offset plus the fastest path
+    this.timeSynced = false; // Last frame carried a UTC capture time
+
+    // Rates over the last tick
+    this.rates = { fps: 0, kbps: 0, decodeMs: 0, delayMs: 0 };
+    this.lastTick = { time: Date.now(), frames: 0, bytes: 0, decodeNs: 0n, delayUs: 0 };
+  }
+
+  get connected() {
+    return this.cmdClient !== null && !this.cmdClient.connecting && !this.cmdClient.destroyed;
+  }
+
+  start() {
+    this.running = true;
+    activeDevices.add(this);
+    if (!tickTimer) {
+      tickTimer = setInterval(tickDevices, TICK_MS);
+    }
+
+    if (this.transport === "udp") {
+      this.connectFrameUdp();
+    } else {
+      this.connectFramePort();
+    }
+    this.connectCommandPort();
+  }
+
+  stop(callback) {
+    this.running = false;
+    activeDevices.delete(this);
+    if (activeDevices.size === 0 && tickTimer) {
+      clearInterval(tickTimer);
+      tickTimer = null;
+    }
+
+    clearTimeout(this.frameRetry.timer);
+    clearTimeout(this.cmdRetry.timer);
+    if (this.frameClient) this.frameClient.destroy();
+    if (this.cmdClient) this.cmdClient.destroy();
+    this.log(`${this.droppedFrames} frames dropped, ${this.resyncCount} resyncs, ${this.incompleteFrames} incomplete`);
+
+    if (this.udpSocket) {
+      const socket = this.udpSocket;
+      this.udpSocket = null;
+      socket.send(UDP_BYE_MAGIC, this.framePort, this.host, () => {
+        socket.close();
+        if (callback) callback();
+      });
+      return;
+    }
+    if (callback) callback();
+  }
+
+  log(message) {
+    console.log(`[${this.id}] ${message}`);
+  }
+
+  // Called once a second for every device by the shared timer
+  tick(now) {
+    if (this.connected) {
+      this.sendCommand(RRSE_QUADRANT);
+    }
+    if (this.udpSocket && this.udpReady) {
+      // The hello keeps this viewer registered
+      this.udpSocket.send(UDP_HELLO_MAGIC, this.framePort, this.host);
+    }
+
+    const last = this.lastTick;
+    const seconds = Math.max(0.001, (now - last.time) / 1000);
+    const frames = this.frames - last.frames;
+    this.rates = {
+      fps: frames / seconds,
+      kbps: (this.bytes - last.bytes) * 8 / 1000 / seconds,
+      decodeMs: frames ? Number(this.decodeNs - last.decodeNs) / 1e6 / frames : 0,
+      delayMs: frames ? (this.delayUs - last.delayUs) / 1000 / frames : 0
+    };
+    this.lastTick = { time: now, frames: this.frames, bytes: this.bytes, decodeNs: this.decodeNs, delayUs: this.delayUs };
+  }
+
+  metrics() {
+    return {
+      id: this.id,
+      host: this.host,
+      transport: this.transport,
+      connected: this.connected,
+      fps: Math.round(this.rates.fps * 10) / 10,
+      kbps: Math.round(this.rates.kbps),
+      decodeMs: Math.round(this.rates.decodeMs * 100) / 100,
+      delayMs: Math.round(this.rates.delayMs * 10) / 10,
+      timeSynced: this.timeSynced,
+      frames: this.frames,
+      droppedFrames: this.droppedFrames,
+      resyncs: this.resyncCount,
+      incompleteFrames: this.incompleteFrames,
+      reconnects: this.reconnects
+    };
+  }
+
+  // ============ Commands ============
+
+  sendCommand(packet) {
+    if (this.cmdClient && !this.cmdClient.destroyed) {
+      this.cmdClient.write(packet);
+    }
+  }
+
+  writeRegister(address, value) {
+    this.sendCommand(buildWREG(address, value));
+  }
+
+  readRegister(address, callback) {
+    this.pendingReads.set(address, callback);
+    this.sendCommand(buildRREG(address));
+  }
+
+  readQuadrantRegisters() {
+    this.sendCommand(RRSE_QUADRANT);
+  }
+
+  requestFramedStream() {
+    this.sendCommand(buildSFMT(STREAM_FORMAT_FRAMED, STREAM_ENCODING));
+  }
+
+  updateQuadrantFromRRSE(results) {
+    const q = this.quadrantConfig;
+    if (results[0xC0] !== undefined) q.xSplit = results[0xC0];
+    if (results[0xC1] !== undefined) q.ySplit = results[0xC1];
+    if (results[0xC2] !== undefined) q.aMax = results[0xC2];
+    if (results[0xC3] !== undefined) q.aCenter = results[0xC3];
+    if (results[0xC4] !== undefined) q.bMax = results[0xC4];
+    if (results[0xC5] !== undefined) q.bCenter = results[0xC5];
+    if (results[0xC6] !== undefined) q.cMax = results[0xC6];
+    if (results[0xC7] !== undefined) q.cCenter = results[0xC7];
+    if (results[0xC8] !== undefined) q.dMax = results[0xC8];
+    if (results[0xC9] !== undefined) q.dCenter = results[0xC9];
+
+    this.emit("quadrant", q);
+  }
+
+  processProtocolPacket(buffer, pos) {
+    // Parse the protocol packet at pos, in place
+    // Returns: bytes consumed, 0 if incomplete, -1 if this is not a packet
+    const packet = this.packet;
+    const totalPacketLen = decodePacket(buffer, pos, packet);
+    if (totalPacketLen <= 0) return totalPacketLen;
+    if (!packet.sumValid) return totalPacketLen; // Corrupted on the way, drop it
+
+    const command = packet.command;
+    const dataStart = packet.dataStart;
+    const dataEnd = packet.dataEnd;
+
+    if (command === CMD_RRSE) {
+      const results = parseRRSEResponse(buffer, dataStart, dataEnd);
+      this.updateQuadrantFromRRSE(results);
+    } else if (command === CMD_RREG) {
+      if (dataEnd - dataStart >= 4) {
+        const addr = hexValue(buffer, dataStart, 2);
+        const value = addr < 0 ? -1 : hexValue(buffer, dataStart + 2, REGISTER_DIGITS[addr]);
+
+        const callback = this.pendingReads.get(addr);
+        if (callback && value >= 0) {
+          callback(value);
+          this.pendingReads.delete(addr);
+        }
+      }
+    }
+    // WREG and SFMT acknowledgments are silently consumed
+
+    return totalPacketLen;
+  }
+
+  processCommandData() {
+    // Process protocol packets from command port, bytes between packets are dropped
+    const buffer = this.cmdStream.view();
+    let pos = 0;
+
+    for (;;) {
+      const start = findPacket(buffer, pos);
+      if (start === -1) {
+        pos = Math.max(pos, buffer.length - (PACKET_PREFIX.length - 1)); // Keep a possible partial "   #"
+        break;
+      }
+
+      const consumed = this.processProtocolPacket(buffer, start);
+      if (consumed === 0) {
+        pos = start; // Incomplete, wait for more data
+        break;
+      }
+      pos = consumed > 0 ? start + consumed : start + 1;
+    }
+
+    this.cmdStream.consume(pos);
+  }
+
+  // ============ Frame Stream ============
+
+  decodePayload(header, payload) {
+    // Decode into decodedFrame, which then becomes referenceFrame
+    // Returns false if the frame cannot be decoded yet
+    const isKey = (header.flags & STREAM_FLAG_KEYFRAME) !== 0;
+    const ref = isKey ? null : this.referenceFrame;
+    const out = this.decodedFrame;
+    let ok = false;
+
+    if (!isKey && !this.hasReference) return false; // Wait for a keyframe
+
+    if (header.encoding === STREAM_ENCODING_RAW16) {
+      if (payload.length >= TCP_FRAME_SIZE) {
+        for (let i = 0; i < FRAME_PIXELS; i++) out[i] = payload.readUInt16LE(i * 2);
+        ok = true;
+      }
+    } else if (header.encoding === STREAM_ENCODING_DELTA) {
+      ok = decodeDelta(payload, ref, out);
+    } else if (header.encoding === STREAM_ENCODING_DELTA_LZ) {
+      const length = decodeLZ(payload, this.lzScratch);
+      ok = length >= 0 && decodeDelta(this.lzScratch.subarray(0, length), ref, out);
+    } else if (header.encoding >= STREAM_ENCODING_PACK12 && header.encoding <= STREAM_ENCODING_PACK8) {
+      ok = decodePacked(payload, out);
+    }
+
+    this.hasReference = ok; // A broken frame invalidates the reference
+    if (ok) {
+      this.decodedFrame = this.referenceFrame;
+      this.referenceFrame = out;
+    }
+    return ok;
+  }
+
+  parseFrames(buffer) {
+    // Process framed thermal frames (header + 80x64 frame, first row is header)
+    // in place. Anything in front of a valid header is skipped, including raw
+    // frames sent before the ESP32 switched format. Returns the bytes consumed
+    let pos = 0;
+
+    while (buffer.length - pos >= STREAM_HEADER_MIN_SIZE) {
+      const header = parseStreamHeader(buffer, pos);
+
+      if (!header) {
+        // Out of sync: skip to the next magic, keep a possible partial magic
+        const next = buffer.indexOf(STREAM_MAGIC, pos + 1);
+        pos = next !== -1 ? next : Math.max(pos + 1, buffer.length - (STREAM_MAGIC.length - 1));
+        this.resyncCount++;
+        this.hasReference = false;
+        continue;
+      }
+
+      const total = header.headerLength + header.payloadLength;
+      if (buffer.length - pos < total) break;
+
+      const payload = buffer.subarray(pos + header.headerLength, pos + total);
+      const record = (header.flags & STREAM_FLAG_BLOBS) !== 0
+        ? parseBlobRecord(buffer, pos + STREAM_HEADER.BLOBS, pos + header.headerLength)
+        : null;
+      pos += total;
+
+      if (this.lastSequence !== null && ((header.sequence - this.lastSequence) >>> 0) > 1) {
+        this.droppedFrames += ((header.sequence - this.lastSequence) >>> 0) - 1;
+      }
+      this.lastSequence = header.sequence;
+
+      // With both clocks on SNTP, arrival minus the UTC capture time is the delay.
+      // Otherwise arrival minus capture time holds the clock offset, its excess over
+      // the smallest one seen is the delay through Wi-Fi and the queues
+      if (header.utcUs !== null) {
+        this.delayUs += Math.max(0, Date.now() * 1000 - Number(header.utcUs));
+      } else {
+        const offsetUs = Date.now() * 1000 - Number(header.timestampUs);
+        if (this.minOffsetUs === null || offsetUs < this.minOffsetUs) this.minOffsetUs = offsetUs;
+        this.delayUs += offsetUs - this.minOffsetUs;
+      }
+      this.timeSynced = header.utcUs !== null;
+
+      // The ESP32 already computed the frame range, passing it on costs no pixel scan
+      if (header.hasStats) {
+        this.emit("stats", header.min, header.max);
+      }
+      if (record) {
+        this.emit("blobs", record.sequence, record.blobs, record.overflow);
+      }
+
+      const started = process.hrtime.bigint();
+      const decoded = this.decodePayload(header, payload);
+      this.decodeNs += process.hrtime.bigint() - started;
+
+      if (decoded) {
+        this.frames++;
+        // Skip header row, the image rows of the frame just decoded
+        const image = Buffer.from(this.referenceFrame.buffer, HEADER_SIZE, RAW_FRAME_SIZE);
+        // UTC capture time in ms lines up frames of several cameras, null until the ESP32 is synced
+        this.emit("frame", header.sequence, image, header.utcUs !== null ? Number(header.utcUs) / 1000 : null);
+      }
+    }
+
+    return pos;
+  }
+
+  processFrameData(data) {
+    this.bytes += data.length;
+    if (this.frameStream.append(data)) {
+      this.hasReference = false; // Bytes were dropped, the next delta frame has no base
+    }
+    this.frameStream.consume(this.parseFrames(this.frameStream.view()));
+  }
+
+  scheduleReconnect(retry, connect, name) {
+    if (!this.running || retry.timer) return;
+
+    // Exponential backoff with jitter, so a fleet that lost Wi-Fi does not reconnect in step
+    const delay = retry.delay * (0.75 + Math.random() * 0.5);
+    retry.delay = Math.min(RECONNECT_MAX_MS, retry.delay * 2);
+    retry.timer = setTimeout(() => {
+      retry.timer = null;
+      this.reconnects++;
+      this.log(`Reconnecting to ${name} port...`);
+      connect();
+    }, delay);
+  }
+
+  connectFramePort() {
+    if (this.frameClient) {
+      this.frameClient.destroy();
+      this.frameClient = null;
+    }
+
+    const client = new net.Socket();
+    this.frameClient = client;
+
+    client.connect(this.framePort, this.host, () => {
+      this.log(`Connected to frame port at ${this.host}:${this.framePort}`);
+      this.frameRetry.delay = RECONNECT_MIN_MS;
+      this.frameStream.clear();
+      this.lastSequence = null;
+      this.hasReference = false;
+      this.minOffsetUs = null; // The ESP32 may have rebooted
+      this.timeSynced = false;
+
+      // The ESP32 falls back to raw frames when its last viewer leaves,
+      // so ask for the framed stream on every connect
+      this.requestFramedStream();
+    });
+
+    client.setTimeout(5000);
+
+    client.on("timeout", () => {
+      this.log("Frame port connection timed out");
+      client.destroy();
+    });
+
+    client.on("data", (data) => this.processFrameData(data));
+
+    client.on("error", (err) => {
+      this.log(`Frame port error: ${err.message}`);
+      client.destroy();
+    });
+
+    client.on("close", () => {
+      if (this.frameClient !== client) return;
+      this.log(`Frame port connection closed, ${this.droppedFrames} frames dropped, ${this.resyncCount} resyncs`);
+      this.scheduleReconnect(this.frameRetry, () => this.connectFramePort(), "frame");
+    });
+  }
+
+  processChunk(msg) {
+    // Reassemble a v2 frame from its UDP chunks. A chunk of a newer frame drops
+    // the incomplete one: on poor Wi-Fi a late frame is worth less than a lost one
+    if (msg.length < UdpChunkHeaderView.SIZE || msg.compare(UDP_CHUNK_MAGIC, 0, 4, 0, 4) !== 0) return;
+
+    const chunk = chunkView.at(msg);
+    const id = chunk.frameId;
+    const index = chunk.chunkIdx;
+    const count = chunk.chunkCount;
+    const length = chunk.frameLen;
+    const data = msg.subarray(UdpChunkHeaderView.SIZE);
+    const offset = index * UDP_CHUNK_DATA;
+
+    if (index >= count || length > UDP_FRAME_MAX || offset + data.length > length) return;
+    this.bytes += msg.length;
+
+    let frame = this.udpFrame;
+    if (frame && frame.id !== id) {
+      if (((id - frame.id) | 0) < 0) return; // Late chunk of an older frame
+      this.incompleteFrames++;
+      frame = null;
+    }
+
+    if (!frame) {
+      this.udpReceived.fill(0, 0, count);
+      frame = { id, count, length, receivedCount: 0 };
+      this.udpFrame = frame;
+    }
+
+    if (frame.count !== count || frame.length !== length || this.udpReceived[index]) return;
+    data.copy(this.udpFrameData, offset);
+    this.udpReceived[index] = 1;
+
+    if (++frame.receivedCount === frame.count) {
+      // Complete: same parser as the TCP v2 stream
+      this.parseFrames(this.udpFrameData.subarray(0, length));
+      this.udpFrame = null;
+    }
+  }
+
+  connectFrameUdp() {
+    const socket = dgram.createSocket({ type: "udp4", reuseAddr: true });
+    this.udpSocket = socket;
+    this.udpReady = false;
+    this.udpFrameData = Buffer.allocUnsafe(UDP_FRAME_MAX);
+    this.udpReceived = new Uint8Array(Math.ceil(UDP_FRAME_MAX / UDP_CHUNK_DATA));
+
+    socket.on("message", (msg) => this.processChunk(msg));
+
+    socket.on("error", (err) => {
+      this.log(`Frame UDP error: ${err.message}`);
+    });
+
+    // Multicast viewers listen on the group port, unicast ones on any free port
+    socket.bind(this.multicastGroup ? this.framePort : 0, () => {
+      if (this.multicastGroup) {
+        socket.addMembership(this.multicastGroup);
+      }
+      this.log(`Receiving frames over UDP${this.multicastGroup ? ` from group ${this.multicastGroup}` : ""}`);
+
+      // The hello starts the stream, the shared tick repeats it
+      this.udpReady = true;
+      socket.send(UDP_HELLO_MAGIC, this.framePort, this.host);
+    });
+  }
+
+  connectCommandPort() {
+    if (this.cmdClient) {
+      this.cmdClient.destroy();
+      this.cmdClient = null;
+    }
+
+    const client = new net.Socket();
+    this.cmdClient = client;
+
+    client.connect(this.cmdPort, this.host, () => {
+      this.log(`Connected to command port at ${this.host}:${this.cmdPort}`);
+      this.cmdRetry.delay = RECONNECT_MIN_MS;
+      this.cmdStream.clear();
+      this.emit("status", true);
+
+      // Frame port may have connected first. Over UDP the stream is always
+      // framed, SFMT still selects the encoding
+      const frameClient = this.frameClient;
+      if (this.transport === "udp" || (frameClient && !frameClient.connecting && !frameClient.destroyed)) {
+        this.requestFramedStream();
+      }
+
+      // The shared tick polls the quadrant registers from now on
+      this.readQuadrantRegisters();
+    });
+
+    client.setTimeout(10000);
+
+    client.on("timeout", () => {
+      this.log("Command port connection timed out");
+      client.destroy();
+    });
+
+    client.on("data", (data) => {
+      this.cmdStream.append(data);
+      this.processCommandData();
+    });
+
+    client.on("error", (err) => {
+      this.log(`Command port error: ${err.message}`);
+      client.destroy();
+    });
+
+    client.on("close", () => {
+      if (this.cmdClient !== client) return;
+      this.log("Command port connection closed");
+      this.emit("status", false);
+      this.scheduleReconnect(this.cmdRetry, () => this.connectCommandPort(), "command");
+    });
+  }
+}
+
+module.exports = { Device, RAW_FRAME_SIZE, QUADRANT_REGISTERS, StreamBuffer, parseStreamHeader, STREAM_MAGIC };
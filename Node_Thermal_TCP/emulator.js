@@ -0,0 +1,606 @@
+// ESP32 camera emulator, for load tests of the iOS app, client.js and the fleet
+// mode without a room full of cameras. Every emulated camera serves the frame
+// and command ports like the firmware (see protocol.md):
+// - frame port: v1 raw frames until the host of a client sends SFMT 02, then
+//   v2 frames in the raw or delta encoding, or with --transport udp the chunked UDP stream
+//   to every viewer that sends SXHI
+// - command port: WREG, RREG, RRSE and SFMT, with the quadrant registers
+//   computed from the frame being sent
+// Camera n listens on --port + 2n (frames) and --port + 2n + 1 (commands).
+//
+// Frames are synthetic, a hot spot circling a warm background, or a recording
+// given with --frames: 10240 byte raw frames back to back, which is what
+// "nc <esp32> 3333 > clip.raw" saves from the v1 stream. They are encoded once
+// per process and shared by every camera, so sending a frame costs a header
+// and a socket write and one process serves 100+ cameras at 25 fps. Delta + LZ
+// requests get delta frames and packed ones raw frames; the header reports the
+// encoding of every frame, so clients decode them either way.
+//
+// --loss drops frames over TCP (the client then sees a sequence gap and gets
+// a keyframe, as after a firmware mailbox drop) and datagrams over UDP.
+// --latency and --jitter delay every frame and command reply, in ms.
+// --fleet writes a fleet config for client.js (FLEET_CONFIG=<file>).
+// --duration stops after that many seconds and prints what was sent, for CI.
+//
+//   node emulator.js --cameras 100 --fps 25 --loss 0.01 --latency 20 --jitter 10 --fleet fleet.emulated.json
+
+const fs = require("fs");
+const net = require("net");
+const dgram = require("dgram");
+const { REGISTER_DIGITS } = require("./registers");
+const {
+  STREAM_MAGIC, UDP_CHUNK_MAGIC, UDP_HELLO_MAGIC, UDP_BYE_MAGIC,
+  STREAM_ENCODING_RAW16, STREAM_ENCODING_DELTA, STREAM_ENCODING_DELTA_LZ, STREAM_ENCODING_PACK8,
+  STREAM_FLAG_KEYFRAME, STREAM_FLAG_STATS, STREAM_FLAG_UTC,
+  STREAM_HEADER, FRAME_STATS, UDP_CHUNK_HEADER, CMD_WREG, CMD_RREG, CMD_RRSE, CMD_SFMT,
+  buildPacket, findPacket, decodePacket
+} = require("./protocol");
+
+const DEFAULTS = {
+  cameras: 1,
+  fps: 25,
+  host: "127.0.0.1",
+  port: 3333,
+  transport: "tcp",
+  maxClients: 4,       // CONFIG_MI_TCP_MAX_CLIENTS
+  loss: 0,
+  latency: 0,
+  jitter: 0,
+  frames: null,
+  loop: 100,           // Synthetic frames, the loop the hot spot takes
+  fleet: null,
+  duration: 0
+};
+
+// 80x64 uint16 frames, the first 2 rows are the header
+const FRAME_WIDTH = 80;
+const FRAME_ROWS = 64;
+const HEADER_ROWS = 2;
+const FRAME_PIXELS = FRAME_WIDTH * FRAME_ROWS;
+const FRAME_SIZE = FRAME_PIXELS * 2;
+const IMAGE_HEIGHT = FRAME_ROWS - HEADER_ROWS;
+
+const STREAM_V1 = 1;
+const STREAM_V2 = 2;
+const KEYFRAME_INTERVAL = 50;        // CONFIG_MI_TCP_KEYFRAME_INTERVAL
+const FRAME_BACKLOG = 2 * FRAME_SIZE; // Frames dropped for a client this far behind, it gets the newest only
+const STATS_SCALE = 10;               // Raw units per Kelvin
+const UDP_CHUNK_DATA = 1456;
+const UDP_VIEWER_TIMEOUT_MS = 5000;
+const CMD_BUFFER_SIZE = 1024;
+
+// ============ Frames ============
+
+function parseArgs(argv) {
+  const options = { ...DEFAULTS };
+  for (let i = 0; i < argv.length; i++) {
+    const m = /^--([\w-]+)(?:=(.*))?$/.exec(argv[i]);
+    const name = m && m[1].replace(/-(\w)/g, (_, c) => c.toUpperCase()); // --max-clients is maxClients
+    if (!m || !(name in DEFAULTS)) throw new Error(`Unknown option ${argv[i]}`);
+    const value = m[2] !== undefined ? m[2] : argv[++i];
+    options[name] = typeof DEFAULTS[name] === "number" ? Number(value) : value;
+  }
+  if (options.transport !== "tcp" && options.transport !== "udp") throw new Error("--transport is tcp or udp");
+  if (!(options.fps > 0) || !(options.cameras >= 1)) throw new Error("--fps and --cameras must be positive");
+  return options;
+}
+
+function syntheticFrames(count) {
+  // Warm background with a gradient and a little noise, and a hot spot that
+  // circles the image once per loop
+  const frames = [];
+  let seed = 1;
+  const noise = () => {
+    seed = (seed * 1103515245 + 12345) >>> 0;
+    return (seed >>> 16) % 5 - 2;
+  };
+
+  for (let k = 0; k < count; k++) {
+    const frame = new Uint16Array(FRAME_PIXELS);
+    const angle = (2 * Math.PI * k) / count;
+    const spotX = FRAME_WIDTH / 2 + 25 * Math.cos(angle);
+    const spotY = IMAGE_HEIGHT / 2 + 18 * Math.sin(angle);
+    for (let y = 0; y < IMAGE_HEIGHT; y++) {
+      for (let x = 0; x < FRAME_WIDTH; x++) {
+        const d2 = (x - spotX) ** 2 + (y - spotY) ** 2;
+        const value = 2950 + x + (y >> 1) + 600 * Math.exp(-d2 / 18) + noise();
+        frame[(y + HEADER_ROWS) * FRAME_WIDTH + x] = Math.round(value);
+      }
+    }
+    frames.push(frame);
+  }
+  return frames;
+}
+
+function recordedFrames(file) {
+  const data = fs.readFileSync(file);
+  const count = Math.floor(data.length / FRAME_SIZE);
+  if (count === 0) throw new Error(`${file} holds no complete ${FRAME_SIZE} byte frame`);
+  const frames = [];
+  for (let k = 0; k < count; k++) {
+    const frame = new Uint16Array(FRAME_PIXELS);
+    for (let i = 0; i < FRAME_PIXELS; i++) frame[i] = data.readUInt16LE(k * FRAME_SIZE + i * 2);
+    frames.push(frame);
+  }
+  return frames;
+}
+
+function encodeDelta(frame, ref) {
+  // Inverse of decodeDelta in device.js: zigzag varint residuals, 0x00 starts
+  // a run of zero residuals. ref is the previous frame, null for a keyframe
+  const out = Buffer.allocUnsafe(FRAME_PIXELS * 3 + 8);
+  let op = 0;
+  let run = 0;
+  let predict = 0;
+
+  const writeVarint = (value) => {
+    while (value >= 0x80) {
+      out[op++] = (value & 0x7F) | 0x80;
+      value >>>= 7;
+    }
+    out[op++] = value;
+  };
+  const flushRun = () => {
+    if (run === 0) return;
+    out[op++] = 0x00;
+    writeVarint(run - 1);
+    run = 0;
+  };
+
+  for (let i = 0; i < FRAME_PIXELS; i++) {
+    if (ref) predict = ref[i];
+    const delta = ((frame[i] - predict) << 16) >> 16;
+    predict = frame[i];
+    if (delta === 0) {
+      run++;
+      continue;
+    }
+    flushRun();
+    writeVarint(((delta << 1) ^ (delta >> 15)) & 0xFFFF);
+  }
+  flushRun();
+  return Buffer.from(out.subarray(0, op));
+}
+
+function encodeFrames(frames) {
+  // Every payload a camera can send, once per process. A delta frame is coded
+  // against the previous frame of the loop; a payload that does not shrink is
+  // replaced by the raw frame, as the firmware does
+  return frames.map((frame, k) => {
+    const raw = Buffer.allocUnsafe(FRAME_SIZE);
+    for (let i = 0; i < FRAME_PIXELS; i++) raw.writeUInt16LE(frame[i], i * 2);
+
+    let min = 0xFFFF;
+    let max = 0;
+    let sum = 0;
+    for (let i = HEADER_ROWS * FRAME_WIDTH; i < FRAME_PIXELS; i++) {
+      min = Math.min(min, frame[i]);
+      max = Math.max(max, frame[i]);
+      sum += frame[i];
+    }
+
+    const key = encodeDelta(frame, null);
+    const delta = encodeDelta(frame, frames[(k + frames.length - 1) % frames.length]);
+    return {
+      pixels: frame,
+      raw,
+      key: key.length < FRAME_SIZE ? key : null,
+      delta: delta.length < FRAME_SIZE ? delta : null,
+      min,
+      max,
+      mean: Math.round(sum / (FRAME_WIDTH * IMAGE_HEIGHT))
+    };
+  });
+}
+
+function buildHeader(encoding, flags, sequence, timestampUs, payloadLength, frame) {
+  const H = STREAM_HEADER;
+  const header = Buffer.alloc(H.SIZE);
+  STREAM_MAGIC.copy(header, H.MAGIC);
+  header[H.VERSION] = STREAM_V2;
+  header[H.ENCODING] = encoding;
+  header.writeUInt16LE(H.SIZE, H.HEADER_LEN);
+  header.writeUInt32LE(sequence >>> 0, H.SEQ);
+  header.writeBigUInt64LE(timestampUs, H.TIMESTAMP_US);
+  header.writeUInt32LE(payloadLength, H.PAYLOAD_LEN);
+  header[H.FLAGS] = flags | STREAM_FLAG_STATS | STREAM_FLAG_UTC;
+  header.writeUInt16LE(frame.min, H.STATS + FRAME_STATS.MIN);
+  header.writeUInt16LE(frame.max, H.STATS + FRAME_STATS.MAX);
+  header.writeUInt16LE(frame.mean, H.STATS + FRAME_STATS.MEAN);
+  header[H.STATS + FRAME_STATS.SCALE] = STATS_SCALE;
+  header.writeBigUInt64LE(BigInt(Date.now()) * 1000n, H.UTC_US); // The host clock stands in for SNTP
+  return header;
+}
+
+const hex = (value, digits) => value.toString(16).toUpperCase().padStart(digits, "0");
+
+// IPv4 address of a peer, as the firmware keys its stream requests
+const hostOf = (address) => (address || "").replace(/^::ffff:/, "");
+
+const DEFAULT_REQUEST = { format: STREAM_V1, encoding: STREAM_ENCODING_RAW16 };
+
+// ============ Camera ============
+
+// Delivery of one socket or viewer: latency and jitter without reordering
+class Link {
+  constructor(options) {
+    this.options = options;
+    this.lastAt = 0;
+  }
+
+  send(write) {
+    const { latency, jitter } = this.options;
+    if (latency <= 0 && jitter <= 0) {
+      write();
+      return;
+    }
+    const now = Date.now();
+    const at = Math.max(this.lastAt, now + Math.max(0, latency + jitter * (2 * Math.random() - 1)));
+    this.lastAt = at;
+    setTimeout(write, at - now);
+  }
+}
+
+class EmulatedCamera {
+  constructor(index, options, frames) {
+    this.index = index;
+    this.options = options;
+    this.frames = frames;
+    this.framePort = options.port + 2 * index;
+    this.cmdPort = this.framePort + 1;
+
+    this.registers = new Uint16Array(256);
+    this.registers[0xB1] = 0x03;
+    this.registers[0xC0] = 40;
+    this.registers[0xC1] = 31;
+    this.requests = new Map();  // SFMT format and encoding by client address
+    this.sequence = 0;
+    this.current = frames[0];
+
+    this.clients = new Set();   // TCP frame sockets
+    this.viewers = new Map();   // UDP viewers by "address:port"
+    this.stats = { frames: 0, bytes: 0, dropped: 0, commands: 0 };
+  }
+
+  start(startUs) {
+    this.startUs = startUs;
+    if (this.options.transport === "udp") {
+      this.udpSocket = dgram.createSocket("udp4");
+      this.udpSocket.on("message", (msg, from) => this.onDatagram(msg, from));
+      this.udpSocket.bind(this.framePort, this.options.host);
+    } else {
+      this.frameServer = net.createServer(socket => this.onFrameClient(socket));
+      this.frameServer.listen(this.framePort, this.options.host);
+    }
+    this.cmdServer = net.createServer(socket => this.onCommandClient(socket));
+    this.cmdServer.listen(this.cmdPort, this.options.host);
+
+    // Cameras start out of step, as real ones do
+    const period = 1000 / this.options.fps;
+    this.phaseTimer = setTimeout(() => {
+      this.captureTimer = setInterval(() => this.capture(), period);
+    }, Math.random() * period);
+  }
+
+  stop() {
+    clearTimeout(this.phaseTimer);
+    clearInterval(this.captureTimer);
+    for (const client of this.clients) client.socket.destroy();
+    if (this.frameServer) this.frameServer.close();
+    if (this.udpSocket) this.udpSocket.close();
+    this.cmdServer.close();
+  }
+
+  onFrameClient(socket) {
+    if (this.clients.size >= this.options.maxClients) {
+      socket.destroy();
+      return;
+    }
+    socket.setNoDelay(true);
+    const client = { socket, address: hostOf(socket.remoteAddress), link: new Link(this.options), needKey: true, lastFrame: -1, sinceKey: 0 };
+    this.clients.add(client);
+    socket.on("error", () => socket.destroy());
+    socket.on("data", () => {}); // The firmware ignores what frame clients send
+    socket.on("close", () => {
+      this.clients.delete(client);
+      if (this.clients.size === 0) this.requests.clear(); // Back to v1 with the last client
+    });
+  }
+
+  onDatagram(msg, from) {
+    const key = `${from.address}:${from.port}`;
+    if (msg.length < 4) return;
+    if (msg.compare(UDP_HELLO_MAGIC, 0, 4, 0, 4) === 0) {
+      const viewer = this.viewers.get(key);
+      if (viewer) {
+        viewer.lastHello = Date.now();
+      } else if (this.viewers.size < this.options.maxClients) {
+        this.viewers.set(key, { address: from.address, port: from.port, lastHello: Date.now(), link: new Link(this.options) });
+      }
+    } else if (msg.compare(UDP_BYE_MAGIC, 0, 4, 0, 4) === 0) {
+      this.viewers.delete(key);
+    }
+  }
+
+  capture() {
+    const k = this.sequence % this.frames.length;
+    this.sequence++;
+    this.current = this.frames[k];
+    const timestampUs = process.hrtime.bigint() / 1000n - this.startUs;
+
+    for (const client of this.clients) this.sendFrame(client, k, timestampUs);
+
+    if (this.viewers.size > 0) {
+      const now = Date.now();
+      for (const [key, viewer] of this.viewers) {
+        if (now - viewer.lastHello > UDP_VIEWER_TIMEOUT_MS) this.viewers.delete(key);
+      }
+      this.sendChunks(k, timestampUs);
+    }
+  }
+
+  requestOf(address) {
+    return this.requests.get(address) || DEFAULT_REQUEST;
+  }
+
+  payloadFor(client, k, requested) {
+    // Payload and encoding for a TCP client, delta only on top of the frame it got last
+    const frame = this.frames[k];
+    if (requested === STREAM_ENCODING_DELTA || requested === STREAM_ENCODING_DELTA_LZ) {
+      const previous = (k + this.frames.length - 1) % this.frames.length;
+      const canDelta = !client.needKey && client.lastFrame === previous && client.sinceKey < KEYFRAME_INTERVAL;
+      if (canDelta && frame.delta) return { payload: frame.delta, encoding: STREAM_ENCODING_DELTA, key: false };
+      if (frame.key) return { payload: frame.key, encoding: STREAM_ENCODING_DELTA, key: true };
+    }
+    return { payload: frame.raw, encoding: STREAM_ENCODING_RAW16, key: true };
+  }
+
+  sendFrame(client, k, timestampUs) {
+    const { socket } = client;
+    if (socket.writableLength > FRAME_BACKLOG || Math.random() < this.options.loss) {
+      client.needKey = true;
+      this.stats.dropped++;
+      return;
+    }
+
+    const request = this.requestOf(client.address);
+    let parts;
+    if (request.format === STREAM_V1) {
+      parts = [this.frames[k].raw];
+    } else {
+      const { payload, encoding, key } = this.payloadFor(client, k, request.encoding);
+      const flags = key ? STREAM_FLAG_KEYFRAME : 0;
+      parts = [buildHeader(encoding, flags, this.sequence, timestampUs, payload.length, this.frames[k]), payload];
+      client.needKey = false;
+      client.sinceKey = key ? 0 : client.sinceKey + 1;
+    }
+    client.lastFrame = k;
+
+    this.stats.frames++;
+    client.link.send(() => {
+      if (socket.destroyed) return;
+      for (const part of parts) {
+        socket.write(part);
+        this.stats.bytes += part.length;
+      }
+    });
+  }
+
+  sendChunks(k, timestampUs) {
+    // Every UDP frame is a keyframe, chunked once per encoding the viewers asked for
+    const chunksByDelta = new Map();
+    for (const viewer of this.viewers.values()) {
+      const { encoding } = this.requestOf(viewer.address);
+      const useDelta = (encoding === STREAM_ENCODING_DELTA || encoding === STREAM_ENCODING_DELTA_LZ) && !!this.frames[k].key;
+      if (!chunksByDelta.has(useDelta)) chunksByDelta.set(useDelta, this.buildChunks(k, timestampUs, useDelta));
+      const chunks = chunksByDelta.get(useDelta);
+
+      this.stats.frames++;
+      viewer.link.send(() => {
+        for (const chunk of chunks) {
+          if (Math.random() < this.options.loss) {
+            this.stats.dropped++;
+            continue;
+          }
+          this.udpSocket.send(chunk, viewer.port, viewer.address);
+          this.stats.bytes += chunk.length;
+        }
+      });
+    }
+  }
+
+  buildChunks(k, timestampUs, useDelta) {
+    // A v2 frame split into chunks behind a chunk header
+    const frame = this.frames[k];
+    const payload = useDelta ? frame.key : frame.raw;
+    const header = buildHeader(useDelta ? STREAM_ENCODING_DELTA : STREAM_ENCODING_RAW16, STREAM_FLAG_KEYFRAME,
+      this.sequence, timestampUs, payload.length, frame);
+    const data = Buffer.concat([header, payload]);
+    const count = Math.ceil(data.length / UDP_CHUNK_DATA);
+
+    const chunks = [];
+    for (let n = 0; n < count; n++) {
+      const C = UDP_CHUNK_HEADER;
+      const slice = data.subarray(n * UDP_CHUNK_DATA, Math.min(data.length, (n + 1) * UDP_CHUNK_DATA));
+      const chunk = Buffer.allocUnsafe(C.SIZE + slice.length);
+      UDP_CHUNK_MAGIC.copy(chunk, C.MAGIC);
+      chunk.writeUInt32LE(this.sequence >>> 0, C.FRAME_ID);
+      chunk.writeUInt16LE(n, C.CHUNK_IDX);
+      chunk.writeUInt16LE(count, C.CHUNK_COUNT);
+      chunk.writeUInt32LE(data.length, C.FRAME_LEN);
+      slice.copy(chunk, C.SIZE);
+      chunks.push(chunk);
+    }
+    return chunks;
+  }
+
+  // ============ Commands ============
+
+  onCommandClient(socket) {
+    socket.setNoDelay(true);
+    const link = new Link(this.options);
+    const address = hostOf(socket.remoteAddress);
+    let pending = Buffer.alloc(0);
+    const packet = {};
+
+    socket.on("error", () => socket.destroy());
+    socket.on("data", (data) => {
+      pending = pending.length ? Buffer.concat([pending, data]) : data;
+      let pos = 0;
+      for (;;) {
+        const start = findPacket(pending, pos);
+        if (start < 0) break;
+        const length = decodePacket(pending, start, packet);
+        if (length < 0) {
+          pos = start + 1;
+          continue;
+        }
+        if (length === 0) {
+          pos = start;
+          break;
+        }
+        pos = start + length;
+        if (!packet.sumValid) continue; // The firmware drops a packet with a wrong checksum
+
+        const data = pending.toString("latin1", packet.dataStart, packet.dataEnd);
+        const reply = this.onCommand(packet.command, data, address);
+        if (reply) link.send(() => { if (!socket.destroyed) socket.write(reply); });
+      }
+      pending = pending.subarray(Math.min(pos, pending.length));
+      if (pending.length > CMD_BUFFER_SIZE) pending = Buffer.alloc(0); // Garbage, resync on the next packet
+    });
+  }
+
+  onCommand(command, data, address) {
+    this.stats.commands++;
+    switch (command) {
+      case CMD_WREG: {
+        this.writeRegister(parseInt(data.slice(0, 2), 16), parseInt(data.slice(2, 4), 16));
+        return buildPacket(CMD_WREG, "", true);
+      }
+      case CMD_RREG: {
+        const address = parseInt(data.slice(0, 2), 16);
+        return buildPacket(CMD_RREG, hex(this.readRegister(address), REGISTER_DIGITS[address]), true);
+      }
+      case CMD_RRSE: {
+        let reply = "";
+        for (let i = 0; i + 2 <= data.length; i += 2) {
+          const address = parseInt(data.slice(i, i + 2), 16);
+          if (address === 0xFF) break;
+          reply += hex(address, 2) + hex(this.readRegister(address), REGISTER_DIGITS[address]);
+        }
+        return buildPacket(CMD_RRSE, reply, true);
+      }
+      case CMD_SFMT: {
+        const format = parseInt(data.slice(0, 2), 16);
+        const encoding = data.length >= 4 ? parseInt(data.slice(2, 4), 16) : STREAM_ENCODING_RAW16;
+        if ((format !== STREAM_V1 && format !== STREAM_V2) || !(encoding >= 0 && encoding <= STREAM_ENCODING_PACK8) ||
+            (format === STREAM_V1 && encoding !== STREAM_ENCODING_RAW16)) {
+          return null;
+        }
+        // Only the clients of this host switch, as in the firmware
+        if (this.requestOf(address).encoding !== encoding) {
+          for (const client of this.clients) {
+            if (client.address === address) client.needKey = true;
+          }
+        }
+        if (format === STREAM_V1) {
+          this.requests.delete(address);
+        } else {
+          this.requests.set(address, { format, encoding });
+        }
+        return buildPacket(CMD_SFMT, hex(format, 2) + hex(encoding, 2), true);
+      }
+      default:
+        return null; // Not emulated, the firmware would answer
+    }
+  }
+
+  writeRegister(address, value) {
+    if (!(address >= 0 && address <= 0xFF) || !(value >= 0 && value <= 0xFF)) return;
+    if (address === 0xC0) value = Math.min(value, FRAME_WIDTH);
+    if (address === 0xC1) value = Math.min(value, IMAGE_HEIGHT);
+    this.registers[address] = value;
+  }
+
+  readRegister(address) {
+    if (address >= 0xC2 && address <= 0xC9) return this.quadrantValue(address);
+    return this.registers[address] || 0;
+  }
+
+  quadrantValue(address) {
+    // Max and center pixel of quadrant A-D of the frame being sent
+    const quadrant = (address - 0xC2) >> 1;
+    const xSplit = this.registers[0xC0];
+    const ySplit = this.registers[0xC1];
+    const x0 = quadrant & 1 ? xSplit : 0;
+    const x1 = quadrant & 1 ? FRAME_WIDTH : xSplit;
+    const y0 = quadrant & 2 ? ySplit : 0;
+    const y1 = quadrant & 2 ? IMAGE_HEIGHT : ySplit;
+    const pixel = (x, y) => this.current.pixels[(y + HEADER_ROWS) * FRAME_WIDTH + x];
+
+    if (x1 <= x0 || y1 <= y0) return 0;
+    if ((address - 0xC2) & 1) return pixel(x0 + ((x1 - x0) >> 1), y0 + ((y1 - y0) >> 1));
+    let max = 0;
+    for (let y = y0; y < y1; y++) {
+      for (let x = x0; x < x1; x++) max = Math.max(max, pixel(x, y));
+    }
+    return max;
+  }
+}
+
+// ============ Main ============
+
+function main() {
+  const options = parseArgs(process.argv.slice(2));
+  const frames = encodeFrames(options.frames ? recordedFrames(options.frames) : syntheticFrames(options.loop));
+  const startUs = process.hrtime.bigint() / 1000n;
+  const cameras = Array.from({ length: options.cameras }, (_, i) => new EmulatedCamera(i, options, frames));
+  cameras.forEach(camera => camera.start(startUs));
+
+  console.log(`Emulating ${cameras.length} camera(s) on ${options.host}:${options.port}-${options.port + 2 * cameras.length - 1}, ` +
+    `${options.fps} fps, ${frames.length} frame loop, ${options.transport}`);
+
+  if (options.fleet) {
+    const fleet = {
+      workers: 0,
+      devices: cameras.map(c => ({
+        id: `emu-${c.index}`, host: options.host, transport: options.transport, framePort: c.framePort, cmdPort: c.cmdPort
+      }))
+    };
+    fs.writeFileSync(options.fleet, JSON.stringify(fleet, null, 2) + "\n");
+    console.log(`Fleet config written to ${options.fleet}`);
+  }
+
+  const total = () => cameras.reduce((t, c) => {
+    for (const key of Object.keys(t)) t[key] += c.stats[key];
+    return t;
+  }, { frames: 0, bytes: 0, dropped: 0, commands: 0 });
+
+  let last = { time: Date.now(), ...total() };
+  const report = setInterval(() => {
+    const now = { time: Date.now(), ...total() };
+    const seconds = (now.time - last.time) / 1000;
+    const clients = cameras.reduce((n, c) => n + c.clients.size + c.viewers.size, 0);
+    console.log(`${clients} clients, ${((now.frames - last.frames) / seconds).toFixed(0)} frames/s, ` +
+      `${((now.bytes - last.bytes) * 8 / 1000 / seconds).toFixed(0)} kbit/s, ` +
+      `${now.dropped - last.dropped} dropped, ${now.commands - last.commands} commands`);
+    last = now;
+  }, 5000);
+
+  const stop = () => {
+    clearInterval(report);
+    cameras.forEach(camera => camera.stop());
+    const t = total();
+    console.log(`Sent ${t.frames} frames, ${t.bytes} bytes, ${t.dropped} dropped, ${t.commands} commands`);
+    setTimeout(() => process.exit(0), 100);
+  };
+  process.on("SIGINT", stop);
+  if (options.duration > 0) setTimeout(stop, options.duration * 1000);
+}
+
+if (require.main === module) {
+  main();
+}
+
+module.exports = { EmulatedCamera, encodeDelta, encodeFrames, syntheticFrames };
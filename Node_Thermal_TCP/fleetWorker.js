@@ -0,0 +1,124 @@
+// Runs a share of the fleet in a worker thread, so decoding of many cameras is
+// spread over several cores. The main thread sees each device through a
+// RemoteDevice with the same events and commands as a local Device.
+
+const { Worker, isMainThread, parentPort, workerData } = require("worker_threads");
+const EventEmitter = require("events");
+const { Device } = require("./device");
+
+const METRICS_INTERVAL = 1000;
+
+if (!isMainThread) {
+  const devices = workerData.devices.map(config => new Device(config));
+
+  devices.forEach((device, index) => {
+    device.on("frame", (sequence, image, utcMs) => {
+      // Copied into a buffer of its own and transferred, the image view is reused
+      const pixels = new Uint8Array(image.length);
+      pixels.set(image);
+      parentPort.postMessage({ type: "frame", index, sequence, pixels, utcMs }, [pixels.buffer]);
+    });
+    device.on("quadrant", (config) => parentPort.postMessage({ type: "quadrant", index, config }));
+    device.on("stats", (min, max) => parentPort.postMessage({ type: "stats", index, min, max }));
+    device.on("status", (connected) => parentPort.postMessage({ type: "status", index, connected }));
+    device.start();
+  });
+
+  setInterval(() => {
+    parentPort.postMessage({ type: "metrics", metrics: devices.map(d => d.metrics()) });
+  }, METRICS_INTERVAL);
+
+  parentPort.on("message", (msg) => {
+    const device = devices[msg.index];
+    switch (msg.type) {
+      case "writeRegister":
+        device.writeRegister(msg.address, msg.value);
+        break;
+      case "readQuadrantRegisters":
+        device.readQuadrantRegisters();
+        break;
+      case "stop": {
+        let pending = devices.length;
+        const done = () => { if (--pending <= 0) process.exit(0); };
+        devices.forEach(d => d.stop(done));
+        if (pending === 0) process.exit(0);
+        break;
+      }
+    }
+  });
+}
+
+// Main thread stand-in for a Device running in a worker
+class RemoteDevice extends EventEmitter {
+  constructor(worker, index, config) {
+    super();
+    this.worker = worker;
+    this.index = index;
+    this.id = config.id;
+    this.host = config.host;
+    this.transport = config.transport || "tcp";
+    this.quadrantConfig = { xSplit: 40, ySplit: 31, aMax: 0, aCenter: 0, bMax: 0, bCenter: 0, cMax: 0, cCenter: 0, dMax: 0, dCenter: 0 };
+    this.lastMetrics = { id: this.id, host: this.host, transport: this.transport, connected: false };
+  }
+
+  get connected() {
+    return this.lastMetrics.connected;
+  }
+
+  writeRegister(address, value) {
+    this.worker.postMessage({ type: "writeRegister", index: this.index, address, value });
+  }
+
+  readQuadrantRegisters() {
+    this.worker.postMessage({ type: "readQuadrantRegisters", index: this.index });
+  }
+
+  metrics() {
+    return this.lastMetrics;
+  }
+}
+
+// Starts a worker for the given device configs, returns their RemoteDevices
+function startWorker(configs) {
+  const worker = new Worker(__filename, { workerData: { devices: configs } });
+  const devices = configs.map((config, index) => new RemoteDevice(worker, index, config));
+
+  worker.on("message", (msg) => {
+    if (msg.type === "metrics") {
+      msg.metrics.forEach((m, i) => { devices[i].lastMetrics = m; });
+      return;
+    }
+
+    const device = devices[msg.index];
+    switch (msg.type) {
+      case "frame":
+        device.emit("frame", msg.sequence, Buffer.from(msg.pixels.buffer, msg.pixels.byteOffset, msg.pixels.length), msg.utcMs);
+        break;
+      case "quadrant":
+        Object.assign(device.quadrantConfig, msg.config);
+        device.emit("quadrant", device.quadrantConfig);
+        break;
+      case "stats":
+        device.emit("stats", msg.min, msg.max);
+        break;
+      case "status":
+        device.lastMetrics.connected = msg.connected;
+        device.emit("status", msg.connected);
+        break;
+    }
+  });
+
+  worker.on("error", (err) => {
+    console.error(`Fleet worker error: ${err.message}`);
+  });
+
+  return { worker, devices };
+}
+
+// Stops the devices of a worker, callback once it has said goodbye to its cameras
+function stopWorker(worker, callback) {
+  worker.once("exit", () => callback());
+  worker.postMessage({ type: "stop" });
+}
+
+module.exports = { startWorker, stopWorker };
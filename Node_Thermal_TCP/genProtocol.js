@@ -0,0 +1,927 @@
+// Generates the protocol code of the firmware and the clients from the two
+// sources of truth, so C, Swift and JS cannot drift apart:
+// - REG_MAP_LIST in regMap.h: registers.js, the register widths of
+//   ThermalProtocol.swift and the register table of protocol.md
+// - protocolSchema.json: the command packet codec and the layout views of
+//   protoSchema.h, protocol.js and the schema block of ThermalProtocol.swift,
+//   and the conformance vectors all three are tested against. protoSchema.h
+//   also holds PROTO_CHECK_* macros that fail the firmware build when a packed
+//   struct no longer matches the schema.
+// Run "npm run protocol" after changing either, then "npm test" and the host
+// tests of the firmware (test/host).
+
+const fs = require("fs");
+const path = require("path");
+
+const FIRMWARE = path.join(__dirname, "..", "senxorESP32S3");
+const REG_MAP_H = path.join(FIRMWARE, "components", "util", "include", "regMap.h");
+const SCHEMA_JSON = path.join(FIRMWARE, "protocolSchema.json");
+const PROTO_SCHEMA_H = path.join(FIRMWARE, "components", "util", "include", "protoSchema.h");
+const PROTOCOL_MD = path.join(FIRMWARE, "protocol.md");
+const VECTORS = path.join(FIRMWARE, "test", "host", "vectors", "protocol.txt");
+const REGISTERS_JS = path.join(__dirname, "registers.js");
+const PROTOCOL_JS = path.join(__dirname, "protocol.js");
+const SWIFT = path.join(__dirname, "..", "ThermalViewer", "ThermalViewer", "Core", "Protocol", "ThermalProtocol.swift");
+
+const DIGITS = { REG_8: 2, REG_16: 4 };
+const ENTRY = /^\s*X\((0x[0-9A-Fa-f]{2}),\s*"(\w+)",\s*(REG_8|REG_16),\s*(\w+),\s*(\w+),\s*(NULL|"\w+")\)/;
+const SCALARS = { u8: 1, u16: 2, u32: 4, u64: 8 };
+const C_TYPES = { u8: "uint8_t", u16: "uint16_t", u32: "uint32_t", u64: "uint64_t" };
+const SWIFT_TYPES = { u8: "UInt8", u16: "UInt16", u32: "UInt32", u64: "UInt64" };
+const JS_READ = { u8: null, u16: "readUInt16LE", u32: "readUInt32LE", u64: "readBigUInt64LE" };
+const JS_WRITE = { u8: null, u16: "writeUInt16LE", u32: "writeUInt32LE", u64: "writeBigUInt64LE" };
+
+function parseRegMap(text) {
+  const registers = [];
+  for (const line of text.split(/\r?\n/)) {
+    const m = ENTRY.exec(line);
+    if (!m) continue;
+    registers.push({
+      address: parseInt(m[1], 16),
+      name: m[2],
+      digits: DIGITS[m[3]],
+      writable: m[5] !== "NULL",
+      nvsKey: m[6] === "NULL" ? null : m[6].slice(1, -1),
+    });
+  }
+  if (registers.length === 0) throw new Error(`No registers found in ${REG_MAP_H}`);
+  return registers;
+}
+
+// Field offsets of every layout. A type is a scalar, a scalar array "u16[16]",
+// another layout, or a layout array "blobEntry[]" of variable length, which
+// must be the last field and is not counted in the size. kind is "scalar",
+// "array", "layout" or "tail", elem the scalar or layout of the field.
+function parseLayouts(layouts) {
+  const out = {};
+  const sizeOf = (type) => {
+    if (SCALARS[type]) return SCALARS[type];
+    if (!out[type]) throw new Error(`Unknown type ${type}`);
+    return out[type].size;
+  };
+  for (const [name, fields] of Object.entries(layouts)) {
+    let offset = 0;
+    const parsed = fields.map(([field, type, member], i) => {
+      const array = /^(\w+)\[(\d*)\]$/.exec(type);
+      const elem = array ? array[1] : type;
+      const tail = array !== null && array[2] === "";
+      const count = array && !tail ? Number(array[2]) : 1;
+      if (tail && i !== fields.length - 1) throw new Error(`${name}.${field}: a variable array must come last`);
+      const kind = tail ? "tail" : SCALARS[elem] ? (array ? "array" : "scalar") : "layout";
+      if (kind === "layout" && array) throw new Error(`${name}.${field}: arrays of layouts must be variable`);
+      const elemSize = sizeOf(elem);
+      const entry = { name: field, type, member, offset, size: tail ? 0 : elemSize * count, tail, kind, elem, count, elemSize };
+      offset += entry.size;
+      return entry;
+    });
+    out[name] = { name, fields: parsed, size: offset, hasTail: parsed.some(f => f.tail) };
+  }
+  return out;
+}
+
+// Offsets of the command packet fields
+function parsePacket(packet) {
+  if (packet.commandSize !== 4) throw new Error("Commands are 4 letters, the codecs pass them as a 32 bit word");
+  const len = packet.prefix.length;
+  const cmd = len + packet.lengthDigits;
+  return {
+    ...packet,
+    len,
+    cmd,
+    data: cmd + packet.commandSize,
+    minLength: packet.commandSize + packet.checksumDigits,
+  };
+}
+
+// Contiguous runs of 16-bit registers, as [first, last]
+function wideRanges(registers) {
+  const ranges = [];
+  for (const r of registers) {
+    if (r.digits !== 4) continue;
+    const last = ranges[ranges.length - 1];
+    if (last && last[1] === r.address - 1) last[1] = r.address;
+    else ranges.push([r.address, r.address]);
+  }
+  return ranges;
+}
+
+const hex = (v, digits = 2) => "0x" + v.toString(16).toUpperCase().padStart(digits, "0");
+const snake = name => name.replace(/([a-z0-9])([A-Z])/g, "$1_$2").toUpperCase();
+const pascal = name => name[0].toUpperCase() + name.slice(1);
+const magicLE = text => Buffer.from(text, "ascii").readUInt32LE(0);
+const magicBE = text => Buffer.from(text, "ascii").readUInt32BE(0);
+const pad = (text, width) => text + "\t".repeat(Math.max(1, Math.ceil((width - text.length) / 4)));
+const byteList = text => [...Buffer.from(text, "ascii")].map(b => hex(b)).join(", ");
+
+// Replace the lines between the markers, keeping the file's line endings
+function replaceBlock(file, begin, end, lines) {
+  const text = fs.readFileSync(file, "utf8");
+  const eol = text.includes("\r\n") ? "\r\n" : "\n";
+  const start = text.indexOf(begin);
+  const stop = text.indexOf(end);
+  if (start < 0 || stop < start) throw new Error(`Markers not found in ${file}`);
+  const head = text.slice(0, text.indexOf(eol, start) + eol.length);
+  const tail = text.slice(text.lastIndexOf(eol, stop) + eol.length);
+  fs.writeFileSync(file, head + lines.map(l => l + eol).join("") + tail);
+}
+
+function writeRegistersJs(registers) {
+  const rows = registers.map(r =>
+    `  { address: ${hex(r.address)}, name: "${r.name}", digits: ${r.digits}, writable: ${r.writable}, nvsKey: ${r.nvsKey ? `"${r.nvsKey}"` : "null"} },`);
+  fs.writeFileSync(REGISTERS_JS, [
+    "// Generated by genProtocol.js from regMap.h, do not edit.",
+    "",
+    "const REGISTERS = [",
+    ...rows,
+    "];",
+    "",
+    "// Hex digits of each register value in RREG and RRSE replies, by address",
+    "const REGISTER_DIGITS = new Uint8Array(256).fill(2);",
+    "for (const r of REGISTERS) REGISTER_DIGITS[r.address] = r.digits;",
+    "",
+    "module.exports = { REGISTERS, REGISTER_DIGITS };",
+    "",
+  ].join("\n"));
+}
+
+function writeProtocolMd(registers) {
+  replaceBlock(PROTOCOL_MD, "<!-- BEGIN generated register table", "<!-- END generated register table", [
+    "| Address | Name | Value digits | R/W | Saved in NVS |",
+    "|---------|------|--------------|-----|--------------|",
+    ...registers.map(r => `| \`${hex(r.address)}\` | ${r.name} | ${r.digits} | ${r.writable ? "R/W" : "R"} | ${r.nvsKey ? `\`${r.nvsKey}\`` : "-"} |`),
+  ]);
+}
+
+// ============ C ============
+
+const C_PACKET_CODEC = `
+// Value of digits ASCII hex digits at p in *pValue, false on any other character
+static inline bool protoHex_Read(const uint8_t* p, const uint8_t digits, uint32_t* pValue)
+{
+	uint32_t value = 0;
+
+	for (uint8_t i = 0; i < digits; i++)
+	{
+		const uint8_t letter = p[i] | 0x20;
+		if (p[i] >= '0' && p[i] <= '9')
+		{
+			value = (value << 4) | (uint32_t)(p[i] - '0');
+		}
+		else if (letter >= 'a' && letter <= 'f')
+		{
+			value = (value << 4) | (uint32_t)(letter - 'a' + 10);
+		}
+		else
+		{
+			return false;
+		}
+	}
+	*pValue = value;
+	return true;
+}
+
+// value as digits upper case ASCII hex digits at p, without a NUL
+static inline void protoHex_Write(uint8_t* p, uint32_t value, const uint8_t digits)
+{
+	for (uint8_t i = digits; i > 0; i--)
+	{
+		p[i - 1] = (uint8_t)"0123456789ABCDEF"[value & 0x0F];
+		value >>= 4;
+	}
+}
+
+// Packet checksum of len bytes
+static inline uint16_t protoPacket_Sum(const uint8_t* p, const size_t len)
+{
+	uint16_t sum = 0;
+
+	for (size_t i = 0; i < len; i++)
+	{
+		sum += p[i];
+	}
+	return sum;
+}
+
+// Complete the packet around the dataLen bytes already at pPacket + PROTO_PACKET_DATA,
+// with the checksum or PROTO_PACKET_NO_SUM, and a NUL after it. Returns the packet length.
+static inline size_t protoPacket_Encode(uint8_t* pPacket, const uint32_t cmd, const size_t dataLen, const bool withSum)
+{
+	const size_t sumAt = PROTO_PACKET_DATA + dataLen;
+
+	memcpy(pPacket, PROTO_PACKET_PREFIX, PROTO_PACKET_LEN);
+	protoHex_Write(&pPacket[PROTO_PACKET_LEN], (uint32_t)(dataLen + PROTO_PACKET_MIN_LEN), PROTO_PACKET_LEN_DIGITS);
+	pPacket[PROTO_PACKET_CMD] = (uint8_t)(cmd >> 24);
+	pPacket[PROTO_PACKET_CMD + 1] = (uint8_t)(cmd >> 16);
+	pPacket[PROTO_PACKET_CMD + 2] = (uint8_t)(cmd >> 8);
+	pPacket[PROTO_PACKET_CMD + 3] = (uint8_t)cmd;
+	if (withSum)
+	{
+		protoHex_Write(&pPacket[sumAt], protoPacket_Sum(&pPacket[PROTO_PACKET_LEN], sumAt - PROTO_PACKET_LEN), PROTO_PACKET_SUM_DIGITS);
+	}
+	else
+	{
+		memcpy(&pPacket[sumAt], PROTO_PACKET_NO_SUM, PROTO_PACKET_SUM_DIGITS);
+	}
+	pPacket[sumAt + PROTO_PACKET_SUM_DIGITS] = 0;
+	return sumAt + PROTO_PACKET_SUM_DIGITS;
+}
+
+// Packet at the start of pIn, the data is left in place. Returns the packet length,
+// 0 if the len bytes are the start of a packet, -1 if pIn does not start one.
+static inline int32_t protoPacket_Decode(const uint8_t* pIn, const size_t len, protoPacket_t* pPacket)
+{
+	uint32_t packetLen;
+	uint32_t sum;
+
+	if (memcmp(pIn, PROTO_PACKET_PREFIX, (len < PROTO_PACKET_LEN) ? len : PROTO_PACKET_LEN) != 0)
+	{
+		return -1;
+	}
+	if (len < PROTO_PACKET_DATA)
+	{
+		return 0;
+	}
+	if (!protoHex_Read(&pIn[PROTO_PACKET_LEN], PROTO_PACKET_LEN_DIGITS, &packetLen) ||
+			packetLen < PROTO_PACKET_MIN_LEN || packetLen > PROTO_PACKET_MAX_LEN)
+	{
+		return -1;
+	}
+	packetLen += PROTO_PACKET_CMD;
+	if (len < packetLen)
+	{
+		return 0;
+	}
+
+	const uint8_t* pSum = &pIn[packetLen - PROTO_PACKET_SUM_DIGITS];
+	pPacket->mCmd = PROTO_CMD_CODE(&pIn[PROTO_PACKET_CMD]);
+	pPacket->pData = &pIn[PROTO_PACKET_DATA];
+	pPacket->mDataLen = packetLen - PROTO_PACKET_DATA - PROTO_PACKET_SUM_DIGITS;
+	pPacket->mSumSent = memcmp(pSum, PROTO_PACKET_NO_SUM, PROTO_PACKET_SUM_DIGITS) != 0;
+	pPacket->mSumValid = !pPacket->mSumSent || (protoHex_Read(pSum, PROTO_PACKET_SUM_DIGITS, &sum) &&
+			sum == protoPacket_Sum(&pIn[PROTO_PACKET_LEN], (size_t)(pSum - &pIn[PROTO_PACKET_LEN])));
+	return (int32_t)packetLen;
+}
+
+// Offset of the first packet prefix in pIn from from on, -1 if there is none
+static inline int32_t protoPacket_Find(const uint8_t* pIn, const size_t len, size_t from)
+{
+	for (; from + PROTO_PACKET_LEN <= len; from++)
+	{
+		if (memcmp(&pIn[from], PROTO_PACKET_PREFIX, PROTO_PACKET_LEN) == 0)
+		{
+			return (int32_t)from;
+		}
+	}
+	return -1;
+}
+
+// Little endian fields at any alignment
+static inline uint8_t protoGetU8(const uint8_t* p) { return p[0]; }
+static inline uint16_t protoGetU16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static inline uint32_t protoGetU32(const uint8_t* p) { return (uint32_t)protoGetU16(p) | ((uint32_t)protoGetU16(&p[2]) << 16); }
+static inline uint64_t protoGetU64(const uint8_t* p) { return (uint64_t)protoGetU32(p) | ((uint64_t)protoGetU32(&p[4]) << 32); }
+static inline void protoPutU8(uint8_t* p, const uint8_t value) { p[0] = value; }
+static inline void protoPutU16(uint8_t* p, const uint16_t value) { p[0] = (uint8_t)value; p[1] = (uint8_t)(value >> 8); }
+static inline void protoPutU32(uint8_t* p, const uint32_t value) { protoPutU16(p, (uint16_t)value); protoPutU16(&p[2], (uint16_t)(value >> 16)); }
+static inline void protoPutU64(uint8_t* p, const uint64_t value) { protoPutU32(p, (uint32_t)value); protoPutU32(&p[4], (uint32_t)(value >> 32)); }`;
+
+// Get and set functions of the scalar and scalar array fields, nested layouts
+// and the variable part are reached through the offset of their field
+function cAccessors(layout) {
+  const prefix = `PROTO_${snake(layout.name)}_`;
+  const fn = `proto${pascal(layout.name)}_`;
+  const lines = [];
+  const fields = [];
+  for (const f of layout.fields) {
+    if (f.kind !== "scalar" && f.kind !== "array") continue;
+    const type = C_TYPES[f.elem];
+    const access = f.elem.toUpperCase();
+    const get = `${fn}Get${pascal(f.name)}`;
+    const set = `${fn}Set${pascal(f.name)}`;
+    if (f.kind === "scalar") {
+      lines.push(`static inline ${type} ${get}(const uint8_t* p) { return protoGet${access}(&p[${prefix}${snake(f.name)}]); }`);
+      lines.push(`static inline void ${set}(uint8_t* p, const ${type} value) { protoPut${access}(&p[${prefix}${snake(f.name)}], value); }`);
+      fields.push(`SCALAR(${get}, ${set}, ${type})`);
+    } else {
+      const at = `${prefix}${snake(f.name)} + i * ${f.elemSize}`;
+      lines.push(`static inline ${type} ${get}(const uint8_t* p, const uint32_t i) { return protoGet${access}(&p[${at}]); }`);
+      lines.push(`static inline void ${set}(uint8_t* p, const uint32_t i, const ${type} value) { protoPut${access}(&p[${at}], value); }`);
+      fields.push(`ARRAY(${get}, ${set}, ${type}, ${f.count})`);
+    }
+  }
+  lines.push(`#define PROTO_FIELDS_${snake(layout.name)}(SCALAR, ARRAY) \\`);
+  fields.forEach((f, i) => lines.push(`\t${f}${i < fields.length - 1 ? " \\" : ""}`));
+  return lines;
+}
+
+function writeProtoSchemaH(schema, packet, layouts) {
+  const lines = [
+    "/*****************************************************************************",
+    " * @file     protoSchema.h",
+    " * @brief    Command packet and layouts shared with the clients",
+    " * @details	 Generated by Node_Thermal_TCP/genProtocol.js from",
+    " * 			 protocolSchema.json, do not edit. The packet codec and the",
+    " * 			 layout get and set functions are the ones protocol.js and",
+    " * 			 ThermalProtocol.swift are generated with, all three are",
+    " * 			 tested against test/host/vectors/protocol.txt. PROTO_CHECK_*",
+    " * 			 fail the build when a packed struct or a set of defines no",
+    " * 			 longer matches the schema.",
+    " ******************************************************************************/",
+    "#ifndef COMPONENTS_UTIL_INCLUDE_PROTOSCHEMA_H_",
+    "#define COMPONENTS_UTIL_INCLUDE_PROTOSCHEMA_H_",
+    "",
+    "#include <stdbool.h>",
+    "#include <stddef.h>",
+    "#include <stdint.h>",
+    "#include <string.h>",
+    "",
+    "// Command word, the 4 command letters big endian",
+    "#define PROTO_CMD_CODE(p)\t\t\t(((uint32_t)(p)[0] << 24) | ((uint32_t)(p)[1] << 16) | ((uint32_t)(p)[2] << 8) | (uint32_t)(p)[3])",
+    ...schema.commands.map(([name, doc]) => `${pad(`#define PROTO_CMD_${name}`, 44)}${hex(magicBE(name), 8)}UL\t\t//${doc}`),
+    "",
+    "// Command packet: prefix, length, command, data and checksum. The length and",
+    "// checksum are ASCII hex, the length counts the command, data and checksum, the",
+    "// checksum is the 16 bit byte sum of the length, command and data.",
+    `${pad("#define PROTO_PACKET_PREFIX", 44)}"${packet.prefix}"`,
+    `${pad("#define PROTO_PACKET_LEN", 44)}${packet.len}\t\t\t//Offset of the length, after the prefix`,
+    `${pad("#define PROTO_PACKET_LEN_DIGITS", 44)}${packet.lengthDigits}`,
+    `${pad("#define PROTO_PACKET_CMD", 44)}${packet.cmd}`,
+    `${pad("#define PROTO_PACKET_DATA", 44)}${packet.data}`,
+    `${pad("#define PROTO_PACKET_SUM_DIGITS", 44)}${packet.checksumDigits}`,
+    `${pad("#define PROTO_PACKET_MIN_LEN", 44)}${packet.minLength}\t\t\t//Length of a packet without data`,
+    `${pad("#define PROTO_PACKET_MAX_LEN", 44)}${packet.maxLength}`,
+    `${pad("#define PROTO_PACKET_NO_SUM", 44)}"${packet.noChecksum}"\t\t//Checksum of a packet that is not checked`,
+    "",
+    "// Decoded packet, the data stays in the input",
+    "typedef struct protoPacket{",
+    "\tuint32_t mCmd;\t\t\t\t\t\t//PROTO_CMD_*",
+    "\tconst uint8_t* pData;",
+    "\tuint32_t mDataLen;",
+    "\tbool mSumSent;\t\t\t\t\t\t//false for PROTO_PACKET_NO_SUM",
+    "\tbool mSumValid;\t\t\t\t\t\t//Checksum matches, or was not sent",
+    "}protoPacket_t;",
+    ...C_PACKET_CODEC.split("\n"),
+    "",
+    "// Magic numbers, the 4 letters read as a little endian uint32_t",
+    ...Object.entries(schema.magics).map(([name, text]) => `${pad(`#define PROTO_MAGIC_${snake(name)}`, 44)}${hex(magicLE(text), 8)}UL\t\t//"${text}"`),
+  ];
+
+  for (const [name, values] of Object.entries(schema.enums)) {
+    const prefix = `PROTO_${snake(name)}_`;
+    lines.push("", `// ${name}`);
+    values.forEach(([value, number, doc]) => lines.push(`${pad(`#define ${prefix}${snake(value)}`, 44)}${hex(number)}\t\t//${doc}`));
+    lines.push(`#define PROTO_CHECK_${snake(name)}(prefix) \\`);
+    values.forEach(([value], i) => lines.push(
+      `\t_Static_assert(prefix##${snake(value)} == ${prefix}${snake(value)}, #prefix "${snake(value)} differs from protocolSchema.json")${i < values.length - 1 ? "; \\" : ""}`));
+  }
+
+  for (const layout of Object.values(layouts)) {
+    const prefix = `PROTO_${snake(layout.name)}_`;
+    lines.push("", `// ${layout.name}, byte offset of each field`);
+    layout.fields.forEach(f => lines.push(`${pad(`#define ${prefix}${snake(f.name)}`, 44)}${f.offset}`));
+    lines.push(`${pad(`#define ${prefix}SIZE`, 44)}${layout.size}${layout.hasTail ? "\t\t\t\t//Without the variable part" : ""}`);
+    const checks = layout.fields.map(f => f.tail
+      ? `_Static_assert(offsetof(T, ${f.member}) == ${prefix}${snake(f.name)}, #T ".${f.member} differs from protocolSchema.json")`
+      : `_Static_assert(offsetof(T, ${f.member}) == ${prefix}${snake(f.name)} && sizeof(((T*)0)->${f.member}) == ${f.size}, #T ".${f.member} differs from protocolSchema.json")`);
+    if (!layout.hasTail) checks.push(`_Static_assert(sizeof(T) == ${prefix}SIZE, #T " size differs from protocolSchema.json")`);
+    lines.push(`#define PROTO_CHECK_${snake(layout.name)}(T) \\`);
+    checks.forEach((c, i) => lines.push(`\t${c}${i < checks.length - 1 ? "; \\" : ""}`));
+    lines.push(...cAccessors(layout));
+  }
+
+  lines.push("", "// Every layout, with the X macro of its fields and its size");
+  lines.push("#define PROTO_LAYOUTS(X) \\");
+  Object.values(layouts).forEach((layout, i, all) => lines.push(
+    `\tX(${layout.name}, PROTO_FIELDS_${snake(layout.name)}, PROTO_${snake(layout.name)}_SIZE)${i < all.length - 1 ? " \\" : ""}`));
+
+  lines.push("", "#endif /* COMPONENTS_UTIL_INCLUDE_PROTOSCHEMA_H_ */", "");
+  fs.writeFileSync(PROTO_SCHEMA_H, lines.join("\n"));
+}
+
+// ============ JS ============
+
+const JS_PACKET_CODEC = `
+// Value of digits ASCII hex digits at offset, -1 on any other character
+function hexValue(buffer, offset, digits) {
+  let value = 0;
+  for (let i = offset; i < offset + digits; i++) {
+    const c = buffer[i];
+    const letter = c | 0x20;
+    let digit;
+    if (c >= 0x30 && c <= 0x39) digit = c - 0x30;
+    else if (letter >= 0x61 && letter <= 0x66) digit = letter - 0x57;
+    else return -1;
+    value = value * 16 + digit;
+  }
+  return value;
+}
+
+// value as digits upper case ASCII hex digits at offset
+function writeHex(buffer, offset, value, digits) {
+  for (let i = offset + digits - 1; i >= offset; i--) {
+    buffer[i] = HEX_DIGITS[value & 0x0F];
+    value >>>= 4;
+  }
+}
+
+// Packet checksum of the bytes from start to end
+function packetSum(buffer, start, end) {
+  let sum = 0;
+  for (let i = start; i < end; i++) sum += buffer[i];
+  return sum & 0xFFFF;
+}
+
+// Complete the packet around the dataLength bytes already at pos + PACKET_DATA,
+// with the checksum or PACKET_NO_SUM. Returns the packet length
+function encodePacket(buffer, pos, command, dataLength, withSum = false) {
+  const sumAt = pos + PACKET_DATA + dataLength;
+  PACKET_PREFIX.copy(buffer, pos);
+  writeHex(buffer, pos + PACKET_LEN, dataLength + PACKET_MIN_LEN, PACKET_LEN_DIGITS);
+  buffer.writeUInt32BE(command, pos + PACKET_CMD);
+  if (withSum) writeHex(buffer, sumAt, packetSum(buffer, pos + PACKET_LEN, sumAt), PACKET_SUM_DIGITS);
+  else PACKET_NO_SUM.copy(buffer, sumAt);
+  return sumAt + PACKET_SUM_DIGITS - pos;
+}
+
+// Packet of a CMD_* command, data is an ASCII string or a Buffer
+function buildPacket(command, data = "", withSum = false) {
+  const packet = Buffer.allocUnsafe(PACKET_DATA + data.length + PACKET_SUM_DIGITS);
+  if (typeof data === "string") packet.write(data, PACKET_DATA, "latin1");
+  else data.copy(packet, PACKET_DATA);
+  encodePacket(packet, 0, command, data.length, withSum);
+  return packet;
+}
+
+// Offset of the next packet prefix from offset on, -1 if there is none
+function findPacket(buffer, offset = 0) {
+  return buffer.indexOf(PACKET_PREFIX, offset);
+}
+
+// The bytes at pos, as far as there are any, are the first length bytes of pattern
+function matches(buffer, pos, pattern, length) {
+  const end = Math.min(length, buffer.length - pos);
+  for (let i = 0; i < end; i++) {
+    if (buffer[pos + i] !== pattern[i]) return false;
+  }
+  return true;
+}
+
+// Packet at pos, the data is left in place: sets command, dataStart, dataEnd,
+// sumSent and sumValid of packet. Returns the packet length, 0 if the bytes
+// from pos are the start of a packet, -1 if pos does not start one
+function decodePacket(buffer, pos, packet) {
+  const available = buffer.length - pos;
+  if (!matches(buffer, pos, PACKET_PREFIX, PACKET_LEN)) return -1;
+  if (available < PACKET_DATA) return 0;
+
+  const length = hexValue(buffer, pos + PACKET_LEN, PACKET_LEN_DIGITS);
+  if (length < PACKET_MIN_LEN || length > PACKET_MAX_LEN) return -1;
+  const total = PACKET_CMD + length;
+  if (available < total) return 0;
+
+  const sumAt = pos + total - PACKET_SUM_DIGITS;
+  packet.command = buffer.readUInt32BE(pos + PACKET_CMD);
+  packet.dataStart = pos + PACKET_DATA;
+  packet.dataEnd = sumAt;
+  packet.sumSent = !matches(buffer, sumAt, PACKET_NO_SUM, PACKET_SUM_DIGITS);
+  packet.sumValid = !packet.sumSent || hexValue(buffer, sumAt, PACKET_SUM_DIGITS) === packetSum(buffer, pos + PACKET_LEN, sumAt);
+  return total;
+}`;
+
+// View class of a layout: getters and setters of the fields in the buffer,
+// at() moves it without allocating
+function jsView(layout, layouts) {
+  const table = snake(layout.name);
+  const cls = `${pascal(layout.name)}View`;
+  const lines = [
+    "",
+    `// ${layout.name} in place, at(buffer, offset) moves the view without allocating`,
+    `class ${cls} {`,
+    `  static SIZE = ${layout.size};`,
+    "",
+    "  constructor(buffer = null, offset = 0) {",
+    "    this.buffer = buffer;",
+    "    this.offset = offset;",
+    "  }",
+    "",
+    "  at(buffer, offset = 0) {",
+    "    this.buffer = buffer;",
+    "    this.offset = offset;",
+    "    return this;",
+    "  }",
+    "",
+  ];
+  for (const f of layout.fields) {
+    const at = `this.offset + ${table}.${snake(f.name)}`;
+    if (f.kind === "scalar") {
+      if (f.elem === "u8") {
+        lines.push(`  get ${f.name}() { return this.buffer[${at}]; }`);
+        lines.push(`  set ${f.name}(value) { this.buffer[${at}] = value; }`);
+      } else if (f.elem === "u64") {
+        lines.push(`  get ${f.name}() { return this.buffer.${JS_READ[f.elem]}(${at}); }`);
+        lines.push(`  set ${f.name}(value) { this.buffer.${JS_WRITE[f.elem]}(BigInt(value), ${at}); }`);
+      } else {
+        lines.push(`  get ${f.name}() { return this.buffer.${JS_READ[f.elem]}(${at}); }`);
+        lines.push(`  set ${f.name}(value) { this.buffer.${JS_WRITE[f.elem]}(value, ${at}); }`);
+      }
+    } else if (f.kind === "array") {
+      const item = `${at} + i${f.elemSize > 1 ? ` * ${f.elemSize}` : ""}`;
+      const setter = `set${pascal(f.name)}`;
+      if (f.elem === "u8") {
+        lines.push(`  ${f.name}(i) { return this.buffer[${item}]; }`);
+        lines.push(`  ${setter}(i, value) { this.buffer[${item}] = value; }`);
+      } else {
+        const value = f.elem === "u64" ? "BigInt(value)" : "value";
+        lines.push(`  ${f.name}(i) { return this.buffer.${JS_READ[f.elem]}(${item}); }`);
+        lines.push(`  ${setter}(i, value) { this.buffer.${JS_WRITE[f.elem]}(${value}, ${item}); }`);
+      }
+    } else if (f.kind === "layout") {
+      lines.push(`  get ${f.name}() { return new ${pascal(f.elem)}View(this.buffer, ${at}); }`);
+    } else {
+      lines.push(`  ${f.name}(i = 0) { return new ${pascal(f.elem)}View(this.buffer, ${at} + i * ${snake(f.elem)}.SIZE); }`);
+    }
+  }
+  lines.push("}");
+  return lines;
+}
+
+function writeProtocolJs(schema, packet, layouts) {
+  const names = [];
+  const lines = ["// Generated by genProtocol.js from protocolSchema.json, do not edit.", ""];
+  const exported = (id, line) => {
+    names.push(id);
+    lines.push(line);
+  };
+
+  for (const [name, text] of Object.entries(schema.magics)) {
+    exported(`${snake(name)}_MAGIC`, `const ${snake(name)}_MAGIC = Buffer.from("${text}", "ascii");`);
+  }
+  for (const [name, values] of Object.entries(schema.enums)) {
+    lines.push("");
+    for (const [value, number, doc] of values) {
+      exported(`${snake(name)}_${snake(value)}`, `const ${snake(name)}_${snake(value)} = ${hex(number)}; // ${doc}`);
+    }
+  }
+
+  lines.push("", "// Command words, the 4 letters big endian as PROTO_CMD_* of the firmware");
+  for (const [name, doc] of schema.commands) {
+    exported(`CMD_${name}`, `const CMD_${name} = ${hex(magicBE(name), 8)}; // ${doc}`);
+  }
+
+  lines.push("",
+    "// Command packet: prefix, length, command, data and checksum. The length and",
+    "// checksum are ASCII hex, the length counts the command, data and checksum, the",
+    "// checksum is the 16 bit byte sum of the length, command and data");
+  exported("PACKET_PREFIX", `const PACKET_PREFIX = Buffer.from("${packet.prefix}", "ascii");`);
+  exported("PACKET_LEN", `const PACKET_LEN = ${packet.len}; // Offset of the length, after the prefix`);
+  exported("PACKET_LEN_DIGITS", `const PACKET_LEN_DIGITS = ${packet.lengthDigits};`);
+  exported("PACKET_CMD", `const PACKET_CMD = ${packet.cmd};`);
+  exported("PACKET_DATA", `const PACKET_DATA = ${packet.data};`);
+  exported("PACKET_SUM_DIGITS", `const PACKET_SUM_DIGITS = ${packet.checksumDigits};`);
+  exported("PACKET_MIN_LEN", `const PACKET_MIN_LEN = ${packet.minLength}; // Length of a packet without data`);
+  exported("PACKET_MAX_LEN", `const PACKET_MAX_LEN = ${packet.maxLength};`);
+  exported("PACKET_NO_SUM", `const PACKET_NO_SUM = Buffer.from("${packet.noChecksum}", "ascii"); // Checksum of a packet that is not checked`);
+  lines.push(`const HEX_DIGITS = Buffer.from("0123456789ABCDEF", "ascii");`);
+  lines.push(...JS_PACKET_CODEC.split("\n"));
+  names.push("hexValue", "writeHex", "packetSum", "encodePacket", "buildPacket", "findPacket", "decodePacket");
+
+  lines.push("", "// Byte offset of each field, SIZE is the size without a variable part");
+  for (const layout of Object.values(layouts)) {
+    const fields = layout.fields.map(f => `${snake(f.name)}: ${f.offset}`).concat(`SIZE: ${layout.size}`);
+    exported(snake(layout.name), `const ${snake(layout.name)} = Object.freeze({ ${fields.join(", ")} });`);
+  }
+  for (const layout of Object.values(layouts)) {
+    lines.push(...jsView(layout, layouts));
+    names.push(`${pascal(layout.name)}View`);
+  }
+
+  lines.push("", "module.exports = {");
+  for (let i = 0; i < names.length; i += 4) lines.push(`  ${names.slice(i, i + 4).join(", ")},`);
+  lines.push("};", "");
+  fs.writeFileSync(PROTOCOL_JS, lines.join("\n"));
+}
+
+// ============ Swift ============
+
+const SWIFT_PACKET_CODEC = `
+    /// ASCII hex straight from the bytes, nil on a bad digit
+    static func hexValue<Bytes: RandomAccessCollection>(_ bytes: Bytes, at offset: Int, digits: Int) -> Int?
+        where Bytes.Element == UInt8, Bytes.Index == Int {
+        var value = 0
+        for i in offset..<(offset + digits) {
+            let c = bytes[bytes.startIndex + i]
+            switch c {
+            case 0x30...0x39: value = value << 4 | Int(c - 0x30)
+            case 0x41...0x46: value = value << 4 | Int(c - 0x37)
+            case 0x61...0x66: value = value << 4 | Int(c - 0x57)
+            default: return nil
+            }
+        }
+        return value
+    }
+
+    /// value as digits upper case ASCII hex digits
+    static func appendHex(_ value: Int, digits: Int, to bytes: inout [UInt8]) {
+        for shift in stride(from: (digits - 1) * 4, through: 0, by: -4) {
+            bytes.append(hexDigits[(value >> shift) & 0x0F])
+        }
+    }
+
+    private static let hexDigits: [UInt8] = Array("0123456789ABCDEF".utf8)
+
+    /// Packet checksum, the 16 bit byte sum
+    static func packetSum<Bytes: Sequence>(_ bytes: Bytes) -> UInt16 where Bytes.Element == UInt8 {
+        bytes.reduce(UInt16(0)) { $0 &+ UInt16($1) }
+    }
+
+    /// Packet of command with binary data, with the checksum or packetNoSum
+    static func buildPacket<Payload: Collection>(command: UInt32, data: Payload, withSum: Bool = false) -> Data
+        where Payload.Element == UInt8 {
+        var packet = packetPrefix
+        packet.reserveCapacity(packetData + data.count + packetSumDigits)
+        appendHex(data.count + packetMinLen, digits: packetLenDigits, to: &packet)
+        for shift in stride(from: 24, through: 0, by: -8) {
+            packet.append(UInt8(truncatingIfNeeded: command >> UInt32(shift)))
+        }
+        packet.append(contentsOf: data)
+        if withSum {
+            appendHex(Int(packetSum(packet[packetLen...])), digits: packetSumDigits, to: &packet)
+        } else {
+            packet.append(contentsOf: packetNoSum)
+        }
+        return Data(packet)
+    }
+
+    /// Packet of command with ASCII data
+    static func buildPacket(command: UInt32, data: String = "", withSum: Bool = false) -> Data {
+        buildPacket(command: command, data: Array(data.utf8), withSum: withSum)
+    }
+
+    /// A complete packet in a receive buffer, as offsets from the start of the bytes
+    struct Packet {
+        let command: UInt32
+        let data: Range<Int>  // Excluding command and checksum
+        let end: Int
+        let sumSent: Bool
+        let sumValid: Bool  // The checksum matches, or was not sent
+    }
+
+    enum PacketDecode {
+        case packet(Packet)
+        /// The bytes are the start of a packet, wait for more
+        case incomplete
+        /// No packet starts here
+        case invalid
+    }
+
+    /// Offset of the next packet prefix from offset on, nil if there is none
+    static func findPacket<Bytes: RandomAccessCollection>(_ bytes: Bytes, from offset: Int = 0) -> Int?
+        where Bytes.Element == UInt8, Bytes.Index == Int {
+        var i = offset
+        while i + packetLen <= bytes.count {
+            if matches(bytes, at: i, packetPrefix) {
+                return i
+            }
+            i += 1
+        }
+        return nil
+    }
+
+    /// Decode the packet at offset in place
+    static func decodePacket<Bytes: RandomAccessCollection>(_ bytes: Bytes, at offset: Int) -> PacketDecode
+        where Bytes.Element == UInt8, Bytes.Index == Int {
+        guard matches(bytes, at: offset, packetPrefix) else { return .invalid }
+        guard bytes.count - offset >= packetData else { return .incomplete }
+        guard let length = hexValue(bytes, at: offset + packetLen, digits: packetLenDigits),
+              length >= packetMinLen, length <= packetMaxLen else {
+            return .invalid
+        }
+
+        let end = offset + packetCmd + length
+        guard end <= bytes.count else { return .incomplete }
+
+        let base = bytes.startIndex
+        let sumAt = end - packetSumDigits
+        var command: UInt32 = 0
+        for k in 0..<4 {
+            command = command << 8 | UInt32(bytes[base + offset + packetCmd + k])
+        }
+        let sumSent = !matches(bytes, at: sumAt, packetNoSum)
+        let sum = hexValue(bytes, at: sumAt, digits: packetSumDigits)
+        let sumValid = !sumSent || sum == Int(packetSum(bytes[(base + offset + packetLen)..<(base + sumAt)]))
+        return .packet(Packet(command: command, data: (offset + packetData)..<sumAt, end: end,
+                              sumSent: sumSent, sumValid: sumValid))
+    }
+
+    /// The bytes at offset, as far as there are any, are the start of pattern
+    private static func matches<Bytes: RandomAccessCollection>(_ bytes: Bytes, at offset: Int, _ pattern: [UInt8]) -> Bool
+        where Bytes.Element == UInt8, Bytes.Index == Int {
+        let base = bytes.startIndex + offset
+        for k in 0..<Swift.max(0, Swift.min(pattern.count, bytes.count - offset)) where bytes[base + k] != pattern[k] {
+            return false
+        }
+        return true
+    }
+
+    /// Little endian field at any alignment
+    static func readLE<Bytes: RandomAccessCollection, Value: FixedWidthInteger>(_ bytes: Bytes, _ offset: Int) -> Value
+        where Bytes.Element == UInt8, Bytes.Index == Int {
+        let base = bytes.startIndex + offset
+        var value: Value = 0
+        for i in (0..<(Value.bitWidth / 8)).reversed() {
+            value = value << 8 | Value(bytes[base + i])
+        }
+        return value
+    }
+
+    static func writeLE<Bytes: MutableCollection, Value: FixedWidthInteger>(_ value: Value, to bytes: inout Bytes, _ offset: Int)
+        where Bytes.Element == UInt8, Bytes.Index == Int {
+        let base = bytes.startIndex + offset
+        for i in 0..<(Value.bitWidth / 8) {
+            bytes[base + i] = UInt8(truncatingIfNeeded: value >> (i * 8))
+        }
+    }`;
+
+// View struct of a layout: getters of the fields in place, setters when the
+// bytes are mutable
+function swiftView(layout) {
+  const view = `${pascal(layout.name)}View`;
+  const offsets = `${pascal(layout.name)}Layout`;
+  const lines = [
+    "",
+    `    /// ${layout.name} in place, the fields are read when used`,
+    `    struct ${view}<Bytes: RandomAccessCollection> where Bytes.Element == UInt8, Bytes.Index == Int {`,
+    "        var bytes: Bytes",
+    "        let offset: Int",
+    "",
+    "        init(_ bytes: Bytes, at offset: Int = 0) {",
+    "            self.bytes = bytes",
+    "            self.offset = offset",
+    "        }",
+    "",
+  ];
+  const setters = [];
+  for (const f of layout.fields) {
+    const at = `offset + ${offsets}.${f.name}`;
+    const type = SWIFT_TYPES[f.elem];
+    if (f.kind === "scalar") {
+      lines.push(`        var ${f.name}: ${type} { ThermalProtocol.readLE(bytes, ${at}) }`);
+      setters.push(
+        `        mutating func set${pascal(f.name)}(_ value: ${type}) where Bytes: MutableCollection {`,
+        `            ThermalProtocol.writeLE(value, to: &bytes, ${at})`,
+        "        }");
+    } else if (f.kind === "array") {
+      lines.push(`        func ${f.name}(_ i: Int) -> ${type} { ThermalProtocol.readLE(bytes, ${at} + i * ${f.elemSize}) }`);
+      setters.push(
+        `        mutating func set${pascal(f.name)}(_ i: Int, _ value: ${type}) where Bytes: MutableCollection {`,
+        `            ThermalProtocol.writeLE(value, to: &bytes, ${at} + i * ${f.elemSize})`,
+        "        }");
+    } else if (f.kind === "layout") {
+      lines.push(`        var ${f.name}: ${pascal(f.elem)}View<Bytes> { ${pascal(f.elem)}View(bytes, at: ${at}) }`);
+    } else {
+      lines.push(`        func ${f.name}(_ i: Int = 0) -> ${pascal(f.elem)}View<Bytes> {`,
+        `            ${pascal(f.elem)}View(bytes, at: ${at} + i * ${pascal(f.elem)}Layout.size)`,
+        "        }");
+    }
+  }
+  lines.push("", ...setters, "    }");
+  return lines;
+}
+
+function writeSwift(registers, schema, packet, layouts) {
+  const ranges = wideRanges(registers).map(([a, b]) => `${hex(a)}...${hex(b)}`).join(", ");
+  replaceBlock(SWIFT, "// BEGIN generated register map", "// END generated register map", [
+    `    static let wideRegisterRanges: [ClosedRange<UInt8>] = [${ranges}]`,
+  ]);
+
+  const lines = [];
+  for (const [name, text] of Object.entries(schema.magics)) {
+    lines.push(`    static let ${name}Magic: [UInt8] = [${byteList(text)}]  // "${text}"`);
+  }
+  for (const [name, values] of Object.entries(schema.enums)) {
+    for (const [value, number, doc] of values) {
+      lines.push(`    static let ${name}${value}: UInt8 = ${hex(number)}  // ${doc}`);
+    }
+  }
+
+  lines.push("", "    /// Command words, the 4 letters big endian as PROTO_CMD_* of the firmware");
+  for (const [name, doc] of schema.commands) {
+    lines.push(`    static let command${name}: UInt32 = ${hex(magicBE(name), 8)}  // ${doc}`);
+  }
+
+  lines.push("",
+    "    /// Command packet: prefix, length, command, data and checksum. The length and",
+    "    /// checksum are ASCII hex, the length counts the command, data and checksum, the",
+    "    /// checksum is the 16 bit byte sum of the length, command and data",
+    `    static let packetPrefix: [UInt8] = [${byteList(packet.prefix)}]  // "${packet.prefix}"`,
+    `    static let packetLen = ${packet.len}  // Offset of the length, after the prefix`,
+    `    static let packetLenDigits = ${packet.lengthDigits}`,
+    `    static let packetCmd = ${packet.cmd}`,
+    `    static let packetData = ${packet.data}`,
+    `    static let packetSumDigits = ${packet.checksumDigits}`,
+    `    static let packetMinLen = ${packet.minLength}  // Length of a packet without data`,
+    `    static let packetMaxLen = ${packet.maxLength}`,
+    `    static let packetNoSum: [UInt8] = [${byteList(packet.noChecksum)}]  // "${packet.noChecksum}", not checked`);
+  lines.push(...SWIFT_PACKET_CODEC.split("\n"));
+
+  for (const layout of Object.values(layouts)) {
+    lines.push("", `    /// Byte offset of each field of ${layout.name}, size without a variable part`);
+    lines.push(`    enum ${pascal(layout.name)}Layout {`);
+    layout.fields.forEach(f => lines.push(`        static let ${f.name} = ${f.offset}`));
+    lines.push(`        static let size = ${layout.size}`, "    }");
+  }
+  for (const layout of Object.values(layouts)) {
+    lines.push(...swiftView(layout));
+  }
+  replaceBlock(SWIFT, "// BEGIN generated protocol schema", "// END generated protocol schema", lines);
+}
+
+// ============ Conformance vectors ============
+
+// Packets of the vectors: command, data, checksum (0 none, 1 computed, 2 wrong)
+const VECTOR_PACKETS = [
+  ["WREG", "C201", 0],
+  ["WREG", "C201", 1],
+  ["WREG", "C201", 2],
+  ["RREG", "C2", 1],
+  ["RREG", "C20BB8", 1],
+  ["RRSE", "C0C1C2C3FF", 0],
+  ["SFMT", "0202", 1],
+  ["SAVE", "", 1],
+  ["SUBV", [0x02, 0xC2, 0x34, 0x12, 0xC3, 0xFF, 0xEE, 0x5A, 0xA5], 1],
+  ["BRWR", [0x01, 0x00, 0xC2, 0x00, 0x00, 0x9E, 0x31], 0],
+];
+
+// Deterministic field values of every width, so a vector exercises the top bits
+function* vectorValues(seed) {
+  let state = BigInt(seed) | 1n;
+  for (;;) {
+    state = (state * 6364136223846793005n + 1442695040888963407n) & 0xFFFFFFFFFFFFFFFFn;
+    yield state;
+  }
+}
+
+// One line per packet and per layout, the bytes laid out from the schema
+// itself, not with any of the generated codecs:
+//   packet <command> <checksum> <data hex or -> <packet hex>
+//   layout <name> <bytes hex> <value of every scalar field, arrays element by element>
+// Nested layouts and the variable part are zero, each layout has its own line.
+function writeVectors(packet, layouts) {
+  const lines = [
+    "# Generated by Node_Thermal_TCP/genProtocol.js from protocolSchema.json, do not edit.",
+    "# packet <command> <checksum: 0 none, 1 computed, 2 wrong> <data hex or -> <packet hex>",
+  ];
+  for (const [command, data, sum] of VECTOR_PACKETS) {
+    const body = Buffer.concat([
+      Buffer.from((Buffer.byteLength(Buffer.from(data)) + packet.minLength).toString(16).toUpperCase().padStart(packet.lengthDigits, "0"), "ascii"),
+      Buffer.from(command, "ascii"),
+      Buffer.from(data),
+    ]);
+    let checksum = Buffer.from(packet.noChecksum, "ascii");
+    if (sum !== 0) {
+      let total = 0;
+      for (const b of body) total += b;
+      const value = (total + (sum === 2 ? 1 : 0)) & 0xFFFF;
+      checksum = Buffer.from(value.toString(16).toUpperCase().padStart(packet.checksumDigits, "0"), "ascii");
+    }
+    const bytes = Buffer.concat([Buffer.from(packet.prefix, "ascii"), body, checksum]);
+    const dataHex = Buffer.from(data).toString("hex").toUpperCase() || "-";
+    lines.push(`packet ${command} ${sum} ${dataHex} ${bytes.toString("hex").toUpperCase()}`);
+  }
+
+  lines.push("# layout <name> <bytes hex> <value of every scalar field in schema order, arrays element by element>");
+  Object.values(layouts).forEach((layout, n) => {
+    const bytes = Buffer.alloc(layout.size);
+    const values = [];
+    const random = vectorValues(n + 1);
+    for (const f of layout.fields) {
+      if (f.kind !== "scalar" && f.kind !== "array") continue;
+      for (let i = 0; i < f.count; i++) {
+        const value = random.next().value >> BigInt(64 - f.elemSize * 8);
+        const at = f.offset + i * f.elemSize;
+        for (let k = 0; k < f.elemSize; k++) bytes[at + k] = Number((value >> BigInt(k * 8)) & 0xFFn);
+        values.push(value.toString());
+      }
+    }
+    lines.push(`layout ${layout.name} ${bytes.toString("hex").toUpperCase()} ${values.join(" ")}`);
+  });
+  fs.writeFileSync(VECTORS, lines.join("\n") + "\n");
+}
+
+if (require.main === module) {
+  const registers = parseRegMap(fs.readFileSync(REG_MAP_H, "utf8"));
+  const schema = JSON.parse(fs.readFileSync(SCHEMA_JSON, "utf8"));
+  const packet = parsePacket(schema.packet);
+  const layouts = parseLayouts(schema.layouts);
+
+  writeRegistersJs(registers);
+  writeProtocolMd(registers);
+  writeProtoSchemaH(schema, packet, layouts);
+  writeProtocolJs(schema, packet, layouts);
+  writeSwift(registers, schema, packet, layouts);
+  writeVectors(packet, layouts);
+  console.log(`${registers.length} registers, ${schema.commands.length} commands and ${Object.keys(layouts).length} layouts written`);
+}
+
+// The layouts as the generator sees them, for protocolTest.js
+module.exports = { SCHEMA_JSON, VECTORS, parseLayouts };
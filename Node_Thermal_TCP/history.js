@@ -0,0 +1,129 @@
+// In-memory history of the quadrant and frame statistics, for trend charts.
+// Every metric keeps min/max/sum/count rollups at several resolutions. Each
+// resolution is a fixed ring of typed arrays, updated as samples arrive, so a
+// chart window is served from the rollup that fits it without rescanning samples.
+
+const RESOLUTIONS = [
+  { seconds: 1, capacity: 3600 },   // 1 hour
+  { seconds: 10, capacity: 8640 },  // 24 hours
+  { seconds: 60, capacity: 10080 }  // 7 days
+];
+
+class RollupRing {
+  constructor(seconds, capacity) {
+    this.seconds = seconds;
+    this.capacity = capacity;
+    this.bucket = new Float64Array(capacity); // Bucket number, start time / seconds
+    this.min = new Float32Array(capacity);
+    this.max = new Float32Array(capacity);
+    this.sum = new Float64Array(capacity);
+    this.count = new Uint32Array(capacity);
+    this.head = -1; // Slot of the newest bucket
+    this.size = 0;
+  }
+
+  get span() {
+    return this.seconds * this.capacity;
+  }
+
+  add(time, value) {
+    const bucket = Math.floor(time / this.seconds);
+    const head = this.head;
+
+    if (this.size > 0 && bucket === this.bucket[head]) {
+      if (value < this.min[head]) this.min[head] = value;
+      if (value > this.max[head]) this.max[head] = value;
+      this.sum[head] += value;
+      this.count[head]++;
+      return;
+    }
+    if (this.size > 0 && bucket < this.bucket[head]) return; // Clock stepped back, dropped
+
+    this.head = (head + 1) % this.capacity;
+    this.size = Math.min(this.size + 1, this.capacity);
+    this.bucket[this.head] = bucket;
+    this.min[this.head] = value;
+    this.max[this.head] = value;
+    this.sum[this.head] = value;
+    this.count[this.head] = 1;
+  }
+
+  // Buckets from time `from` on, oldest first, merged `step` at a time
+  query(from, step) {
+    const result = { time: [], min: [], max: [], avg: [] };
+    const first = Math.floor(from / this.seconds);
+
+    // Walk back to the first bucket of the window, only the window is visited
+    let n = 0;
+    while (n < this.size && this.bucket[(this.head - n + this.capacity) % this.capacity] >= first) n++;
+
+    let group = null;
+    let min = 0, max = 0, sum = 0, count = 0;
+    const flush = () => {
+      result.time.push(group * step * this.seconds);
+      result.min.push(min);
+      result.max.push(max);
+      result.avg.push(sum / count);
+    };
+
+    for (let i = n - 1; i >= 0; i--) {
+      const slot = (this.head - i + this.capacity) % this.capacity;
+      const g = Math.floor(this.bucket[slot] / step);
+      if (g !== group) {
+        if (group !== null) flush();
+        group = g;
+        min = this.min[slot];
+        max = this.max[slot];
+        sum = 0;
+        count = 0;
+      }
+      min = Math.min(min, this.min[slot]);
+      max = Math.max(max, this.max[slot]);
+      sum += this.sum[slot];
+      count += this.count[slot];
+    }
+    if (group !== null) flush();
+
+    return result;
+  }
+}
+
+class HistoryStore {
+  constructor(resolutions = RESOLUTIONS) {
+    this.resolutions = resolutions;
+    this.metrics = new Map(); // Name -> RollupRing per resolution, finest first
+  }
+
+  record(metric, value, time = Date.now() / 1000) {
+    let rings = this.metrics.get(metric);
+    if (!rings) {
+      rings = this.resolutions.map(r => new RollupRing(r.seconds, r.capacity));
+      this.metrics.set(metric, rings);
+    }
+    for (const ring of rings) ring.add(time, value);
+  }
+
+  metricNames() {
+    return [...this.metrics.keys()];
+  }
+
+  // The last windowSeconds of a metric in about maxPoints points, or null if unknown.
+  // Uses the coarsest rollup that is still detailed enough and reaches back far enough
+  query(metric, windowSeconds, maxPoints, now = Date.now() / 1000) {
+    const rings = this.metrics.get(metric);
+    if (!rings) return null;
+
+    const target = windowSeconds / maxPoints; // Seconds per point
+    let ring = null;
+    for (const candidate of rings) {
+      if (candidate.span < windowSeconds) continue;
+      if (!ring || candidate.seconds <= target) ring = candidate;
+    }
+    ring = ring || rings[rings.length - 1];
+
+    const step = Math.max(1, Math.ceil(target / ring.seconds));
+    return { metric, resolution: ring.seconds * step, ...ring.query(now - windowSeconds, step) };
+  }
+}
+
+module.exports = { HistoryStore };
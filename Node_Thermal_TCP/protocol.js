@@ -0,0 +1,488 @@
+// Generated by genProtocol.js from protocolSchema.json, do not edit.
+
+const STREAM_MAGIC = Buffer.from("SXFR", "ascii");
+const UDP_CHUNK_MAGIC = Buffer.from("SXUC", "ascii");
+const UDP_HELLO_MAGIC = Buffer.from("SXHI", "ascii");
+const UDP_BYE_MAGIC = Buffer.from("SXBY", "ascii");
+
+const STREAM_ENCODING_RAW16 = 0x00; // 80x64 uint16 pixels as captured
+const STREAM_ENCODING_DELTA = 0x01; // Zigzag varint residuals with zero runs
+const STREAM_ENCODING_DELTA_LZ = 0x02; // Delta residuals, LZ compressed
+const STREAM_ENCODING_PACK12 = 0x03; // Image bit packed to 12 bits per pixel
+const STREAM_ENCODING_PACK14 = 0x04; // Image bit packed to 14 bits per pixel
+const STREAM_ENCODING_PACK8 = 0x05; // Image bit packed to 8 bits, lossy beyond a 255 count span
+
+const STREAM_FLAG_KEYFRAME = 0x01; // Payload does not depend on the previous frame
+const STREAM_FLAG_STATS = 0x02; // Header carries the frame statistics
+const STREAM_FLAG_CRC32 = 0x04; // payloadCrc holds the CRC32 of the payload
+const STREAM_FLAG_SHAPED = 0x08; // Payload is the image window of shape
+const STREAM_FLAG_BLOBS = 0x10; // Header ends with the used part of the blob record
+const STREAM_FLAG_UTC = 0x20; // utcUs holds the capture time in UTC
+
+// Command words, the 4 letters big endian as PROTO_CMD_* of the firmware
+const CMD_WREG = 0x57524547; // Write a register
+const CMD_RREG = 0x52524547; // Read a register
+const CMD_RRSE = 0x52525345; // Read a register sequence
+const CMD_BRWR = 0x42525752; // Binary batch register read and write
+const CMD_WSID = 0x57534944; // Set the Wi-Fi SSID
+const CMD_WPWD = 0x57505744; // Set the Wi-Fi password
+const CMD_WMDE = 0x574D4445; // Set the Wi-Fi mode
+const CMD_POLL = 0x504F4C4C; // Set the quadrant polling rate
+const CMD_STAT = 0x53544154; // Read stream statistics
+const CMD_SFMT = 0x53464D54; // Select the frame stream format
+const CMD_SHAP = 0x53484150; // Shape the frame stream
+const CMD_SCRC = 0x53435243; // Select the frame integrity check
+const CMD_CAPS = 0x43415053; // Read capture interrupt statistics
+const CMD_LATS = 0x4C415453; // Read pipeline latency
+const CMD_ROIW = 0x524F4957; // Define a region of interest
+const CMD_ROIR = 0x524F4952; // Read region of interest statistics
+const CMD_SUBS = 0x53554253; // Subscribe to register updates
+const CMD_SUBV = 0x53554256; // Register update push
+const CMD_RECC = 0x52454343; // Frame recorder control
+const CMD_RECD = 0x52454344; // Download a recorded clip
+const CMD_SAVE = 0x53415645; // Commit the configuration
+const CMD_BPIX = 0x42504958; // Bad pixel map
+const CMD_BNCH = 0x424E4348; // Run a microbenchmark
+const CMD_SYST = 0x53595354; // Read system telemetry
+const CMD_BLOB = 0x424C4F42; // Hot spot blob tracking
+const CMD_RULE = 0x52554C45; // Alarm rules
+const CMD_ALRM = 0x414C524D; // Alarm event push
+const CMD_ESPN = 0x4553504E; // ESP-NOW peer table
+const CMD_CORR = 0x434F5252; // Per-pixel correction map
+
+// Command packet: prefix, length, command, data and checksum. The length and
+// checksum are ASCII hex, the length counts the command, data and checksum, the
+// checksum is the 16 bit byte sum of the length, command and data
+const PACKET_PREFIX = Buffer.from("   #", "ascii");
+const PACKET_LEN = 4; // Offset of the length, after the prefix
+const PACKET_LEN_DIGITS = 4;
+const PACKET_CMD = 8;
+const PACKET_DATA = 12;
+const PACKET_SUM_DIGITS = 4;
+const PACKET_MIN_LEN = 8; // Length of a packet without data
+const PACKET_MAX_LEN = 15000;
+const PACKET_NO_SUM = Buffer.from("XXXX", "ascii"); // Checksum of a packet that is not checked
+const HEX_DIGITS = Buffer.from("0123456789ABCDEF", "ascii");
+
+// Value of digits ASCII hex digits at offset, -1 on any other character
+function hexValue(buffer, offset, digits) {
+  let value = 0;
+  for (let i = offset; i < offset + digits; i++) {
+    const c = buffer[i];
+    const letter = c | 0x20;
+    let digit;
+    if (c >= 0x30 && c <= 0x39) digit = c - 0x30;
+    else if (letter >= 0x61 && letter <= 0x66) digit = letter - 0x57;
+    else return -1;
+    value = value * 16 + digit;
+  }
+  return value;
+}
+
+// value as digits upper case ASCII hex digits at offset
+function writeHex(buffer, offset, value, digits) {
+  for (let i = offset + digits - 1; i >= offset; i--) {
+    buffer[i] = HEX_DIGITS[value & 0x0F];
+    value >>>= 4;
+  }
+}
+
+// Packet checksum of the bytes from start to end
+function packetSum(buffer, start, end) {
+  let sum = 0;
+  for (let i = start; i < end; i++) sum += buffer[i];
+  return sum & 0xFFFF;
+}
+
+// Complete the packet around the dataLength bytes already at pos + PACKET_DATA,
+// with the checksum or PACKET_NO_SUM. Returns the packet length
+function encodePacket(buffer, pos, command, dataLength, withSum = false) {
+  const sumAt = pos + PACKET_DATA + dataLength;
+  PACKET_PREFIX.copy(buffer, pos);
+  writeHex(buffer, pos + PACKET_LEN, dataLength + PACKET_MIN_LEN, PACKET_LEN_DIGITS);
+  buffer.writeUInt32BE(command, pos + PACKET_CMD);
+  if (withSum) writeHex(buffer, sumAt, packetSum(buffer, pos + PACKET_LEN, sumAt), PACKET_SUM_DIGITS);
+  else PACKET_NO_SUM.copy(buffer, sumAt);
+  return sumAt + PACKET_SUM_DIGITS - pos;
+}
+
+// Packet of a CMD_* command, data is an ASCII string or a Buffer
+function buildPacket(command, data = "", withSum = false) {
+  const packet = Buffer.allocUnsafe(PACKET_DATA + data.length + PACKET_SUM_DIGITS);
+  if (typeof data === "string") packet.write(data, PACKET_DATA, "latin1");
+  else data.copy(packet, PACKET_DATA);
+  encodePacket(packet, 0, command, data.length, withSum);
+  return packet;
+}
+
+// Offset of the next packet prefix from offset on, -1 if there is none
+function findPacket(buffer, offset = 0) {
+  return buffer.indexOf(PACKET_PREFIX, offset);
+}
+
+// The bytes at pos, as far as there are any, are the first length bytes of pattern
+function matches(buffer, pos, pattern, length) {
+  const end = Math.min(length, buffer.length - pos);
+  for (let i = 0; i < end; i++) {
+    if (buffer[pos + i] !== pattern[i]) return false;
+  }
+  return true;
+}
+
+// Packet at pos, the data is left in place: sets command, dataStart, dataEnd,
+// sumSent and sumValid of packet. Returns the packet length, 0 if the bytes
+// from pos are the start of a packet, -1 if pos does not start one
+function decodePacket(buffer, pos, packet) {
+  const available = buffer.length - pos;
+  if (!matches(buffer, pos, PACKET_PREFIX, PACKET_LEN)) return -1;
+  if (available < PACKET_DATA) return 0;
+
+  const length = hexValue(buffer, pos + PACKET_LEN, PACKET_LEN_DIGITS);
+  if (length < PACKET_MIN_LEN || length > PACKET_MAX_LEN) return -1;
+  const total = PACKET_CMD + length;
+  if (available < total) return 0;
+
+  const sumAt = pos + total - PACKET_SUM_DIGITS;
+  packet.command = buffer.readUInt32BE(pos + PACKET_CMD);
+  packet.dataStart = pos + PACKET_DATA;
+  packet.dataEnd = sumAt;
+  packet.sumSent = !matches(buffer, sumAt, PACKET_NO_SUM, PACKET_SUM_DIGITS);
+  packet.sumValid = !packet.sumSent || hexValue(buffer, sumAt, PACKET_SUM_DIGITS) === packetSum(buffer, pos + PACKET_LEN, sumAt);
+  return total;
+}
+
+// Byte offset of each field, SIZE is the size without a variable part
+const FRAME_STATS = Object.freeze({ MIN: 0, MAX: 2, MEAN: 4, P50: 6, P95: 8, P99: 10, BUCKET_LO: 12, BUCKET_SHIFT: 14, SCALE: 15, BUCKET: 16, SIZE: 48 });
+const STREAM_SHAPE = Object.freeze({ X: 0, Y: 1, WIDTH: 2, HEIGHT: 3, DECIMATION: 4, RATE_DIV: 5, OUT_WIDTH: 6, OUT_HEIGHT: 7, SIZE: 8 });
+const BLOB_ENTRY = Object.freeze({ ID: 0, FLAGS: 1, AREA: 2, PEAK: 4, PEAK_X: 6, PEAK_Y: 7, CX: 8, CY: 10, SIZE: 12 });
+const BLOB_RECORD = Object.freeze({ SEQ: 0, COUNT: 4, FLAGS: 5, BLOBS: 6, SIZE: 6 });
+const STREAM_HEADER = Object.freeze({ MAGIC: 0, VERSION: 4, ENCODING: 5, HEADER_LEN: 6, SEQ: 8, TIMESTAMP_US: 12, PAYLOAD_LEN: 20, FLAGS: 24, RESERVED: 25, STATS: 28, PAYLOAD_CRC: 76, SHAPE: 80, UTC_US: 88, BLOBS: 96, SIZE: 96 });
+const UDP_CHUNK_HEADER = Object.freeze({ MAGIC: 0, FRAME_ID: 4, CHUNK_IDX: 8, CHUNK_COUNT: 10, FRAME_LEN: 12, SIZE: 16 });
+const MQTT_BATCH_HEADER = Object.freeze({ VERSION: 0, SAMPLES: 1, PERIOD_MS: 2, UPTIME_MS: 4, SEQ: 8, UTC_MS: 12, SIZE: 20 });
+const MQTT_SAMPLE = Object.freeze({ OFFSET_MS: 0, COUNT: 2, SIZE: 3 });
+const MQTT_ROI_ENTRY = Object.freeze({ ROI: 0, MIN: 1, MAX: 3, MEAN: 5, PERCENTILE: 7, SIZE: 9 });
+const MQTT_EVENT_ENTRY = Object.freeze({ RULE: 0, RAISED: 1, VALUE: 2, ACTIVE: 4, SEQ: 5, SIZE: 9 });
+
+// frameStats in place, at(buffer, offset) moves the view without allocating
+class FrameStatsView {
+  static SIZE = 48;
+
+  constructor(buffer = null, offset = 0) {
+    this.buffer = buffer;
+    this.offset = offset;
+  }
+
+  at(buffer, offset = 0) {
+    this.buffer = buffer;
+    this.offset = offset;
+    return this;
+  }
+
+  get min() { return this.buffer.readUInt16LE(this.offset + FRAME_STATS.MIN); }
+  set min(value) { this.buffer.writeUInt16LE(value, this.offset + FRAME_STATS.MIN); }
+  get max() { return this.buffer.readUInt16LE(this.offset + FRAME_STATS.MAX); }
+  set max(value) { this.buffer.writeUInt16LE(value, this.offset + FRAME_STATS.MAX); }
+  get mean() { return this.buffer.readUInt16LE(this.offset + FRAME_STATS.MEAN); }
+  set mean(value) { this.buffer.writeUInt16LE(value, this.offset + FRAME_STATS.MEAN); }
+  get p50() { return this.buffer.readUInt16LE(this.offset + FRAME_STATS.P50); }
+  set p50(value) { this.buffer.writeUInt16LE(value, this.offset + FRAME_STATS.P50); }
+  get p95() { return this.buffer.readUInt16LE(this.offset + FRAME_STATS.P95); }
+  set p95(value) { this.buffer.writeUInt16LE(value, this.offset + FRAME_STATS.P95); }
+  get p99() { return this.buffer.readUInt16LE(this.offset + FRAME_STATS.P99); }
+  set p99(value) { this.buffer.writeUInt16LE(value, this.offset + FRAME_STATS.P99); }
+  get bucketLo() { return this.buffer.readUInt16LE(this.offset + FRAME_STATS.BUCKET_LO); }
+  set bucketLo(value) { this.buffer.writeUInt16LE(value, this.offset + FRAME_STATS.BUCKET_LO); }
+  get bucketShift() { return this.buffer[this.offset + FRAME_STATS.BUCKET_SHIFT]; }
+  set bucketShift(value) { this.buffer[this.offset + FRAME_STATS.BUCKET_SHIFT] = value; }
+  get scale() { return this.buffer[this.offset + FRAME_STATS.SCALE]; }
+  set scale(value) { this.buffer[this.offset + FRAME_STATS.SCALE] = value; }
+  bucket(i) { return this.buffer.readUInt16LE(this.offset + FRAME_STATS.BUCKET + i * 2); }
+  setBucket(i, value) { this.buffer.writeUInt16LE(value, this.offset + FRAME_STATS.BUCKET + i * 2); }
+}
+
+// streamShape in place, at(buffer, offset) moves the view without allocating
+class StreamShapeView {
+  static SIZE = 8;
+
+  constructor(buffer = null, offset = 0) {
+    this.buffer = buffer;
+    this.offset = offset;
+  }
+
+  at(buffer, offset = 0) {
+    this.buffer = buffer;
+    this.offset = offset;
+    return this;
+  }
+
+  get x() { return this.buffer[this.offset + STREAM_SHAPE.X]; }
+  set x(value) { this.buffer[this.offset + STREAM_SHAPE.X] = value; }
+  get y() { return this.buffer[this.offset + STREAM_SHAPE.Y]; }
+  set y(value) { this.buffer[this.offset + STREAM_SHAPE.Y] = value; }
+  get width() { return this.buffer[this.offset + STREAM_SHAPE.WIDTH]; }
+  set width(value) { this.buffer[this.offset + STREAM_SHAPE.WIDTH] = value; }
+  get height() { return this.buffer[this.offset + STREAM_SHAPE.HEIGHT]; }
+  set height(value) { this.buffer[this.offset + STREAM_SHAPE.HEIGHT] = value; }
+  get decimation() { return this.buffer[this.offset + STREAM_SHAPE.DECIMATION]; }
+  set decimation(value) { this.buffer[this.offset + STREAM_SHAPE.DECIMATION] = value; }
+  get rateDiv() { return this.buffer[this.offset + STREAM_SHAPE.RATE_DIV]; }
+  set rateDiv(value) { this.buffer[this.offset + STREAM_SHAPE.RATE_DIV] = value; }
+  get outWidth() { return this.buffer[this.offset + STREAM_SHAPE.OUT_WIDTH]; }
+  set outWidth(value) { this.buffer[this.offset + STREAM_SHAPE.OUT_WIDTH] = value; }
+  get outHeight() { return this.buffer[this.offset + STREAM_SHAPE.OUT_HEIGHT]; }
+  set outHeight(value) { this.buffer[this.offset + STREAM_SHAPE.OUT_HEIGHT] = value; }
+}
+
+// blobEntry in place, at(buffer, offset) moves the view without allocating
+class BlobEntryView {
+  static SIZE = 12;
+
+  constructor(buffer = null, offset = 0) {
+    this.buffer = buffer;
+    this.offset = offset;
+  }
+
+  at(buffer, offset = 0) {
+    this.buffer = buffer;
+    this.offset = offset;
+    return this;
+  }
+
+  get id() { return this.buffer[this.offset + BLOB_ENTRY.ID]; }
+  set id(value) { this.buffer[this.offset + BLOB_ENTRY.ID] = value; }
+  get flags() { return this.buffer[this.offset + BLOB_ENTRY.FLAGS]; }
+  set flags(value) { this.buffer[this.offset + BLOB_ENTRY.FLAGS] = value; }
+  get area() { return this.buffer.readUInt16LE(this.offset + BLOB_ENTRY.AREA); }
+  set area(value) { this.buffer.writeUInt16LE(value, this.offset + BLOB_ENTRY.AREA); }
+  get peak() { return this.buffer.readUInt16LE(this.offset + BLOB_ENTRY.PEAK); }
+  set peak(value) { this.buffer.writeUInt16LE(value, this.offset + BLOB_ENTRY.PEAK); }
+  get peakX() { return this.buffer[this.offset + BLOB_ENTRY.PEAK_X]; }
+  set peakX(value) { this.buffer[this.offset + BLOB_ENTRY.PEAK_X] = value; }
+  get peakY() { return this.buffer[this.offset + BLOB_ENTRY.PEAK_Y]; }
+  set peakY(value) { this.buffer[this.offset + BLOB_ENTRY.PEAK_Y] = value; }
+  get cx() { return this.buffer.readUInt16LE(this.offset + BLOB_ENTRY.CX); }
+  set cx(value) { this.buffer.writeUInt16LE(value, this.offset + BLOB_ENTRY.CX); }
+  get cy() { return this.buffer.readUInt16LE(this.offset + BLOB_ENTRY.CY); }
+  set cy(value) { this.buffer.writeUInt16LE(value, this.offset + BLOB_ENTRY.CY); }
+}
+
+// blobRecord in place, at(buffer, offset) moves the view without allocating
+class BlobRecordView {
+  static SIZE = 6;
+
+  constructor(buffer = null, offset = 0) {
+    this.buffer = buffer;
+    this.offset = offset;
+  }
+
+  at(buffer, offset = 0) {
+    this.buffer = buffer;
+    this.offset = offset;
+    return this;
+  }
+
+  get seq() { return this.buffer.readUInt32LE(this.offset + BLOB_RECORD.SEQ); }
+  set seq(value) { this.buffer.writeUInt32LE(value, this.offset + BLOB_RECORD.SEQ); }
+  get count() { return this.buffer[this.offset + BLOB_RECORD.COUNT]; }
+  set count(value) { this.buffer[this.offset + BLOB_RECORD.COUNT] = value; }
+  get flags() { return this.buffer[this.offset + BLOB_RECORD.FLAGS]; }
+  set flags(value) { this.buffer[this.offset + BLOB_RECORD.FLAGS] = value; }
+  blobs(i = 0) { return new BlobEntryView(this.buffer, this.offset + BLOB_RECORD.BLOBS + i * BLOB_ENTRY.SIZE); }
+}
+
+// streamHeader in place, at(buffer, offset) moves the view without allocating
+class StreamHeaderView {
+  static SIZE = 96;
+
+  constructor(buffer = null, offset = 0) {
+    this.buffer = buffer;
+    this.offset = offset;
+  }
+
+  at(buffer, offset = 0) {
+    this.buffer = buffer;
+    this.offset = offset;
+    return this;
+  }
+
+  get magic() { return this.buffer.readUInt32LE(this.offset + STREAM_HEADER.MAGIC); }
+  set magic(value) { this.buffer.writeUInt32LE(value, this.offset + STREAM_HEADER.MAGIC); }
+  get version() { return this.buffer[this.offset + STREAM_HEADER.VERSION]; }
+  set version(value) { this.buffer[this.offset + STREAM_HEADER.VERSION] = value; }
+  get encoding() { return this.buffer[this.offset + STREAM_HEADER.ENCODING]; }
+  set encoding(value) { this.buffer[this.offset + STREAM_HEADER.ENCODING] = value; }
+  get headerLen() { return this.buffer.readUInt16LE(this.offset + STREAM_HEADER.HEADER_LEN); }
+  set headerLen(value) { this.buffer.writeUInt16LE(value, this.offset + STREAM_HEADER.HEADER_LEN); }
+  get seq() { return this.buffer.readUInt32LE(this.offset + STREAM_HEADER.SEQ); }
+  set seq(value) { this.buffer.writeUInt32LE(value, this.offset + STREAM_HEADER.SEQ); }
+  get timestampUs() { return this.buffer.readBigUInt64LE(this.offset + STREAM_HEADER.TIMESTAMP_US); }
+  set timestampUs(value) { this.buffer.writeBigUInt64LE(BigInt(value), this.offset + STREAM_HEADER.TIMESTAMP_US); }
+  get payloadLen() { return this.buffer.readUInt32LE(this.offset + STREAM_HEADER.PAYLOAD_LEN); }
+  set payloadLen(value) { this.buffer.writeUInt32LE(value, this.offset + STREAM_HEADER.PAYLOAD_LEN); }
+  get flags() { return this.buffer[this.offset + STREAM_HEADER.FLAGS]; }
+  set flags(value) { this.buffer[this.offset + STREAM_HEADER.FLAGS] = value; }
+  reserved(i) { return this.buffer[this.offset + STREAM_HEADER.RESERVED + i]; }
+  setReserved(i, value) { this.buffer[this.offset + STREAM_HEADER.RESERVED + i] = value; }
+  get stats() { return new FrameStatsView(this.buffer, this.offset + STREAM_HEADER.STATS); }
+  get payloadCrc() { return this.buffer.readUInt32LE(this.offset + STREAM_HEADER.PAYLOAD_CRC); }
+  set payloadCrc(value) { this.buffer.writeUInt32LE(value, this.offset + STREAM_HEADER.PAYLOAD_CRC); }
+  get shape() { return new StreamShapeView(this.buffer, this.offset + STREAM_HEADER.SHAPE); }
+  get utcUs() { return this.buffer.readBigUInt64LE(this.offset + STREAM_HEADER.UTC_US); }
+  set utcUs(value) { this.buffer.writeBigUInt64LE(BigInt(value), this.offset + STREAM_HEADER.UTC_US); }
+  blobs(i = 0) { return new BlobRecordView(this.buffer, this.offset + STREAM_HEADER.BLOBS + i * BLOB_RECORD.SIZE); }
+}
+
+// udpChunkHeader in place, at(buffer, offset) moves the view without allocating
+class UdpChunkHeaderView {
+  static SIZE = 16;
+
+  constructor(buffer = null, offset = 0) {
+    this.buffer = buffer;
+    this.offset = offset;
+  }
+
+  at(buffer, offset = 0) {
+    this.buffer = buffer;
+    this.offset = offset;
+    return this;
+  }
+
+  get magic() { return this.buffer.readUInt32LE(this.offset + UDP_CHUNK_HEADER.MAGIC); }
+  set magic(value) { this.buffer.writeUInt32LE(value, this.offset + UDP_CHUNK_HEADER.MAGIC); }
+  get frameId() { return this.buffer.readUInt32LE(this.offset + UDP_CHUNK_HEADER.FRAME_ID); }
+  set frameId(value) { this.buffer.writeUInt32LE(value, this.offset + UDP_CHUNK_HEADER.FRAME_ID); }
+  get chunkIdx() { return this.buffer.readUInt16LE(this.offset + UDP_CHUNK_HEADER.CHUNK_IDX); }
+  set chunkIdx(value) { this.buffer.writeUInt16LE(value, this.offset + UDP_CHUNK_HEADER.CHUNK_IDX); }
+  get chunkCount() { return this.buffer.readUInt16LE(this.offset + UDP_CHUNK_HEADER.CHUNK_COUNT); }
+  set chunkCount(value) { this.buffer.writeUInt16LE(value, this.offset + UDP_CHUNK_HEADER.CHUNK_COUNT); }
+  get frameLen() { return this.buffer.readUInt32LE(this.offset + UDP_CHUNK_HEADER.FRAME_LEN); }
+  set frameLen(value) { this.buffer.writeUInt32LE(value, this.offset + UDP_CHUNK_HEADER.FRAME_LEN); }
+}
+
+// mqttBatchHeader in place, at(buffer, offset) moves the view without allocating
+class MqttBatchHeaderView {
+  static SIZE = 20;
+
+  constructor(buffer = null, offset = 0) {
+    this.buffer = buffer;
+    this.offset = offset;
+  }
+
+  at(buffer, offset = 0) {
+    this.buffer = buffer;
+    this.offset = offset;
+    return this;
+  }
+
+  get version() { return this.buffer[this.offset + MQTT_BATCH_HEADER.VERSION]; }
+  set version(value) { this.buffer[this.offset + MQTT_BATCH_HEADER.VERSION] = value; }
+  get samples() { return this.buffer[this.offset + MQTT_BATCH_HEADER.SAMPLES]; }
+  set samples(value) { this.buffer[this.offset + MQTT_BATCH_HEADER.SAMPLES] = value; }
+  get periodMs() { return this.buffer.readUInt16LE(this.offset + MQTT_BATCH_HEADER.PERIOD_MS); }
+  set periodMs(value) { this.buffer.writeUInt16LE(value, this.offset + MQTT_BATCH_HEADER.PERIOD_MS); }
+  get uptimeMs() { return this.buffer.readUInt32LE(this.offset + MQTT_BATCH_HEADER.UPTIME_MS); }
+  set uptimeMs(value) { this.buffer.writeUInt32LE(value, this.offset + MQTT_BATCH_HEADER.UPTIME_MS); }
+  get seq() { return this.buffer.readUInt32LE(this.offset + MQTT_BATCH_HEADER.SEQ); }
+  set seq(value) { this.buffer.writeUInt32LE(value, this.offset + MQTT_BATCH_HEADER.SEQ); }
+  get utcMs() { return this.buffer.readBigUInt64LE(this.offset + MQTT_BATCH_HEADER.UTC_MS); }
+  set utcMs(value) { this.buffer.writeBigUInt64LE(BigInt(value), this.offset + MQTT_BATCH_HEADER.UTC_MS); }
+}
+
+// mqttSample in place, at(buffer, offset) moves the view without allocating
+class MqttSampleView {
+  static SIZE = 3;
+
+  constructor(buffer = null, offset = 0) {
+    this.buffer = buffer;
+    this.offset = offset;
+  }
+
+  at(buffer, offset = 0) {
+    this.buffer = buffer;
+    this.offset = offset;
+    return this;
+  }
+
+  get offsetMs() { return this.buffer.readUInt16LE(this.offset + MQTT_SAMPLE.OFFSET_MS); }
+  set offsetMs(value) { this.buffer.writeUInt16LE(value, this.offset + MQTT_SAMPLE.OFFSET_MS); }
+  get count() { return this.buffer[this.offset + MQTT_SAMPLE.COUNT]; }
+  set count(value) { this.buffer[this.offset + MQTT_SAMPLE.COUNT] = value; }
+}
+
+// mqttRoiEntry in place, at(buffer, offset) moves the view without allocating
+class MqttRoiEntryView {
+  static SIZE = 9;
+
+  constructor(buffer = null, offset = 0) {
+    this.buffer = buffer;
+    this.offset = offset;
+  }
+
+  at(buffer, offset = 0) {
+    this.buffer = buffer;
+    this.offset = offset;
+    return this;
+  }
+
+  get roi() { return this.buffer[this.offset + MQTT_ROI_ENTRY.ROI]; }
+  set roi(value) { this.buffer[this.offset + MQTT_ROI_ENTRY.ROI] = value; }
+  get min() { return this.buffer.readUInt16LE(this.offset + MQTT_ROI_ENTRY.MIN); }
+  set min(value) { this.buffer.writeUInt16LE(value, this.offset + MQTT_ROI_ENTRY.MIN); }
+  get max() { return this.buffer.readUInt16LE(this.offset + MQTT_ROI_ENTRY.MAX); }
+  set max(value) { this.buffer.writeUInt16LE(value, this.offset + MQTT_ROI_ENTRY.MAX); }
+  get mean() { return this.buffer.readUInt16LE(this.offset + MQTT_ROI_ENTRY.MEAN); }
+  set mean(value) { this.buffer.writeUInt16LE(value, this.offset + MQTT_ROI_ENTRY.MEAN); }
+  get percentile() { return this.buffer.readUInt16LE(this.offset + MQTT_ROI_ENTRY.PERCENTILE); }
+  set percentile(value) { this.buffer.writeUInt16LE(value, this.offset + MQTT_ROI_ENTRY.PERCENTILE); }
+}
+
+// mqttEventEntry in place, at(buffer, offset) moves the view without allocating
+class MqttEventEntryView {
+  static SIZE = 9;
+
+  constructor(buffer = null, offset = 0) {
+    this.buffer = buffer;
+    this.offset = offset;
+  }
+
+  at(buffer, offset = 0) {
+    this.buffer = buffer;
+    this.offset = offset;
+    return this;
+  }
+
+  get rule() { return this.buffer[this.offset + MQTT_EVENT_ENTRY.RULE]; }
+  set rule(value) { this.buffer[this.offset + MQTT_EVENT_ENTRY.RULE] = value; }
+  get raised() { return this.buffer[this.offset + MQTT_EVENT_ENTRY.RAISED]; }
+  set raised(value) { this.buffer[this.offset + MQTT_EVENT_ENTRY.RAISED] = value; }
+  get value() { return this.buffer.readUInt16LE(this.offset + MQTT_EVENT_ENTRY.VALUE); }
+  set value(value) { this.buffer.writeUInt16LE(value, this.offset + MQTT_EVENT_ENTRY.VALUE); }
+  get active() { return this.buffer[this.offset + MQTT_EVENT_ENTRY.ACTIVE]; }
+  set active(value) { this.buffer[this.offset + MQTT_EVENT_ENTRY.ACTIVE] = value; }
+  get seq() { return this.buffer.readUInt32LE(this.offset + MQTT_EVENT_ENTRY.SEQ); }
+  set seq(value) { this.buffer.writeUInt32LE(value, this.offset + MQTT_EVENT_ENTRY.SEQ); }
+}
+
+module.exports = {
+  STREAM_MAGIC, UDP_CHUNK_MAGIC, UDP_HELLO_MAGIC, UDP_BYE_MAGIC,
+  STREAM_ENCODING_RAW16, STREAM_ENCODING_DELTA, STREAM_ENCODING_DELTA_LZ, STREAM_ENCODING_PACK12,
+  STREAM_ENCODING_PACK14, STREAM_ENCODING_PACK8, STREAM_FLAG_KEYFRAME, STREAM_FLAG_STATS,
+  STREAM_FLAG_CRC32, STREAM_FLAG_SHAPED, STREAM_FLAG_BLOBS, STREAM_FLAG_UTC,
+  CMD_WREG, CMD_RREG, CMD_RRSE, CMD_BRWR,
+  CMD_WSID, CMD_WPWD, CMD_WMDE, CMD_POLL,
+  CMD_STAT, CMD_SFMT, CMD_SHAP, CMD_SCRC,
+  CMD_CAPS, CMD_LATS, CMD_ROIW, CMD_ROIR,
+  CMD_SUBS, CMD_SUBV, CMD_RECC, CMD_RECD,
+  CMD_SAVE, CMD_BPIX, CMD_BNCH, CMD_SYST,
+  CMD_BLOB, CMD_RULE, CMD_ALRM, CMD_ESPN,
+  CMD_CORR, PACKET_PREFIX, PACKET_LEN, PACKET_LEN_DIGITS,
+  PACKET_CMD, PACKET_DATA, PACKET_SUM_DIGITS, PACKET_MIN_LEN,
+  PACKET_MAX_LEN, PACKET_NO_SUM, hexValue, writeHex,
+  packetSum, encodePacket, buildPacket, findPacket,
+  decodePacket, FRAME_STATS, STREAM_SHAPE, BLOB_ENTRY,
+  BLOB_RECORD, STREAM_HEADER, UDP_CHUNK_HEADER, MQTT_BATCH_HEADER,
+  MQTT_SAMPLE, MQTT_ROI_ENTRY, MQTT_EVENT_ENTRY, FrameStatsView,
+  StreamShapeView, BlobEntryView, BlobRecordView, StreamHeaderView,
+  UdpChunkHeaderView, MqttBatchHeaderView, MqttSampleView, MqttRoiEntryView,
+  MqttEventEntryView,
+};
@@ -0,0 +1,108 @@
+// Checks the packet codec and layout views of protocol.js against the vectors
+// genProtocol.js writes from protocolSchema.json, the ones the firmware host
+// test (test_protocol) and the Swift client are checked against, then times
+// the codec. Run with "npm test".
+
+const assert = require("node:assert/strict");
+const fs = require("fs");
+const protocol = require("./protocol");
+const { SCHEMA_JSON, VECTORS, parseLayouts } = require("./genProtocol");
+
+const TIMED_RUNS = 1000000;
+const LAYOUTS = parseLayouts(JSON.parse(fs.readFileSync(SCHEMA_JSON, "utf8")).layouts);
+
+const fromHex = text => text === "-" ? Buffer.alloc(0) : Buffer.from(text, "hex");
+const pascal = name => name[0].toUpperCase() + name.slice(1);
+
+function checkPacket([command, sum, dataHex, packetHex]) {
+  const data = fromHex(dataHex);
+  const bytes = fromHex(packetHex);
+  const code = Buffer.from(command, "ascii").readUInt32BE(0);
+  const packet = {};
+
+  for (let len = 0; len < bytes.length; len++) {
+    assert.equal(protocol.decodePacket(bytes.subarray(0, len), 0, packet), 0, `${command}: ${len} bytes not incomplete`);
+  }
+  assert.equal(protocol.decodePacket(bytes, 0, packet), bytes.length, `${command}: not decoded`);
+  assert.equal(packet.command, code);
+  assert.deepEqual(bytes.subarray(packet.dataStart, packet.dataEnd), data, `${command}: data differs`);
+  assert.equal(packet.sumSent, sum !== "0", `${command}: checksum sent`);
+  assert.equal(packet.sumValid, sum !== "2", `${command}: checksum valid`);
+
+  if (sum !== "2") {
+    assert.deepEqual(protocol.buildPacket(code, data, sum === "1"), bytes, `${command}: encoded packet differs`);
+    if (data.every(b => b >= 0x20 && b < 0x7F)) {
+      assert.deepEqual(protocol.buildPacket(code, data.toString("latin1"), sum === "1"), bytes, `${command}: encoded string differs`);
+    }
+  }
+
+  const shifted = Buffer.concat([Buffer.from("#  ", "ascii"), bytes]);
+  assert.equal(protocol.findPacket(shifted), 3, `${command}: not found behind garbage`);
+  assert.equal(protocol.decodePacket(shifted, 0, packet), -1, `${command}: garbage decoded`);
+}
+
+function checkLayout([name, hex, ...values]) {
+  const View = protocol[`${pascal(name)}View`];
+  assert.ok(View, `${name}: no view`);
+  const bytes = fromHex(hex);
+  assert.equal(bytes.length, View.SIZE, `${name}: size`);
+
+  // Each scalar field and array element in schema order, set again into zeros
+  const encoded = Buffer.alloc(View.SIZE);
+  const view = new View(bytes);
+  const out = new View(encoded);
+  const value = (f, text) => f.elem === "u64" ? BigInt(text) : Number(text);
+  let k = 0;
+  for (const f of LAYOUTS[name].fields) {
+    if (f.kind === "scalar") {
+      assert.equal(view[f.name], value(f, values[k]), `${name}.${f.name}`);
+      out[f.name] = value(f, values[k++]);
+    } else if (f.kind === "array") {
+      for (let i = 0; i < f.count; i++) {
+        assert.equal(view[f.name](i), value(f, values[k]), `${name}.${f.name}(${i})`);
+        out[`set${pascal(f.name)}`](i, value(f, values[k++]));
+      }
+    }
+  }
+  assert.equal(k, values.length, `${name}: ${values.length} values, ${k} fields`);
+  assert.deepEqual(encoded, bytes, `${name}: encoded layout differs`);
+}
+
+function time(name, unit, run) {
+  const start = process.hrtime.bigint();
+  let sink = 0;
+  for (let i = 0; i < TIMED_RUNS; i++) sink += run(i);
+  const ns = Number(process.hrtime.bigint() - start) / TIMED_RUNS;
+  console.log(`${name.padEnd(30)} ${ns.toFixed(0).padStart(8)} ns/${unit}`);
+  return sink;
+}
+
+function throughput() {
+  const data = Buffer.from("C0C1C2C30BB8C40FA0", "ascii");
+  const buffer = Buffer.alloc(protocol.PACKET_DATA + data.length + protocol.PACKET_SUM_DIGITS);
+  const packet = {};
+  const header = new protocol.StreamHeaderView(Buffer.alloc(protocol.StreamHeaderView.SIZE));
+
+  time("encodePacket", "packet", () => {
+    data.copy(buffer, protocol.PACKET_DATA);
+    return protocol.encodePacket(buffer, 0, protocol.CMD_RRSE, data.length, true);
+  });
+  time("decodePacket", "packet", () => protocol.decodePacket(buffer, 0, packet) + (packet.sumValid ? 1 : 0));
+  time("StreamHeaderView set + get", "header", (i) => {
+    header.seq = i;
+    header.payloadLen = i & 0x3FFF;
+    return header.seq + header.payloadLen;
+  });
+}
+
+let vectors = 0;
+for (const line of fs.readFileSync(VECTORS, "utf8").split("\n")) {
+  const [kind, ...fields] = line.trim().split(/\s+/);
+  if (kind === "packet") checkPacket(fields);
+  else if (kind === "layout") checkLayout(fields);
+  else continue;
+  vectors++;
+}
+assert.ok(vectors > 0, `No vectors in ${VECTORS}`);
+console.log(`${vectors} vectors, 0 failures`);
+throughput();
@@ -0,0 +1,74 @@
+// Generated by genProtocol.js from regMap.h, do not edit.
+
+const REGISTERS = [
+  { address: 0xB0, name: "Control", digits: 2, writable: true, nvsKey: null },
+  { address: 0xB1, name: "Capture", digits: 2, writable: true, nvsKey: null },
+  { address: 0xB2, name: "VersionHigh", digits: 2, writable: false, nvsKey: null },
+  { address: 0xB3, name: "VersionLow", digits: 2, writable: false, nvsKey: null },
+  { address: 0xC0, name: "Xsplit", digits: 4, writable: true, nvsKey: "quadcfg" },
+  { address: 0xC1, name: "Ysplit", digits: 4, writable: true, nvsKey: "quadcfg" },
+  { address: 0xC2, name: "Amax", digits: 4, writable: false, nvsKey: null },
+  { address: 0xC3, name: "Acenter", digits: 4, writable: false, nvsKey: null },
+  { address: 0xC4, name: "Bmax", digits: 4, writable: false, nvsKey: null },
+  { address: 0xC5, name: "Bcenter", digits: 4, writable: false, nvsKey: null },
+  { address: 0xC6, name: "Cmax", digits: 4, writable: false, nvsKey: null },
+  { address: 0xC7, name: "Ccenter", digits: 4, writable: false, nvsKey: null },
+  { address: 0xC8, name: "Dmax", digits: 4, writable: false, nvsKey: null },
+  { address: 0xC9, name: "Dcenter", digits: 4, writable: false, nvsKey: null },
+  { address: 0xCA, name: "Aburnerx", digits: 4, writable: true, nvsKey: "quadcfg" },
+  { address: 0xCB, name: "Aburnery", digits: 4, writable: true, nvsKey: "quadcfg" },
+  { address: 0xCC, name: "Aburnert", digits: 4, writable: false, nvsKey: null },
+  { address: 0xCD, name: "Bburnerx", digits: 4, writable: true, nvsKey: "quadcfg" },
+  { address: 0xCE, name: "Bburnery", digits: 4, writable: true, nvsKey: "quadcfg" },
+  { address: 0xCF, name: "Bburnert", digits: 4, writable: false, nvsKey: null },
+  { address: 0xD0, name: "Cburnerx", digits: 4, writable: true, nvsKey: "quadcfg" },
+  { address: 0xD1, name: "Cburnery", digits: 4, writable: true, nvsKey: "quadcfg" },
+  { address: 0xD2, name: "Cburnert", digits: 4, writable: false, nvsKey: null },
+  { address: 0xD3, name: "Dburnerx", digits: 4, writable: true, nvsKey: "quadcfg" },
+  { address: 0xD4, name: "Dburnery", digits: 4, writable: true, nvsKey: "quadcfg" },
+  { address: 0xD5, name: "Dburnert", digits: 4, writable: false, nvsKey: null },
+  { address: 0xD6, name: "TfiltMode", digits: 4, writable: true, nvsKey: null },
+  { address: 0xD7, name: "TfiltAlpha", digits: 4, writable: true, nvsKey: null },
+  { address: 0xD8, name: "TfiltFrames", digits: 4, writable: true, nvsKey: null },
+  { address: 0xD9, name: "ChgMode", digits: 4, writable: true, nvsKey: null },
+  { address: 0xDA, name: "ChgDelta", digits: 4, writable: true, nvsKey: null },
+  { address: 0xDB, name: "ChgPixels", digits: 4, writable: true, nvsKey: null },
+  { address: 0xDC, name: "ChgHeartbeat", digits: 4, writable: true, nvsKey: null },
+  { address: 0xDD, name: "ChgCount", digits: 4, writable: false, nvsKey: null },
+  { address: 0xDE, name: "ChgBoxMin", digits: 4, writable: false, nvsKey: null },
+  { address: 0xDF, name: "ChgBoxMax", digits: 4, writable: false, nvsKey: null },
+  { address: 0xE0, name: "DevID0", digits: 2, writable: false, nvsKey: null },
+  { address: 0xE1, name: "DevID1", digits: 2, writable: false, nvsKey: null },
+  { address: 0xE2, name: "DevID2", digits: 2, writable: false, nvsKey: null },
+  { address: 0xE3, name: "DevID3", digits: 2, writable: false, nvsKey: null },
+  { address: 0xE4, name: "DevID4", digits: 2, writable: false, nvsKey: null },
+  { address: 0xE5, name: "DevID5", digits: 2, writable: false, nvsKey: null },
+  { address: 0xE8, name: "RoiCount", digits: 4, writable: false, nvsKey: null },
+  { address: 0xE9, name: "RoiSel", digits: 4, writable: true, nvsKey: null },
+  { address: 0xEA, name: "RoiMin", digits: 4, writable: false, nvsKey: null },
+  { address: 0xEB, name: "RoiMax", digits: 4, writable: false, nvsKey: null },
+  { address: 0xEC, name: "RoiMean", digits: 4, writable: false, nvsKey: null },
+  { address: 0xED, name: "RoiPct", digits: 4, writable: false, nvsKey: null },
+  { address: 0xEE, name: "RoiHotX", digits: 4, writable: false, nvsKey: null },
+  { address: 0xEF, name: "RoiHotY", digits: 4, writable: false, nvsKey: null },
+  { address: 0xF0, name: "RoiPixels", digits: 4, writable: false, nvsKey: null },
+  { address: 0xF1, name: "FrameMin", digits: 4, writable: false, nvsKey: null },
+  { address: 0xF2, name: "FrameMax", digits: 4, writable: false, nvsKey: null },
+  { address: 0xF3, name: "FrameMean", digits: 4, writable: false, nvsKey: null },
+  { address: 0xF4, name: "FrameP50", digits: 4, writable: false, nvsKey: null },
+  { address: 0xF5, name: "FrameP95", digits: 4, writable: false, nvsKey: null },
+  { address: 0xF6, name: "FrameP99", digits: 4, writable: false, nvsKey: null },
+  { address: 0xF7, name: "RuleActive", digits: 4, writable: false, nvsKey: null },
+  { address: 0xF8, name: "ClsRate", digits: 4, writable: true, nvsKey: null },
+  { address: 0xF9, name: "ClsRoi", digits: 4, writable: true, nvsKey: null },
+  { address: 0xFA, name: "ClsClass", digits: 4, writable: false, nvsKey: null },
+  { address: 0xFB, name: "ClsFlame", digits: 4, writable: false, nvsKey: null },
+  { address: 0xFC, name: "ClsPan", digits: 4, writable: false, nvsKey: null },
+  { address: 0xFD, name: "ClsLatency", digits: 4, writable: false, nvsKey: null },
+];
+
+// Hex digits of each register value in RREG and RRSE replies, by address
+const REGISTER_DIGITS = new Uint8Array(256).fill(2);
+for (const r of REGISTERS) REGISTER_DIGITS[r.address] = r.digits;
+
+module.exports = { REGISTERS, REGISTER_DIGITS };
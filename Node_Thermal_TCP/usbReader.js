@@ -0,0 +1,192 @@
+// Reader of the USB vendor bulk frame stream (see protocol.md), for lab rigs
+// with several cameras on one host. Needs the "usb" package, which is not a
+// dependency of the bridge: npm install usb
+//
+// Run on its own it is a benchmark: node usbReader.js [seconds] prints the
+// frame rate, throughput, gaps and CRC errors of every camera it finds.
+
+const EventEmitter = require("events");
+const zlib = require("zlib");
+const { StreamBuffer, parseStreamHeader, STREAM_MAGIC } = require("./device");
+
+const USB_VID = 0x0416;
+const USB_PID = 0xb002;
+const VENDOR_CLASS = 0xff;
+const HELLO = Buffer.from("SXHI", "ascii");
+const BYE = Buffer.from("SXBY", "ascii");
+const HELLO_MS = 1000;           // The device drops a reader that goes quiet
+const TRANSFER_SIZE = 16384;     // Large reads, ended early by a short packet
+const TRANSFERS = 4;             // Reads kept in flight
+const STREAM_SIZE = 65536;
+const STREAM_HEADER_MIN_SIZE = 28;
+const STREAM_FLAG_CRC32 = 0x04;
+const STREAM_CRC_OFFSET = 76;
+
+function loadUsb() {
+  try {
+    return require("usb");
+  } catch (err) {
+    throw new Error("usbReader needs the usb package: npm install usb");
+  }
+}
+
+class UsbReader extends EventEmitter {
+  constructor(device) {
+    super();
+    this.device = device;
+    this.name = `${device.busNumber}-${device.deviceAddress}`;
+    this.stream = new StreamBuffer(STREAM_SIZE);
+    this.iface = null;
+    this.inEp = null;
+    this.outEp = null;
+    this.helloTimer = null;
+    this.lastSequence = null;
+    this.frames = 0;
+    this.bytes = 0;
+    this.droppedFrames = 0;
+    this.resyncCount = 0;
+    this.crcErrors = 0;
+  }
+
+  // Every camera on the bus, not opened yet
+  static list() {
+    const usb = loadUsb();
+    return usb.getDeviceList()
+      .filter(d => d.deviceDescriptor.idVendor === USB_VID && d.deviceDescriptor.idProduct === USB_PID)
+      .map(d => new UsbReader(d));
+  }
+
+  start() {
+    this.device.open();
+    this.iface = this.device.interfaces.find(i => i.descriptor.bInterfaceClass === VENDOR_CLASS);
+    if (!this.iface) {
+      this.device.close();
+      throw new Error(`${this.name}: no vendor interface, firmware built without CONFIG_MI_USB_VENDOR_EN?`);
+    }
+    this.iface.claim();
+    this.inEp = this.iface.endpoints.find(e => e.direction === "in");
+    this.outEp = this.iface.endpoints.find(e => e.direction === "out");
+
+    this.inEp.on("data", (data) => this.onData(data));
+    this.inEp.on("error", (err) => this.emit("error", err));
+    this.inEp.startPoll(TRANSFERS, TRANSFER_SIZE);
+
+    this.sendHello();
+    this.helloTimer = setInterval(() => this.sendHello(), HELLO_MS);
+  }
+
+  stop(callback) {
+    clearInterval(this.helloTimer);
+    this.outEp.transfer(BYE, () => {
+      this.inEp.stopPoll(() => {
+        this.iface.release(true, () => {
+          this.device.close();
+          if (callback) callback();
+        });
+      });
+    });
+  }
+
+  sendHello() {
+    this.outEp.transfer(HELLO, (err) => {
+      if (err) this.emit("error", err);
+    });
+  }
+
+  onData(data) {
+    this.bytes += data.length;
+    if (this.stream.append(data)) this.resyncCount++;
+    this.stream.consume(this.parseFrames(this.stream.view()));
+  }
+
+  // Same framing as port 3333 in the v2 format, returns the bytes consumed
+  parseFrames(buffer) {
+    let pos = 0;
+
+    while (buffer.length - pos >= STREAM_HEADER_MIN_SIZE) {
+      const header = parseStreamHeader(buffer, pos);
+      if (!header) {
+        const next = buffer.indexOf(STREAM_MAGIC, pos + 1);
+        pos = next !== -1 ? next : Math.max(pos + 1, buffer.length - (STREAM_MAGIC.length - 1));
+        this.resyncCount++;
+        continue;
+      }
+
+      const total = header.headerLength + header.payloadLength;
+      if (buffer.length - pos < total) break;
+
+      // A frame the device cut short runs into the next header
+      const next = buffer.indexOf(STREAM_MAGIC, pos + 4);
+      if (next !== -1 && next < pos + total && parseStreamHeader(buffer, next)) {
+        pos = next;
+        this.resyncCount++;
+        continue;
+      }
+
+      const payload = buffer.subarray(pos + header.headerLength, pos + total);
+      if ((header.flags & STREAM_FLAG_CRC32) && zlib.crc32 &&
+          zlib.crc32(payload) !== buffer.readUInt32LE(pos + STREAM_CRC_OFFSET)) {
+        this.crcErrors++;
+      }
+      pos += total;
+
+      if (this.lastSequence !== null && ((header.sequence - this.lastSequence) >>> 0) > 1) {
+        this.droppedFrames += ((header.sequence - this.lastSequence) >>> 0) - 1;
+      }
+      this.lastSequence = header.sequence;
+      this.frames++;
+      this.emit("frame", header.sequence, payload, header); // payload is only valid in this call
+    }
+    return pos;
+  }
+
+  // Counters since the last call
+  metrics() {
+    const m = {
+      name: this.name,
+      frames: this.frames,
+      bytes: this.bytes,
+      droppedFrames: this.droppedFrames,
+      resyncs: this.resyncCount,
+      crcErrors: this.crcErrors
+    };
+    this.frames = 0;
+    this.bytes = 0;
+    this.droppedFrames = 0;
+    this.resyncCount = 0;
+    this.crcErrors = 0;
+    return m;
+  }
+}
+
+if (require.main === module) {
+  const seconds = Number(process.argv[2]) || 10;
+  const readers = UsbReader.list();
+  if (readers.length === 0) {
+    console.error("No camera found");
+    process.exit(1);
+  }
+
+  readers.forEach(r => {
+    r.on("error", (err) => console.error(`${r.name}: ${err.message}`));
+    r.start();
+  });
+  console.log(`Reading ${readers.length} camera(s) for ${seconds} s`);
+
+  const started = Date.now();
+  const timer = setInterval(() => {
+    const elapsed = (Date.now() - started) / 1000;
+    readers.forEach(r => {
+      const m = r.metrics();
+      console.log(`${m.name}: ${m.frames} fps, ${(m.bytes / 1024).toFixed(0)} kB/s, ` +
+        `${m.droppedFrames} gaps, ${m.resyncs} resyncs, ${m.crcErrors} CRC errors`);
+    });
+    if (elapsed >= seconds) {
+      clearInterval(timer);
+      let left = readers.length;
+      readers.forEach(r => r.stop(() => { if (--left === 0) process.exit(0); }));
+    }
+  }, 1000);
+}
+
+module.exports = { UsbReader };
@@ -14,18 +14,55 @@ class QuadrantData {
     var dMax: UInt16 = 0
     var dCenter: UInt16 = 0
 
-    /// Update from RRSE response
-    func update(from registerValues: [UInt8: UInt16]) {
-        if let val = registerValues[ThermalProtocol.regXSplit] { xSplit = Int(val) }
-        if let val = registerValues[ThermalProtocol.regYSplit] { ySplit = Int(val) }
-        if let val = registerValues[ThermalProtocol.regAMax] { aMax = val }
-        if let val = registerValues[ThermalProtocol.regACenter] { aCenter = val }
-        if let val = registerValues[ThermalProtocol.regBMax] { bMax = val }
-        if let val = registerValues[ThermalProtocol.regBCenter] { bCenter = val }
-        if let val = registerValues[ThermalProtocol.regCMax] { cMax = val }
-        if let val = registerValues[ThermalProtocol.regCCenter] { cCenter = val }
-        if let val = registerValues[ThermalProtocol.regDMax] { dMax = val }
-        if let val = registerValues[ThermalProtocol.regDCenter] { dCenter = val }
+    /// Apply the registers of one response. Only fields whose value changed are
+    /// assigned, so SwiftUI invalidates only the views that read them.
+    func apply(_ registers: QuadrantRegisters) {
+        if let val = registers[ThermalProtocol.regXSplit] { assign(\.xSplit, Int(val)) }
+        if let val = registers[ThermalProtocol.regYSplit] { assign(\.ySplit, Int(val)) }
+        if let val = registers[ThermalProtocol.regAMax] { assign(\.aMax, val) }
+        if let val = registers[ThermalProtocol.regACenter] { assign(\.aCenter, val) }
+        if let val = registers[ThermalProtocol.regBMax] { assign(\.bMax, val) }
+        if let val = registers[ThermalProtocol.regBCenter] { assign(\.bCenter, val) }
+        if let val = registers[ThermalProtocol.regCMax] { assign(\.cMax, val) }
+        if let val = registers[ThermalProtocol.regCCenter] { assign(\.cCenter, val) }
+        if let val = registers[ThermalProtocol.regDMax] { assign(\.dMax, val) }
+        if let val = registers[ThermalProtocol.regDCenter] { assign(\.dCenter, val) }
+    }
+
+    /// An @Observable setter notifies even when the value is unchanged
+    private func assign<Value: Equatable>(_ keyPath: ReferenceWritableKeyPath<QuadrantData, Value>, _ value: Value) {
+        if self[keyPath: keyPath] != value {
+            self[keyPath: keyPath] = value
+        }
+    }
+}
+
+/// Quadrant registers 0xC0-0xC9 decoded from one RRSE, SUBV or BRWR packet.
+/// Fixed storage with a bit per register present, so decoding allocates nothing.
+struct QuadrantRegisters {
+    private var values: (UInt16, UInt16, UInt16, UInt16, UInt16, UInt16, UInt16, UInt16, UInt16, UInt16) =
+        (0, 0, 0, 0, 0, 0, 0, 0, 0, 0)
+    private(set) var present: UInt16 = 0
+
+    var isEmpty: Bool { present == 0 }
+
+    /// Value of the register, nil if the packet did not carry it.
+    /// Setting a register outside the quadrant block is ignored.
+    subscript(address: UInt8) -> UInt16? {
+        get {
+            guard let index = Self.index(of: address), present & (1 << index) != 0 else { return nil }
+            return withUnsafeBytes(of: values) { $0.load(fromByteOffset: index * 2, as: UInt16.self) }
+        }
+        set {
+            guard let index = Self.index(of: address), let newValue = newValue else { return }
+            withUnsafeMutableBytes(of: &values) { $0.storeBytes(of: newValue, toByteOffset: index * 2, as: UInt16.self) }
+            present |= 1 << index
+        }
+    }
+
+    private static func index(of address: UInt8) -> Int? {
+        let index = Int(address) - Int(ThermalProtocol.regXSplit)
+        return index >= 0 && index < ThermalProtocol.quadrantRegisters.count ? index : nil
     }
 }
 
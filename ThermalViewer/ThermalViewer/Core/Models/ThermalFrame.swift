@@ -1,4 +1,5 @@
 import Foundation
+import Accelerate
 
 struct ThermalFrame {
     let width: Int
@@ -11,6 +12,10 @@ struct ThermalFrame {
     let headerMin: UInt16
     let headerMax: UInt16
 
+    // Set from the v2 stream header, nil for raw frames
+    var sequence: UInt32?
+    var captureTimestampUs: UInt64?
+
     /// Initialize from raw TCP frame data (10,240 bytes = 80x64 pixels)
     init?(data: Data) {
         guard data.count >= ThermalProtocol.tcpFrameSize else { return nil }
@@ -40,8 +45,50 @@ struct ThermalFrame {
         }
 
         // Calculate actual min/max from image pixels
-        self.minValue = pixels.min() ?? 0
-        self.maxValue = pixels.max() ?? 65535
+        (self.minValue, self.maxValue) = ThermalFrame.valueRange(of: pixels)
+    }
+
+    /// Initialize from an 80x62 image without header rows, as rebuilt from the BLE frame stream
+    init?(image: [UInt16], sequence: UInt32? = nil) {
+        guard image.count == ThermalProtocol.frameWidth * ThermalProtocol.imageHeight else { return nil }
+
+        self.width = ThermalProtocol.frameWidth
+        self.height = ThermalProtocol.imageHeight
+        self.pixels = image
+        (self.minValue, self.maxValue) = ThermalFrame.valueRange(of: image)
+        self.frameNumber = UInt16(truncatingIfNeeded: sequence ?? 0)
+        self.dieTemperature = 0
+        self.headerMax = maxValue
+        self.headerMin = minValue
+        self.sequence = sequence
+    }
+
+    /// Initialize from the header row of a raw frame and its 80x62 image.
+    /// The image comes from a PixelBufferPool, so no pixel array is allocated per frame.
+    init(headerRow: UnsafeRawBufferPointer, image: [UInt16]) {
+        func word(_ index: Int) -> UInt16 {
+            headerRow.count >= (index + 1) * 2 ? headerRow.loadUnaligned(fromByteOffset: index * 2, as: UInt16.self) : 0
+        }
+
+        self.width = ThermalProtocol.frameWidth
+        self.height = ThermalProtocol.imageHeight
+        self.frameNumber = word(0)
+        self.dieTemperature = word(2)
+        self.headerMax = word(5)
+        self.headerMin = word(6)
+        self.pixels = image
+        (self.minValue, self.maxValue) = ThermalFrame.valueRange(of: image)
+    }
+
+    /// Min and max of an image with vDSP, through a stack buffer so nothing is allocated
+    static func valueRange(of image: [UInt16]) -> (min: UInt16, max: UInt16) {
+        guard !image.isEmpty else { return (0, 65535) }
+
+        return withUnsafeTemporaryAllocation(of: Float.self, capacity: image.count) { buffer in
+            var values = buffer
+            image.withUnsafeBufferPointer { vDSP.convertElements(of: $0, to: &values) }
+            return (UInt16(vDSP.minimum(values)), UInt16(vDSP.maximum(values)))
+        }
     }
 
     /// Get pixel value at (x, y) coordinate
@@ -61,3 +108,24 @@ struct ThermalFrame {
         return celsius * 9.0 / 5.0 + 32.0
     }
 }
+
+/// Recycled 80x62 pixel arrays for the frame stream. A delivered frame shares its
+/// array with the pool: once the UI has dropped the frame the array is rewritten in
+/// place, and a frame still held just makes the next fill copy on write.
+final class PixelBufferPool {
+    private var buffers: [[UInt16]]
+    private var next = 0
+
+    init(count: Int = 4) {
+        let pixelCount = ThermalProtocol.frameWidth * ThermalProtocol.imageHeight
+        buffers = (0..<max(1, count)).map { _ in [UInt16](repeating: 0, count: pixelCount) }
+    }
+
+    /// Fill the next array in place and return it for a ThermalFrame
+    func fill(_ body: (UnsafeMutableBufferPointer<UInt16>) -> Void) -> [UInt16] {
+        let index = next
+        next = (next + 1) % buffers.count
+        buffers[index].withUnsafeMutableBufferPointer { body($0) }
+        return buffers[index]
+    }
+}
@@ -9,6 +9,19 @@ class BLEManager: NSObject {
     static let serviceUUID = CBUUID(string: "00000100-CAAB-3792-3D44-97AE51C1407A")
     static let characteristicUUID = CBUUID(string: "00000101-CAAB-3792-3D44-97AE51C1407A")
 
+    // Thermal Stream service, frames for sites without Wi-Fi (see protocol.md)
+    static let streamServiceUUID = CBUUID(string: "5A0B0100-2E1F-4B8C-9D37-6C1E80F3A7B2")
+    static let streamFrameUUID = CBUUID(string: "5A0B0101-2E1F-4B8C-9D37-6C1E80F3A7B2")
+    static let streamControlUUID = CBUUID(string: "5A0B0102-2E1F-4B8C-9D37-6C1E80F3A7B2")
+    static let streamChunkHeaderSize = 3
+    static let streamHeaderSize = 14
+    static let streamOpCredit: UInt8 = 0x01
+    static let streamOpView: UInt8 = 0x02
+    static let streamOpRate: UInt8 = 0x03
+    static let streamOpKeyframe: UInt8 = 0x04
+    static let streamCreditWindow: UInt8 = 16  // Notifications granted in advance
+    static let streamCreditBatch = 8           // Credits are returned in batches of this many
+
     // MARK: - State
     enum ConnectionState {
         case disconnected
@@ -32,13 +45,41 @@ class BLEManager: NSObject {
     var cCenter: Double = 0
     var dCenter: Double = 0
 
+    // Frame stream
+    enum StreamView: Equatable {
+        case preview          // 40x31, mean of 2x2 blocks
+        case roi(UInt8)       // Bounding box of one ROI slot
+    }
+
+    /// Receive frames over BLE while connected
+    var streamFrames: Bool = false {
+        didSet { updateStreamNotifications() }
+    }
+    var streamView: StreamView = .preview {
+        didSet { if isStreaming { sendStreamView() } }
+    }
+    var streamFps: UInt8 = 8 {
+        didSet { if isStreaming { sendStreamRate() } }
+    }
+    var isStreaming: Bool = false
+    var incompleteStreamFrames: Int = 0
+
     // Callbacks
     var onTemperaturesUpdated: (() -> Void)?
+    var onFrameReceived: ((ThermalFrame) -> Void)?
 
     // MARK: - Private
     private var centralManager: CBCentralManager!
     private var thermoHoodPeripheral: CBPeripheral?
     private var probeCharacteristic: CBCharacteristic?
+    private var streamFrameCharacteristic: CBCharacteristic?
+    private var streamControlCharacteristic: CBCharacteristic?
+    private var streamMessage: [UInt8] = []
+    private var streamFrameId: UInt8?          // Frame being reassembled, nil between frames
+    private var streamNextChunk = 0
+    private var streamReceivedSinceGrant = 0
+    private var streamReference: [UInt16]?     // Last decoded view, base of delta frames
+    private var streamReferenceView: [UInt8]?  // X, Y, width, height, step of streamReference
 
     override init() {
         super.init()
@@ -73,6 +114,7 @@ class BLEManager: NSObject {
         }
         thermoHoodPeripheral = nil
         probeCharacteristic = nil
+        resetStream()
         state = .disconnected
         discoveredDeviceName = nil
     }
@@ -148,6 +190,153 @@ class BLEManager: NSObject {
         let temps = decodeTemperatures(from: tempData)
         updateTemperatures(temps)
     }
+
+    // MARK: - Frame Stream
+
+    private func updateStreamNotifications() {
+        guard let peripheral = thermoHoodPeripheral, let characteristic = streamFrameCharacteristic else { return }
+        peripheral.setNotifyValue(streamFrames, for: characteristic)
+    }
+
+    private func resetStream() {
+        streamFrameCharacteristic = nil
+        streamControlCharacteristic = nil
+        isStreaming = false
+        streamMessage = []
+        streamFrameId = nil
+        streamNextChunk = 0
+        streamReceivedSinceGrant = 0
+        streamReference = nil
+        streamReferenceView = nil
+    }
+
+    /// Control writes need a response: a lost credit grant would stall the stream
+    private func writeStreamControl(_ bytes: [UInt8]) {
+        guard let peripheral = thermoHoodPeripheral, let characteristic = streamControlCharacteristic else { return }
+        peripheral.writeValue(Data(bytes), for: characteristic, type: .withResponse)
+    }
+
+    private func sendStreamView() {
+        switch streamView {
+        case .preview:
+            writeStreamControl([Self.streamOpView, 0x00])
+        case .roi(let slot):
+            writeStreamControl([Self.streamOpView, 0x01, slot])
+        }
+    }
+
+    private func sendStreamRate() {
+        writeStreamControl([Self.streamOpRate, streamFps])
+    }
+
+    /// Return credits in batches, so the device keeps streamCreditWindow notifications in flight
+    private func returnStreamCredit() {
+        streamReceivedSinceGrant += 1
+        guard streamReceivedSinceGrant >= Self.streamCreditBatch else { return }
+        writeStreamControl([Self.streamOpCredit, UInt8(streamReceivedSinceGrant)])
+        streamReceivedSinceGrant = 0
+    }
+
+    /// Reassemble a frame from its notifications. Chunks arrive in order, so a gap
+    /// means the frame is lost: drop it and ask for a keyframe.
+    private func processStreamChunk(_ data: Data) {
+        let bytes = [UInt8](data)
+        guard bytes.count > Self.streamChunkHeaderSize else { return }
+        returnStreamCredit()
+
+        let frameId = bytes[0]
+        let index = Int(bytes[1])
+        let count = Int(bytes[2])
+
+        if index == 0 {
+            if streamFrameId != nil { incompleteStreamFrames += 1 }
+            streamFrameId = frameId
+            streamMessage.removeAll(keepingCapacity: true)
+        } else if streamFrameId != frameId || index != streamNextChunk {
+            if streamFrameId != nil {  // Joined mid-frame otherwise
+                incompleteStreamFrames += 1
+                streamFrameId = nil
+                streamReference = nil
+                writeStreamControl([Self.streamOpKeyframe])
+            }
+            return
+        }
+
+        streamMessage.append(contentsOf: bytes[Self.streamChunkHeaderSize...])
+        streamNextChunk = index + 1
+        guard streamNextChunk >= count else { return }
+
+        streamFrameId = nil
+        streamNextChunk = 0
+        decodeStreamMessage(streamMessage)
+    }
+
+    /// Decode a stream message and place the view on a full 80x62 image
+    private func decodeStreamMessage(_ message: [UInt8]) {
+        guard message.count >= Self.streamHeaderSize else { return }
+
+        let encoding = message[0]
+        let isKeyframe = message[1] & ThermalProtocol.streamFlagKeyframe != 0
+        let view = Array(message[2..<7])
+        let x = Int(view[0]), y = Int(view[1]), width = Int(view[2]), height = Int(view[3]), step = Int(view[4])
+        let sequence = UInt32(message[8]) | UInt32(message[9]) << 8 | UInt32(message[10]) << 16 | UInt32(message[11]) << 24
+        let payloadLength = Int(message[12]) | Int(message[13]) << 8
+
+        guard width > 0, height > 0, step > 0,
+              message.count >= Self.streamHeaderSize + payloadLength else { return }
+
+        let payload = Array(message[Self.streamHeaderSize..<(Self.streamHeaderSize + payloadLength)])
+        let pixelCount = width * height
+        let reference = (isKeyframe || streamReferenceView != view) ? nil : streamReference
+        if !isKeyframe && reference == nil { return }  // Waiting for a keyframe
+
+        var pixels: [UInt16]?
+        switch encoding {
+        case ThermalProtocol.streamEncodingRaw16:
+            if payload.count >= pixelCount * 2 {
+                pixels = (0..<pixelCount).map { UInt16(payload[$0 * 2]) | UInt16(payload[$0 * 2 + 1]) << 8 }
+            }
+        case ThermalProtocol.streamEncodingDelta:
+            pixels = FrameDecoder.decodeDelta(payload, reference: reference, pixelCount: pixelCount)
+        case ThermalProtocol.streamEncodingDeltaLZ:
+            if let residuals = FrameDecoder.decodeLZ(payload, maxOutput: pixelCount * 2) {
+                pixels = FrameDecoder.decodeDelta(residuals, reference: reference, pixelCount: pixelCount)
+            }
+        default:
+            break
+        }
+
+        streamReference = pixels  // A broken frame invalidates the reference
+        streamReferenceView = view
+        guard let pixels = pixels else {
+            writeStreamControl([Self.streamOpKeyframe])
+            return
+        }
+
+        // Each pixel covers a step x step block, outside the view is the view minimum
+        let imageWidth = ThermalProtocol.frameWidth
+        let imageHeight = ThermalProtocol.imageHeight
+        var image = [UInt16](repeating: pixels.min() ?? 0, count: imageWidth * imageHeight)
+        for row in 0..<height {
+            for column in 0..<width {
+                let value = pixels[row * width + column]
+                for dy in 0..<step {
+                    let py = y + row * step + dy
+                    guard py < imageHeight else { break }
+                    for dx in 0..<step {
+                        let px = x + column * step + dx
+                        guard px < imageWidth else { break }
+                        image[py * imageWidth + px] = value
+                    }
+                }
+            }
+        }
+
+        guard let frame = ThermalFrame(image: image, sequence: sequence) else { return }
+        DispatchQueue.main.async {
+            self.onFrameReceived?(frame)
+        }
+    }
 }
 
 // MARK: - CBCentralManagerDelegate
@@ -186,7 +375,7 @@ extension BLEManager: CBCentralManagerDelegate {
 
     func centralManager(_ central: CBCentralManager, didConnect peripheral: CBPeripheral) {
         state = .connected
-        peripheral.discoverServices([Self.serviceUUID])
+        peripheral.discoverServices([Self.serviceUUID, Self.streamServiceUUID])
     }
 
     func centralManager(_ central: CBCentralManager, didFailToConnect peripheral: CBPeripheral, error: Error?) {
@@ -198,6 +387,7 @@ extension BLEManager: CBCentralManagerDelegate {
     func centralManager(_ central: CBCentralManager, didDisconnectPeripheral peripheral: CBPeripheral, error: Error?) {
         thermoHoodPeripheral = nil
         probeCharacteristic = nil
+        resetStream()
 
         // If we were connected, try to reconnect
         if state == .connected {
@@ -213,8 +403,12 @@ extension BLEManager: CBPeripheralDelegate {
     func peripheral(_ peripheral: CBPeripheral, didDiscoverServices error: Error?) {
         guard let services = peripheral.services else { return }
 
-        for service in services where service.uuid == Self.serviceUUID {
-            peripheral.discoverCharacteristics([Self.characteristicUUID], for: service)
+        for service in services {
+            if service.uuid == Self.serviceUUID {
+                peripheral.discoverCharacteristics([Self.characteristicUUID], for: service)
+            } else if service.uuid == Self.streamServiceUUID {
+                peripheral.discoverCharacteristics([Self.streamFrameUUID, Self.streamControlUUID], for: service)
+            }
         }
     }
 
@@ -223,17 +417,49 @@ extension BLEManager: CBPeripheralDelegate {
                     error: Error?) {
         guard let characteristics = service.characteristics else { return }
 
-        for char in characteristics where char.uuid == Self.characteristicUUID {
-            probeCharacteristic = char
-            peripheral.setNotifyValue(true, for: char)
+        for char in characteristics {
+            switch char.uuid {
+            case Self.characteristicUUID:
+                probeCharacteristic = char
+                peripheral.setNotifyValue(true, for: char)
+            case Self.streamFrameUUID:
+                streamFrameCharacteristic = char
+                if streamFrames { peripheral.setNotifyValue(true, for: char) }
+            case Self.streamControlUUID:
+                streamControlCharacteristic = char
+            default:
+                break
+            }
         }
     }
 
+    func peripheral(_ peripheral: CBPeripheral,
+                    didUpdateNotificationStateFor characteristic: CBCharacteristic,
+                    error: Error?) {
+        guard characteristic.uuid == Self.streamFrameUUID else { return }
+
+        isStreaming = characteristic.isNotifying && error == nil
+        streamFrameId = nil
+        streamReference = nil
+        streamReceivedSinceGrant = 0
+        guard isStreaming else { return }
+
+        // The device sends nothing until it has credits
+        sendStreamView()
+        sendStreamRate()
+        writeStreamControl([Self.streamOpCredit, Self.streamCreditWindow])
+    }
+
     func peripheral(_ peripheral: CBPeripheral,
                     didUpdateValueFor characteristic: CBCharacteristic,
                     error: Error?) {
-        guard characteristic.uuid == Self.characteristicUUID,
-              let data = characteristic.value else { return }
+        guard let data = characteristic.value else { return }
+
+        if characteristic.uuid == Self.streamFrameUUID {
+            processStreamChunk(data)
+            return
+        }
+        guard characteristic.uuid == Self.characteristicUUID else { return }
 
         // GATT notification contains temperature data directly
         let temps = decodeTemperatures(from: data)
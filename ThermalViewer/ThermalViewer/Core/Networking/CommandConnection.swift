@@ -5,9 +5,17 @@ import Network
 class CommandConnection {
     private var connection: NWConnection?
     private var receiveBuffer = Data()
+    private let queue: DispatchQueue
 
     var state: NWConnection.State = .setup
-    var onQuadrantDataReceived: (([UInt8: UInt16]) -> Void)?
+    /// Main thread. Quadrant registers of a BRWR or RRSE response or a SUBV push
+    var onQuadrantDataReceived: ((QuadrantRegisters) -> Void)?
+    var onReady: (() -> Void)?
+
+    /// queue runs the connection, sessions of several devices can share one
+    init(queue: DispatchQueue = .global(qos: .userInteractive)) {
+        self.queue = queue
+    }
 
     func connect(host: String) {
         disconnect()
@@ -25,10 +33,11 @@ class CommandConnection {
             }
             if newState == .ready {
                 self?.startReceiving()
+                self?.onReady?()
             }
         }
 
-        connection?.start(queue: .global(qos: .userInteractive))
+        connection?.start(queue: queue)
     }
 
     func disconnect() {
@@ -52,8 +61,9 @@ class CommandConnection {
         send(packet)
     }
 
+    /// One binary BRWR batch, answered with raw values instead of ASCII hex
     func readQuadrantRegisters() {
-        let packet = ThermalProtocol.buildRRSE(addresses: ThermalProtocol.quadrantRegisters)
+        let packet = ThermalProtocol.buildBRWR(reads: ThermalProtocol.quadrantRegisters)
         send(packet)
     }
 
@@ -64,6 +74,20 @@ class CommandConnection {
         send(packet)
     }
 
+    /// Send SFMT command to select the frame stream format on port 3333
+    func sendStreamFormat(_ format: UInt8, encoding: UInt8 = ThermalProtocol.streamEncodingRaw16) {
+        let packet = ThermalProtocol.buildSFMT(format: format, encoding: encoding)
+        send(packet)
+    }
+
+    /// Have the quadrant registers pushed at most every intervalMs, and only once they
+    /// moved by threshold raw units. Also sets the capture rate of the device.
+    func subscribeQuadrants(intervalMs: Int, threshold: UInt16 = 0) {
+        let packet = ThermalProtocol.buildSUBS(intervalMs: intervalMs, threshold: threshold,
+                                               addresses: ThermalProtocol.quadrantRegisters)
+        send(packet)
+    }
+
     private func send(_ data: Data) {
         connection?.send(content: data, completion: .contentProcessed { error in
             if let error = error {
@@ -89,37 +113,50 @@ class CommandConnection {
     private func processReceivedData(_ data: Data) {
         receiveBuffer.append(data)
 
-        // Process protocol packets
-        while let packetStart = ThermalProtocol.findPacketStart(in: receiveBuffer) {
-            let packetBuffer = receiveBuffer.suffix(from: receiveBuffer.startIndex + packetStart)
-
-            guard let (command, payload, totalLength) = ThermalProtocol.parsePacket(Data(packetBuffer)) else {
-                break  // Incomplete packet, wait for more data
-            }
-
-            // Handle different commands
-            switch command {
-            case "RRSE":
-                let results = ThermalProtocol.parseRRSEResponse(payload)
-                DispatchQueue.main.async { [weak self] in
-                    self?.onQuadrantDataReceived?(results)
+        // Packets are decoded in place, the buffer is trimmed once per receive
+        let consumed = receiveBuffer.withUnsafeBytes { raw -> Int in
+            let bytes = raw.bindMemory(to: UInt8.self)
+            var offset = 0
+
+            while let start = ThermalProtocol.findPacket(bytes, from: offset) {
+                switch ThermalProtocol.decodePacket(bytes, at: start) {
+                case .packet(let packet):
+                    if packet.sumValid {
+                        handlePacket(packet.command, data: UnsafeBufferPointer(rebasing: bytes[packet.data]))
+                    }
+                    offset = packet.end
+                case .incomplete:
+                    return start  // Wait for more data
+                case .invalid:
+                    offset = start + 1  // Not a real packet
                 }
+            }
+            // All but a possible partial packet prefix can be dropped
+            return max(offset, bytes.count - (ThermalProtocol.packetLen - 1))
+        }
 
-            case "RREG":
-                // Single register read response
-                break
+        receiveBuffer.removeFirst(consumed)
+    }
 
-            case "WREG":
-                // Write acknowledgment
-                break
+    private func handlePacket(_ command: UInt32, data: UnsafeBufferPointer<UInt8>) {
+        let registers: QuadrantRegisters?
+
+        switch command {
+        case ThermalProtocol.commandBRWR:
+            registers = ThermalProtocol.parseBRWRResponse(data)
+        case ThermalProtocol.commandSUBV:
+            registers = ThermalProtocol.parseSUBVPush(data)
+        case ThermalProtocol.commandRRSE:
+            registers = ThermalProtocol.parseRRSEResponse(data)
+        default:
+            // RREG, WREG, SFMT and SUBS acknowledgments
+            registers = nil
+        }
 
-            default:
-                break
+        if let registers = registers, !registers.isEmpty {
+            DispatchQueue.main.async { [weak self] in
+                self?.onQuadrantDataReceived?(registers)
             }
-
-            // Remove processed packet from buffer
-            let removeCount = packetStart + totalLength
-            receiveBuffer.removeFirst(removeCount)
         }
     }
 }
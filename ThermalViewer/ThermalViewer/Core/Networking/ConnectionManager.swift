@@ -1,5 +1,6 @@
 import Foundation
 import Network
+import os
 
 @Observable
 class ConnectionManager {
@@ -14,11 +15,22 @@ class ConnectionManager {
     var fps: Int = 0
     var frameStreamEnabled: Bool = false
 
+    // Session recording and playback
+    var isRecording: Bool = false
+    var recordedFrames: Int = 0
+    private(set) var player: SessionPlayer?
+    var playbackPosition: Int = 0
+    var isPlaying: Bool = false
+
     // BLE hybrid mode settings
     var bleAutoConnectEnabled: Bool {
         didSet { UserDefaults.standard.set(bleAutoConnectEnabled, forKey: "bleAutoConnectEnabled") }
     }
     var usingBLEData: Bool = false
+    /// Also take frames over BLE in Simple mode, for sites without Wi-Fi
+    var bleFrameStreamEnabled: Bool = false {
+        didSet { bleManager.streamFrames = bleFrameStreamEnabled }
+    }
 
     // Display settings (shared across tabs, persisted)
     var flipHorizontally: Bool {
@@ -35,9 +47,14 @@ class ConnectionManager {
         static let flipV = "flipVertically"
     }
 
-    private var fpsTimer: Timer?
-    private var frameTimestamps: [Date] = []
-    private var quadrantPollTimer: Timer?
+    private let framePublisher = FramePublisher()
+    /// Read on the receive queues: the recorder takes every live frame, live frames
+    /// are not shown while a session plays
+    private struct FrameTap {
+        var recorder: SessionRecorder?
+        var isReplaying = false
+    }
+    private let frameTap = OSAllocatedUnfairLock(initialState: FrameTap())
     private var reconnectTask: Task<Void, Never>?
     private var lastBLEUpdateTime: Date?
 
@@ -86,21 +103,48 @@ class ConnectionManager {
     }
 
     private func setupCallbacks() {
+        // Frames are decoded off the main thread and reach the UI once per display refresh
         frameConnection.onFrameReceived = { [weak self] frame in
-            self?.handleFrame(frame)
+            self?.receiveLive(frame)
+        }
+        framePublisher.onPublish = { [weak self] frame, received, fps in
+            self?.handleFrame(frame, received: received, fps: fps)
+        }
+        framePublisher.onIdle = { [weak self] in
+            self?.fps = 0
+        }
+
+        // Ask for the framed stream every time the frame port (re)connects,
+        // the device falls back to raw frames when its last viewer leaves
+        frameConnection.framedFormat = true
+        frameConnection.onReady = { [weak self] in
+            self?.commandConnection.sendStreamFormat(ThermalProtocol.streamFormatFramed,
+                                                     encoding: ThermalProtocol.streamEncodingDeltaLZ)
+        }
+
+        commandConnection.onReady = { [weak self] in
+            DispatchQueue.main.async {
+                self?.subscribeQuadrants()
+            }
         }
 
         commandConnection.onQuadrantDataReceived = { [weak self] results in
             guard let self = self else { return }
             // Only use WiFi data if not receiving BLE data
             if !self.usingBLEData {
-                self.quadrantData.update(from: results)
+                self.quadrantData.apply(results)
             }
         }
 
         bleManager.onTemperaturesUpdated = { [weak self] in
             self?.handleBLEUpdate()
         }
+
+        // Frames over BLE, shown only while the Wi-Fi frame stream is off
+        bleManager.onFrameReceived = { [weak self] frame in
+            guard let self = self, !self.frameStreamEnabled else { return }
+            self.receiveLive(frame)
+        }
     }
 
     private func handleBLEUpdate() {
@@ -137,9 +181,8 @@ class ConnectionManager {
         }
         commandConnection.connect(host: host)
 
-        // Start quadrant polling after a short delay
+        // Quadrant updates start from commandConnection.onReady
         DispatchQueue.main.asyncAfter(deadline: .now() + 0.5) { [weak self] in
-            self?.startQuadrantPolling()
             // If connecting without frame stream (Simple mode), send POLL to enable ESP32 polling
             if !withFrameStream {
                 self?.commandConnection.sendPoll(frequency: 1)
@@ -151,12 +194,14 @@ class ConnectionManager {
 
     func disconnect() {
         reconnectTask?.cancel()
-        stopQuadrantPolling()
         stopBLEScanning()
+        stopRecording()
+        closePlayback()
 
         frameConnection.disconnect()
         commandConnection.disconnect()
 
+        framePublisher.reset()
         frameCount = 0
         fps = 0
         currentFrame = nil
@@ -183,6 +228,7 @@ class ConnectionManager {
         } else if !enabled && frameStreamEnabled {
             // Entering Simple view: disconnect frame stream, then start polling and BLE
             frameConnection.disconnect()
+            framePublisher.reset()
             currentFrame = nil
             frameCount = 0
             fps = 0
@@ -247,40 +293,110 @@ class ConnectionManager {
 
     // MARK: - Frame Handling
 
-    private func handleFrame(_ frame: ThermalFrame) {
-        currentFrame = frame
-        frameCount += 1
-        updateFPS()
+    /// Receive queue of the frame port or BLE
+    private func receiveLive(_ frame: ThermalFrame) {
+        let (recorder, isReplaying) = frameTap.withLock { ($0.recorder, $0.isReplaying) }
+        recorder?.append(frame)
+        if !isReplaying {
+            framePublisher.submit(frame)
+        }
     }
 
-    private func updateFPS() {
-        let now = Date()
-        frameTimestamps.append(now)
-
-        // Keep only timestamps from last second
-        let oneSecondAgo = now.addingTimeInterval(-1)
-        frameTimestamps = frameTimestamps.filter { $0 > oneSecondAgo }
+    /// At most once per display refresh, frames in between are counted but not shown
+    private func handleFrame(_ frame: ThermalFrame, received: Int, fps: Int) {
+        currentFrame = frame
+        frameCount = received
+        self.fps = fps
+        if let recorder = frameTap.withLock({ $0.recorder }) {
+            recordedFrames = recorder.frameCount
+        }
+    }
 
-        fps = frameTimestamps.count
+    // MARK: - Recording
+
+    /// Record the live frames to a new session in SessionFormat.directory
+    func startRecording() {
+        guard !isRecording else { return }
+        do {
+            let recorder = try SessionRecorder()
+            frameTap.withLock { $0.recorder = recorder }
+            recordedFrames = 0
+            isRecording = true
+        } catch {
+            print("Failed to start recording: \(error)")
+        }
     }
 
-    // MARK: - Quadrant Polling
+    func stopRecording() {
+        guard isRecording else { return }
+        let recorder = frameTap.withLock { tap -> SessionRecorder? in
+            defer { tap.recorder = nil }
+            return tap.recorder
+        }
+        recorder?.finish()
+        isRecording = false
+    }
 
-    private func startQuadrantPolling() {
-        stopQuadrantPolling()
+    // MARK: - Playback
+
+    /// Play a recorded session in place of the live frames. Its frames go through the
+    /// same publisher and renderer, recording carries on underneath.
+    func openPlayback(_ url: URL) {
+        closePlayback()
+        do {
+            let player = try SessionPlayer(url: url)
+            player.onFrame = { [weak self] frame, index in
+                self?.framePublisher.submit(frame)
+                DispatchQueue.main.async {
+                    self?.playbackPosition = index
+                }
+            }
+            player.onPlayingChanged = { [weak self] playing in
+                DispatchQueue.main.async {
+                    self?.isPlaying = playing
+                }
+            }
+            frameTap.withLock { $0.isReplaying = true }
+            framePublisher.reset()
+            self.player = player
+            playbackPosition = 0
+            player.seek(to: 0)
+            player.play()
+        } catch {
+            print("Failed to open recording: \(error)")
+        }
+    }
 
-        // Initial read
-        commandConnection.readQuadrantRegisters()
+    func closePlayback() {
+        guard let player = player else { return }
+        player.stop()
+        self.player = nil
+        isPlaying = false
+        frameTap.withLock { $0.isReplaying = false }
+        framePublisher.reset()
+        currentFrame = nil
+    }
 
-        // Poll every second
-        quadrantPollTimer = Timer.scheduledTimer(withTimeInterval: 1.0, repeats: true) { [weak self] _ in
-            self?.commandConnection.readQuadrantRegisters()
+    func togglePlayback() {
+        guard let player = player else { return }
+        if isPlaying {
+            player.pause()
+        } else {
+            player.play()
         }
     }
 
-    private func stopQuadrantPolling() {
-        quadrantPollTimer?.invalidate()
-        quadrantPollTimer = nil
+    func seekPlayback(to frame: Int) {
+        playbackPosition = frame
+        player?.seek(to: frame)
+    }
+
+    // MARK: - Quadrant Updates
+
+    /// The device pushes the quadrant registers that changed, at most once a second.
+    /// A subscription ends with its connection, so this runs on every connect.
+    private func subscribeQuadrants() {
+        commandConnection.subscribeQuadrants(intervalMs: 1000)
     }
 
     // MARK: - Quadrant Controls
@@ -0,0 +1,198 @@
+import Foundation
+import Network
+
+/// One camera of the dashboard. Every device keeps only its command port open and
+/// has its quadrant registers pushed by SUBS, so a thumbnail costs no timer and no
+/// frame traffic. Only the focused device also opens the frame port.
+@Observable
+final class DeviceSession: Identifiable {
+    static let thumbnailIntervalMs = 1000
+    static let thumbnailThreshold: UInt16 = 5  // Raw units, about 0.5 °C
+    static let focusedIntervalMs = 200
+
+    let id = UUID()
+    let host: String
+    let quadrantData = QuadrantData()
+    let commandConnection: CommandConnection
+    private(set) var frameConnection: FrameStreamConnection?
+    private let queue: DispatchQueue
+
+    var isConnected: Bool {
+        commandConnection.state == .ready
+    }
+
+    var isFocused: Bool {
+        frameConnection != nil
+    }
+
+    /// Hottest quadrant maximum, shown on the tile
+    var hottest: UInt16 {
+        max(quadrantData.aMax, quadrantData.bMax, quadrantData.cMax, quadrantData.dMax)
+    }
+
+    fileprivate var needsReconnect: Bool {
+        switch commandConnection.state {
+        case .failed, .waiting, .cancelled: return true
+        default: return false
+        }
+    }
+
+    fileprivate init(host: String, queue: DispatchQueue) {
+        self.host = host
+        self.queue = queue
+        self.commandConnection = CommandConnection(queue: queue)
+
+        commandConnection.onQuadrantDataReceived = { [weak self] results in
+            self?.quadrantData.apply(results)
+        }
+        // A subscription ends with its connection, renew it on every connect
+        commandConnection.onReady = { [weak self] in
+            DispatchQueue.main.async {
+                self?.subscribe()
+            }
+        }
+    }
+
+    fileprivate func connect() {
+        commandConnection.connect(host: host)
+        frameConnection?.connect(host: host)
+    }
+
+    fileprivate func disconnect() {
+        stopFrameStream()
+        commandConnection.disconnect()
+    }
+
+    /// Reconnect whichever port dropped, called from the manager's shared timer
+    fileprivate func reconnectIfNeeded() {
+        if needsReconnect {
+            connect()
+        } else if let frameConnection = frameConnection, case .failed = frameConnection.state {
+            frameConnection.connect(host: host)
+        }
+    }
+
+    /// Full frames, onFrame runs on the network queue
+    fileprivate func startFrameStream(onFrame: @escaping (ThermalFrame) -> Void) {
+        let connection = FrameStreamConnection(queue: queue)
+        connection.framedFormat = true
+        connection.onReady = { [weak self] in
+            self?.commandConnection.sendStreamFormat(ThermalProtocol.streamFormatFramed,
+                                                     encoding: ThermalProtocol.streamEncodingDeltaLZ)
+        }
+        connection.onFrameReceived = onFrame
+        frameConnection = connection
+        connection.connect(host: host)
+        subscribe()
+    }
+
+    fileprivate func stopFrameStream() {
+        guard let connection = frameConnection else { return }
+        connection.onFrameReceived = nil
+        connection.disconnect()
+        frameConnection = nil
+        subscribe()
+    }
+
+    private func subscribe() {
+        guard isConnected else { return }
+        if isFocused {
+            commandConnection.subscribeQuadrants(intervalMs: Self.focusedIntervalMs)
+        } else {
+            commandConnection.subscribeQuadrants(intervalMs: Self.thumbnailIntervalMs, threshold: Self.thumbnailThreshold)
+        }
+    }
+}
+
+/// Sessions of every camera on the dashboard. All connections share one serial
+/// network queue and one reconnect timer, and only the focused device streams
+/// frames, so bandwidth and wakeups grow with the quadrant pushes of each extra
+/// camera rather than with its frames.
+@Observable
+final class DeviceSessionManager {
+    private static let hostsKey = "dashboardHosts"
+    private static let reconnectInterval: TimeInterval = 5
+
+    private(set) var sessions: [DeviceSession] = []
+    private(set) var focusedID: UUID?
+    private(set) var focusedFrame: ThermalFrame?
+    private(set) var focusedFPS: Int = 0
+
+    private let networkQueue = DispatchQueue(label: "ThermalViewer.devices", qos: .userInitiated)
+    private let framePublisher = FramePublisher()
+    private var reconnectTimer: Timer?
+
+    var focusedSession: DeviceSession? {
+        sessions.first { $0.id == focusedID }
+    }
+
+    init() {
+        let hosts = UserDefaults.standard.stringArray(forKey: Self.hostsKey) ?? []
+        sessions = hosts.map { DeviceSession(host: $0, queue: networkQueue) }
+
+        framePublisher.onPublish = { [weak self] frame, _, fps in
+            self?.focusedFrame = frame
+            self?.focusedFPS = fps
+        }
+        framePublisher.onIdle = { [weak self] in
+            self?.focusedFPS = 0
+        }
+    }
+
+    func start() {
+        guard reconnectTimer == nil else { return }
+        sessions.forEach { $0.connect() }
+        reconnectTimer = Timer.scheduledTimer(withTimeInterval: Self.reconnectInterval, repeats: true) { [weak self] _ in
+            self?.sessions.forEach { $0.reconnectIfNeeded() }
+        }
+    }
+
+    func stop() {
+        focus(nil)
+        reconnectTimer?.invalidate()
+        reconnectTimer = nil
+        sessions.forEach { $0.disconnect() }
+    }
+
+    /// host is an IP address or the device's mDNS name, `<hostname>.local`
+    func addDevice(host: String) {
+        let host = host.trimmingCharacters(in: .whitespacesAndNewlines)
+        guard !host.isEmpty, !sessions.contains(where: { $0.host == host }) else { return }
+
+        let session = DeviceSession(host: host, queue: networkQueue)
+        sessions.append(session)
+        saveHosts()
+        if reconnectTimer != nil {
+            session.connect()
+        }
+    }
+
+    func removeDevice(_ session: DeviceSession) {
+        if session.id == focusedID {
+            focus(nil)
+        }
+        session.disconnect()
+        sessions.removeAll { $0.id == session.id }
+        saveHosts()
+    }
+
+    /// Stream full frames from this device only, the previous one drops back to pushes
+    func focus(_ session: DeviceSession?) {
+        guard session?.id != focusedID else { return }
+
+        focusedSession?.stopFrameStream()
+        framePublisher.reset()
+        focusedFrame = nil
+        focusedFPS = 0
+        focusedID = session?.id
+
+        let publisher = framePublisher
+        session?.startFrameStream { frame in
+            publisher.submit(frame)
+        }
+    }
+
+    private func saveHosts() {
+        UserDefaults.standard.set(sessions.map(\.host), forKey: Self.hostsKey)
+    }
+}
@@ -0,0 +1,124 @@
+import Foundation
+import QuartzCore
+import os
+
+/// Hands decoded frames from the receive queues to the UI at most once per display
+/// refresh. Frames arriving faster than the display are coalesced to the newest, so
+/// the main thread does one update per vsync whatever the stream rate. The display
+/// link pauses itself once the stream stops.
+final class FramePublisher {
+    /// Main thread. Newest frame, frames received since the last reset, receive rate.
+    var onPublish: ((ThermalFrame, Int, Int) -> Void)?
+    /// Main thread. No frame for a second, the stream has stalled.
+    var onIdle: (() -> Void)?
+
+    private struct State {
+        var frame: ThermalFrame?
+        var received = 0
+        var rate = FrameRateCounter()
+        var isLinkRunning = false
+    }
+
+    private let state = OSAllocatedUnfairLock(initialState: State())
+    private var displayLink: CADisplayLink?
+
+    /// Any thread. Keeps only the newest frame until the next display refresh.
+    func submit(_ frame: ThermalFrame) {
+        let now = CACurrentMediaTime()
+        let needsLink = state.withLock { state -> Bool in
+            state.frame = frame
+            state.received += 1
+            state.rate.record(now)
+            defer { state.isLinkRunning = true }
+            return !state.isLinkRunning
+        }
+
+        if needsLink {
+            DispatchQueue.main.async { [weak self] in
+                self?.startDisplayLink()
+            }
+        }
+    }
+
+    /// Drop the pending frame and restart the counters
+    func reset() {
+        state.withLock { state in
+            state.frame = nil
+            state.received = 0
+            state.rate = FrameRateCounter()
+        }
+    }
+
+    private func startDisplayLink() {
+        if displayLink == nil {
+            let link = CADisplayLink(target: DisplayLinkTarget(owner: self), selector: #selector(DisplayLinkTarget.tick(_:)))
+            link.add(to: .main, forMode: .common)
+            displayLink = link
+        }
+        displayLink?.isPaused = false
+    }
+
+    fileprivate func tick(_ link: CADisplayLink) {
+        let now = CACurrentMediaTime()
+        let (frame, received, fps) = state.withLock { state in
+            let frame = state.frame
+            state.frame = nil
+            let fps = state.rate.framesPerSecond(at: now)
+            if frame == nil && fps == 0 {
+                state.isLinkRunning = false  // Stalled, the next submit restarts the link
+            }
+            return (frame, state.received, fps)
+        }
+
+        if let frame = frame {
+            onPublish?(frame, received, fps)
+        } else if fps == 0 {
+            link.isPaused = true
+            onIdle?()
+        }
+    }
+}
+
+/// The display link retains its target, this keeps it from retaining the publisher
+private final class DisplayLinkTarget: NSObject {
+    weak var owner: FramePublisher?
+
+    init(owner: FramePublisher) {
+        self.owner = owner
+    }
+
+    @objc func tick(_ link: CADisplayLink) {
+        guard let owner = owner else {
+            link.invalidate()
+            return
+        }
+        owner.tick(link)
+    }
+}
+
+/// Receive rate over the last frames. Arrival times go to a fixed ring, so
+/// recording and reading are O(1) whatever the frame rate.
+struct FrameRateCounter {
+    static let capacity = 64
+
+    private var times = [CFTimeInterval](repeating: 0, count: capacity)
+    private var head = 0
+    private var count = 0
+
+    mutating func record(_ time: CFTimeInterval) {
+        times[head] = time
+        head = (head + 1) % Self.capacity
+        count = min(count + 1, Self.capacity)
+    }
+
+    /// Frames per second over the ring, 0 once no frame came for a second
+    func framesPerSecond(at now: CFTimeInterval) -> Int {
+        guard count >= 2 else { return 0 }
+
+        let newest = times[(head + Self.capacity - 1) % Self.capacity]
+        let oldest = times[(head + Self.capacity - count) % Self.capacity]
+        guard now - newest <= 1, newest > oldest else { return 0 }
+
+        return Int((Double(count - 1) / (newest - oldest)).rounded())
+    }
+}
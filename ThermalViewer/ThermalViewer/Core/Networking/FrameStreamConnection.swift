@@ -4,10 +4,72 @@ import Network
 @Observable
 class FrameStreamConnection {
     private var connection: NWConnection?
-    private var frameBuffer = Data()
+    @ObservationIgnored private var streamBuffer = StreamBuffer(capacity: StreamBuffer.defaultCapacity)
+    private let pixelPool = PixelBufferPool()
+    private let queue: DispatchQueue
 
     var state: NWConnection.State = .setup
-    var onFrameReceived: ((ThermalFrame) -> Void)?
+    /// Called on the receive queue, not the main thread
+    @ObservationIgnored var onFrameReceived: ((ThermalFrame) -> Void)?
+    var onReady: (() -> Void)?
+
+    /// Expect the v2 stream format (header before every frame).
+    /// The caller selects the format on the device with SFMT.
+    var framedFormat = false
+
+    enum Transport {
+        case tcp
+        case udp  // Firmware built with CONFIG_MI_SER_MODE_UDP, always framed
+    }
+
+    /// Frame port transport, applied on the next connect
+    var transport: Transport = .tcp
+
+    // v2 stream statistics
+    private(set) var droppedFrames: Int = 0
+    private(set) var resyncCount: Int = 0
+    private var lastSequence: UInt32?
+
+    // v2 decoding, buffers allocated once and reused for every frame.
+    // Not observed, so the hot path mutates them in place.
+    private static let pixelCount = ThermalProtocol.tcpFrameSize / ThermalProtocol.bytesPerPixel
+    @ObservationIgnored private var referenceFrame = [UInt16](repeating: 0, count: Self.pixelCount)  // Last decoded frame, base of delta frames
+    @ObservationIgnored private var hasReference = false
+    @ObservationIgnored private var decodedFrame = [UInt16](repeating: 0, count: Self.pixelCount)
+    @ObservationIgnored private var residuals: [UInt8] = {
+        var buffer = [UInt8]()
+        buffer.reserveCapacity(ThermalProtocol.tcpFrameSize)
+        return buffer
+    }()
+
+    // UDP stream
+    private(set) var incompleteFrames: Int = 0
+    private var helloTimer: DispatchSourceTimer?
+    @ObservationIgnored private var chunkFrame = ChunkFrame()  // Frame being reassembled
+
+    private struct ChunkFrame {
+        var id: UInt32 = 0
+        var count = 0
+        var length = 0
+        var data = [UInt8](repeating: 0, count: ThermalProtocol.udpFrameMax)
+        var received = [Bool](repeating: false, count: ThermalProtocol.udpFrameMax / ThermalProtocol.udpChunkData + 1)
+        var receivedCount = 0
+        var isActive = false
+
+        mutating func start(id: UInt32, count: Int, length: Int) {
+            self.id = id
+            self.count = count
+            self.length = length
+            for i in 0..<count { received[i] = false }
+            receivedCount = 0
+            isActive = true
+        }
+    }
+
+    /// queue runs the connection and the decode, sessions of several devices can share one
+    init(queue: DispatchQueue = .global(qos: .userInteractive)) {
+        self.queue = queue
+    }
 
     func connect(host: String) {
         disconnect()
@@ -17,24 +79,42 @@ class FrameStreamConnection {
             port: NWEndpoint.Port(rawValue: ThermalProtocol.framePort)!
         )
 
-        connection = NWConnection(to: endpoint, using: .tcp)
+        let isUDP = transport == .udp
+        connection = NWConnection(to: endpoint, using: isUDP ? .udp : .tcp)
 
         connection?.stateUpdateHandler = { [weak self] newState in
             DispatchQueue.main.async {
                 self?.state = newState
             }
             if newState == .ready {
-                self?.startReceiving()
+                if isUDP {
+                    self?.startHello()
+                    self?.startReceivingDatagrams()
+                } else {
+                    self?.startReceiving()
+                }
+                self?.onReady?()
             }
         }
 
-        connection?.start(queue: .global(qos: .userInteractive))
+        connection?.start(queue: queue)
     }
 
     func disconnect() {
+        if let timer = helloTimer {
+            timer.cancel()
+            helloTimer = nil
+            connection?.send(content: ThermalProtocol.udpBye, completion: .idempotent)
+        }
         connection?.cancel()
         connection = nil
-        frameBuffer.removeAll()
+        streamBuffer.removeAll()
+        lastSequence = nil
+        hasReference = false
+        chunkFrame.isActive = false
+        droppedFrames = 0
+        resyncCount = 0
+        incompleteFrames = 0
         DispatchQueue.main.async {
             self.state = .cancelled
         }
@@ -52,19 +132,415 @@ class FrameStreamConnection {
         }
     }
 
+    /// The hello starts the stream and keeps this viewer registered
+    private func startHello() {
+        let timer = DispatchSource.makeTimerSource(queue: queue)
+        timer.schedule(deadline: .now(), repeating: ThermalProtocol.udpHelloInterval)
+        timer.setEventHandler { [weak self] in
+            self?.connection?.send(content: ThermalProtocol.udpHello, completion: .idempotent)
+        }
+        timer.resume()
+        helloTimer = timer
+    }
+
+    private func startReceivingDatagrams() {
+        connection?.receiveMessage { [weak self] data, _, _, error in
+            if let data = data {
+                data.withUnsafeBytes { self?.processChunk($0.bindMemory(to: UInt8.self)) }
+            }
+
+            if error == nil {
+                self?.startReceivingDatagrams()
+            }
+        }
+    }
+
+    /// Reassemble a v2 frame from its UDP chunks. A chunk of a newer frame drops
+    /// the incomplete one: on poor Wi-Fi a late frame is worth less than a lost one.
+    private func processChunk(_ bytes: UnsafeBufferPointer<UInt8>) {
+        guard let chunk = ThermalProtocol.parseChunkHeader(bytes) else { return }
+
+        if chunkFrame.isActive && chunkFrame.id != chunk.frameId {
+            if Int32(bitPattern: chunk.frameId &- chunkFrame.id) < 0 { return }  // Late chunk of an older frame
+            incompleteFrames += 1
+            chunkFrame.isActive = false
+        }
+
+        if !chunkFrame.isActive {
+            guard chunk.count <= chunkFrame.received.count else { return }
+            chunkFrame.start(id: chunk.frameId, count: chunk.count, length: chunk.frameLength)
+        }
+
+        guard chunkFrame.count == chunk.count, chunkFrame.length == chunk.frameLength,
+              !chunkFrame.received[chunk.index] else { return }
+
+        // Mutate in place, the frame buffer is reused for every frame
+        let payload = UnsafeBufferPointer(rebasing: bytes[ThermalProtocol.udpChunkHeaderSize...])
+        chunkFrame.data.replaceSubrange(chunk.offset..<(chunk.offset + payload.count), with: payload)
+        chunkFrame.received[chunk.index] = true
+        chunkFrame.receivedCount += 1
+
+        guard chunkFrame.receivedCount == chunkFrame.count else { return }
+
+        // Complete: same parser as the TCP v2 stream
+        chunkFrame.isActive = false
+        let length = chunkFrame.length
+        chunkFrame.data.withUnsafeBufferPointer {
+            _ = parseFramed(UnsafeBufferPointer(rebasing: $0[0..<length]))
+        }
+    }
+
+    /// Frames are parsed where they land in the stream buffer. A receive larger
+    /// than the free space is taken in parts, parsing in between.
     private func processReceivedData(_ data: Data) {
-        frameBuffer.append(data)
+        data.withUnsafeBytes { (raw: UnsafeRawBufferPointer) in
+            var offset = 0
+            while offset < raw.count {
+                let taken = streamBuffer.append(UnsafeRawBufferPointer(rebasing: raw[offset...]))
+                offset += taken
+
+                let consumed = streamBuffer.withUnreadBytes { framedFormat ? parseFramed($0) : parseRaw($0) }
+                streamBuffer.consume(consumed)
+
+                if taken == 0 && consumed == 0 {
+                    // Full of bytes that never make a frame (oversized header length)
+                    streamBuffer.removeAll()
+                    resyncCount += 1
+                    hasReference = false
+                }
+            }
+        }
+    }
+
+    /// Extract raw frames (10,240 bytes each). Returns the number of bytes used.
+    private func parseRaw(_ bytes: UnsafeBufferPointer<UInt8>) -> Int {
+        var pos = 0
+        while bytes.count - pos >= ThermalProtocol.tcpFrameSize {
+            deliver(makeFrame(UnsafeRawBufferPointer(rebasing: UnsafeRawBufferPointer(bytes)[pos..<(pos + ThermalProtocol.tcpFrameSize)])))
+            pos += ThermalProtocol.tcpFrameSize
+        }
+        return pos
+    }
+
+    /// Extract v2 frames. Anything in front of a valid header is skipped,
+    /// which also drops raw frames sent before the device switched format.
+    /// Returns the number of bytes used.
+    private func parseFramed(_ bytes: UnsafeBufferPointer<UInt8>) -> Int {
+        var pos = 0
+        while bytes.count - pos >= ThermalProtocol.streamHeaderMinSize {
+            let rest = UnsafeBufferPointer(rebasing: bytes[pos...])
+
+            guard let header = ThermalProtocol.parseStreamHeader(rest) else {
+                // Out of sync: skip to the next magic, keep a possible partial magic
+                pos += ThermalProtocol.findStreamHeaderStart(in: rest[1...]).map { $0 + 1 }
+                    ?? max(1, rest.count - (ThermalProtocol.streamMagic.count - 1))
+                resyncCount += 1
+                hasReference = false
+                continue
+            }
+
+            let total = header.headerLength + header.payloadLength
+            guard rest.count >= total else { break }
+
+            let payload = UnsafeBufferPointer(rebasing: rest[header.headerLength..<total])
+            pos += total
 
-        // Extract complete frames (10,240 bytes each)
-        while frameBuffer.count >= ThermalProtocol.tcpFrameSize {
-            let frameData = frameBuffer.prefix(ThermalProtocol.tcpFrameSize)
-            frameBuffer.removeFirst(ThermalProtocol.tcpFrameSize)
+            if let previous = lastSequence, header.sequence &- previous > 1 {
+                droppedFrames += Int(header.sequence &- previous &- 1)
+            }
+            lastSequence = header.sequence
+
+            guard decodePayload(header: header, payload: payload) else { continue }
+
+            var frame = referenceFrame.withUnsafeBytes { makeFrame($0) }
+            frame.sequence = header.sequence
+            frame.captureTimestampUs = header.timestampUs
+            deliver(frame)
+        }
+        return pos
+    }
 
-            if let frame = ThermalFrame(data: Data(frameData)) {
-                DispatchQueue.main.async { [weak self] in
-                    self?.onFrameReceived?(frame)
+    /// Decode a v2 payload to the 80x64 frame in referenceFrame.
+    /// Returns false while waiting for a keyframe.
+    private func decodePayload(header: ThermalProtocol.StreamHeader, payload: UnsafeBufferPointer<UInt8>) -> Bool {
+        if !header.isKeyframe && !hasReference {
+            return false
+        }
+
+        let useReference = !header.isKeyframe
+        var isDecoded = false
+
+        switch header.encoding {
+        case ThermalProtocol.streamEncodingRaw16:
+            if payload.count >= ThermalProtocol.tcpFrameSize {
+                decodedFrame.withUnsafeMutableBytes {
+                    $0.copyMemory(from: UnsafeRawBufferPointer(rebasing: UnsafeRawBufferPointer(payload)[0..<ThermalProtocol.tcpFrameSize]))
                 }
+                isDecoded = true
+            }
+        case ThermalProtocol.streamEncodingDelta:
+            isDecoded = decodeDelta(payload, useReference: useReference)
+        case ThermalProtocol.streamEncodingDeltaLZ:
+            if FrameDecoder.decodeLZ(payload, into: &residuals, maxOutput: ThermalProtocol.tcpFrameSize) {
+                isDecoded = residuals.withUnsafeBufferPointer { decodeDelta($0, useReference: useReference) }
             }
+        case ThermalProtocol.streamEncodingPack12...ThermalProtocol.streamEncodingPack8:
+            isDecoded = decodedFrame.withUnsafeMutableBufferPointer { FrameDecoder.decodePacked(payload, into: $0) }
+        default:
+            break
         }
+
+        hasReference = isDecoded  // A broken frame invalidates the reference
+        if isDecoded {
+            swap(&decodedFrame, &referenceFrame)
+        }
+        return isDecoded
+    }
+
+    private func decodeDelta(_ input: UnsafeBufferPointer<UInt8>, useReference: Bool) -> Bool {
+        referenceFrame.withUnsafeBufferPointer { reference in
+            decodedFrame.withUnsafeMutableBufferPointer { output in
+                FrameDecoder.decodeDelta(input, reference: useReference ? reference : nil, into: output)
+            }
+        }
+    }
+
+    /// Frame from a raw 80x64 frame, the image rows go to a recycled pixel array
+    private func makeFrame(_ raw: UnsafeRawBufferPointer) -> ThermalFrame {
+        let imageStart = ThermalProtocol.headerSize
+        let image = pixelPool.fill {
+            UnsafeMutableRawBufferPointer($0).copyMemory(
+                from: UnsafeRawBufferPointer(rebasing: raw[imageStart..<(imageStart + ThermalProtocol.imageSize)]))
+        }
+        return ThermalFrame(headerRow: UnsafeRawBufferPointer(rebasing: raw[0..<imageStart]), image: image)
+    }
+
+    private func deliver(_ frame: ThermalFrame) {
+        onFrameReceived?(frame)
+    }
+}
+
+/// Fixed capacity reassembly buffer of the frame port stream. Frames are parsed
+/// where they land and consumed by moving the read index; the partial frame left
+/// over is moved to the front only when the next receive does not fit. Nothing is
+/// allocated after init.
+struct StreamBuffer {
+    /// One full receive plus two of the largest v2 frames
+    static let defaultCapacity = 65536 + 2 * ThermalProtocol.udpFrameMax
+
+    private var storage: [UInt8]
+    private var readIndex = 0
+    private var writeIndex = 0
+
+    init(capacity: Int) {
+        storage = [UInt8](repeating: 0, count: capacity)
+    }
+
+    var count: Int { writeIndex - readIndex }
+
+    /// Copy as much of bytes as fits. Returns the number of bytes taken.
+    mutating func append(_ bytes: UnsafeRawBufferPointer) -> Int {
+        if storage.count - writeIndex < bytes.count && readIndex > 0 {
+            compact()
+        }
+
+        let length = min(bytes.count, storage.count - writeIndex)
+        guard length > 0, let source = bytes.baseAddress else { return 0 }
+        let start = writeIndex
+        storage.withUnsafeMutableBytes { $0.baseAddress!.advanced(by: start).copyMemory(from: source, byteCount: length) }
+        writeIndex += length
+        return length
+    }
+
+    /// Bytes received and not consumed yet
+    func withUnreadBytes<Result>(_ body: (UnsafeBufferPointer<UInt8>) throws -> Result) rethrows -> Result {
+        try storage.withUnsafeBufferPointer { try body(UnsafeBufferPointer(rebasing: $0[readIndex..<writeIndex])) }
+    }
+
+    mutating func consume(_ length: Int) {
+        readIndex = min(readIndex + length, writeIndex)
+        if readIndex == writeIndex {
+            removeAll()
+        }
+    }
+
+    mutating func removeAll() {
+        readIndex = 0
+        writeIndex = 0
+    }
+
+    private mutating func compact() {
+        let length = count
+        let start = readIndex
+        storage.withUnsafeMutableBytes { $0.baseAddress!.copyMemory(from: $0.baseAddress!.advanced(by: start), byteCount: length) }  // Overlap safe
+        readIndex = 0
+        writeIndex = length
+    }
+}
+
+/// Decoders of the v2 stream payload encodings (see protocol.md, frameCodec.c)
+enum FrameDecoder {
+    static let lzMinMatch = 4
+
+    /// Zigzag varint residuals, 0x00 starts a zero run.
+    /// reference is the previous frame, or nil for a keyframe (predict from previous pixel).
+    static func decodeDelta(_ input: [UInt8], reference: [UInt16]?, pixelCount: Int) -> [UInt16]? {
+        var output = [UInt16](repeating: 0, count: pixelCount)
+        let isDecoded = input.withUnsafeBufferPointer { input in
+            output.withUnsafeMutableBufferPointer { output in
+                guard let reference = reference else {
+                    return decodeDelta(input, reference: nil, into: output)
+                }
+                return reference.withUnsafeBufferPointer { decodeDelta(input, reference: $0, into: output) }
+            }
+        }
+        return isDecoded ? output : nil
+    }
+
+    /// decodeDelta into a caller owned frame, for decoding without allocation.
+    /// Fills all of output, returns false on a broken payload.
+    static func decodeDelta(_ input: UnsafeBufferPointer<UInt8>, reference: UnsafeBufferPointer<UInt16>?,
+                            into output: UnsafeMutableBufferPointer<UInt16>) -> Bool {
+        let pixelCount = output.count
+        if let reference = reference, reference.count < pixelCount { return false }
+
+        var ip = 0
+        var i = 0
+        var predict: UInt16 = 0
+
+        func readVarint() -> UInt32? {
+            var value: UInt32 = 0
+            var shift: UInt32 = 0
+            while ip < input.count, shift <= 28 {
+                let byte = input[ip]
+                ip += 1
+                value |= UInt32(byte & 0x7F) << shift
+                if byte & 0x80 == 0 { return value }
+                shift += 7
+            }
+            return nil
+        }
+
+        while i < pixelCount {
+            guard ip < input.count else { return false }
+            var zigzag: UInt32 = 0
+            var count = 1
+
+            if input[ip] == 0x00 {
+                ip += 1
+                guard let run = readVarint(), i + Int(run) + 1 <= pixelCount else { return false }
+                count = Int(run) + 1
+            } else {
+                guard let value = readVarint() else { return false }
+                zigzag = value
+            }
+
+            let delta = UInt16(truncatingIfNeeded: (zigzag >> 1) ^ (0 &- (zigzag & 1)))
+            for _ in 0..<count {
+                if let reference = reference { predict = reference[i] }
+                output[i] = predict &+ delta
+                predict = output[i]
+                i += 1
+            }
+        }
+
+        return true
+    }
+
+    static let packHeaderWords = 8  // Frame header words ahead of a packed image
+    static let packScaleSize = 4    // Minimum, shift and bits ahead of the packed pixels
+    static let packImageOffset = ThermalProtocol.frameWidth * 2  // The image starts after the 2 header rows of the device frame
+
+    /// Header words, then the 80x62 image as an LSB first stream of 8/12/14 bit
+    /// values above the frame minimum. Rebuilt into the 80x64 frame layout of output.
+    /// Returns false on a broken payload or one that is not a full image.
+    static func decodePacked(_ input: UnsafeBufferPointer<UInt8>, into output: UnsafeMutableBufferPointer<UInt16>) -> Bool {
+        let pixels = ThermalProtocol.frameWidth * ThermalProtocol.imageHeight
+        let start = packHeaderWords * 2 + packScaleSize
+        guard input.count >= start, output.count >= packImageOffset + pixels else { return false }
+
+        let min = UInt32(input[start - 4]) | UInt32(input[start - 3]) << 8
+        let shift = UInt32(input[start - 2])
+        let bits = Int(input[start - 1])
+        guard bits == 8 || bits == 12 || bits == 14, shift < 16,
+              input.count >= start + (pixels * bits + 7) / 8 else { return false }
+
+        output.update(repeating: 0)
+        for i in 0..<packHeaderWords {
+            output[i] = UInt16(input[i * 2]) | UInt16(input[i * 2 + 1]) << 8
+        }
+
+        let mask = UInt32(1) << bits - 1
+        let half = shift > 0 ? UInt32(1) << (shift - 1) : 0  // Middle of the step of a lossy value
+        var acc: UInt32 = 0
+        var accBits = 0
+        var ip = start
+        for i in 0..<pixels {
+            while accBits < bits {
+                acc |= UInt32(input[ip]) << accBits
+                ip += 1
+                accBits += 8
+            }
+            output[packImageOffset + i] = UInt16(Swift.min(0xFFFF, min + (acc & mask) << shift + half))
+            acc >>= bits
+            accBits -= bits
+        }
+        return true
+    }
+
+    /// LZ4 style block: [token][literal length...][literals][offset LE][match length...]
+    static func decodeLZ(_ input: [UInt8], maxOutput: Int) -> [UInt8]? {
+        var output = [UInt8]()
+        output.reserveCapacity(maxOutput)
+        let isDecoded = input.withUnsafeBufferPointer { decodeLZ($0, into: &output, maxOutput: maxOutput) }
+        return isDecoded ? output : nil
+    }
+
+    /// decodeLZ into a caller owned array. Its capacity is kept, so once it has
+    /// grown to maxOutput no frame allocates. Returns false on a broken payload.
+    static func decodeLZ(_ input: UnsafeBufferPointer<UInt8>, into output: inout [UInt8], maxOutput: Int) -> Bool {
+        output.removeAll(keepingCapacity: true)
+        var ip = 0
+
+        func readLength(_ base: Int) -> Int? {
+            guard base == 15 else { return base }
+            var length = base
+            while true {
+                guard ip < input.count else { return nil }
+                let byte = input[ip]
+                ip += 1
+                length += Int(byte)
+                if byte != 255 { return length }
+            }
+        }
+
+        while ip < input.count {
+            let token = input[ip]
+            ip += 1
+
+            guard let literalLength = readLength(Int(token >> 4)),
+                  ip + literalLength <= input.count,
+                  output.count + literalLength <= maxOutput else { return false }
+            output.append(contentsOf: UnsafeBufferPointer(rebasing: input[ip..<(ip + literalLength)]))
+            ip += literalLength
+
+            if ip >= input.count { break }  // Trailing literals
+
+            guard ip + 2 <= input.count else { return false }
+            let offset = Int(input[ip]) | Int(input[ip + 1]) << 8
+            ip += 2
+
+            guard let length = readLength(Int(token & 0x0F)) else { return false }
+            let matchLength = length + lzMinMatch
+            guard offset > 0, offset <= output.count, output.count + matchLength <= maxOutput else { return false }
+
+            // Byte by byte, matches may overlap
+            let start = output.count - offset
+            for n in 0..<matchLength {
+                output.append(output[start + n])
+            }
+        }
+
+        return true
     }
 }
@@ -15,6 +15,731 @@ enum ThermalProtocol {
     static let headerSize = frameWidth * headerRows * bytesPerPixel     // 320 bytes
     static let imageSize = frameWidth * imageHeight * bytesPerPixel     // 9,920 bytes
 
+    // MARK: - Frame Stream Formats
+    static let streamFormatRaw: UInt8 = 0x01     // Raw 10,240 byte frames, no delimiter
+    static let streamFormatFramed: UInt8 = 0x02  // Each frame preceded by a StreamHeader
+
+    static let streamHeaderMinSize = StreamHeaderLayout.stats   // Fields before the statistics
+    static let streamUTCOffset = StreamHeaderLayout.utcUs
+
+    // MARK: - UDP Frame Stream
+    static let udpChunkHeaderSize = UdpChunkHeaderLayout.size
+    static let udpChunkData = 1456                    // Frame bytes per chunk
+    static let udpFrameMax = tcpFrameSize + 256       // v2 header and raw payload, with room for header growth
+    static let udpHello = Data(udpHelloMagic)         // Joins, or keeps the viewer registered
+    static let udpBye = Data(udpByeMagic)
+    static let udpHelloInterval: TimeInterval = 1.0   // Device drops viewers silent for 5 s
+
+    // MARK: - Protocol Schema
+    /// From protocolSchema.json of the firmware, run genProtocol.js of Node_Thermal_TCP to update
+    // BEGIN generated protocol schema
+    static let streamMagic: [UInt8] = [0x53, 0x58, 0x46, 0x52]  // "SXFR"
+    static let udpChunkMagic: [UInt8] = [0x53, 0x58, 0x55, 0x43]  // "SXUC"
+    static let udpHelloMagic: [UInt8] = [0x53, 0x58, 0x48, 0x49]  // "SXHI"
+    static let udpByeMagic: [UInt8] = [0x53, 0x58, 0x42, 0x59]  // "SXBY"
+    static let streamEncodingRaw16: UInt8 = 0x00  // 80x64 uint16 pixels as captured
+    static let streamEncodingDelta: UInt8 = 0x01  // Zigzag varint residuals with zero runs
+    static let streamEncodingDeltaLZ: UInt8 = 0x02  // Delta residuals, LZ compressed
+    static let streamEncodingPack12: UInt8 = 0x03  // Image bit packed to 12 bits per pixel
+    static let streamEncodingPack14: UInt8 = 0x04  // Image bit packed to 14 bits per pixel
+    static let streamEncodingPack8: UInt8 = 0x05  // Image bit packed to 8 bits, lossy beyond a 255 count span
+    static let streamFlagKeyframe: UInt8 = 0x01  // Payload does not depend on the previous frame
+    static let streamFlagStats: UInt8 = 0x02  // Header carries the frame statistics
+    static let streamFlagCRC32: UInt8 = 0x04  // payloadCrc holds the CRC32 of the payload
+    static let streamFlagShaped: UInt8 = 0x08  // Payload is the image window of shape
+    static let streamFlagBlobs: UInt8 = 0x10  // Header ends with the used part of the blob record
+    static let streamFlagUTC: UInt8 = 0x20  // utcUs holds the capture time in UTC
+
+    /// Command words, the 4 letters big endian as PROTO_CMD_* of the firmware
+    static let commandWREG: UInt32 = 0x57524547  // Write a register
+    static let commandRREG: UInt32 = 0x52524547  // Read a register
+    static let commandRRSE: UInt32 = 0x52525345  // Read a register sequence
+    static let commandBRWR: UInt32 = 0x42525752  // Binary batch register read and write
+    static let commandWSID: UInt32 = 0x57534944  // Set the Wi-Fi SSID
+    static let commandWPWD: UInt32 = 0x57505744  // Set the Wi-Fi password
+    static let commandWMDE: UInt32 = 0x574D4445  // Set the Wi-Fi mode
+    static let commandPOLL: UInt32 = 0x504F4C4C  // Set the quadrant polling rate
+    static let commandSTAT: UInt32 = 0x53544154  // Read stream statistics
+    static let commandSFMT: UInt32 = 0x53464D54  // Select the frame stream format
+    static let commandSHAP: UInt32 = 0x53484150  // Shape the frame stream
+    static let commandSCRC: UInt32 = 0x53435243  // Select the frame integrity check
+    static let commandCAPS: UInt32 = 0x43415053  // Read capture interrupt statistics
+    static let commandLATS: UInt32 = 0x4C415453  // Read pipeline latency
+    static let commandROIW: UInt32 = 0x524F4957  // Define a region of interest
+    static let commandROIR: UInt32 = 0x524F4952  // Read region of interest statistics
+    static let commandSUBS: UInt32 = 0x53554253  // Subscribe to register updates
+    static let commandSUBV: UInt32 = 0x53554256  // Register update push
+    static let commandRECC: UInt32 = 0x52454343  // Frame recorder control
+    static let commandRECD: UInt32 = 0x52454344  // Download a recorded clip
+    static let commandSAVE: UInt32 = 0x53415645  // Commit the configuration
+    static let commandBPIX: UInt32 = 0x42504958  // Bad pixel map
+    static let commandBNCH: UInt32 = 0x424E4348  // Run a microbenchmark
+    static let commandSYST: UInt32 = 0x53595354  // Read system telemetry
+    static let commandBLOB: UInt32 = 0x424C4F42  // Hot spot blob tracking
+    static let commandRULE: UInt32 = 0x52554C45  // Alarm rules
+    static let commandALRM: UInt32 = 0x414C524D  // Alarm event push
+    static let commandESPN: UInt32 = 0x4553504E  // ESP-NOW peer table
+    static let commandCORR: UInt32 = 0x434F5252  // Per-pixel correction map
+
+    /// Command packet: prefix, length, command, data and checksum. The length and
+    /// checksum are ASCII hex, the length counts the command, data and checksum, the
+    /// checksum is the 16 bit byte sum of the length, command and data
+    static let packetPrefix: [UInt8] = [0x20, 0x20, 0x20, 0x23]  // "   #"
+    static let packetLen = 4  // Offset of the length, after the prefix
+    static let packetLenDigits = 4
+    static let packetCmd = 8
+    static let packetData = 12
+    static let packetSumDigits = 4
+    static let packetMinLen = 8  // Length of a packet without data
+    static let packetMaxLen = 15000
+    static let packetNoSum: [UInt8] = [0x58, 0x58, 0x58, 0x58]  // "XXXX", not checked
+
+    /// ASCII hex straight from the bytes, nil on a bad digit
+    static func hexValue<Bytes: RandomAccessCollection>(_ bytes: Bytes, at offset: Int, digits: Int) -> Int?
+        where Bytes.Element == UInt8, Bytes.Index == Int {
+        var value = 0
+        for i in offset..<(offset + digits) {
+            let c = bytes[bytes.startIndex + i]
+            switch c {
+            case 0x30...0x39: value = value << 4 | Int(c - 0x30)
+            case 0x41...0x46: value = value << 4 | Int(c - 0x37)
+            case 0x61...0x66: value = value << 4 | Int(c - 0x57)
+            default: return nil
+            }
+        }
+        return value
+    }
+
+    /// value as digits upper case ASCII hex digits
+    static func appendHex(_ value: Int, digits: Int, to bytes: inout [UInt8]) {
+        for shift in stride(from: (digits - 1) * 4, through: 0, by: -4) {
+            bytes.append(hexDigits[(value >> shift) & 0x0F])
+        }
+    }
+
+    private static let hexDigits: [UInt8] = Array("0123456789ABCDEF".utf8)
+
+    /// Packet checksum, the 16 bit byte sum
+    static func packetSum<Bytes: Sequence>(_ bytes: Bytes) -> UInt16 where Bytes.Element == UInt8 {
+        bytes.reduce(UInt16(0)) { $0 &+ UInt16($1) }
+    }
+
+    /// Packet of command with binary data, with the checksum or packetNoSum
+    static func buildPacket<Payload: Collection>(command: UInt32, data: Payload, withSum: Bool = false) -> Data
+        where Payload.Element == UInt8 {
+        var packet = packetPrefix
+        packet.reserveCapacity(packetData + data.count + packetSumDigits)
+        appendHex(data.count + packetMinLen, digits: packetLenDigits, to: &packet)
+        for shift in stride(from: 24, through: 0, by: -8) {
+            packet.append(UInt8(truncatingIfNeeded: command >> UInt32(shift)))
+        }
+        packet.append(contentsOf: data)
+        if withSum {
+            appendHex(Int(packetSum(packet[packetLen...])), digits: packetSumDigits, to: &packet)
+        } else {
+            packet.append(contentsOf: packetNoSum)
+        }
+        return Data(packet)
+    }
+
+    /// Packet of command with ASCII data
+    static func buildPacket(command: UInt32, data: String = "", withSum: Bool = false) -> Data {
+        buildPacket(command: command, data: Array(data.utf8), withSum: withSum)
+    }
+
+    /// A complete packet in a receive buffer, as offsets from the start of the bytes
+    struct Packet {
+        let command: UInt32
+        let data: Range<Int>  // Excluding command and checksum
+        let end: Int
+        let sumSent: Bool
+        let sumValid: Bool  // The checksum matches, or was not sent
+    }
+
+    enum PacketDecode {
+        case packet(Packet)
+        /// The bytes are the start of a packet, wait for more
+        case incomplete
+        /// No packet starts here
+        case invalid
+    }
+
+    /// Offset of the next packet prefix from offset on, nil if there is none
+    static func findPacket<Bytes: RandomAccessCollection>(_ bytes: Bytes, from offset: Int = 0) -> Int?
+        where Bytes.Element == UInt8, Bytes.Index == Int {
+        var i = offset
+        while i + packetLen <= bytes.count {
+            if matches(bytes, at: i, packetPrefix) {
+                return i
+            }
+            i += 1
+        }
+        return nil
+    }
+
+    /// Decode the packet at offset in place
+    static func decodePacket<Bytes: RandomAccessCollection>(_ bytes: Bytes, at offset: Int) -> PacketDecode
+        where Bytes.Element == UInt8, Bytes.Index == Int {
+        guard matches(bytes, at: offset, packetPrefix) else { return .invalid }
+        guard bytes.count - offset >= packetData else { return .incomplete }
+        guard let length = hexValue(bytes, at: offset + packetLen, digits: packetLenDigits),
+              length >= packetMinLen, length <= packetMaxLen else {
+            return .invalid
+        }
+
+        let end = offset + packetCmd + length
+        guard end <= bytes.count else { return .incomplete }
+
+        let base = bytes.startIndex
+        let sumAt = end - packetSumDigits
+        var command: UInt32 = 0
+        for k in 0..<4 {
+            command = command << 8 | UInt32(bytes[base + offset + packetCmd + k])
+        }
+        let sumSent = !matches(bytes, at: sumAt, packetNoSum)
+        let sum = hexValue(bytes, at: sumAt, digits: packetSumDigits)
+        let sumValid = !sumSent || sum == Int(packetSum(bytes[(base + offset + packetLen)..<(base + sumAt)]))
+        return .packet(Packet(command: command, data: (offset + packetData)..<sumAt, end: end,
+                              sumSent: sumSent, sumValid: sumValid))
+    }
+
+    /// The bytes at offset, as far as there are any, are the start of pattern
+    private static func matches<Bytes: RandomAccessCollection>(_ bytes: Bytes, at offset: Int, _ pattern: [UInt8]) -> Bool
+        where Bytes.Element == UInt8, Bytes.Index == Int {
+        let base = bytes.startIndex + offset
+        for k in 0..<Swift.max(0, Swift.min(pattern.count, bytes.count - offset)) where bytes[base + k] != pattern[k] {
+            return false
+        }
+        return true
+    }
+
+    /// Little endian field at any alignment
+    static func readLE<Bytes: RandomAccessCollection, Value: FixedWidthInteger>(_ bytes: Bytes, _ offset: Int) -> Value
+        where Bytes.Element == UInt8, Bytes.Index == Int {
+        let base = bytes.startIndex + offset
+        var value: Value = 0
+        for i in (0..<(Value.bitWidth / 8)).reversed() {
+            value = value << 8 | Value(bytes[base + i])
+        }
+        return value
+    }
+
+    static func writeLE<Bytes: MutableCollection, Value: FixedWidthInteger>(_ value: Value, to bytes: inout Bytes, _ offset: Int)
+        where Bytes.Element == UInt8, Bytes.Index == Int {
+        let base = bytes.startIndex + offset
+        for i in 0..<(Value.bitWidth / 8) {
+            bytes[base + i] = UInt8(truncatingIfNeeded: value >> (i * 8))
+        }
+    }
+
+    /// Byte offset of each field of frameStats, size without a variable part
+    enum FrameStatsLayout {
+        static let min = 0
+        static let max = 2
+        static let mean = 4
+        static let p50 = 6
+        static let p95 = 8
+        static let p99 = 10
+        static let bucketLo = 12
+        static let bucketShift = 14
+        static let scale = 15
+        static let bucket = 16
+        static let size = 48
+    }
+
+    /// Byte offset of each field of streamShape, size without a variable part
+    enum StreamShapeLayout {
+        static let x = 0
+        static let y = 1
+        static let width = 2
+        static let height = 3
+        static let decimation = 4
+        static let rateDiv = 5
+        static let outWidth = 6
+        static let outHeight = 7
+        static let size = 8
+    }
+
+    /// Byte offset of each field of blobEntry, size without a variable part
+    enum BlobEntryLayout {
+        static let id = 0
+        static let flags = 1
+        static let area = 2
+        static let peak = 4
+        static let peakX = 6
+        static let peakY = 7
+        static let cx = 8
+        static let cy = 10
+        static let size = 12
+    }
+
+    /// Byte offset of each field of blobRecord, size without a variable part
+    enum BlobRecordLayout {
+        static let seq = 0
+        static let count = 4
+        static let flags = 5
+        static let blobs = 6
+        static let size = 6
+    }
+
+    /// Byte offset of each field of streamHeader, size without a variable part
+    enum StreamHeaderLayout {
+        static let magic = 0
+        static let version = 4
+        static let encoding = 5
+        static let headerLen = 6
+        static let seq = 8
+        static let timestampUs = 12
+        static let payloadLen = 20
+        static let flags = 24
+        static let reserved = 25
+        static let stats = 28
+        static let payloadCrc = 76
+        static let shape = 80
+        static let utcUs = 88
+        static let blobs = 96
+        static let size = 96
+    }
+
+    /// Byte offset of each field of udpChunkHeader, size without a variable part
+    enum UdpChunkHeaderLayout {
+        static let magic = 0
+        static let frameId = 4
+        static let chunkIdx = 8
+        static let chunkCount = 10
+        static let frameLen = 12
+        static let size = 16
+    }
+
+    /// Byte offset of each field of mqttBatchHeader, size without a variable part
+    enum MqttBatchHeaderLayout {
+        static let version = 0
+        static let samples = 1
+        static let periodMs = 2
+        static let uptimeMs = 4
+        static let seq = 8
+        static let utcMs = 12
+        static let size = 20
+    }
+
+    /// Byte offset of each field of mqttSample, size without a variable part
+    enum MqttSampleLayout {
+        static let offsetMs = 0
+        static let count = 2
+        static let size = 3
+    }
+
+    /// Byte offset of each field of mqttRoiEntry, size without a variable part
+    enum MqttRoiEntryLayout {
+        static let roi = 0
+        static let min = 1
+        static let max = 3
+        static let mean = 5
+        static let percentile = 7
+        static let size = 9
+    }
+
+    /// Byte offset of each field of mqttEventEntry, size without a variable part
+    enum MqttEventEntryLayout {
+        static let rule = 0
+        static let raised = 1
+        static let value = 2
+        static let active = 4
+        static let seq = 5
+        static let size = 9
+    }
+
+    /// frameStats in place, the fields are read when used
+    struct FrameStatsView<Bytes: RandomAccessCollection> where Bytes.Element == UInt8, Bytes.Index == Int {
+        var bytes: Bytes
+        let offset: Int
+
+        init(_ bytes: Bytes, at offset: Int = 0) {
+            self.bytes = bytes
+            self.offset = offset
+        }
+
+        var min: UInt16 { ThermalProtocol.readLE(bytes, offset + FrameStatsLayout.min) }
+        var max: UInt16 { ThermalProtocol.readLE(bytes, offset + FrameStatsLayout.max) }
+        var mean: UInt16 { ThermalProtocol.readLE(bytes, offset + FrameStatsLayout.mean) }
+        var p50: UInt16 { ThermalProtocol.readLE(bytes, offset + FrameStatsLayout.p50) }
+        var p95: UInt16 { ThermalProtocol.readLE(bytes, offset + FrameStatsLayout.p95) }
+        var p99: UInt16 { ThermalProtocol.readLE(bytes, offset + FrameStatsLayout.p99) }
+        var bucketLo: UInt16 { ThermalProtocol.readLE(bytes, offset + FrameStatsLayout.bucketLo) }
+        var bucketShift: UInt8 { ThermalProtocol.readLE(bytes, offset + FrameStatsLayout.bucketShift) }
+        var scale: UInt8 { ThermalProtocol.readLE(bytes, offset + FrameStatsLayout.scale) }
+        func bucket(_ i: Int) -> UInt16 { ThermalProtocol.readLE(bytes, offset + FrameStatsLayout.bucket + i * 2) }
+
+        mutating func setMin(_ value: UInt16) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + FrameStatsLayout.min)
+        }
+        mutating func setMax(_ value: UInt16) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + FrameStatsLayout.max)
+        }
+        mutating func setMean(_ value: UInt16) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + FrameStatsLayout.mean)
+        }
+        mutating func setP50(_ value: UInt16) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + FrameStatsLayout.p50)
+        }
+        mutating func setP95(_ value: UInt16) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + FrameStatsLayout.p95)
+        }
+        mutating func setP99(_ value: UInt16) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + FrameStatsLayout.p99)
+        }
+        mutating func setBucketLo(_ value: UInt16) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + FrameStatsLayout.bucketLo)
+        }
+        mutating func setBucketShift(_ value: UInt8) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + FrameStatsLayout.bucketShift)
+        }
+        mutating func setScale(_ value: UInt8) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + FrameStatsLayout.scale)
+        }
+        mutating func setBucket(_ i: Int, _ value: UInt16) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + FrameStatsLayout.bucket + i * 2)
+        }
+    }
+
+    /// streamShape in place, the fields are read when used
+    struct StreamShapeView<Bytes: RandomAccessCollection> where Bytes.Element == UInt8, Bytes.Index == Int {
+        var bytes: Bytes
+        let offset: Int
+
+        init(_ bytes: Bytes, at offset: Int = 0) {
+            self.bytes = bytes
+            self.offset = offset
+        }
+
+        var x: UInt8 { ThermalProtocol.readLE(bytes, offset + StreamShapeLayout.x) }
+        var y: UInt8 { ThermalProtocol.readLE(bytes, offset + StreamShapeLayout.y) }
+        var width: UInt8 { ThermalProtocol.readLE(bytes, offset + StreamShapeLayout.width) }
+        var height: UInt8 { ThermalProtocol.readLE(bytes, offset + StreamShapeLayout.height) }
+        var decimation: UInt8 { ThermalProtocol.readLE(bytes, offset + StreamShapeLayout.decimation) }
+        var rateDiv: UInt8 { ThermalProtocol.readLE(bytes, offset + StreamShapeLayout.rateDiv) }
+        var outWidth: UInt8 { ThermalProtocol.readLE(bytes, offset + StreamShapeLayout.outWidth) }
+        var outHeight: UInt8 { ThermalProtocol.readLE(bytes, offset + StreamShapeLayout.outHeight) }
+
+        mutating func setX(_ value: UInt8) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + StreamShapeLayout.x)
+        }
+        mutating func setY(_ value: UInt8) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + StreamShapeLayout.y)
+        }
+        mutating func setWidth(_ value: UInt8) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + StreamShapeLayout.width)
+        }
+        mutating func setHeight(_ value: UInt8) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + StreamShapeLayout.height)
+        }
+        mutating func setDecimation(_ value: UInt8) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + StreamShapeLayout.decimation)
+        }
+        mutating func setRateDiv(_ value: UInt8) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + StreamShapeLayout.rateDiv)
+        }
+        mutating func setOutWidth(_ value: UInt8) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + StreamShapeLayout.outWidth)
+        }
+        mutating func setOutHeight(_ value: UInt8) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + StreamShapeLayout.outHeight)
+        }
+    }
+
+    /// blobEntry in place, the fields are read when used
+    struct BlobEntryView<Bytes: RandomAccessCollection> where Bytes.Element == UInt8, Bytes.Index == Int {
+        var bytes: Bytes
+        let offset: Int
+
+        init(_ bytes: Bytes, at offset: Int = 0) {
+            self.bytes = bytes
+            self.offset = offset
+        }
+
+        var id: UInt8 { ThermalProtocol.readLE(bytes, offset + BlobEntryLayout.id) }
+        var flags: UInt8 { ThermalProtocol.readLE(bytes, offset + BlobEntryLayout.flags) }
+        var area: UInt16 { ThermalProtocol.readLE(bytes, offset + BlobEntryLayout.area) }
+        var peak: UInt16 { ThermalProtocol.readLE(bytes, offset + BlobEntryLayout.peak) }
+        var peakX: UInt8 { ThermalProtocol.readLE(bytes, offset + BlobEntryLayout.peakX) }
+        var peakY: UInt8 { ThermalProtocol.readLE(bytes, offset + BlobEntryLayout.peakY) }
+        var cx: UInt16 { ThermalProtocol.readLE(bytes, offset + BlobEntryLayout.cx) }
+        var cy: UInt16 { ThermalProtocol.readLE(bytes, offset + BlobEntryLayout.cy) }
+
+        mutating func setId(_ value: UInt8) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + BlobEntryLayout.id)
+        }
+        mutating func setFlags(_ value: UInt8) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + BlobEntryLayout.flags)
+        }
+        mutating func setArea(_ value: UInt16) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + BlobEntryLayout.area)
+        }
+        mutating func setPeak(_ value: UInt16) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + BlobEntryLayout.peak)
+        }
+        mutating func setPeakX(_ value: UInt8) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + BlobEntryLayout.peakX)
+        }
+        mutating func setPeakY(_ value: UInt8) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + BlobEntryLayout.peakY)
+        }
+        mutating func setCx(_ value: UInt16) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + BlobEntryLayout.cx)
+        }
+        mutating func setCy(_ value: UInt16) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + BlobEntryLayout.cy)
+        }
+    }
+
+    /// blobRecord in place, the fields are read when used
+    struct BlobRecordView<Bytes: RandomAccessCollection> where Bytes.Element == UInt8, Bytes.Index == Int {
+        var bytes: Bytes
+        let offset: Int
+
+        init(_ bytes: Bytes, at offset: Int = 0) {
+            self.bytes = bytes
+            self.offset = offset
+        }
+
+        var seq: UInt32 { ThermalProtocol.readLE(bytes, offset + BlobRecordLayout.seq) }
+        var count: UInt8 { ThermalProtocol.readLE(bytes, offset + BlobRecordLayout.count) }
+        var flags: UInt8 { ThermalProtocol.readLE(bytes, offset + BlobRecordLayout.flags) }
+        func blobs(_ i: Int = 0) -> BlobEntryView<Bytes> {
+            BlobEntryView(bytes, at: offset + BlobRecordLayout.blobs + i * BlobEntryLayout.size)
+        }
+
+        mutating func setSeq(_ value: UInt32) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + BlobRecordLayout.seq)
+        }
+        mutating func setCount(_ value: UInt8) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + BlobRecordLayout.count)
+        }
+        mutating func setFlags(_ value: UInt8) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + BlobRecordLayout.flags)
+        }
+    }
+
+    /// streamHeader in place, the fields are read when used
+    struct StreamHeaderView<Bytes: RandomAccessCollection> where Bytes.Element == UInt8, Bytes.Index == Int {
+        var bytes: Bytes
+        let offset: Int
+
+        init(_ bytes: Bytes, at offset: Int = 0) {
+            self.bytes = bytes
+            self.offset = offset
+        }
+
+        var magic: UInt32 { ThermalProtocol.readLE(bytes, offset + StreamHeaderLayout.magic) }
+        var version: UInt8 { ThermalProtocol.readLE(bytes, offset + StreamHeaderLayout.version) }
+        var encoding: UInt8 { ThermalProtocol.readLE(bytes, offset + StreamHeaderLayout.encoding) }
+        var headerLen: UInt16 { ThermalProtocol.readLE(bytes, offset + StreamHeaderLayout.headerLen) }
+        var seq: UInt32 { ThermalProtocol.readLE(bytes, offset + StreamHeaderLayout.seq) }
+        var timestampUs: UInt64 { ThermalProtocol.readLE(bytes, offset + StreamHeaderLayout.timestampUs) }
+        var payloadLen: UInt32 { ThermalProtocol.readLE(bytes, offset + StreamHeaderLayout.payloadLen) }
+        var flags: UInt8 { ThermalProtocol.readLE(bytes, offset + StreamHeaderLayout.flags) }
+        func reserved(_ i: Int) -> UInt8 { ThermalProtocol.readLE(bytes, offset + StreamHeaderLayout.reserved + i * 1) }
+        var stats: FrameStatsView<Bytes> { FrameStatsView(bytes, at: offset + StreamHeaderLayout.stats) }
+        var payloadCrc: UInt32 { ThermalProtocol.readLE(bytes, offset + StreamHeaderLayout.payloadCrc) }
+        var shape: StreamShapeView<Bytes> { StreamShapeView(bytes, at: offset + StreamHeaderLayout.shape) }
+        var utcUs: UInt64 { ThermalProtocol.readLE(bytes, offset + StreamHeaderLayout.utcUs) }
+        func blobs(_ i: Int = 0) -> BlobRecordView<Bytes> {
+            BlobRecordView(bytes, at: offset + StreamHeaderLayout.blobs + i * BlobRecordLayout.size)
+        }
+
+        mutating func setMagic(_ value: UInt32) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + StreamHeaderLayout.magic)
+        }
+        mutating func setVersion(_ value: UInt8) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + StreamHeaderLayout.version)
+        }
+        mutating func setEncoding(_ value: UInt8) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + StreamHeaderLayout.encoding)
+        }
+        mutating func setHeaderLen(_ value: UInt16) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + StreamHeaderLayout.headerLen)
+        }
+        mutating func setSeq(_ value: UInt32) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + StreamHeaderLayout.seq)
+        }
+        mutating func setTimestampUs(_ value: UInt64) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + StreamHeaderLayout.timestampUs)
+        }
+        mutating func setPayloadLen(_ value: UInt32) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + StreamHeaderLayout.payloadLen)
+        }
+        mutating func setFlags(_ value: UInt8) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + StreamHeaderLayout.flags)
+        }
+        mutating func setReserved(_ i: Int, _ value: UInt8) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + StreamHeaderLayout.reserved + i * 1)
+        }
+        mutating func setPayloadCrc(_ value: UInt32) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + StreamHeaderLayout.payloadCrc)
+        }
+        mutating func setUtcUs(_ value: UInt64) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + StreamHeaderLayout.utcUs)
+        }
+    }
+
+    /// udpChunkHeader in place, the fields are read when used
+    struct UdpChunkHeaderView<Bytes: RandomAccessCollection> where Bytes.Element == UInt8, Bytes.Index == Int {
+        var bytes: Bytes
+        let offset: Int
+
+        init(_ bytes: Bytes, at offset: Int = 0) {
+            self.bytes = bytes
+            self.offset = offset
+        }
+
+        var magic: UInt32 { ThermalProtocol.readLE(bytes, offset + UdpChunkHeaderLayout.magic) }
+        var frameId: UInt32 { ThermalProtocol.readLE(bytes, offset + UdpChunkHeaderLayout.frameId) }
+        var chunkIdx: UInt16 { ThermalProtocol.readLE(bytes, offset + UdpChunkHeaderLayout.chunkIdx) }
+        var chunkCount: UInt16 { ThermalProtocol.readLE(bytes, offset + UdpChunkHeaderLayout.chunkCount) }
+        var frameLen: UInt32 { ThermalProtocol.readLE(bytes, offset + UdpChunkHeaderLayout.frameLen) }
+
+        mutating func setMagic(_ value: UInt32) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + UdpChunkHeaderLayout.magic)
+        }
+        mutating func setFrameId(_ value: UInt32) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + UdpChunkHeaderLayout.frameId)
+        }
+        mutating func setChunkIdx(_ value: UInt16) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + UdpChunkHeaderLayout.chunkIdx)
+        }
+        mutating func setChunkCount(_ value: UInt16) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + UdpChunkHeaderLayout.chunkCount)
+        }
+        mutating func setFrameLen(_ value: UInt32) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + UdpChunkHeaderLayout.frameLen)
+        }
+    }
+
+    /// mqttBatchHeader in place, the fields are read when used
+    struct MqttBatchHeaderView<Bytes: RandomAccessCollection> where Bytes.Element == UInt8, Bytes.Index == Int {
+        var bytes: Bytes
+        let offset: Int
+
+        init(_ bytes: Bytes, at offset: Int = 0) {
+            self.bytes = bytes
+            self.offset = offset
+        }
+
+        var version: UInt8 { ThermalProtocol.readLE(bytes, offset + MqttBatchHeaderLayout.version) }
+        var samples: UInt8 { ThermalProtocol.readLE(bytes, offset + MqttBatchHeaderLayout.samples) }
+        var periodMs: UInt16 { ThermalProtocol.readLE(bytes, offset + MqttBatchHeaderLayout.periodMs) }
+        var uptimeMs: UInt32 { ThermalProtocol.readLE(bytes, offset + MqttBatchHeaderLayout.uptimeMs) }
+        var seq: UInt32 { ThermalProtocol.readLE(bytes, offset + MqttBatchHeaderLayout.seq) }
+        var utcMs: UInt64 { ThermalProtocol.readLE(bytes, offset + MqttBatchHeaderLayout.utcMs) }
+
+        mutating func setVersion(_ value: UInt8) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + MqttBatchHeaderLayout.version)
+        }
+        mutating func setSamples(_ value: UInt8) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + MqttBatchHeaderLayout.samples)
+        }
+        mutating func setPeriodMs(_ value: UInt16) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + MqttBatchHeaderLayout.periodMs)
+        }
+        mutating func setUptimeMs(_ value: UInt32) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + MqttBatchHeaderLayout.uptimeMs)
+        }
+        mutating func setSeq(_ value: UInt32) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + MqttBatchHeaderLayout.seq)
+        }
+        mutating func setUtcMs(_ value: UInt64) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + MqttBatchHeaderLayout.utcMs)
+        }
+    }
+
+    /// mqttSample in place, the fields are read when used
+    struct MqttSampleView<Bytes: RandomAccessCollection> where Bytes.Element == UInt8, Bytes.Index == Int {
+        var bytes: Bytes
+        let offset: Int
+
+        init(_ bytes: Bytes, at offset: Int = 0) {
+            self.bytes = bytes
+            self.offset = offset
+        }
+
+        var offsetMs: UInt16 { ThermalProtocol.readLE(bytes, offset + MqttSampleLayout.offsetMs) }
+        var count: UInt8 { ThermalProtocol.readLE(bytes, offset + MqttSampleLayout.count) }
+
+        mutating func setOffsetMs(_ value: UInt16) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + MqttSampleLayout.offsetMs)
+        }
+        mutating func setCount(_ value: UInt8) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + MqttSampleLayout.count)
+        }
+    }
+
+    /// mqttRoiEntry in place, the fields are read when used
+    struct MqttRoiEntryView<Bytes: RandomAccessCollection> where Bytes.Element == UInt8, Bytes.Index == Int {
+        var bytes: Bytes
+        let offset: Int
+
+        init(_ bytes: Bytes, at offset: Int = 0) {
+            self.bytes = bytes
+            self.offset = offset
+        }
+
+        var roi: UInt8 { ThermalProtocol.readLE(bytes, offset + MqttRoiEntryLayout.roi) }
+        var min: UInt16 { ThermalProtocol.readLE(bytes, offset + MqttRoiEntryLayout.min) }
+        var max: UInt16 { ThermalProtocol.readLE(bytes, offset + MqttRoiEntryLayout.max) }
+        var mean: UInt16 { ThermalProtocol.readLE(bytes, offset + MqttRoiEntryLayout.mean) }
+        var percentile: UInt16 { ThermalProtocol.readLE(bytes, offset + MqttRoiEntryLayout.percentile) }
+
+        mutating func setRoi(_ value: UInt8) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + MqttRoiEntryLayout.roi)
+        }
+        mutating func setMin(_ value: UInt16) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + MqttRoiEntryLayout.min)
+        }
+        mutating func setMax(_ value: UInt16) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + MqttRoiEntryLayout.max)
+        }
+        mutating func setMean(_ value: UInt16) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + MqttRoiEntryLayout.mean)
+        }
+        mutating func setPercentile(_ value: UInt16) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + MqttRoiEntryLayout.percentile)
+        }
+    }
+
+    /// mqttEventEntry in place, the fields are read when used
+    struct MqttEventEntryView<Bytes: RandomAccessCollection> where Bytes.Element == UInt8, Bytes.Index == Int {
+        var bytes: Bytes
+        let offset: Int
+
+        init(_ bytes: Bytes, at offset: Int = 0) {
+            self.bytes = bytes
+            self.offset = offset
+        }
+
+        var rule: UInt8 { ThermalProtocol.readLE(bytes, offset + MqttEventEntryLayout.rule) }
+        var raised: UInt8 { ThermalProtocol.readLE(bytes, offset + MqttEventEntryLayout.raised) }
+        var value: UInt16 { ThermalProtocol.readLE(bytes, offset + MqttEventEntryLayout.value) }
+        var active: UInt8 { ThermalProtocol.readLE(bytes, offset + MqttEventEntryLayout.active) }
+        var seq: UInt32 { ThermalProtocol.readLE(bytes, offset + MqttEventEntryLayout.seq) }
+
+        mutating func setRule(_ value: UInt8) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + MqttEventEntryLayout.rule)
+        }
+        mutating func setRaised(_ value: UInt8) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + MqttEventEntryLayout.raised)
+        }
+        mutating func setValue(_ value: UInt16) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + MqttEventEntryLayout.value)
+        }
+        mutating func setActive(_ value: UInt8) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + MqttEventEntryLayout.active)
+        }
+        mutating func setSeq(_ value: UInt32) where Bytes: MutableCollection {
+            ThermalProtocol.writeLE(value, to: &bytes, offset + MqttEventEntryLayout.seq)
+        }
+    }
+    // END generated protocol schema
+
     // MARK: - Quadrant Register Addresses
     static let regXSplit: UInt8 = 0xC0
     static let regYSplit: UInt8 = 0xC1
@@ -27,6 +752,12 @@ enum ThermalProtocol {
     static let regDMax: UInt8 = 0xC8
     static let regDCenter: UInt8 = 0xC9
 
+    // MARK: - Binary Register Batches
+    static let brwrOpRead: UInt8 = 0x00
+    static let brwrOpWrite: UInt8 = 0x01
+    static let brwrOpSkipped: UInt8 = 0x80  // Set in a response op the device did not know
+    static let brwrMaxOps = 24
+
     static let quadrantRegisters: [UInt8] = [
         regXSplit, regYSplit,
         regAMax, regACenter,
@@ -37,135 +768,246 @@ enum ThermalProtocol {
 
     // MARK: - Packet Building
 
-    /// Build a protocol packet with format: [3 spaces][#][4-char hex length][command][data][XXXX]
-    static func buildPacket(command: String, data: String = "") -> Data {
-        let payload = command + data
-        let length = payload.count + 4  // +4 for CRC placeholder
-        let lengthHex = String(format: "%04X", length)
-        let packet = "   #\(lengthHex)\(payload)XXXX"
-        return Data(packet.utf8)
-    }
-
     /// Build WREG command to write a value to a register
     static func buildWREG(address: UInt8, value: UInt8) -> Data {
         let addrHex = String(format: "%02X", address)
         let valueHex = String(format: "%02X", value)
-        return buildPacket(command: "WREG", data: addrHex + valueHex)
+        return buildPacket(command: commandWREG, data: addrHex + valueHex)
     }
 
     /// Build WREG command to write a 16-bit value to a register
     static func buildWREG16(address: UInt8, value: UInt16) -> Data {
         let addrHex = String(format: "%02X", address)
         let valueHex = String(format: "%04X", value)
-        return buildPacket(command: "WREG", data: addrHex + valueHex)
+        return buildPacket(command: commandWREG, data: addrHex + valueHex)
     }
 
     /// Build RREG command to read a register
     static func buildRREG(address: UInt8) -> Data {
         let addrHex = String(format: "%02X", address)
-        return buildPacket(command: "RREG", data: addrHex)
+        return buildPacket(command: commandRREG, data: addrHex)
     }
 
     /// Build RRSE command to read multiple registers
     static func buildRRSE(addresses: [UInt8]) -> Data {
         let addrData = addresses.map { String(format: "%02X", $0) }.joined()
-        return buildPacket(command: "RRSE", data: addrData + "FF")
+        return buildPacket(command: commandRRSE, data: addrData + "FF")
     }
 
     /// Build POLL command to set polling frequency (0-25 Hz)
     static func buildPOLL(frequency: Int) -> Data {
         let clampedFreq = max(0, min(25, frequency))
         let freqHex = String(format: "%02X", clampedFreq)
-        return buildPacket(command: "POLL", data: freqHex)
+        return buildPacket(command: commandPOLL, data: freqHex)
+    }
+
+    /// Build SFMT command to select the frame stream format
+    static func buildSFMT(format: UInt8, encoding: UInt8 = streamEncodingRaw16) -> Data {
+        return buildPacket(command: commandSFMT, data: String(format: "%02X%02X", format, encoding))
+    }
+
+    /// Build SUBS command, the device pushes the registers as SUBV packets.
+    /// No registers ends the subscription.
+    static func buildSUBS(intervalMs: Int, threshold: UInt16 = 0, addresses: [UInt8]) -> Data {
+        let interval = String(format: "%04X", max(0, min(0xFFFF, intervalMs)))
+        let count = String(format: "%02X", addresses.count)
+        let addrData = addresses.map { String(format: "%02X", $0) }.joined()
+        return buildPacket(command: commandSUBS, data: interval + String(format: "%04X", threshold) + count + addrData)
+    }
+
+    /// Build BRWR command: binary reads, then writes, of up to 24 registers in one packet
+    static func buildBRWR(reads: [UInt8], writes: [(address: UInt8, value: UInt16)] = []) -> Data {
+        var body: [UInt8] = [UInt8(min(reads.count + writes.count, brwrMaxOps))]
+        for address in reads.prefix(brwrMaxOps) {
+            body += [brwrOpRead, address, 0, 0]
+        }
+        for write in writes.prefix(brwrMaxOps - min(reads.count, brwrMaxOps)) {
+            body += [brwrOpWrite, write.address, UInt8(write.value & 0xFF), UInt8(write.value >> 8)]
+        }
+        let crc = crc16(body)
+        body += [UInt8(crc & 0xFF), UInt8(crc >> 8)]
+        return buildPacket(command: commandBRWR, data: body)
     }
 
     // MARK: - Packet Parsing
 
-    /// Find the start of a protocol packet ("   #" pattern)
-    static func findPacketStart(in data: Data) -> Int? {
-        guard data.count >= 4 else { return nil }
-        let bytes = [UInt8](data)  // Convert to array for safe 0-based indexing
-        let pattern: [UInt8] = [0x20, 0x20, 0x20, 0x23]  // "   #"
-        for i in 0...(bytes.count - 4) {
-            if bytes[i] == pattern[0] &&
-               bytes[i + 1] == pattern[1] &&
-               bytes[i + 2] == pattern[2] &&
-               bytes[i + 3] == pattern[3] {
+    /// Header that precedes every frame in the v2 stream format
+    struct StreamHeader {
+        let version: UInt8
+        let encoding: UInt8
+        let headerLength: Int
+        let sequence: UInt32
+        let timestampUs: UInt64
+        let payloadLength: Int
+        let flags: UInt8
+        /// Capture time in µs since 1970, nil until the device clock is synced
+        let utcUs: UInt64?
+
+        var isKeyframe: Bool { flags & ThermalProtocol.streamFlagKeyframe != 0 }
+    }
+
+    /// Find the start of a v2 frame header ("SXFR" magic), as an offset from the start of bytes
+    static func findStreamHeaderStart<Bytes: RandomAccessCollection>(in bytes: Bytes) -> Int?
+        where Bytes.Element == UInt8, Bytes.Index == Int {
+        guard bytes.count >= streamMagic.count else { return nil }
+        let base = bytes.startIndex
+        for i in 0...(bytes.count - streamMagic.count) {
+            if bytes[base + i] == streamMagic[0] &&
+               bytes[base + i + 1] == streamMagic[1] &&
+               bytes[base + i + 2] == streamMagic[2] &&
+               bytes[base + i + 3] == streamMagic[3] {
                 return i
             }
         }
         return nil
     }
 
-    /// Parse a protocol packet, returns (command, data, totalLength) or nil if incomplete
-    static func parsePacket(_ data: Data) -> (command: String, data: Data, totalLength: Int)? {
-        guard data.count >= 12 else { return nil }
+    /// Parse a v2 frame header at the start of bytes.
+    /// Returns nil if incomplete or not a valid header.
+    /// Takes arrays as well as buffer pointers, so the stream is parsed in place.
+    static func parseStreamHeader<Bytes: RandomAccessCollection>(_ bytes: Bytes) -> StreamHeader?
+        where Bytes.Element == UInt8, Bytes.Index == Int {
+        let header = StreamHeaderView(bytes)
+        guard bytes.count >= streamHeaderMinSize,
+              bytes.prefix(streamMagic.count).elementsEqual(streamMagic),
+              header.version == streamFormatFramed else {
+            return nil
+        }
 
-        let bytes = [UInt8](data)  // Convert to array for safe indexing
+        let headerLength = Int(header.headerLen)
+        let payloadLength = Int(header.payloadLen)
 
-        // Check for "   #" prefix
-        guard bytes[0] == 0x20, bytes[1] == 0x20, bytes[2] == 0x20, bytes[3] == 0x23 else {
+        // Reject anything that cannot be a frame, the caller then resyncs
+        guard headerLength >= streamHeaderMinSize,
+              payloadLength > 0, payloadLength <= tcpFrameSize else {
             return nil
         }
 
-        // Parse length (4 hex chars at positions 4-7)
-        guard let lengthStr = String(bytes: bytes[4..<8], encoding: .ascii),
-              let payloadLen = Int(lengthStr, radix: 16),
-              payloadLen >= 8, payloadLen <= 15000 else {
+        return StreamHeader(
+            version: header.version,
+            encoding: header.encoding,
+            headerLength: headerLength,
+            sequence: header.seq,
+            timestampUs: header.timestampUs,
+            payloadLength: payloadLength,
+            flags: header.flags,
+            utcUs: header.flags & streamFlagUTC != 0 && headerLength >= streamUTCOffset + 8
+                && bytes.count >= streamUTCOffset + 8 ? header.utcUs : nil
+        )
+    }
+
+    /// Header of every datagram of the UDP frame stream
+    struct ChunkHeader {
+        let frameId: UInt32
+        let index: Int
+        let count: Int
+        let frameLength: Int
+
+        var offset: Int { index * ThermalProtocol.udpChunkData }
+    }
+
+    /// Parse a UDP chunk header. Returns nil if this is not a valid chunk.
+    static func parseChunkHeader<Bytes: RandomAccessCollection>(_ bytes: Bytes) -> ChunkHeader?
+        where Bytes.Element == UInt8, Bytes.Index == Int {
+        guard bytes.count >= udpChunkHeaderSize,
+              bytes.prefix(udpChunkMagic.count).elementsEqual(udpChunkMagic) else {
             return nil
         }
 
-        let totalPacketLen = 4 + 4 + payloadLen  // prefix + length + payload
-        guard bytes.count >= totalPacketLen else { return nil }
+        let view = UdpChunkHeaderView(bytes)
+        let header = ChunkHeader(
+            frameId: view.frameId,
+            index: Int(view.chunkIdx),
+            count: Int(view.chunkCount),
+            frameLength: Int(view.frameLen)
+        )
 
-        // Parse command (4 chars at positions 8-11)
-        guard let command = String(bytes: bytes[8..<12], encoding: .ascii) else {
+        guard header.index < header.count,
+              header.frameLength <= udpFrameMax,
+              header.offset + bytes.count - udpChunkHeaderSize <= header.frameLength else {
             return nil
         }
+        return header
+    }
 
-        // Extract data (excluding command and CRC)
-        let dataStart = 12
-        let dataEnd = 8 + payloadLen - 4  // -4 for CRC
+    /// Parse a SUBV push, binary registers followed by a CRC-16/CCITT-FALSE.
+    /// Returns nil when the CRC does not match.
+    static func parseSUBVPush<Bytes: RandomAccessCollection>(_ bytes: Bytes) -> QuadrantRegisters?
+        where Bytes.Element == UInt8, Bytes.Index == Int {
+        let base = bytes.startIndex
+        guard let count = bytes.first.map(Int.init), bytes.count >= 1 + count * 3 + 2 else { return nil }
 
-        // Ensure valid range
-        guard dataEnd >= dataStart, dataEnd <= bytes.count else {
-            return (command, Data(), totalPacketLen)
+        let end = base + 1 + count * 3
+        let crc = UInt16(bytes[end]) | UInt16(bytes[end + 1]) << 8
+        guard crc16(bytes[base..<end]) == crc else { return nil }
+
+        var registers = QuadrantRegisters()
+        for offset in stride(from: base + 1, to: end, by: 3) {
+            registers[bytes[offset]] = UInt16(bytes[offset + 1]) | UInt16(bytes[offset + 2]) << 8
         }
+        return registers
+    }
 
-        let payloadData = Data(bytes[dataStart..<dataEnd])
-        return (command, payloadData, totalPacketLen)
+    /// Parse a BRWR response, the values read and written by each op.
+    /// Returns nil when the device rejected the batch or the CRC does not match.
+    static func parseBRWRResponse<Bytes: RandomAccessCollection>(_ bytes: Bytes) -> QuadrantRegisters?
+        where Bytes.Element == UInt8, Bytes.Index == Int {
+        let base = bytes.startIndex
+        guard bytes.count >= 4, bytes[base] == 0x00 else { return nil }
+
+        let count = Int(bytes[base + 1])
+        let end = base + 2 + count * 4
+        guard bytes.count >= 2 + count * 4 + 2 else { return nil }
+        let crc = UInt16(bytes[end]) | UInt16(bytes[end + 1]) << 8
+        guard crc16(bytes[base..<end]) == crc else { return nil }
+
+        var registers = QuadrantRegisters()
+        for offset in stride(from: base + 2, to: end, by: 4) where bytes[offset] & brwrOpSkipped == 0 {
+            registers[bytes[offset + 1]] = UInt16(bytes[offset + 2]) | UInt16(bytes[offset + 3]) << 8
+        }
+        return registers
     }
 
-    /// Parse RRSE response data into register values
-    static func parseRRSEResponse(_ data: Data) -> [UInt8: UInt16] {
-        var results: [UInt8: UInt16] = [:]
-        guard let hexString = String(data: data, encoding: .ascii) else {
-            return results
+    /// CRC-16/CCITT-FALSE, poly 0x1021, init 0xFFFF
+    static func crc16<Bytes: Sequence>(_ bytes: Bytes) -> UInt16 where Bytes.Element == UInt8 {
+        var crc: UInt16 = 0xFFFF
+        for byte in bytes {
+            crc ^= UInt16(byte) << 8
+            for _ in 0..<8 {
+                crc = crc & 0x8000 != 0 ? (crc << 1) ^ 0x1021 : crc << 1
+            }
         }
+        return crc
+    }
 
-        var offset = 0
-        while offset < hexString.count {
-            guard offset + 2 <= hexString.count else { break }
+    /// 16-bit registers, RRSE returns them as 4 hex digits and the others as 2.
+    /// From regMap.h of the firmware, run genProtocol.js of Node_Thermal_TCP to update
+    // BEGIN generated register map
+    static let wideRegisterRanges: [ClosedRange<UInt8>] = [0xC0...0xDF, 0xE8...0xFD]
+    // END generated register map
 
-            let addrStart = hexString.index(hexString.startIndex, offsetBy: offset)
-            let addrEnd = hexString.index(addrStart, offsetBy: 2)
-            guard let addr = UInt8(hexString[addrStart..<addrEnd], radix: 16) else { break }
-            offset += 2
+    static func isWideRegister(_ address: UInt8) -> Bool {
+        wideRegisterRanges.contains { $0.contains(address) }
+    }
 
-            // Quadrant registers (0xC0-0xC9) are 16-bit, others are 8-bit
-            let isQuadrantReg = addr >= 0xC0 && addr <= 0xC9
-            let valueLen = isQuadrantReg ? 4 : 2
+    /// Parse RRSE response data, pairs of ASCII hex [address][value], in place
+    static func parseRRSEResponse<Bytes: RandomAccessCollection>(_ bytes: Bytes) -> QuadrantRegisters
+        where Bytes.Element == UInt8, Bytes.Index == Int {
+        var registers = QuadrantRegisters()
+        var offset = 0
 
-            guard offset + valueLen <= hexString.count else { break }
+        while offset + 2 <= bytes.count {
+            guard let addr = hexValue(bytes, at: offset, digits: 2) else { break }
+            offset += 2
 
-            let valueStart = hexString.index(hexString.startIndex, offsetBy: offset)
-            let valueEnd = hexString.index(valueStart, offsetBy: valueLen)
-            guard let value = UInt16(hexString[valueStart..<valueEnd], radix: 16) else { break }
+            let valueLen = isWideRegister(UInt8(addr)) ? 4 : 2
+            guard offset + valueLen <= bytes.count,
+                  let value = hexValue(bytes, at: offset, digits: valueLen) else { break }
             offset += valueLen
 
-            results[addr] = value
+            registers[UInt8(addr)] = UInt16(value)
         }
 
-        return results
+        return registers
     }
 }
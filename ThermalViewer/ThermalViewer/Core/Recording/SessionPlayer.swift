@@ -0,0 +1,237 @@
+import Foundation
+import QuartzCore
+
+/// Plays a recorded session back from memory-mapped files. Only the pages of the
+/// frames decoded are read, so opening or scrubbing an hours long session costs the
+/// same as a short one. A frame is at most keyframeInterval - 1 deltas away from its
+/// keyframe, and playing forward decodes each frame once.
+final class SessionPlayer {
+    let url: URL
+    let encoding: SessionFormat.Encoding
+    let keyframeInterval: Int
+    /// Index entries whose record is complete, a session cut off by a crash plays up to its last full frame
+    let frameCount: Int
+    let duration: TimeInterval
+
+    /// Playback queue. Every frame shown and its index.
+    var onFrame: ((ThermalFrame, Int) -> Void)?
+    /// Playback queue. Playing started or stopped, also at the end of the session.
+    var onPlayingChanged: ((Bool) -> Void)?
+
+    private let data: Data
+    private let index: Data
+    private let queue = DispatchQueue(label: "SessionPlayer", qos: .userInteractive)
+    private let timer: DispatchSourceTimer
+
+    // Playback queue only
+    private var decoded: [UInt16]
+    private var scratch: [UInt16]
+    private var decodedIndex = -1  // Frame in decoded, -1 for none
+    private let pixelPool = PixelBufferPool()
+    private var position = 0
+    private var isPlaying = false
+    private var clockOrigin: CFTimeInterval = 0  // Host time of the session start
+
+    init(url: URL) throws {
+        self.url = url
+        data = try Data(contentsOf: url, options: .alwaysMapped)
+        index = try Data(contentsOf: SessionFormat.indexURL(for: url), options: .alwaysMapped)
+
+        guard data.count >= SessionFormat.fileHeaderSize,
+              data.prefix(SessionFormat.magic.count).elementsEqual(SessionFormat.magic),
+              data[4] == SessionFormat.version,
+              let encoding = SessionFormat.Encoding(rawValue: data[5]),
+              Int(Self.load(data, 8, as: UInt16.self)) == ThermalProtocol.frameWidth,
+              Int(Self.load(data, 10, as: UInt16.self)) == ThermalProtocol.imageHeight else {
+            throw CocoaError(.fileReadCorruptFile)
+        }
+        self.encoding = encoding
+        keyframeInterval = max(1, Int(Self.load(data, 6, as: UInt16.self)))
+
+        // Frames are written before their index entries, only a torn last batch needs this
+        var count = index.count / SessionFormat.indexEntrySize
+        while count > 0 {
+            let offset = Int(Self.load(index, (count - 1) * SessionFormat.indexEntrySize, as: UInt64.self))
+            if offset + SessionFormat.recordHeaderSize <= data.count,
+               offset + SessionFormat.recordHeaderSize + Int(Self.load(data, offset, as: UInt32.self)) <= data.count {
+                break
+            }
+            count -= 1
+        }
+        frameCount = count
+        duration = count > 0 ? Double(Self.load(index, (count - 1) * SessionFormat.indexEntrySize + 8, as: UInt64.self)) / 1_000_000 : 0
+
+        let pixelCount = ThermalProtocol.frameWidth * ThermalProtocol.imageHeight
+        decoded = [UInt16](repeating: 0, count: pixelCount)
+        scratch = [UInt16](repeating: 0, count: pixelCount)
+
+        timer = DispatchSource.makeTimerSource(queue: queue)
+        timer.setEventHandler { [weak self] in
+            self?.tick()
+        }
+        timer.schedule(deadline: .distantFuture)
+        timer.resume()
+    }
+
+    deinit {
+        timer.cancel()
+    }
+
+    /// Time of a frame since the start of the session
+    func time(ofFrame frame: Int) -> TimeInterval {
+        guard frameCount > 0 else { return 0 }
+        return Double(timeUs(max(0, min(frameCount - 1, frame)))) / 1_000_000
+    }
+
+    /// Last frame at or before time, by binary search of the index
+    func frame(at time: TimeInterval) -> Int {
+        let target = UInt64(max(0, time) * 1_000_000)
+        var low = 0
+        var high = frameCount - 1
+        while low < high {
+            let mid = (low + high + 1) / 2
+            if timeUs(mid) <= target {
+                low = mid
+            } else {
+                high = mid - 1
+            }
+        }
+        return max(0, low)
+    }
+
+    func play() {
+        queue.async { [self] in
+            guard !isPlaying, frameCount > 1 else { return }
+            if position >= frameCount - 1 {
+                position = 0
+                show(position)
+            }
+            isPlaying = true
+            clockOrigin = CACurrentMediaTime() - time(ofFrame: position)
+            onPlayingChanged?(true)
+            scheduleNext()
+        }
+    }
+
+    func pause() {
+        queue.async { [self] in
+            guard isPlaying else { return }
+            isPlaying = false
+            timer.schedule(deadline: .distantFuture)
+            onPlayingChanged?(false)
+        }
+    }
+
+    /// Stop for good. Returns once no more callbacks can come.
+    func stop() {
+        queue.sync {
+            isPlaying = false
+            timer.schedule(deadline: .distantFuture)
+            onFrame = nil
+            onPlayingChanged = nil
+        }
+    }
+
+    /// Show one frame. While playing, playback carries on from it.
+    func seek(to frame: Int) {
+        queue.async { [self] in
+            guard frameCount > 0 else { return }
+            position = max(0, min(frameCount - 1, frame))
+            show(position)
+            if isPlaying {
+                clockOrigin = CACurrentMediaTime() - time(ofFrame: position)
+                scheduleNext()
+            }
+        }
+    }
+
+    // MARK: - Playback Clock
+
+    private func scheduleNext() {
+        guard position + 1 < frameCount else {
+            isPlaying = false
+            onPlayingChanged?(false)
+            return
+        }
+        let delay = clockOrigin + time(ofFrame: position + 1) - CACurrentMediaTime()
+        timer.schedule(deadline: .now() + max(0, delay))
+    }
+
+    /// Show the newest frame that is due, frames the decoder fell behind on are skipped
+    private func tick() {
+        guard isPlaying else { return }
+        position = max(position + 1, frame(at: CACurrentMediaTime() - clockOrigin))
+        show(min(position, frameCount - 1))
+        scheduleNext()
+    }
+
+    private func show(_ frame: Int) {
+        guard decode(frame) else { return }
+        let image = pixelPool.fill { output in
+            decoded.withUnsafeBytes { UnsafeMutableRawBufferPointer(output).copyMemory(from: $0) }
+        }
+        guard let thermalFrame = ThermalFrame(image: image, sequence: sequence(frame)) else { return }
+        onFrame?(thermalFrame, frame)
+    }
+
+    // MARK: - Decoding
+
+    /// Decode a frame into decoded. Delta frames start from their keyframe, or go on
+    /// from the frame decoded last when it lies between.
+    private func decode(_ frame: Int) -> Bool {
+        if frame == decodedIndex { return true }
+        guard encoding == .delta else { return decodeRecord(frame, useReference: false) }
+
+        var next = frame - frame % keyframeInterval
+        if decodedIndex >= next && decodedIndex < frame {
+            next = decodedIndex + 1
+        }
+        while next <= frame {
+            guard decodeRecord(next, useReference: next % keyframeInterval != 0) else {
+                decodedIndex = -1
+                return false
+            }
+            next += 1
+        }
+        return true
+    }
+
+    private func decodeRecord(_ frame: Int, useReference: Bool) -> Bool {
+        let offset = Int(Self.load(index, frame * SessionFormat.indexEntrySize, as: UInt64.self))
+        let start = offset + SessionFormat.recordHeaderSize
+        let end = start + Int(Self.load(data, offset, as: UInt32.self))
+
+        let isDecoded = data.withUnsafeBytes { raw -> Bool in
+            let payload = UnsafeBufferPointer(rebasing: raw.bindMemory(to: UInt8.self)[start..<end])
+            switch encoding {
+            case .raw16:
+                guard payload.count == decoded.count * ThermalProtocol.bytesPerPixel else { return false }
+                scratch.withUnsafeMutableBytes { $0.copyMemory(from: UnsafeRawBufferPointer(payload)) }
+                return true
+            case .delta:
+                return decoded.withUnsafeBufferPointer { reference in
+                    scratch.withUnsafeMutableBufferPointer { output in
+                        FrameDecoder.decodeDelta(payload, reference: useReference ? reference : nil, into: output)
+                    }
+                }
+            }
+        }
+
+        guard isDecoded else { return false }
+        swap(&decoded, &scratch)
+        decodedIndex = frame
+        return true
+    }
+
+    private func timeUs(_ frame: Int) -> UInt64 {
+        Self.load(index, frame * SessionFormat.indexEntrySize + 8, as: UInt64.self)
+    }
+
+    private func sequence(_ frame: Int) -> UInt32 {
+        Self.load(data, Int(Self.load(index, frame * SessionFormat.indexEntrySize, as: UInt64.self)) + 4, as: UInt32.self)
+    }
+
+    private static func load<T: FixedWidthInteger>(_ data: Data, _ offset: Int, as type: T.Type) -> T {
+        data.withUnsafeBytes { T(littleEndian: $0.loadUnaligned(fromByteOffset: offset, as: T.self)) }
+    }
+}
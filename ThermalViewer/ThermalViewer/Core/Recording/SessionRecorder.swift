@@ -0,0 +1,261 @@
+import Foundation
+import os
+
+/// Layout of a recorded session. The frames go to an append-only .sxrec file, each
+/// behind a record header. A sidecar .sxidx file holds one fixed-size entry per frame:
+/// the record offset and the time since the start. Playback seeks through the index
+/// and never scans the frames. All fields are little endian.
+enum SessionFormat {
+    static let magic: [UInt8] = [0x53, 0x58, 0x53, 0x52]  // "SXSR"
+    static let version: UInt8 = 1
+    static let fileExtension = "sxrec"
+    static let indexExtension = "sxidx"
+
+    /// magic, version, encoding, keyframe interval u16, width u16, height u16, reserved u32
+    static let fileHeaderSize = 16
+    /// payload length u32, sequence u32, time since the start in us u64
+    static let recordHeaderSize = 16
+    /// record offset u64, time since the start in us u64
+    static let indexEntrySize = 16
+
+    enum Encoding: UInt8 {
+        case raw16 = 0  // 80x62 uint16 image
+        case delta = 1  // Zigzag varint residuals with zero runs, as the v2 stream
+    }
+
+    /// Sessions live in Documents/Recordings
+    static var directory: URL {
+        URL.documentsDirectory.appending(path: "Recordings", directoryHint: .isDirectory)
+    }
+
+    static func indexURL(for url: URL) -> URL {
+        url.deletingPathExtension().appendingPathExtension(indexExtension)
+    }
+
+    /// Recorded sessions, newest first
+    static func recordings() -> [URL] {
+        let urls = (try? FileManager.default.contentsOfDirectory(at: directory, includingPropertiesForKeys: nil)) ?? []
+        return urls.filter { $0.pathExtension == fileExtension }.sorted { $0.lastPathComponent > $1.lastPathComponent }
+    }
+}
+
+/// Appends every frame of a session to disk. append encodes on the caller's queue into
+/// buffers allocated once; the encoded bytes are written in batches on a utility queue,
+/// so a frame costs no system call and a held frame never pins a pooled pixel array.
+/// Delta frames are coded against the previous frame with a keyframe every
+/// keyframeInterval frames, the most playback decodes to reach any frame.
+final class SessionRecorder {
+    static let defaultKeyframeInterval = 64
+    static let flushThreshold = 256 * 1024  // Bytes staged before a write
+
+    let url: URL
+    let encoding: SessionFormat.Encoding
+    let keyframeInterval: Int
+
+    private struct State {
+        var reference: [UInt16]
+        var hasReference = false
+        var scratch: [UInt8]
+        var pending = Data()
+        var pendingIndex = Data()
+        var frameCount = 0
+        var fileOffset: UInt64 = UInt64(SessionFormat.fileHeaderSize)
+        var startTime: UInt64?
+        var isFinished = false
+    }
+
+    private let state: OSAllocatedUnfairLock<State>
+    private let queue = DispatchQueue(label: "SessionRecorder", qos: .utility)
+    private let dataHandle: FileHandle
+    private let indexHandle: FileHandle
+
+    /// Frames appended so far
+    var frameCount: Int {
+        state.withLock { $0.frameCount }
+    }
+
+    /// A new session in SessionFormat.directory named after the current time
+    static func makeURL() -> URL {
+        let formatter = DateFormatter()
+        formatter.dateFormat = "yyyyMMdd-HHmmss"
+        formatter.locale = Locale(identifier: "en_US_POSIX")
+        return SessionFormat.directory.appending(path: "\(formatter.string(from: Date())).\(SessionFormat.fileExtension)")
+    }
+
+    init(url: URL = SessionRecorder.makeURL(), encoding: SessionFormat.Encoding = .delta,
+         keyframeInterval: Int = SessionRecorder.defaultKeyframeInterval) throws {
+        self.url = url
+        self.encoding = encoding
+        self.keyframeInterval = encoding == .raw16 ? 1 : max(1, min(Int(UInt16.max), keyframeInterval))
+
+        let fileManager = FileManager.default
+        try fileManager.createDirectory(at: url.deletingLastPathComponent(), withIntermediateDirectories: true)
+        guard fileManager.createFile(atPath: url.path, contents: nil),
+              fileManager.createFile(atPath: SessionFormat.indexURL(for: url).path, contents: nil) else {
+            throw CocoaError(.fileWriteUnknown)
+        }
+        dataHandle = try FileHandle(forWritingTo: url)
+        indexHandle = try FileHandle(forWritingTo: SessionFormat.indexURL(for: url))
+
+        let pixelCount = ThermalProtocol.frameWidth * ThermalProtocol.imageHeight
+        state = OSAllocatedUnfairLock(initialState: State(
+            reference: [UInt16](repeating: 0, count: pixelCount),
+            scratch: [UInt8](repeating: 0, count: FrameEncoder.maxDeltaSize(pixelCount: pixelCount))))
+
+        var header = Data(SessionFormat.magic)
+        header.append(SessionFormat.version)
+        header.append(encoding.rawValue)
+        header.appendLittleEndian(UInt16(self.keyframeInterval))
+        header.appendLittleEndian(UInt16(ThermalProtocol.frameWidth))
+        header.appendLittleEndian(UInt16(ThermalProtocol.imageHeight))
+        header.appendLittleEndian(UInt32(0))
+        try dataHandle.write(contentsOf: header)
+    }
+
+    /// Any thread. Frames that are not a full image are skipped.
+    func append(_ frame: ThermalFrame) {
+        guard frame.pixels.count == ThermalProtocol.frameWidth * ThermalProtocol.imageHeight else { return }
+        let now = DispatchTime.now().uptimeNanoseconds
+
+        let batch = state.withLock { state -> (Data, Data)? in
+            guard !state.isFinished else { return nil }
+            let startTime = state.startTime ?? now
+            state.startTime = startTime
+            let timeUs = (now - startTime) / 1000
+            let isKeyframe = state.frameCount % keyframeInterval == 0 || !state.hasReference
+
+            let payloadLength: Int
+            switch encoding {
+            case .raw16:
+                payloadLength = frame.pixels.count * ThermalProtocol.bytesPerPixel
+            case .delta:
+                payloadLength = frame.pixels.withUnsafeBufferPointer { pixels in
+                    state.reference.withUnsafeBufferPointer { reference in
+                        state.scratch.withUnsafeMutableBufferPointer { output in
+                            FrameEncoder.encodeDelta(pixels, reference: isKeyframe ? nil : reference, into: output)
+                        }
+                    }
+                }
+                frame.pixels.withUnsafeBufferPointer { pixels in
+                    state.reference.withUnsafeMutableBytes { $0.copyMemory(from: UnsafeRawBufferPointer(pixels)) }
+                }
+                state.hasReference = true
+            }
+
+            state.pendingIndex.appendLittleEndian(state.fileOffset)
+            state.pendingIndex.appendLittleEndian(timeUs)
+            state.pending.appendLittleEndian(UInt32(payloadLength))
+            state.pending.appendLittleEndian(frame.sequence ?? UInt32(truncatingIfNeeded: state.frameCount))
+            state.pending.appendLittleEndian(timeUs)
+            switch encoding {
+            case .raw16:
+                frame.pixels.withUnsafeBytes { state.pending.append(contentsOf: $0) }
+            case .delta:
+                state.scratch.withUnsafeBufferPointer { state.pending.append(contentsOf: UnsafeBufferPointer(rebasing: $0[0..<payloadLength])) }
+            }
+            state.fileOffset += UInt64(SessionFormat.recordHeaderSize + payloadLength)
+            state.frameCount += 1
+
+            guard state.pending.count >= Self.flushThreshold else { return nil }
+            defer {
+                state.pending = Data()
+                state.pendingIndex = Data()
+            }
+            return (state.pending, state.pendingIndex)
+        }
+
+        if let batch = batch {
+            write(batch.0, batch.1)
+        }
+    }
+
+    /// Write what is staged and close the files. Later frames are ignored.
+    func finish() {
+        let (frames, index) = state.withLock { state -> (Data, Data) in
+            state.isFinished = true
+            defer {
+                state.pending = Data()
+                state.pendingIndex = Data()
+            }
+            return (state.pending, state.pendingIndex)
+        }
+        write(frames, index)
+        queue.async { [dataHandle, indexHandle] in
+            try? dataHandle.close()
+            try? indexHandle.close()
+        }
+    }
+
+    /// Frames go out before their index entries, so an index entry never points past
+    /// the end of the file, even when the app is killed in between.
+    private func write(_ frames: Data, _ index: Data) {
+        queue.async { [dataHandle, indexHandle] in
+            do {
+                try dataHandle.write(contentsOf: frames)
+                try indexHandle.write(contentsOf: index)
+            } catch {
+                print("Session recording write failed: \(error)")
+            }
+        }
+    }
+}
+
+/// Encoder of the delta payload that FrameDecoder.decodeDelta reads
+enum FrameEncoder {
+    /// Worst case: every residual takes a 3 byte varint
+    static func maxDeltaSize(pixelCount: Int) -> Int {
+        pixelCount * 3
+    }
+
+    /// Zigzag varint residuals against reference, or against the previous pixel for a
+    /// keyframe. A run of zero residuals is 0x00 and the run length - 1 as a varint.
+    /// output must hold maxDeltaSize bytes. Returns the bytes written.
+    static func encodeDelta(_ pixels: UnsafeBufferPointer<UInt16>, reference: UnsafeBufferPointer<UInt16>?,
+                            into output: UnsafeMutableBufferPointer<UInt8>) -> Int {
+        var op = 0
+        var predict: UInt16 = 0
+
+        func writeVarint(_ value: UInt32) {
+            var value = value
+            while value >= 0x80 {
+                output[op] = UInt8(truncatingIfNeeded: value) | 0x80
+                op += 1
+                value >>= 7
+            }
+            output[op] = UInt8(value)
+            op += 1
+        }
+
+        var i = 0
+        while i < pixels.count {
+            if let reference = reference { predict = reference[i] }
+            let residual = Int16(bitPattern: pixels[i] &- predict)
+
+            if residual == 0 {
+                var run = 1
+                predict = pixels[i]
+                while i + run < pixels.count {
+                    if let reference = reference { predict = reference[i + run] }
+                    guard pixels[i + run] == predict else { break }
+                    run += 1
+                }
+                output[op] = 0x00
+                op += 1
+                writeVarint(UInt32(run - 1))
+                i += run
+                predict = pixels[i - 1]
+            } else {
+                writeVarint(UInt32(UInt16(bitPattern: (residual << 1) ^ (residual >> 15))))
+                predict = pixels[i]
+                i += 1
+            }
+        }
+        return op
+    }
+}
+
+extension Data {
+    mutating func appendLittleEndian<T: FixedWidthInteger>(_ value: T) {
+        Swift.withUnsafeBytes(of: value.littleEndian) { append(contentsOf: $0) }
+    }
+}
@@ -5,6 +5,7 @@ struct ConnectionView: View {
     @Binding var initialTab: AppTab
     @State private var ipAddress: String = "192.168.4.213"
     @State private var isConnecting: Bool = false
+    @State private var showDashboard: Bool = false
 
     var body: some View {
         VStack(spacing: 32) {
@@ -68,6 +69,13 @@ struct ConnectionView: View {
                 .buttonStyle(.borderedProminent)
                 .controlSize(.large)
                 .disabled(ipAddress.isEmpty || isConnecting)
+
+                Button {
+                    showDashboard = true
+                } label: {
+                    Label("All Cameras", systemImage: "square.grid.2x2")
+                }
+                .disabled(isConnecting)
             }
             .padding(32)
             .background(Color(.secondarySystemBackground))
@@ -86,6 +94,9 @@ struct ConnectionView: View {
         .padding()
         .frame(maxWidth: .infinity, maxHeight: .infinity)
         .background(Color(.systemBackground))
+        .fullScreenCover(isPresented: $showDashboard) {
+            DashboardView()
+        }
         .onChange(of: connectionManager.isConnected) { _, isConnected in
             if isConnected {
                 isConnecting = false
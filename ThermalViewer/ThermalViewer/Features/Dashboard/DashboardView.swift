@@ -0,0 +1,142 @@
+import SwiftUI
+
+/// Every camera of the site at once. Tiles show the pushed quadrant maxima,
+/// the selected camera streams full frames in the main panel.
+struct DashboardView: View {
+    @Environment(DeviceSessionManager.self) private var sessionManager
+    @Environment(\.dismiss) private var dismiss
+    @AppStorage("temperatureUnit") private var temperatureUnit: TemperatureUnit = .celsius
+    @AppStorage("flipHorizontally") private var flipHorizontally: Bool = false
+    @AppStorage("flipVertically") private var flipVertically: Bool = false
+    @State private var newHost: String = ""
+
+    var body: some View {
+        NavigationStack {
+            HStack(spacing: 0) {
+                focusedPanel
+                    .frame(maxWidth: .infinity, maxHeight: .infinity)
+                    .background(Color.black)
+
+                tileList
+                    .frame(width: 260)
+                    .background(Color(.secondarySystemBackground))
+            }
+            .navigationTitle("Dashboard")
+            .navigationBarTitleDisplayMode(.inline)
+            .toolbar {
+                ToolbarItem(placement: .cancellationAction) {
+                    Button("Done") { dismiss() }
+                }
+            }
+        }
+        .onAppear { sessionManager.start() }
+        .onDisappear { sessionManager.stop() }
+    }
+
+    @ViewBuilder
+    private var focusedPanel: some View {
+        if let session = sessionManager.focusedSession {
+            VStack(spacing: 12) {
+                ThermalCanvasView(
+                    frame: sessionManager.focusedFrame,
+                    palette: .default,
+                    flipHorizontally: flipHorizontally,
+                    flipVertically: flipVertically
+                )
+
+                HStack {
+                    Text(session.host)
+                        .font(.system(.headline, design: .monospaced))
+                    Spacer()
+                    Text("\(sessionManager.focusedFPS) FPS")
+                        .font(.system(.caption, design: .monospaced))
+                }
+                .foregroundColor(.white)
+            }
+            .padding()
+        } else {
+            Text(sessionManager.sessions.isEmpty ? "Add a camera" : "Select a camera")
+                .foregroundColor(.gray)
+        }
+    }
+
+    private var tileList: some View {
+        ScrollView {
+            LazyVStack(spacing: 8) {
+                ForEach(sessionManager.sessions) { session in
+                    DeviceTileView(session: session, temperatureUnit: temperatureUnit)
+                        .onTapGesture {
+                            sessionManager.focus(session.isFocused ? nil : session)
+                        }
+                        .contextMenu {
+                            Button(role: .destructive) {
+                                sessionManager.removeDevice(session)
+                            } label: {
+                                Label("Remove", systemImage: "trash")
+                            }
+                        }
+                }
+
+                HStack {
+                    TextField("hood-1.local", text: $newHost)
+                        .textFieldStyle(.roundedBorder)
+                        .font(.system(.body, design: .monospaced))
+                        .autocorrectionDisabled()
+                        .textInputAutocapitalization(.never)
+                        .onSubmit(addDevice)
+
+                    Button(action: addDevice) {
+                        Image(systemName: "plus.circle.fill")
+                    }
+                    .disabled(newHost.isEmpty)
+                }
+                .padding(.top, 8)
+            }
+            .padding()
+        }
+    }
+
+    private func addDevice() {
+        sessionManager.addDevice(host: newHost)
+        newHost = ""
+    }
+}
+
+struct DeviceTileView: View {
+    let session: DeviceSession
+    let temperatureUnit: TemperatureUnit
+
+    var body: some View {
+        VStack(alignment: .leading, spacing: 6) {
+            HStack {
+                Circle()
+                    .fill(session.isConnected ? Color.green : Color.red)
+                    .frame(width: 8, height: 8)
+                Text(session.host)
+                    .font(.system(.subheadline, design: .monospaced))
+                    .lineLimit(1)
+                Spacer()
+            }
+
+            Text(session.isConnected ? temperatureUnit.format(session.hottest) : "--")
+                .font(.system(.title2, design: .rounded))
+                .fontWeight(.semibold)
+
+            HStack {
+                ForEach(Quadrant.allCases) { quadrant in
+                    Text("\(quadrant.rawValue) \(temperatureUnit.format(quadrant.maxValue(from: session.quadrantData)))")
+                        .font(.system(size: 9, design: .monospaced))
+                        .foregroundColor(.secondary)
+                }
+            }
+        }
+        .padding(10)
+        .frame(maxWidth: .infinity, alignment: .leading)
+        .background(Color(.systemBackground))
+        .cornerRadius(10)
+        .overlay(
+            RoundedRectangle(cornerRadius: 10)
+                .stroke(session.isFocused ? Color.accentColor : Color.clear, lineWidth: 2)
+        )
+    }
+}
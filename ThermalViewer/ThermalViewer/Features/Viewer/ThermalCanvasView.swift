@@ -6,10 +6,21 @@ struct ThermalCanvasView: View {
     let palette: ColorPalette
     let flipHorizontally: Bool
     let flipVertically: Bool
+    var interpolation: ThermalInterpolation = .nearest
 
     var body: some View {
         GeometryReader { geometry in
-            if let cgImage = renderFrame() {
+            if let frame = frame, let renderer = ThermalRenderer.shared {
+                ThermalMetalView(
+                    renderer: renderer,
+                    frame: frame,
+                    palette: palette,
+                    flipHorizontally: flipHorizontally,
+                    flipVertically: flipVertically,
+                    interpolation: interpolation
+                )
+                .frame(width: geometry.size.width, height: geometry.size.height)
+            } else if let cgImage = renderFrame() {
                 Image(decorative: cgImage, scale: 1)
                     .interpolation(.none)
                     .resizable()
@@ -28,28 +39,29 @@ struct ThermalCanvasView: View {
         .aspectRatio(CGFloat(ThermalProtocol.frameWidth) / CGFloat(ThermalProtocol.imageHeight), contentMode: .fit)
     }
 
+    /// Core Graphics fallback for devices without Metal
     private func renderFrame() -> CGImage? {
         guard let frame = frame else { return nil }
 
         let width = ThermalProtocol.frameWidth
         let height = ThermalProtocol.imageHeight
 
-        // Normalize values based on frame min/max
-        let minVal = Double(frame.minValue)
-        let maxVal = Double(frame.maxValue)
-        let range = max(1, maxVal - minVal)
+        // Normalize values based on frame min/max, integer math into the palette LUT
+        let minVal = Int(frame.minValue)
+        let range = max(1, Int(frame.maxValue) - minVal)
+        let lut = palette.fineLut
+        let lastEntry = ColorPalette.fineLutSize - 1
 
         // Create RGBA buffer
         var rgbaBuffer = [UInt8](repeating: 0, count: width * height * 4)
 
         for i in 0..<frame.pixels.count {
-            let normalized = (Double(frame.pixels[i]) - minVal) / range
-            let (r, g, b) = palette.color(for: normalized)
+            let index = min(lastEntry, max(0, (Int(frame.pixels[i]) - minVal) * lastEntry / range)) * 4
 
             let offset = i * 4
-            rgbaBuffer[offset] = r
-            rgbaBuffer[offset + 1] = g
-            rgbaBuffer[offset + 2] = b
+            rgbaBuffer[offset] = lut[index]
+            rgbaBuffer[offset + 1] = lut[index + 1]
+            rgbaBuffer[offset + 2] = lut[index + 2]
             rgbaBuffer[offset + 3] = 255
         }
 
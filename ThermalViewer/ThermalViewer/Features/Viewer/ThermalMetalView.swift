@@ -0,0 +1,201 @@
+import SwiftUI
+import MetalKit
+
+/// Upscaling of the 80x62 image to the view
+enum ThermalInterpolation: UInt32, CaseIterable, Identifiable {
+    case nearest = 0
+    case bilinear = 1
+    case bicubic = 2
+
+    var id: UInt32 { rawValue }
+
+    var name: String {
+        switch self {
+        case .nearest: return "Pixel"
+        case .bilinear: return "Smooth"
+        case .bicubic: return "Sharp"
+        }
+    }
+}
+
+/// Metal state shared by every thermal view: one pipeline and one LUT texture
+/// per palette, so each extra camera in a grid only adds its pixel textures.
+/// Used from the main thread only.
+final class ThermalRenderer {
+    static let shared = ThermalRenderer()  // nil without Metal, views fall back to Core Graphics
+
+    // Must match ThermalUniforms in ThermalShaders.metal
+    struct Uniforms {
+        var minValue: Float
+        var invRange: Float
+        var flip: SIMD2<Float>
+        var interpolation: UInt32
+    }
+
+    static let maxFramesInFlight = 3
+
+    let device: MTLDevice
+    private let commandQueue: MTLCommandQueue
+    private let pipeline: MTLRenderPipelineState
+    private var lutTextures: [ColorPalette: MTLTexture] = [:]
+
+    private init?() {
+        guard let device = MTLCreateSystemDefaultDevice(),
+              let commandQueue = device.makeCommandQueue(),
+              let library = device.makeDefaultLibrary() else {
+            return nil
+        }
+
+        let descriptor = MTLRenderPipelineDescriptor()
+        descriptor.vertexFunction = library.makeFunction(name: "thermalVertex")
+        descriptor.fragmentFunction = library.makeFunction(name: "thermalFragment")
+        descriptor.colorAttachments[0].pixelFormat = .bgra8Unorm
+
+        guard let pipeline = try? device.makeRenderPipelineState(descriptor: descriptor) else {
+            return nil
+        }
+
+        self.device = device
+        self.commandQueue = commandQueue
+        self.pipeline = pipeline
+    }
+
+    /// Texture of one frame, raw values as 16 bit normalised so the GPU can filter them
+    func makePixelTexture() -> MTLTexture? {
+        let descriptor = MTLTextureDescriptor.texture2DDescriptor(
+            pixelFormat: .r16Unorm,
+            width: ThermalProtocol.frameWidth,
+            height: ThermalProtocol.imageHeight,
+            mipmapped: false
+        )
+        descriptor.usage = .shaderRead
+        return device.makeTexture(descriptor: descriptor)
+    }
+
+    private func lutTexture(for palette: ColorPalette) -> MTLTexture? {
+        if let texture = lutTextures[palette] {
+            return texture
+        }
+
+        let descriptor = MTLTextureDescriptor()
+        descriptor.textureType = .type1D
+        descriptor.pixelFormat = .rgba8Unorm
+        descriptor.width = ColorPalette.lutSize
+        descriptor.usage = .shaderRead
+
+        guard let texture = device.makeTexture(descriptor: descriptor) else { return nil }
+        palette.lut.withUnsafeBytes {
+            texture.replace(region: MTLRegionMake1D(0, ColorPalette.lutSize), mipmapLevel: 0,
+                            withBytes: $0.baseAddress!, bytesPerRow: ColorPalette.lutSize * 4)
+        }
+        lutTextures[palette] = texture
+        return texture
+    }
+
+    /// Draw one frame to the view. completion runs once the GPU is done with pixels.
+    func draw(in view: MTKView, pixels: MTLTexture, palette: ColorPalette, uniforms: Uniforms,
+              completion: @escaping () -> Void) {
+        guard let drawable = view.currentDrawable,
+              let pass = view.currentRenderPassDescriptor,
+              let lut = lutTexture(for: palette),
+              let commandBuffer = commandQueue.makeCommandBuffer(),
+              let encoder = commandBuffer.makeRenderCommandEncoder(descriptor: pass) else {
+            completion()
+            return
+        }
+
+        var uniforms = uniforms
+        encoder.setRenderPipelineState(pipeline)
+        encoder.setVertexBytes(&uniforms, length: MemoryLayout<Uniforms>.stride, index: 0)
+        encoder.setFragmentBytes(&uniforms, length: MemoryLayout<Uniforms>.stride, index: 0)
+        encoder.setFragmentTexture(pixels, index: 0)
+        encoder.setFragmentTexture(lut, index: 1)
+        encoder.drawPrimitives(type: .triangle, vertexStart: 0, vertexCount: 3)
+        encoder.endEncoding()
+
+        commandBuffer.addCompletedHandler { _ in completion() }
+        commandBuffer.present(drawable)
+        commandBuffer.commit()
+    }
+}
+
+/// GPU path of ThermalCanvasView. Raw pixels go to an r16Unorm texture, normalisation
+/// and the palette run in the fragment shader. The view only redraws when a frame
+/// or a setting changes.
+struct ThermalMetalView: UIViewRepresentable {
+    let renderer: ThermalRenderer
+    let frame: ThermalFrame
+    let palette: ColorPalette
+    let flipHorizontally: Bool
+    let flipVertically: Bool
+    let interpolation: ThermalInterpolation
+
+    func makeCoordinator() -> Coordinator {
+        Coordinator(renderer: renderer)
+    }
+
+    func makeUIView(context: Context) -> MTKView {
+        let view = MTKView(frame: .zero, device: renderer.device)
+        view.colorPixelFormat = .bgra8Unorm
+        view.clearColor = MTLClearColorMake(0, 0, 0, 1)
+        view.framebufferOnly = true
+        view.isPaused = true
+        view.enableSetNeedsDisplay = true
+        view.delegate = context.coordinator
+        return view
+    }
+
+    func updateUIView(_ view: MTKView, context: Context) {
+        context.coordinator.frame = frame
+        context.coordinator.palette = palette
+        context.coordinator.flip = SIMD2(flipHorizontally ? 1 : 0, flipVertically ? 1 : 0)
+        context.coordinator.interpolation = interpolation
+        view.setNeedsDisplay()
+    }
+
+    final class Coordinator: NSObject, MTKViewDelegate {
+        private let renderer: ThermalRenderer
+        private var pixelTextures: [MTLTexture]
+        private var nextTexture = 0
+        private let inFlight = DispatchSemaphore(value: ThermalRenderer.maxFramesInFlight)
+
+        var frame: ThermalFrame?
+        var palette: ColorPalette = .default
+        var flip = SIMD2<Float>(0, 0)
+        var interpolation: ThermalInterpolation = .nearest
+
+        init(renderer: ThermalRenderer) {
+            self.renderer = renderer
+            // One texture per frame in flight, the GPU never reads a texture being written
+            self.pixelTextures = (0..<ThermalRenderer.maxFramesInFlight).compactMap { _ in renderer.makePixelTexture() }
+        }
+
+        func mtkView(_ view: MTKView, drawableSizeWillChange size: CGSize) {}
+
+        func draw(in view: MTKView) {
+            guard let frame = frame, !pixelTextures.isEmpty else { return }
+
+            inFlight.wait()
+            let texture = pixelTextures[nextTexture]
+            nextTexture = (nextTexture + 1) % pixelTextures.count
+
+            frame.pixels.withUnsafeBytes {
+                texture.replace(region: MTLRegionMake2D(0, 0, frame.width, frame.height), mipmapLevel: 0,
+                                withBytes: $0.baseAddress!, bytesPerRow: frame.width * MemoryLayout<UInt16>.stride)
+            }
+
+            let range = max(1, Float(frame.maxValue) - Float(frame.minValue))
+            let uniforms = ThermalRenderer.Uniforms(
+                minValue: Float(frame.minValue) / 65535,
+                invRange: 65535 / range,
+                flip: flip,
+                interpolation: interpolation.rawValue
+            )
+
+            let semaphore = inFlight
+            renderer.draw(in: view, pixels: texture, palette: palette, uniforms: uniforms) {
+                semaphore.signal()
+            }
+        }
+    }
+}
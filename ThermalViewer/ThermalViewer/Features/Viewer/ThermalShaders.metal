@@ -0,0 +1,81 @@
+#include <metal_stdlib>
+using namespace metal;
+
+// Must match ThermalRenderer.Uniforms
+struct ThermalUniforms {
+    float minValue;        // Frame minimum, in r16Unorm units
+    float invRange;        // 1 / (max - min), in r16Unorm units
+    float2 flip;           // 1 mirrors the axis
+    uint interpolation;    // ThermalInterpolation: 0 nearest, 1 bilinear, 2 bicubic
+};
+
+struct RasterData {
+    float4 position [[position]];
+    float2 uv;
+};
+
+constexpr sampler nearestSampler(coord::normalized, filter::nearest, address::clamp_to_edge);
+constexpr sampler linearSampler(coord::normalized, filter::linear, address::clamp_to_edge);
+
+// One triangle covering the view, no vertex buffer
+vertex RasterData thermalVertex(uint vid [[vertex_id]],
+                                constant ThermalUniforms &uniforms [[buffer(0)]]) {
+    float2 corner = float2((vid << 1) & 2, vid & 2);
+    float2 uv = float2(corner.x, 1.0 - corner.y);
+
+    RasterData out;
+    out.position = float4(corner * 2.0 - 1.0, 0.0, 1.0);
+    out.uv = mix(uv, 1.0 - uv, uniforms.flip);
+    return out;
+}
+
+// Catmull-Rom weights of the 4 taps around t
+static float4 cubicWeights(float t) {
+    float t2 = t * t;
+    float t3 = t2 * t;
+    return float4(-0.5 * t3 + t2 - 0.5 * t,
+                  1.5 * t3 - 2.5 * t2 + 1.0,
+                  -1.5 * t3 + 2.0 * t2 + 0.5 * t,
+                  0.5 * t3 - 0.5 * t2);
+}
+
+static float sampleBicubic(texture2d<float> pixels, float2 uv) {
+    float2 size = float2(pixels.get_width(), pixels.get_height());
+    float2 position = uv * size - 0.5;
+    float2 base = floor(position);
+    float4 wx = cubicWeights(position.x - base.x);
+    float4 wy = cubicWeights(position.y - base.y);
+
+    float value = 0.0;
+    for (int j = 0; j < 4; j++) {
+        for (int i = 0; i < 4; i++) {
+            float2 texel = (base + float2(i - 1, j - 1) + 0.5) / size;
+            value += wx[i] * wy[j] * pixels.sample(nearestSampler, texel).r;
+        }
+    }
+    return value;
+}
+
+// Normalise to the frame range, then colour through the palette LUT
+fragment float4 thermalFragment(RasterData in [[stage_in]],
+                                texture2d<float> pixels [[texture(0)]],
+                                texture1d<float> lut [[texture(1)]],
+                                constant ThermalUniforms &uniforms [[buffer(0)]]) {
+    float raw;
+    switch (uniforms.interpolation) {
+        case 1:
+            raw = pixels.sample(linearSampler, in.uv).r;
+            break;
+        case 2:
+            raw = sampleBicubic(pixels, in.uv);
+            break;
+        default:
+            raw = pixels.sample(nearestSampler, in.uv).r;
+            break;
+    }
+
+    float value = saturate((raw - uniforms.minValue) * uniforms.invRange);
+    float lutSize = float(lut.get_width());
+    float coordinate = (value * (lutSize - 1.0) + 0.5) / lutSize;  // Centre of the first and last entries
+    return float4(lut.sample(linearSampler, coordinate).rgb, 1.0);
+}
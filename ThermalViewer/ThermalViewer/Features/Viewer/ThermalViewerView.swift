@@ -3,6 +3,7 @@ import SwiftUI
 struct ThermalViewerView: View {
     @Environment(ConnectionManager.self) private var connectionManager
     @State private var selectedPalette: ColorPalette = .default
+    @State private var interpolation: ThermalInterpolation = .nearest
     @State private var temperatureUnit: TemperatureUnit = .celsius
     @State private var showQuadrants: Bool = true
     @State private var showSettings: Bool = false
@@ -32,7 +33,8 @@ struct ThermalViewerView: View {
                     frame: connectionManager.currentFrame,
                     palette: selectedPalette,
                     flipHorizontally: connectionManager.flipHorizontally,
-                    flipVertically: connectionManager.flipVertically
+                    flipVertically: connectionManager.flipVertically,
+                    interpolation: interpolation
                 )
 
                 // Quadrant overlay
@@ -67,6 +69,11 @@ struct ThermalViewerView: View {
             // Controls
             controlsSection
 
+            Divider()
+
+            // Recording and playback
+            recordingSection
+
             Spacer()
 
             // Disconnect button
@@ -156,6 +163,19 @@ struct ThermalViewerView: View {
                 .pickerStyle(.menu)
             }
 
+            // Upscaling
+            VStack(alignment: .leading, spacing: 4) {
+                Text("Upscaling")
+                    .font(.caption)
+                    .foregroundColor(.secondary)
+                Picker("Upscaling", selection: $interpolation) {
+                    ForEach(ThermalInterpolation.allCases) { mode in
+                        Text(mode.name).tag(mode)
+                    }
+                }
+                .pickerStyle(.segmented)
+            }
+
             // Temperature unit
             VStack(alignment: .leading, spacing: 4) {
                 Text("Temperature Unit")
@@ -191,6 +211,65 @@ struct ThermalViewerView: View {
         }
     }
 
+    private var recordingSection: some View {
+        VStack(spacing: 12) {
+            if let player = connectionManager.player {
+                playbackControls(player)
+            } else {
+                Button {
+                    if connectionManager.isRecording {
+                        connectionManager.stopRecording()
+                    } else {
+                        connectionManager.startRecording()
+                    }
+                } label: {
+                    Label(connectionManager.isRecording ? "Stop Recording (\(connectionManager.recordedFrames))" : "Record",
+                          systemImage: connectionManager.isRecording ? "stop.circle" : "record.circle")
+                }
+                .buttonStyle(.bordered)
+                .tint(connectionManager.isRecording ? .red : nil)
+
+                Menu {
+                    ForEach(SessionFormat.recordings(), id: \.self) { url in
+                        Button(url.deletingPathExtension().lastPathComponent) {
+                            connectionManager.openPlayback(url)
+                        }
+                    }
+                } label: {
+                    Label("Play Recording", systemImage: "play.rectangle")
+                }
+            }
+        }
+    }
+
+    private func playbackControls(_ player: SessionPlayer) -> some View {
+        VStack(spacing: 8) {
+            Text(player.url.deletingPathExtension().lastPathComponent)
+                .font(.caption)
+                .foregroundColor(.secondary)
+
+            Slider(value: Binding(
+                get: { Double(connectionManager.playbackPosition) },
+                set: { connectionManager.seekPlayback(to: Int($0)) }
+            ), in: 0...Double(max(1, player.frameCount - 1)), step: 1)
+
+            HStack {
+                Button {
+                    connectionManager.togglePlayback()
+                } label: {
+                    Image(systemName: connectionManager.isPlaying ? "pause.fill" : "play.fill")
+                }
+                Text("\(formatTime(player.time(ofFrame: connectionManager.playbackPosition))) / \(formatTime(player.duration))")
+                    .font(.system(.caption, design: .monospaced))
+                Spacer()
+                Button("Close") {
+                    connectionManager.closePlayback()
+                }
+            }
+            .buttonStyle(.bordered)
+        }
+    }
+
     private var disconnectButton: some View {
         Button(role: .destructive) {
             connectionManager.disconnect()
@@ -203,6 +282,10 @@ struct ThermalViewerView: View {
 
     // MARK: - Actions
 
+    private func formatTime(_ seconds: TimeInterval) -> String {
+        Duration.seconds(seconds).formatted(.time(pattern: .hourMinuteSecond))
+    }
+
     private func saveScreenshot() {
         // TODO: Implement screenshot capture
     }
@@ -150,3 +150,33 @@ extension ColorPalette {
         }
     }
 }
+
+// MARK: - Lookup Tables
+
+extension ColorPalette {
+    static let lutSize = 256        // GPU table, the shader interpolates between entries
+    static let fineLutSize = 1024   // CPU table, fine enough to index without interpolation
+
+    /// RGBA table of lutSize entries, coldest first
+    var lut: [UInt8] { ColorPalette.lutCache[self] ?? [] }
+
+    /// RGBA table of fineLutSize entries, coldest first
+    var fineLut: [UInt8] { ColorPalette.fineLutCache[self] ?? [] }
+
+    // Built lazily on first use, once per palette, and shared by every view
+    private static let lutCache = makeLUTs(entries: lutSize)
+    private static let fineLutCache = makeLUTs(entries: fineLutSize)
+
+    private static func makeLUTs(entries: Int) -> [ColorPalette: [UInt8]] {
+        Dictionary(uniqueKeysWithValues: allCases.map { palette in
+            var table = [UInt8](repeating: 255, count: entries * 4)
+            for i in 0..<entries {
+                let (r, g, b) = palette.color(for: Double(i) / Double(entries - 1))
+                table[i * 4] = r
+                table[i * 4 + 1] = g
+                table[i * 4 + 2] = b
+            }
+            return (palette, table)
+        })
+    }
+}
@@ -3,11 +3,13 @@ import SwiftUI
 @main
 struct ThermalViewerApp: App {
     @State private var connectionManager = ConnectionManager()
+    @State private var sessionManager = DeviceSessionManager()
 
     var body: some Scene {
         WindowGroup {
             ContentView()
                 .environment(connectionManager)
+                .environment(sessionManager)
         }
     }
 }
@@ -2,6 +2,7 @@
 #define __CUSTOMER_INTERFACE_H__
 
 #include <stdint.h>
+#include <stdbool.h>
 
 int Read_Customer_Registers (int Address);
 void Write_Customer_Registers (int Address,int Data);
@@ -352,6 +353,28 @@ void Initialize_Filter(void);
 
 extern MCU_REG MCU_REGISTER;
 void Process_Header(uint16_t* ProcessDataFrame_TXBuf);
+
+/* Per-pixel stages fused into the unit conversion pass (COnvert_Image_Transfer_Format)*/
+#define CONV_GAIN_SHIFT		14						// Gain is fixed point, CONV_GAIN_UNITY is 1.0
+#define CONV_GAIN_UNITY		(1 << CONV_GAIN_SHIFT)
+
+// Gain and offset of one pixel, applied to the raw value before the conversion
+typedef struct convCorr{
+	uint16_t mGain;								// Q2.14
+	int16_t mOffset;							// Raw frame units, after the gain
+}convCorr_t;
+
+// One bad pixel, the final value at mSrc is copied to mDst
+typedef struct pixPatch{
+	uint16_t mDst;
+	uint16_t mSrc;
+}pixPatch_t;
+
+uint8_t Customer_GetTgain(void);
+void Customer_InvalidateTgain(void);
+void Customer_SetPixelCorrection(const convCorr_t* pMap);
+void Customer_SetPixelPatch(const pixPatch_t* pPatch, const uint16_t count);
+bool Customer_GetPixelPatched(void);
 #define B1_START_CAPTURE 	0x01
 #define B1_SINGLE_CONT 		0x02
 #endif //__CUSTOMER_INTERFACE_H__
@@ -0,0 +1,40 @@
+#ifndef __FRAMESTATS_H__
+#define __FRAMESTATS_H__
+
+#include <stdint.h>
+
+#define FRAME_STATS_BINS				256		// Fine histogram bins, sets the percentile resolution
+#define FRAME_STATS_BUCKETS				16		// Coarse buckets reported to clients
+#define FRAME_STATS_BINS_PER_BUCKET		(FRAME_STATS_BINS / FRAME_STATS_BUCKETS)
+
+// Frame statistics registers (R, 16-bit)
+#define REG_FSTAT_MIN					0xF1
+#define REG_FSTAT_MAX					0xF2
+#define REG_FSTAT_MEAN					0xF3
+#define REG_FSTAT_P50					0xF4
+#define REG_FSTAT_P95					0xF5
+#define REG_FSTAT_P99					0xF6
+#define REG_FSTAT_FIRST					REG_FSTAT_MIN
+#define REG_FSTAT_LAST					REG_FSTAT_P99
+
+// Statistics of one processed frame, in raw frame units before the unit conversion of 0x31
+typedef struct __attribute__((packed)) frameStats{
+	uint16_t mMin;
+	uint16_t mMax;
+	uint16_t mMean;
+	uint16_t mP50;
+	uint16_t mP95;
+	uint16_t mP99;
+	uint16_t mBucketLo;					// Lower bound of bucket 0
+	uint8_t mBucketShift;				// Bucket width is 1 << mBucketShift
+	uint8_t mScale;						// Raw units per Kelvin: 10 or 100 (0xB9 bit 7)
+	uint16_t mBucket[FRAME_STATS_BUCKETS];	// Pixel count per bucket
+}frameStats_t;
+
+void FrameStats_Process(const uint16_t* buffer, int l_FrameSize, uint16_t Frame_min, uint16_t Frame_max);
+
+void FrameStats_Get(frameStats_t* pStats);
+
+uint16_t FrameStats_ReadRegister(int Address);
+
+#endif //__FRAMESTATS_H__
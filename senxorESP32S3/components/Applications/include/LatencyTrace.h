@@ -0,0 +1,92 @@
+#ifndef __LATENCYTRACE_H__
+#define __LATENCYTRACE_H__
+
+#include <stdint.h>
+#include <esp_attr.h>
+#include <esp_timer.h>
+#include <esp_cpu.h>
+#include <sdkconfig.h>
+
+// Pipeline stages, in the order a frame goes through them
+typedef enum latencyStage{
+	LAT_STAGE_CAPTURE = 0,				// Last block of the frame read in the capture interrupt
+	LAT_STAGE_RECEIVE,					// DataFrameReceiveSenxor returned the processed frame
+	LAT_STAGE_ANALYTICS,				// Quadrant and ROI analysis done
+	LAT_STAGE_PUBLISH,					// Frame pushed to the frame bus
+	LAT_STAGE_NET_SEND,					// Frame handed to a TCP, UDP or WebSocket client
+	LAT_STAGE_USB_SEND,					// Frame queued on USB CDC
+	LAT_STAGE_COUNT
+}latencyStage_t;
+
+#define LAT_STAT_TOTAL					LAT_STAGE_COUNT			// Capture to network send
+#define LAT_STAT_COUNT					(LAT_STAGE_COUNT + 1)
+
+// Latency of one stage over the records still in the rings, in us
+typedef struct latencyStats{
+	uint16_t mCount;					// Frames measured
+	uint32_t mMinUs;
+	uint32_t mAvgUs;
+	uint32_t mP99Us;
+	uint32_t mMaxUs;
+}latencyStats_t;
+
+// Analytics functions timed per call, every one runs once per frame
+typedef enum latencyFunc{
+	LAT_FUNC_QUADRANT = 0,				// quadrant_Calculate
+	LAT_FUNC_CONVERT,					// COnvert_Image_Transfer_Format
+	LAT_FUNC_MIN_MAX,					// Update_min_max_header
+	LAT_FUNC_COUNT
+}latencyFunc_t;
+
+// Execution time of one function since boot, in ns
+typedef struct latencyFuncStats{
+	uint32_t mCalls;
+	uint32_t mMinNs;
+	uint32_t mAvgNs;
+	uint32_t mMaxNs;
+}latencyFuncStats_t;
+
+#if CONFIG_MI_LATENCY_TRACE_EN
+
+#define LAT_RING_SIZE					CONFIG_MI_LATENCY_TRACE_DEPTH	// Records per core, power of 2
+
+// Record the time a frame reached a stage. Stages after the capture are measured from the previous stage of the same frame
+#define LATENCY_TRACE(stage, seq)				LatencyTrace_Record((stage), (seq), (uint32_t)esp_timer_get_time())
+#define LATENCY_TRACE_AT(stage, seq, timeUs)	LatencyTrace_Record((stage), (seq), (uint32_t)(timeUs))
+// The capture interrupt does not know the frame number, it only latches the time
+#define LATENCY_TRACE_CAPTURE_DONE()			LatencyTrace_CaptureDone()
+#define LATENCY_TRACE_CAPTURE(seq)				LatencyTrace_Record(LAT_STAGE_CAPTURE, (seq), LatencyTrace_GetCaptureUs())
+// Time a call in CPU cycles, BEGIN and END go in the same block. The cycle counter is per core, both ends run on the caller's
+#define LATENCY_FUNC_BEGIN(func)				const uint32_t latFuncStart_##func = esp_cpu_get_cycle_count()
+#define LATENCY_FUNC_END(func)					LatencyTrace_RecordFunc((func), esp_cpu_get_cycle_count() - latFuncStart_##func)
+
+void LatencyTrace_Init(void);
+
+void IRAM_ATTR LatencyTrace_Record(const latencyStage_t stage, const uint32_t seq, const uint32_t timeUs);
+
+void IRAM_ATTR LatencyTrace_CaptureDone(void);
+
+uint32_t LatencyTrace_GetCaptureUs(void);
+
+void LatencyTrace_GetStats(latencyStats_t* pStats);
+
+const char* LatencyTrace_GetStageName(const uint8_t stat);
+
+void LatencyTrace_RecordFunc(const latencyFunc_t func, const uint32_t cycles);
+
+void LatencyTrace_GetFuncStats(latencyFuncStats_t* pStats);
+
+const char* LatencyTrace_GetFuncName(const uint8_t func);
+
+#else
+
+#define LATENCY_TRACE(stage, seq)				do{}while(0)
+#define LATENCY_TRACE_AT(stage, seq, timeUs)	do{}while(0)
+#define LATENCY_TRACE_CAPTURE_DONE()			do{}while(0)
+#define LATENCY_TRACE_CAPTURE(seq)				do{}while(0)
+#define LATENCY_FUNC_BEGIN(func)				do{}while(0)
+#define LATENCY_FUNC_END(func)					do{}while(0)
+
+#endif
+
+#endif //__LATENCYTRACE_H__
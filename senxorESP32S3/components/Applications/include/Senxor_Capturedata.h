@@ -3,6 +3,8 @@
 
 #include <stdint.h>
 #include <esp_attr.h>			//Using ESP attributes
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "DrvSPIHost.h"
 
 
@@ -26,6 +28,31 @@
 #define ERROR_EEPROM_VERIFY_ERROR		0x2000
 #define ERROR_EEPROM_WRITE_ERROR		32
 
+// Capture modes reported by Capture_GetIsrStats
+#define CAPTURE_MODE_POLLED				0x00	// Per-word SPI transfers inside the DATA_AV ISR
+#define CAPTURE_MODE_DMA				0x01	// One GDMA burst per FIFO threshold
+
+// Notification bit set on the frame task when a frame is complete
+#define CAPTURE_NOTIFY_FRAME			(1 << 0)
+
+// Time spent in capture interrupts, one block is one FIFO threshold
+typedef struct captureIsrStats{
+	uint8_t mMode;						// CAPTURE_MODE_*
+	uint32_t mBlocks;					// Blocks captured
+	uint32_t mAvgCycles;				// Average CPU cycles in ISRs per block
+	uint32_t mMaxCycles;				// Longest single ISR in CPU cycles
+	uint32_t mOverruns;					// DATA_AV raised while a burst was still running
+}captureIsrStats_t;
+
+void Capture_Init(void);
+
+void Capture_SetFrameTask(TaskHandle_t task);
+
+void Capture_Reset(void);
+
+void Capture_GetIsrStats(captureIsrStats_t* pStats, const bool reset);
+
+int64_t Capture_GetFrameTimeUs(void);
 
 void IRAM_ATTR Data_AV_FIFO_Int_Handler(void* arg);
 #endif //__SENXOR_CAPTUREDATA_H__
@@ -0,0 +1,32 @@
+#ifndef __UNITCONVERT_H__
+#define __UNITCONVERT_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "Customer_Interface.h"
+
+#define UNIT_MODE_COUNT					7		// MCU_REG_31 unit modes, 0 and 3 send raw Kelvin
+#define UNIT_TGAIN_HIGH_RES				0x80	// 0xB9 bit 7, raw frame units are 0.01 K instead of 0.1 K
+#define UNIT_RAW_VALUES					65536
+
+// Unit conversion of a raw pixel v, bit for bit the float code it replaced.
+// Integer modes take the quotient of (mMul * v + mAdd) / mDiv, 273.15 K being
+// 5463/20, then step toward zero where pRound has the bit of v set.
+typedef struct unitScale{
+	int32_t mMul;
+	int32_t mAdd;
+	int32_t mDiv;
+	uint8_t mMode;						// MCU_REG_31
+	bool mFloat;						// Low 16 bits of the IEEE float, computed by the float code
+	float mDivide;						// Raw units per kelvin of the float code, 10 or 100
+	const uint8_t* pRound;				// Bit v set: the float code gives one less in magnitude, NULL for none
+}unitScale_t;
+
+const unitScale_t* UnitConvert_GetScale(uint8_t mode, uint8_t Tgain);
+
+void UnitConvert_Frame(uint16_t* buffer, int l_FrameSize, const unitScale_t* pScale, uint16_t* pMin, uint16_t* pMax);
+
+void UnitConvert_Fused(uint16_t* buffer, int l_FrameSize, const unitScale_t* pScale, const convCorr_t* pCorr,
+		const pixPatch_t* pPatch, uint16_t patchCount, uint16_t* pMin, uint16_t* pMax);
+
+#endif //__UNITCONVERT_H__
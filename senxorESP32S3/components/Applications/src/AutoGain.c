@@ -7,10 +7,13 @@
  ******************************************************************************/
 
 #include "AutoGain.h"
+#include "Customer_Interface.h"
 
 
+#define TOP_K			10		// Hottest pixels kept per frame
+#define TOP_K_TRIM		5		// Hottest of those ignored as dead pixels
+
 const uint8_t MaxFrame = 100;
-const uint8_t Temp_Arr_Size = 10;
 uint8_t Gain_Switch_Completed = 0;
 uint8_t PrevMode = 0;
 uint8_t PrevIntergrator = 0;
@@ -22,38 +25,63 @@ uint8_t B9_State;
 int Firmware_Averaging = 0;
 int Pix_Cnt = FRAMEWIDTH_BUF*(FRAMEHEIGHT_BUF-2);
 int Pix_Max = 0;
-uint16_t Temp_Arr[10];
-
 
-int compare (const void * num1, const void * num2) {
-   if(*(uint16_t*)num1 > *(uint16_t*)num2)
-    return 1;
-   else
-    return -1;
-}
 
 /******************************************************************************
  * @brief       Get_Max
- * @param       Arr -> Array to be sorted
-								len -> Lenght of array
+ * @param       Frame -> Frame buffer
+								start -> First pixel to scan
+								stop -> End of the scan, excluded
  * @return      Avereged Max value in frame
- * @details     Calculated max value in frame ignoring dead pixels
+ * @details     Calculated max value in frame ignoring dead pixels: mean of the
+								TOP_K hottest pixels without the TOP_K_TRIM hottest. One pass with
+								a TOP_K entry min-heap, so the cost only depends on the frame size.
  *****************************************************************************/
-int Get_Max(uint16_t arr[], int len)
+int Get_Max(const uint16_t* Frame, int start, int stop)
 {
-	int i,c=0;
-	int start = 0;
-	int stop = len-5;		// Remove top 5 pixels
-	int sum = 0;
-		
-	qsort(arr, len, sizeof(uint16_t), compare);
-	
+	uint16_t heap[TOP_K] = {0};	// heap[0] is the smallest of the TOP_K hottest pixels
+	int i, sum = 0;
+
 	for(i = start; i < stop; i++)
 	{
-		sum+=arr[i];
-		c++;
+		uint16_t value = Frame[i];
+		if(value <= heap[0])
+			continue;
+
+		int node = 0;			// Replace the root and sift it down
+		while(1)
+		{
+			int child = 2 * node + 1;
+			if(child >= TOP_K)
+				break;
+			if(child + 1 < TOP_K && heap[child + 1] < heap[child])
+				child++;
+			if(heap[child] >= value)
+				break;
+			heap[node] = heap[child];
+			node = child;
+		}
+		heap[node] = value;
+	}
+
+	// Heap order is not sorted order: drop the TOP_K_TRIM largest by selection
+	uint16_t kept[TOP_K];
+	memcpy(kept, heap, sizeof(kept));
+	for(int t = 0; t < TOP_K_TRIM; t++)
+	{
+		int maxIdx = 0;
+		for(i = 1; i < TOP_K - t; i++)
+		{
+			if(kept[i] > kept[maxIdx])
+				maxIdx = i;
+		}
+		kept[maxIdx] = kept[TOP_K - t - 1];
+	}
+	for(i = 0; i < TOP_K - TOP_K_TRIM; i++)
+	{
+		sum += kept[i];
 	}
-	return sum/c;
+	return sum / (TOP_K - TOP_K_TRIM);
 }
 
 
@@ -69,7 +97,6 @@ void AutoGain(void)
 {
 	uint8_t CaptureState = 0;
 	uint8_t Mode = 0;
-	int c = 0, i = 0;
 	
 	Firmware_Averaging = Acces_Read_Reg(0xB4);
 	Mode = Acces_Read_Reg(0xB9) & 0x0F;
@@ -95,16 +122,7 @@ void AutoGain(void)
 		{
 			GetTransmitFrameBuffer();
 			
-			for (i = FRAMEWIDTH_BUF*2 + 12; i < Pix_Cnt; i+=2)
-			{
-				if (c > Temp_Arr_Size-1)
-					c = 0;
-				if (TransmitFrame->TXBuf[i] > Temp_Arr[c])
-					Temp_Arr[c] = TransmitFrame->TXBuf[i];
-				c++;
-			}
-			
-			Pix_Max = Get_Max(Temp_Arr, Temp_Arr_Size); // sort and get avg of max
+			Pix_Max = Get_Max(TransmitFrame->TXBuf, FRAMEWIDTH_BUF*2 + 12, Pix_Cnt); // avg of max, every pixel
 			if (High_Res == 0x80)
 			{
 				Pix_Max = Pix_Max / 100 - 273;
@@ -126,6 +144,7 @@ void AutoGain(void)
 				Acces_Write_Reg(0x08, 0x14); // Set gain 1x 
 				Acces_Write_Reg(0x0A, 0x03);
 				Acces_Write_Reg(0xB9, B9_State);
+				Customer_InvalidateTgain();
 				Acces_Write_Reg(0xB1, CaptureState); // Resume previus capture state
 				
 				Gain_Switch_Completed = 1;
@@ -142,6 +161,7 @@ void AutoGain(void)
 				Acces_Write_Reg(0x08, 0x14); // Set gain 0.5x 
 				Acces_Write_Reg(0x0A, 0x01);
 				Acces_Write_Reg(0xB9, B9_State);
+				Customer_InvalidateTgain();
 				Acces_Write_Reg(0xB1, CaptureState); // Resume previus capture state
 
 				Gain_Switch_Completed = 2;
@@ -158,6 +178,7 @@ void AutoGain(void)
 				Acces_Write_Reg(0x08, 0x04); // Set Gain 0.25x
 				Acces_Write_Reg(0x0A, 0x01);
 				Acces_Write_Reg(0xB9, B9_State);
+				Customer_InvalidateTgain();
 				Acces_Write_Reg(0xB1, CaptureState); // Resume previus capture state
 				
 				Gain_Switch_Completed = 3;
@@ -166,11 +187,6 @@ void AutoGain(void)
 			FrameCount = 0;
 			AutoGainReady = 0;
 			
-			for (i = 0; i < Temp_Arr_Size; i++)
-			{
-					Temp_Arr[i] = 0;
-			}
-			
 		}
 		else if (Mode > PRESET_AUTO)
 		{
@@ -13,12 +13,15 @@
 #include "SenXorLib.h"
 #include "SenXor_FLASH.h"
 #include "Customer_Interface.h"
+#include "FrameStats.h"
 #ifdef WITH_TOF_VL53L1
 #include "tof_vl53l1_user.h"
 #endif
 #include "defines.h"
 #include "version.h"
 #include "imageProcessingLib.h"
+#include "LatencyTrace.h"
+#include "UnitConvert.h"
 
 extern MCU_REG MCU_REGISTER;
 extern MERGE MergeBuffer;
@@ -42,6 +45,15 @@ union FP16_union {
   unsigned long   ul;           /* Unsigned long value */
 };
 
+static volatile uint32_t TgainWrites = 0;						// Writes of 0xB9 since boot
+static uint32_t TgainReadAt = 0xFFFFFFFF;						// TgainWrites when Tgain was read, capture task only
+static uint8_t TgainCache = 0;									// Register 0xB9
+
+static const convCorr_t* volatile ConvertCorr = NULL;			// Per-pixel gain and offset, NULL for none
+static const pixPatch_t* volatile ConvertPatch = NULL;			// Bad pixels, ascending mDst
+static volatile uint16_t ConvertPatchCount = 0;
+static bool ConvertPatched = false;								// The last frame had its bad pixels patched here
+
 /******************************************************************************
  * @brief       Application_Version
  * @param       None
@@ -254,118 +266,99 @@ void Initialize_Filter(void)
 
 
 
+/******************************************************************************
+ * @brief       Customer_GetTgain
+ * @param       NONE
+ * @return      Register 0xB9
+ * @details     Read over SPI only after a write of 0xB9, not on every frame.
+ * 				Called by the capture task.
+ *****************************************************************************/
+uint8_t Customer_GetTgain(void)
+{
+	const uint32_t writes = TgainWrites;
+
+	if(writes != TgainReadAt)
+	{
+		TgainCache = Acces_Read_Reg(0xB9);
+		TgainReadAt = writes;					// A write during the read is seen on the next call
+	}
+	return TgainCache;
+}
+
+/******************************************************************************
+ * @brief       Customer_InvalidateTgain
+ * @param       NONE
+ * @return      NONE
+ * @details     Call after every write of 0xB9, the next frame reads it again
+ *****************************************************************************/
+void Customer_InvalidateTgain(void)
+{
+	TgainWrites++;
+}
+
 /******************************************************************************
  * @brief       Update min max header
  * @param       uint16_t* buffer, framesize
  * @return      NONE
- * @details     this Function will be called from custumer interface to update min max header
+ * @details     this Function will be called from custumer interface to update min max header.
+ * 				Same output as the float code it replaced, see UnitConvert.c.
+ * 				With a correction map or bad pixels set, UnitConvert_Fused applies them
+ * 				in the same pass, Kelvin included.
  *****************************************************************************/
 void COnvert_Image_Transfer_Format(uint16_t* buffer, int l_FrameSize)
 {
-	uint16_t i = 0;
-	uint16_t minT = 0xFFFF;
-	uint16_t maxT = 0;
-	uint16_t temp ;
-  	float temp_res_divide=10 ;
+	const unitScale_t* pScale = UnitConvert_GetScale(Image_Processing.MCU_REG_31.Setting, Customer_GetTgain());
+	const convCorr_t* pCorr = ConvertCorr;
+	const uint16_t patchCount = ConvertPatchCount;
 
-	union FP16_union temp_data_f16 ;
-	float temp_data ;
-
-	float Celsius_Scale = 273.15;
-	uint16_t Tgain = Acces_Read_Reg(0xB9);
-
-	if((Tgain&0x80) == 0x80)
+	ConvertPatched = (patchCount > 0);
+	if(pCorr != NULL || patchCount > 0)
 	{
-		temp_res_divide=100 ;
+		UnitConvert_Fused(buffer, l_FrameSize, pScale, pCorr, ConvertPatch, patchCount, &minTemp, &maxTemp);
+		return;
 	}
-	switch(Image_Processing.MCU_REG_31.Setting)
-	{
-		case 1:
-			for (i=0; i<l_FrameSize; i++)
-			{
-				temp_data = buffer[i]/temp_res_divide;
-				temp_data = (temp_data - Celsius_Scale)*temp_res_divide;
-				buffer[i]= (int)temp_data;
-			}
-			temp_data = minTemp/temp_res_divide;  					//min  pixel
-			temp_data = (temp_data - Celsius_Scale)*temp_res_divide;
-			minTemp= (int)temp_data;
-
-			temp_data = maxTemp/temp_res_divide;  					//max  pixel
-			temp_data = (temp_data - Celsius_Scale)*temp_res_divide;
-			maxTemp= (int)temp_data;
-
-
-
-		break;
-		case 2:
-			for (i=0; i<l_FrameSize; i++)
-			{
-				temp_data = buffer[i]/temp_res_divide;
-				temp_data = (float)(((temp_data - Celsius_Scale) * 9/5) + 32)*temp_res_divide;
-				buffer[i]= (int)temp_data;
-			}
-			temp_data = minTemp/temp_res_divide;  					//min  pixel
-			temp_data = (float)(((temp_data - Celsius_Scale) * 9/5) + 32)*temp_res_divide;
-			minTemp= (int)temp_data;
-
-			temp_data = maxTemp/temp_res_divide;					//max  pixel
-			temp_data = (float)(((temp_data - Celsius_Scale) * 9/5) + 32)*temp_res_divide;
-			maxTemp= (int)temp_data;
-		break;
-		case 4:
-			for (i=0; i<l_FrameSize; i++)
-			{
-
-				temp_data_f16.fp = buffer[i]/temp_res_divide;
-
-				buffer[i]= (uint16_t)temp_data_f16.ul;
-			}
-			temp_data_f16.fp = minTemp/temp_res_divide;  					//min  pixel
-			minTemp= (uint16_t)temp_data_f16.ul;
-
-			temp_data_f16.fp = maxTemp/temp_res_divide;					//max  pixel
-			maxTemp= (uint16_t)temp_data_f16.ul;
-
-		break;
-		case 5:
-			for (i=0; i<l_FrameSize; i++)
-			{
-				temp_data = buffer[i]/temp_res_divide;
-				temp_data_f16.fp = (temp_data - Celsius_Scale);
-				buffer[i]= (uint16_t)temp_data_f16.ul;
-			}
-
-			temp_data = minTemp/temp_res_divide;  					//min  pixel
-			temp_data_f16.fp = (temp_data - Celsius_Scale);
-			minTemp= (uint16_t)temp_data_f16.ul;
-
-			temp_data = maxTemp/temp_res_divide;					//max  pixel
-			temp_data_f16.fp = (temp_data - Celsius_Scale);
-			maxTemp= (uint16_t)temp_data_f16.ul;
-
-		break;
-		case 6:
-			for (i=0; i<l_FrameSize; i++)
-			{
-
-				temp_data = buffer[i]/10.0;
-				temp_data_f16.fp = (float)(((temp_data - Celsius_Scale) * 9/5) + 32);
-				buffer[i]= (uint16_t)temp_data_f16.ul;
-			}
-			temp_data = minTemp/10.0;  					//min  pixel
-			temp_data_f16.fp = (float)(((temp_data - Celsius_Scale) * 9/5) + 32);
-			minTemp= (uint16_t)temp_data_f16.ul;
-
-			temp_data = maxTemp/10.0;						//max  pixel
-			temp_data_f16.fp = (float)(((temp_data - Celsius_Scale) * 9/5) + 32);
-			maxTemp= (uint16_t)temp_data_f16.ul;
-		break;
 
+	if(pScale != NULL)
+	{
+		UnitConvert_Frame(buffer, l_FrameSize, pScale, &minTemp, &maxTemp);
+	}
+}
 
+/******************************************************************************
+ * @brief       Customer_SetPixelCorrection
+ * @param       pMap - gain and offset of every image pixel, NULL for none
+ * @return      NONE
+ * @details     The map is read by every later frame, its owner keeps it unchanged
+ * 				until it is replaced. Call between two frames of the capture task.
+ *****************************************************************************/
+void Customer_SetPixelCorrection(const convCorr_t* pMap)
+{
+	ConvertCorr = pMap;
+}
 
-	}
+/******************************************************************************
+ * @brief       Customer_SetPixelPatch
+ * @param       pPatch - bad pixels, ascending mDst, count - entries, 0 for none
+ * @return      NONE
+ * @details     Bad pixels patched by the conversion pass. Entries past count may
+ * 				change at any time, the first count may not until count changes.
+ *****************************************************************************/
+void Customer_SetPixelPatch(const pixPatch_t* pPatch, const uint16_t count)
+{
+	ConvertPatchCount = 0;
+	ConvertPatch = pPatch;
+	ConvertPatchCount = count;
+}
 
+/******************************************************************************
+ * @brief       Customer_GetPixelPatched
+ * @param       NONE
+ * @return      true if the last converted frame had its bad pixels patched
+ * @details     The frame of DataFrameGetPointer, for the owner of the bad pixel map
+ *****************************************************************************/
+bool Customer_GetPixelPatched(void)
+{
+	return ConvertPatched;
 }
 
 
@@ -385,7 +378,7 @@ void COnvert_Image_Transfer_Format_header(uint16_t* ProcessDataFrame_TXBuf)
 	union FP16_union temp_data_f16 ;
 	float temp_data ;
 	float Celsius_Scale = 273.15;
-	uint16_t Tgain = Acces_Read_Reg(0xB9);
+	uint16_t Tgain = Customer_GetTgain();
 
 	if((Tgain&0x80) == 0x80)
 	{
@@ -492,7 +485,7 @@ void Customer_imageprocessing(uint16_t* buffer, int l_FrameSize, uint16_t Frame_
 {
 #ifdef MEDIAN_STARK
 
-	uint16_t Tgain = Acces_Read_Reg(0xB9);
+	uint16_t Tgain = Customer_GetTgain();
 	uint16_t module_type =  Acces_Read_Reg(0xBB);
 	uint16_t F_FrameSize= l_FrameSize-FRAMEWIDTH_BUF;
 	minTemp = Frame_min;
@@ -501,12 +494,17 @@ void Customer_imageprocessing(uint16_t* buffer, int l_FrameSize, uint16_t Frame_
 	STARK_ImagePRocessing(buffer,F_FrameSize, &minTemp, &maxTemp, Tgain, module_type);
 	MEDIAN_ImagePRocessing(buffer,F_FrameSize);
 	KXMS_stabilizer(buffer, F_FrameSize, &minTemp, &maxTemp);
+	FrameStats_Process(buffer, F_FrameSize, Frame_min, Frame_max);	// Histogram and percentiles, raw units
+	LATENCY_FUNC_BEGIN(LAT_FUNC_CONVERT);
 	COnvert_Image_Transfer_Format(buffer, F_FrameSize);
+	LATENCY_FUNC_END(LAT_FUNC_CONVERT);
 
 	// Find min max if KXMS_stabilizer is not used
 	if ((Image_Processing.MCU_REG_25.GetSet.Roll==0)&&(Image_Processing.MCU_REG_25.GetSet.KXMS==0)&&(Image_Processing.MCU_REG_20.GetSet.STARK_Enable==0))
 	{
+		LATENCY_FUNC_BEGIN(LAT_FUNC_MIN_MAX);
 		Update_min_max_header(buffer, F_FrameSize);
+		LATENCY_FUNC_END(LAT_FUNC_MIN_MAX);
 	}
 
 #endif
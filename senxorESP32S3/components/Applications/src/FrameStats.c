@@ -0,0 +1,152 @@
+/**************************************************************************//**
+ * @file     FrameStats.c
+ * @version  V1.00
+ * @brief    Histogram and percentile statistics of the processed frame
+ *
+ * @details  One pass over the frame fills a FRAME_STATS_BINS bin histogram in
+ *           internal RAM. The bins start at the frame minimum of the library
+ *           with a power of 2 width covering the frame range, so the
+ *           percentiles are exact for scenes spanning less than
+ *           FRAME_STATS_BINS raw counts and accurate to one bin otherwise.
+ ******************************************************************************/
+#include <stdint.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "SenXorLib.h"
+#include "FrameStats.h"
+#include "Customer_Interface.h"
+
+static uint16_t StatsHist[FRAME_STATS_BINS];						// Fine histogram of the running frame
+static frameStats_t StatsResult;									// Last completed frame
+static portMUX_TYPE StatsLock = portMUX_INITIALIZER_UNLOCKED;
+
+/******************************************************************************
+ * @brief       FrameStats_Percentile
+ * @param       count - pixels in the histogram, rank - percentile in %, lo/shift - bin layout
+ * @return      Value at the percentile (nearest rank)
+ * @details     None
+ *****************************************************************************/
+static uint16_t FrameStats_Percentile(uint32_t count, uint8_t rank, uint16_t lo, uint8_t shift, uint16_t min, uint16_t max)
+{
+	const uint32_t target = (count * rank + 99) / 100;
+	uint32_t cumulative = 0;
+	int bin = 0;
+
+	for (; bin < FRAME_STATS_BINS - 1; bin++)
+	{
+		cumulative += StatsHist[bin];
+		if (cumulative >= target)
+			break;
+	}
+
+	int32_t value = lo + ((int32_t)bin << shift) + ((1 << shift) >> 1);
+	if (value < min)
+		value = min;
+	if (value > max)
+		value = max;
+	return (uint16_t)value;
+}
+
+/******************************************************************************
+ * @brief       FrameStats_Process
+ * @param       buffer - image pixels, l_FrameSize - number of pixels, Frame_min / Frame_max - range given by the library
+ * @return      NONE
+ * @details     Called from Customer_imageprocessing before the unit conversion
+ *****************************************************************************/
+void FrameStats_Process(const uint16_t* buffer, int l_FrameSize, uint16_t Frame_min, uint16_t Frame_max)
+{
+	frameStats_t stats;
+	uint16_t minT = 0xFFFF;
+	uint16_t maxT = 0;
+	uint32_t sum = 0;
+	uint8_t shift = 0;
+	const uint16_t lo = (Frame_min < Frame_max) ? Frame_min : Frame_max;
+	const uint32_t range = (Frame_min < Frame_max) ? (Frame_max - Frame_min) : 0;
+
+	if (buffer == NULL || l_FrameSize <= 0)
+		return;
+
+	while ((range >> shift) >= FRAME_STATS_BINS)
+		shift++;
+
+	memset(StatsHist, 0, sizeof(StatsHist));
+
+	for (int i = 0; i < l_FrameSize; i++)
+	{
+		const uint16_t temp = buffer[i];
+		int32_t bin = ((int32_t)temp - lo) >> shift;
+
+		bin = (bin < 0) ? 0 : (bin >= FRAME_STATS_BINS) ? FRAME_STATS_BINS - 1 : bin;	// Filters may leave the library range
+		StatsHist[bin]++;
+		sum += temp;
+		minT = (temp < minT) ? temp : minT;
+		maxT = (temp > maxT) ? temp : maxT;
+	}
+
+	stats.mMin = minT;
+	stats.mMax = maxT;
+	stats.mMean = (uint16_t)((sum + l_FrameSize / 2) / l_FrameSize);
+	stats.mP50 = FrameStats_Percentile(l_FrameSize, 50, lo, shift, minT, maxT);
+	stats.mP95 = FrameStats_Percentile(l_FrameSize, 95, lo, shift, minT, maxT);
+	stats.mP99 = FrameStats_Percentile(l_FrameSize, 99, lo, shift, minT, maxT);
+	stats.mBucketLo = lo;
+	stats.mBucketShift = shift + 4;										// 16 fine bins per bucket
+	stats.mScale = ((Customer_GetTgain() & 0x80) == 0x80) ? 100 : 10;
+
+	for (int b = 0; b < FRAME_STATS_BUCKETS; b++)
+	{
+		uint16_t count = 0;
+		for (int j = 0; j < FRAME_STATS_BINS_PER_BUCKET; j++)
+		{
+			count += StatsHist[b * FRAME_STATS_BINS_PER_BUCKET + j];
+		}
+		stats.mBucket[b] = count;
+	}
+
+	portENTER_CRITICAL(&StatsLock);
+	StatsResult = stats;
+	portEXIT_CRITICAL(&StatsLock);
+}
+
+/******************************************************************************
+ * @brief       FrameStats_Get
+ * @param       pStats - output
+ * @return      NONE
+ * @details     Statistics of the last processed frame
+ *****************************************************************************/
+void FrameStats_Get(frameStats_t* pStats)
+{
+	portENTER_CRITICAL(&StatsLock);
+	*pStats = StatsResult;
+	portEXIT_CRITICAL(&StatsLock);
+}
+
+/******************************************************************************
+ * @brief       FrameStats_ReadRegister
+ * @param       Address - REG_FSTAT_FIRST to REG_FSTAT_LAST
+ * @return      Register value
+ * @details     None
+ *****************************************************************************/
+uint16_t FrameStats_ReadRegister(int Address)
+{
+	frameStats_t stats;
+
+	FrameStats_Get(&stats);
+	switch (Address)
+	{
+		case REG_FSTAT_MIN:
+		return stats.mMin;
+		case REG_FSTAT_MAX:
+		return stats.mMax;
+		case REG_FSTAT_MEAN:
+		return stats.mMean;
+		case REG_FSTAT_P50:
+		return stats.mP50;
+		case REG_FSTAT_P95:
+		return stats.mP95;
+		case REG_FSTAT_P99:
+		return stats.mP99;
+		default:
+		return 0;
+	}
+}
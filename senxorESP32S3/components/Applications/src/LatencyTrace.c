@@ -0,0 +1,360 @@
+/**************************************************************************//**
+ * @file     LatencyTrace.c
+ * @version  V1.00
+ * @brief    Per-stage latency of the capture to network frame pipeline
+ *
+ * @details  Every stage writes one record (frame number, stage, time) into the
+ *           ring of the core it runs on. A writer claims its slot with an
+ *           atomic increment, so tasks and interrupts on the same core never
+ *           wait for each other, and tags the slot once the record is
+ *           complete. The reader copies the rings, drops records whose tag
+ *           changed while they were read, and pairs each record with the
+ *           previous stage of the same frame.
+ *
+ *           Times come from esp_timer. The CPU cycle counters of the two cores
+ *           are not synchronised, and stages of one frame run on both.
+ *
+ *           Analytics functions are timed apart from the stages, in CPU cycles
+ *           of the one core a call runs on, converted to ns at the clock of the
+ *           moment. Their totals run from boot, so one figure per function
+ *           compares builds on the same scene.
+ ******************************************************************************/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "LatencyTrace.h"
+
+#if CONFIG_MI_LATENCY_TRACE_EN
+
+typedef struct latencyRecord{
+	atomic_uint mTag;					// Ring position + 1 once the record is complete, 0 while written
+	uint32_t mSeq;						// Frame number
+	uint32_t mTimeUs;					// esp_timer, low 32 bits
+	uint8_t mStage;						// latencyStage_t
+}latencyRecord_t;
+
+typedef struct latencyRing{
+	atomic_uint mHead;					// Next position to claim
+	latencyRecord_t mRecord[LAT_RING_SIZE];
+}latencyRing_t;
+
+_Static_assert((LAT_RING_SIZE & (LAT_RING_SIZE - 1)) == 0, "CONFIG_MI_LATENCY_TRACE_DEPTH must be a power of 2");
+
+static latencyRing_t TraceRing[portNUM_PROCESSORS];									// Internal RAM, atomics do not work on PSRAM
+static volatile uint32_t TraceCaptureUs = 0;										// Time of the last captured frame
+EXT_RAM_BSS_ATTR static latencyRecord_t TraceSnapshot[portNUM_PROCESSORS * LAT_RING_SIZE];	// Copy sorted by the reader
+EXT_RAM_BSS_ATTR static uint32_t TraceSamples[portNUM_PROCESSORS * LAT_RING_SIZE];			// Durations of one stage
+static SemaphoreHandle_t TraceReadLock = NULL;										// One reader at a time
+static StaticSemaphore_t TraceReadLockBuffer;
+
+typedef struct latencyFuncTotal{
+	uint32_t mCalls;
+	uint32_t mMinNs;
+	uint32_t mMaxNs;
+	uint64_t mSumNs;
+}latencyFuncTotal_t;
+
+static latencyFuncTotal_t TraceFunc[LAT_FUNC_COUNT];
+static portMUX_TYPE TraceFuncLock = portMUX_INITIALIZER_UNLOCKED;					// 64 bit sum, read from another core
+
+// Stage a stage is measured from
+static const uint8_t TraceParent[LAT_STAT_COUNT] = {
+	[LAT_STAGE_CAPTURE] = LAT_STAGE_CAPTURE,
+	[LAT_STAGE_RECEIVE] = LAT_STAGE_CAPTURE,
+	[LAT_STAGE_ANALYTICS] = LAT_STAGE_RECEIVE,
+#if CONFIG_MI_SCHED_PROFILE_SPLIT
+	[LAT_STAGE_PUBLISH] = LAT_STAGE_RECEIVE,			// Published while senxorAnalyticsTask works on its copy
+#else
+	[LAT_STAGE_PUBLISH] = LAT_STAGE_ANALYTICS,
+#endif
+	[LAT_STAGE_NET_SEND] = LAT_STAGE_PUBLISH,
+	[LAT_STAGE_USB_SEND] = LAT_STAGE_PUBLISH,
+	[LAT_STAT_TOTAL] = LAT_STAGE_CAPTURE,
+};
+
+static const char* const TraceName[LAT_STAT_COUNT] = {
+	[LAT_STAGE_CAPTURE] = "capture",
+	[LAT_STAGE_RECEIVE] = "receive",
+	[LAT_STAGE_ANALYTICS] = "analytics",
+	[LAT_STAGE_PUBLISH] = "publish",
+	[LAT_STAGE_NET_SEND] = "net_send",
+	[LAT_STAGE_USB_SEND] = "usb_send",
+	[LAT_STAT_TOTAL] = "total",
+};
+
+static const char* const TraceFuncName[LAT_FUNC_COUNT] = {
+	[LAT_FUNC_QUADRANT] = "quadrant",
+	[LAT_FUNC_CONVERT] = "convert",
+	[LAT_FUNC_MIN_MAX] = "min_max",
+};
+
+static uint32_t LatencyTrace_Snapshot(void);
+static void LatencyTrace_Reduce(latencyStats_t* pStats, const uint32_t samples);
+static int LatencyTrace_CompareRecord(const void* a, const void* b);
+static int LatencyTrace_CompareU32(const void* a, const void* b);
+
+/******************************************************************************
+ * @brief       LatencyTrace_Init
+ * @param       none
+ * @return      None
+ * @details     Clear the rings. Call once before the capture starts.
+ *****************************************************************************/
+void LatencyTrace_Init(void)
+{
+	for (uint8_t core = 0; core < portNUM_PROCESSORS; core++)
+	{
+		atomic_init(&TraceRing[core].mHead, 0);
+		for (uint32_t i = 0; i < LAT_RING_SIZE; i++)
+		{
+			atomic_init(&TraceRing[core].mRecord[i].mTag, 0);
+		}
+	}
+	TraceReadLock = xSemaphoreCreateMutexStatic(&TraceReadLockBuffer);
+	memset(TraceFunc, 0, sizeof(TraceFunc));
+}
+
+/******************************************************************************
+ * @brief       LatencyTrace_Record
+ * @param       stage - Stage reached, seq - frame number, timeUs - esp_timer time
+ * @return      None
+ * @details     Lock free, callable from tasks and interrupts
+ *****************************************************************************/
+void IRAM_ATTR LatencyTrace_Record(const latencyStage_t stage, const uint32_t seq, const uint32_t timeUs)
+{
+	latencyRing_t* ring = &TraceRing[esp_cpu_get_core_id()];
+	const uint32_t pos = atomic_fetch_add_explicit(&ring->mHead, 1, memory_order_relaxed);
+	latencyRecord_t* rec = &ring->mRecord[pos & (LAT_RING_SIZE - 1)];
+
+	atomic_store_explicit(&rec->mTag, 0, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	rec->mSeq = seq;
+	rec->mTimeUs = timeUs;
+	rec->mStage = (uint8_t)stage;
+	atomic_store_explicit(&rec->mTag, pos + 1, memory_order_release);
+}
+
+/******************************************************************************
+ * @brief       LatencyTrace_CaptureDone
+ * @param       none
+ * @return      None
+ * @details     Latch the time the last block of a frame was read
+ *****************************************************************************/
+void IRAM_ATTR LatencyTrace_CaptureDone(void)
+{
+	TraceCaptureUs = (uint32_t)esp_timer_get_time();
+}
+
+/******************************************************************************
+ * @brief       LatencyTrace_GetCaptureUs
+ * @param       none
+ * @return      Time of the last captured frame
+ * @details     None
+ *****************************************************************************/
+uint32_t LatencyTrace_GetCaptureUs(void)
+{
+	return TraceCaptureUs;
+}
+
+/******************************************************************************
+ * @brief       LatencyTrace_GetStats
+ * @param       pStats - LAT_STAT_COUNT entries, indexed by latencyStage_t and LAT_STAT_TOTAL
+ * @return      None
+ * @details     Min / avg / p99 / max of every stage over the frames still in
+ * 				the rings. The capture entry only counts frames. Runs in the
+ * 				caller's task, the writers are never held up.
+ *****************************************************************************/
+void LatencyTrace_GetStats(latencyStats_t* pStats)
+{
+	memset(pStats, 0, sizeof(latencyStats_t) * LAT_STAT_COUNT);
+	if (TraceReadLock == NULL)
+		return;
+
+	xSemaphoreTake(TraceReadLock, portMAX_DELAY);
+	const uint32_t count = LatencyTrace_Snapshot();
+	qsort(TraceSnapshot, count, sizeof(latencyRecord_t), LatencyTrace_CompareRecord);	// By frame, then stage
+
+	for (uint8_t stat = 0; stat < LAT_STAT_COUNT; stat++)
+	{
+		const uint8_t stage = (stat == LAT_STAT_TOTAL) ? LAT_STAGE_NET_SEND : stat;
+		const uint8_t parent = TraceParent[stat];
+		uint32_t samples = 0;
+		uint32_t first = 0;											// First record of the current frame
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (TraceSnapshot[i].mSeq != TraceSnapshot[first].mSeq)
+				first = i;
+			if (TraceSnapshot[i].mStage != stage)
+				continue;
+			if (stage == LAT_STAGE_CAPTURE)
+			{
+				TraceSamples[samples++] = 0;
+				continue;
+			}
+
+			for (uint32_t j = first; j < i; j++)					// Records of a frame are sorted by stage
+			{
+				if (TraceSnapshot[j].mStage == parent)
+				{
+					TraceSamples[samples++] = TraceSnapshot[i].mTimeUs - TraceSnapshot[j].mTimeUs;
+					break;
+				}
+			}
+		}
+
+		LatencyTrace_Reduce(&pStats[stat], samples);
+	}
+	xSemaphoreGive(TraceReadLock);
+}
+
+/******************************************************************************
+ * @brief       LatencyTrace_GetStageName
+ * @param       stat - latencyStage_t or LAT_STAT_TOTAL
+ * @return      Name used by /metrics, NULL if out of range
+ * @details     None
+ *****************************************************************************/
+const char* LatencyTrace_GetStageName(const uint8_t stat)
+{
+	return (stat < LAT_STAT_COUNT) ? TraceName[stat] : NULL;
+}
+
+/******************************************************************************
+ * @brief       LatencyTrace_RecordFunc
+ * @param       func - Function timed, cycles - CPU cycles of the call
+ * @return      None
+ * @details     Called through LATENCY_FUNC_END
+ *****************************************************************************/
+void LatencyTrace_RecordFunc(const latencyFunc_t func, const uint32_t cycles)
+{
+	if (func >= LAT_FUNC_COUNT)
+		return;
+
+	const uint32_t ns = (uint32_t)(((uint64_t)cycles * 1000) / esp_rom_get_cpu_ticks_per_us());
+	latencyFuncTotal_t* total = &TraceFunc[func];
+
+	taskENTER_CRITICAL(&TraceFuncLock);
+	if (total->mCalls == 0 || ns < total->mMinNs)
+		total->mMinNs = ns;
+	if (ns > total->mMaxNs)
+		total->mMaxNs = ns;
+	total->mSumNs += ns;
+	total->mCalls++;
+	taskEXIT_CRITICAL(&TraceFuncLock);
+}
+
+/******************************************************************************
+ * @brief       LatencyTrace_GetFuncStats
+ * @param       pStats - LAT_FUNC_COUNT entries, indexed by latencyFunc_t
+ * @return      None
+ * @details     Calls and min / avg / max ns of every analytics function since
+ * 				boot
+ *****************************************************************************/
+void LatencyTrace_GetFuncStats(latencyFuncStats_t* pStats)
+{
+	latencyFuncTotal_t totals[LAT_FUNC_COUNT];
+
+	taskENTER_CRITICAL(&TraceFuncLock);
+	memcpy(totals, TraceFunc, sizeof(totals));
+	taskEXIT_CRITICAL(&TraceFuncLock);
+
+	for (uint8_t func = 0; func < LAT_FUNC_COUNT; func++)
+	{
+		pStats[func].mCalls = totals[func].mCalls;
+		pStats[func].mMinNs = totals[func].mMinNs;
+		pStats[func].mAvgNs = (totals[func].mCalls == 0) ? 0 : (uint32_t)(totals[func].mSumNs / totals[func].mCalls);
+		pStats[func].mMaxNs = totals[func].mMaxNs;
+	}
+}
+
+/******************************************************************************
+ * @brief       LatencyTrace_GetFuncName
+ * @param       func - latencyFunc_t
+ * @return      Name used by /metrics, NULL if out of range
+ * @details     None
+ *****************************************************************************/
+const char* LatencyTrace_GetFuncName(const uint8_t func)
+{
+	return (func < LAT_FUNC_COUNT) ? TraceFuncName[func] : NULL;
+}
+
+/******************************************************************************
+ * @brief       LatencyTrace_Snapshot
+ * @param       none
+ * @return      Records copied to TraceSnapshot
+ * @details     Keep a record only if its tag is the same before and after the
+ * 				copy, otherwise a writer wrapped around onto it meanwhile
+ *****************************************************************************/
+static uint32_t LatencyTrace_Snapshot(void)
+{
+	uint32_t count = 0;
+
+	for (uint8_t core = 0; core < portNUM_PROCESSORS; core++)
+	{
+		for (uint32_t i = 0; i < LAT_RING_SIZE; i++)
+		{
+			latencyRecord_t* rec = &TraceRing[core].mRecord[i];
+			const uint32_t tag = atomic_load_explicit(&rec->mTag, memory_order_acquire);
+			if (tag == 0)
+				continue;
+
+			TraceSnapshot[count].mSeq = rec->mSeq;
+			TraceSnapshot[count].mTimeUs = rec->mTimeUs;
+			TraceSnapshot[count].mStage = rec->mStage;
+			atomic_thread_fence(memory_order_acquire);
+			if (atomic_load_explicit(&rec->mTag, memory_order_relaxed) == tag)
+				++count;
+		}
+	}
+	return count;
+}
+
+/******************************************************************************
+ * @brief       LatencyTrace_Reduce
+ * @param       pStats - Result, samples - durations in TraceSamples
+ * @return      None
+ * @details     None
+ *****************************************************************************/
+static void LatencyTrace_Reduce(latencyStats_t* pStats, const uint32_t samples)
+{
+	if (samples == 0)
+		return;
+
+	qsort(TraceSamples, samples, sizeof(uint32_t), LatencyTrace_CompareU32);
+
+	uint64_t sum = 0;
+	for (uint32_t i = 0; i < samples; i++)
+	{
+		sum += TraceSamples[i];
+	}
+
+	pStats->mCount = (samples > UINT16_MAX) ? UINT16_MAX : (uint16_t)samples;
+	pStats->mMinUs = TraceSamples[0];
+	pStats->mAvgUs = (uint32_t)(sum / samples);
+	pStats->mP99Us = TraceSamples[(samples * 99 + 99) / 100 - 1];	// Nearest rank
+	pStats->mMaxUs = TraceSamples[samples - 1];
+}
+
+static int LatencyTrace_CompareRecord(const void* a, const void* b)
+{
+	const latencyRecord_t* ra = (const latencyRecord_t*)a;
+	const latencyRecord_t* rb = (const latencyRecord_t*)b;
+	const int32_t seqDiff = (int32_t)(ra->mSeq - rb->mSeq);			// Survives the frame counter wrap
+
+	if (seqDiff != 0)
+		return (seqDiff < 0) ? -1 : 1;
+	return (int)ra->mStage - (int)rb->mStage;
+}
+
+static int LatencyTrace_CompareU32(const void* a, const void* b)
+{
+	const uint32_t va = *(const uint32_t*)a;
+	const uint32_t vb = *(const uint32_t*)b;
+	return (va > vb) - (va < vb);
+}
+
+#endif
@@ -19,13 +19,121 @@
 #include "SenXorLib.h"
 #include "Senxor_Flash.h"
 #include "Senxor_Capturedata.h"
+#include "LatencyTrace.h"
 #include "defines.h"
 #include "portmacro.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
 
 
 extern void IRAM_ATTR GetReceiveFrameBuffer();
 extern void CaptureProcessFrame(uint16_t tmp);
 
+static portMUX_TYPE mIsrStatsLock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t mIsrBlocks = 0;					// Blocks captured since the last reset
+static uint64_t mIsrCycles = 0;					// CPU cycles spent in capture ISRs since the last reset
+static uint32_t mIsrMaxCycles = 0;				// Longest capture ISR since the last reset
+static uint32_t mIsrOverruns = 0;				// DATA_AV while a burst was running
+static TaskHandle_t mFrameTask = NULL;			// Notified with CAPTURE_NOTIFY_FRAME once a frame is complete
+static int64_t mFrameDoneUs = 0;				// esp_timer time the last frame was complete, guarded by mIsrStatsLock
+
+#if CONFIG_MI_SPI_CAPTURE_DMA
+static bool mDmaReady = false;					// DMA completion interrupt registered
+static volatile bool mDmaBusy = false;			// A burst is in flight
+static volatile uint16_t mDmaWords = 0;			// Words in the running burst
+static bool IRAM_ATTR Capture_DmaDone(const uint8_t* pRxBuff);
+#endif
+
+static BaseType_t IRAM_ATTR Capture_BlockDone(void);
+static void IRAM_ATTR Capture_RecordIsr(const uint32_t cycles, const bool blockDone);
+
+/******************************************************************************
+ * @brief       Capture_Init
+ * @param       none
+ * @return      None
+ * @details     Select the capture path. Must run after Drv_SPI_Init().
+ *****************************************************************************/
+void Capture_Init(void)
+{
+#if CONFIG_MI_SPI_CAPTURE_DMA
+	mDmaReady = (Drv_SPI_DMA_CaptureInit(Capture_DmaDone) == ESP_OK);	// Polled capture stays as fallback
+#endif
+}
+
+/******************************************************************************
+ * @brief       Capture_SetFrameTask
+ * @param       task - Task to notify, NULL for none
+ * @return      None
+ * @details     Set the task woken with CAPTURE_NOTIFY_FRAME whenever the capture
+ * 				interrupt has handed a complete frame to the library
+ *****************************************************************************/
+void Capture_SetFrameTask(TaskHandle_t task)
+{
+	mFrameTask = task;
+}
+
+/******************************************************************************
+ * @brief       Capture_Reset
+ * @param       none
+ * @return      None
+ * @details     Drop the partial frame, the next block starts a new one.
+ * 				Capture must be stopped, a burst still running is abandoned.
+ *****************************************************************************/
+void Capture_Reset(void)
+{
+	portENTER_CRITICAL(&mIsrStatsLock);
+#if CONFIG_MI_SPI_CAPTURE_DMA
+	mDmaBusy = false;
+#endif
+	PixelCnt = 0;
+	portEXIT_CRITICAL(&mIsrStatsLock);
+}
+
+/******************************************************************************
+ * @brief       Capture_GetIsrStats
+ * @param       pStats - Output
+ * 				reset - Start a new measurement window after reading
+ * @return      None
+ * @details     Time spent in the capture interrupts, to compare capture modes
+ *****************************************************************************/
+void Capture_GetIsrStats(captureIsrStats_t* pStats, const bool reset)
+{
+	portENTER_CRITICAL(&mIsrStatsLock);
+#if CONFIG_MI_SPI_CAPTURE_DMA
+	pStats->mMode = mDmaReady ? CAPTURE_MODE_DMA : CAPTURE_MODE_POLLED;
+#else
+	pStats->mMode = CAPTURE_MODE_POLLED;
+#endif
+	pStats->mBlocks = mIsrBlocks;
+	pStats->mAvgCycles = (mIsrBlocks > 0) ? (uint32_t)(mIsrCycles / mIsrBlocks) : 0;
+	pStats->mMaxCycles = mIsrMaxCycles;
+	pStats->mOverruns = mIsrOverruns;
+
+	if(reset)
+	{
+		mIsrBlocks = 0;
+		mIsrCycles = 0;
+		mIsrMaxCycles = 0;
+		mIsrOverruns = 0;
+	}
+	portEXIT_CRITICAL(&mIsrStatsLock);
+}
+
+/******************************************************************************
+ * @brief       Capture_GetFrameTimeUs
+ * @param       none
+ * @return      esp_timer time the last frame was complete, 0 before the first
+ * @details     Taken in the interrupt that hands the frame to the library, so
+ * 				it does not depend on when the frame task gets to run
+ *****************************************************************************/
+int64_t Capture_GetFrameTimeUs(void)
+{
+	portENTER_CRITICAL(&mIsrStatsLock);
+	const int64_t frameUs = mFrameDoneUs;
+	portEXIT_CRITICAL(&mIsrStatsLock);
+	return frameUs;
+}
+
 /******************************************************************************
  * @brief       Data_AV_FIFO_Int_Handler
  * @param       none
@@ -36,11 +144,34 @@ extern void CaptureProcessFrame(uint16_t tmp);
 #define BURST_MODE 8							//maximum of allowed write to MCU SPI (MCU FIFO Size)
 void IRAM_ATTR Data_AV_FIFO_Int_Handler(void* arg)
 {
-
+	const uint32_t startCycles = esp_cpu_get_cycle_count();
 	uint8_t Burstmode = BURST_MODE;
 
+#if CONFIG_MI_SPI_CAPTURE_DMA
+	if (mDmaBusy)
+	{
+		portENTER_CRITICAL_ISR(&mIsrStatsLock);
+		++mIsrOverruns;					// Previous burst still running, it has this data's FIFO slot
+		portEXIT_CRITICAL_ISR(&mIsrStatsLock);
+		return;
+	}
+#endif
+
 	GetReceiveFrameBuffer();
-//	Drv_SPI_DMA_Enable();
+
+#if CONFIG_MI_SPI_CAPTURE_DMA
+	if (mDmaReady)
+	{
+		mDmaWords = DATA_AV_Threshold;
+		mDmaBusy = true;
+		if (Drv_SPI_DMA_CaptureStart(DATA_AV_Threshold))
+		{
+			Capture_RecordIsr(esp_cpu_get_cycle_count() - startCycles, false);
+			return;						// Capture_DmaDone() finishes the block
+		}
+		mDmaBusy = false;				// Threshold not usable for a burst, read it word by word
+	}
+#endif
 
 	if (DATA_AV_Threshold < BURST_MODE)
 	{
@@ -52,10 +183,53 @@ void IRAM_ATTR Data_AV_FIFO_Int_Handler(void* arg)
 	{
 		for(uint16_t Bcnt = 0; Bcnt<Burstmode; Bcnt++)
 		{
-			ReceiveFrame->TXBuf[PixelCnt++] = Drv_SPI_Transmit(); //Drv_SPI_DMA_Transmit(); ;
+			ReceiveFrame->TXBuf[PixelCnt++] = Drv_SPI_Transmit();
 		}
 
 	}//End for
+
+	Capture_RecordIsr(esp_cpu_get_cycle_count() - startCycles, true);
+	if (Capture_BlockDone() == pdTRUE)
+	{
+		portYIELD_FROM_ISR();
+	}
+
+}//Data AV handler (FIFO) END
+
+#if CONFIG_MI_SPI_CAPTURE_DMA
+/******************************************************************************
+ * @brief       Capture_DmaDone
+ * @param       pRxBuff - Bytes received by the burst, most significant first
+ * @return      True if the frame task must run
+ * @details     DMA completion interrupt. Stores the burst in the frame buffer.
+ *****************************************************************************/
+static bool IRAM_ATTR Capture_DmaDone(const uint8_t* pRxBuff)
+{
+	const uint32_t startCycles = esp_cpu_get_cycle_count();
+	const uint16_t words = mDmaWords;
+
+	for (uint16_t i = 0; i < words; i++)
+	{
+		ReceiveFrame->TXBuf[PixelCnt++] = (uint16_t)(pRxBuff[i * 2] << 8 | pRxBuff[i * 2 + 1]);
+	}
+
+	mDmaBusy = false;
+	const BaseType_t woken = Capture_BlockDone();
+	Capture_RecordIsr(esp_cpu_get_cycle_count() - startCycles, true);
+	return woken == pdTRUE;
+}
+#endif
+
+/******************************************************************************
+ * @brief       Capture_BlockDone
+ * @param       none
+ * @return      pdTRUE if the frame task must run
+ * @details     Hand the frame over once the last block is in
+ *****************************************************************************/
+static BaseType_t IRAM_ATTR Capture_BlockDone(void)
+{
+	BaseType_t woken = pdFALSE;
+
 #if CONFIG_MI_LED_EN
 	Drv_LED_Gpio_En(LED_PIN_G , LED_OFF);
 #endif
@@ -65,7 +239,34 @@ void IRAM_ATTR Data_AV_FIFO_Int_Handler(void* arg)
 		Drv_LED_Gpio_En(LED_PIN_G, LED_ON);
 #endif	
 		Drv_SPI_DMA_Disable();
+		LATENCY_TRACE_CAPTURE_DONE();
+		portENTER_CRITICAL_ISR(&mIsrStatsLock);
+		mFrameDoneUs = esp_timer_get_time();		// Capture time of the frame, before the library processes it
+		portEXIT_CRITICAL_ISR(&mIsrStatsLock);
 		CaptureProcessFrame(ReceiveFrame->TXBuf[PixelCnt-1]);
+		if (mFrameTask != NULL)
+		{
+			xTaskNotifyFromISR(mFrameTask, CAPTURE_NOTIFY_FRAME, eSetBits, &woken);
+		}
 	}//End if
+	return woken;
+}
 
-}//Data AV handler (FIFO) END
+/******************************************************************************
+ * @brief       Capture_RecordIsr
+ * @param       cycles - CPU cycles spent in this ISR
+ * 				blockDone - This ISR completed a block
+ * @return      None
+ * @details     Update the capture ISR statistics
+ *****************************************************************************/
+static void IRAM_ATTR Capture_RecordIsr(const uint32_t cycles, const bool blockDone)
+{
+	portENTER_CRITICAL_ISR(&mIsrStatsLock);
+	mIsrCycles += cycles;
+	mIsrMaxCycles = (cycles > mIsrMaxCycles) ? cycles : mIsrMaxCycles;
+	if (blockDone)
+	{
+		++mIsrBlocks;
+	}
+	portEXIT_CRITICAL_ISR(&mIsrStatsLock);
+}
@@ -0,0 +1,249 @@
+/**************************************************************************//**
+ * @file     UnitConvert.c
+ * @version  V1.00
+ * @brief    Unit conversion of the processed frame (MCU_REG_31)
+ *
+ * @details  The output is bit for bit the one of the float code that used to
+ *           convert every pixel: v / divide - 273.15, in float.
+ *
+ *           Celsius and Fahrenheit are the ratio (mMul * v + mAdd) / mDiv
+ *           truncated, 273.15 K being 5463/20. The float code only differs
+ *           from it where the ratio is a whole number: its rounding of v /
+ *           divide and of 273.15 then lands just short of it, one count
+ *           toward zero. Those raw values are marked in a bitmap, built once
+ *           from the float code whenever the mode or 0xB9 bit 7 changes.
+ *           At 0.1 K no value is marked, at 0.01 K 18884 of the Celsius and
+ *           3810 of the Fahrenheit ones are.
+ *
+ *           The modes that send float bits keep the float code per pixel,
+ *           their bits depend on every rounding step of it. There is no S3
+ *           PIE path: the PIE has no divide, and the integer modes need a 32
+ *           bit quotient per pixel.
+ *
+ *           Nothing here touches the SenXor or the IDF, the host tests build
+ *           this file as it is.
+ ******************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include "UnitConvert.h"
+
+// 0.1 K raw units, 0xB9 bit 7 clear
+static const unitScale_t UnitScaleLow[UNIT_MODE_COUNT] = {
+	[1] = { 2, -5463, 2, 1, false, 10, NULL },		// Celsius, 0.1 degree
+	[2] = { 18, -45967, 10, 2, false, 10, NULL },	// Fahrenheit, 0.1 degree
+	[4] = { 0, 0, 0, 4, true, 10, NULL },			// Kelvin, float
+	[5] = { 0, 0, 0, 5, true, 10, NULL },			// Celsius, float
+	[6] = { 0, 0, 0, 6, true, 10, NULL },			// Fahrenheit, float
+};
+
+// 0.01 K raw units, 0xB9 bit 7 set
+static const unitScale_t UnitScaleHigh[UNIT_MODE_COUNT] = {
+	[1] = { 1, -27315, 1, 1, false, 100, NULL },	// Celsius, 0.01 degree
+	[2] = { 9, -229835, 5, 2, false, 100, NULL },	// Fahrenheit, 0.01 degree
+	[4] = { 0, 0, 0, 4, true, 100, NULL },			// Kelvin, float
+	[5] = { 0, 0, 0, 5, true, 100, NULL },			// Celsius, float
+	[6] = { 0, 0, 0, 6, true, 100, NULL },			// Fahrenheit, float, always from 0.1 K like before
+};
+
+static unitScale_t UnitScale;								// Scale in use, with its bitmap
+static const unitScale_t* UnitScaleFrom = NULL;				// Table entry UnitScale was built from
+static uint8_t UnitRound[UNIT_RAW_VALUES / 8];
+
+/******************************************************************************
+ * @brief       UnitConvert_Float
+ * @param       pScale - scale of the mode, value - raw pixel
+ * @return      Converted pixel
+ * @details     The float code of COnvert_Image_Transfer_Format, unchanged.
+ * 				Keep every operation and its type as it is, the output
+ * 				depends on each rounding.
+ *****************************************************************************/
+static uint16_t UnitConvert_Float(const unitScale_t* pScale, uint32_t value)
+{
+	union {
+		float fp;
+		uint32_t ul;
+	} temp_data_f16;
+	float temp_data;
+	float Celsius_Scale = 273.15;
+	const float temp_res_divide = pScale->mDivide;
+
+	switch(pScale->mMode)
+	{
+		case 1:
+			temp_data = value/temp_res_divide;
+			temp_data = (temp_data - Celsius_Scale)*temp_res_divide;
+			return (uint16_t)(int)temp_data;
+		case 2:
+			temp_data = value/temp_res_divide;
+			temp_data = (float)(((temp_data - Celsius_Scale) * 9/5) + 32)*temp_res_divide;
+			return (uint16_t)(int)temp_data;
+		case 4:
+			temp_data_f16.fp = value/temp_res_divide;
+			return (uint16_t)temp_data_f16.ul;
+		case 5:
+			temp_data = value/temp_res_divide;
+			temp_data_f16.fp = (temp_data - Celsius_Scale);
+			return (uint16_t)temp_data_f16.ul;
+		default:
+			temp_data = value/10.0;
+			temp_data_f16.fp = (float)(((temp_data - Celsius_Scale) * 9/5) + 32);
+			return (uint16_t)temp_data_f16.ul;
+	}
+}
+
+/******************************************************************************
+ * @brief       UnitConvert_Pixel
+ * @param       pScale - scale of the mode, value - raw pixel
+ * @return      Converted pixel
+ * @details     None
+ *****************************************************************************/
+static inline uint16_t UnitConvert_Pixel(const unitScale_t* pScale, uint32_t value)
+{
+	if(pScale->mFloat)
+	{
+		return UnitConvert_Float(pScale, value);
+	}
+
+	int32_t out = (pScale->mMul * (int32_t)value + pScale->mAdd) / pScale->mDiv;
+	if(pScale->pRound != NULL && (pScale->pRound[value >> 3] & (1 << (value & 7))) != 0)
+	{
+		out += (out > 0) ? -1 : 1;
+	}
+	return (uint16_t)out;
+}
+
+/******************************************************************************
+ * @brief       UnitConvert_BuildRound
+ * @param       pScale - integer mode scale
+ * @return      true if a raw value is marked in UnitRound
+ * @details     Runs the float code on every raw value the ratio divides
+ * 				exactly, the others always match the quotient
+ *****************************************************************************/
+static bool UnitConvert_BuildRound(const unitScale_t* pScale)
+{
+	bool marked = false;
+
+	memset(UnitRound, 0, sizeof(UnitRound));
+	for (uint32_t value = 0; value < UNIT_RAW_VALUES; value++)
+	{
+		const int32_t ratio = pScale->mMul * (int32_t)value + pScale->mAdd;
+		if(ratio % pScale->mDiv != 0)
+		{
+			continue;
+		}
+		if(UnitConvert_Float(pScale, value) != (uint16_t)(ratio / pScale->mDiv))
+		{
+			UnitRound[value >> 3] |= (uint8_t)(1 << (value & 7));
+			marked = true;
+		}
+	}
+	return marked;
+}
+
+/******************************************************************************
+ * @brief       UnitConvert_GetScale
+ * @param       mode - MCU_REG_31 unit mode, Tgain - register 0xB9
+ * @return      Scale of the mode, NULL when the frame stays in raw Kelvin
+ * @details     Builds the bitmap of an integer mode when the mode or 0xB9
+ * 				bit 7 changed, a few ms once. The other bits of 0xB9 do not
+ * 				matter. Called by the capture task only.
+ *****************************************************************************/
+const unitScale_t* UnitConvert_GetScale(uint8_t mode, uint8_t Tgain)
+{
+	const unitScale_t* pTable = ((Tgain & UNIT_TGAIN_HIGH_RES) == UNIT_TGAIN_HIGH_RES) ? UnitScaleHigh : UnitScaleLow;
+
+	if(mode >= UNIT_MODE_COUNT || pTable[mode].mMode == 0)
+	{
+		return NULL;
+	}
+	if(UnitScaleFrom != &pTable[mode])
+	{
+		UnitScale = pTable[mode];
+		if(!UnitScale.mFloat && UnitConvert_BuildRound(&UnitScale))
+		{
+			UnitScale.pRound = UnitRound;
+		}
+		UnitScaleFrom = &pTable[mode];
+	}
+	return &UnitScale;
+}
+
+/******************************************************************************
+ * @brief       UnitConvert_Frame
+ * @param       buffer - image pixels, l_FrameSize - number of pixels
+ * 				pScale - scale of the mode
+ * 				pMin / pMax - header min and max, converted in place
+ * @return      NONE
+ * @details     None
+ *****************************************************************************/
+void UnitConvert_Frame(uint16_t* buffer, int l_FrameSize, const unitScale_t* pScale, uint16_t* pMin, uint16_t* pMax)
+{
+	for (int i=0; i<l_FrameSize; i++)
+	{
+		buffer[i] = UnitConvert_Pixel(pScale, buffer[i]);
+	}
+	*pMin = UnitConvert_Pixel(pScale, *pMin);
+	*pMax = UnitConvert_Pixel(pScale, *pMax);
+}
+
+/******************************************************************************
+ * @brief       UnitConvert_Fused
+ * @param       buffer - image pixels, l_FrameSize - number of pixels
+ * 				pScale - scale of the mode, NULL in Kelvin
+ * 				pCorr - per-pixel gain and offset, NULL for none
+ * 				pPatch / patchCount - bad pixels, ascending mDst
+ * 				pMin / pMax - header min and max
+ * @return      NONE
+ * @details     Correction, conversion and bad pixel patch in one pass over the
+ * 				frame. A bad pixel takes the final value of its replacement: already
+ * 				in the buffer when the replacement comes first, else computed from
+ * 				its raw value, which the loop converts again when it gets there.
+ * 				The header min and max are taken from the corrected pixels.
+ *****************************************************************************/
+void UnitConvert_Fused(uint16_t* buffer, int l_FrameSize, const unitScale_t* pScale, const convCorr_t* pCorr,
+		const pixPatch_t* pPatch, uint16_t patchCount, uint16_t* pMin, uint16_t* pMax)
+{
+	uint16_t nextBad = (patchCount > 0) ? pPatch[0].mDst : 0xFFFF;
+	uint16_t p = 0;
+	uint16_t minT = 0xFFFF;
+	uint16_t maxT = 0;
+
+	for (int i=0; i<l_FrameSize; i++)
+	{
+		int src = i;
+
+		if(i == nextBad)
+		{
+			src = pPatch[p].mSrc;
+			nextBad = (++p < patchCount) ? pPatch[p].mDst : 0xFFFF;
+			if(src < i)
+			{
+				buffer[i] = buffer[src];		// Replacement already final
+				continue;
+			}
+		}
+
+		uint32_t value = buffer[src];
+		if(pCorr != NULL)
+		{
+			const int32_t corrected = (int32_t)((value * pCorr[src].mGain + (CONV_GAIN_UNITY >> 1)) >> CONV_GAIN_SHIFT) + pCorr[src].mOffset;
+			value = (corrected < 0) ? 0 : (corrected > 0xFFFF) ? 0xFFFF : (uint32_t)corrected;
+		}
+		minT = (value < minT) ? value : minT;
+		maxT = (value > maxT) ? value : maxT;
+		buffer[i] = (pScale != NULL) ? UnitConvert_Pixel(pScale, value) : (uint16_t)value;
+	}
+
+	if(pCorr != NULL)
+	{
+		*pMin = minT;
+		*pMax = maxT;
+	}
+	if(pScale != NULL)
+	{
+		*pMin = UnitConvert_Pixel(pScale, *pMin);	//min  pixel
+		*pMax = UnitConvert_Pixel(pScale, *pMax);	//max  pixel
+	}
+}
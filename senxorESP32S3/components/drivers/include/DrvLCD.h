@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
+#include <stdbool.h>
 #include "sdkconfig.h"
 #include "esp_lcd_gc9a01.h"
 #include "esp_lcd_panel_io.h"
@@ -38,7 +39,16 @@
 #define LCD_SENXOR_FRAME_H 62		//Height of a SenXor's frame
 #define LCD_SENXOR_FRAME_W 80		//Width of a SenXor's frame
 
-//C - Hardware specification
+//C - Live view
+#define LCD_LIVE_SCALE		3											//Panel pixels per SenXor pixel, nearest neighbour
+#define LCD_LIVE_OFFSET_Y	((LCD_V_RES - LCD_SENXOR_FRAME_H*LCD_LIVE_SCALE)/2)	//Image centred vertically
+#define LCD_LIVE_TILE_W		8											//Tile width in SenXor pixels, unit of the dirty test
+#define LCD_LIVE_TILE_H		4											//Tile height in SenXor pixels, rows of one band
+#define LCD_LIVE_TILES_X	(LCD_SENXOR_FRAME_W/LCD_LIVE_TILE_W)
+#define LCD_LIVE_BAND_PIX	(LCD_H_RES*LCD_LIVE_TILE_H*LCD_LIVE_SCALE)	//Panel pixels of one band, size of a DMA buffer
+#define LCD_LIVE_DELTA		CONFIG_MI_LCD_LIVE_DELTA					//Colour index change that marks a tile dirty
+
+//D - Hardware specification
 #define LCD_PIXEL_CLK	(80 * 1000 * 1000)
 
 #ifndef CONFIG_MI_LCD_CUSTOM_PINS
@@ -72,7 +82,7 @@
 #define LCD_MISO	CONFIG_MI_LCD_MISO
 #endif
 
-//D - SPI PIN
+//E - SPI PIN
 /*
  * GC9A01		ST7789
  * CLK 21		21
@@ -118,4 +128,10 @@ void drawText(const uint8_t draw_x, const uint8_t draw_y, const char* text);
 
 void fillScreen(const uint16_t colour);
 
+bool lcdLiveViewInit(const uint8_t colourmap);
+
+uint16_t lcdLiveViewDraw(const uint16_t* pImage, const uint16_t minVal, const uint16_t maxVal);
+
+void lcdLiveViewInvalidate(void);
+
 #endif /* COMPONENTS_DRIVERS_INCLUDE_DRVLCD_H_ */
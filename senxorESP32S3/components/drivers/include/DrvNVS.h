@@ -9,6 +9,7 @@
 #include <esp_log.h>
 #include <nvs_flash.h>
 #include <stdio.h>
+#include <stdbool.h>
 #include "msg.h"
 
 
@@ -20,6 +21,10 @@ void NVS_WriteStr(const char* key, const char* value);
 
 void NVS_WriteU8(const char* key, uint8_t value);
 
+void NVS_WriteBlob(const char* key, const void* data, const size_t len);
+
+bool NVS_ReadBlob(const char* key, void* data, const size_t len);
+
 void NVS_ReadInt(const char* key, int32_t value);
 
 uint8_t NVS_ReadU8(const char* key, uint8_t defaultValue);
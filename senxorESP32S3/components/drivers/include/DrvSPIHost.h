@@ -58,6 +58,11 @@
 #define CALIBDATA_FLASH_SIZE	            (CALIBDATA_FLASH_END_ADDRESS-CALIBDATA_FLASH_START_ADDRESS)/2
 #define DEFAULT_SPI_LENGTH 		            16
 #define FLASH_SPI_LENGTH 		            8
+#define SPI_DMA_CAPTURE_MAX_WORDS           256									/* Longest DMA burst of 16 bit FIFO words */
+/******************************************************************************
+ * @brief       DMA burst capture
+ *****************************************************************************/
+typedef bool (*Drv_SPI_CaptureDoneCb_t)(const uint8_t* pRxBuff);				/* Called from ISR with the received bytes */
 /******************************************************************************
  * @brief       Functions prototyping
  *****************************************************************************/
@@ -94,7 +99,21 @@ void Drv_SPI_DMA_Enable(void);
 
 void Drv_SPI_DMA_PrepDesc(void *txBuff, void *rxBuff, const int dataLen);
 
+void Drv_SPI_Restart(void);
+
+void Drv_SPI_SetFrameClock(const uint32_t clk_speed);
+
+uint32_t Drv_SPI_GetFrameClock(void);
+
+#if CONFIG_MI_SPI_CAPTURE_DMA
+esp_err_t Drv_SPI_DMA_CaptureInit(Drv_SPI_CaptureDoneCb_t doneCb);
+
+bool IRAM_ATTR Drv_SPI_DMA_CaptureStart(const uint16_t words);
+#endif
+
 void Read_CalibrationData(void);
 
+bool Read_CalibrationHead(uint8_t* pBuf, const uint32_t len);
+
 
 #endif /* DRV_DRVSPI_H_ */
@@ -1,6 +1,6 @@
 /*****************************************************************************
  * @file     DrvWLAN.h
- * @version  1.2
+ * @version  1.4
  * @brief    Contains function for controlling WiFi
  * @date	 5 July 2022
  ******************************************************************************/
@@ -9,7 +9,7 @@
 #define COMPONENTS_DRIVERS_INCLUDE_DRVWLAN_H_
 #include <stddef.h>
 #include <string.h>
-#include "cJSON.h"
+#include "jsonWriter.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
@@ -88,6 +88,9 @@
 #define WLAN_SCAN_TOTALAP		"Total APs found: %u"
 #define WLAN_STAT_CONNECT		"The device is connected to: %s ."
 #define WLAN_STOP				"Disabling WiFi..."
+#define WLAN_SNTP_START			"SNTP started, server %s."
+#define WLAN_SNTP_SYNC			"Clock synchronised: %lld s UTC, offset moved %ld us."
+#define WLAN_ERR_SNTP			"Cannot start SNTP: %s"
 #define WLAN_WARN_AP_SDKCFGPWD	"Using the pre-configurated password in sdkconfig."
 #define WLAN_WARN_STA_SDKCFGSSID "Using the pre-configurated SSID in sdkconfig."
 #define WLAN_WARN_EVTGRP_EXIST	"An event group already initialised. Using the existing one."
@@ -126,7 +129,7 @@ void Drv_WLAN_Restart(const uint8_t WIFI_MODE);
 
 void Drv_WLAN_getCfgNvs(wlanCfg_t* wlanCfgObj);
 
-void Drv_WLAN_getRptToJson(cJSON* jsonObj);
+void Drv_WLAN_getRptToJson(jsonWriter_t* pWriter);
 
 void Drv_WLAN_getRptJsonStr(char* result, int buffLen);
 
@@ -136,6 +139,8 @@ const char* Drv_WLAN_getIP(void);
 
 bool Drv_WLAN_getIsIpObtained();
 
+int64_t Drv_WLAN_getUtcOffsetUs(void);
+
 void Drv_WLAN_getAuthMode(int authmode);
 
 
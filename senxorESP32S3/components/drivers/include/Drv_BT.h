@@ -27,6 +27,7 @@
 #define BLUFI_DEG_LOG           0
 
 #define BLUFI_BUFF_LEN			200
+#define BLUFI_RPT_LEN			384										//Custom data report sent on connect
 #define BLUFI_CTM_JSON_ROOT		"blufiCustomData"
 
 //JSON
@@ -51,8 +52,6 @@ void Drv_BT_DeInit(void);
 
 void Drv_BT_ReInit(void);
 
-void Drv_BluFi_SendCtmDataJson(cJSON* mJson);
-
 void Drv_BluFi_GetCtmDataJson(char* jsonStr, char* jsonOut);
 
 #endif /* COMPONENTS_DRIVERS_INCLUDE_DRV_BT_H_ */
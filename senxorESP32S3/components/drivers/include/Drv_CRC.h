@@ -3,6 +3,15 @@
 
 #include <stdint.h>
 
+/******************************************************************************
+ * @brief       Integrity check of the frame packets, selected with SCRC
+ *****************************************************************************/
+typedef enum crcMode{
+	CRC_MODE_SUM16 = 0,				// 16 bit byte sum, getCRC()
+	CRC_MODE_CRC32,					// CRC-32 (IEEE 802.3) of the ROM
+	CRC_MODE_COUNT
+}crcMode_t;
+
 /******************************************************************************
  * @brief       Function prototyping
  *****************************************************************************/
@@ -10,6 +19,7 @@ void Drv_Crc_Open(void);
 void Drv_Crc_crc32_open(void);
 uint16_t Drv_Crc_WriteCRC(uint16_t data);
 uint32_t Drv_Crc_GetCRCcheckSum(void);
+uint32_t Drv_Crc_Crc32(uint32_t crc, const uint8_t* pData, uint32_t len);
 extern uint32_t CalData_CRC;
 
 
@@ -10,6 +10,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "esp_err.h"
+#include "esp_gatts_api.h"
+#include "sdkconfig.h"
 
 // Combustion Inc. Vendor ID
 #define COMBUSTION_VENDOR_ID                0x09C7
@@ -27,6 +29,9 @@
 #define COMBUSTION_ADV_INTERVAL_NORMAL      400   // 250ms
 #define COMBUSTION_ADV_INTERVAL_FAST        160   // 100ms
 
+// Temperature updates per second worth producing: adverts refresh every COMBUSTION_ADV_INTERVAL_NORMAL
+#define COMBUSTION_UPDATE_RATE_HZ           4
+
 // Temperature encoding constants
 // Formula: raw = ((celsius + 20.0) / 0.05)
 // Range: -20C to +388.95C with 0.05C resolution
@@ -34,6 +39,15 @@
 #define COMBUSTION_TEMP_SCALE_C             0.05f
 #define COMBUSTION_TEMP_BITS                13
 #define COMBUSTION_TEMP_MAX_RAW             0x1FFF  // 13-bit max
+// The same formula from decikelvin, in integers: raw = 2 * dK - (273.15 - 20.0) / 0.05
+#define COMBUSTION_TEMP_RAW_PER_DK          2
+#define COMBUSTION_TEMP_DK_OFFSET_RAW       5063
+#define COMBUSTION_PACKED_TEMPS_LEN         13      // 8 x 13 bits
+
+// Change-driven updates, see CONFIG_MI_BLE_* in the Combustion BLE menu
+#define COMBUSTION_DEADBAND_DK              CONFIG_MI_BLE_DEADBAND_DK
+#define COMBUSTION_MIN_INTERVAL_MS          CONFIG_MI_BLE_MIN_INTERVAL_MS
+#define COMBUSTION_DRIFT_INTERVAL_MS        CONFIG_MI_BLE_DRIFT_INTERVAL_MS
 
 // Combustion Service UUID: 00000100-CAAB-3792-3D44-97AE51C1407A
 // (128-bit, LSB first for ESP32)
@@ -64,8 +78,12 @@ esp_err_t combustionBle_Init(void);
 
 /**
  * @brief Update temperature values for BLE broadcast
- * @details Called from senxorTask after quadrant_Calculate() to update
- *          both advertising data and connected client notifications.
+ * @details Called from senxorTask after quadrant_Calculate() with every
+ *          frame. The advertising data is rebuilt and connected clients are
+ *          notified only when a temperature moved by COMBUSTION_DEADBAND_DK
+ *          since the last broadcast, at most once per
+ *          COMBUSTION_MIN_INTERVAL_MS. Smaller changes are broadcast after
+ *          COMBUSTION_DRIFT_INTERVAL_MS.
  * @param temps Array of 8 temperatures in decikelvin (dK = 1/10 K)
  *              Example: 2973 = 297.3K = 24.15°C
  *              [0-3]: Amax, Bmax, Cmax, Dmax (quadrant max temps)
@@ -73,6 +91,15 @@ esp_err_t combustionBle_Init(void);
  */
 void combustionBle_UpdateTemps(const uint16_t temps[8]);
 
+/**
+ * @brief Forward the GATT server events of other applications
+ * @details Bluedroid has a single GATT server callback, registered by
+ *          combustionBle_Init(). Events of any application registered with
+ *          another app ID go to this handler. Call before registering it.
+ * @param handler Callback of the other application, NULL to drop the events
+ */
+void combustionBle_SetAppHandler(esp_gatts_cb_t handler);
+
 /**
  * @brief Check if Combustion BLE is initialized
  * @return true if initialized and advertising
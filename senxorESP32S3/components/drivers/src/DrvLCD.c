@@ -5,10 +5,13 @@
  * @date	 17 Jun 2022
  *
  ******************************************************************************/
+#include <stdlib.h>
+#include <sys/param.h>
 #include "DrvLCD.h"
 #include "MeridianLogo.h"
 #include "More_perfect_VGA_dark.h"
 #include "icons.h"
+#include "simpleGFX.h"
 
 #ifdef CONFIG_MI_LCD_EN
 //private:
@@ -34,6 +37,17 @@ static void LCDBLKCtrlInit(void);
 
 static void LCDBuffInit(void);
 
+#ifdef CONFIG_MI_LCD_LIVE_VIEW
+static gfxColourLut_t mLiveLut;					//Colour map of the current range
+static uint8_t mLiveMap = IronGlow;				//ColourmapSelection
+static uint16_t* mLiveShown = NULL;				//LUT entry on the panel, per SenXor pixel
+static uint16_t* mLiveBand[2] = {NULL, NULL};	//Internal DMA buffers, one is filled while the other is sent
+static uint8_t mLiveBandIdx = 0;				//Buffer filled next
+static bool mLiveForce = true;					//Every tile is drawn on the next frame
+
+static void lcdLiveViewPushRun(const uint16_t* pImage, const uint16_t* pIndex, const uint8_t srcY, const uint8_t rows, const uint8_t srcX, const uint8_t cols);
+#endif
+
 /******************************************************************************
  * @brief       LCDInit
  * @param       None
@@ -534,4 +548,185 @@ void drawIcon(const uint8_t draw_x, const uint8_t draw_y, const uint8_t icon)
 	}
 
 }
+
+#ifdef CONFIG_MI_LCD_LIVE_VIEW
+/******************************************************************************
+ * @brief       lcdLiveViewInit
+ * @param		colourmap - ColourmapSelection of the live view
+ * @return      true if the buffers are allocated
+ * @details     Allocate the live view buffers and clear the screen. The LUT
+ * 				entry last shown by every SenXor pixel is kept in PSRAM, the
+ * 				panel pixels only exist in two band buffers in internal RAM,
+ * 				which the SPI DMA reads without a bounce copy.
+ *****************************************************************************/
+bool lcdLiveViewInit(const uint8_t colourmap)
+{
+	mLiveMap = (colourmap < colourmapCount) ? colourmap : IronGlow;
+	gfxLutReset(&mLiveLut);
+
+	mLiveShown = heap_caps_malloc(LCD_BUFF_PIX_SENXOR*sizeof(uint16_t), MALLOC_CAP_SPIRAM);
+	for(uint8_t i = 0 ; i < 2 ; ++i)
+	{
+		mLiveBand[i] = heap_caps_malloc(LCD_LIVE_BAND_PIX*sizeof(uint16_t), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+	}
+	if(mLiveShown == 0 || mLiveBand[0] == 0 || mLiveBand[1] == 0)
+	{
+		ESP_LOGE(LCDTAG, LCD_ERR_NO_RAM);
+		return false;
+	}
+
+	fillScreen(BLACK);
+	mLiveForce = true;
+	ESP_LOGI(LCDTAG, LCD_LIVE_INFO, mLiveMap, LCD_LIVE_SCALE, (int)(2*LCD_LIVE_BAND_PIX*sizeof(uint16_t)));
+	return true;
+}
+
+/******************************************************************************
+ * @brief       lcdLiveViewDraw
+ * @param		pImage - SenXor image, header rows removed
+ * 				minVal, maxVal - Values mapped to the ends of the colour map
+ * @return      Number of tiles sent to the panel
+ * @details     Look up the LUT entry of every pixel band by band and send
+ * 				only the tiles where one moved by more than LCD_LIVE_DELTA
+ * 				of 256 colour map steps since it was last drawn.
+ * 				Neighbouring dirty tiles of a band are sent as one rectangle.
+ * 				A tile that is not drawn keeps its old entries, so a slow
+ * 				drift is drawn once it adds up.
+ *****************************************************************************/
+uint16_t lcdLiveViewDraw(const uint16_t* pImage, const uint16_t minVal, const uint16_t maxVal)
+{
+	uint16_t index[LCD_SENXOR_FRAME_W*LCD_LIVE_TILE_H];					//LUT entries of one band
+	bool dirty[LCD_LIVE_TILES_X];
+	uint16_t pushed = 0;
+
+	if(mLiveShown == 0 || pImage == 0)
+	{
+		return 0;
+	}
+
+	gfxLutUpdate(&mLiveLut, minVal, maxVal, mLiveMap);					//Rebuilt only when the range moved
+	const int32_t delta = (LCD_LIVE_DELTA*mLiveLut.mEntries)/256;			//Colour map steps in LUT entries
+
+	for(uint8_t srcY = 0 ; srcY < LCD_SENXOR_FRAME_H ; srcY += LCD_LIVE_TILE_H)
+	{
+		const uint8_t rows = MIN(LCD_LIVE_TILE_H, LCD_SENXOR_FRAME_H - srcY);	//Last band is shorter
+		const uint16_t* pSrc = pImage + srcY*LCD_SENXOR_FRAME_W;
+		uint16_t* pShown = mLiveShown + srcY*LCD_SENXOR_FRAME_W;
+
+		for(uint16_t i = 0 ; i < rows*LCD_SENXOR_FRAME_W ; ++i)
+		{
+			index[i] = gfxLutIndex(&mLiveLut, pSrc[i]);
+		}
+
+		for(uint8_t tile = 0 ; tile < LCD_LIVE_TILES_X ; ++tile)
+		{
+			dirty[tile] = mLiveForce;
+			for(uint8_t y = 0 ; y < rows && !dirty[tile] ; ++y)
+			{
+				const uint16_t start = y*LCD_SENXOR_FRAME_W + tile*LCD_LIVE_TILE_W;
+				for(uint8_t x = 0 ; x < LCD_LIVE_TILE_W ; ++x)
+				{
+					if(abs((int32_t)index[start + x] - (int32_t)pShown[start + x]) > delta)
+					{
+						dirty[tile] = true;
+						break;
+					}
+				}
+			}
+		}
+
+		//Send every run of dirty tiles as one rectangle
+		for(uint8_t tile = 0 ; tile < LCD_LIVE_TILES_X ; )
+		{
+			if(!dirty[tile])
+			{
+				++tile;
+				continue;
+			}
+			const uint8_t first = tile;
+			while(tile < LCD_LIVE_TILES_X && dirty[tile])
+			{
+				++tile;
+			}
+			const uint8_t srcX = first*LCD_LIVE_TILE_W;
+			const uint8_t cols = (tile - first)*LCD_LIVE_TILE_W;
+			lcdLiveViewPushRun(pImage, index, srcY, rows, srcX, cols);
+			for(uint8_t y = 0 ; y < rows ; ++y)
+			{
+				memcpy(pShown + y*LCD_SENXOR_FRAME_W + srcX, index + y*LCD_SENXOR_FRAME_W + srcX, cols*sizeof(uint16_t));
+			}
+			pushed += tile - first;
+		}
+	}
+	mLiveForce = false;
+	return pushed;
+}
+
+/******************************************************************************
+ * @brief       lcdLiveViewInvalidate
+ * @param		None
+ * @return      None
+ * @details     Draw every tile on the next frame, e.g. after text was drawn
+ * 				over the image
+ *****************************************************************************/
+void lcdLiveViewInvalidate(void)
+{
+	mLiveForce = true;
+}
+
+/******************************************************************************
+ * @brief       lcdLiveViewPushRun
+ * @param		pImage - SenXor image, for the bilinear kernel
+ * 				pIndex - LUT entries of the band
+ * 				srcY, rows - First SenXor row and number of rows of the band
+ * 				srcX, cols - First SenXor column and number of columns
+ * @return      None
+ * @details     Upscale the rectangle into the next band buffer and queue it.
+ * 				esp_lcd_panel_draw_bitmap returns once the colour data is
+ * 				queued to the SPI DMA, and the column and row commands it
+ * 				sends first wait for the transfer before. So when this
+ * 				returns, the other buffer is free to be filled while this
+ * 				one is on its way.
+ *****************************************************************************/
+static void lcdLiveViewPushRun(const uint16_t* pImage, const uint16_t* pIndex, const uint8_t srcY, const uint8_t rows, const uint8_t srcX, const uint8_t cols)
+{
+	uint16_t* pBand = mLiveBand[mLiveBandIdx];
+	const uint16_t lineW = cols*LCD_LIVE_SCALE;							//Panel pixels per line
+	uint16_t* pLine = pBand;
+
+	mLiveBandIdx ^= 1;
+	for(uint8_t y = 0 ; y < rows ; ++y)
+	{
+#ifdef CONFIG_MI_LCD_LIVE_BILINEAR
+		(void)pIndex;
+		for(uint8_t s = 0 ; s < LCD_LIVE_SCALE ; ++s)
+		{
+			gfxUpscaleBilinearRow(pImage, LCD_SENXOR_FRAME_W, LCD_SENXOR_FRAME_H, LCD_LIVE_SCALE,
+								  (srcY + y)*LCD_LIVE_SCALE + s, srcX*LCD_LIVE_SCALE, lineW, pLine);
+			gfxLutMapRow(&mLiveLut, pLine, pLine, lineW);
+			pLine += lineW;
+		}
+#else
+		(void)pImage;
+		uint16_t colour[LCD_SENXOR_FRAME_W];
+		const uint16_t* pRow = pIndex + y*LCD_SENXOR_FRAME_W + srcX;
+		for(uint8_t x = 0 ; x < cols ; ++x)
+		{
+			colour[x] = mLiveLut.mColour[pRow[x]];
+		}
+		gfxUpscaleNearestRow(colour, cols, LCD_LIVE_SCALE, pLine);
+		//Repeat the line for the rest of the scale
+		for(uint8_t s = 1 ; s < LCD_LIVE_SCALE ; ++s)
+		{
+			memcpy(pLine + s*lineW, pLine, lineW*sizeof(uint16_t));
+		}
+		pLine += lineW*LCD_LIVE_SCALE;
+#endif
+	}
+
+	const int x0 = srcX*LCD_LIVE_SCALE;
+	const int y0 = LCD_LIVE_OFFSET_Y + srcY*LCD_LIVE_SCALE;
+	esp_lcd_panel_draw_bitmap(panel_handle, x0, y0, x0 + lineW, y0 + rows*LCD_LIVE_SCALE, pBand);
+}
+#endif
 #endif
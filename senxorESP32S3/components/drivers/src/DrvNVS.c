@@ -162,6 +162,81 @@ void NVS_WriteU8(const char* key, uint8_t value)
 	}//End if
 }
 
+/*
+ * ***********************************************************************
+ * @brief       NVS_WriteBlob
+ * @param       key - Key to locate the value
+ * 				data - Data to be stored
+ * 				len - Size of data in bytes
+ * @return      None
+ * @details     Write binary data to NVS
+ **************************************************************************/
+void NVS_WriteBlob(const char* key, const void* data, const size_t len)
+{
+	if(nvs_handler == 0)
+	{
+		ESP_LOGE(NVSTAG,NVS_ERR_HANDLE_NULL);
+		return;
+	}//End if
+	esp_err_t err = nvs_set_blob(nvs_handler, key, data, len);
+
+	if(err != ESP_OK)
+	{
+		ESP_LOGE(NVSTAG,NVS_ERR_WRITE,esp_err_to_name(err));
+		return;
+	}//End if
+
+	err = nvs_commit(nvs_handler);
+
+	if(err != ESP_OK)
+	{
+		ESP_LOGE(NVSTAG,NVS_ERR_WRITE,esp_err_to_name(err));
+		return;
+	}//End if
+}
+
+/*
+ * ***********************************************************************
+ * @brief       NVS_ReadBlob
+ * @param       key - Key to locate the value
+ * 				data - Buffer to hold the value
+ * 				len - Expected size in bytes
+ * @return      True if a blob of exactly len bytes was read
+ * @details     Read binary data from NVS. data is left untouched if the
+ * 				stored size differs, e.g. after a layout change.
+ **************************************************************************/
+bool NVS_ReadBlob(const char* key, void* data, const size_t len)
+{
+	if(nvs_handler == 0 || data == 0)
+	{
+		return false;
+	}//End if
+
+	size_t rdSize = 0;
+	esp_err_t err = nvs_get_blob(nvs_handler, key, NULL, &rdSize);
+
+	if(err == ESP_OK && rdSize != len)
+	{
+		return false;
+	}//End if
+
+	if(err == ESP_OK)
+	{
+		err = nvs_get_blob(nvs_handler, key, data, &rdSize);
+	}//End if
+
+	switch(err)
+	{
+		case ESP_OK:
+			return true;
+		case ESP_ERR_NVS_NOT_FOUND:
+			return false;
+		default:
+			ESP_LOGE(NVSTAG,NVS_ERR_RD, esp_err_to_name(err));
+			return false;
+	}//End switch
+}
+
 /*
  * ***********************************************************************
  * @brief       NVS_ReadU8
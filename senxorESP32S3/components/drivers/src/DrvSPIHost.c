@@ -6,10 +6,11 @@
  ******************************************************************************/
 #include "DrvSPIHost.h"
 #include "esp_err.h"
+#include "esp_private/gdma.h"
 
 //public:
 extern volatile uint32_t SenXorError;
-extern EXT_RAM_BSS_ATTR uint16_t CalibData_BufferData[CALIBDATA_FLASH_SIZE];
+extern uint16_t CalibData_BufferData[CALIBDATA_FLASH_SIZE];				//Placed by senxorTask.c, see memProfile.h
 uint8_t dataBuff[4] = {0};								//Data buffer holds data from SPI
 uint8_t Read_Flash_Timeout = 0;
 DMA_ATTR uint8_t dummy[4] = {0x80,0x00};		//Dummy data for SPI reading phrase
@@ -22,7 +23,15 @@ static spi_dma_desc_t *dmaDescTx;						//Address of DMA TX descriptor
 static spi_dma_desc_t *dmaDescRx;						//Address of DMA RX descriptor
 static int rx_dma_ch;									//RX Channel ID allocated for a SPI transaction
 static int tx_dma_ch;									//TX Channel ID allocated for a SPI transaction
+static uint32_t mFrameClkHz = 0;						//Register and frame clock set by Drv_SPI_SetFrameClock, 0 = as requested
+static uint32_t mClkHz = 0;								//Clock of the attached device
 static uint32_t selectSPISpd(const uint8_t sel);		//Select SPI clock speed by selection
+#if CONFIG_MI_SPI_CAPTURE_DMA
+DMA_ATTR static uint8_t mCaptureTxBuff[SPI_DMA_CAPTURE_MAX_WORDS * 2];	//Dummy words clocked out during a burst
+DMA_ATTR static uint8_t mCaptureRxBuff[SPI_DMA_CAPTURE_MAX_WORDS * 2];	//FIFO words received during a burst
+static Drv_SPI_CaptureDoneCb_t mCaptureDoneCb = NULL;	//Burst completion handler
+static bool IRAM_ATTR Drv_SPI_DMA_RxEof(gdma_channel_handle_t dma_chan, gdma_event_data_t *event_data, void *user_data);
+#endif
 
 /******************************************************************************
  * @brief       Drv_SPI_Init
@@ -90,6 +99,12 @@ void Drv_SPI_SENXOR_Init(uint32_t clk_speed, const uint8_t FlashEnable)
 		clk_speed = sel_clk;
 	}
 
+	if(!FlashEnable && mFrameClkHz != 0)
+	{
+		clk_speed = mFrameClkHz;												//Tuned clock, the flash keeps its own
+	}
+	mClkHz = clk_speed;
+
 	spi_device_interface_config_t spi_inter_config = {0};
 	spi_inter_config.clock_speed_hz = clk_speed;								//SPI Speed
 	spi_inter_config.duty_cycle_pos = 128;										//SPI Clock duty cycle
@@ -105,6 +120,31 @@ void Drv_SPI_SENXOR_Init(uint32_t clk_speed, const uint8_t FlashEnable)
 
 }
 
+/******************************************************************************
+ * @brief       Drv_SPI_SetFrameClock
+ * @param       clk_speed - SPI clock speed in Hz, 0 to use the clock each
+ * 				Drv_SPI_SENXOR_Init caller asks for
+ * @return      None
+ * @details     Clock of the register and frame reads, kept over the
+ * 				Drv_SPI_SENXOR_Init calls of SenXorLib. Reattaches SenXor at
+ * 				once, capture must be stopped.
+ *****************************************************************************/
+void Drv_SPI_SetFrameClock(const uint32_t clk_speed)
+{
+	mFrameClkHz = clk_speed;
+	Drv_SPI_SENXOR_Init((clk_speed != 0) ? clk_speed : DEFAULT_SPI_CLK_SPD, 0);
+}
+
+/******************************************************************************
+ * @brief       Drv_SPI_GetFrameClock
+ * @param       None
+ * @return      Clock of the attached device in Hz
+ *****************************************************************************/
+uint32_t Drv_SPI_GetFrameClock(void)
+{
+	return mClkHz;
+}
+
 /******************************************************************************
  * @brief       Drv_SPI_Senxor_ConstructData
  * @param       reg 	-> 7 bit Registers to access
@@ -238,6 +278,26 @@ void Read_CalibrationData(void)
 
 }
 
+/******************************************************************************
+ * @brief       Read_CalibrationHead
+ * @param       pBuf - Buffer for the first len bytes of the calibration data
+ * 				len - Number of bytes to read
+ * @return      True if the SenXor flash answered
+ * @details     Read the start of the calibration data only, to tell whether
+ * 				a cached copy belongs to the connected module.
+ *****************************************************************************/
+bool Read_CalibrationHead(uint8_t* pBuf, const uint32_t len)
+{
+	CalData_Available = false;
+
+	Drv_SPI_SENXOR_Init(SELECT_SPICLK_6M,1);
+
+	Read_Flash_Timeout = 0;
+	Read_SenXorExternal_Flash(0x0000,len,pBuf);
+
+	return Read_Flash_Timeout == 0;
+}
+
 /******************************************************************************
  * @brief       Drv_SPI_Host_PDMA_Disable
  * @param
@@ -452,4 +512,119 @@ void Drv_SPI_DMA_PrepDesc(void *txBuff, void *rxBuff, const int dataLen)
 
 }
 
+/******************************************************************************
+ * @brief       Drv_SPI_Restart
+ * @param		None
+ * @return      None
+ * @details    Bring the SPI engine back to its state after Drv_SPI_Init,
+ *				without touching the bus or the device: end a cut burst,
+ *				empty both FIFOs and reset the GDMA channels. Capture must be
+ *				stopped.
+ *****************************************************************************/
+void Drv_SPI_Restart(void)
+{
+	Drv_SPI_DMA_Disable();
+	Drv_Gpio_SSDATAN_PIN_Set(1);										//Chip de-select, a burst may have been cut
+	spi_ll_clear_int_stat(&GPSPI2);
+	Drv_SPI_DMA_PrepDesc(dummy, dataBuff_dma, DEFAULT_SPI_LENGTH);		//Resets the FIFOs and channels
+	ESP_LOGW(STAG,SPI_RESTART);
+}
+
+#if CONFIG_MI_SPI_CAPTURE_DMA
+/******************************************************************************
+ * @brief       Drv_SPI_DMA_CaptureInit
+ * @param		doneCb - Called from ISR when a burst is complete
+ * @return      ESP_OK if the DMA completion interrupt is registered
+ * @details    Prepare burst capture. The TX buffer is filled once with the
+ *				dummy read word so a burst only has to link the descriptors.
+ *****************************************************************************/
+esp_err_t Drv_SPI_DMA_CaptureInit(Drv_SPI_CaptureDoneCb_t doneCb)
+{
+	for(uint16_t i = 0; i < SPI_DMA_CAPTURE_MAX_WORDS; i++)
+	{
+		mCaptureTxBuff[i * 2] = dummy[0];
+		mCaptureTxBuff[i * 2 + 1] = dummy[1];
+	}
+
+	mCaptureDoneCb = doneCb;
+
+	const spi_dma_ctx_t *dma_ctx = spi_bus_get_dma_ctx(SPI2_HOST);
+	gdma_rx_event_callbacks_t rxCbs = {
+		.on_recv_eof = Drv_SPI_DMA_RxEof,									//Fires when the SPI transaction ends
+	};
+	const esp_err_t ret = gdma_register_rx_event_callbacks(dma_ctx->rx_dma_chan, &rxCbs, NULL);
+
+	if(ret == ESP_OK)
+	{
+		ESP_LOGI(STAG,SPI_DMA_CAP_INIT,SPI_DMA_CAPTURE_MAX_WORDS);
+	}
+	else
+	{
+		mCaptureDoneCb = NULL;
+		ESP_LOGE(STAG,SPI_DMA_CAP_ERR,esp_err_to_name(ret));
+	}// End if-else
+
+	return ret;
+}
+
+/******************************************************************************
+ * @brief       Drv_SPI_DMA_CaptureStart
+ * @param		words - Number of 16 bit FIFO words to read
+ * @return      True if the burst was started
+ * @details    Read words from SenXor's FIFO in one SPI transaction driven by
+ *				GDMA, with SSDATAN held low for the whole burst. Returns right
+ *				after starting, completion is reported to the callback given to
+ *				Drv_SPI_DMA_CaptureInit(). This function is ISR safe.
+ *****************************************************************************/
+bool IRAM_ATTR Drv_SPI_DMA_CaptureStart(const uint16_t words)
+{
+	const size_t len = words * 2;
+
+	if(mCaptureDoneCb == NULL || words == 0 || words > SPI_DMA_CAPTURE_MAX_WORDS || (len % 4) != 0)
+	{
+		return false;													//GDMA RX needs word aligned lengths
+	}
+
+	spicommon_dma_desc_setup_link(dmaDescTx, mCaptureTxBuff, len, false);	//One descriptor chain per burst
+	spi_ll_dma_tx_fifo_reset(&GPSPI2);
+	spi_ll_outfifo_empty_clr(&GPSPI2);
+	gdma_ll_tx_reset_channel(&GDMA, tx_dma_ch);
+	gdma_ll_tx_set_desc_addr(&GDMA, tx_dma_ch, (uint32_t)dmaDescTx);
+	gdma_ll_tx_start(&GDMA, tx_dma_ch);
+
+	spicommon_dma_desc_setup_link(dmaDescRx, mCaptureRxBuff, len, true);
+	spi_ll_dma_rx_fifo_reset(&GPSPI2);
+	spi_ll_infifo_full_clr(&GPSPI2);
+	gdma_ll_rx_reset_channel(&GDMA, rx_dma_ch);
+	gdma_ll_rx_set_desc_addr(&GDMA, rx_dma_ch, (uint32_t)dmaDescRx);
+	gdma_ll_rx_start(&GDMA, rx_dma_ch);
+
+	Drv_SPI_DMA_Enable();
+	GPSPI2.dma_int_clr.trans_done = 1;
+	GPSPI2.ms_dlen.ms_data_bitlen = words * DEFAULT_SPI_LENGTH - 1;	//Whole burst in one transaction
+	GPSPI2.user.usr_mosi = 1;										//Enable MOSI
+	GPSPI2.user.usr_miso = 1;										//Enable MISO
+
+	Drv_Gpio_SSDATAN_PIN_Set(0);
+	spi_ll_apply_config(&GPSPI2);
+	spi_ll_user_start(&GPSPI2);										//Initiate the burst
+
+	return true;
+}
+
+/******************************************************************************
+ * @brief       Drv_SPI_DMA_RxEof
+ * @param		dma_chan - GDMA RX channel of SPI2
+ *				event_data - Unused
+ *				user_data - Unused
+ * @return      True if a higher priority task was woken
+ * @details    GDMA RX EOF interrupt. Ends the burst and hands the data over.
+ *****************************************************************************/
+static bool IRAM_ATTR Drv_SPI_DMA_RxEof(gdma_channel_handle_t dma_chan, gdma_event_data_t *event_data, void *user_data)
+{
+	Drv_Gpio_SSDATAN_PIN_Set(1);									//Chip de-select
+	Drv_SPI_DMA_Disable();											//Register access is polled
 
+	return (mCaptureDoneCb != NULL) ? mCaptureDoneCb(mCaptureRxBuff) : false;
+}
+#endif
@@ -1,6 +1,6 @@
 /*****************************************************************************
  * @file     DrvWLAN.c
- * @version  1.8
+ * @version  1.10
  * @brief    WiFi driver
  * @date	 8 Jul 2022
  ******************************************************************************/
@@ -8,7 +8,10 @@
 #include "DrvNVS.h"
 #include "MCU_Dependent.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_netif_sntp.h"
 #include "sdkconfig.h"
+#include <sys/time.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -26,8 +29,18 @@ EXT_RAM_BSS_ATTR static EventGroupHandle_t s_wifi_event_group;
 static uint8_t s_retry_num = 0;
 static uint8_t sta_ssid[32];
 
+static portMUX_TYPE mTimeLock = portMUX_INITIALIZER_UNLOCKED;
+static int64_t mUtcOffsetUs = 0;										//UTC minus esp_timer time, 0 until the first SNTP sync
+#if CONFIG_MI_WLAN_SNTP_EN
+static bool mIsSntpStarted = false;
+#endif
+
 static void Drv_WLAN_EventGrpInit(void);
 static void Drv_WLAN_EventGrpDeinit(void);
+#if CONFIG_MI_WLAN_SNTP_EN
+static void Drv_WLAN_SntpStart(void);
+static void Drv_WLAN_SntpSynced(struct timeval* pTime);
+#endif
 
 /*
  * ***********************************************************************
@@ -47,6 +60,9 @@ static void ip_event_handler(void* arg, esp_event_base_t event_base,int32_t even
 	        s_retry_num = 0;
 	        xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
 	        mIsIpObtain = true;
+#if CONFIG_MI_WLAN_SNTP_EN
+	        Drv_WLAN_SntpStart();
+#endif
 	    break;
 		case IP_EVENT_STA_LOST_IP:
 			ip_obtain[0] = 0;
@@ -554,26 +570,23 @@ void Drv_WLAN_getCfgNvs(wlanCfg_t* pWlanCfgObj)
 /*
  * ***********************************************************************
  * @brief       Drv_WLAN_getRptToJson
- * @param       jsonObj - An existing JSON object
+ * @param       pWriter - Writer inside an existing JSON object
  * @return      None
  * @details     Add WLAN report to existing JSON object
  **************************************************************************/
-void Drv_WLAN_getRptToJson(cJSON* jsonObj)
+void Drv_WLAN_getRptToJson(jsonWriter_t* pWriter)
 {
-	uint8_t base_mac_addr[6] = {0};
-	char macAddrBuff[20] = {0};
-	ESP_ERROR_CHECK(esp_read_mac(base_mac_addr, ESP_MAC_WIFI_SOFTAP));
-	snprintf(macAddrBuff,20,"%x:%x:%x:%x:%x:%x",base_mac_addr[0],base_mac_addr[1],base_mac_addr[2],base_mac_addr[3],base_mac_addr[4],base_mac_addr[5]);
-	if(jsonObj == 0)
+	if(pWriter == 0)
 	{
 		return;
 	}
 
 	//Construct a JSON network report
-	cJSON *wlan_status_node = cJSON_AddObjectToObject(jsonObj, JSON_WLAN_STATUS_ROOT);
-
-	cJSON *network_root_node = cJSON_AddObjectToObject(wlan_status_node,JSON_WLAN_NET_ROOT);
-	cJSON_AddStringToObject(network_root_node, JSON_WLAN_NET_IP, ip_obtain);
+	jsonBeginObject(pWriter, JSON_WLAN_STATUS_ROOT);
+	jsonBeginObject(pWriter, JSON_WLAN_NET_ROOT);
+	jsonAddString(pWriter, JSON_WLAN_NET_IP, ip_obtain);
+	jsonEndObject(pWriter);
+	jsonEndObject(pWriter);
 }
 
 /*
@@ -582,40 +595,51 @@ void Drv_WLAN_getRptToJson(cJSON* jsonObj)
  * @param       result - Character buffer
  * 				buffLen - Buffer length
  * @return      None
- * @details     Get JSON string
+ * @details     Get JSON string, empty if it does not fit the buffer
  **************************************************************************/
 void Drv_WLAN_getRptJsonStr(char* result, int buffLen)
 {
+	jsonWriter_t json;
+	char ssid[sizeof(((wifi_sta_config_t*)0)->ssid) + 1] = {0};
 
 	//Display AP info
 	wifi_config_t wifi_config_info;												//WiFi AP info object
-	if (esp_wifi_get_config(WIFI_IF_STA, &wifi_config_info) != ESP_OK)
+	if (buffLen <= 0 || esp_wifi_get_config(WIFI_IF_STA, &wifi_config_info) != ESP_OK)
 	{
 		return;
 	}//End if
+	memcpy(ssid, wifi_config_info.sta.ssid, sizeof(wifi_config_info.sta.ssid));	//A 32 character SSID has no NUL
 
 	//Construct a JSON network report
-	cJSON *root = cJSON_CreateObject();
-	cJSON *wlan_status_node = cJSON_AddObjectToObject(root, JSON_WLAN_STATUS_ROOT);
-	cJSON *stat_root_node = cJSON_AddObjectToObject(wlan_status_node, JSON_WLAN_STAT_ROOT);
-	cJSON_AddStringToObject(stat_root_node, JSON_WLAN_STAT_SSID, (char*) wifi_config_info.sta.ssid);
+	jsonWriterInit(&json, result, buffLen, NULL, NULL);
+	jsonBeginObject(&json, NULL);
+	jsonBeginObject(&json, JSON_WLAN_STATUS_ROOT);
+	jsonBeginObject(&json, JSON_WLAN_STAT_ROOT);
+	jsonAddString(&json, JSON_WLAN_STAT_SSID, ssid);
+	jsonEndObject(&json);
 
 	if (esp_wifi_get_config(WIFI_IF_AP, &wifi_config_info) != ESP_OK)
 	{
-		cJSON_free(root);
+		result[0] = '\0';
 		return;
 	}//End if
 
-	cJSON *ap_root_node = cJSON_AddObjectToObject(wlan_status_node,JSON_WLAN_AP_ROOT);
-	cJSON_AddStringToObject(ap_root_node, JSON_WLAN_STAT_SSID, (char*) wifi_config_info.ap.ssid);
-	cJSON_AddStringToObject(ap_root_node, JSON_WLAN_AP_PWD, (char*) wifi_config_info.ap.password);
-	cJSON_AddNumberToObject(ap_root_node, JSON_WLAN_AP_CH, wifi_config_info.ap.channel);
-
-	cJSON *network_root_node = cJSON_AddObjectToObject(wlan_status_node,JSON_WLAN_NET_ROOT);
-	cJSON_AddStringToObject(network_root_node, JSON_WLAN_NET_IP, ip_obtain);
-    const char* rawJson = cJSON_PrintUnformatted(root);
-    memcpy(result,rawJson,strlen(rawJson));
-    cJSON_Delete(root);																	//Free up memory
+	memcpy(ssid, wifi_config_info.ap.ssid, sizeof(wifi_config_info.ap.ssid));
+	jsonBeginObject(&json, JSON_WLAN_AP_ROOT);
+	jsonAddString(&json, JSON_WLAN_STAT_SSID, ssid);
+	jsonAddString(&json, JSON_WLAN_AP_PWD, (char*) wifi_config_info.ap.password);
+	jsonAddInt(&json, JSON_WLAN_AP_CH, wifi_config_info.ap.channel);
+	jsonEndObject(&json);
+
+	jsonBeginObject(&json, JSON_WLAN_NET_ROOT);
+	jsonAddString(&json, JSON_WLAN_NET_IP, ip_obtain);
+	jsonEndObject(&json);
+	jsonEndObject(&json);
+	jsonEndObject(&json);
+	if (!jsonWriterFinish(&json))
+	{
+		result[0] = '\0';
+	}//End if
 }
 
 /*
@@ -673,6 +697,76 @@ bool Drv_WLAN_getIsIpObtained()
 	return mIsIpObtain;
 }
 
+/*
+ * ***********************************************************************
+ * @brief       Drv_WLAN_getUtcOffsetUs
+ * @param       None
+ * @return      UTC in microseconds minus esp_timer_get_time(), 0 until the
+ * 				clock is synchronised
+ * @details     Add it to a capture time from esp_timer to get its UTC time.
+ * 				The offset is set again at every SNTP sync.
+ **************************************************************************/
+int64_t Drv_WLAN_getUtcOffsetUs(void)
+{
+	taskENTER_CRITICAL(&mTimeLock);
+	const int64_t offsetUs = mUtcOffsetUs;
+	taskEXIT_CRITICAL(&mTimeLock);
+	return offsetUs;
+}
+
+#if CONFIG_MI_WLAN_SNTP_EN
+/*
+ * ***********************************************************************
+ * @brief       Drv_WLAN_SntpStart
+ * @param       None
+ * @return      None
+ * @details     Start SNTP the first time the station gets an IP. lwIP
+ * 				keeps it running over reconnects.
+ **************************************************************************/
+static void Drv_WLAN_SntpStart(void)
+{
+	if(mIsSntpStarted)
+	{
+		return;
+	}
+
+	esp_sntp_config_t config = ESP_NETIF_SNTP_DEFAULT_CONFIG(CONFIG_MI_WLAN_SNTP_SERVER);
+	config.sync_cb = Drv_WLAN_SntpSynced;
+	esp_sntp_set_sync_interval(CONFIG_MI_WLAN_SNTP_INTERVAL_MIN * 60UL * 1000UL);
+	const esp_err_t err = esp_netif_sntp_init(&config);
+	if(err != ESP_OK)
+	{
+		ESP_LOGE(WLANTAG, WLAN_ERR_SNTP, esp_err_to_name(err));
+		return;
+	}
+	mIsSntpStarted = true;
+	ESP_LOGI(WLANTAG, WLAN_SNTP_START, CONFIG_MI_WLAN_SNTP_SERVER);
+}
+
+/*
+ * ***********************************************************************
+ * @brief       Drv_WLAN_SntpSynced
+ * @param       pTime - Time received, already set
+ * @return      None
+ * @details     Called by lwIP after each sync. Takes the system clock and
+ * 				esp_timer at the same moment for the UTC offset.
+ **************************************************************************/
+static void Drv_WLAN_SntpSynced(struct timeval* pTime)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	const int64_t offsetUs = (int64_t)now.tv_sec * 1000000LL + now.tv_usec - esp_timer_get_time();
+
+	taskENTER_CRITICAL(&mTimeLock);
+	const int64_t lastUs = mUtcOffsetUs;
+	mUtcOffsetUs = offsetUs;
+	taskEXIT_CRITICAL(&mTimeLock);
+
+	ESP_LOGI(WLANTAG, WLAN_SNTP_SYNC, (long long)now.tv_sec, (lastUs != 0) ? (long)(offsetUs - lastUs) : 0L);
+}
+#endif
+
 /*
  * ***********************************************************************
  * @brief       Drv_WLAN_getAuthMode
@@ -1,6 +1,6 @@
 /*****************************************************************************
  * @file     Drv_BT.c
- * @version  1.0
+ * @version  1.1
  * @brief    Bluetooth driver
  * @date	 3 Jul 2023
  ******************************************************************************/
@@ -20,6 +20,7 @@ EXT_RAM_BSS_ATTR static char mBlufiBuff[BLUFI_BUFF_LEN];
 EXT_RAM_BSS_ATTR static wifi_config_t mWifiCfg;
 EXT_RAM_BSS_ATTR static wlanCfg_t mWlanCfgObj;
 EXT_RAM_BSS_ATTR static esp_blufi_extra_info_t mBlufExtraInfo;							//Blufi info object
+EXT_RAM_BSS_ATTR static char mRptBuff[BLUFI_RPT_LEN];
 
 static void Drv_Blufi_event_handler(esp_blufi_cb_event_t event, esp_blufi_cb_param_t *param);
 static void Drv_Blufi_Init(void);
@@ -28,6 +29,7 @@ static void Drv_BluFi_Advertise(char* devName);
 static void Drv_BluFi_fetchDevJSON(char* mJson);
 static void Drv_BluFi_fetchWipeJSON(char* mJson);
 static void Drv_BluFi_loadPref();
+static void Drv_BluFi_SendCtmReport(void);
 
 //Callback structure
 static esp_blufi_callbacks_t blufiCallbackObj =
@@ -141,11 +143,7 @@ static void Drv_Blufi_event_handler(esp_blufi_cb_event_t event, esp_blufi_cb_par
 			//Don't care the onnection status
 			esp_blufi_send_wifi_conn_report(WIFI_MODE_APSTA,ESP_BLUFI_STA_CONN_SUCCESS,1,&mBlufExtraInfo);
 		
-			cJSON *root = cJSON_CreateObject();
-		    Drv_WLAN_getRptToJson(root);									//Add network information to JSON
-			getSysInfoJson(root);											//Add system information
-		    Drv_BluFi_SendCtmDataJson(root);									//Wrap constructed JSON and send
-			cJSON_Delete(root);												//Free JSON object after use
+			Drv_BluFi_SendCtmReport();										//Network and system information
 
 		break;
 
@@ -607,25 +605,29 @@ static void Drv_BluFi_loadPref()
 
 /*
  * ***********************************************************************
- * @brief       Drv_BluFi_SendCtmDataJson
- * @param       mJSON - JSON to be sent
+ * @brief       Drv_BluFi_SendCtmReport
+ * @param       None
  * @return      None
- * @details     Wrap JSON and send via BluFi
+ * @details     Write the network and system information as custom data
+ * 				JSON and send it via BluFi
  **************************************************************************/
-void Drv_BluFi_SendCtmDataJson(cJSON* mJson)
+static void Drv_BluFi_SendCtmReport(void)
 {
-	if(mJson == 0)
+	jsonWriter_t json;
+
+	jsonWriterInit(&json, mRptBuff, sizeof(mRptBuff), NULL, NULL);
+	jsonBeginObject(&json, NULL);
+	jsonBeginObject(&json, BLUFI_CTM_JSON_ROOT);
+	Drv_WLAN_getRptToJson(&json);									//Add network information to JSON
+	getSysInfoJson(&json);											//Add system information
+	jsonEndObject(&json);
+	jsonEndObject(&json);
+	if(!jsonWriterFinish(&json))
 	{
+		ESP_LOGE(BTTAG, "Custom data report longer than %d bytes", BLUFI_RPT_LEN);
 		return;
-	}
-
-	cJSON *root = cJSON_CreateObject();
-	cJSON_AddItemToObject(root, BLUFI_CTM_JSON_ROOT, mJson);
-	
-
-	const char* jsonStr = cJSON_PrintUnformatted(root);
-	esp_blufi_send_custom_data((uint8_t*)jsonStr, strlen(jsonStr));
-	cJSON_free(root);
+	}//End if
+	esp_blufi_send_custom_data((uint8_t*)mRptBuff, strlen(mRptBuff));
 }
 
 /*
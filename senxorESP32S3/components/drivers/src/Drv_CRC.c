@@ -1,3 +1,4 @@
+#include "esp_rom_crc.h"
 #include "Drv_CRC.h"
 uint32_t  CalData_CRC;
 
@@ -16,7 +17,7 @@ void Drv_Crc_Open(void)
  * @brief       Drv_Crc_crc32_open
  * @param       none
  * @return      None
- * @details     open CRC 32 bit
+ * @details     open CRC 32 bit. The ROM routine of Drv_Crc_Crc32 needs no setup
  *****************************************************************************/
 void Drv_Crc_crc32_open(void)
 {
@@ -45,3 +46,19 @@ uint32_t Drv_Crc_GetCRCcheckSum(void)
 {
 	return 0;
 }
+
+/******************************************************************************
+ * @brief       Drv_Crc_Crc32
+ * @param       crc -> 0, or the result over the preceding data
+ * 				pData -> Data to be checked
+ * 				len -> Size of the data in bytes
+ * @return      CRC-32 of the data
+ * @details     CRC-32 (IEEE 802.3, reflected, init and final xor 0xFFFFFFFF)
+ * 				computed by the table driven routine in the ESP32-S3 ROM.
+ * 				Chaining the result over several buffers gives the CRC of
+ * 				the concatenated data.
+ *****************************************************************************/
+uint32_t Drv_Crc_Crc32(uint32_t crc, const uint8_t* pData, uint32_t len)
+{
+	return esp_rom_crc32_le(crc, pData, len);
+}
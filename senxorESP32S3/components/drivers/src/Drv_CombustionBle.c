@@ -12,8 +12,13 @@
 #include "esp_bt_main.h"
 #include "esp_gatt_common_api.h"
 #include "esp_mac.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include <string.h>
-#include <math.h>
+#include <stdlib.h>
+
+// senxorTask (main) re-evaluates its capture mode when the connection count changes
+extern void senxorTaskNotifyClientChange(void);
 
 // GATT database indices
 enum {
@@ -44,8 +49,10 @@ typedef struct {
     combustion_client_t clients[COMBUSTION_MAX_CONNECTIONS];
     uint8_t connected_count;
 
-    // Temperature data (in millikelvin)
+    // Temperatures last broadcast (in decikelvin)
     uint16_t temps[COMBUSTION_NUM_TEMPS];
+    TickType_t last_update_tick;
+    bool broadcast_once;
 
     // Device identity
     uint32_t serial_number;
@@ -57,6 +64,9 @@ typedef struct {
 
 static combustion_state_t mState = {0};
 
+// GATT server callback of the other application sharing the stack, if any
+static esp_gatts_cb_t mAppHandler = NULL;
+
 // Track initial advertising setup (only start advertising once during init)
 static bool initial_adv_setup_pending = false;
 static bool adv_data_configured = false;
@@ -169,9 +179,10 @@ static void combustionBle_GattsEventHandler(esp_gatts_cb_event_t event,
                                              esp_ble_gatts_cb_param_t *param);
 static void combustionBle_GapEventHandler(esp_gap_ble_cb_event_t event,
                                           esp_ble_gap_cb_param_t *param);
-static uint16_t combustionBle_EncodeTemp(uint16_t temp_mk);
+static uint16_t combustionBle_EncodeTemp(uint16_t temp_dk);
 static void combustionBle_PackTemps(const uint16_t encoded_temps[8], uint8_t output[13]);
-static void combustionBle_UpdateAdvData(void);
+static bool combustionBle_ShouldUpdate(const uint16_t temps[8], TickType_t now);
+static bool combustionBle_UpdateAdvData(void);
 static void combustionBle_StartAdvertising(void);
 static void combustionBle_SendNotifications(void);
 
@@ -181,17 +192,14 @@ static void combustionBle_SendNotifications(void);
  *****************************************************************************/
 static uint16_t combustionBle_EncodeTemp(uint16_t temp_dk)
 {
-    // Convert decikelvin to Celsius: (temp_dk / 10.0) - 273.15
-    float celsius = (temp_dk / 10.0f) - 273.15f;
-
-    // Apply Combustion encoding: (celsius + 20.0) / 0.05
-    float raw_float = (celsius + COMBUSTION_TEMP_OFFSET_C) / COMBUSTION_TEMP_SCALE_C;
+    // (celsius + 20.0) / 0.05 with celsius = temp_dk / 10.0 - 273.15, exact in integers
+    int32_t raw = (int32_t)temp_dk * COMBUSTION_TEMP_RAW_PER_DK - COMBUSTION_TEMP_DK_OFFSET_RAW;
 
     // Clamp to valid range
-    if (raw_float < 0) raw_float = 0;
-    if (raw_float > COMBUSTION_TEMP_MAX_RAW) raw_float = COMBUSTION_TEMP_MAX_RAW;
+    if (raw < 0) raw = 0;
+    if (raw > COMBUSTION_TEMP_MAX_RAW) raw = COMBUSTION_TEMP_MAX_RAW;
 
-    return (uint16_t)raw_float & COMBUSTION_TEMP_MAX_RAW;
+    return (uint16_t)raw;
 }
 
 /*****************************************************************************
@@ -207,29 +215,59 @@ static void combustionBle_PackTemps(const uint16_t encoded_temps[8], uint8_t out
     // Byte 3:  T2[1:0] | T3[12:7]
     // ... etc
 
-    memset(output, 0, 13);
-
-    int bit_pos = 0;
+    // Shift each value into an accumulator, emit whole bytes from its top.
+    // At most 7 + 13 bits are pending, bits above them are shifted out.
+    uint32_t acc = 0;
+    uint8_t pending = 0;
     for (int i = 0; i < 8; i++) {
-        uint16_t val = encoded_temps[i];
+        acc = (acc << COMBUSTION_TEMP_BITS) | (encoded_temps[i] & COMBUSTION_TEMP_MAX_RAW);
+        pending += COMBUSTION_TEMP_BITS;
 
-        // Write 13 bits starting at bit_pos
-        for (int b = 12; b >= 0; b--) {
-            int byte_idx = bit_pos / 8;
-            int bit_in_byte = 7 - (bit_pos % 8);
+        while (pending >= 8) {
+            pending -= 8;
+            *output++ = (uint8_t)(acc >> pending);
+        }
+    }
+}
 
-            if (val & (1 << b)) {
-                output[byte_idx] |= (1 << bit_in_byte);
-            }
-            bit_pos++;
+/*****************************************************************************
+ * @brief  Decide whether new temperatures are worth a broadcast
+ * @param  temps New temperatures in decikelvin
+ * @param  now   Current tick count
+ * @return true if a value moved past the deadband, or changed at all and
+ *         the drift interval elapsed, and the minimum interval elapsed
+ *****************************************************************************/
+static bool combustionBle_ShouldUpdate(const uint16_t temps[8], TickType_t now)
+{
+    if (!mState.broadcast_once) {
+        return true;
+    }
+
+    const TickType_t elapsed = now - mState.last_update_tick;
+    if (elapsed < pdMS_TO_TICKS(COMBUSTION_MIN_INTERVAL_MS)) {
+        return false;
+    }
+
+    // Compared with the last broadcast, so a slow drift still adds up
+    uint16_t max_delta = 0;
+    for (int i = 0; i < COMBUSTION_NUM_TEMPS; i++) {
+        const uint16_t delta = (uint16_t)abs((int32_t)temps[i] - (int32_t)mState.temps[i]);
+        if (delta > max_delta) {
+            max_delta = delta;
         }
     }
+
+    if (max_delta == 0) {
+        return false;
+    }
+    return (max_delta >= COMBUSTION_DEADBAND_DK) || (elapsed >= pdMS_TO_TICKS(COMBUSTION_DRIFT_INTERVAL_MS));
 }
 
 /*****************************************************************************
  * @brief  Update advertising data with current temperatures
+ * @return true if the packed temperatures changed
  *****************************************************************************/
-static void combustionBle_UpdateAdvData(void)
+static bool combustionBle_UpdateAdvData(void)
 {
     // Encode temperatures
     uint16_t encoded[8];
@@ -238,12 +276,17 @@ static void combustionBle_UpdateAdvData(void)
     }
 
     // Pack temperatures into 13 bytes
-    uint8_t packed_temps[13];
+    uint8_t packed_temps[COMBUSTION_PACKED_TEMPS_LEN];
     combustionBle_PackTemps(encoded, packed_temps);
 
+    // Clamped temperatures can change without changing the broadcast
+    if (mState.broadcast_once && memcmp(probe_status_value, packed_temps, sizeof(packed_temps)) == 0) {
+        return false;
+    }
+
     // Update probe_status_value for GATT reads and notifications
     // Format: 13 bytes of packed temps, then padding
-    memcpy(probe_status_value, packed_temps, 13);
+    memcpy(probe_status_value, packed_temps, sizeof(packed_temps));
 
     // Manufacturer data starts at offset 5 in raw_adv_data (after flags and mfr header)
     uint8_t *mfr_data = &raw_adv_data[5];
@@ -262,7 +305,7 @@ static void combustionBle_UpdateAdvData(void)
     mfr_data[6] = (mState.serial_number >> 24) & 0xFF;
 
     // Offset 7-19: Raw temperature data (13 bytes)
-    memcpy(&mfr_data[7], packed_temps, 13);
+    memcpy(&mfr_data[7], packed_temps, sizeof(packed_temps));
 
     // Offset 20: Mode/ID
     mfr_data[20] = 0x00;  // Normal mode
@@ -280,6 +323,7 @@ static void combustionBle_UpdateAdvData(void)
     if (mState.advertising) {
         esp_ble_gap_config_adv_data_raw(raw_adv_data, sizeof(raw_adv_data));
     }
+    return true;
 }
 
 /*****************************************************************************
@@ -427,6 +471,16 @@ static void combustionBle_GattsEventHandler(esp_gatts_cb_event_t event,
                                              esp_gatt_if_t gatts_if,
                                              esp_ble_gatts_cb_param_t *param)
 {
+    // Every application gets its own events, connections included
+    const bool other_app = (event == ESP_GATTS_REG_EVT) ? (param->reg.app_id != COMBUSTION_GATTS_APP_ID)
+                                                        : (gatts_if != mState.gatts_if);
+    if (other_app) {
+        if (mAppHandler != NULL) {
+            mAppHandler(event, gatts_if, param);
+        }
+        return;
+    }
+
     switch (event) {
         case ESP_GATTS_REG_EVT:
             if (param->reg.status == ESP_GATT_OK) {
@@ -481,6 +535,7 @@ static void combustionBle_GattsEventHandler(esp_gatts_cb_event_t event,
 
                 ESP_LOGI(COMBUSTION_TAG, "Client connected, conn_id=%d, slot=%d, total=%d",
                          param->connect.conn_id, slot, mState.connected_count);
+                senxorTaskNotifyClientChange();
 
                 // Update connection parameters for better latency
                 esp_ble_conn_update_params_t conn_params = {0};
@@ -506,6 +561,7 @@ static void combustionBle_GattsEventHandler(esp_gatts_cb_event_t event,
 
                 ESP_LOGI(COMBUSTION_TAG, "Client disconnected, conn_id=%d, remaining=%d",
                          param->disconnect.conn_id, mState.connected_count);
+                senxorTaskNotifyClientChange();
             }
 
             // Restart advertising
@@ -559,6 +615,7 @@ esp_err_t combustionBle_Init(void)
     for (int i = 0; i < COMBUSTION_NUM_TEMPS; i++) {
         mState.temps[i] = 0;
     }
+    mState.broadcast_once = false;
 
     // Update advertising data with initial values
     combustionBle_UpdateAdvData();
@@ -604,14 +661,28 @@ void combustionBle_UpdateTemps(const uint16_t temps[8])
         return;
     }
 
+    const TickType_t now = xTaskGetTickCount();
+    if (!combustionBle_ShouldUpdate(temps, now)) {
+        return;
+    }
+
     // Copy new temperature values
     memcpy(mState.temps, temps, sizeof(mState.temps));
+    mState.last_update_tick = now;
 
-    // Update advertising data
-    combustionBle_UpdateAdvData();
+    // Update advertising data, notify connected clients if the packed values changed
+    if (combustionBle_UpdateAdvData()) {
+        combustionBle_SendNotifications();
+    }
+    mState.broadcast_once = true;
+}
 
-    // Send notifications to connected clients
-    combustionBle_SendNotifications();
+/*****************************************************************************
+ * @brief  Forward the GATT server events of other applications
+ *****************************************************************************/
+void combustionBle_SetAppHandler(esp_gatts_cb_t handler)
+{
+    mAppHandler = handler;
 }
 
 /*****************************************************************************
@@ -56,6 +56,7 @@ void ESP32_Peri_Init(void)
 
 	Drv_SPI_Init();															//Initialise MCU SPI Bus
 	Drv_SPI_SENXOR_Init(DEFAULT_SPI_CLK_SPD,0);		//Initialise SPI Interface
+	Capture_Init();									//Select polled or DMA frame capture
 
 	ESP_LOGI(MCUTAG,MCU_INIT_DONE);
 }
@@ -1,6 +1,6 @@
 /*****************************************************************************
  * @file     restServer.h
- * @version  2.16
+ * @version  2.17
  * @brief    Header file for restServer.c
  * @date	 26 Apr 2023
  ******************************************************************************/
@@ -14,10 +14,36 @@
 #include <esp_log.h>
 #include <esp_vfs.h>
 #include <esp_system.h>
-#include <cJSON.h>
+#include "jsonWriter.h"
 #include "DrvWLAN.h"
 #include "DrvNVS.h"
 #include "msg.h"
+#include "LatencyTrace.h"
+
+#if CONFIG_MI_WS_STREAM_EN
+#define RST_STACK_SIZE			3072								//WebSocket handshakes subscribe to the frame bus
+#define RST_WS_SOCKETS			CONFIG_MI_WS_MAX_CLIENTS			//One per WebSocket viewer
+#else
+#define RST_STACK_SIZE			2048
+#define RST_WS_SOCKETS			0
+#endif
+#if CONFIG_MI_SNAP_JPEG_EN
+#define RST_MJPEG_SOCKETS		CONFIG_MI_SNAP_MJPEG_MAX_CLIENTS	//An MJPEG viewer holds its session open
+#else
+#define RST_MJPEG_SOCKETS		0
+#endif
+#if CONFIG_MI_MEM_PROFILE_INTERNAL
+#define RST_REST_SOCKETS		3									//Calibration data leaves little internal heap for socket buffers
+#else
+#define RST_REST_SOCKETS		5									//Dashboards polling /stats and /metrics keep their sessions alive
+#endif
+#define RST_MAX_OPEN_SOCKETS	(RST_REST_SOCKETS + RST_WS_SOCKETS + RST_MJPEG_SOCKETS)	//REST sessions plus the long lived ones
+#define RST_MAX_URI_HANDLERS	12									//Handlers of this file and of the modules that register their own
+#define RST_JSON_CHUNK			512									//JSON replies go out in chunks of this size
+
+#if RST_MAX_OPEN_SOCKETS > CONFIG_LWIP_MAX_SOCKETS - 3
+#error "The REST server needs 3 lwIP sockets for itself, raise CONFIG_LWIP_MAX_SOCKETS or lower the viewer counts"
+#endif
 
 
 //Structure definition for JSON strings
@@ -99,4 +125,8 @@ void printAreaCfgDetails(const areaJsonCfgStruct* areaCfgObj);
 
 httpd_handle_t getRestServerHandler();
 
+void restServer_JsonBegin(jsonWriter_t* pWriter, httpd_req_t *req);
+
+esp_err_t restServer_JsonEnd(jsonWriter_t* pWriter, httpd_req_t *req);
+
 #endif /* COMPONENTS_NET_INCLUDE_RESTSERVER_H_ */
@@ -1,6 +1,6 @@
 /*****************************************************************************
  * @file     restServer.c
- * @version  1.1
+ * @version  1.2
  * @brief    REST Sever
  * @date	 26 Apr 2023
  * @Author	 Sarashina Ruka
@@ -17,12 +17,17 @@ EXT_RAM_BSS_ATTR areaJsonCfgArrStruct monitorAreaCfgObj;
 #if CONFIG_ESPMODEL_S3MINI_C
 //extern QueueHandle_t areaCfgQueue;
 #endif
-extern void senxorTask_getRptToJson(cJSON* jsonObj);
+extern void bootTimelineGetRptToJson(jsonWriter_t* pWriter);
 //private:
 static httpd_handle_t server = NULL;
+static char mJsonBuff[RST_JSON_CHUNK];								//JSON reply chunk, handlers run one at a time in the httpd task
 
 static esp_err_t restServer_Start();
+static bool restServer_JsonFlush(void* pCtx, const char* pData, size_t len);
 static esp_err_t system_info_get_handler(httpd_req_t *req);
+#if CONFIG_MI_LATENCY_TRACE_EN
+static esp_err_t metrics_get_handler(httpd_req_t *req);
+#endif
 
 /*
  * ***********************************************************************
@@ -85,6 +90,51 @@ httpd_handle_t getRestServerHandler()
 	return server;
 }
 
+/*
+ * ***********************************************************************
+ * @brief       restServer_JsonBegin
+ * @param       pWriter - Writer to set up
+ * 				req - HTTP request the reply is for
+ * @return      None
+ * @details     Start a chunked JSON reply. Only for handlers of this
+ * 				server, they share one chunk buffer.
+ **************************************************************************/
+void restServer_JsonBegin(jsonWriter_t* pWriter, httpd_req_t *req)
+{
+	httpd_resp_set_type(req, "application/json");				//HTTP content type is JSON
+	jsonWriterInit(pWriter, mJsonBuff, sizeof(mJsonBuff), restServer_JsonFlush, req);
+}
+
+/*
+ * ***********************************************************************
+ * @brief       restServer_JsonEnd
+ * @param       pWriter - Writer of the reply
+ * 				req - HTTP request the reply is for
+ * @return      ESP_FAIL if the client could not take the reply, the
+ * 				session is then closed
+ **************************************************************************/
+esp_err_t restServer_JsonEnd(jsonWriter_t* pWriter, httpd_req_t *req)
+{
+	if(!jsonWriterFinish(pWriter))
+	{
+		return ESP_FAIL;
+	}//End if
+	return httpd_resp_send_chunk(req, NULL, 0);					//Last chunk
+}
+
+/*
+ * ***********************************************************************
+ * @brief       restServer_JsonFlush
+ * @param       pCtx - HTTP request
+ * 				pData - Chunk to send
+ * 				len - Chunk size
+ * @return      false if the chunk was not sent
+ **************************************************************************/
+static bool restServer_JsonFlush(void* pCtx, const char* pData, size_t len)
+{
+	return httpd_resp_send_chunk((httpd_req_t*)pCtx, pData, len) == ESP_OK;
+}
+
 /*
  * ***********************************************************************
  * @brief       restServer_Start
@@ -101,9 +151,11 @@ static esp_err_t restServer_Start()
     rest_server_context_t *rest_context = calloc(1, sizeof(rest_server_context_t));
 #endif
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
-    config.stack_size = 2048;
-    config.max_open_sockets = 2;
+    config.stack_size = RST_STACK_SIZE;
+    config.max_open_sockets = RST_MAX_OPEN_SOCKETS;
+    config.max_uri_handlers = RST_MAX_URI_HANDLERS;
     config.uri_match_fn = httpd_uri_match_wildcard;
+    config.lru_purge_enable = true;												//A new dashboard session closes the longest idle one instead of being refused
 
     ESP_LOGI(RSTTAG, RSTSER_INFO);
     ESP_LOGI(RSTTAG,MAIN_FREE_RAM " / " MAIN_TOTAL_RAM,heap_caps_get_free_size(MALLOC_CAP_INTERNAL), heap_caps_get_total_size(MALLOC_CAP_INTERNAL));								//Display the total amount of DRAM
@@ -132,6 +184,17 @@ static esp_err_t restServer_Start()
     };
     httpd_register_uri_handler(server, &system_info_get_uri);
 
+#if CONFIG_MI_LATENCY_TRACE_EN
+    /* URI handler for per-stage latency */
+    httpd_uri_t metrics_get_uri = {
+        .uri = "/metrics",
+        .method = HTTP_GET,
+        .handler = metrics_get_handler,
+        .user_ctx = rest_context
+    };
+    httpd_register_uri_handler(server, &metrics_get_uri);
+#endif
+
     switch(err)
     {
     	case ESP_OK:
@@ -153,9 +216,10 @@ static esp_err_t restServer_Start()
  **************************************************************************/
 static esp_err_t system_info_get_handler(httpd_req_t *req)
 {
-	httpd_resp_set_type(req, "application/json");				//HTTP content type is JSON
-    cJSON *root = cJSON_CreateObject();							//Create a JSON object
-    cJSON *sys_info = cJSON_AddObjectToObject(root, "sys_info");
+    jsonWriter_t json;
+    restServer_JsonBegin(&json, req);
+    jsonBeginObject(&json, NULL);
+    jsonBeginObject(&json, "sys_info");
 
     /*
      * Add data to JSON
@@ -163,17 +227,68 @@ static esp_err_t system_info_get_handler(httpd_req_t *req)
     esp_chip_info_t chip_info;
     esp_chip_info(&chip_info);
 
-    cJSON_AddStringToObject(sys_info, "version", IDF_VER);
-    cJSON_AddNumberToObject(sys_info, "cores", chip_info.cores);
-    cJSON_AddNumberToObject(sys_info, "model", chip_info.model);
-    cJSON_AddNumberToObject(sys_info, "speed", CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+    jsonAddString(&json, "version", IDF_VER);
+    jsonAddInt(&json, "cores", chip_info.cores);
+    jsonAddInt(&json, "model", chip_info.model);
+    jsonAddInt(&json, "speed", CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+    jsonEndObject(&json);
 
-    const char *sendStr = cJSON_Print(root);									//Format JSON to string
-    httpd_resp_sendstr(req, sendStr);											//Send JSON object
+    jsonBeginObject(&json, "boot");										//Boot milestones, ms since power-on
+    bootTimelineGetRptToJson(&json);
+    jsonEndObject(&json);
+    jsonEndObject(&json);
 
-    free((void *)sendStr);
-    cJSON_Delete(root);
-    return ESP_OK;
+    return restServer_JsonEnd(&json, req);
 }//End system_info_get_handler
 
+#if CONFIG_MI_LATENCY_TRACE_EN
+/*
+ * ***********************************************************************
+ * @brief       metrics_get_handler
+ * @param       req - HTTP Request object
+ * @return      None
+ * @details     Send the latency of every frame pipeline stage in us and
+ * 				the execution time of the analytics functions in ns
+ **************************************************************************/
+static esp_err_t metrics_get_handler(httpd_req_t *req)
+{
+    latencyStats_t stats[LAT_STAT_COUNT];
+    latencyFuncStats_t funcStats[LAT_FUNC_COUNT];
+    LatencyTrace_GetStats(stats);
+    LatencyTrace_GetFuncStats(funcStats);
+
+    jsonWriter_t json;
+    restServer_JsonBegin(&json, req);
+    jsonBeginObject(&json, NULL);
+    jsonBeginObject(&json, "latency_us");
+
+    for (uint8_t i = 0; i < LAT_STAT_COUNT; i++)
+    {
+        jsonBeginObject(&json, LatencyTrace_GetStageName(i));
+        jsonAddInt(&json, "count", stats[i].mCount);
+        jsonAddInt(&json, "min", stats[i].mMinUs);
+        jsonAddInt(&json, "avg", stats[i].mAvgUs);
+        jsonAddInt(&json, "p99", stats[i].mP99Us);
+        jsonAddInt(&json, "max", stats[i].mMaxUs);
+        jsonEndObject(&json);
+    }//End for
+    jsonEndObject(&json);
+
+    jsonBeginObject(&json, "func_ns");
+    for (uint8_t i = 0; i < LAT_FUNC_COUNT; i++)
+    {
+        jsonBeginObject(&json, LatencyTrace_GetFuncName(i));
+        jsonAddInt(&json, "calls", funcStats[i].mCalls);
+        jsonAddInt(&json, "min", funcStats[i].mMinNs);
+        jsonAddInt(&json, "avg", funcStats[i].mAvgNs);
+        jsonAddInt(&json, "max", funcStats[i].mMaxNs);
+        jsonEndObject(&json);
+    }//End for
+    jsonEndObject(&json);
+    jsonEndObject(&json);
+
+    return restServer_JsonEnd(&json, req);
+}//End metrics_get_handler
+#endif
+
 
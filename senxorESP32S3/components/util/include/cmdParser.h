@@ -20,6 +20,54 @@
 #define CMD_WMDE "WMDE"
 #define CMD_RRSE "RRSE"
 #define CMD_POLL "POLL"
+#define CMD_STAT "STAT"
+#define CMD_SFMT "SFMT"
+#define CMD_CAPS "CAPS"
+#define CMD_ROIW "ROIW"
+#define CMD_ROIR "ROIR"
+#define CMD_BRWR "BRWR"
+#define CMD_SUBS "SUBS"
+#define CMD_SUBV "SUBV"
+#define CMD_SCRC "SCRC"
+#define CMD_LATS "LATS"
+#define CMD_RECC "RECC"
+#define CMD_RECD "RECD"
+#define CMD_SAVE "SAVE"
+#define CMD_BPIX "BPIX"
+#define CMD_BNCH "BNCH"
+#define CMD_SYST "SYST"
+#define CMD_SHAP "SHAP"
+#define CMD_BLOB "BLOB"
+#define CMD_RULE "RULE"
+#define CMD_ALRM "ALRM"
+#define CMD_ESPN "ESPN"
+#define CMD_CORR "CORR"
+
+/* BRWR binary batch definition*/
+#define BRWR_OP_READ			0x00
+#define BRWR_OP_WRITE			0x01
+#define BRWR_OP_REJECTED		0x80	// Set in the op byte of the response for an unknown op
+#define BRWR_OP_SIZE			4		// op, address, 16-bit little endian value
+#define BRWR_MAX_OPS			24		// Response must fit the 128 byte USB CDC buffer
+#define BRWR_STATUS_OK			0x00
+#define BRWR_STATUS_BAD_LEN		0x01
+#define BRWR_STATUS_BAD_CRC		0x02
+
+/* CORR correction map definition*/
+#define CORR_OP_STATUS			0x00
+#define CORR_OP_WRITE			0x01
+#define CORR_OP_COMMIT			0x02
+#define CORR_OP_CLEAR			0x03
+#define CORR_HEAD_SIZE			4		// op, 16-bit little endian first pixel, count
+#define CORR_ENTRY_SIZE			4		// 16-bit little endian gain and offset
+#define CORR_STATUS_OK			0x00
+#define CORR_STATUS_BAD_LEN		0x01
+#define CORR_STATUS_BAD_CRC		0x02
+#define CORR_STATUS_BAD_RANGE	0x03
+
+/* SUBS register subscription definition*/
+#define SUBS_MAX_REGS			24		// Registers in one subscription
+#define SUBV_REG_SIZE			3		// address, 16-bit little endian value
 
 /* Data format definition*/
 #define EVK_CMD_START_CHAR 		'#'
@@ -36,6 +84,12 @@
 #define CP_DLEN_FIELD_LEN		5
 #define CP_CRC_FIELD_LEN		5
 #define CP_DATA_FIELD_LEN		512
+#define CP_MAX_CMD_LEN			(NUM_BYTES_CMD_FIELD + CP_DATA_FIELD_LEN + NUM_BYTES_CRC_FIELD)	// Largest value of the length field
+
+/* cmdParser_FeedCmd results*/
+#define CP_CMD_PENDING			0		// More input needed
+#define CP_CMD_READY			1		// A verified command is ready for cmdParser_CommitCmd
+#define CP_CMD_CRC_FAIL			(-1)	// A command was received with a bad checksum
 
 // Messages
 #define CPTAG					"[CMD_PHASER]"
@@ -56,6 +110,7 @@
 #define CP_INFO_CRC_OK			"Data verified."
 #define CP_WARN_INPUT_LEN_OVER	"Input size exceeds the limit. Capping size to %d ."
 #define CP_WARN_INPUT_CRC_NULL	"No checksum is provided. Ignoring data integrity check."
+#define CP_WARN_CMD_TOO_LONG	"Command length %lu exceeds the data buffer, skipped."
 
 typedef enum cmdList
 {	
@@ -98,6 +153,9 @@ typedef struct cmdPhaserClass
 	uint8_t mCmd[CP_CMD_FIELD_LEN];
 	uint8_t mData[CP_DATA_FIELD_LEN];
 	uint8_t mCRC[CP_CRC_FIELD_LEN];
+	uint32_t mFieldPtr;				// Position in the current field
+	uint32_t mLenValue;				// Value of the length field
+	uint32_t mChksum;				// Running checksum of the length, command and data
 }cmdPhaser;
 
 
@@ -107,8 +165,14 @@ uint8_t cmdParser_CommitCmd(const cmdPhaser* pCmdPhaser, uint8_t* pAckBuff);
 
 int cmdParser_PharseCmd(cmdPhaser* pCmdPhaser, const uint8_t* pInput, size_t pInputSize);
 
+int cmdParser_FeedCmd(cmdPhaser* pCmdPhaser, const uint8_t* pInput, size_t pInputSize, size_t* pConsumed);
+
 void cmdParser_PrintResult(const cmdPhaser* pCmdPhaser);
 
+bool cmdParser_GetBulkRange(const uint8_t* pAck, const size_t ackLen, uint32_t* pOffset, uint32_t* pLen);
+
+uint16_t cmdParser_ReadRegister(int addr);
+
 int toHex(const char* str);
 
 int getHexValue(const char c);
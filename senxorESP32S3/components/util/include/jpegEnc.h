@@ -0,0 +1,43 @@
+/*****************************************************************************
+ * @file     jpegEnc.h
+ * @version  1.00
+ * @brief    Header file for jpegEnc.c
+ * @date	 14 Oct 2026
+ ******************************************************************************/
+#ifndef COMPONENTS_UTIL_INCLUDE_JPEGENC_H_
+#define COMPONENTS_UTIL_INCLUDE_JPEGENC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define JPEG_QUALITY_MIN	1
+#define JPEG_QUALITY_MAX	100
+#define JPEG_HEADER_SIZE	623					//Markers before the entropy coded data, 4:4:4 with all tables
+
+/*
+ * Huffman code of one symbol
+ */
+typedef struct jpegCode{
+	uint16_t mCode;
+	uint8_t mLen;
+}jpegCode_t;
+
+/*
+ * Tables of one quality setting, built by jpegEncSetQuality.
+ * Index 0 is luminance, 1 chrominance.
+ */
+typedef struct jpegEncoder{
+	uint8_t mQuality;
+	uint8_t mQuant[2][64];					//Zigzag order, as written to DQT
+	float mScale[2][64];					//Reciprocal of quantiser and DCT scale, natural order
+	jpegCode_t mDcCode[2][12];
+	jpegCode_t mAcCode[2][256];
+}jpegEncoder_t;
+
+void jpegEncSetQuality(jpegEncoder_t* pEnc, const uint8_t quality);
+
+size_t jpegEncodeRgb565(const jpegEncoder_t* pEnc, const uint16_t* pImage, const uint16_t w, const uint16_t h,
+						uint8_t* pOut, const size_t outSize);
+
+#endif /* COMPONENTS_UTIL_INCLUDE_JPEGENC_H_ */
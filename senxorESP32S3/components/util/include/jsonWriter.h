@@ -0,0 +1,60 @@
+/*****************************************************************************
+ * @file     jsonWriter.h
+ * @version  1.00
+ * @brief    Header file for jsonWriter.c
+ * @date	 15 Oct 2026
+ ******************************************************************************/
+#ifndef COMPONENTS_UTIL_INCLUDE_JSONWRITER_H_
+#define COMPONENTS_UTIL_INCLUDE_JSONWRITER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define JSON_MAX_DEPTH		32					//Nested objects and arrays, one bit each in mHasMember
+#define JSON_NUMBER_MAX		24					//Longest number written
+
+/*
+ * Takes the buffer once it is full and at the end. Returns false if the
+ * data could not be sent, the writer then drops the rest.
+ */
+typedef bool (*jsonFlush_t)(void* pCtx, const char* pData, size_t len);
+
+/*
+ * Output state of one document. Without a flush function the document
+ * must fit the buffer, which is NUL terminated by jsonWriterFinish.
+ */
+typedef struct jsonWriter{
+	char* pBuff;
+	size_t mSize;
+	size_t mPos;
+	jsonFlush_t pFlush;
+	void* pCtx;
+	uint32_t mHasMember;					//Bit n: level n needs a comma before the next member
+	uint8_t mDepth;
+	bool mError;							//Overflow or failed flush, nothing more is written
+}jsonWriter_t;
+
+void jsonWriterInit(jsonWriter_t* pWriter, char* pBuff, const size_t size, jsonFlush_t pFlush, void* pCtx);
+
+bool jsonWriterFinish(jsonWriter_t* pWriter);
+
+void jsonBeginObject(jsonWriter_t* pWriter, const char* pKey);
+
+void jsonEndObject(jsonWriter_t* pWriter);
+
+void jsonBeginArray(jsonWriter_t* pWriter, const char* pKey);
+
+void jsonEndArray(jsonWriter_t* pWriter);
+
+void jsonAddString(jsonWriter_t* pWriter, const char* pKey, const char* pValue);
+
+void jsonAddInt(jsonWriter_t* pWriter, const char* pKey, const int64_t value);
+
+void jsonAddFloat(jsonWriter_t* pWriter, const char* pKey, const double value, const uint8_t decimals);
+
+void jsonAddBool(jsonWriter_t* pWriter, const char* pKey, const bool value);
+
+void jsonAddNull(jsonWriter_t* pWriter, const char* pKey);
+
+#endif /* COMPONENTS_UTIL_INCLUDE_JSONWRITER_H_ */
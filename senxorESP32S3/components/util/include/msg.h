@@ -128,6 +128,8 @@
 #define LCD_INIT_INFO					"LCD Initialising..."
 #define LCD_INIT_DONE					"LCD Initialised."
 #define LCD_TASK_INFO					"Display task started. Running in Core %d"
+#define LCD_LIVE_INFO					"Live view: colour map %d, %dx scale, %d bytes of DMA buffers."
+#define LCD_ERR_LIVE_SUB				"Cannot subscribe to the frame bus, live view stopped."
 
 
 
@@ -142,6 +144,9 @@
 #define SPI_DEV_ADD						"Added SPI device."
 #define SPI_DEV_DEL 					"Removing existing SPI device..."
 #define SPI_DMA_INIT					"Attached SPI to DMA.\nDMA TX channel: %d | DMA RX channel: %d "
+#define SPI_DMA_CAP_INIT				"Frame capture uses DMA bursts of up to %d words."
+#define SPI_DMA_CAP_ERR					"Cannot register DMA completion interrupt (%s). Using polled capture."
+#define SPI_RESTART						"SPI FIFOs and DMA channels reset."
 #define SPI_ERR_BUFF_EPY				"Buffers empty"
 #define SPI_ERR_CLK_SPD					"Invalid clock speed. (%lu Hz) Reverting to default clock speed (%d Hz)"
 #define SPI_SPD_SEL						"Selecting SPI Clock (Present %lu) with %lu Hz..."
@@ -172,6 +177,9 @@
 #define SXR_CAP_MODE_1					"Capture a frame."
 #define SXR_CAP_MODE_2					"Capture frames continuously."
 #define SXR_CAP_NA						"Capturing mode unknown."
+#define SXR_CAP_DEMAND					"Capture for %d Hz demand (%s)."
+#define SXR_PM_INFO						"Light sleep enabled, CPU %d - %d MHz."
+#define SXR_PM_WARN						"Power management not available: %s"
 #define SXR_DATA_HEADER 				"FRAME - %d \n\r VDD %d mV | Die temperature %d mK \n Maximum temperature: %d mK | Minimum temperature: %d mK "
 #define SXR_DATA_CAP 					"Pixel 80: %d mK | Pixel 2480: %d mK | Pixel 5039: %d mK \r"
 #define SXR_DATA_CAP_DEG				"Pixel 80: %f C | Pixel 2480: %f C | Pixel 5039: %f C \r"
@@ -193,6 +201,10 @@
 #define SXR_REG_ROLL_AVG				"Rolling average strength (Register 0xD3): %d"
 #define SXR_PROCESS_CALI				"Processing calibration data..."
 #define SXR_PROCESS_CALI_DONE			"Finished processing."
+#define SXR_CALI_CACHE_HIT				"Calibration data loaded from the NVS cache."
+#define SXR_CALI_CACHE_MISS				"Calibration cache %s, reading SenXor's flash."
+#define SXR_CALI_CACHE_SAVED			"Calibration data cached, %u bytes."
+#define SXR_BOOT_PHASE					"Boot phase %-12s %6lld us"
 #define SXR_PIX_CNT						"Total Pixel count: %lu "
 #define SXR_INIT_DONE					"SenXor initialised."
 #define SXR_PROD_INFO					"Production info Year: %d | Week: %d | Location: %d  SN: %lld"
@@ -203,6 +215,8 @@
 #define SXR_NO_DATA						"Data not available."
 #define SXR_TASK_INFO					"SenXor task started, running on core %d ."
 #define SXR_WARN_RECR					"Attempting to recover..."
+#define SXR_WARN_RECR_LEVEL				"Recovery level %d (%s)."
+#define SXR_INFO_RECOVERED				"Capture resumed %lu us after the error."
 
 //D-7 - NVS
 #define NVSTAG							"[NVS]"
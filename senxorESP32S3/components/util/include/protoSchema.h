@@ -0,0 +1,634 @@
+/*****************************************************************************
+ * @file     protoSchema.h
+ * @brief    Command packet and layouts shared with the clients
+ * @details	 Generated by Node_Thermal_TCP/genProtocol.js from
+ * 			 protocolSchema.json, do not edit. The packet codec and the
+ * 			 layout get and set functions are the ones protocol.js and
+ * 			 ThermalProtocol.swift are generated with, all three are
+ * 			 tested against test/host/vectors/protocol.txt. PROTO_CHECK_*
+ * 			 fail the build when a packed struct or a set of defines no
+ * 			 longer matches the schema.
+ ******************************************************************************/
+#ifndef COMPONENTS_UTIL_INCLUDE_PROTOSCHEMA_H_
+#define COMPONENTS_UTIL_INCLUDE_PROTOSCHEMA_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Command word, the 4 command letters big endian
+#define PROTO_CMD_CODE(p)			(((uint32_t)(p)[0] << 24) | ((uint32_t)(p)[1] << 16) | ((uint32_t)(p)[2] << 8) | (uint32_t)(p)[3])
+#define PROTO_CMD_WREG						0x57524547UL		//Write a register
+#define PROTO_CMD_RREG						0x52524547UL		//Read a register
+#define PROTO_CMD_RRSE						0x52525345UL		//Read a register sequence
+#define PROTO_CMD_BRWR						0x42525752UL		//Binary batch register read and write
+#define PROTO_CMD_WSID						0x57534944UL		//Set the Wi-Fi SSID
+#define PROTO_CMD_WPWD						0x57505744UL		//Set the Wi-Fi password
+#define PROTO_CMD_WMDE						0x574D4445UL		//Set the Wi-Fi mode
+#define PROTO_CMD_POLL						0x504F4C4CUL		//Set the quadrant polling rate
+#define PROTO_CMD_STAT						0x53544154UL		//Read stream statistics
+#define PROTO_CMD_SFMT						0x53464D54UL		//Select the frame stream format
+#define PROTO_CMD_SHAP						0x53484150UL		//Shape the frame stream
+#define PROTO_CMD_SCRC						0x53435243UL		//Select the frame integrity check
+#define PROTO_CMD_CAPS						0x43415053UL		//Read capture interrupt statistics
+#define PROTO_CMD_LATS						0x4C415453UL		//Read pipeline latency
+#define PROTO_CMD_ROIW						0x524F4957UL		//Define a region of interest
+#define PROTO_CMD_ROIR						0x524F4952UL		//Read region of interest statistics
+#define PROTO_CMD_SUBS						0x53554253UL		//Subscribe to register updates
+#define PROTO_CMD_SUBV						0x53554256UL		//Register update push
+#define PROTO_CMD_RECC						0x52454343UL		//Frame recorder control
+#define PROTO_CMD_RECD						0x52454344UL		//Download a recorded clip
+#define PROTO_CMD_SAVE						0x53415645UL		//Commit the configuration
+#define PROTO_CMD_BPIX						0x42504958UL		//Bad pixel map
+#define PROTO_CMD_BNCH						0x424E4348UL		//Run a microbenchmark
+#define PROTO_CMD_SYST						0x53595354UL		//Read system telemetry
+#define PROTO_CMD_BLOB						0x424C4F42UL		//Hot spot blob tracking
+#define PROTO_CMD_RULE						0x52554C45UL		//Alarm rules
+#define PROTO_CMD_ALRM						0x414C524DUL		//Alarm event push
+#define PROTO_CMD_ESPN						0x4553504EUL		//ESP-NOW peer table
+#define PROTO_CMD_CORR						0x434F5252UL		//Per-pixel correction map
+
+// Command packet: prefix, length, command, data and checksum. The length and
+// checksum are ASCII hex, the length counts the command, data and checksum, the
+// checksum is the 16 bit byte sum of the length, command and data.
+#define PROTO_PACKET_PREFIX					"   #"
+#define PROTO_PACKET_LEN					4			//Offset of the length, after the prefix
+#define PROTO_PACKET_LEN_DIGITS				4
+#define PROTO_PACKET_CMD					8
+#define PROTO_PACKET_DATA					12
+#define PROTO_PACKET_SUM_DIGITS				4
+#define PROTO_PACKET_MIN_LEN				8			//Length of a packet without data
+#define PROTO_PACKET_MAX_LEN				15000
+#define PROTO_PACKET_NO_SUM					"XXXX"		//Checksum of a packet that is not checked
+
+// Decoded packet, the data stays in the input
+typedef struct protoPacket{
+	uint32_t mCmd;						//PROTO_CMD_*
+	const uint8_t* pData;
+	uint32_t mDataLen;
+	bool mSumSent;						//false for PROTO_PACKET_NO_SUM
+	bool mSumValid;						//Checksum matches, or was not sent
+}protoPacket_t;
+
+// Value of digits ASCII hex digits at p in *pValue, false on any other character
+static inline bool protoHex_Read(const uint8_t* p, const uint8_t digits, uint32_t* pValue)
+{
+	uint32_t value = 0;
+
+	for (uint8_t i = 0; i < digits; i++)
+	{
+		const uint8_t letter = p[i] | 0x20;
+		if (p[i] >= '0' && p[i] <= '9')
+		{
+			value = (value << 4) | (uint32_t)(p[i] - '0');
+		}
+		else if (letter >= 'a' && letter <= 'f')
+		{
+			value = (value << 4) | (uint32_t)(letter - 'a' + 10);
+		}
+		else
+		{
+			return false;
+		}
+	}
+	*pValue = value;
+	return true;
+}
+
+// value as digits upper case ASCII hex digits at p, without a NUL
+static inline void protoHex_Write(uint8_t* p, uint32_t value, const uint8_t digits)
+{
+	for (uint8_t i = digits; i > 0; i--)
+	{
+		p[i - 1] = (uint8_t)"0123456789ABCDEF"[value & 0x0F];
+		value >>= 4;
+	}
+}
+
+// Packet checksum of len bytes
+static inline uint16_t protoPacket_Sum(const uint8_t* p, const size_t len)
+{
+	uint16_t sum = 0;
+
+	for (size_t i = 0; i < len; i++)
+	{
+		sum += p[i];
+	}
+	return sum;
+}
+
+// Complete the packet around the dataLen bytes already at pPacket + PROTO_PACKET_DATA,
+// with the checksum or PROTO_PACKET_NO_SUM, and a NUL after it. Returns the packet length.
+static inline size_t protoPacket_Encode(uint8_t* pPacket, const uint32_t cmd, const size_t dataLen, const bool withSum)
+{
+	const size_t sumAt = PROTO_PACKET_DATA + dataLen;
+
+	memcpy(pPacket, PROTO_PACKET_PREFIX, PROTO_PACKET_LEN);
+	protoHex_Write(&pPacket[PROTO_PACKET_LEN], (uint32_t)(dataLen + PROTO_PACKET_MIN_LEN), PROTO_PACKET_LEN_DIGITS);
+	pPacket[PROTO_PACKET_CMD] = (uint8_t)(cmd >> 24);
+	pPacket[PROTO_PACKET_CMD + 1] = (uint8_t)(cmd >> 16);
+	pPacket[PROTO_PACKET_CMD + 2] = (uint8_t)(cmd >> 8);
+	pPacket[PROTO_PACKET_CMD + 3] = (uint8_t)cmd;
+	if (withSum)
+	{
+		protoHex_Write(&pPacket[sumAt], protoPacket_Sum(&pPacket[PROTO_PACKET_LEN], sumAt - PROTO_PACKET_LEN), PROTO_PACKET_SUM_DIGITS);
+	}
+	else
+	{
+		memcpy(&pPacket[sumAt], PROTO_PACKET_NO_SUM, PROTO_PACKET_SUM_DIGITS);
+	}
+	pPacket[sumAt + PROTO_PACKET_SUM_DIGITS] = 0;
+	return sumAt + PROTO_PACKET_SUM_DIGITS;
+}
+
+// Packet at the start of pIn, the data is left in place. Returns the packet length,
+// 0 if the len bytes are the start of a packet, -1 if pIn does not start one.
+static inline int32_t protoPacket_Decode(const uint8_t* pIn, const size_t len, protoPacket_t* pPacket)
+{
+	uint32_t packetLen;
+	uint32_t sum;
+
+	if (memcmp(pIn, PROTO_PACKET_PREFIX, (len < PROTO_PACKET_LEN) ? len : PROTO_PACKET_LEN) != 0)
+	{
+		return -1;
+	}
+	if (len < PROTO_PACKET_DATA)
+	{
+		return 0;
+	}
+	if (!protoHex_Read(&pIn[PROTO_PACKET_LEN], PROTO_PACKET_LEN_DIGITS, &packetLen) ||
+			packetLen < PROTO_PACKET_MIN_LEN || packetLen > PROTO_PACKET_MAX_LEN)
+	{
+		return -1;
+	}
+	packetLen += PROTO_PACKET_CMD;
+	if (len < packetLen)
+	{
+		return 0;
+	}
+
+	const uint8_t* pSum = &pIn[packetLen - PROTO_PACKET_SUM_DIGITS];
+	pPacket->mCmd = PROTO_CMD_CODE(&pIn[PROTO_PACKET_CMD]);
+	pPacket->pData = &pIn[PROTO_PACKET_DATA];
+	pPacket->mDataLen = packetLen - PROTO_PACKET_DATA - PROTO_PACKET_SUM_DIGITS;
+	pPacket->mSumSent = memcmp(pSum, PROTO_PACKET_NO_SUM, PROTO_PACKET_SUM_DIGITS) != 0;
+	pPacket->mSumValid = !pPacket->mSumSent || (protoHex_Read(pSum, PROTO_PACKET_SUM_DIGITS, &sum) &&
+			sum == protoPacket_Sum(&pIn[PROTO_PACKET_LEN], (size_t)(pSum - &pIn[PROTO_PACKET_LEN])));
+	return (int32_t)packetLen;
+}
+
+// Offset of the first packet prefix in pIn from from on, -1 if there is none
+static inline int32_t protoPacket_Find(const uint8_t* pIn, const size_t len, size_t from)
+{
+	for (; from + PROTO_PACKET_LEN <= len; from++)
+	{
+		if (memcmp(&pIn[from], PROTO_PACKET_PREFIX, PROTO_PACKET_LEN) == 0)
+		{
+			return (int32_t)from;
+		}
+	}
+	return -1;
+}
+
+// Little endian fields at any alignment
+static inline uint8_t protoGetU8(const uint8_t* p) { return p[0]; }
+static inline uint16_t protoGetU16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static inline uint32_t protoGetU32(const uint8_t* p) { return (uint32_t)protoGetU16(p) | ((uint32_t)protoGetU16(&p[2]) << 16); }
+static inline uint64_t protoGetU64(const uint8_t* p) { return (uint64_t)protoGetU32(p) | ((uint64_t)protoGetU32(&p[4]) << 32); }
+static inline void protoPutU8(uint8_t* p, const uint8_t value) { p[0] = value; }
+static inline void protoPutU16(uint8_t* p, const uint16_t value) { p[0] = (uint8_t)value; p[1] = (uint8_t)(value >> 8); }
+static inline void protoPutU32(uint8_t* p, const uint32_t value) { protoPutU16(p, (uint16_t)value); protoPutU16(&p[2], (uint16_t)(value >> 16)); }
+static inline void protoPutU64(uint8_t* p, const uint64_t value) { protoPutU32(p, (uint32_t)value); protoPutU32(&p[4], (uint32_t)(value >> 32)); }
+
+// Magic numbers, the 4 letters read as a little endian uint32_t
+#define PROTO_MAGIC_STREAM					0x52465853UL		//"SXFR"
+#define PROTO_MAGIC_UDP_CHUNK				0x43555853UL		//"SXUC"
+#define PROTO_MAGIC_UDP_HELLO				0x49485853UL		//"SXHI"
+#define PROTO_MAGIC_UDP_BYE					0x59425853UL		//"SXBY"
+
+// streamEncoding
+#define PROTO_STREAM_ENCODING_RAW16			0x00		//80x64 uint16 pixels as captured
+#define PROTO_STREAM_ENCODING_DELTA			0x01		//Zigzag varint residuals with zero runs
+#define PROTO_STREAM_ENCODING_DELTA_LZ		0x02		//Delta residuals, LZ compressed
+#define PROTO_STREAM_ENCODING_PACK12		0x03		//Image bit packed to 12 bits per pixel
+#define PROTO_STREAM_ENCODING_PACK14		0x04		//Image bit packed to 14 bits per pixel
+#define PROTO_STREAM_ENCODING_PACK8			0x05		//Image bit packed to 8 bits, lossy beyond a 255 count span
+#define PROTO_CHECK_STREAM_ENCODING(prefix) \
+	_Static_assert(prefix##RAW16 == PROTO_STREAM_ENCODING_RAW16, #prefix "RAW16 differs from protocolSchema.json"); \
+	_Static_assert(prefix##DELTA == PROTO_STREAM_ENCODING_DELTA, #prefix "DELTA differs from protocolSchema.json"); \
+	_Static_assert(prefix##DELTA_LZ == PROTO_STREAM_ENCODING_DELTA_LZ, #prefix "DELTA_LZ differs from protocolSchema.json"); \
+	_Static_assert(prefix##PACK12 == PROTO_STREAM_ENCODING_PACK12, #prefix "PACK12 differs from protocolSchema.json"); \
+	_Static_assert(prefix##PACK14 == PROTO_STREAM_ENCODING_PACK14, #prefix "PACK14 differs from protocolSchema.json"); \
+	_Static_assert(prefix##PACK8 == PROTO_STREAM_ENCODING_PACK8, #prefix "PACK8 differs from protocolSchema.json")
+
+// streamFlag
+#define PROTO_STREAM_FLAG_KEYFRAME			0x01		//Payload does not depend on the previous frame
+#define PROTO_STREAM_FLAG_STATS				0x02		//Header carries the frame statistics
+#define PROTO_STREAM_FLAG_CRC32				0x04		//payloadCrc holds the CRC32 of the payload
+#define PROTO_STREAM_FLAG_SHAPED			0x08		//Payload is the image window of shape
+#define PROTO_STREAM_FLAG_BLOBS				0x10		//Header ends with the used part of the blob record
+#define PROTO_STREAM_FLAG_UTC				0x20		//utcUs holds the capture time in UTC
+#define PROTO_CHECK_STREAM_FLAG(prefix) \
+	_Static_assert(prefix##KEYFRAME == PROTO_STREAM_FLAG_KEYFRAME, #prefix "KEYFRAME differs from protocolSchema.json"); \
+	_Static_assert(prefix##STATS == PROTO_STREAM_FLAG_STATS, #prefix "STATS differs from protocolSchema.json"); \
+	_Static_assert(prefix##CRC32 == PROTO_STREAM_FLAG_CRC32, #prefix "CRC32 differs from protocolSchema.json"); \
+	_Static_assert(prefix##SHAPED == PROTO_STREAM_FLAG_SHAPED, #prefix "SHAPED differs from protocolSchema.json"); \
+	_Static_assert(prefix##BLOBS == PROTO_STREAM_FLAG_BLOBS, #prefix "BLOBS differs from protocolSchema.json"); \
+	_Static_assert(prefix##UTC == PROTO_STREAM_FLAG_UTC, #prefix "UTC differs from protocolSchema.json")
+
+// frameStats, byte offset of each field
+#define PROTO_FRAME_STATS_MIN				0
+#define PROTO_FRAME_STATS_MAX				2
+#define PROTO_FRAME_STATS_MEAN				4
+#define PROTO_FRAME_STATS_P50				6
+#define PROTO_FRAME_STATS_P95				8
+#define PROTO_FRAME_STATS_P99				10
+#define PROTO_FRAME_STATS_BUCKET_LO			12
+#define PROTO_FRAME_STATS_BUCKET_SHIFT		14
+#define PROTO_FRAME_STATS_SCALE				15
+#define PROTO_FRAME_STATS_BUCKET			16
+#define PROTO_FRAME_STATS_SIZE				48
+#define PROTO_CHECK_FRAME_STATS(T) \
+	_Static_assert(offsetof(T, mMin) == PROTO_FRAME_STATS_MIN && sizeof(((T*)0)->mMin) == 2, #T ".mMin differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mMax) == PROTO_FRAME_STATS_MAX && sizeof(((T*)0)->mMax) == 2, #T ".mMax differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mMean) == PROTO_FRAME_STATS_MEAN && sizeof(((T*)0)->mMean) == 2, #T ".mMean differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mP50) == PROTO_FRAME_STATS_P50 && sizeof(((T*)0)->mP50) == 2, #T ".mP50 differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mP95) == PROTO_FRAME_STATS_P95 && sizeof(((T*)0)->mP95) == 2, #T ".mP95 differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mP99) == PROTO_FRAME_STATS_P99 && sizeof(((T*)0)->mP99) == 2, #T ".mP99 differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mBucketLo) == PROTO_FRAME_STATS_BUCKET_LO && sizeof(((T*)0)->mBucketLo) == 2, #T ".mBucketLo differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mBucketShift) == PROTO_FRAME_STATS_BUCKET_SHIFT && sizeof(((T*)0)->mBucketShift) == 1, #T ".mBucketShift differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mScale) == PROTO_FRAME_STATS_SCALE && sizeof(((T*)0)->mScale) == 1, #T ".mScale differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mBucket) == PROTO_FRAME_STATS_BUCKET && sizeof(((T*)0)->mBucket) == 32, #T ".mBucket differs from protocolSchema.json"); \
+	_Static_assert(sizeof(T) == PROTO_FRAME_STATS_SIZE, #T " size differs from protocolSchema.json")
+static inline uint16_t protoFrameStats_GetMin(const uint8_t* p) { return protoGetU16(&p[PROTO_FRAME_STATS_MIN]); }
+static inline void protoFrameStats_SetMin(uint8_t* p, const uint16_t value) { protoPutU16(&p[PROTO_FRAME_STATS_MIN], value); }
+static inline uint16_t protoFrameStats_GetMax(const uint8_t* p) { return protoGetU16(&p[PROTO_FRAME_STATS_MAX]); }
+static inline void protoFrameStats_SetMax(uint8_t* p, const uint16_t value) { protoPutU16(&p[PROTO_FRAME_STATS_MAX], value); }
+static inline uint16_t protoFrameStats_GetMean(const uint8_t* p) { return protoGetU16(&p[PROTO_FRAME_STATS_MEAN]); }
+static inline void protoFrameStats_SetMean(uint8_t* p, const uint16_t value) { protoPutU16(&p[PROTO_FRAME_STATS_MEAN], value); }
+static inline uint16_t protoFrameStats_GetP50(const uint8_t* p) { return protoGetU16(&p[PROTO_FRAME_STATS_P50]); }
+static inline void protoFrameStats_SetP50(uint8_t* p, const uint16_t value) { protoPutU16(&p[PROTO_FRAME_STATS_P50], value); }
+static inline uint16_t protoFrameStats_GetP95(const uint8_t* p) { return protoGetU16(&p[PROTO_FRAME_STATS_P95]); }
+static inline void protoFrameStats_SetP95(uint8_t* p, const uint16_t value) { protoPutU16(&p[PROTO_FRAME_STATS_P95], value); }
+static inline uint16_t protoFrameStats_GetP99(const uint8_t* p) { return protoGetU16(&p[PROTO_FRAME_STATS_P99]); }
+static inline void protoFrameStats_SetP99(uint8_t* p, const uint16_t value) { protoPutU16(&p[PROTO_FRAME_STATS_P99], value); }
+static inline uint16_t protoFrameStats_GetBucketLo(const uint8_t* p) { return protoGetU16(&p[PROTO_FRAME_STATS_BUCKET_LO]); }
+static inline void protoFrameStats_SetBucketLo(uint8_t* p, const uint16_t value) { protoPutU16(&p[PROTO_FRAME_STATS_BUCKET_LO], value); }
+static inline uint8_t protoFrameStats_GetBucketShift(const uint8_t* p) { return protoGetU8(&p[PROTO_FRAME_STATS_BUCKET_SHIFT]); }
+static inline void protoFrameStats_SetBucketShift(uint8_t* p, const uint8_t value) { protoPutU8(&p[PROTO_FRAME_STATS_BUCKET_SHIFT], value); }
+static inline uint8_t protoFrameStats_GetScale(const uint8_t* p) { return protoGetU8(&p[PROTO_FRAME_STATS_SCALE]); }
+static inline void protoFrameStats_SetScale(uint8_t* p, const uint8_t value) { protoPutU8(&p[PROTO_FRAME_STATS_SCALE], value); }
+static inline uint16_t protoFrameStats_GetBucket(const uint8_t* p, const uint32_t i) { return protoGetU16(&p[PROTO_FRAME_STATS_BUCKET + i * 2]); }
+static inline void protoFrameStats_SetBucket(uint8_t* p, const uint32_t i, const uint16_t value) { protoPutU16(&p[PROTO_FRAME_STATS_BUCKET + i * 2], value); }
+#define PROTO_FIELDS_FRAME_STATS(SCALAR, ARRAY) \
+	SCALAR(protoFrameStats_GetMin, protoFrameStats_SetMin, uint16_t) \
+	SCALAR(protoFrameStats_GetMax, protoFrameStats_SetMax, uint16_t) \
+	SCALAR(protoFrameStats_GetMean, protoFrameStats_SetMean, uint16_t) \
+	SCALAR(protoFrameStats_GetP50, protoFrameStats_SetP50, uint16_t) \
+	SCALAR(protoFrameStats_GetP95, protoFrameStats_SetP95, uint16_t) \
+	SCALAR(protoFrameStats_GetP99, protoFrameStats_SetP99, uint16_t) \
+	SCALAR(protoFrameStats_GetBucketLo, protoFrameStats_SetBucketLo, uint16_t) \
+	SCALAR(protoFrameStats_GetBucketShift, protoFrameStats_SetBucketShift, uint8_t) \
+	SCALAR(protoFrameStats_GetScale, protoFrameStats_SetScale, uint8_t) \
+	ARRAY(protoFrameStats_GetBucket, protoFrameStats_SetBucket, uint16_t, 16)
+
+// streamShape, byte offset of each field
+#define PROTO_STREAM_SHAPE_X				0
+#define PROTO_STREAM_SHAPE_Y				1
+#define PROTO_STREAM_SHAPE_WIDTH			2
+#define PROTO_STREAM_SHAPE_HEIGHT			3
+#define PROTO_STREAM_SHAPE_DECIMATION		4
+#define PROTO_STREAM_SHAPE_RATE_DIV			5
+#define PROTO_STREAM_SHAPE_OUT_WIDTH		6
+#define PROTO_STREAM_SHAPE_OUT_HEIGHT		7
+#define PROTO_STREAM_SHAPE_SIZE				8
+#define PROTO_CHECK_STREAM_SHAPE(T) \
+	_Static_assert(offsetof(T, mX) == PROTO_STREAM_SHAPE_X && sizeof(((T*)0)->mX) == 1, #T ".mX differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mY) == PROTO_STREAM_SHAPE_Y && sizeof(((T*)0)->mY) == 1, #T ".mY differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mWidth) == PROTO_STREAM_SHAPE_WIDTH && sizeof(((T*)0)->mWidth) == 1, #T ".mWidth differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mHeight) == PROTO_STREAM_SHAPE_HEIGHT && sizeof(((T*)0)->mHeight) == 1, #T ".mHeight differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mDecimation) == PROTO_STREAM_SHAPE_DECIMATION && sizeof(((T*)0)->mDecimation) == 1, #T ".mDecimation differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mRateDiv) == PROTO_STREAM_SHAPE_RATE_DIV && sizeof(((T*)0)->mRateDiv) == 1, #T ".mRateDiv differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mOutWidth) == PROTO_STREAM_SHAPE_OUT_WIDTH && sizeof(((T*)0)->mOutWidth) == 1, #T ".mOutWidth differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mOutHeight) == PROTO_STREAM_SHAPE_OUT_HEIGHT && sizeof(((T*)0)->mOutHeight) == 1, #T ".mOutHeight differs from protocolSchema.json"); \
+	_Static_assert(sizeof(T) == PROTO_STREAM_SHAPE_SIZE, #T " size differs from protocolSchema.json")
+static inline uint8_t protoStreamShape_GetX(const uint8_t* p) { return protoGetU8(&p[PROTO_STREAM_SHAPE_X]); }
+static inline void protoStreamShape_SetX(uint8_t* p, const uint8_t value) { protoPutU8(&p[PROTO_STREAM_SHAPE_X], value); }
+static inline uint8_t protoStreamShape_GetY(const uint8_t* p) { return protoGetU8(&p[PROTO_STREAM_SHAPE_Y]); }
+static inline void protoStreamShape_SetY(uint8_t* p, const uint8_t value) { protoPutU8(&p[PROTO_STREAM_SHAPE_Y], value); }
+static inline uint8_t protoStreamShape_GetWidth(const uint8_t* p) { return protoGetU8(&p[PROTO_STREAM_SHAPE_WIDTH]); }
+static inline void protoStreamShape_SetWidth(uint8_t* p, const uint8_t value) { protoPutU8(&p[PROTO_STREAM_SHAPE_WIDTH], value); }
+static inline uint8_t protoStreamShape_GetHeight(const uint8_t* p) { return protoGetU8(&p[PROTO_STREAM_SHAPE_HEIGHT]); }
+static inline void protoStreamShape_SetHeight(uint8_t* p, const uint8_t value) { protoPutU8(&p[PROTO_STREAM_SHAPE_HEIGHT], value); }
+static inline uint8_t protoStreamShape_GetDecimation(const uint8_t* p) { return protoGetU8(&p[PROTO_STREAM_SHAPE_DECIMATION]); }
+static inline void protoStreamShape_SetDecimation(uint8_t* p, const uint8_t value) { protoPutU8(&p[PROTO_STREAM_SHAPE_DECIMATION], value); }
+static inline uint8_t protoStreamShape_GetRateDiv(const uint8_t* p) { return protoGetU8(&p[PROTO_STREAM_SHAPE_RATE_DIV]); }
+static inline void protoStreamShape_SetRateDiv(uint8_t* p, const uint8_t value) { protoPutU8(&p[PROTO_STREAM_SHAPE_RATE_DIV], value); }
+static inline uint8_t protoStreamShape_GetOutWidth(const uint8_t* p) { return protoGetU8(&p[PROTO_STREAM_SHAPE_OUT_WIDTH]); }
+static inline void protoStreamShape_SetOutWidth(uint8_t* p, const uint8_t value) { protoPutU8(&p[PROTO_STREAM_SHAPE_OUT_WIDTH], value); }
+static inline uint8_t protoStreamShape_GetOutHeight(const uint8_t* p) { return protoGetU8(&p[PROTO_STREAM_SHAPE_OUT_HEIGHT]); }
+static inline void protoStreamShape_SetOutHeight(uint8_t* p, const uint8_t value) { protoPutU8(&p[PROTO_STREAM_SHAPE_OUT_HEIGHT], value); }
+#define PROTO_FIELDS_STREAM_SHAPE(SCALAR, ARRAY) \
+	SCALAR(protoStreamShape_GetX, protoStreamShape_SetX, uint8_t) \
+	SCALAR(protoStreamShape_GetY, protoStreamShape_SetY, uint8_t) \
+	SCALAR(protoStreamShape_GetWidth, protoStreamShape_SetWidth, uint8_t) \
+	SCALAR(protoStreamShape_GetHeight, protoStreamShape_SetHeight, uint8_t) \
+	SCALAR(protoStreamShape_GetDecimation, protoStreamShape_SetDecimation, uint8_t) \
+	SCALAR(protoStreamShape_GetRateDiv, protoStreamShape_SetRateDiv, uint8_t) \
+	SCALAR(protoStreamShape_GetOutWidth, protoStreamShape_SetOutWidth, uint8_t) \
+	SCALAR(protoStreamShape_GetOutHeight, protoStreamShape_SetOutHeight, uint8_t)
+
+// blobEntry, byte offset of each field
+#define PROTO_BLOB_ENTRY_ID					0
+#define PROTO_BLOB_ENTRY_FLAGS				1
+#define PROTO_BLOB_ENTRY_AREA				2
+#define PROTO_BLOB_ENTRY_PEAK				4
+#define PROTO_BLOB_ENTRY_PEAK_X				6
+#define PROTO_BLOB_ENTRY_PEAK_Y				7
+#define PROTO_BLOB_ENTRY_CX					8
+#define PROTO_BLOB_ENTRY_CY					10
+#define PROTO_BLOB_ENTRY_SIZE				12
+#define PROTO_CHECK_BLOB_ENTRY(T) \
+	_Static_assert(offsetof(T, mId) == PROTO_BLOB_ENTRY_ID && sizeof(((T*)0)->mId) == 1, #T ".mId differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mFlags) == PROTO_BLOB_ENTRY_FLAGS && sizeof(((T*)0)->mFlags) == 1, #T ".mFlags differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mArea) == PROTO_BLOB_ENTRY_AREA && sizeof(((T*)0)->mArea) == 2, #T ".mArea differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mPeak) == PROTO_BLOB_ENTRY_PEAK && sizeof(((T*)0)->mPeak) == 2, #T ".mPeak differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mPeakX) == PROTO_BLOB_ENTRY_PEAK_X && sizeof(((T*)0)->mPeakX) == 1, #T ".mPeakX differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mPeakY) == PROTO_BLOB_ENTRY_PEAK_Y && sizeof(((T*)0)->mPeakY) == 1, #T ".mPeakY differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mCx) == PROTO_BLOB_ENTRY_CX && sizeof(((T*)0)->mCx) == 2, #T ".mCx differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mCy) == PROTO_BLOB_ENTRY_CY && sizeof(((T*)0)->mCy) == 2, #T ".mCy differs from protocolSchema.json"); \
+	_Static_assert(sizeof(T) == PROTO_BLOB_ENTRY_SIZE, #T " size differs from protocolSchema.json")
+static inline uint8_t protoBlobEntry_GetId(const uint8_t* p) { return protoGetU8(&p[PROTO_BLOB_ENTRY_ID]); }
+static inline void protoBlobEntry_SetId(uint8_t* p, const uint8_t value) { protoPutU8(&p[PROTO_BLOB_ENTRY_ID], value); }
+static inline uint8_t protoBlobEntry_GetFlags(const uint8_t* p) { return protoGetU8(&p[PROTO_BLOB_ENTRY_FLAGS]); }
+static inline void protoBlobEntry_SetFlags(uint8_t* p, const uint8_t value) { protoPutU8(&p[PROTO_BLOB_ENTRY_FLAGS], value); }
+static inline uint16_t protoBlobEntry_GetArea(const uint8_t* p) { return protoGetU16(&p[PROTO_BLOB_ENTRY_AREA]); }
+static inline void protoBlobEntry_SetArea(uint8_t* p, const uint16_t value) { protoPutU16(&p[PROTO_BLOB_ENTRY_AREA], value); }
+static inline uint16_t protoBlobEntry_GetPeak(const uint8_t* p) { return protoGetU16(&p[PROTO_BLOB_ENTRY_PEAK]); }
+static inline void protoBlobEntry_SetPeak(uint8_t* p, const uint16_t value) { protoPutU16(&p[PROTO_BLOB_ENTRY_PEAK], value); }
+static inline uint8_t protoBlobEntry_GetPeakX(const uint8_t* p) { return protoGetU8(&p[PROTO_BLOB_ENTRY_PEAK_X]); }
+static inline void protoBlobEntry_SetPeakX(uint8_t* p, const uint8_t value) { protoPutU8(&p[PROTO_BLOB_ENTRY_PEAK_X], value); }
+static inline uint8_t protoBlobEntry_GetPeakY(const uint8_t* p) { return protoGetU8(&p[PROTO_BLOB_ENTRY_PEAK_Y]); }
+static inline void protoBlobEntry_SetPeakY(uint8_t* p, const uint8_t value) { protoPutU8(&p[PROTO_BLOB_ENTRY_PEAK_Y], value); }
+static inline uint16_t protoBlobEntry_GetCx(const uint8_t* p) { return protoGetU16(&p[PROTO_BLOB_ENTRY_CX]); }
+static inline void protoBlobEntry_SetCx(uint8_t* p, const uint16_t value) { protoPutU16(&p[PROTO_BLOB_ENTRY_CX], value); }
+static inline uint16_t protoBlobEntry_GetCy(const uint8_t* p) { return protoGetU16(&p[PROTO_BLOB_ENTRY_CY]); }
+static inline void protoBlobEntry_SetCy(uint8_t* p, const uint16_t value) { protoPutU16(&p[PROTO_BLOB_ENTRY_CY], value); }
+#define PROTO_FIELDS_BLOB_ENTRY(SCALAR, ARRAY) \
+	SCALAR(protoBlobEntry_GetId, protoBlobEntry_SetId, uint8_t) \
+	SCALAR(protoBlobEntry_GetFlags, protoBlobEntry_SetFlags, uint8_t) \
+	SCALAR(protoBlobEntry_GetArea, protoBlobEntry_SetArea, uint16_t) \
+	SCALAR(protoBlobEntry_GetPeak, protoBlobEntry_SetPeak, uint16_t) \
+	SCALAR(protoBlobEntry_GetPeakX, protoBlobEntry_SetPeakX, uint8_t) \
+	SCALAR(protoBlobEntry_GetPeakY, protoBlobEntry_SetPeakY, uint8_t) \
+	SCALAR(protoBlobEntry_GetCx, protoBlobEntry_SetCx, uint16_t) \
+	SCALAR(protoBlobEntry_GetCy, protoBlobEntry_SetCy, uint16_t)
+
+// blobRecord, byte offset of each field
+#define PROTO_BLOB_RECORD_SEQ				0
+#define PROTO_BLOB_RECORD_COUNT				4
+#define PROTO_BLOB_RECORD_FLAGS				5
+#define PROTO_BLOB_RECORD_BLOBS				6
+#define PROTO_BLOB_RECORD_SIZE				6				//Without the variable part
+#define PROTO_CHECK_BLOB_RECORD(T) \
+	_Static_assert(offsetof(T, mSeq) == PROTO_BLOB_RECORD_SEQ && sizeof(((T*)0)->mSeq) == 4, #T ".mSeq differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mCount) == PROTO_BLOB_RECORD_COUNT && sizeof(((T*)0)->mCount) == 1, #T ".mCount differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mFlags) == PROTO_BLOB_RECORD_FLAGS && sizeof(((T*)0)->mFlags) == 1, #T ".mFlags differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mBlob) == PROTO_BLOB_RECORD_BLOBS, #T ".mBlob differs from protocolSchema.json")
+static inline uint32_t protoBlobRecord_GetSeq(const uint8_t* p) { return protoGetU32(&p[PROTO_BLOB_RECORD_SEQ]); }
+static inline void protoBlobRecord_SetSeq(uint8_t* p, const uint32_t value) { protoPutU32(&p[PROTO_BLOB_RECORD_SEQ], value); }
+static inline uint8_t protoBlobRecord_GetCount(const uint8_t* p) { return protoGetU8(&p[PROTO_BLOB_RECORD_COUNT]); }
+static inline void protoBlobRecord_SetCount(uint8_t* p, const uint8_t value) { protoPutU8(&p[PROTO_BLOB_RECORD_COUNT], value); }
+static inline uint8_t protoBlobRecord_GetFlags(const uint8_t* p) { return protoGetU8(&p[PROTO_BLOB_RECORD_FLAGS]); }
+static inline void protoBlobRecord_SetFlags(uint8_t* p, const uint8_t value) { protoPutU8(&p[PROTO_BLOB_RECORD_FLAGS], value); }
+#define PROTO_FIELDS_BLOB_RECORD(SCALAR, ARRAY) \
+	SCALAR(protoBlobRecord_GetSeq, protoBlobRecord_SetSeq, uint32_t) \
+	SCALAR(protoBlobRecord_GetCount, protoBlobRecord_SetCount, uint8_t) \
+	SCALAR(protoBlobRecord_GetFlags, protoBlobRecord_SetFlags, uint8_t)
+
+// streamHeader, byte offset of each field
+#define PROTO_STREAM_HEADER_MAGIC			0
+#define PROTO_STREAM_HEADER_VERSION			4
+#define PROTO_STREAM_HEADER_ENCODING		5
+#define PROTO_STREAM_HEADER_HEADER_LEN		6
+#define PROTO_STREAM_HEADER_SEQ				8
+#define PROTO_STREAM_HEADER_TIMESTAMP_US	12
+#define PROTO_STREAM_HEADER_PAYLOAD_LEN		20
+#define PROTO_STREAM_HEADER_FLAGS			24
+#define PROTO_STREAM_HEADER_RESERVED		25
+#define PROTO_STREAM_HEADER_STATS			28
+#define PROTO_STREAM_HEADER_PAYLOAD_CRC		76
+#define PROTO_STREAM_HEADER_SHAPE			80
+#define PROTO_STREAM_HEADER_UTC_US			88
+#define PROTO_STREAM_HEADER_BLOBS			96
+#define PROTO_STREAM_HEADER_SIZE			96				//Without the variable part
+#define PROTO_CHECK_STREAM_HEADER(T) \
+	_Static_assert(offsetof(T, mMagic) == PROTO_STREAM_HEADER_MAGIC && sizeof(((T*)0)->mMagic) == 4, #T ".mMagic differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mVersion) == PROTO_STREAM_HEADER_VERSION && sizeof(((T*)0)->mVersion) == 1, #T ".mVersion differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mEncoding) == PROTO_STREAM_HEADER_ENCODING && sizeof(((T*)0)->mEncoding) == 1, #T ".mEncoding differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mHeaderLen) == PROTO_STREAM_HEADER_HEADER_LEN && sizeof(((T*)0)->mHeaderLen) == 2, #T ".mHeaderLen differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mSeq) == PROTO_STREAM_HEADER_SEQ && sizeof(((T*)0)->mSeq) == 4, #T ".mSeq differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mTimestampUs) == PROTO_STREAM_HEADER_TIMESTAMP_US && sizeof(((T*)0)->mTimestampUs) == 8, #T ".mTimestampUs differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mPayloadLen) == PROTO_STREAM_HEADER_PAYLOAD_LEN && sizeof(((T*)0)->mPayloadLen) == 4, #T ".mPayloadLen differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mFlags) == PROTO_STREAM_HEADER_FLAGS && sizeof(((T*)0)->mFlags) == 1, #T ".mFlags differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mReserved) == PROTO_STREAM_HEADER_RESERVED && sizeof(((T*)0)->mReserved) == 3, #T ".mReserved differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mStats) == PROTO_STREAM_HEADER_STATS && sizeof(((T*)0)->mStats) == 48, #T ".mStats differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mPayloadCrc) == PROTO_STREAM_HEADER_PAYLOAD_CRC && sizeof(((T*)0)->mPayloadCrc) == 4, #T ".mPayloadCrc differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mShape) == PROTO_STREAM_HEADER_SHAPE && sizeof(((T*)0)->mShape) == 8, #T ".mShape differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mUtcUs) == PROTO_STREAM_HEADER_UTC_US && sizeof(((T*)0)->mUtcUs) == 8, #T ".mUtcUs differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mBlobs) == PROTO_STREAM_HEADER_BLOBS, #T ".mBlobs differs from protocolSchema.json")
+static inline uint32_t protoStreamHeader_GetMagic(const uint8_t* p) { return protoGetU32(&p[PROTO_STREAM_HEADER_MAGIC]); }
+static inline void protoStreamHeader_SetMagic(uint8_t* p, const uint32_t value) { protoPutU32(&p[PROTO_STREAM_HEADER_MAGIC], value); }
+static inline uint8_t protoStreamHeader_GetVersion(const uint8_t* p) { return protoGetU8(&p[PROTO_STREAM_HEADER_VERSION]); }
+static inline void protoStreamHeader_SetVersion(uint8_t* p, const uint8_t value) { protoPutU8(&p[PROTO_STREAM_HEADER_VERSION], value); }
+static inline uint8_t protoStreamHeader_GetEncoding(const uint8_t* p) { return protoGetU8(&p[PROTO_STREAM_HEADER_ENCODING]); }
+static inline void protoStreamHeader_SetEncoding(uint8_t* p, const uint8_t value) { protoPutU8(&p[PROTO_STREAM_HEADER_ENCODING], value); }
+static inline uint16_t protoStreamHeader_GetHeaderLen(const uint8_t* p) { return protoGetU16(&p[PROTO_STREAM_HEADER_HEADER_LEN]); }
+static inline void protoStreamHeader_SetHeaderLen(uint8_t* p, const uint16_t value) { protoPutU16(&p[PROTO_STREAM_HEADER_HEADER_LEN], value); }
+static inline uint32_t protoStreamHeader_GetSeq(const uint8_t* p) { return protoGetU32(&p[PROTO_STREAM_HEADER_SEQ]); }
+static inline void protoStreamHeader_SetSeq(uint8_t* p, const uint32_t value) { protoPutU32(&p[PROTO_STREAM_HEADER_SEQ], value); }
+static inline uint64_t protoStreamHeader_GetTimestampUs(const uint8_t* p) { return protoGetU64(&p[PROTO_STREAM_HEADER_TIMESTAMP_US]); }
+static inline void protoStreamHeader_SetTimestampUs(uint8_t* p, const uint64_t value) { protoPutU64(&p[PROTO_STREAM_HEADER_TIMESTAMP_US], value); }
+static inline uint32_t protoStreamHeader_GetPayloadLen(const uint8_t* p) { return protoGetU32(&p[PROTO_STREAM_HEADER_PAYLOAD_LEN]); }
+static inline void protoStreamHeader_SetPayloadLen(uint8_t* p, const uint32_t value) { protoPutU32(&p[PROTO_STREAM_HEADER_PAYLOAD_LEN], value); }
+static inline uint8_t protoStreamHeader_GetFlags(const uint8_t* p) { return protoGetU8(&p[PROTO_STREAM_HEADER_FLAGS]); }
+static inline void protoStreamHeader_SetFlags(uint8_t* p, const uint8_t value) { protoPutU8(&p[PROTO_STREAM_HEADER_FLAGS], value); }
+static inline uint8_t protoStreamHeader_GetReserved(const uint8_t* p, const uint32_t i) { return protoGetU8(&p[PROTO_STREAM_HEADER_RESERVED + i * 1]); }
+static inline void protoStreamHeader_SetReserved(uint8_t* p, const uint32_t i, const uint8_t value) { protoPutU8(&p[PROTO_STREAM_HEADER_RESERVED + i * 1], value); }
+static inline uint32_t protoStreamHeader_GetPayloadCrc(const uint8_t* p) { return protoGetU32(&p[PROTO_STREAM_HEADER_PAYLOAD_CRC]); }
+static inline void protoStreamHeader_SetPayloadCrc(uint8_t* p, const uint32_t value) { protoPutU32(&p[PROTO_STREAM_HEADER_PAYLOAD_CRC], value); }
+static inline uint64_t protoStreamHeader_GetUtcUs(const uint8_t* p) { return protoGetU64(&p[PROTO_STREAM_HEADER_UTC_US]); }
+static inline void protoStreamHeader_SetUtcUs(uint8_t* p, const uint64_t value) { protoPutU64(&p[PROTO_STREAM_HEADER_UTC_US], value); }
+#define PROTO_FIELDS_STREAM_HEADER(SCALAR, ARRAY) \
+	SCALAR(protoStreamHeader_GetMagic, protoStreamHeader_SetMagic, uint32_t) \
+	SCALAR(protoStreamHeader_GetVersion, protoStreamHeader_SetVersion, uint8_t) \
+	SCALAR(protoStreamHeader_GetEncoding, protoStreamHeader_SetEncoding, uint8_t) \
+	SCALAR(protoStreamHeader_GetHeaderLen, protoStreamHeader_SetHeaderLen, uint16_t) \
+	SCALAR(protoStreamHeader_GetSeq, protoStreamHeader_SetSeq, uint32_t) \
+	SCALAR(protoStreamHeader_GetTimestampUs, protoStreamHeader_SetTimestampUs, uint64_t) \
+	SCALAR(protoStreamHeader_GetPayloadLen, protoStreamHeader_SetPayloadLen, uint32_t) \
+	SCALAR(protoStreamHeader_GetFlags, protoStreamHeader_SetFlags, uint8_t) \
+	ARRAY(protoStreamHeader_GetReserved, protoStreamHeader_SetReserved, uint8_t, 3) \
+	SCALAR(protoStreamHeader_GetPayloadCrc, protoStreamHeader_SetPayloadCrc, uint32_t) \
+	SCALAR(protoStreamHeader_GetUtcUs, protoStreamHeader_SetUtcUs, uint64_t)
+
+// udpChunkHeader, byte offset of each field
+#define PROTO_UDP_CHUNK_HEADER_MAGIC		0
+#define PROTO_UDP_CHUNK_HEADER_FRAME_ID		4
+#define PROTO_UDP_CHUNK_HEADER_CHUNK_IDX	8
+#define PROTO_UDP_CHUNK_HEADER_CHUNK_COUNT	10
+#define PROTO_UDP_CHUNK_HEADER_FRAME_LEN	12
+#define PROTO_UDP_CHUNK_HEADER_SIZE			16
+#define PROTO_CHECK_UDP_CHUNK_HEADER(T) \
+	_Static_assert(offsetof(T, mMagic) == PROTO_UDP_CHUNK_HEADER_MAGIC && sizeof(((T*)0)->mMagic) == 4, #T ".mMagic differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mFrameId) == PROTO_UDP_CHUNK_HEADER_FRAME_ID && sizeof(((T*)0)->mFrameId) == 4, #T ".mFrameId differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mChunkIdx) == PROTO_UDP_CHUNK_HEADER_CHUNK_IDX && sizeof(((T*)0)->mChunkIdx) == 2, #T ".mChunkIdx differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mChunkCount) == PROTO_UDP_CHUNK_HEADER_CHUNK_COUNT && sizeof(((T*)0)->mChunkCount) == 2, #T ".mChunkCount differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mFrameLen) == PROTO_UDP_CHUNK_HEADER_FRAME_LEN && sizeof(((T*)0)->mFrameLen) == 4, #T ".mFrameLen differs from protocolSchema.json"); \
+	_Static_assert(sizeof(T) == PROTO_UDP_CHUNK_HEADER_SIZE, #T " size differs from protocolSchema.json")
+static inline uint32_t protoUdpChunkHeader_GetMagic(const uint8_t* p) { return protoGetU32(&p[PROTO_UDP_CHUNK_HEADER_MAGIC]); }
+static inline void protoUdpChunkHeader_SetMagic(uint8_t* p, const uint32_t value) { protoPutU32(&p[PROTO_UDP_CHUNK_HEADER_MAGIC], value); }
+static inline uint32_t protoUdpChunkHeader_GetFrameId(const uint8_t* p) { return protoGetU32(&p[PROTO_UDP_CHUNK_HEADER_FRAME_ID]); }
+static inline void protoUdpChunkHeader_SetFrameId(uint8_t* p, const uint32_t value) { protoPutU32(&p[PROTO_UDP_CHUNK_HEADER_FRAME_ID], value); }
+static inline uint16_t protoUdpChunkHeader_GetChunkIdx(const uint8_t* p) { return protoGetU16(&p[PROTO_UDP_CHUNK_HEADER_CHUNK_IDX]); }
+static inline void protoUdpChunkHeader_SetChunkIdx(uint8_t* p, const uint16_t value) { protoPutU16(&p[PROTO_UDP_CHUNK_HEADER_CHUNK_IDX], value); }
+static inline uint16_t protoUdpChunkHeader_GetChunkCount(const uint8_t* p) { return protoGetU16(&p[PROTO_UDP_CHUNK_HEADER_CHUNK_COUNT]); }
+static inline void protoUdpChunkHeader_SetChunkCount(uint8_t* p, const uint16_t value) { protoPutU16(&p[PROTO_UDP_CHUNK_HEADER_CHUNK_COUNT], value); }
+static inline uint32_t protoUdpChunkHeader_GetFrameLen(const uint8_t* p) { return protoGetU32(&p[PROTO_UDP_CHUNK_HEADER_FRAME_LEN]); }
+static inline void protoUdpChunkHeader_SetFrameLen(uint8_t* p, const uint32_t value) { protoPutU32(&p[PROTO_UDP_CHUNK_HEADER_FRAME_LEN], value); }
+#define PROTO_FIELDS_UDP_CHUNK_HEADER(SCALAR, ARRAY) \
+	SCALAR(protoUdpChunkHeader_GetMagic, protoUdpChunkHeader_SetMagic, uint32_t) \
+	SCALAR(protoUdpChunkHeader_GetFrameId, protoUdpChunkHeader_SetFrameId, uint32_t) \
+	SCALAR(protoUdpChunkHeader_GetChunkIdx, protoUdpChunkHeader_SetChunkIdx, uint16_t) \
+	SCALAR(protoUdpChunkHeader_GetChunkCount, protoUdpChunkHeader_SetChunkCount, uint16_t) \
+	SCALAR(protoUdpChunkHeader_GetFrameLen, protoUdpChunkHeader_SetFrameLen, uint32_t)
+
+// mqttBatchHeader, byte offset of each field
+#define PROTO_MQTT_BATCH_HEADER_VERSION		0
+#define PROTO_MQTT_BATCH_HEADER_SAMPLES		1
+#define PROTO_MQTT_BATCH_HEADER_PERIOD_MS	2
+#define PROTO_MQTT_BATCH_HEADER_UPTIME_MS	4
+#define PROTO_MQTT_BATCH_HEADER_SEQ			8
+#define PROTO_MQTT_BATCH_HEADER_UTC_MS		12
+#define PROTO_MQTT_BATCH_HEADER_SIZE		20
+#define PROTO_CHECK_MQTT_BATCH_HEADER(T) \
+	_Static_assert(offsetof(T, mVersion) == PROTO_MQTT_BATCH_HEADER_VERSION && sizeof(((T*)0)->mVersion) == 1, #T ".mVersion differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mSamples) == PROTO_MQTT_BATCH_HEADER_SAMPLES && sizeof(((T*)0)->mSamples) == 1, #T ".mSamples differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mPeriodMs) == PROTO_MQTT_BATCH_HEADER_PERIOD_MS && sizeof(((T*)0)->mPeriodMs) == 2, #T ".mPeriodMs differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mUptimeMs) == PROTO_MQTT_BATCH_HEADER_UPTIME_MS && sizeof(((T*)0)->mUptimeMs) == 4, #T ".mUptimeMs differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mSeq) == PROTO_MQTT_BATCH_HEADER_SEQ && sizeof(((T*)0)->mSeq) == 4, #T ".mSeq differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mUtcMs) == PROTO_MQTT_BATCH_HEADER_UTC_MS && sizeof(((T*)0)->mUtcMs) == 8, #T ".mUtcMs differs from protocolSchema.json"); \
+	_Static_assert(sizeof(T) == PROTO_MQTT_BATCH_HEADER_SIZE, #T " size differs from protocolSchema.json")
+static inline uint8_t protoMqttBatchHeader_GetVersion(const uint8_t* p) { return protoGetU8(&p[PROTO_MQTT_BATCH_HEADER_VERSION]); }
+static inline void protoMqttBatchHeader_SetVersion(uint8_t* p, const uint8_t value) { protoPutU8(&p[PROTO_MQTT_BATCH_HEADER_VERSION], value); }
+static inline uint8_t protoMqttBatchHeader_GetSamples(const uint8_t* p) { return protoGetU8(&p[PROTO_MQTT_BATCH_HEADER_SAMPLES]); }
+static inline void protoMqttBatchHeader_SetSamples(uint8_t* p, const uint8_t value) { protoPutU8(&p[PROTO_MQTT_BATCH_HEADER_SAMPLES], value); }
+static inline uint16_t protoMqttBatchHeader_GetPeriodMs(const uint8_t* p) { return protoGetU16(&p[PROTO_MQTT_BATCH_HEADER_PERIOD_MS]); }
+static inline void protoMqttBatchHeader_SetPeriodMs(uint8_t* p, const uint16_t value) { protoPutU16(&p[PROTO_MQTT_BATCH_HEADER_PERIOD_MS], value); }
+static inline uint32_t protoMqttBatchHeader_GetUptimeMs(const uint8_t* p) { return protoGetU32(&p[PROTO_MQTT_BATCH_HEADER_UPTIME_MS]); }
+static inline void protoMqttBatchHeader_SetUptimeMs(uint8_t* p, const uint32_t value) { protoPutU32(&p[PROTO_MQTT_BATCH_HEADER_UPTIME_MS], value); }
+static inline uint32_t protoMqttBatchHeader_GetSeq(const uint8_t* p) { return protoGetU32(&p[PROTO_MQTT_BATCH_HEADER_SEQ]); }
+static inline void protoMqttBatchHeader_SetSeq(uint8_t* p, const uint32_t value) { protoPutU32(&p[PROTO_MQTT_BATCH_HEADER_SEQ], value); }
+static inline uint64_t protoMqttBatchHeader_GetUtcMs(const uint8_t* p) { return protoGetU64(&p[PROTO_MQTT_BATCH_HEADER_UTC_MS]); }
+static inline void protoMqttBatchHeader_SetUtcMs(uint8_t* p, const uint64_t value) { protoPutU64(&p[PROTO_MQTT_BATCH_HEADER_UTC_MS], value); }
+#define PROTO_FIELDS_MQTT_BATCH_HEADER(SCALAR, ARRAY) \
+	SCALAR(protoMqttBatchHeader_GetVersion, protoMqttBatchHeader_SetVersion, uint8_t) \
+	SCALAR(protoMqttBatchHeader_GetSamples, protoMqttBatchHeader_SetSamples, uint8_t) \
+	SCALAR(protoMqttBatchHeader_GetPeriodMs, protoMqttBatchHeader_SetPeriodMs, uint16_t) \
+	SCALAR(protoMqttBatchHeader_GetUptimeMs, protoMqttBatchHeader_SetUptimeMs, uint32_t) \
+	SCALAR(protoMqttBatchHeader_GetSeq, protoMqttBatchHeader_SetSeq, uint32_t) \
+	SCALAR(protoMqttBatchHeader_GetUtcMs, protoMqttBatchHeader_SetUtcMs, uint64_t)
+
+// mqttSample, byte offset of each field
+#define PROTO_MQTT_SAMPLE_OFFSET_MS			0
+#define PROTO_MQTT_SAMPLE_COUNT				2
+#define PROTO_MQTT_SAMPLE_SIZE				3
+#define PROTO_CHECK_MQTT_SAMPLE(T) \
+	_Static_assert(offsetof(T, mOffsetMs) == PROTO_MQTT_SAMPLE_OFFSET_MS && sizeof(((T*)0)->mOffsetMs) == 2, #T ".mOffsetMs differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mCount) == PROTO_MQTT_SAMPLE_COUNT && sizeof(((T*)0)->mCount) == 1, #T ".mCount differs from protocolSchema.json"); \
+	_Static_assert(sizeof(T) == PROTO_MQTT_SAMPLE_SIZE, #T " size differs from protocolSchema.json")
+static inline uint16_t protoMqttSample_GetOffsetMs(const uint8_t* p) { return protoGetU16(&p[PROTO_MQTT_SAMPLE_OFFSET_MS]); }
+static inline void protoMqttSample_SetOffsetMs(uint8_t* p, const uint16_t value) { protoPutU16(&p[PROTO_MQTT_SAMPLE_OFFSET_MS], value); }
+static inline uint8_t protoMqttSample_GetCount(const uint8_t* p) { return protoGetU8(&p[PROTO_MQTT_SAMPLE_COUNT]); }
+static inline void protoMqttSample_SetCount(uint8_t* p, const uint8_t value) { protoPutU8(&p[PROTO_MQTT_SAMPLE_COUNT], value); }
+#define PROTO_FIELDS_MQTT_SAMPLE(SCALAR, ARRAY) \
+	SCALAR(protoMqttSample_GetOffsetMs, protoMqttSample_SetOffsetMs, uint16_t) \
+	SCALAR(protoMqttSample_GetCount, protoMqttSample_SetCount, uint8_t)
+
+// mqttRoiEntry, byte offset of each field
+#define PROTO_MQTT_ROI_ENTRY_ROI			0
+#define PROTO_MQTT_ROI_ENTRY_MIN			1
+#define PROTO_MQTT_ROI_ENTRY_MAX			3
+#define PROTO_MQTT_ROI_ENTRY_MEAN			5
+#define PROTO_MQTT_ROI_ENTRY_PERCENTILE		7
+#define PROTO_MQTT_ROI_ENTRY_SIZE			9
+#define PROTO_CHECK_MQTT_ROI_ENTRY(T) \
+	_Static_assert(offsetof(T, mRoi) == PROTO_MQTT_ROI_ENTRY_ROI && sizeof(((T*)0)->mRoi) == 1, #T ".mRoi differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mMin) == PROTO_MQTT_ROI_ENTRY_MIN && sizeof(((T*)0)->mMin) == 2, #T ".mMin differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mMax) == PROTO_MQTT_ROI_ENTRY_MAX && sizeof(((T*)0)->mMax) == 2, #T ".mMax differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mMean) == PROTO_MQTT_ROI_ENTRY_MEAN && sizeof(((T*)0)->mMean) == 2, #T ".mMean differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mPercentile) == PROTO_MQTT_ROI_ENTRY_PERCENTILE && sizeof(((T*)0)->mPercentile) == 2, #T ".mPercentile differs from protocolSchema.json"); \
+	_Static_assert(sizeof(T) == PROTO_MQTT_ROI_ENTRY_SIZE, #T " size differs from protocolSchema.json")
+static inline uint8_t protoMqttRoiEntry_GetRoi(const uint8_t* p) { return protoGetU8(&p[PROTO_MQTT_ROI_ENTRY_ROI]); }
+static inline void protoMqttRoiEntry_SetRoi(uint8_t* p, const uint8_t value) { protoPutU8(&p[PROTO_MQTT_ROI_ENTRY_ROI], value); }
+static inline uint16_t protoMqttRoiEntry_GetMin(const uint8_t* p) { return protoGetU16(&p[PROTO_MQTT_ROI_ENTRY_MIN]); }
+static inline void protoMqttRoiEntry_SetMin(uint8_t* p, const uint16_t value) { protoPutU16(&p[PROTO_MQTT_ROI_ENTRY_MIN], value); }
+static inline uint16_t protoMqttRoiEntry_GetMax(const uint8_t* p) { return protoGetU16(&p[PROTO_MQTT_ROI_ENTRY_MAX]); }
+static inline void protoMqttRoiEntry_SetMax(uint8_t* p, const uint16_t value) { protoPutU16(&p[PROTO_MQTT_ROI_ENTRY_MAX], value); }
+static inline uint16_t protoMqttRoiEntry_GetMean(const uint8_t* p) { return protoGetU16(&p[PROTO_MQTT_ROI_ENTRY_MEAN]); }
+static inline void protoMqttRoiEntry_SetMean(uint8_t* p, const uint16_t value) { protoPutU16(&p[PROTO_MQTT_ROI_ENTRY_MEAN], value); }
+static inline uint16_t protoMqttRoiEntry_GetPercentile(const uint8_t* p) { return protoGetU16(&p[PROTO_MQTT_ROI_ENTRY_PERCENTILE]); }
+static inline void protoMqttRoiEntry_SetPercentile(uint8_t* p, const uint16_t value) { protoPutU16(&p[PROTO_MQTT_ROI_ENTRY_PERCENTILE], value); }
+#define PROTO_FIELDS_MQTT_ROI_ENTRY(SCALAR, ARRAY) \
+	SCALAR(protoMqttRoiEntry_GetRoi, protoMqttRoiEntry_SetRoi, uint8_t) \
+	SCALAR(protoMqttRoiEntry_GetMin, protoMqttRoiEntry_SetMin, uint16_t) \
+	SCALAR(protoMqttRoiEntry_GetMax, protoMqttRoiEntry_SetMax, uint16_t) \
+	SCALAR(protoMqttRoiEntry_GetMean, protoMqttRoiEntry_SetMean, uint16_t) \
+	SCALAR(protoMqttRoiEntry_GetPercentile, protoMqttRoiEntry_SetPercentile, uint16_t)
+
+// mqttEventEntry, byte offset of each field
+#define PROTO_MQTT_EVENT_ENTRY_RULE			0
+#define PROTO_MQTT_EVENT_ENTRY_RAISED		1
+#define PROTO_MQTT_EVENT_ENTRY_VALUE		2
+#define PROTO_MQTT_EVENT_ENTRY_ACTIVE		4
+#define PROTO_MQTT_EVENT_ENTRY_SEQ			5
+#define PROTO_MQTT_EVENT_ENTRY_SIZE			9
+#define PROTO_CHECK_MQTT_EVENT_ENTRY(T) \
+	_Static_assert(offsetof(T, mRule) == PROTO_MQTT_EVENT_ENTRY_RULE && sizeof(((T*)0)->mRule) == 1, #T ".mRule differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mRaised) == PROTO_MQTT_EVENT_ENTRY_RAISED && sizeof(((T*)0)->mRaised) == 1, #T ".mRaised differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mValue) == PROTO_MQTT_EVENT_ENTRY_VALUE && sizeof(((T*)0)->mValue) == 2, #T ".mValue differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mActive) == PROTO_MQTT_EVENT_ENTRY_ACTIVE && sizeof(((T*)0)->mActive) == 1, #T ".mActive differs from protocolSchema.json"); \
+	_Static_assert(offsetof(T, mSeq) == PROTO_MQTT_EVENT_ENTRY_SEQ && sizeof(((T*)0)->mSeq) == 4, #T ".mSeq differs from protocolSchema.json"); \
+	_Static_assert(sizeof(T) == PROTO_MQTT_EVENT_ENTRY_SIZE, #T " size differs from protocolSchema.json")
+static inline uint8_t protoMqttEventEntry_GetRule(const uint8_t* p) { return protoGetU8(&p[PROTO_MQTT_EVENT_ENTRY_RULE]); }
+static inline void protoMqttEventEntry_SetRule(uint8_t* p, const uint8_t value) { protoPutU8(&p[PROTO_MQTT_EVENT_ENTRY_RULE], value); }
+static inline uint8_t protoMqttEventEntry_GetRaised(const uint8_t* p) { return protoGetU8(&p[PROTO_MQTT_EVENT_ENTRY_RAISED]); }
+static inline void protoMqttEventEntry_SetRaised(uint8_t* p, const uint8_t value) { protoPutU8(&p[PROTO_MQTT_EVENT_ENTRY_RAISED], value); }
+static inline uint16_t protoMqttEventEntry_GetValue(const uint8_t* p) { return protoGetU16(&p[PROTO_MQTT_EVENT_ENTRY_VALUE]); }
+static inline void protoMqttEventEntry_SetValue(uint8_t* p, const uint16_t value) { protoPutU16(&p[PROTO_MQTT_EVENT_ENTRY_VALUE], value); }
+static inline uint8_t protoMqttEventEntry_GetActive(const uint8_t* p) { return protoGetU8(&p[PROTO_MQTT_EVENT_ENTRY_ACTIVE]); }
+static inline void protoMqttEventEntry_SetActive(uint8_t* p, const uint8_t value) { protoPutU8(&p[PROTO_MQTT_EVENT_ENTRY_ACTIVE], value); }
+static inline uint32_t protoMqttEventEntry_GetSeq(const uint8_t* p) { return protoGetU32(&p[PROTO_MQTT_EVENT_ENTRY_SEQ]); }
+static inline void protoMqttEventEntry_SetSeq(uint8_t* p, const uint32_t value) { protoPutU32(&p[PROTO_MQTT_EVENT_ENTRY_SEQ], value); }
+#define PROTO_FIELDS_MQTT_EVENT_ENTRY(SCALAR, ARRAY) \
+	SCALAR(protoMqttEventEntry_GetRule, protoMqttEventEntry_SetRule, uint8_t) \
+	SCALAR(protoMqttEventEntry_GetRaised, protoMqttEventEntry_SetRaised, uint8_t) \
+	SCALAR(protoMqttEventEntry_GetValue, protoMqttEventEntry_SetValue, uint16_t) \
+	SCALAR(protoMqttEventEntry_GetActive, protoMqttEventEntry_SetActive, uint8_t) \
+	SCALAR(protoMqttEventEntry_GetSeq, protoMqttEventEntry_SetSeq, uint32_t)
+
+// Every layout, with the X macro of its fields and its size
+#define PROTO_LAYOUTS(X) \
+	X(frameStats, PROTO_FIELDS_FRAME_STATS, PROTO_FRAME_STATS_SIZE) \
+	X(streamShape, PROTO_FIELDS_STREAM_SHAPE, PROTO_STREAM_SHAPE_SIZE) \
+	X(blobEntry, PROTO_FIELDS_BLOB_ENTRY, PROTO_BLOB_ENTRY_SIZE) \
+	X(blobRecord, PROTO_FIELDS_BLOB_RECORD, PROTO_BLOB_RECORD_SIZE) \
+	X(streamHeader, PROTO_FIELDS_STREAM_HEADER, PROTO_STREAM_HEADER_SIZE) \
+	X(udpChunkHeader, PROTO_FIELDS_UDP_CHUNK_HEADER, PROTO_UDP_CHUNK_HEADER_SIZE) \
+	X(mqttBatchHeader, PROTO_FIELDS_MQTT_BATCH_HEADER, PROTO_MQTT_BATCH_HEADER_SIZE) \
+	X(mqttSample, PROTO_FIELDS_MQTT_SAMPLE, PROTO_MQTT_SAMPLE_SIZE) \
+	X(mqttRoiEntry, PROTO_FIELDS_MQTT_ROI_ENTRY, PROTO_MQTT_ROI_ENTRY_SIZE) \
+	X(mqttEventEntry, PROTO_FIELDS_MQTT_EVENT_ENTRY, PROTO_MQTT_EVENT_ENTRY_SIZE)
+
+#endif /* COMPONENTS_UTIL_INCLUDE_PROTOSCHEMA_H_ */
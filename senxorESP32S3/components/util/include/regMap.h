@@ -0,0 +1,116 @@
+/*****************************************************************************
+ * @file     regMap.h
+ * @version  1.00
+ * @brief    Header file for regMap.c
+ * @date	 15 Oct 2026
+ * @details	 REG_MAP_LIST is the one description of the registers that are
+ * 			 not plain SenXor registers, or that the clients need to know.
+ * 			 regMap.c builds its lookup table from it, and
+ * 			 Node_Thermal_TCP/genProtocol.js the client constants and the
+ * 			 register table of protocol.md. Run "npm run protocol" there
+ * 			 after changing the list. Keep one entry per line, the script
+ * 			 reads the lines as text.
+ ******************************************************************************/
+#ifndef COMPONENTS_UTIL_INCLUDE_REGMAP_H_
+#define COMPONENTS_UTIL_INCLUDE_REGMAP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define REG_MAP_SIZE		256
+
+// Hex digits of the value in RREG and RRSE replies
+#define REG_8				2
+#define REG_16				4
+
+/*
+ * X(address, name, width, getter, setter, NVS key)
+ * The getter and setter take the address, the setter is NULL for read
+ * only registers. The NVS key is the record the register is saved in,
+ * NULL if writes are lost on reset. Addresses left out are SenXor
+ * registers, 8-bit and read and written over SPI.
+ */
+#define REG_MAP_LIST(X) \
+	X(0xB0, "Control",      REG_8,  regReadSenxor,               regWriteSenxor,                NULL) \
+	X(0xB1, "Capture",      REG_8,  regReadSenxor,               regWriteSenxor,                NULL) \
+	X(0xB2, "VersionHigh",  REG_8,  regReadVersion,              NULL,                          NULL) \
+	X(0xB3, "VersionLow",   REG_8,  regReadVersion,              NULL,                          NULL) \
+	X(0xC0, "Xsplit",       REG_16, quadrant_ReadRegister,       quadrant_WriteRegister,        "quadcfg") \
+	X(0xC1, "Ysplit",       REG_16, quadrant_ReadRegister,       quadrant_WriteRegister,        "quadcfg") \
+	X(0xC2, "Amax",         REG_16, quadrant_ReadRegister,       NULL,                          NULL) \
+	X(0xC3, "Acenter",      REG_16, quadrant_ReadRegister,       NULL,                          NULL) \
+	X(0xC4, "Bmax",         REG_16, quadrant_ReadRegister,       NULL,                          NULL) \
+	X(0xC5, "Bcenter",      REG_16, quadrant_ReadRegister,       NULL,                          NULL) \
+	X(0xC6, "Cmax",         REG_16, quadrant_ReadRegister,       NULL,                          NULL) \
+	X(0xC7, "Ccenter",      REG_16, quadrant_ReadRegister,       NULL,                          NULL) \
+	X(0xC8, "Dmax",         REG_16, quadrant_ReadRegister,       NULL,                          NULL) \
+	X(0xC9, "Dcenter",      REG_16, quadrant_ReadRegister,       NULL,                          NULL) \
+	X(0xCA, "Aburnerx",     REG_16, quadrant_ReadRegister,       quadrant_WriteRegister,        "quadcfg") \
+	X(0xCB, "Aburnery",     REG_16, quadrant_ReadRegister,       quadrant_WriteRegister,        "quadcfg") \
+	X(0xCC, "Aburnert",     REG_16, quadrant_ReadRegister,       NULL,                          NULL) \
+	X(0xCD, "Bburnerx",     REG_16, quadrant_ReadRegister,       quadrant_WriteRegister,        "quadcfg") \
+	X(0xCE, "Bburnery",     REG_16, quadrant_ReadRegister,       quadrant_WriteRegister,        "quadcfg") \
+	X(0xCF, "Bburnert",     REG_16, quadrant_ReadRegister,       NULL,                          NULL) \
+	X(0xD0, "Cburnerx",     REG_16, quadrant_ReadRegister,       quadrant_WriteRegister,        "quadcfg") \
+	X(0xD1, "Cburnery",     REG_16, quadrant_ReadRegister,       quadrant_WriteRegister,        "quadcfg") \
+	X(0xD2, "Cburnert",     REG_16, quadrant_ReadRegister,       NULL,                          NULL) \
+	X(0xD3, "Dburnerx",     REG_16, quadrant_ReadRegister,       quadrant_WriteRegister,        "quadcfg") \
+	X(0xD4, "Dburnery",     REG_16, quadrant_ReadRegister,       quadrant_WriteRegister,        "quadcfg") \
+	X(0xD5, "Dburnert",     REG_16, quadrant_ReadRegister,       NULL,                          NULL) \
+	X(0xD6, "TfiltMode",    REG_16, temporalFilter_ReadRegister, temporalFilter_WriteRegister,  NULL) \
+	X(0xD7, "TfiltAlpha",   REG_16, temporalFilter_ReadRegister, temporalFilter_WriteRegister,  NULL) \
+	X(0xD8, "TfiltFrames",  REG_16, temporalFilter_ReadRegister, temporalFilter_WriteRegister,  NULL) \
+	X(0xD9, "ChgMode",      REG_16, sceneChange_ReadRegister,    sceneChange_WriteRegister,     NULL) \
+	X(0xDA, "ChgDelta",     REG_16, sceneChange_ReadRegister,    sceneChange_WriteRegister,     NULL) \
+	X(0xDB, "ChgPixels",    REG_16, sceneChange_ReadRegister,    sceneChange_WriteRegister,     NULL) \
+	X(0xDC, "ChgHeartbeat", REG_16, sceneChange_ReadRegister,    sceneChange_WriteRegister,     NULL) \
+	X(0xDD, "ChgCount",     REG_16, sceneChange_ReadRegister,    NULL,                          NULL) \
+	X(0xDE, "ChgBoxMin",    REG_16, sceneChange_ReadRegister,    NULL,                          NULL) \
+	X(0xDF, "ChgBoxMax",    REG_16, sceneChange_ReadRegister,    NULL,                          NULL) \
+	X(0xE0, "DevID0",       REG_8,  regReadSenxor,               NULL,                          NULL) \
+	X(0xE1, "DevID1",       REG_8,  regReadSenxor,               NULL,                          NULL) \
+	X(0xE2, "DevID2",       REG_8,  regReadSenxor,               NULL,                          NULL) \
+	X(0xE3, "DevID3",       REG_8,  regReadSenxor,               NULL,                          NULL) \
+	X(0xE4, "DevID4",       REG_8,  regReadSenxor,               NULL,                          NULL) \
+	X(0xE5, "DevID5",       REG_8,  regReadSenxor,               NULL,                          NULL) \
+	X(0xE8, "RoiCount",     REG_16, roiEngine_ReadRegister,      NULL,                          NULL) \
+	X(0xE9, "RoiSel",       REG_16, roiEngine_ReadRegister,      roiEngine_WriteRegister,       NULL) \
+	X(0xEA, "RoiMin",       REG_16, roiEngine_ReadRegister,      NULL,                          NULL) \
+	X(0xEB, "RoiMax",       REG_16, roiEngine_ReadRegister,      NULL,                          NULL) \
+	X(0xEC, "RoiMean",      REG_16, roiEngine_ReadRegister,      NULL,                          NULL) \
+	X(0xED, "RoiPct",       REG_16, roiEngine_ReadRegister,      NULL,                          NULL) \
+	X(0xEE, "RoiHotX",      REG_16, roiEngine_ReadRegister,      NULL,                          NULL) \
+	X(0xEF, "RoiHotY",      REG_16, roiEngine_ReadRegister,      NULL,                          NULL) \
+	X(0xF0, "RoiPixels",    REG_16, roiEngine_ReadRegister,      NULL,                          NULL) \
+	X(0xF1, "FrameMin",     REG_16, regReadStats,                NULL,                          NULL) \
+	X(0xF2, "FrameMax",     REG_16, regReadStats,                NULL,                          NULL) \
+	X(0xF3, "FrameMean",    REG_16, regReadStats,                NULL,                          NULL) \
+	X(0xF4, "FrameP50",     REG_16, regReadStats,                NULL,                          NULL) \
+	X(0xF5, "FrameP95",     REG_16, regReadStats,                NULL,                          NULL) \
+	X(0xF6, "FrameP99",     REG_16, regReadStats,                NULL,                          NULL) \
+	X(0xF7, "RuleActive",   REG_16, regReadRule,                 NULL,                          NULL) \
+	X(0xF8, "ClsRate",      REG_16, frameClassifier_ReadRegister, frameClassifier_WriteRegister, NULL) \
+	X(0xF9, "ClsRoi",       REG_16, frameClassifier_ReadRegister, frameClassifier_WriteRegister, NULL) \
+	X(0xFA, "ClsClass",     REG_16, frameClassifier_ReadRegister, NULL,                         NULL) \
+	X(0xFB, "ClsFlame",     REG_16, frameClassifier_ReadRegister, NULL,                         NULL) \
+	X(0xFC, "ClsPan",       REG_16, frameClassifier_ReadRegister, NULL,                         NULL) \
+	X(0xFD, "ClsLatency",   REG_16, frameClassifier_ReadRegister, NULL,                         NULL)
+
+typedef uint16_t (*regRead_t)(const uint8_t addr);
+typedef void (*regWrite_t)(const uint8_t addr, const uint8_t value);
+
+typedef struct regDesc{
+	const char* pName;
+	const char* pNvsKey;					//NVS record the register is saved in, NULL if not saved
+	regRead_t pRead;
+	regWrite_t pWrite;						//NULL for read only registers
+	uint8_t mWidth;							//REG_8 or REG_16, hex digits in RREG and RRSE
+}regDesc_t;
+
+const regDesc_t* regMap_Get(const uint8_t addr);
+
+uint16_t regMap_Read(const uint8_t addr);
+
+bool regMap_Write(const uint8_t addr, const uint8_t value);
+
+#endif /* COMPONENTS_UTIL_INCLUDE_REGMAP_H_ */
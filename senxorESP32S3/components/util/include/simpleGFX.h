@@ -8,11 +8,53 @@
 #define COMPONENTS_UTIL_INCLUDE_SIMPLEGFX_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "colourmap.h"
 #include "DrvLCD.h"
 #include "sdkconfig.h"
 #define colour565(r, g, b) (((r & 0xF8) << 8) | ((g & 0xFC) << 3) | ((b & 0xF8) >> 3))
 
+#define GFX_LUT_SIZE		1024				//Colour LUT entries, one per raw unit for spans up to this
+#define GFX_MAX_SCALE		4					//Largest integer upscale of the row kernels
+
+/*
+ * Raw value to colour565 look-up table for one colour map and range.
+ * Entry i holds the colour of raw values mMin + (i << mShift), so a pixel
+ * costs a subtract, a shift and a load, without a division.
+ */
+typedef struct gfxColourLut{
+	uint16_t mMin;
+	uint16_t mMax;
+	uint16_t mEntries;					//Entries in use, the last one is the colour of mMax
+	uint8_t mShift;						//log2 of the raw units per entry
+	uint8_t mMap;						//ColourmapSelection, colourmapCount while not built
+	uint16_t mColour[GFX_LUT_SIZE];
+}gfxColourLut_t;
+
+/*
+ * LUT entry of a raw value, clamped to the range
+ */
+static inline uint16_t gfxLutIndex(const gfxColourLut_t* pLut, const uint16_t value)
+{
+	if(value <= pLut->mMin)
+	{
+		return 0;
+	}
+	const uint32_t i = (uint32_t)(value - pLut->mMin) >> pLut->mShift;
+	return (i < pLut->mEntries) ? (uint16_t)i : (uint16_t)(pLut->mEntries - 1);
+}
+
+void gfxLutReset(gfxColourLut_t* pLut);
+
+bool gfxLutUpdate(gfxColourLut_t* pLut, const uint16_t minVal, const uint16_t maxVal, const uint8_t map);
+
+void gfxLutMapRow(const gfxColourLut_t* pLut, const uint16_t* pSrc, uint16_t* pDst, const uint16_t count);
+
+void gfxUpscaleNearestRow(const uint16_t* pSrc, const uint16_t count, const uint8_t scale, uint16_t* pDst);
+
+void gfxUpscaleBilinearRow(const uint16_t* pImage, const uint16_t w, const uint16_t h, const uint8_t scale,
+						   const uint16_t outY, const uint16_t outX, const uint16_t outW, uint16_t* pDst);
+
 uint16_t* colourMapping(uint16_t *temperateData , uint16_t minTemperature, uint16_t maxTemperature, const uint8_t selectedColourMapIndex);
 
 void drawCrossByOverlay(uint16_t* srcImg, const uint16_t colour, const uint8_t scale);
@@ -2,7 +2,7 @@
 #define COMPONENTS_UTIL_INCLUDE_UTIL_H_
 
 #include <stdint.h>
-#include <cJSON.h>
+#include "jsonWriter.h"
 #include "esp_log.h"			//ESP logger
 #include "esp_attr.h"
 #include "DrvWLAN.h"
@@ -49,9 +49,11 @@ void printSenXorLog(const uint16_t *senData);
 
 void displaySenxorInfo(void);
 
-void getSysInfoJson(cJSON* jsonObj);
+void getSysInfoJson(jsonWriter_t* pWriter);
 
 uint32_t getFrameAvg(uint16_t x, uint16_t y, uint16_t h, uint16_t w, const uint16_t* frame);
 
 uint16_t getCRC(const uint8_t* pData, uint16_t pDataSize);
+
+uint16_t getCRC16(const uint8_t* pData, uint16_t pDataSize);
 #endif /* COMPONENTS_UTIL_INCLUDE_MSG_H_ */
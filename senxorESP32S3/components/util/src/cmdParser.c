@@ -7,48 +7,123 @@
  ******************************************************************************/
 #include "cmdParser.h"
 #include "SenXorLib.h"
+#include "Senxor_Capturedata.h"
+#include "FrameStats.h"
+#include "LatencyTrace.h"
+#include "Drv_CRC.h"
+#include "regMap.h"
+#include "protoSchema.h"
+#include <sdkconfig.h>
 
-//public:
-extern int ApplicationReadVersion (int Address);
-
-// Quadrant register addresses (from senxorTask.h)
-#define REG_XSPLIT    0xC0
-#define REG_YSPLIT    0xC1
-#define REG_AMAX      0xC2
-#define REG_ACENTER   0xC3
-#define REG_BMAX      0xC4
-#define REG_BCENTER   0xC5
-#define REG_CMAX      0xC6
-#define REG_CCENTER   0xC7
-#define REG_DMAX      0xC8
-#define REG_DCENTER   0xC9
-
-// Burner register addresses
-#define REG_ABURNERX  0xCA
-#define REG_ABURNERY  0xCB
-#define REG_ABURNERT  0xCC
-#define REG_BBURNERX  0xCD
-#define REG_BBURNERY  0xCE
-#define REG_BBURNERT  0xCF
-#define REG_CBURNERX  0xD0
-#define REG_CBURNERY  0xD1
-#define REG_CBURNERT  0xD2
-#define REG_DBURNERX  0xD3
-#define REG_DBURNERY  0xD4
-#define REG_DBURNERT  0xD5
+// ROI register window (see roiEngine.h)
+#define REG_ROI_MIN   0xEA
+#define REG_ROI_MAX   0xEB
+#define REG_ROI_MEAN  0xEC
+#define REG_ROI_PCT   0xED
+#define REG_ROI_HOTX  0xEE
+#define REG_ROI_HOTY  0xEF
+#define REG_ROI_PIXELS 0xF0
+#define ROI_MAX_VERTICES 8
 
 // External quadrant functions (implemented in senxorTask.c)
-extern uint16_t quadrant_ReadRegister(uint8_t regAddr);
-extern void quadrant_WriteRegister(uint8_t regAddr, uint8_t value);
+extern void quadrant_SaveConfig(void);
+
+// External ROI functions (implemented in roiEngine.c)
+extern bool roiEngine_SetRoi(const uint8_t idx, const uint8_t type, const uint8_t percentile, const uint8_t vertexCount, const uint8_t* pVertex);
+extern uint16_t roiEngine_ReadStat(const uint8_t idx, const uint8_t regAddr);
+
+// External blob tracking functions (implemented in blobTrack.c)
+extern void blobTrack_Configure(const uint16_t threshold, const uint8_t minArea);
+extern void blobTrack_GetStatus(uint16_t* pThreshold, uint8_t* pMinArea, uint8_t* pCount);
+
+// External alarm rule functions (implemented in ruleEngine.c)
+extern bool ruleEngine_SetRule(const uint8_t idx, const uint8_t metric, const uint8_t source, const uint8_t compare, const uint8_t led,
+		const uint16_t threshold, const uint16_t hysteresis, const uint16_t dwell);
+extern bool ruleEngine_GetRule(const uint8_t idx, uint8_t* pMetric, uint8_t* pSource, uint8_t* pCompare, uint8_t* pLed,
+		uint16_t* pThreshold, uint16_t* pHysteresis, uint16_t* pDwell, uint8_t* pRaised, uint16_t* pValue);
+
+// External ESP-NOW peer functions (implemented in espNowTask.c)
+extern bool espNow_SetPeer(const uint8_t idx, const uint8_t* pMac, const uint8_t flags);
+extern bool espNow_GetPeer(const uint8_t idx, uint8_t* pMac, uint8_t* pFlags, uint16_t* pFailed);
+
+// External bad pixel map functions (implemented in pixelMap.c)
+extern bool pixelMap_Calibrate(const uint16_t threshold);
+extern void pixelMap_Clear(void);
+extern void pixelMap_GetStatus(uint8_t* pState, uint16_t* pCount);
+
+// External correction map functions (implemented in pixelCorrect.c)
+extern uint8_t pixelCorrect_Write(const uint16_t start, const uint8_t count, const uint8_t* pEntry);
+extern uint8_t pixelCorrect_Commit(void);
+extern uint8_t pixelCorrect_Clear(void);
+extern void pixelCorrect_GetStatus(uint8_t* pState, bool* pSaved, uint16_t* pWritten);
+
+// External benchmark function (implemented in microBench.c)
+extern bool microBench_Run(const uint8_t test, uint32_t* pIterations, uint32_t* pCycles, uint32_t* pBytesPerSec);
+
+// External telemetry functions (implemented in sysStats.c)
+extern bool sysStats_GetSummary(uint32_t* pUptimeS, uint32_t* pInternalFree, uint32_t* pInternalMin, uint32_t* pPsramFree, uint32_t* pDropped, uint8_t* pDeepest);
+extern bool sysStats_GetTask(const char* pName, uint16_t* pCpuPermille, uint16_t* pStackFree);
+
+// Tasks reported by SYST, in response order
+static const char* const mSystTask[] = {"senxorTask", "tcpServerTask", "cmdServerTask", "usbSerialTask"};
+
+#define BPIX_OP_STATUS			0x00
+#define BPIX_OP_CALIBRATE		0x01
+#define BPIX_OP_CLEAR			0x02
 
 // External functions for POLL command
 extern bool tcpServerGetIsClientConnected(void);
 extern void cmdServerSetPollFreqHz(uint8_t freqHz);
+extern bool cmdServerSubscribe(const uint8_t* pAddr, const uint8_t count, const uint16_t intervalMs, const uint16_t threshold);
+
+// External function for STAT command (implemented in tcpServerTask.c)
+extern bool tcpServerGetClientStats(const uint8_t idx, uint32_t* pBytesSent, uint32_t* pFramesSent, uint32_t* pFramesDropped, uint32_t* pBlockedMs);
+
+// External functions for SFMT command (implemented in tcpServerTask.c)
+extern int tcpServerSetStreamFormat(const char* pAddr, uint8_t* pFormat, uint8_t* pEncoding);
+extern int tcpServerSetStreamIntegrity(const char* pAddr, uint8_t* pMode);
+
+// External functions for SHAP command (implemented in tcpServerTask.c and cmdServerTask.c), the address is used by SFMT and SCRC too
+extern int tcpServerSetStreamShape(const char* pAddr, uint8_t* pShape);
+extern const char* cmdServerGetCurrentAddr(void);
+
+// External USB functions (implemented in usbSerialTask.c)
+extern void usbSerialSetIntegrity(const uint8_t mode);
+extern uint8_t usbSerialGetIntegrity(void);
+
+#if CONFIG_MI_REC_EN
+// External frame recorder functions (implemented in frameRecorder.c)
+extern void frameRecorderTrigger(const uint8_t source);
+extern void frameRecorderArm(void);
+extern bool frameRecorderSetRoiTrigger(const uint8_t idx, const uint16_t threshold);
+extern void frameRecorderGetStatus(uint8_t* pState, uint8_t* pTrigger, uint32_t* pFrames, uint32_t* pClipLen, uint8_t* pRoi, uint16_t* pThreshold);
+extern bool frameRecorderBeginDownload(void);
+
+#define RECC_OP_STATUS			0x00
+#define RECC_OP_TRIGGER			0x01
+#define RECC_OP_ARM				0x02
+#define RECC_OP_ROI				0x03
+#define RECC_TRIGGER_COMMAND	0x01	// recTrigger_t REC_TRIGGER_COMMAND
+#define RECD_ACK_LEN			32		// "   #0018RECD" + offset + length + CRC
+#endif
+
+/******************************************************************************
+ * @brief       cmdParser_ReadRegister
+ * @param       addr - Register address
+ * @return      Register value, 16-bit registers are returned in full
+ * @details     Same value as RREG
+ *****************************************************************************/
+uint16_t cmdParser_ReadRegister(int addr)
+{
+	return regMap_Read((uint8_t)addr);
+}// cmdParser_ReadRegister
+
+// Hex digit value + 1, 0 for characters that are not an upper case hex digit
+static const uint8_t mHexTable[256] = {
+	['0'] = 1, ['1'] = 2, ['2'] = 3, ['3'] = 4, ['4'] = 5, ['5'] = 6, ['6'] = 7, ['7'] = 8,
+	['8'] = 9, ['9'] = 10, ['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16
+};
 
-// Helper to check if address is a quadrant/burner register (0xC0-0xD5)
-static inline bool isQuadrantRegister(int addr) {
-	return (addr >= REG_XSPLIT && addr <= REG_DBURNERT);
-}
 /******************************************************************************
  * @brief       getHexValue
  * @param       c - Data to be converted
@@ -57,15 +132,7 @@ static inline bool isQuadrantRegister(int addr) {
  *****************************************************************************/
 int getHexValue(const char c)
 {
-	if((c >= '0') && (c <='9'))
-	{
-	    return c - '0';
-	}
-	if((c >= 'A') && (c <= 'F'))
-	{
-	    return c -'A' + 10;
-	}
-	return LENGTH_PARSE_ERROR;
+	return (int)mHexTable[(uint8_t)c] - 1;		//LENGTH_PARSE_ERROR for an invalid character
 }
 
 /******************************************************************************
@@ -77,17 +144,16 @@ int getHexValue(const char c)
 int toHex(const char* pStr)
 {
   int result = 0;
-  const int length = strlen(pStr);								//Obtains the length
   //For each elements inside the buffer
-  //Convert it to hexadecimal value
-  for(int i = 0; i < length; i++)
+  //Shift in its hexadecimal value
+  for(; *pStr != 0; pStr++)
   {
-    int val = getHexValue(pStr[i]);
+    const int val = getHexValue(*pStr);
     if(val == LENGTH_PARSE_ERROR)
 	{
       return LENGTH_PARSE_ERROR;
     }
-    result += (int)(val * pow(16, length-i-1));
+    result = (result << 4) | val;
   }
   return result;
 }// toHex
@@ -97,7 +163,7 @@ int toHex(const char* pStr)
  * @param       pCmdPhaser - cmdParser object
  * @return      none
  * @details     Initialise cmdParser object. 
- * 				This will erase all the data stored in the object
+ * 				This will erase the command and data stored in the object
  *****************************************************************************/
 void cmdParser_Init(cmdPhaser* pCmdPhaser)
 {
@@ -106,10 +172,21 @@ void cmdParser_Init(cmdPhaser* pCmdPhaser)
 	{
 		return;
 	}// End if
+
+	// Only the data of the last command needs to be erased
+	uint32_t tDataLen = (pCmdPhaser->mLenValue > 8) ? pCmdPhaser->mLenValue - 8 : 0;
+	if(tDataLen > CP_DATA_FIELD_LEN)
+	{
+		tDataLen = CP_DATA_FIELD_LEN;
+	}// End if
+
 	pCmdPhaser->mCmdParserState = START_CHAR;
+	pCmdPhaser->mFieldPtr = 0;
+	pCmdPhaser->mLenValue = 0;
+	pCmdPhaser->mChksum = 0;
 	memset(pCmdPhaser->mCmd,0,CP_CMD_FIELD_LEN);
 	memset(pCmdPhaser->mCmdLen,0,CP_DLEN_FIELD_LEN);
-	memset(pCmdPhaser->mData,0,CP_DATA_FIELD_LEN);
+	memset(pCmdPhaser->mData,0,tDataLen);
 	memset(pCmdPhaser->mCRC,0,CP_CRC_FIELD_LEN);
 }// cmdParser_Init
 
@@ -118,26 +195,42 @@ void cmdParser_Init(cmdPhaser* pCmdPhaser)
  * @param       pCmdPhaser - cmdParser object
  * 				pInput - Input string
 				pInputSize - Size of the input string
- * @return      none
+ * @return      0 on success or incomplete input, -1 on a checksum mismatch
  * @details     Pharse the command and data in a given string
  *****************************************************************************/
 int cmdParser_PharseCmd(cmdPhaser* pCmdPhaser, const uint8_t* pInput, size_t pInputSize)
 {
-	uint32_t tCmdPtr = 0;
-	uint32_t tInputChksum = 0;
-	uint32_t tCalChksum = 0;
-	uint32_t tCmdLen = 0;
+	size_t tConsumed = 0;
 
 #if CONFIG_MI_EVK_CP_DBG
 	ESP_LOGI(CPTAG,CP_INFO_START);
 	ESP_LOGI(CPTAG,"%s",pInput);
 #endif
+	return (cmdParser_FeedCmd(pCmdPhaser, pInput, pInputSize, &tConsumed) == CP_CMD_CRC_FAIL) ? -1 : 0;
+}// cmdParser_PharseCmd
+
+/******************************************************************************
+ * @brief       cmdParser_FeedCmd
+ * @param       pCmdPhaser - cmdParser object
+ * 				pInput - Received bytes
+				pInputSize - Number of received bytes
+				pConsumed - Number of bytes used from pInput
+ * @return      CP_CMD_READY, CP_CMD_CRC_FAIL or CP_CMD_PENDING
+ * @details     Streaming parser: the state is kept in the object, so a command
+ * 				can be split across several calls. Parsing stops after a
+ * 				complete command, the caller feeds the rest of the input
+ * 				after cmdParser_CommitCmd and cmdParser_Init.
+ *****************************************************************************/
+int cmdParser_FeedCmd(cmdPhaser* pCmdPhaser, const uint8_t* pInput, size_t pInputSize, size_t* pConsumed)
+{
+	*pConsumed = 0;
+
 	if(!pInput)
 	{
 		#if CONFIG_MI_EVK_CP_DBG	
 		ESP_LOGE(CPTAG,CP_ERR_INPUT_NULL);
 		#endif
-		return -1;
+		return CP_CMD_CRC_FAIL;
 	}
 
 	if(!pCmdPhaser)
@@ -145,16 +238,7 @@ int cmdParser_PharseCmd(cmdPhaser* pCmdPhaser, const uint8_t* pInput, size_t pIn
 		#if CONFIG_MI_EVK_CP_DBG	
 		ESP_LOGE(CPTAG,CP_ERR_OBJ_NULL);
 		#endif
-		return -1;
-	}
-
-	if(pInputSize > (CP_CMD_FIELD_LEN+CP_DLEN_FIELD_LEN+CP_DATA_FIELD_LEN+CP_CRC_FIELD_LEN))
-	{
-		
-		pInputSize = (CP_CMD_FIELD_LEN+CP_DLEN_FIELD_LEN+CP_DATA_FIELD_LEN+CP_CRC_FIELD_LEN);
-		#if CONFIG_MI_EVK_CP_DBG	
-		ESP_LOGW(CPTAG,CP_WARN_INPUT_LEN_OVER,pInputSize);
-		#endif
+		return CP_CMD_CRC_FAIL;
 	}
 
 	for (size_t i = 0 ; i < pInputSize ; ++i)
@@ -168,34 +252,41 @@ int cmdParser_PharseCmd(cmdPhaser* pCmdPhaser, const uint8_t* pInput, size_t pIn
 				// Search for start character '#'
 				if(pInput[i] == CP_START_CHAR)
 				{
+					pCmdPhaser->mFieldPtr = 0;
+					pCmdPhaser->mChksum = 0;
 					pCmdPhaser->mCmdParserState = LEN;
 				}// End if
 			break;
 			// Command length
 			case LEN:
-				pCmdPhaser->mCmdLen[tCmdPtr++] = pInput[i];
-				tInputChksum += pInput[i];
+				pCmdPhaser->mCmdLen[pCmdPhaser->mFieldPtr++] = pInput[i];
+				pCmdPhaser->mChksum += pInput[i];
 			#if CONFIG_MI_EVK_CP_DBG
 				ESP_LOGI(CPTAG,CP_INFO_STAGE_2);
 			#endif
-				if(tCmdPtr == CP_CMD_FIELD_LEN - 1)
+				if(pCmdPhaser->mFieldPtr == CP_CMD_FIELD_LEN - 1)
 				{
-					tCmdLen = strtoul((char*)pCmdPhaser->mCmdLen,0,16);
-					if (tCmdLen > 7) 
-					{
-						tCmdPtr = 0;
-						pCmdPhaser->mCmdParserState = DATA;
-					}// End if
+					uint32_t tCmdLen = 0;
+					pCmdPhaser->mFieldPtr = 0;
 
 					// Rejecting unqualified commands
-					if ((tCmdLen < 8)||(tCmdLen==0xffffffff))
+					if (!protoHex_Read(pCmdPhaser->mCmdLen, PROTO_PACKET_LEN_DIGITS, &tCmdLen) || (tCmdLen < PROTO_PACKET_MIN_LEN))
 					{
-						tCmdPtr = 0;
 						pCmdPhaser->mCmdParserState = START_CHAR;
 					#if CONFIG_MI_EVK_CP_DBG		
 						ESP_LOGE(CPTAG,CP_ERR_CMD_LEN);
 					#endif
-					}// End if
+					}
+					else if (tCmdLen > CP_MAX_CMD_LEN)
+					{
+						pCmdPhaser->mCmdParserState = START_CHAR;
+						ESP_LOGW(CPTAG,CP_WARN_CMD_TOO_LONG,tCmdLen);
+					}
+					else
+					{
+						pCmdPhaser->mLenValue = tCmdLen;
+						pCmdPhaser->mCmdParserState = DATA;
+					}// End if-else
 					
 				}// End if
 				
@@ -206,86 +297,224 @@ int cmdParser_PharseCmd(cmdPhaser* pCmdPhaser, const uint8_t* pInput, size_t pIn
 				#if CONFIG_MI_EVK_CP_DBG	
 				ESP_LOGI(CPTAG,CP_INFO_STAGE_3);
 				#endif
-				tInputChksum += pInput[i];    
+				pCmdPhaser->mChksum += pInput[i];
 
 				// Fetch commands first (4 bytes)
-				if(tCmdPtr < CP_CMD_FIELD_LEN - 1)
+				if(pCmdPhaser->mFieldPtr < CP_CMD_FIELD_LEN - 1)
 				{
-					pCmdPhaser->mCmd[tCmdPtr++] = pInput[i];
-
+					pCmdPhaser->mCmd[pCmdPhaser->mFieldPtr] = pInput[i];
 				}
 				else
 				{
-					pCmdPhaser->mData[tCmdPtr - (CP_CMD_FIELD_LEN - 1)] = pInput[i];
-					tCmdPtr++;
+					pCmdPhaser->mData[pCmdPhaser->mFieldPtr - (CP_CMD_FIELD_LEN - 1)] = pInput[i];
 				}// End if-else
+				pCmdPhaser->mFieldPtr++;
 
-				                        
-				if (tCmdPtr == tCmdLen - 4 || tCmdPtr == CP_CMD_FIELD_LEN + CP_DATA_FIELD_LEN)
+				// Length field counts command, data and CRC
+				if (pCmdPhaser->mFieldPtr == pCmdPhaser->mLenValue - NUM_BYTES_CRC_FIELD)
 				{
 					pCmdPhaser->mCmdParserState = CRC;
-					tCmdPtr = 0;
+					pCmdPhaser->mFieldPtr = 0;
 				}//End if
 				
-				
 			break;
 
 			case CRC:
 				#if CONFIG_MI_EVK_CP_DBG	
 				ESP_LOGI(CPTAG,CP_INFO_STAGE_4);
 				#endif
-				pCmdPhaser->mCRC[tCmdPtr++] = pInput[i];
-				if(tCmdPtr == CP_CRC_FIELD_LEN - 1)
+				pCmdPhaser->mCRC[pCmdPhaser->mFieldPtr++] = pInput[i];
+				if(pCmdPhaser->mFieldPtr == CP_CRC_FIELD_LEN - 1)
 				{ 
-					tCalChksum = strtoul((char*)pCmdPhaser->mCRC,0,16);
-					tCmdPtr = 0;
-					if((pCmdPhaser->mCRC[0] == 'X' &&pCmdPhaser->mCRC[1] == 'X' &&pCmdPhaser->mCRC[2] == 'X' && pCmdPhaser->mCRC[3] == 'X'))
+					uint32_t tCalChksum = 0;
+					const bool tSumRead = protoHex_Read(pCmdPhaser->mCRC, PROTO_PACKET_SUM_DIGITS, &tCalChksum);
+					pCmdPhaser->mFieldPtr = 0;
+					pCmdPhaser->mCmdParserState = RST;			// Hold the command until cmdParser_Init
+					*pConsumed = i + 1;
+					if(memcmp(pCmdPhaser->mCRC, PROTO_PACKET_NO_SUM, PROTO_PACKET_SUM_DIGITS) == 0)
 					{
 						#if CONFIG_MI_EVK_CP_DBG	
 						ESP_LOGW(CPTAG,CP_WARN_INPUT_CRC_NULL);
 						#endif
-						return 0;
+						return CP_CMD_READY;
 					}
 
-					if(tInputChksum ==  tCalChksum)
+					// The CRC field holds the 16 bit sum
+					if(tSumRead && ((uint16_t)pCmdPhaser->mChksum == tCalChksum))
 					{
 						#if CONFIG_MI_EVK_CP_DBG
 						ESP_LOGI(CPTAG,CP_INFO_CRC_OK);
 						#endif
-						return 0;
+						return CP_CMD_READY;
 					}
 					else
 					{
 						#if CONFIG_MI_EVK_CP_DBG	
 						ESP_LOGE(CPTAG,CP_ERR_CRC_FAIL);
-						ESP_LOGE(CPTAG,CP_ERR_CRC_FAIL_INFO, tCalChksum,tInputChksum);
+						ESP_LOGE(CPTAG,CP_ERR_CRC_FAIL_INFO, tCalChksum,pCmdPhaser->mChksum);
 						#endif
-						return -1;
+						return CP_CMD_CRC_FAIL;
 					}// End if-else
 				}// End if
 				
 			break;
 
+			// A parsed command waits for cmdParser_Init
+			case RST:
+				*pConsumed = i;
+				return CP_CMD_PENDING;
+
 			// Reset phaser for any invalid state.
 			default:
 				#if CONFIG_MI_EVK_CP_DBG	
 				ESP_LOGE(SPTAG,CP_ERR_STATE);
 				#endif
-				pCmdPhaser->mCmdParserState = START_CHAR;
 				cmdParser_Init(pCmdPhaser);
 			break;
 		}//End switch
 	}
-	return 0;
-}// cmdParser_PharseCmd
+	*pConsumed = pInputSize;
+	return CP_CMD_PENDING;
+}// cmdParser_FeedCmd
+
+
+ /******************************************************************************
+ * @brief       cmdParser_CommitBatch
+ * @param       pCmdPhaser - cmdParser object holding a BRWR command
+ * 				pAckBuff - Pointer to ACK buffer
+ * 				pDataLen - Size of the data field
+ * @return      Length of ACK buffer
+ * @details     Execute the ops of a BRWR batch in order and construct the ACK.
+ * 				Data: [count] {[op][addr][value LSB][value MSB]} x count [CRC16 LSB][CRC16 MSB]
+ * 				ACK:  [status][count] {[op][addr][value LSB][value MSB]} x count [CRC16 LSB][CRC16 MSB]
+ * 				The CRC16 covers the bytes before it. Nothing is executed on a bad length or CRC.
+ *****************************************************************************/
+static uint8_t cmdParser_CommitBatch(const cmdPhaser* pCmdPhaser, uint8_t* pAckBuff, const uint32_t pDataLen)
+{
+	const uint8_t* pIn = pCmdPhaser->mData;
+	uint8_t* pOut = &pAckBuff[PROTO_PACKET_DATA];
+	uint8_t tStatus = BRWR_STATUS_OK;
+	uint8_t tCount = pIn[0];
+
+	if (tCount > BRWR_MAX_OPS || pDataLen != 1 + tCount * BRWR_OP_SIZE + 2)
+	{
+		tStatus = BRWR_STATUS_BAD_LEN;
+	}
+	else if (getCRC16(pIn, pDataLen - 2) != (pIn[pDataLen - 2] | (pIn[pDataLen - 1] << 8)))
+	{
+		tStatus = BRWR_STATUS_BAD_CRC;
+	}// End if-else
 
+	if (tStatus != BRWR_STATUS_OK)
+	{
+		tCount = 0;
+	}// End if
+
+	pOut[0] = tStatus;
+	pOut[1] = tCount;
+	pOut += 2;
+	pIn += 1;
+
+	for (uint8_t i = 0; i < tCount; i++, pIn += BRWR_OP_SIZE, pOut += BRWR_OP_SIZE)
+	{
+		const uint8_t tOp = pIn[0];
+		const uint8_t tAddr = pIn[1];
+		uint16_t tValue = pIn[2] | (pIn[3] << 8);
+
+		if (tOp == BRWR_OP_WRITE)
+		{
+			regMap_Write(tAddr, (uint8_t)tValue);
+		}
+		else if (tOp == BRWR_OP_READ)
+		{
+			tValue = regMap_Read(tAddr);
+		}// End if-else
+
+		pOut[0] = (tOp == BRWR_OP_READ || tOp == BRWR_OP_WRITE) ? tOp : (tOp | BRWR_OP_REJECTED);
+		pOut[1] = tAddr;
+		pOut[2] = (uint8_t)(tValue & 0xFF);
+		pOut[3] = (uint8_t)(tValue >> 8);
+	}// End for
+
+	const uint16_t tCRC16 = getCRC16(&pAckBuff[PROTO_PACKET_DATA], pOut - &pAckBuff[PROTO_PACKET_DATA]);
+	*pOut++ = (uint8_t)(tCRC16 & 0xFF);
+	*pOut++ = (uint8_t)(tCRC16 >> 8);
+
+	return protoPacket_Encode(pAckBuff, PROTO_CMD_BRWR, pOut - &pAckBuff[PROTO_PACKET_DATA], true);
+}// cmdParser_CommitBatch
+
+ /******************************************************************************
+ * @brief       cmdParser_CommitCorrection
+ * @param       pCmdPhaser - cmdParser object
+ * 				pAckBuff - Pointer to ACK buffer
+ * 				pDataLen - Size of the data field
+ * @return      Length of ACK buffer
+ * @details     Execute a CORR operation on the per-pixel correction map.
+ * 				Data: [op][first LSB][first MSB][count] {[gain LSB][gain MSB][offset LSB][offset MSB]} x count [CRC16 LSB][CRC16 MSB]
+ * 				ACK:  [status][state][saved][written LSB][written MSB][CRC16 LSB][CRC16 MSB]
+ * 				The CRC16 covers the bytes before it. Nothing is executed on a bad length or CRC.
+ *****************************************************************************/
+static uint8_t cmdParser_CommitCorrection(const cmdPhaser* pCmdPhaser, uint8_t* pAckBuff, const uint32_t pDataLen)
+{
+	const uint8_t* pIn = pCmdPhaser->mData;
+	uint8_t* pOut = &pAckBuff[PROTO_PACKET_DATA];
+	uint8_t tStatus;
+	uint8_t tState;
+	bool tSaved;
+	uint16_t tWritten;
+
+	if (pDataLen < CORR_HEAD_SIZE + 2 || pDataLen != CORR_HEAD_SIZE + pIn[3] * CORR_ENTRY_SIZE + 2)
+	{
+		tStatus = CORR_STATUS_BAD_LEN;
+	}
+	else if (getCRC16(pIn, pDataLen - 2) != (pIn[pDataLen - 2] | (pIn[pDataLen - 1] << 8)))
+	{
+		tStatus = CORR_STATUS_BAD_CRC;
+	}
+	else
+	{
+		switch (pIn[0])
+		{
+		case CORR_OP_STATUS:
+			tStatus = CORR_STATUS_OK;
+			break;
+		case CORR_OP_WRITE:
+			tStatus = pixelCorrect_Write((uint16_t)(pIn[1] | (pIn[2] << 8)), pIn[3], &pIn[CORR_HEAD_SIZE]);
+			break;
+		case CORR_OP_COMMIT:
+			tStatus = pixelCorrect_Commit();
+			break;
+		case CORR_OP_CLEAR:
+			tStatus = pixelCorrect_Clear();
+			break;
+		default:
+			tStatus = CORR_STATUS_BAD_RANGE;
+			break;
+		}// End switch
+	}// End if-else
+
+	pixelCorrect_GetStatus(&tState, &tSaved, &tWritten);
+	pOut[0] = tStatus;
+	pOut[1] = tState;
+	pOut[2] = tSaved ? 1 : 0;
+	pOut[3] = (uint8_t)(tWritten & 0xFF);
+	pOut[4] = (uint8_t)(tWritten >> 8);
+	pOut += 5;
+
+	const uint16_t tCRC16 = getCRC16(&pAckBuff[PROTO_PACKET_DATA], pOut - &pAckBuff[PROTO_PACKET_DATA]);
+	*pOut++ = (uint8_t)(tCRC16 & 0xFF);
+	*pOut++ = (uint8_t)(tCRC16 >> 8);
+
+	return protoPacket_Encode(pAckBuff, PROTO_CMD_CORR, pOut - &pAckBuff[PROTO_PACKET_DATA], true);
+}// cmdParser_CommitCorrection
 
  /******************************************************************************
  * @brief       cmdParser_CommitCmd
  * @param       pCmdPhaser - cmdParser object
  * 				pAckBuff - Pointer to ACK buffer
  * @return      Length of ACK buffer
- * @details     Execute commands and construct ACK messages
+ * @details     Execute commands and construct ACK messages with protoPacket_Encode.
+ * 				The acks that always sent the NUL after the packet still do.
  *****************************************************************************/
 uint8_t cmdParser_CommitCmd(const cmdPhaser* pCmdPhaser, uint8_t* pAckBuff)
 {
@@ -293,8 +522,8 @@ uint8_t cmdParser_CommitCmd(const cmdPhaser* pCmdPhaser, uint8_t* pAckBuff)
 	char tVal[3];
 	int tAddrInt = 0;
 	int tValInt = 0;
-	uint32_t tCmdLenInt = strtoul((char*)pCmdPhaser->mCmdLen,0,16);
-	
+	uint32_t tCmdLenInt = 0;
+
 	if(!pAckBuff)
 	{
 		return 0;
@@ -304,8 +533,20 @@ uint8_t cmdParser_CommitCmd(const cmdPhaser* pCmdPhaser, uint8_t* pAckBuff)
 	{
 		return 0;
 	}// End if
+	protoHex_Read(pCmdPhaser->mCmdLen, PROTO_PACKET_LEN_DIGITS, &tCmdLenInt);		// Checked by cmdParser_FeedCmd
 
-	if(!strcmp((char*) pCmdPhaser->mCmd,CMD_WREG))
+	// One compare of the command word, not a string compare per command
+	switch(PROTO_CMD_CODE(pCmdPhaser->mCmd))
+	{
+	case PROTO_CMD_BRWR:
+	{
+		return cmdParser_CommitBatch(pCmdPhaser, pAckBuff, tCmdLenInt - 8);
+	}
+	case PROTO_CMD_CORR:
+	{
+		return cmdParser_CommitCorrection(pCmdPhaser, pAckBuff, tCmdLenInt - 8);
+	}
+	case PROTO_CMD_WREG:
 	{
 #if CONFIG_MI_EVK_CP_DBG
 		ESP_LOGI(CPTAG,SP_CMD_WREG_INFO);
@@ -321,31 +562,15 @@ uint8_t cmdParser_CommitCmd(const cmdPhaser* pCmdPhaser, uint8_t* pAckBuff)
 		tAddrInt = toHex((char*)tAddr);
 		tValInt = toHex((char*)tVal);
 
-		// Handle quadrant registers (0xC0-0xC1 are writable)
-		if (isQuadrantRegister(tAddrInt)) {
-			quadrant_WriteRegister(tAddrInt, tValInt);
-			printf("WREG quadrant register 0x%02X = %d\n", tAddrInt, tValInt);
-		} else {
-			Acces_Write_Reg(tAddrInt,tValInt);
-		}
-
-		pAckBuff[0]=' ';
-		pAckBuff[1]=' ';
-		pAckBuff[2]=' ';
-		pAckBuff[3]='#';
-		pAckBuff[4]='0';
-		pAckBuff[5]='0';
-		pAckBuff[6]='0';
-		pAckBuff[7]='8';
-		pAckBuff[8]='W';
-		pAckBuff[9]='R';
-		pAckBuff[10]='E';
-		pAckBuff[11]='G';
-		sprintf((char *)&pAckBuff[12], "%04X", getCRC(pAckBuff+4,8));	// Add CRC field
-		pAckBuff[17]=0;
-		return 17;
+		// Read only registers ignore the write, the ack is sent anyway
+		const regDesc_t* pReg = regMap_Get((uint8_t)tAddrInt);
+		if (regMap_Write((uint8_t)tAddrInt, (uint8_t)tValInt) && pReg->pNvsKey != NULL) {
+			printf("WREG %s 0x%02X = %d\n", pReg->pName, tAddrInt, tValInt);
+		}
+
+		return protoPacket_Encode(pAckBuff, PROTO_CMD_WREG, 0, true) + 1;
 	}
-	else if(!strcmp((char*) pCmdPhaser->mCmd,CMD_RREG))
+	case PROTO_CMD_RREG:
 	{
 #if CONFIG_MI_EVK_CP_DBG
 		ESP_LOGI(CPTAG,SP_CMD_RREG_INFO);
@@ -355,88 +580,25 @@ uint8_t cmdParser_CommitCmd(const cmdPhaser* pCmdPhaser, uint8_t* pAckBuff)
 		tAddr[2] = 0;
 		tAddrInt = toHex((char*)tAddr);
 
-		// Handle quadrant registers (16-bit values for 0xC2-0xC9, 8-bit for 0xC0-0xC1)
-		if (isQuadrantRegister(tAddrInt)) {
-			uint16_t rd16 = quadrant_ReadRegister(tAddrInt);
-			printf("RREG quadrant register 0x%02X = %u\n", tAddrInt, rd16);
-
-			pAckBuff[0]=' ';
-			pAckBuff[1]=' ';
-			pAckBuff[2]=' ';
-			pAckBuff[3]='#';
-			pAckBuff[4]='0';
-			pAckBuff[5]='0';
-			pAckBuff[6]='0';
-			pAckBuff[7]='C';  // Length = 12 (0x0C): 4 cmd + 4 data + 4 CRC
-			pAckBuff[8]='R';
-			pAckBuff[9]='R';
-			pAckBuff[10]='E';
-			pAckBuff[11]='G';
-			sprintf((char *)&pAckBuff[12], "%04X", rd16);
-			sprintf((char *)&pAckBuff[16], "%04X", getCRC(pAckBuff+4,12));
-			pAckBuff[20]=0;
-			return 21;
-		}
-
-		uint8_t rd = 0;
-		if(tAddrInt == 0xB2 || tAddrInt == 0xB3)
-		{
-			rd = ApplicationReadVersion(tAddrInt);
-		}
-		else
-		{
-			rd = Acces_Read_Reg(tAddrInt);
-		}
-
-		pAckBuff[0]=' ';
-		pAckBuff[1]=' ';
-		pAckBuff[2]=' ';
-		pAckBuff[3]='#';
-		pAckBuff[4]='0';
-		pAckBuff[5]='0';
-		pAckBuff[6]='0';
-		pAckBuff[7]='A';
-		pAckBuff[8]='R';
-		pAckBuff[9]='R';
-		pAckBuff[10]='E';
-		pAckBuff[11]='G';
-
-		sprintf((char *)&pAckBuff[12], "%02X", rd);
-		sprintf((char *)&pAckBuff[14], "%04X", getCRC(pAckBuff+4,10));	// Add CRC field
-		pAckBuff[18]=0;
-		return 19;
-	}
-	else if (!strcmp((char*) pCmdPhaser->mCmd,CMD_RRSE))
-	{
-		uint16_t tRegCntX2 = (tCmdLenInt - 8 - 2);
-		uint16_t j = 12;
+		// Firmware registers answer 4 hex digits, the SenXor ones 2
+		if (regMap_Get((uint8_t)tAddrInt)->mWidth == REG_16) {
+			uint16_t rd16 = regMap_Read((uint8_t)tAddrInt);
 
-		// First pass: calculate response length (quadrant regs need 6 bytes, others need 4)
-		uint16_t tAckLen = 8;  // Start with CMD (4) + CRC (4)
-		for (size_t i = 0; i < tRegCntX2; i+=2) {
-			tAddr[0] = pCmdPhaser->mData[i];
-			tAddr[1] = pCmdPhaser->mData[i+1];
-			tAddr[2] = 0;
-			tAddrInt = toHex((char*)tAddr);
-			if (isQuadrantRegister(tAddrInt)) {
-				tAckLen += 6;  // 2 addr + 4 value
-			} else {
-				tAckLen += 4;  // 2 addr + 2 value
-			}
+			sprintf((char *)&pAckBuff[PROTO_PACKET_DATA], "%04X", rd16);
+			return protoPacket_Encode(pAckBuff, PROTO_CMD_RREG, 4, true) + 1;
 		}
 
-		pAckBuff[0]=' ';
-		pAckBuff[1]=' ';
-		pAckBuff[2]=' ';
-		pAckBuff[3]='#';
+		uint8_t rd = (uint8_t)regMap_Read((uint8_t)tAddrInt);
 
-		sprintf((char *)&pAckBuff[4], "%04X", tAckLen);												// Add Length
-
-		pAckBuff[8]='R';
-		pAckBuff[9]='R';
-		pAckBuff[10]='S';
-		pAckBuff[11]='E';
+		sprintf((char *)&pAckBuff[PROTO_PACKET_DATA], "%02X", rd);
+		return protoPacket_Encode(pAckBuff, PROTO_CMD_RREG, 2, true) + 1;
+	}
+	case PROTO_CMD_RRSE:
+	{
+		uint16_t tRegCntX2 = (tCmdLenInt - 8 - 2);
+		uint16_t j = PROTO_PACKET_DATA;
 
+		// 2 address digits and the value digits of each register
 		for (size_t i = 0; i < tRegCntX2; i+=2)
 		{
 			tAddr[0] = pCmdPhaser->mData[i];
@@ -447,27 +609,14 @@ uint8_t cmdParser_CommitCmd(const cmdPhaser* pCmdPhaser, uint8_t* pAckBuff)
 			sprintf((char *)&pAckBuff[j], "%02X", tAddrInt);
 			j += 2;
 
-			if (isQuadrantRegister(tAddrInt)) {
-				uint16_t rd16 = quadrant_ReadRegister(tAddrInt);
-				printf("RRSE quadrant register 0x%02X = %u\n", tAddrInt, rd16);
-				sprintf((char *)&pAckBuff[j], "%04X", rd16);
-				j += 4;
-			} else if(tAddrInt == 0xB2 || tAddrInt == 0xB3) {
-				uint8_t tRd = ApplicationReadVersion(tAddrInt);
-				sprintf((char *)&pAckBuff[j], "%02X", tRd);
-				j += 2;
-			} else {
-				uint8_t tRd = Acces_Read_Reg(tAddrInt);
-				sprintf((char *)&pAckBuff[j], "%02X", tRd);
-				j += 2;
-			}
+			const regDesc_t* pReg = regMap_Get((uint8_t)tAddrInt);
+			sprintf((char *)&pAckBuff[j], "%0*X", pReg->mWidth, pReg->pRead((uint8_t)tAddrInt));
+			j += pReg->mWidth;
 		}// End for
 
-		sprintf((char *)&pAckBuff[j], "%04X", getCRC(pAckBuff+4,tAckLen));				// Add CRC
-
-		return tAckLen + 8;
+		return protoPacket_Encode(pAckBuff, PROTO_CMD_RRSE, j - PROTO_PACKET_DATA, true);
 	}
-	else if (!strcmp((char*) pCmdPhaser->mCmd, CMD_POLL))
+	case PROTO_CMD_POLL:
 	{
 		// POLL command: set polling frequency for quadrant register updates
 		// Only valid when frame port (3333) is NOT connected
@@ -492,27 +641,616 @@ uint8_t cmdParser_CommitCmd(const cmdPhaser* pCmdPhaser, uint8_t* pAckBuff)
 		printf("POLL frequency set to %d Hz\n", tValInt);
 
 		// Build ack:    #0008POLL[CRC]
-		pAckBuff[0]=' ';
-		pAckBuff[1]=' ';
-		pAckBuff[2]=' ';
-		pAckBuff[3]='#';
-		pAckBuff[4]='0';
-		pAckBuff[5]='0';
-		pAckBuff[6]='0';
-		pAckBuff[7]='8';
-		pAckBuff[8]='P';
-		pAckBuff[9]='O';
-		pAckBuff[10]='L';
-		pAckBuff[11]='L';
-		sprintf((char *)&pAckBuff[12], "%04X", getCRC(pAckBuff+4,8));
-		pAckBuff[16]=0;
-		return 17;
+		return protoPacket_Encode(pAckBuff, PROTO_CMD_POLL, 0, true) + 1;
 	}
-	else
+	case PROTO_CMD_STAT:
+	{
+		// STAT command: per-client counters of the frame stream (port 3333)
+		// Response:    #LLLLSTAT[NN]{[II][bytes sent][frames sent][frames dropped][ms blocked]}...[CRC]
+		uint16_t j = PROTO_PACKET_DATA + 2;
+		uint8_t tClientCnt = 0;
+		char tCnt[3];
+		uint32_t tBytes, tFrames, tDropped, tBlocked;
+
+		for (uint8_t i = 0; i < CONFIG_MI_TCP_MAX_CLIENTS; i++)
+		{
+			if (tcpServerGetClientStats(i, &tBytes, &tFrames, &tDropped, &tBlocked))
+			{
+				sprintf((char *)&pAckBuff[j], "%02X%08lX%08lX%08lX%08lX", i,
+						(unsigned long)tBytes, (unsigned long)tFrames, (unsigned long)tDropped, (unsigned long)tBlocked);
+				j += 34;
+				++tClientCnt;
+			}
+		}// End for
+
+		sprintf(tCnt, "%02X", tClientCnt);
+		pAckBuff[PROTO_PACKET_DATA]=tCnt[0];
+		pAckBuff[PROTO_PACKET_DATA + 1]=tCnt[1];
+
+		return protoPacket_Encode(pAckBuff, PROTO_CMD_STAT, j - PROTO_PACKET_DATA, true);
+	}
+	case PROTO_CMD_SFMT:
+	{
+		// SFMT command: select the frame stream format of this host (01 = raw frames, 02 = framed with header)
+		// and optionally the v2 payload encoding (00 = raw, 01 = delta, 02 = delta + LZ, 03/04/05 = 12/14/8 bit packed)
+		int tEncInt = 0;
+		const char* pAddr = cmdServerGetCurrentAddr();
+
+		tVal[0] = pCmdPhaser->mData[0];
+		tVal[1] = pCmdPhaser->mData[1];
+		tVal[2] = 0;
+		tValInt = toHex((char*)tVal);
+
+		if (tCmdLenInt >= 4 + 4 + 4) {
+			tVal[0] = pCmdPhaser->mData[2];
+			tVal[1] = pCmdPhaser->mData[3];
+			tEncInt = toHex((char*)tVal);
+		}
+
+		if ((tValInt != 1 && tValInt != 2) || tEncInt < 0 || tEncInt > 5 || (tValInt == 1 && tEncInt != 0)) {
+			ESP_LOGE(CPTAG, "SFMT: unsupported stream format");
+			return 0;
+		}
+
+		if (pAddr == NULL) {
+			ESP_LOGW(CPTAG, "SFMT rejected: no command client");
+			return 0;
+		}
+
+		uint8_t tFormat = (uint8_t)tValInt;
+		uint8_t tEncoding = (uint8_t)tEncInt;
+		if (tcpServerSetStreamFormat(pAddr, &tFormat, &tEncoding) < 0) {
+			ESP_LOGE(CPTAG, "SFMT: no free client entry");
+			return 0;
+		}
+		ESP_LOGI(CPTAG, "Stream format of %s set to v%d, encoding %d", pAddr, tFormat, tEncoding);
+
+		// Build ack:    #000CSFMT[VV][EE][CRC]
+		sprintf((char *)&pAckBuff[PROTO_PACKET_DATA], "%02X%02X", tFormat, tEncoding);
+		return protoPacket_Encode(pAckBuff, PROTO_CMD_SFMT, 4, true) + 1;
+	}
+	case PROTO_CMD_SHAP:
+	{
+		// SHAP command: shape the frame stream of this host (port 3333 clients with the address of this command client)
+		// Data:        [XX][YY][WW][HH][DD][RR] window in the 80x62 image (WW = 00: whole image), DD: 01/02/04 max-pool, RR: send every RR-th frame
+		uint8_t tShape[6];
+		const uint32_t tDataLen = (tCmdLenInt >= 8) ? tCmdLenInt - 8 : 0;
+		const char* pAddr = cmdServerGetCurrentAddr();
+
+		if (tDataLen != sizeof(tShape) * 2) {
+			ESP_LOGE(CPTAG, "SHAP: shape must be 6 bytes");
+			return 0;
+		}
+
+		tVal[2] = 0;
+		for (uint8_t i = 0; i < sizeof(tShape); i++) {
+			tVal[0] = pCmdPhaser->mData[i * 2];
+			tVal[1] = pCmdPhaser->mData[i * 2 + 1];
+			tValInt = toHex((char*)tVal);
+			if (tValInt < 0) {
+				ESP_LOGE(CPTAG, "SHAP: invalid shape");
+				return 0;
+			}
+			tShape[i] = (uint8_t)tValInt;
+		}// End for
+
+		if (pAddr == NULL) {
+			ESP_LOGW(CPTAG, "SHAP rejected: no command client");
+			return 0;
+		}
+
+		const int tClients = tcpServerSetStreamShape(pAddr, tShape);
+		if (tClients < 0) {
+			ESP_LOGE(CPTAG, "SHAP: unsupported shape");
+			return 0;
+		}
+		ESP_LOGD(CPTAG, "Stream shape of %s: %dx%d at %d,%d, 1:%d max-pool, every %d frames, %d clients", pAddr, tShape[2], tShape[3], tShape[0], tShape[1], tShape[4], tShape[5], tClients);
+
+		// Build ack:    #0016SHAP[XX][YY][WW][HH][DD][RR][NN][CRC]
+		for (uint8_t i = 0; i < sizeof(tShape); i++) {
+			sprintf((char *)&pAckBuff[12 + i * 2], "%02X", tShape[i]);
+		}// End for
+		sprintf((char *)&pAckBuff[24], "%02X", (uint8_t)tClients);
+		return protoPacket_Encode(pAckBuff, PROTO_CMD_SHAP, 14, true) + 1;
+	}
+	case PROTO_CMD_SCRC:
+	{
+		// SCRC command: select the integrity check of the frame packets
+		// Data:        [PP][MM] PP: 00 = USB GFRA, 01 = TCP v2 stream. MM: 00 = 16 bit sum, 01 = CRC32
+		int tModeInt = -1;
+
+		tVal[0] = pCmdPhaser->mData[0];
+		tVal[1] = pCmdPhaser->mData[1];
+		tVal[2] = 0;
+		tValInt = (tCmdLenInt >= 4 + 4 + 4) ? toHex((char*)tVal) : -1;
+		tVal[0] = pCmdPhaser->mData[2];
+		tVal[1] = pCmdPhaser->mData[3];
+		tModeInt = (tCmdLenInt >= 4 + 4 + 4) ? toHex((char*)tVal) : -1;
+
+		if (tValInt < 0 || tValInt > 1 || tModeInt < 0 || tModeInt >= CRC_MODE_COUNT) {
+			ESP_LOGE(CPTAG, "SCRC: unsupported integrity mode");
+			return 0;
+		}
+
+		if (tValInt == 0) {
+			usbSerialSetIntegrity((uint8_t)tModeInt);
+			tModeInt = usbSerialGetIntegrity();
+		} else {
+			// TCP: the frame port clients of this host, as SFMT
+			uint8_t tMode = (uint8_t)tModeInt;
+			if (tcpServerSetStreamIntegrity(cmdServerGetCurrentAddr(), &tMode) < 0) {
+				ESP_LOGW(CPTAG, "SCRC rejected: no command client or free client entry");
+				return 0;
+			}
+			tModeInt = tMode;
+		}
+
+		// Build ack:    #000CSCRC[PP][MM][CRC]
+		sprintf((char *)&pAckBuff[PROTO_PACKET_DATA], "%02X%02X", tValInt, tModeInt);
+		return protoPacket_Encode(pAckBuff, PROTO_CMD_SCRC, 4, true) + 1;
+	}
+	case PROTO_CMD_CAPS:
+	{
+		// CAPS command: time spent in the frame capture interrupts since the last CAPS
+		// Response:    #002ACAPS[MM][blocks][avg cycles][max cycles][overruns][CRC]
+		captureIsrStats_t tStats;
+		Capture_GetIsrStats(&tStats, true);
+
+		sprintf((char *)&pAckBuff[PROTO_PACKET_DATA], "%02X%08lX%08lX%08lX%08lX", tStats.mMode,
+				(unsigned long)tStats.mBlocks, (unsigned long)tStats.mAvgCycles,
+				(unsigned long)tStats.mMaxCycles, (unsigned long)tStats.mOverruns);
+		return protoPacket_Encode(pAckBuff, PROTO_CMD_CAPS, 34, true);
+	}
+#if CONFIG_MI_LATENCY_TRACE_EN
+	case PROTO_CMD_LATS:
+	{
+		// LATS command: latency of one frame pipeline stage over the frames still traced
+		// Data:        [SS] latencyStage_t, or LAT_STAT_TOTAL
+		// Response:    #002ELATS[SS][count][min][avg][p99][max][CRC], times in us
+		latencyStats_t tStats[LAT_STAT_COUNT];
+
+		tVal[0] = pCmdPhaser->mData[0];
+		tVal[1] = pCmdPhaser->mData[1];
+		tVal[2] = 0;
+		tValInt = (tCmdLenInt >= 4 + 4 + 2) ? toHex((char*)tVal) : -1;
+
+		if (tValInt < 0 || tValInt >= LAT_STAT_COUNT) {
+			ESP_LOGE(CPTAG, "LATS: unknown stage");
+			return 0;
+		}
+
+		LatencyTrace_GetStats(tStats);
+
+		sprintf((char *)&pAckBuff[PROTO_PACKET_DATA], "%02X%04X%08lX%08lX%08lX%08lX", tValInt, tStats[tValInt].mCount,
+				(unsigned long)tStats[tValInt].mMinUs, (unsigned long)tStats[tValInt].mAvgUs,
+				(unsigned long)tStats[tValInt].mP99Us, (unsigned long)tStats[tValInt].mMaxUs);
+		return protoPacket_Encode(pAckBuff, PROTO_CMD_LATS, 38, true);
+	}
+#endif
+#if CONFIG_MI_REC_EN
+	case PROTO_CMD_RECC:
+	{
+		// RECC command: control the frame recorder
+		// Data:        [OO]{[II][TTTT]} OO: 00 status, 01 trigger, 02 arm, 03 ROI trigger on slot II (FF off) at level TTTT
+		// Response:    #0022RECC[SS][TT][FFFFFFFF][LLLLLLLL][II][TTTT][CRC]
+		char tVal16[5];
+		uint8_t tState, tTrigger, tRoi;
+		uint32_t tFrames, tClipLen;
+		uint16_t tThreshold;
+
+		tVal[0] = pCmdPhaser->mData[0];
+		tVal[1] = pCmdPhaser->mData[1];
+		tVal[2] = 0;
+		tValInt = (tCmdLenInt >= 4 + 4 + 2) ? toHex((char*)tVal) : -1;
+
+		if (tValInt == RECC_OP_TRIGGER) {
+			frameRecorderTrigger(RECC_TRIGGER_COMMAND);
+		} else if (tValInt == RECC_OP_ARM) {
+			frameRecorderArm();
+		} else if (tValInt == RECC_OP_ROI && tCmdLenInt >= 4 + 4 + 8) {
+			tVal[0] = pCmdPhaser->mData[2];
+			tVal[1] = pCmdPhaser->mData[3];
+			tAddrInt = toHex((char*)tVal);
+			tVal16[4] = 0;
+			memcpy(tVal16, &pCmdPhaser->mData[4], 4);
+			const int tLevel = toHex(tVal16);
+			if (tAddrInt < 0 || tLevel < 0 || !frameRecorderSetRoiTrigger((uint8_t)tAddrInt, (uint16_t)tLevel)) {
+				ESP_LOGE(CPTAG, "RECC: invalid ROI trigger");
+				return 0;
+			}
+		} else if (tValInt != RECC_OP_STATUS) {
+			ESP_LOGE(CPTAG, "RECC: unknown operation");
+			return 0;
+		}
+
+		frameRecorderGetStatus(&tState, &tTrigger, &tFrames, &tClipLen, &tRoi, &tThreshold);
+
+		sprintf((char *)&pAckBuff[PROTO_PACKET_DATA], "%02X%02X%08lX%08lX%02X%04X", tState, tTrigger,
+				(unsigned long)tFrames, (unsigned long)tClipLen, tRoi, tThreshold);
+		return protoPacket_Encode(pAckBuff, PROTO_CMD_RECC, 26, true);
+	}
+	case PROTO_CMD_RECD:
+	{
+		// RECD command: download the frozen clip, the raw bytes follow the ack
+		// Data:        {[OOOOOOOO][LLLLLLLL]} byte offset and length, all of the clip if omitted or LLLLLLLL = 0
+		// Response:    #0018RECD[OOOOOOOO][LLLLLLLL][CRC], then LLLLLLLL clip bytes and their CRC32 as 8 hex digits
+		char tVal32[9];
+		uint8_t tState, tTrigger, tRoi;
+		uint32_t tFrames, tClipLen;
+		uint16_t tThreshold;
+		uint32_t tOffset = 0;
+		uint32_t tLen = 0;
+
+		if (tCmdLenInt >= 4 + 4 + 16) {
+			tVal32[8] = 0;
+			memcpy(tVal32, &pCmdPhaser->mData[0], 8);
+			tOffset = strtoul(tVal32, 0, 16);
+			memcpy(tVal32, &pCmdPhaser->mData[8], 8);
+			tLen = strtoul(tVal32, 0, 16);
+		}
+
+		// Pin the clip, the transport ends the download once the bytes are out
+		if (!frameRecorderBeginDownload()) {
+			ESP_LOGW(CPTAG, "RECD rejected: no frozen clip");
+			return 0;
+		}
+
+		frameRecorderGetStatus(&tState, &tTrigger, &tFrames, &tClipLen, &tRoi, &tThreshold);
+		if (tOffset > tClipLen) {
+			tOffset = tClipLen;
+		}
+		if (tLen == 0 || tLen > tClipLen - tOffset) {
+			tLen = tClipLen - tOffset;
+		}
+
+		sprintf((char *)&pAckBuff[PROTO_PACKET_DATA], "%08lX%08lX", (unsigned long)tOffset, (unsigned long)tLen);
+		return protoPacket_Encode(pAckBuff, PROTO_CMD_RECD, 16, true);
+	}
+#endif
+	case PROTO_CMD_SUBS:
+	{
+		// SUBS command: push registers to this client on every new frame
+		// Data:        [IIII][TTTT][NN]{[AA]}... IIII: minimum interval (ms), TTTT: change threshold, NN = 00 unsubscribes
+		uint8_t tRegs[SUBS_MAX_REGS];
+		char tVal16[5];
+		const uint32_t tDataLen = (tCmdLenInt >= 8) ? tCmdLenInt - 8 : 0;
+
+		if (tDataLen < 10) {
+			ESP_LOGE(CPTAG, "SUBS: missing subscription");
+			return 0;
+		}
+
+		tVal16[4] = 0;
+		memcpy(tVal16, &pCmdPhaser->mData[0], 4);
+		const int tInterval = toHex(tVal16);
+		memcpy(tVal16, &pCmdPhaser->mData[4], 4);
+		const int tThreshold = toHex(tVal16);
+		tVal[0] = pCmdPhaser->mData[8];
+		tVal[1] = pCmdPhaser->mData[9];
+		tVal[2] = 0;
+		tValInt = toHex((char*)tVal);
+
+		if (tInterval < 0 || tThreshold < 0 || tValInt < 0 || tValInt > SUBS_MAX_REGS || tDataLen != 10 + (uint32_t)tValInt * 2) {
+			ESP_LOGE(CPTAG, "SUBS: register count does not match the data length");
+			return 0;
+		}
+
+		for (uint8_t i = 0; i < tValInt; i++) {
+			tVal[0] = pCmdPhaser->mData[10 + i * 2];
+			tVal[1] = pCmdPhaser->mData[10 + i * 2 + 1];
+			tAddrInt = toHex((char*)tVal);
+			if (tAddrInt < 0) {
+				ESP_LOGE(CPTAG, "SUBS: invalid register address");
+				return 0;
+			}
+			tRegs[i] = (uint8_t)tAddrInt;
+		}// End for
+
+		if (!cmdServerSubscribe(tRegs, tValInt, tInterval, tThreshold)) {
+			ESP_LOGW(CPTAG, "SUBS rejected: no command client");
+			return 0;
+		}
+
+		// Build ack:    #000ASUBS[NN][CRC]
+		sprintf((char *)&pAckBuff[PROTO_PACKET_DATA], "%02X", tValInt);
+		return protoPacket_Encode(pAckBuff, PROTO_CMD_SUBS, 2, true) + 1;
+	}
+	case PROTO_CMD_ROIW:
+	{
+		// ROIW command: define ROI slot II
+		// Data:        [II][TT][PP][NN]{[XX][YY]}... TT: 00 = clear, 01 = rectangle, 02 = polygon
+		uint8_t tRoi[4];
+		uint8_t tVertex[ROI_MAX_VERTICES * 2];
+		const uint32_t tDataLen = (tCmdLenInt >= 8) ? tCmdLenInt - 8 : 0;
+
+		if (tDataLen < 8) {
+			ESP_LOGE(CPTAG, "ROIW: missing ROI definition");
+			return 0;
+		}
+
+		tVal[2] = 0;
+		for (uint8_t i = 0; i < 4; i++) {
+			tVal[0] = pCmdPhaser->mData[i * 2];
+			tVal[1] = pCmdPhaser->mData[i * 2 + 1];
+			tRoi[i] = (uint8_t)toHex((char*)tVal);
+		}// End for
+
+		if (tRoi[3] > ROI_MAX_VERTICES || tDataLen != 8 + (uint32_t)tRoi[3] * 4) {
+			ESP_LOGE(CPTAG, "ROIW: vertex count does not match the data length");
+			return 0;
+		}
+
+		for (uint8_t i = 0; i < tRoi[3] * 2; i++) {
+			tVal[0] = pCmdPhaser->mData[8 + i * 2];
+			tVal[1] = pCmdPhaser->mData[8 + i * 2 + 1];
+			tVertex[i] = (uint8_t)toHex((char*)tVal);
+		}// End for
+
+		if (!roiEngine_SetRoi(tRoi[0], tRoi[1], tRoi[2], tRoi[3], tVertex)) {
+			return 0;
+		}
+
+		// Build ack:    #000AROIW[II][CRC]
+		sprintf((char *)&pAckBuff[PROTO_PACKET_DATA], "%02X", tRoi[0]);
+		return protoPacket_Encode(pAckBuff, PROTO_CMD_ROIW, 2, true) + 1;
+	}
+	case PROTO_CMD_ROIR:
+	{
+		// ROIR command: statistics of ROI slot II for the last frame
+		// Response:    #0022ROIR[II][min][max][mean][percentile][XX][YY][pixels][CRC]
+		tVal[0] = pCmdPhaser->mData[0];
+		tVal[1] = pCmdPhaser->mData[1];
+		tVal[2] = 0;
+		tValInt = toHex((char*)tVal);
+
+		if (tValInt < 0 || tValInt > 0xFF) {
+			ESP_LOGE(CPTAG, "ROIR: invalid ROI index");
+			return 0;
+		}
+
+		sprintf((char *)&pAckBuff[PROTO_PACKET_DATA], "%02X%04X%04X%04X%04X%02X%02X%04X", tValInt,
+				roiEngine_ReadStat(tValInt, REG_ROI_MIN), roiEngine_ReadStat(tValInt, REG_ROI_MAX),
+				roiEngine_ReadStat(tValInt, REG_ROI_MEAN), roiEngine_ReadStat(tValInt, REG_ROI_PCT),
+				roiEngine_ReadStat(tValInt, REG_ROI_HOTX), roiEngine_ReadStat(tValInt, REG_ROI_HOTY),
+				roiEngine_ReadStat(tValInt, REG_ROI_PIXELS));
+		return protoPacket_Encode(pAckBuff, PROTO_CMD_ROIR, 26, true) + 1;
+	}
+	case PROTO_CMD_SAVE:
+	{
+		// SAVE command: commit the quadrant and burner registers to NVS now
+		// Response:    #0008SAVE[CRC]
+		quadrant_SaveConfig();
+
+		return protoPacket_Encode(pAckBuff, PROTO_CMD_SAVE, 0, true);
+	}
+	case PROTO_CMD_BPIX:
+	{
+		// BPIX command: bad pixel map
+		// Data:        [OO]{[TTTT]} OO: 00 status, 01 calibrate with threshold TTTT (0000 default), 02 clear
+		// Response:    #000EBPIX[SS][NNNN][CRC]
+		char tVal16[5];
+		uint8_t tState;
+		uint16_t tCount;
+
+		tVal[0] = pCmdPhaser->mData[0];
+		tVal[1] = pCmdPhaser->mData[1];
+		tVal[2] = 0;
+		tValInt = (tCmdLenInt >= 4 + 4 + 2) ? toHex((char*)tVal) : -1;
+
+		if (tValInt == BPIX_OP_CALIBRATE) {
+			int tLevel = 0;
+			if (tCmdLenInt >= 4 + 4 + 6) {
+				tVal16[4] = 0;
+				memcpy(tVal16, &pCmdPhaser->mData[2], 4);
+				tLevel = toHex(tVal16);
+			}
+			if (tLevel < 0 || !pixelMap_Calibrate((uint16_t)tLevel)) {
+				ESP_LOGE(CPTAG, "BPIX: calibration not started");
+				return 0;
+			}
+		} else if (tValInt == BPIX_OP_CLEAR) {
+			pixelMap_Clear();
+		} else if (tValInt != BPIX_OP_STATUS) {
+			ESP_LOGE(CPTAG, "BPIX: unknown operation");
+			return 0;
+		}
+
+		pixelMap_GetStatus(&tState, &tCount);
+
+		sprintf((char *)&pAckBuff[PROTO_PACKET_DATA], "%02X%04X", tState, tCount);
+		return protoPacket_Encode(pAckBuff, PROTO_CMD_BPIX, 6, true);
+	}
+	case PROTO_CMD_BNCH:
+	{
+		// BNCH command: run one on-target microbenchmark, blocks this port for about 50 ms
+		// Data:        [TT] benchTest_t
+		// Response:    #0022BNCH[TT][iterations][cycles each][bytes per second][CRC]
+		uint32_t tIterations, tCycles, tBytesPerSec;
+
+		tVal[0] = pCmdPhaser->mData[0];
+		tVal[1] = pCmdPhaser->mData[1];
+		tVal[2] = 0;
+		tValInt = (tCmdLenInt >= 4 + 4 + 2) ? toHex((char*)tVal) : -1;
+
+		if (tValInt < 0 || !microBench_Run((uint8_t)tValInt, &tIterations, &tCycles, &tBytesPerSec)) {
+			ESP_LOGE(CPTAG, "BNCH: test not run");
+			return 0;
+		}
+
+		sprintf((char *)&pAckBuff[PROTO_PACKET_DATA], "%02X%08lX%08lX%08lX", tValInt,
+				(unsigned long)tIterations, (unsigned long)tCycles, (unsigned long)tBytesPerSec);
+		return protoPacket_Encode(pAckBuff, PROTO_CMD_BNCH, 26, true);
+	}
+	case PROTO_CMD_SYST:
+	{
+		// SYST command: newest telemetry sample, taken every CONFIG_MI_SYS_STATS_PERIOD_S
+		// Response:    #0052SYST[uptime s][internal free][internal min][psram free][dropped][deepest]
+		//              then [cpu permille][stack free] of each mSystTask, FFFF if not running[CRC]
+		uint32_t tUptime, tIntFree, tIntMin, tPsramFree, tDropped;
+		uint8_t tDeepest;
+
+		if (!sysStats_GetSummary(&tUptime, &tIntFree, &tIntMin, &tPsramFree, &tDropped, &tDeepest)) {
+			ESP_LOGE(CPTAG, "SYST: no sample");
+			return 0;
+		}
+
+		sprintf((char *)&pAckBuff[PROTO_PACKET_DATA], "%08lX%08lX%08lX%08lX%08lX%02X",
+				(unsigned long)tUptime, (unsigned long)tIntFree, (unsigned long)tIntMin,
+				(unsigned long)tPsramFree, (unsigned long)tDropped, tDeepest);
+		for (uint8_t i = 0; i < sizeof(mSystTask) / sizeof(mSystTask[0]); i++) {
+			uint16_t tCpu = 0xFFFF, tStack = 0xFFFF;
+			sysStats_GetTask(mSystTask[i], &tCpu, &tStack);
+			sprintf((char *)&pAckBuff[54 + i * 8], "%04X%04X", tCpu, tStack);
+		}
+		return protoPacket_Encode(pAckBuff, PROTO_CMD_SYST, 74, true);
+	}
+	case PROTO_CMD_BLOB:
+	{
+		// BLOB command: hot spot blob tracking
+		// Data:        {[TTTT][AA]} threshold TTTT (0000 off) and minimum area AA, none to read only
+		// Response:    #0010BLOB[TTTT][AA][NN][CRC] NN: blobs of the last analysed frame
+		char tVal16[5];
+		uint16_t tThreshold;
+		uint8_t tMinArea, tCount;
+
+		if (tCmdLenInt >= 4 + 4 + 6) {
+			tVal16[4] = 0;
+			memcpy(tVal16, &pCmdPhaser->mData[0], 4);
+			const int tLevel = toHex(tVal16);
+			tVal[0] = pCmdPhaser->mData[4];
+			tVal[1] = pCmdPhaser->mData[5];
+			tVal[2] = 0;
+			tValInt = toHex((char*)tVal);
+			if (tLevel < 0 || tValInt < 0) {
+				ESP_LOGE(CPTAG, "BLOB: invalid configuration");
+				return 0;
+			}
+			blobTrack_Configure((uint16_t)tLevel, (uint8_t)tValInt);
+		}
+
+		blobTrack_GetStatus(&tThreshold, &tMinArea, &tCount);
+
+		sprintf((char *)&pAckBuff[PROTO_PACKET_DATA], "%04X%02X%02X", tThreshold, tMinArea, tCount);
+		return protoPacket_Encode(pAckBuff, PROTO_CMD_BLOB, 8, true);
+	}
+	case PROTO_CMD_RULE:
+	{
+		// RULE command: alarm rule table
+		// Data:        [II]{[MM][SS][CC][LL][TTTT][HHHH][DDDD]} rule II, the definition to set it, none to read only
+		// Response:    #0024RULE[II][MM][SS][CC][LL][TTTT][HHHH][DDDD][AA][VVVV][CRC] AA: raised, VVVV: last value
+		char tVal16[5];
+		uint8_t tField[4];
+		int tWide[3];
+		uint8_t tRaised;
+		uint16_t tValue;
+
+		if (tCmdLenInt < 4 + 4 + 2) {
+			ESP_LOGE(CPTAG, "RULE: missing rule index");
+			return 0;
+		}
+		tVal[0] = pCmdPhaser->mData[0];
+		tVal[1] = pCmdPhaser->mData[1];
+		tVal[2] = 0;
+		const int tIdx = toHex((char*)tVal);
+		if (tIdx < 0) {
+			ESP_LOGE(CPTAG, "RULE: invalid rule index");
+			return 0;
+		}
+
+		if (tCmdLenInt >= 4 + 4 + 22) {
+			for (uint8_t i = 0; i < 4; i++) {
+				tVal[0] = pCmdPhaser->mData[2 + i * 2];
+				tVal[1] = pCmdPhaser->mData[3 + i * 2];
+				tValInt = toHex((char*)tVal);
+				if (tValInt < 0) {
+					ESP_LOGE(CPTAG, "RULE: invalid definition");
+					return 0;
+				}
+				tField[i] = (uint8_t)tValInt;
+			}
+			tVal16[4] = 0;
+			for (uint8_t i = 0; i < 3; i++) {
+				memcpy(tVal16, &pCmdPhaser->mData[10 + i * 4], 4);
+				tWide[i] = toHex(tVal16);
+				if (tWide[i] < 0) {
+					ESP_LOGE(CPTAG, "RULE: invalid definition");
+					return 0;
+				}
+			}
+			if (!ruleEngine_SetRule((uint8_t)tIdx, tField[0], tField[1], tField[2], tField[3],
+					(uint16_t)tWide[0], (uint16_t)tWide[1], (uint16_t)tWide[2])) {
+				return 0;
+			}
+		}
+
+		uint16_t tThreshold, tHysteresis, tDwell;
+		if (!ruleEngine_GetRule((uint8_t)tIdx, &tField[0], &tField[1], &tField[2], &tField[3],
+				&tThreshold, &tHysteresis, &tDwell, &tRaised, &tValue)) {
+			ESP_LOGE(CPTAG, "RULE: invalid rule index");
+			return 0;
+		}
+
+		sprintf((char *)&pAckBuff[PROTO_PACKET_DATA], "%02X%02X%02X%02X%02X%04X%04X%04X%02X%04X", tIdx,
+				tField[0], tField[1], tField[2], tField[3], tThreshold, tHysteresis, tDwell, tRaised, tValue);
+		return protoPacket_Encode(pAckBuff, PROTO_CMD_RULE, 28, true);
+	}
+	case PROTO_CMD_ESPN:
+	{
+		// ESPN command: ESP-NOW peer table
+		// Data:        [II]{[MMMMMMMMMMMM][FF]} slot II, the peer MAC and flags to set it (FF 00 frees it), none to read only
+		// Response:    #001CESPN[II][MMMMMMMMMMMM][FF][NNNN][CRC] NNNN: packets the peer did not acknowledge
+		uint8_t tMac[6];
+		uint8_t tFlags;
+		uint16_t tFailed;
+
+		if (tCmdLenInt < 4 + 4 + 2) {
+			ESP_LOGE(CPTAG, "ESPN: missing peer index");
+			return 0;
+		}
+		tVal[0] = pCmdPhaser->mData[0];
+		tVal[1] = pCmdPhaser->mData[1];
+		tVal[2] = 0;
+		const int tIdx = toHex((char*)tVal);
+		if (tIdx < 0) {
+			ESP_LOGE(CPTAG, "ESPN: invalid peer index");
+			return 0;
+		}
+
+		if (tCmdLenInt >= 4 + 4 + 16) {
+			for (uint8_t i = 0; i < 7; i++) {
+				tVal[0] = pCmdPhaser->mData[2 + i * 2];
+				tVal[1] = pCmdPhaser->mData[3 + i * 2];
+				tValInt = toHex((char*)tVal);
+				if (tValInt < 0) {
+					ESP_LOGE(CPTAG, "ESPN: invalid peer");
+					return 0;
+				}
+				if (i < 6) {
+					tMac[i] = (uint8_t)tValInt;
+				} else {
+					tFlags = (uint8_t)tValInt;
+				}
+			}
+			if (!espNow_SetPeer((uint8_t)tIdx, tMac, tFlags)) {
+				return 0;
+			}
+		}
+
+		if (!espNow_GetPeer((uint8_t)tIdx, tMac, &tFlags, &tFailed)) {
+			ESP_LOGE(CPTAG, "ESPN: invalid peer index");
+			return 0;
+		}
+
+		sprintf((char *)&pAckBuff[PROTO_PACKET_DATA], "%02X%02X%02X%02X%02X%02X%02X%02X%04X", tIdx,
+				tMac[0], tMac[1], tMac[2], tMac[3], tMac[4], tMac[5], tFlags, tFailed);
+		return protoPacket_Encode(pAckBuff, PROTO_CMD_ESPN, 20, true);
+	}
+	default:
 	{
 		ESP_LOGE(CPTAG,CP_ERR_CMD_INVALID);
 		return 0;
-	}//End if-else
+	}
+	}//End switch
 
 }// cmdParser_CommitCmd
 
@@ -535,3 +1273,28 @@ void cmdParser_PrintResult(const cmdPhaser* pCmdPhaser)
 	ESP_LOGI(CPTAG,"Phased data: %s", pCmdPhaser->mData);
 	ESP_LOGI(CPTAG,"Phased CRC: %s", pCmdPhaser->mCRC);
 }// cmdParser_PrintResult
+
+/******************************************************************************
+ * @brief       cmdParser_GetBulkRange
+ * @param       pAck - Ack built by cmdParser_CommitCmd
+ * 				ackLen - Ack length
+ * 				pOffset - Clip offset of the bulk data
+ * 				pLen - Bytes of bulk data that follow the ack
+ * @return      true if the ack is a RECD ack. The caller sends the clip bytes
+ * 				and the CRC32 trailer, then calls frameRecorderEndDownload.
+ ******************************************************************************/
+bool cmdParser_GetBulkRange(const uint8_t* pAck, const size_t ackLen, uint32_t* pOffset, uint32_t* pLen)
+{
+#if CONFIG_MI_REC_EN
+	protoPacket_t tPacket;
+
+	if (ackLen != RECD_ACK_LEN || protoPacket_Decode(pAck, ackLen, &tPacket) <= 0 || tPacket.mCmd != PROTO_CMD_RECD)
+	{
+		return false;
+	}// End if
+
+	return protoHex_Read(&tPacket.pData[0], 8, pOffset) && protoHex_Read(&tPacket.pData[8], 8, pLen);
+#else
+	return false;
+#endif
+}// cmdParser_GetBulkRange
@@ -0,0 +1,463 @@
+/*****************************************************************************
+ * @file     jpegEnc.c
+ * @version  1.00
+ * @brief    Baseline JPEG encoder for colour mapped thermal images
+ * @date	 14 Oct 2026
+ * @details	 ESP-IDF ships a JPEG decoder only, so this is a small baseline
+ * 			 encoder: YCbCr 4:4:4, the Annex K quantisation tables scaled
+ * 			 by quality as libjpeg does, the Annex K Huffman tables and the
+ * 			 floating point AAN forward DCT, which suits the S3's single
+ * 			 precision FPU. Chroma is not subsampled, colour maps change
+ * 			 hue over a few pixels and 4:2:0 would smear the edges.
+ *
+ * 			 The encoder keeps no state between calls and writes into the
+ * 			 caller's buffer; the output is dropped and 0 returned if it
+ * 			 does not fit.
+ ******************************************************************************/
+#include <string.h>
+
+#include "jpegEnc.h"
+
+/*
+ * Output state of one encode
+ */
+typedef struct jpegWriter{
+	uint8_t* pOut;
+	size_t mSize;
+	size_t mPos;
+	uint32_t mBits;							//Pending bits, left aligned to bit 23
+	uint8_t mBitCount;
+	bool mOverflow;
+}jpegWriter_t;
+
+//Natural order position of every zigzag index
+static const uint8_t mZigzag[64] = {
+	 0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+	12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+	35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+	58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63
+};
+
+//Annex K.1 quantisation tables, natural order
+static const uint8_t mStdQuant[2][64] = {
+	{
+		16, 11, 10, 16,  24,  40,  51,  61,  12, 12, 14, 19,  26,  58,  60,  55,
+		14, 13, 16, 24,  40,  57,  69,  56,  14, 17, 22, 29,  51,  87,  80,  62,
+		18, 22, 37, 56,  68, 109, 103,  77,  24, 35, 55, 64,  81, 104, 113,  92,
+		49, 64, 78, 87, 103, 121, 120, 101,  72, 92, 95, 98, 112, 100, 103,  99
+	},
+	{
+		17, 18, 24, 47, 99, 99, 99, 99,  18, 21, 26, 66, 99, 99, 99, 99,
+		24, 26, 56, 99, 99, 99, 99, 99,  47, 66, 99, 99, 99, 99, 99, 99,
+		99, 99, 99, 99, 99, 99, 99, 99,  99, 99, 99, 99, 99, 99, 99, 99,
+		99, 99, 99, 99, 99, 99, 99, 99,  99, 99, 99, 99, 99, 99, 99, 99
+	}
+};
+
+//Annex K.3 Huffman tables: code counts per length 1-16, then the symbols
+static const uint8_t mDcBits[2][16] = {
+	{0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0},
+	{0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0}
+};
+static const uint8_t mDcVals[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+static const uint8_t mAcBits[2][16] = {
+	{0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d},
+	{0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77}
+};
+static const uint8_t mAcVals[2][162] = {
+	{
+		0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+		0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+		0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+		0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+		0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+		0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+		0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+		0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+		0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+		0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+		0xf9, 0xfa
+	},
+	{
+		0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+		0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0,
+		0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+		0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+		0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+		0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+		0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+		0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+		0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+		0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+		0xf9, 0xfa
+	}
+};
+
+//AAN DCT output scale per row and column
+static const float mAanScale[8] = {
+	1.0f, 1.387039845f, 1.306562965f, 1.175875602f, 1.0f, 0.785694958f, 0.541196100f, 0.275899379f
+};
+
+static void jpegBuildCodes(const uint8_t* pBits, const uint8_t* pVals, jpegCode_t* pCodes);
+static void jpegPutByte(jpegWriter_t* pW, const uint8_t byte);
+static void jpegPutBytes(jpegWriter_t* pW, const uint8_t* pData, const size_t len);
+static void jpegPutBits(jpegWriter_t* pW, const uint16_t code, const uint8_t len);
+static void jpegFlushBits(jpegWriter_t* pW);
+static void jpegWriteHeaders(jpegWriter_t* pW, const jpegEncoder_t* pEnc, const uint16_t w, const uint16_t h);
+static void jpegFdct(float* pBlock);
+static int16_t jpegEncodeBlock(jpegWriter_t* pW, float* pBlock, const float* pScale, const int16_t prevDc,
+							   const jpegCode_t* pDc, const jpegCode_t* pAc);
+
+/*
+ * ***********************************************************************
+ * @brief       jpegEncSetQuality
+ * @param       pEnc - Encoder to set up
+ * 				quality - 1 (smallest) to 100 (best)
+ * @return      None
+ * @details     Scale the Annex K tables the way libjpeg does, 50 keeps them
+ * 				as they are. Build once, an encode only reads the tables.
+ **************************************************************************/
+void jpegEncSetQuality(jpegEncoder_t* pEnc, const uint8_t quality)
+{
+	const uint8_t q = (quality < JPEG_QUALITY_MIN) ? JPEG_QUALITY_MIN : ((quality > JPEG_QUALITY_MAX) ? JPEG_QUALITY_MAX : quality);
+	const uint32_t factor = (q < 50) ? (5000 / q) : (200 - 2 * q);
+
+	pEnc->mQuality = q;
+	for(uint8_t t = 0 ; t < 2 ; ++t)
+	{
+		for(uint8_t i = 0 ; i < 64 ; ++i)
+		{
+			const uint8_t pos = mZigzag[i];
+			uint32_t v = (mStdQuant[t][pos] * factor + 50) / 100;
+			v = (v < 1) ? 1 : ((v > 255) ? 255 : v);
+			pEnc->mQuant[t][i] = v;
+			pEnc->mScale[t][pos] = 1.0f / (v * mAanScale[pos >> 3] * mAanScale[pos & 7] * 8.0f);
+		}
+		jpegBuildCodes(mDcBits[t], mDcVals, pEnc->mDcCode[t]);
+		jpegBuildCodes(mAcBits[t], mAcVals[t], pEnc->mAcCode[t]);
+	}
+}
+
+/*
+ * ***********************************************************************
+ * @brief       jpegEncodeRgb565
+ * @param       pEnc - Encoder with the quality set
+ * 				pImage, w, h - colour565 image, rows top down
+ * 				pOut, outSize - Output buffer
+ * @return      Bytes of the JPEG file, 0 if it did not fit
+ * @details     Edge blocks repeat the last column and row
+ **************************************************************************/
+size_t jpegEncodeRgb565(const jpegEncoder_t* pEnc, const uint16_t* pImage, const uint16_t w, const uint16_t h,
+						uint8_t* pOut, const size_t outSize)
+{
+	float block[3][64];
+	int16_t prevDc[3] = {0, 0, 0};
+	jpegWriter_t writer = {
+		.pOut = pOut,
+		.mSize = outSize,
+		.mPos = 0,
+		.mBits = 0,
+		.mBitCount = 0,
+		.mOverflow = false
+	};
+
+	jpegWriteHeaders(&writer, pEnc, w, h);
+
+	for(uint16_t by = 0 ; by < h && !writer.mOverflow ; by += 8)
+	{
+		for(uint16_t bx = 0 ; bx < w ; bx += 8)
+		{
+			for(uint8_t y = 0 ; y < 8 ; ++y)
+			{
+				const uint16_t* pRow = pImage + (uint32_t)((by + y < h) ? by + y : h - 1) * w;
+				for(uint8_t x = 0 ; x < 8 ; ++x)
+				{
+					const uint16_t c = pRow[(bx + x < w) ? bx + x : w - 1];
+					const float r = ((c >> 8) & 0xF8) | (c >> 13);
+					const float g = ((c >> 3) & 0xFC) | ((c >> 9) & 0x03);
+					const float b = ((c << 3) & 0xF8) | ((c >> 2) & 0x07);
+					block[0][y * 8 + x] = 0.299f * r + 0.587f * g + 0.114f * b - 128.0f;
+					block[1][y * 8 + x] = -0.168736f * r - 0.331264f * g + 0.5f * b;
+					block[2][y * 8 + x] = 0.5f * r - 0.418688f * g - 0.081312f * b;
+				}
+			}
+			prevDc[0] = jpegEncodeBlock(&writer, block[0], pEnc->mScale[0], prevDc[0], pEnc->mDcCode[0], pEnc->mAcCode[0]);
+			prevDc[1] = jpegEncodeBlock(&writer, block[1], pEnc->mScale[1], prevDc[1], pEnc->mDcCode[1], pEnc->mAcCode[1]);
+			prevDc[2] = jpegEncodeBlock(&writer, block[2], pEnc->mScale[1], prevDc[2], pEnc->mDcCode[1], pEnc->mAcCode[1]);
+		}
+	}
+
+	jpegFlushBits(&writer);
+	jpegPutByte(&writer, 0xFF);
+	jpegPutByte(&writer, 0xD9);													//EOI
+	return writer.mOverflow ? 0 : writer.mPos;
+}
+
+/*
+ * ***********************************************************************
+ * @brief       jpegBuildCodes
+ * @param       pBits - Code counts per length 1-16
+ * 				pVals - Symbols in code order
+ * 				pCodes - Code of every symbol
+ * @return      None
+ * @details     Canonical codes of Annex C
+ **************************************************************************/
+static void jpegBuildCodes(const uint8_t* pBits, const uint8_t* pVals, jpegCode_t* pCodes)
+{
+	uint16_t code = 0;
+	uint8_t k = 0;
+
+	for(uint8_t len = 1 ; len <= 16 ; ++len)
+	{
+		for(uint8_t i = 0 ; i < pBits[len - 1] ; ++i)
+		{
+			pCodes[pVals[k]].mCode = code++;
+			pCodes[pVals[k]].mLen = len;
+			++k;
+		}
+		code <<= 1;
+	}
+}
+
+/*
+ * ***********************************************************************
+ * @brief       jpegWriteHeaders
+ * @param       pW - Output
+ * 				pEnc - Quantisation tables
+ * 				w, h - Image size
+ * @return      None
+ * @details     SOI, JFIF APP0, DQT, SOF0, DHT and SOS
+ **************************************************************************/
+static void jpegWriteHeaders(jpegWriter_t* pW, const jpegEncoder_t* pEnc, const uint16_t w, const uint16_t h)
+{
+	static const uint8_t app0[] = {
+		0xFF, 0xD8,																//SOI
+		0xFF, 0xE0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0x00, 0x01, 0x01,			//APP0, JFIF 1.1
+		0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00								//No density, no thumbnail
+	};
+	const uint8_t sof0[] = {
+		0xFF, 0xC0, 0x00, 0x11, 0x08,											//SOF0, 8 bit samples
+		h >> 8, h & 0xFF, w >> 8, w & 0xFF, 0x03,
+		0x01, 0x11, 0x00,														//Y, no subsampling, table 0
+		0x02, 0x11, 0x01,														//Cb, table 1
+		0x03, 0x11, 0x01														//Cr, table 1
+	};
+	static const uint8_t sos[] = {
+		0xFF, 0xDA, 0x00, 0x0C, 0x03,
+		0x01, 0x00, 0x02, 0x11, 0x03, 0x11,										//Huffman tables per component
+		0x00, 0x3F, 0x00														//Full spectrum, no approximation
+	};
+
+	jpegPutBytes(pW, app0, sizeof(app0));
+	for(uint8_t t = 0 ; t < 2 ; ++t)
+	{
+		const uint8_t dqt[] = {0xFF, 0xDB, 0x00, 0x43, t};
+		jpegPutBytes(pW, dqt, sizeof(dqt));
+		jpegPutBytes(pW, pEnc->mQuant[t], 64);
+	}
+	jpegPutBytes(pW, sof0, sizeof(sof0));
+	for(uint8_t t = 0 ; t < 2 ; ++t)
+	{
+		const uint8_t dhtDc[] = {0xFF, 0xC4, 0x00, 3 + 16 + sizeof(mDcVals), 0x00 | t};
+		jpegPutBytes(pW, dhtDc, sizeof(dhtDc));
+		jpegPutBytes(pW, mDcBits[t], 16);
+		jpegPutBytes(pW, mDcVals, sizeof(mDcVals));
+
+		const uint8_t dhtAc[] = {0xFF, 0xC4, 0x00, 3 + 16 + sizeof(mAcVals[t]), 0x10 | t};
+		jpegPutBytes(pW, dhtAc, sizeof(dhtAc));
+		jpegPutBytes(pW, mAcBits[t], 16);
+		jpegPutBytes(pW, mAcVals[t], sizeof(mAcVals[t]));
+	}
+	jpegPutBytes(pW, sos, sizeof(sos));
+}
+
+/*
+ * ***********************************************************************
+ * @brief       jpegFdct
+ * @param       pBlock - 8 x 8 samples, replaced by the scaled coefficients
+ * @return      None
+ * @details     Arai, Agui and Nakajima, as jfdctflt.c of libjpeg. The
+ * 				output scale is folded into the quantiser reciprocals.
+ **************************************************************************/
+static void jpegFdct(float* pBlock)
+{
+	for(uint8_t pass = 0 ; pass < 2 ; ++pass)
+	{
+		const uint8_t step = (pass == 0) ? 1 : 8;							//Rows, then columns
+		const uint8_t next = (pass == 0) ? 8 : 1;
+		for(uint8_t i = 0 ; i < 8 ; ++i)
+		{
+			float* d = pBlock + i * next;
+			const float tmp0 = d[0] + d[7 * step];
+			const float tmp7 = d[0] - d[7 * step];
+			const float tmp1 = d[1 * step] + d[6 * step];
+			const float tmp6 = d[1 * step] - d[6 * step];
+			const float tmp2 = d[2 * step] + d[5 * step];
+			const float tmp5 = d[2 * step] - d[5 * step];
+			const float tmp3 = d[3 * step] + d[4 * step];
+			const float tmp4 = d[3 * step] - d[4 * step];
+
+			//Even part
+			float tmp10 = tmp0 + tmp3;
+			const float tmp13 = tmp0 - tmp3;
+			float tmp11 = tmp1 + tmp2;
+			float tmp12 = tmp1 - tmp2;
+			d[0] = tmp10 + tmp11;
+			d[4 * step] = tmp10 - tmp11;
+			const float z1 = (tmp12 + tmp13) * 0.707106781f;
+			d[2 * step] = tmp13 + z1;
+			d[6 * step] = tmp13 - z1;
+
+			//Odd part
+			tmp10 = tmp4 + tmp5;
+			tmp11 = tmp5 + tmp6;
+			tmp12 = tmp6 + tmp7;
+			const float z5 = (tmp10 - tmp12) * 0.382683433f;
+			const float z2 = 0.541196100f * tmp10 + z5;
+			const float z4 = 1.306562965f * tmp12 + z5;
+			const float z3 = tmp11 * 0.707106781f;
+			const float z11 = tmp7 + z3;
+			const float z13 = tmp7 - z3;
+			d[5 * step] = z13 + z2;
+			d[3 * step] = z13 - z2;
+			d[1 * step] = z11 + z4;
+			d[7 * step] = z11 - z4;
+		}
+	}
+}
+
+/*
+ * ***********************************************************************
+ * @brief       jpegEncodeBlock
+ * @param       pW - Output
+ * 				pBlock - 8 x 8 samples, level shifted
+ * 				pScale - Quantiser reciprocals of the component
+ * 				prevDc - Quantised DC of the previous block of the component
+ * 				pDc, pAc - Huffman codes of the component
+ * @return      Quantised DC of this block
+ **************************************************************************/
+static int16_t jpegEncodeBlock(jpegWriter_t* pW, float* pBlock, const float* pScale, const int16_t prevDc,
+							   const jpegCode_t* pDc, const jpegCode_t* pAc)
+{
+	int16_t coef[64];
+
+	jpegFdct(pBlock);
+	for(uint8_t i = 0 ; i < 64 ; ++i)
+	{
+		const float v = pBlock[mZigzag[i]] * pScale[mZigzag[i]];
+		coef[i] = (int16_t)((v < 0.0f) ? (v - 0.5f) : (v + 0.5f));
+	}
+
+	//DC difference, then the AC run lengths
+	int16_t diff = coef[0] - prevDc;
+	for(uint8_t i = 0 ; i < 64 ; )
+	{
+		int16_t v;
+		uint8_t run = 0;
+		if(i == 0)
+		{
+			v = diff;
+		}
+		else
+		{
+			while(i < 64 && coef[i] == 0)
+			{
+				++run;
+				++i;
+			}
+			if(i == 64)
+			{
+				jpegPutBits(pW, pAc[0x00].mCode, pAc[0x00].mLen);				//EOB
+				break;
+			}
+			while(run > 15)
+			{
+				jpegPutBits(pW, pAc[0xF0].mCode, pAc[0xF0].mLen);				//ZRL
+				run -= 16;
+			}
+			v = coef[i];
+		}
+
+		const uint16_t mag = (v < 0) ? -v : v;
+		uint8_t size = 0;
+		while((mag >> size) != 0)
+		{
+			++size;
+		}
+		const uint16_t bits = (v < 0) ? (uint16_t)(v - 1) : (uint16_t)v;		//One's complement of negative values
+
+		if(i == 0)
+		{
+			jpegPutBits(pW, pDc[size].mCode, pDc[size].mLen);
+		}
+		else
+		{
+			const uint8_t sym = (run << 4) | size;
+			jpegPutBits(pW, pAc[sym].mCode, pAc[sym].mLen);
+		}
+		jpegPutBits(pW, bits & ((1u << size) - 1), size);
+		++i;
+	}
+	return coef[0];
+}
+
+/*
+ * ***********************************************************************
+ * @brief       jpegPutBits
+ * @param       pW - Output
+ * 				code, len - Up to 16 bits, right aligned
+ * @return      None
+ * @details     Entropy coded bytes of 0xFF are stuffed with a 0x00
+ **************************************************************************/
+static void jpegPutBits(jpegWriter_t* pW, const uint16_t code, const uint8_t len)
+{
+	pW->mBits |= (uint32_t)code << (24 - pW->mBitCount - len);
+	pW->mBitCount += len;
+	while(pW->mBitCount >= 8)
+	{
+		const uint8_t byte = pW->mBits >> 16;
+		jpegPutByte(pW, byte);
+		if(byte == 0xFF)
+		{
+			jpegPutByte(pW, 0x00);
+		}
+		pW->mBits = (pW->mBits << 8) & 0xFFFFFF;
+		pW->mBitCount -= 8;
+	}
+}
+
+/*
+ * ***********************************************************************
+ * @brief       jpegFlushBits
+ * @param       pW - Output
+ * @return      None
+ * @details     Pad the last byte with 1 bits
+ **************************************************************************/
+static void jpegFlushBits(jpegWriter_t* pW)
+{
+	if(pW->mBitCount > 0)
+	{
+		jpegPutBits(pW, 0xFF >> pW->mBitCount, 8 - pW->mBitCount);
+	}
+}
+
+static void jpegPutByte(jpegWriter_t* pW, const uint8_t byte)
+{
+	if(pW->mPos >= pW->mSize)
+	{
+		pW->mOverflow = true;
+		return;
+	}
+	pW->pOut[pW->mPos++] = byte;
+}
+
+static void jpegPutBytes(jpegWriter_t* pW, const uint8_t* pData, const size_t len)
+{
+	if(pW->mPos + len > pW->mSize)
+	{
+		pW->mOverflow = true;
+		return;
+	}
+	memcpy(&pW->pOut[pW->mPos], pData, len);
+	pW->mPos += len;
+}
@@ -0,0 +1,368 @@
+/*****************************************************************************
+ * @file     jsonWriter.c
+ * @version  1.00
+ * @brief    Streaming JSON writer
+ * @date	 15 Oct 2026
+ * @details	 Writes a JSON document member by member into the caller's
+ * 			 buffer and hands the buffer to a flush function each time it
+ * 			 fills, e.g. httpd_resp_send_chunk. Nothing is allocated and no
+ * 			 tree is kept, the only state is the buffer position and one
+ * 			 comma bit per nesting level, so a reply of any length costs
+ * 			 the buffer and a few bytes of stack.
+ *
+ * 			 A key is given for members of an object and NULL for array
+ * 			 elements and the root. The writer does not check that begin
+ * 			 and end calls match. Output is compact, without white space.
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "jsonWriter.h"
+
+static void jsonPut(jsonWriter_t* pWriter, const char* pData, size_t len);
+static void jsonPutChar(jsonWriter_t* pWriter, const char c);
+static void jsonPutString(jsonWriter_t* pWriter, const char* pStr);
+static void jsonMember(jsonWriter_t* pWriter, const char* pKey);
+
+/*
+ * ***********************************************************************
+ * @brief       jsonWriterInit
+ * @param       pWriter - Writer to set up
+ * 				pBuff - Output buffer
+ * 				size - Buffer size
+ * 				pFlush - Takes the full buffer, NULL if the document must fit
+ * 				pCtx - Passed to pFlush
+ * @return      None
+ **************************************************************************/
+void jsonWriterInit(jsonWriter_t* pWriter, char* pBuff, const size_t size, jsonFlush_t pFlush, void* pCtx)
+{
+	pWriter->pBuff = pBuff;
+	pWriter->mSize = (pFlush == NULL && size > 0) ? size - 1 : size;	//Room for the NUL of a fixed buffer
+	pWriter->mPos = 0;
+	pWriter->pFlush = pFlush;
+	pWriter->pCtx = pCtx;
+	pWriter->mHasMember = 0;
+	pWriter->mDepth = 0;
+	pWriter->mError = (pBuff == NULL || pWriter->mSize == 0);
+}
+
+/*
+ * ***********************************************************************
+ * @brief       jsonWriterFinish
+ * @param       pWriter - Writer of the document
+ * @return      false if part of the document was lost
+ * @details     Flush what is left, or NUL terminate a fixed buffer
+ **************************************************************************/
+bool jsonWriterFinish(jsonWriter_t* pWriter)
+{
+	if(pWriter->mError)
+	{
+		return false;
+	}//End if
+
+	if(pWriter->pFlush == NULL)
+	{
+		pWriter->pBuff[pWriter->mPos] = '\0';
+	}
+	else if(pWriter->mPos > 0)
+	{
+		pWriter->mError = !pWriter->pFlush(pWriter->pCtx, pWriter->pBuff, pWriter->mPos);
+		pWriter->mPos = 0;
+	}//End if-else
+	return !pWriter->mError;
+}
+
+/*
+ * ***********************************************************************
+ * @brief       jsonBeginObject
+ * @param       pWriter - Writer of the document
+ * 				pKey - Member name, NULL in an array or at the root
+ * @return      None
+ **************************************************************************/
+void jsonBeginObject(jsonWriter_t* pWriter, const char* pKey)
+{
+	jsonMember(pWriter, pKey);
+	jsonPutChar(pWriter, '{');
+	if(pWriter->mDepth < JSON_MAX_DEPTH - 1)
+	{
+		pWriter->mDepth++;
+		pWriter->mHasMember &= ~(1UL << pWriter->mDepth);
+	}
+	else
+	{
+		pWriter->mError = true;
+	}//End if-else
+}
+
+/*
+ * ***********************************************************************
+ * @brief       jsonEndObject
+ * @param       pWriter - Writer of the document
+ * @return      None
+ **************************************************************************/
+void jsonEndObject(jsonWriter_t* pWriter)
+{
+	if(pWriter->mDepth > 0)
+	{
+		pWriter->mDepth--;
+	}//End if
+	jsonPutChar(pWriter, '}');
+}
+
+/*
+ * ***********************************************************************
+ * @brief       jsonBeginArray
+ * @param       pWriter - Writer of the document
+ * 				pKey - Member name, NULL in an array or at the root
+ * @return      None
+ **************************************************************************/
+void jsonBeginArray(jsonWriter_t* pWriter, const char* pKey)
+{
+	jsonMember(pWriter, pKey);
+	jsonPutChar(pWriter, '[');
+	if(pWriter->mDepth < JSON_MAX_DEPTH - 1)
+	{
+		pWriter->mDepth++;
+		pWriter->mHasMember &= ~(1UL << pWriter->mDepth);
+	}
+	else
+	{
+		pWriter->mError = true;
+	}//End if-else
+}
+
+/*
+ * ***********************************************************************
+ * @brief       jsonEndArray
+ * @param       pWriter - Writer of the document
+ * @return      None
+ **************************************************************************/
+void jsonEndArray(jsonWriter_t* pWriter)
+{
+	if(pWriter->mDepth > 0)
+	{
+		pWriter->mDepth--;
+	}//End if
+	jsonPutChar(pWriter, ']');
+}
+
+/*
+ * ***********************************************************************
+ * @brief       jsonAddString
+ * @param       pWriter - Writer of the document
+ * 				pKey - Member name, NULL in an array
+ * 				pValue - Value, escaped as needed. NULL writes null
+ * @return      None
+ **************************************************************************/
+void jsonAddString(jsonWriter_t* pWriter, const char* pKey, const char* pValue)
+{
+	jsonMember(pWriter, pKey);
+	if(pValue == NULL)
+	{
+		jsonPut(pWriter, "null", 4);
+		return;
+	}//End if
+	jsonPutString(pWriter, pValue);
+}
+
+/*
+ * ***********************************************************************
+ * @brief       jsonAddInt
+ * @param       pWriter - Writer of the document
+ * 				pKey - Member name, NULL in an array
+ * 				value - Value
+ * @return      None
+ **************************************************************************/
+void jsonAddInt(jsonWriter_t* pWriter, const char* pKey, const int64_t value)
+{
+	char number[JSON_NUMBER_MAX];
+
+	jsonMember(pWriter, pKey);
+	const int len = snprintf(number, sizeof(number), "%" PRId64, value);
+	jsonPut(pWriter, number, (size_t)len);
+}
+
+/*
+ * ***********************************************************************
+ * @brief       jsonAddFloat
+ * @param       pWriter - Writer of the document
+ * 				pKey - Member name, NULL in an array
+ * 				value - Value, null if not finite
+ * 				decimals - Digits after the point
+ * @return      None
+ **************************************************************************/
+void jsonAddFloat(jsonWriter_t* pWriter, const char* pKey, const double value, const uint8_t decimals)
+{
+	char number[JSON_NUMBER_MAX];
+
+	jsonMember(pWriter, pKey);
+	if(value != value || value > 1e15 || value < -1e15)				//NaN, infinity or too long for the buffer
+	{
+		jsonPut(pWriter, "null", 4);
+		return;
+	}//End if
+	const int len = snprintf(number, sizeof(number), "%.*f", decimals, value);
+	jsonPut(pWriter, number, (len < (int)sizeof(number)) ? (size_t)len : sizeof(number) - 1);
+}
+
+/*
+ * ***********************************************************************
+ * @brief       jsonAddBool
+ * @param       pWriter - Writer of the document
+ * 				pKey - Member name, NULL in an array
+ * 				value - Value
+ * @return      None
+ **************************************************************************/
+void jsonAddBool(jsonWriter_t* pWriter, const char* pKey, const bool value)
+{
+	jsonMember(pWriter, pKey);
+	if(value)
+	{
+		jsonPut(pWriter, "true", 4);
+	}
+	else
+	{
+		jsonPut(pWriter, "false", 5);
+	}//End if-else
+}
+
+/*
+ * ***********************************************************************
+ * @brief       jsonAddNull
+ * @param       pWriter - Writer of the document
+ * 				pKey - Member name, NULL in an array
+ * @return      None
+ **************************************************************************/
+void jsonAddNull(jsonWriter_t* pWriter, const char* pKey)
+{
+	jsonMember(pWriter, pKey);
+	jsonPut(pWriter, "null", 4);
+}
+
+/*
+ * ***********************************************************************
+ * @brief       jsonMember
+ * @param       pWriter - Writer of the document
+ * 				pKey - Member name, NULL in an array or at the root
+ * @return      None
+ * @details     Comma before every member but the first of its level,
+ * 				then the key
+ **************************************************************************/
+static void jsonMember(jsonWriter_t* pWriter, const char* pKey)
+{
+	const uint32_t bit = 1UL << pWriter->mDepth;
+
+	if(pWriter->mHasMember & bit)
+	{
+		jsonPutChar(pWriter, ',');
+	}//End if
+	pWriter->mHasMember |= bit;
+
+	if(pKey != NULL)
+	{
+		jsonPutString(pWriter, pKey);
+		jsonPutChar(pWriter, ':');
+	}//End if
+}
+
+/*
+ * ***********************************************************************
+ * @brief       jsonPutString
+ * @param       pWriter - Writer of the document
+ * 				pStr - String to quote
+ * @return      None
+ * @details     Quotes, backslashes and control characters are escaped,
+ * 				the rest is copied in runs
+ **************************************************************************/
+static void jsonPutString(jsonWriter_t* pWriter, const char* pStr)
+{
+	static const char mHex[] = "0123456789abcdef";
+	const char* pRun = pStr;
+
+	jsonPutChar(pWriter, '"');
+	for(; *pStr != '\0'; pStr++)
+	{
+		const uint8_t c = (uint8_t)*pStr;
+		if(c >= 0x20 && c != '"' && c != '\\')
+		{
+			continue;
+		}//End if
+
+		jsonPut(pWriter, pRun, (size_t)(pStr - pRun));
+		pRun = pStr + 1;
+		switch(c)
+		{
+			case '"':
+				jsonPut(pWriter, "\\\"", 2);
+			break;
+			case '\\':
+				jsonPut(pWriter, "\\\\", 2);
+			break;
+			case '\n':
+				jsonPut(pWriter, "\\n", 2);
+			break;
+			case '\r':
+				jsonPut(pWriter, "\\r", 2);
+			break;
+			case '\t':
+				jsonPut(pWriter, "\\t", 2);
+			break;
+			default:
+			{
+				const char escape[6] = {'\\', 'u', '0', '0', mHex[c >> 4], mHex[c & 0x0F]};
+				jsonPut(pWriter, escape, sizeof(escape));
+			}
+			break;
+		}//End switch
+	}//End for
+	jsonPut(pWriter, pRun, (size_t)(pStr - pRun));
+	jsonPutChar(pWriter, '"');
+}
+
+/*
+ * ***********************************************************************
+ * @brief       jsonPutChar
+ * @param       pWriter - Writer of the document
+ * 				c - Character to add
+ * @return      None
+ **************************************************************************/
+static void jsonPutChar(jsonWriter_t* pWriter, const char c)
+{
+	jsonPut(pWriter, &c, 1);
+}
+
+/*
+ * ***********************************************************************
+ * @brief       jsonPut
+ * @param       pWriter - Writer of the document
+ * 				pData - Bytes to add
+ * 				len - Byte count
+ * @return      None
+ * @details     Copy into the buffer, flushing it each time it fills
+ **************************************************************************/
+static void jsonPut(jsonWriter_t* pWriter, const char* pData, size_t len)
+{
+	while(len > 0 && !pWriter->mError)
+	{
+		if(pWriter->mPos == pWriter->mSize)
+		{
+			if(pWriter->pFlush == NULL || !pWriter->pFlush(pWriter->pCtx, pWriter->pBuff, pWriter->mPos))
+			{
+				pWriter->mError = true;
+				return;
+			}//End if
+			pWriter->mPos = 0;
+		}//End if
+
+		size_t part = pWriter->mSize - pWriter->mPos;
+		if(part > len)
+		{
+			part = len;
+		}//End if
+		memcpy(&pWriter->pBuff[pWriter->mPos], pData, part);
+		pWriter->mPos += part;
+		pData += part;
+		len -= part;
+	}//End while
+}
@@ -0,0 +1,140 @@
+/*****************************************************************************
+ * @file     regMap.c
+ * @version  1.00
+ * @brief    Register descriptors and dispatch
+ * @date	 15 Oct 2026
+ * @details	 One const descriptor per register of REG_MAP_LIST and one for
+ * 			 every other address, the SenXor registers. A 256 byte table
+ * 			 indexed by the address picks the descriptor, so a read or
+ * 			 write costs two loads and the call whatever the number of
+ * 			 registers. New registers are a line in regMap.h, not a branch
+ * 			 here or in cmdParser.c.
+ ******************************************************************************/
+#include <stddef.h>
+
+#include "regMap.h"
+#include "SenXorLib.h"
+#include "FrameStats.h"
+
+extern int ApplicationReadVersion (int Address);
+extern void Customer_InvalidateTgain(void);
+
+// Implemented in senxorTask.c
+extern uint16_t quadrant_ReadRegister(uint8_t regAddr);
+extern void quadrant_WriteRegister(uint8_t regAddr, uint8_t value);
+
+// Implemented in roiEngine.c
+extern uint16_t roiEngine_ReadRegister(const uint8_t regAddr);
+extern void roiEngine_WriteRegister(const uint8_t regAddr, const uint8_t value);
+
+// Implemented in temporalFilter.c
+extern uint16_t temporalFilter_ReadRegister(const uint8_t regAddr);
+extern void temporalFilter_WriteRegister(const uint8_t regAddr, const uint8_t value);
+
+// Implemented in sceneChange.c
+extern uint16_t sceneChange_ReadRegister(const uint8_t regAddr);
+extern void sceneChange_WriteRegister(const uint8_t regAddr, const uint8_t value);
+
+// Implemented in frameClassifier.c
+extern uint16_t frameClassifier_ReadRegister(const uint8_t regAddr);
+extern void frameClassifier_WriteRegister(const uint8_t regAddr, const uint8_t value);
+
+// Implemented in ruleEngine.c
+extern uint8_t ruleEngine_GetActive(void);
+
+static uint16_t regReadSenxor(const uint8_t addr);
+static void regWriteSenxor(const uint8_t addr, const uint8_t value);
+static uint16_t regReadVersion(const uint8_t addr);
+static uint16_t regReadStats(const uint8_t addr);
+static uint16_t regReadRule(const uint8_t addr);
+
+// Descriptor index of every listed register, REG_IDX_SENXOR for the others
+#define REG_IDX(addr, name, width, read, write, key)		REG_IDX_##addr,
+enum {
+	REG_IDX_SENXOR = 0,
+	REG_MAP_LIST(REG_IDX)
+	REG_IDX_COUNT
+};
+_Static_assert(REG_IDX_COUNT <= 256, "REG_MAP_LIST does not fit the uint8_t index");
+
+#define REG_DESC(addr, name, width, read, write, key)		[REG_IDX_##addr] = {name, key, read, write, width},
+static const regDesc_t mRegDesc[REG_IDX_COUNT] = {
+	[REG_IDX_SENXOR] = {"SenXor", NULL, regReadSenxor, regWriteSenxor, REG_8},
+	REG_MAP_LIST(REG_DESC)
+};
+
+#define REG_INDEX(addr, name, width, read, write, key)		[addr] = REG_IDX_##addr,
+static const uint8_t mRegIndex[REG_MAP_SIZE] = {
+	REG_MAP_LIST(REG_INDEX)
+};
+
+/*
+ * ***********************************************************************
+ * @brief       regMap_Get
+ * @param       addr - Register address
+ * @return      Descriptor of the register, never NULL
+ **************************************************************************/
+const regDesc_t* regMap_Get(const uint8_t addr)
+{
+	return &mRegDesc[mRegIndex[addr]];
+}
+
+/*
+ * ***********************************************************************
+ * @brief       regMap_Read
+ * @param       addr - Register address
+ * @return      Register value, 16-bit registers in full
+ **************************************************************************/
+uint16_t regMap_Read(const uint8_t addr)
+{
+	return mRegDesc[mRegIndex[addr]].pRead(addr);
+}
+
+/*
+ * ***********************************************************************
+ * @brief       regMap_Write
+ * @param       addr - Register address
+ * 				value - Value to write
+ * @return      false if the register is read only
+ * @details     The owner of the register checks the value
+ **************************************************************************/
+bool regMap_Write(const uint8_t addr, const uint8_t value)
+{
+	const regWrite_t pWrite = mRegDesc[mRegIndex[addr]].pWrite;
+
+	if(pWrite == NULL)
+	{
+		return false;
+	}//End if
+	pWrite(addr, value);
+	return true;
+}
+
+static uint16_t regReadSenxor(const uint8_t addr)
+{
+	return Acces_Read_Reg(addr);
+}
+
+static void regWriteSenxor(const uint8_t addr, const uint8_t value)
+{
+	Acces_Write_Reg(addr, value);
+	if(addr == 0xB9)
+	{
+		Customer_InvalidateTgain();											//Unit conversion reads it once per write
+	}//End if
+}
+
+static uint16_t regReadVersion(const uint8_t addr)
+{
+	return (uint8_t)ApplicationReadVersion(addr);
+}
+
+static uint16_t regReadStats(const uint8_t addr)
+{
+	return FrameStats_ReadRegister(addr);
+}
+
+static uint16_t regReadRule(const uint8_t addr)
+{
+	return ruleEngine_GetActive();
+}
@@ -0,0 +1,219 @@
+/*****************************************************************************
+ * @file     simpleGFX.c
+ * @version  1.00
+ * @brief    Colour mapping and integer upscaling of thermal images
+ * @date	 14 Oct 2026
+ * @details	 The kernels work a row at a time, so a caller can colour and
+ * 			 scale straight into a DMA band or an HTTP chunk without a full
+ * 			 size frame buffer. Nothing divides per pixel: the colour LUT
+ * 			 is indexed by a shift, and the bilinear weights of the scale
+ * 			 phases are worked out once per row in 1/256.
+ ******************************************************************************/
+#include <string.h>
+
+#include "simpleGFX.h"
+
+/*
+ * Taps of one output phase of the bilinear kernel
+ */
+typedef struct gfxTap{
+	int8_t mOffset;						//First source pixel relative to out / scale
+	uint16_t mWeight;					//Weight of the second source pixel, in 1/256
+}gfxTap_t;
+
+static void gfxBilinearPhases(const uint8_t scale, gfxTap_t* pTaps);
+
+/*
+ * ***********************************************************************
+ * @brief       gfxLutReset
+ * @param       pLut - LUT to invalidate
+ * @return      None
+ * @details     The next gfxLutUpdate rebuilds the table
+ **************************************************************************/
+void gfxLutReset(gfxColourLut_t* pLut)
+{
+	pLut->mMap = colourmapCount;
+	pLut->mEntries = 1;
+	pLut->mShift = 0;
+	pLut->mMin = 0;
+	pLut->mMax = 0;
+}
+
+/*
+ * ***********************************************************************
+ * @brief       gfxLutUpdate
+ * @param       pLut - LUT to update
+ * 				minVal, maxVal - Raw values at the ends of the colour map
+ * 				map - ColourmapSelection
+ * @return      true if the table was rebuilt
+ * @details     Rebuild only when the range or the map changed. A span of
+ * 				up to GFX_LUT_SIZE raw units gets one entry per unit, a
+ * 				wider span one per 2^mShift units.
+ **************************************************************************/
+bool gfxLutUpdate(gfxColourLut_t* pLut, const uint16_t minVal, const uint16_t maxVal, const uint8_t map)
+{
+	const uint8_t sel = (map < colourmapCount) ? map : IronGlow;
+
+	if(pLut->mMap == sel && pLut->mMin == minVal && pLut->mMax == maxVal)
+	{
+		return false;
+	}
+
+	const uint32_t span = (maxVal > minVal) ? (maxVal - minVal) : 1;
+	uint8_t shift = 0;
+	while((span >> shift) >= GFX_LUT_SIZE)
+	{
+		++shift;
+	}
+
+	pLut->mMin = minVal;
+	pLut->mMax = maxVal;
+	pLut->mMap = sel;
+	pLut->mShift = shift;
+	pLut->mEntries = (span >> shift) + 1;
+	for(uint16_t i = 0 ; i < pLut->mEntries ; ++i)
+	{
+		const uint32_t pos = ((uint32_t)i << shift) * 255 / span;
+		const uint8_t p = (pos > 255) ? 255 : pos;
+		pLut->mColour[i] = colour565(r[sel][p], g[sel][p], b[sel][p]);
+	}
+	return true;
+}
+
+/*
+ * ***********************************************************************
+ * @brief       gfxLutMapRow
+ * @param       pLut - Colour LUT
+ * 				pSrc - Raw values
+ * 				pDst - colour565 output, may be pSrc
+ * 				count - Pixels
+ * @return      None
+ **************************************************************************/
+void gfxLutMapRow(const gfxColourLut_t* pLut, const uint16_t* pSrc, uint16_t* pDst, const uint16_t count)
+{
+	for(uint16_t i = 0 ; i < count ; ++i)
+	{
+		pDst[i] = pLut->mColour[gfxLutIndex(pLut, pSrc[i])];
+	}
+}
+
+/*
+ * ***********************************************************************
+ * @brief       gfxUpscaleNearestRow
+ * @param       pSrc - Source pixels
+ * 				count - Source pixels to scale
+ * 				scale - 1 to GFX_MAX_SCALE
+ * 				pDst - count * scale output pixels
+ * @return      None
+ * @details     Repeat every pixel; the caller repeats the row
+ **************************************************************************/
+void gfxUpscaleNearestRow(const uint16_t* pSrc, const uint16_t count, const uint8_t scale, uint16_t* pDst)
+{
+	switch(scale)
+	{
+		case 2:
+			for(uint16_t i = 0 ; i < count ; ++i)
+			{
+				*pDst++ = pSrc[i];
+				*pDst++ = pSrc[i];
+			}
+			break;
+		case 3:
+			for(uint16_t i = 0 ; i < count ; ++i)
+			{
+				*pDst++ = pSrc[i];
+				*pDst++ = pSrc[i];
+				*pDst++ = pSrc[i];
+			}
+			break;
+		default:
+			for(uint16_t i = 0 ; i < count ; ++i)
+			{
+				for(uint8_t s = 0 ; s < scale ; ++s)
+				{
+					*pDst++ = pSrc[i];
+				}
+			}
+			break;
+	}
+}
+
+/*
+ * ***********************************************************************
+ * @brief       gfxUpscaleBilinearRow
+ * @param       pImage, w, h - Source image
+ * 				scale - 1 to GFX_MAX_SCALE
+ * 				outY - Output row
+ * 				outX, outW - First output column and number of columns
+ * 				pDst - outW interpolated raw values
+ * @return      None
+ * @details     Output pixel centres sit on the source grid, so the image is
+ * 				not shifted and the edge pixels repeat. Raw values are
+ * 				interpolated, the caller colour maps the result.
+ **************************************************************************/
+void gfxUpscaleBilinearRow(const uint16_t* pImage, const uint16_t w, const uint16_t h, const uint8_t scale,
+						   const uint16_t outY, const uint16_t outX, const uint16_t outW, uint16_t* pDst)
+{
+	gfxTap_t taps[GFX_MAX_SCALE];
+	const uint8_t s = (scale < 1) ? 1 : ((scale > GFX_MAX_SCALE) ? GFX_MAX_SCALE : scale);
+
+	gfxBilinearPhases(s, taps);
+
+	// Source rows of this output row
+	const gfxTap_t* pTapY = &taps[outY % s];
+	int32_t y0 = (int32_t)(outY / s) + pTapY->mOffset;
+	int32_t y1 = y0 + 1;
+	y0 = (y0 < 0) ? 0 : ((y0 >= h) ? h - 1 : y0);
+	y1 = (y1 < 0) ? 0 : ((y1 >= h) ? h - 1 : y1);
+	const uint16_t* pRow0 = pImage + y0 * w;
+	const uint16_t* pRow1 = pImage + y1 * w;
+	const uint32_t wy = pTapY->mWeight;
+
+	uint16_t base = outX / s;
+	uint8_t phase = outX % s;
+	for(uint16_t i = 0 ; i < outW ; ++i)
+	{
+		int32_t x0 = (int32_t)base + taps[phase].mOffset;
+		int32_t x1 = x0 + 1;
+		x0 = (x0 < 0) ? 0 : ((x0 >= w) ? w - 1 : x0);
+		x1 = (x1 < 0) ? 0 : ((x1 >= w) ? w - 1 : x1);
+		const uint32_t wx = taps[phase].mWeight;
+
+		const uint32_t top = pRow0[x0] * (256 - wx) + pRow0[x1] * wx;
+		const uint32_t bottom = pRow1[x0] * (256 - wx) + pRow1[x1] * wx;
+		pDst[i] = (top * (256 - wy) + bottom * wy + 32768) >> 16;
+
+		if(++phase == s)
+		{
+			phase = 0;
+			++base;
+		}
+	}
+}
+
+/*
+ * ***********************************************************************
+ * @brief       gfxBilinearPhases
+ * @param       scale - 1 to GFX_MAX_SCALE
+ * 				pTaps - scale taps, one per output phase
+ * @return      None
+ * @details     Output pixel k of a source pixel has its centre at
+ * 				(2k + 1 - scale) / (2 * scale) source pixels from the source
+ * 				centre. A negative offset interpolates with the pixel before.
+ **************************************************************************/
+static void gfxBilinearPhases(const uint8_t scale, gfxTap_t* pTaps)
+{
+	const int32_t den = 2 * scale;
+
+	for(uint8_t k = 0 ; k < scale ; ++k)
+	{
+		int32_t pos = 2 * k + 1 - scale;
+		pTaps[k].mOffset = 0;
+		if(pos < 0)
+		{
+			pos += den;
+			pTaps[k].mOffset = -1;
+		}
+		pTaps[k].mWeight = (pos * 256 + den / 2) / den;
+	}
+}
@@ -1,6 +1,6 @@
 /**************************************************************************//**
  * @file     util.c
- * @version  V1.02
+ * @version  V1.03
  * @brief    Contains utilities functions
  *
  ******************************************************************************/
@@ -125,17 +125,17 @@ void displaySenxorInfo(void)
 /*
  * ***********************************************************************
  * @brief       getSysInfoJson
- * @param       jsonObj - JSON Object which the information will be added
+ * @param       pWriter - Writer inside the object the information is added to
  * @return     	None
  * @details     Add system information to an existing JSON
  *****************************************************************************/
-void getSysInfoJson(cJSON* jsonObj)
+void getSysInfoJson(jsonWriter_t* pWriter)
 {
-	if(!jsonObj)
+	if(!pWriter)
 	{
 		return;
 	}
-	cJSON *sys_info = cJSON_AddObjectToObject(jsonObj, JSON_SYS_INFO_ROOT);					//Added JSON object
+	jsonBeginObject(pWriter, JSON_SYS_INFO_ROOT);
 
 	/*
 	 * Add data to JSON
@@ -143,13 +143,14 @@ void getSysInfoJson(cJSON* jsonObj)
     esp_chip_info_t chip_info;
     esp_chip_info(&chip_info);
 
-    cJSON_AddStringToObject(sys_info, JSON_SYS_INFO_FW_VER, MSG_APP_VER);
-    cJSON_AddStringToObject(sys_info, JSON_SYS_INFO_SXRLIB_VER, MSG_SXRLIB_VER);
-    cJSON_AddStringToObject(sys_info, JSON_SYS_INFO_IDF_VER, IDF_VER);
-    cJSON_AddNumberToObject(sys_info, JSON_SYS_INFO_CPU_CORE, chip_info.cores);
-    cJSON_AddNumberToObject(sys_info, JSON_SYS_INFO_CPU_SPD, CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
-    cJSON_AddNumberToObject(sys_info, JSON_SYS_INFO_CPU_MODEL, chip_info.model);
-	cJSON_AddNumberToObject(sys_info, BLUFI_JSON_DEV_OPMODE, MCU_getOpMode());
+    jsonAddString(pWriter, JSON_SYS_INFO_FW_VER, MSG_APP_VER);
+    jsonAddString(pWriter, JSON_SYS_INFO_SXRLIB_VER, MSG_SXRLIB_VER);
+    jsonAddString(pWriter, JSON_SYS_INFO_IDF_VER, IDF_VER);
+    jsonAddInt(pWriter, JSON_SYS_INFO_CPU_CORE, chip_info.cores);
+    jsonAddInt(pWriter, JSON_SYS_INFO_CPU_SPD, CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+    jsonAddInt(pWriter, JSON_SYS_INFO_CPU_MODEL, chip_info.model);
+	jsonAddInt(pWriter, BLUFI_JSON_DEV_OPMODE, MCU_getOpMode());
+	jsonEndObject(pWriter);
 
 }
 
@@ -175,3 +176,30 @@ uint16_t getCRC(const uint8_t* pData, uint16_t pDataSize)
 	}
 	return tCRCResult;
 }// getCRC
+
+/*
+ * ***********************************************************************
+ * @brief       getCRC16
+ * @param       pData - Raw data to be calculated
+ * 				pDataSize - Size of the data
+ * @return     	Calculated CRC
+ * @details     CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF), one nibble per table lookup
+ *****************************************************************************/
+uint16_t getCRC16(const uint8_t* pData, uint16_t pDataSize)
+{
+	static const uint16_t tCRCTable[16] = {
+		0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7, 0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+	};
+	uint16_t tCRCResult = 0xFFFF;
+	if(!pData)
+	{
+		return 0;
+	}
+
+	for(uint16_t i = 0 ; i < pDataSize ; ++i)
+	{
+		tCRCResult = (tCRCResult << 4) ^ tCRCTable[(tCRCResult >> 12) ^ (pData[i] >> 4)];
+		tCRCResult = (tCRCResult << 4) ^ tCRCTable[(tCRCResult >> 12) ^ (pData[i] & 0x0F)];
+	}
+	return tCRCResult;
+}// getCRC16
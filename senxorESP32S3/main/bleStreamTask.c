@@ -0,0 +1,781 @@
+/*****************************************************************************
+ * @file     bleStreamTask.c
+ * @version  1.03
+ * @brief    Thermal frame stream over a BLE GATT service.
+ * @date	 14 Oct 2026
+ * @details	 For sites without Wi-Fi. One client at a time enables
+ * 			 notifications on the frame characteristic and receives either
+ * 			 a 40 x 31 preview (mean of 2 x 2 pixel blocks) or the bounding
+ * 			 box of one ROI, at full resolution when it fits in the same
+ * 			 pixel budget.
+ *
+ * 			 Each frame is coded like the TCP v2 stream (frameCodec.c), the
+ * 			 delta frames against the last frame sent, and split into
+ * 			 notifications of MTU - 3 bytes. The client grants credits on
+ * 			 the control characteristic, one per notification, so the
+ * 			 stack queue never overflows and a slow phone sets the pace.
+ * 			 Frames that arrive while a frame is still being sent are
+ * 			 dropped by the latest-only mailbox. When blob tracking is on,
+ * 			 the blob record follows the payload (TCP_STREAM_FLAG_BLOBS).
+ *
+ * 			 Alarm rule events go out on their own characteristic to every
+ * 			 connection that enabled it, streaming or not, ahead of the
+ * 			 frame chunks and without credits.
+ *
+ * 			 The GATT callback runs in the Bluedroid task. It is shared with
+ * 			 the Combustion service, which forwards the events of this
+ * 			 application (combustionBle_SetAppHandler).
+ ******************************************************************************/
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_gap_ble_api.h>
+#include <esp_gatts_api.h>
+#include <sdkconfig.h>
+
+#include "SenXorLib.h"
+#include "bleStreamTask.h"
+#include "frameCodec.h"
+#include "roiEngine.h"
+#include "ruleEngine.h"
+#include "tcpServerTask.h"
+#include "frameRecorder.h"
+#include "Drv_CombustionBle.h"
+
+#if CONFIG_MI_BLE_STREAM_EN
+
+// GATT database indices
+enum {
+	BLE_STREAM_IDX_SVC,
+	BLE_STREAM_IDX_FRAME_DECL,
+	BLE_STREAM_IDX_FRAME_VAL,
+	BLE_STREAM_IDX_FRAME_CCCD,
+	BLE_STREAM_IDX_CTRL_DECL,
+	BLE_STREAM_IDX_CTRL_VAL,
+	BLE_STREAM_IDX_ALARM_DECL,
+	BLE_STREAM_IDX_ALARM_VAL,
+	BLE_STREAM_IDX_ALARM_CCCD,
+	BLE_STREAM_IDX_NB,
+};
+
+//private:
+static bleStreamClient_t mClient;
+static uint32_t mSession = 0;										//Incremented for every new client
+static SemaphoreHandle_t mClientMutex = NULL;						//Guards mClient between Bluedroid and bleStreamTask
+static TaskHandle_t mTaskHandle = NULL;
+static esp_gatt_if_t mGattsIf = ESP_GATT_IF_NONE;
+static uint16_t mHandles[BLE_STREAM_IDX_NB];
+static uint16_t mConnMtu[CONFIG_BT_ACL_CONNECTIONS];				//Negotiated MTU of every connection
+static volatile bool mAlarmOn[CONFIG_BT_ACL_CONNECTIONS];			//Alarm notifications enabled on the connection
+static uint32_t mRuleCursor = 0;									//Next rule event to send, only used by bleStreamTask
+
+// Frame being sent, only used by bleStreamTask
+static uint8_t mMsg[BLE_STREAM_MSG_MAX];
+static uint16_t mMsgLen = 0;
+static uint16_t mTxOffset = 0;
+static uint8_t mTxFrameId = 0;
+static uint8_t mTxChunk = 0;
+static uint8_t mTxChunkCount = 0;
+static uint16_t mTxChunkData = 0;									//Message bytes per notification, latched per frame
+static uint8_t mChunk[BLE_STREAM_CHUNK_HEADER + BLE_STREAM_MSG_MAX];
+static bleView_t mRefView;
+static bool mRefValid = false;
+static uint16_t mFramesSinceKey = 0;
+static int64_t mNextFrameUs = 0;
+EXT_RAM_BSS_ATTR static uint16_t mPixels[BLE_STREAM_MAX_PIXELS];
+EXT_RAM_BSS_ATTR static uint16_t mRefPixels[BLE_STREAM_MAX_PIXELS];
+EXT_RAM_BSS_ATTR static uint8_t mDeltaBuff[BLE_STREAM_MAX_PIXELS * 2];
+
+static const uint16_t mPrimaryServiceUuid = ESP_GATT_UUID_PRI_SERVICE;
+static const uint16_t mCharDeclUuid = ESP_GATT_UUID_CHAR_DECLARE;
+static const uint16_t mCharCccdUuid = ESP_GATT_UUID_CHAR_CLIENT_CONFIG;
+static const uint8_t mFrameProp = ESP_GATT_CHAR_PROP_BIT_NOTIFY;
+static const uint8_t mCtrlProp = ESP_GATT_CHAR_PROP_BIT_WRITE | ESP_GATT_CHAR_PROP_BIT_WRITE_NR;
+static const uint8_t mAlarmProp = ESP_GATT_CHAR_PROP_BIT_NOTIFY;
+static const uint8_t mServiceUuid[16] = BLE_STREAM_SERVICE_UUID_128;
+static const uint8_t mFrameUuid[16] = BLE_STREAM_FRAME_UUID_128;
+static const uint8_t mCtrlUuid[16] = BLE_STREAM_CTRL_UUID_128;
+static const uint8_t mAlarmUuid[16] = BLE_STREAM_ALARM_UUID_128;
+static uint8_t mFrameValue[1] = {0};
+static uint16_t mFrameCccd = 0x0000;
+static uint8_t mCtrlValue[BLE_STREAM_CTRL_MAX] = {0};
+static uint8_t mAlarmValue[BLE_STREAM_RULE_MSG_SIZE] = {0};
+static uint16_t mAlarmCccd = 0x0000;
+
+static const esp_gatts_attr_db_t mGattDb[BLE_STREAM_IDX_NB] = {
+	[BLE_STREAM_IDX_SVC] = {
+		{ESP_GATT_AUTO_RSP},
+		{ESP_UUID_LEN_16, (uint8_t *)&mPrimaryServiceUuid, ESP_GATT_PERM_READ,
+		 sizeof(mServiceUuid), sizeof(mServiceUuid), (uint8_t *)mServiceUuid}
+	},
+	[BLE_STREAM_IDX_FRAME_DECL] = {
+		{ESP_GATT_AUTO_RSP},
+		{ESP_UUID_LEN_16, (uint8_t *)&mCharDeclUuid, ESP_GATT_PERM_READ,
+		 1, 1, (uint8_t *)&mFrameProp}
+	},
+	[BLE_STREAM_IDX_FRAME_VAL] = {
+		{ESP_GATT_AUTO_RSP},
+		{ESP_UUID_LEN_128, (uint8_t *)mFrameUuid, 0,
+		 sizeof(mFrameValue), sizeof(mFrameValue), mFrameValue}
+	},
+	[BLE_STREAM_IDX_FRAME_CCCD] = {
+		{ESP_GATT_AUTO_RSP},
+		{ESP_UUID_LEN_16, (uint8_t *)&mCharCccdUuid, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE,
+		 sizeof(uint16_t), sizeof(mFrameCccd), (uint8_t *)&mFrameCccd}
+	},
+	[BLE_STREAM_IDX_CTRL_DECL] = {
+		{ESP_GATT_AUTO_RSP},
+		{ESP_UUID_LEN_16, (uint8_t *)&mCharDeclUuid, ESP_GATT_PERM_READ,
+		 1, 1, (uint8_t *)&mCtrlProp}
+	},
+	[BLE_STREAM_IDX_CTRL_VAL] = {
+		{ESP_GATT_AUTO_RSP},
+		{ESP_UUID_LEN_128, (uint8_t *)mCtrlUuid, ESP_GATT_PERM_WRITE,
+		 sizeof(mCtrlValue), 0, mCtrlValue}
+	},
+	[BLE_STREAM_IDX_ALARM_DECL] = {
+		{ESP_GATT_AUTO_RSP},
+		{ESP_UUID_LEN_16, (uint8_t *)&mCharDeclUuid, ESP_GATT_PERM_READ,
+		 1, 1, (uint8_t *)&mAlarmProp}
+	},
+	[BLE_STREAM_IDX_ALARM_VAL] = {
+		{ESP_GATT_AUTO_RSP},
+		{ESP_UUID_LEN_128, (uint8_t *)mAlarmUuid, 0,
+		 sizeof(mAlarmValue), sizeof(mAlarmValue), mAlarmValue}
+	},
+	[BLE_STREAM_IDX_ALARM_CCCD] = {
+		{ESP_GATT_AUTO_RSP},
+		{ESP_UUID_LEN_16, (uint8_t *)&mCharCccdUuid, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE,
+		 sizeof(uint16_t), sizeof(mAlarmCccd), (uint8_t *)&mAlarmCccd}
+	},
+};
+
+static void bleStream_GattsHandler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t *param);
+static void bleStream_AddClient(const uint16_t connId, esp_bd_addr_t bda);
+static void bleStream_RemoveClient(void);
+static void bleStream_Control(const uint16_t connId, const uint8_t* pValue, const uint16_t len);
+static void bleStream_Send(void);
+static void bleStream_SendRules(void);
+static bool bleStream_LoadFrame(const bleStreamClient_t* pClient);
+static void bleStream_GetView(const bleStreamClient_t* pClient, bleView_t* pView);
+static void bleStream_Downsample(const uint16_t* pImage, const bleView_t* pView, uint16_t* pOut);
+
+/*
+ * ***********************************************************************
+ * @brief       bleStreamTask
+ * @param       pvParameters - Not used
+ * @return      None
+ * @details     Register the stream service next to the Combustion service
+ * 				and send frames to the streaming client as credits allow.
+ * 				Must start after combustionBle_Init.
+ **************************************************************************/
+void bleStreamTask(void *pvParameters)
+{
+	mTaskHandle = xTaskGetCurrentTaskHandle();
+	mClientMutex = xSemaphoreCreateMutex();
+	memset(&mClient, 0, sizeof(mClient));
+	mClient.mFrameSub = FRAME_BUS_INVALID_ID;
+	for(uint8_t i = 0; i < CONFIG_BT_ACL_CONNECTIONS; i++)
+	{
+		mConnMtu[i] = BLE_STREAM_DEFAULT_MTU;
+	}//End for
+
+	mRuleCursor = ruleEngine_GetEventCount();
+	combustionBle_SetAppHandler(bleStream_GattsHandler);
+	const esp_err_t err = esp_ble_gatts_app_register(BLE_STREAM_APP_ID);
+	if(err != ESP_OK)
+	{
+		ESP_LOGE(BLSTAG, BLS_ERR_REGISTER, esp_err_to_name(err));
+		vTaskDelete(NULL);
+	}//End if
+
+	uint32_t session = 0;
+	for(;;)
+	{
+		ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(BLE_STREAM_WAIT_MS));		//Woken by the frame bus, credits, congestion end or a rule event
+
+		if(session != mSession)
+		{
+			session = mSession;												//New client: no reference, nothing in flight
+			mRefValid = false;
+			mTxChunk = mTxChunkCount = 0;
+			mNextFrameUs = 0;
+		}//End if
+		bleStream_SendRules();
+		bleStream_Send();
+	}//End for
+}//End bleStreamTask
+
+/*
+ * ***********************************************************************
+ * @brief       bleStreamGetIsClientConnected
+ * @param       None
+ * @return      true if a client has notifications enabled
+ * @details     None
+ **************************************************************************/
+bool bleStreamGetIsClientConnected(void)
+{
+	return mClient.mActive;
+}//End bleStreamGetIsClientConnected
+
+/*
+ * ***********************************************************************
+ * @brief       bleStreamNotifyRule
+ * @param       None
+ * @return      None
+ * @details     Called by senxorTask when an alarm rule was raised or cleared
+ **************************************************************************/
+void bleStreamNotifyRule(void)
+{
+	if(mTaskHandle != NULL)
+	{
+		xTaskNotifyGive(mTaskHandle);
+	}//End if
+}//End bleStreamNotifyRule
+
+/*
+ * ***********************************************************************
+ * @brief       bleStream_GattsHandler
+ * @param       event, gatts_if, param - GATT server event of this application
+ * @return      None
+ * @details     Runs in the Bluedroid task
+ **************************************************************************/
+static void bleStream_GattsHandler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t *param)
+{
+	switch(event)
+	{
+		case ESP_GATTS_REG_EVT:
+			if(param->reg.status == ESP_GATT_OK)
+			{
+				mGattsIf = gatts_if;
+				esp_ble_gatts_create_attr_tab(mGattDb, gatts_if, BLE_STREAM_IDX_NB, 0);
+			}//End if
+			break;
+
+		case ESP_GATTS_CREAT_ATTR_TAB_EVT:
+			if(param->add_attr_tab.status == ESP_GATT_OK && param->add_attr_tab.num_handle == BLE_STREAM_IDX_NB)
+			{
+				memcpy(mHandles, param->add_attr_tab.handles, sizeof(mHandles));
+				esp_ble_gatts_start_service(mHandles[BLE_STREAM_IDX_SVC]);
+				ESP_LOGI(BLSTAG, BLS_INFO_START, BLE_STREAM_APP_ID);
+			}//End if
+			break;
+
+		case ESP_GATTS_CONNECT_EVT:
+			if(param->connect.conn_id < CONFIG_BT_ACL_CONNECTIONS)
+			{
+				mConnMtu[param->connect.conn_id] = BLE_STREAM_DEFAULT_MTU;
+				mAlarmOn[param->connect.conn_id] = false;
+			}//End if
+			break;
+
+		case ESP_GATTS_MTU_EVT:
+			if(param->mtu.conn_id < CONFIG_BT_ACL_CONNECTIONS)
+			{
+				mConnMtu[param->mtu.conn_id] = param->mtu.mtu;
+			}//End if
+			break;
+
+		case ESP_GATTS_WRITE_EVT:
+			if(param->write.handle == mHandles[BLE_STREAM_IDX_FRAME_CCCD] && param->write.len == 2)
+			{
+				if(param->write.value[0] & 0x01)
+				{
+					bleStream_AddClient(param->write.conn_id, param->write.bda);
+				}
+				else
+				{
+					xSemaphoreTake(mClientMutex, portMAX_DELAY);
+					if(mClient.mActive && mClient.mConnId == param->write.conn_id)
+					{
+						bleStream_RemoveClient();
+					}//End if
+					xSemaphoreGive(mClientMutex);
+				}//End if-else
+			}
+			else if(param->write.handle == mHandles[BLE_STREAM_IDX_CTRL_VAL])
+			{
+				bleStream_Control(param->write.conn_id, param->write.value, param->write.len);
+			}
+			else if(param->write.handle == mHandles[BLE_STREAM_IDX_ALARM_CCCD] && param->write.len == 2 && param->write.conn_id < CONFIG_BT_ACL_CONNECTIONS)
+			{
+				mAlarmOn[param->write.conn_id] = (param->write.value[0] & 0x01) != 0;
+			}//End if-else
+			break;
+
+		case ESP_GATTS_CONGEST_EVT:
+			xSemaphoreTake(mClientMutex, portMAX_DELAY);
+			if(mClient.mActive && mClient.mConnId == param->congest.conn_id)
+			{
+				mClient.mCongested = param->congest.congested;
+			}//End if
+			xSemaphoreGive(mClientMutex);
+			xTaskNotifyGive(mTaskHandle);
+			break;
+
+		case ESP_GATTS_DISCONNECT_EVT:
+			if(param->disconnect.conn_id < CONFIG_BT_ACL_CONNECTIONS)
+			{
+				mAlarmOn[param->disconnect.conn_id] = false;
+			}//End if
+			xSemaphoreTake(mClientMutex, portMAX_DELAY);
+			if(mClient.mActive && mClient.mConnId == param->disconnect.conn_id)
+			{
+				bleStream_RemoveClient();
+			}//End if
+			xSemaphoreGive(mClientMutex);
+			break;
+
+		default:
+			break;
+	}//End switch
+}//End bleStream_GattsHandler
+
+/*
+ * ***********************************************************************
+ * @brief       bleStream_AddClient
+ * @param       connId - Connection that enabled notifications
+ * 				bda - Its address
+ * @return      None
+ * @details     Subscribe the client to the frame bus and ask the central
+ * 				for a short connection interval, 2M PHY and long link layer
+ * 				packets. The first client starts capture, unless a TCP or
+ * 				WebSocket client or the recorder already did. Streaming
+ * 				starts once the client grants credits.
+ **************************************************************************/
+static void bleStream_AddClient(const uint16_t connId, esp_bd_addr_t bda)
+{
+	xSemaphoreTake(mClientMutex, portMAX_DELAY);
+	if(mClient.mActive)
+	{
+		if(mClient.mConnId != connId)
+		{
+			ESP_LOGW(BLSTAG, BLS_WARN_BUSY, connId, mClient.mConnId);
+		}//End if
+		xSemaphoreGive(mClientMutex);
+		return;
+	}//End if
+
+	const frameSubscriber_t sub = framePool_Subscribe("ble", 1, FRAME_POLICY_LATEST_ONLY, mTaskHandle);
+	if(sub == FRAME_BUS_INVALID_ID)
+	{
+		xSemaphoreGive(mClientMutex);
+		return;
+	}//End if
+
+	mClient.mConnId = connId;
+	mClient.mMtu = (connId < CONFIG_BT_ACL_CONNECTIONS) ? mConnMtu[connId] : BLE_STREAM_DEFAULT_MTU;
+	mClient.mCredits = 0;
+	mClient.mCongested = false;
+	mClient.mKeyRequest = true;
+	mClient.mFps = BLE_STREAM_FPS;
+	mClient.mView = BLE_STREAM_VIEW_PREVIEW;
+	mClient.mRoi = 0;
+	mClient.mFrameSub = sub;
+	mClient.mFramesSent = 0;
+	mClient.mActive = true;
+	++mSession;
+	ESP_LOGI(BLSTAG, BLS_INFO_JOIN, connId, mClient.mMtu);
+
+	senxorAcquireCapture();
+	xSemaphoreGive(mClientMutex);
+
+	esp_ble_conn_update_params_t connParams = {0};
+	memcpy(connParams.bda, bda, sizeof(esp_bd_addr_t));
+	connParams.latency = 0;
+	connParams.min_int = BLE_STREAM_CONN_INT_MIN;
+	connParams.max_int = BLE_STREAM_CONN_INT_MAX;
+	connParams.timeout = BLE_STREAM_CONN_TIMEOUT;
+	esp_ble_gap_update_conn_params(&connParams);
+	esp_ble_gap_set_pkt_data_len(bda, BLE_STREAM_DATA_LEN);
+#if CONFIG_BT_BLE_50_FEATURES_SUPPORTED
+	esp_ble_gap_set_preferred_phy(bda, 0, ESP_BLE_GAP_PHY_2M_PREF_MASK, ESP_BLE_GAP_PHY_2M_PREF_MASK, ESP_BLE_GAP_PHY_OPTIONS_NO_PREF);
+#endif
+}//End bleStream_AddClient
+
+/*
+ * ***********************************************************************
+ * @brief       bleStream_RemoveClient
+ * @param       None
+ * @return      None
+ * @details     Release the frame mailbox and the capture reference of
+ * 				the client. Caller must hold mClientMutex.
+ **************************************************************************/
+static void bleStream_RemoveClient(void)
+{
+	ESP_LOGI(BLSTAG, BLS_INFO_LEFT, mClient.mConnId, (unsigned)mClient.mFramesSent);
+
+	framePool_Unsubscribe(mClient.mFrameSub);
+	mClient.mFrameSub = FRAME_BUS_INVALID_ID;
+	mClient.mActive = false;
+	senxorReleaseCapture();
+}//End bleStream_RemoveClient
+
+/*
+ * ***********************************************************************
+ * @brief       bleStream_Control
+ * @param       connId - Connection that wrote the control characteristic
+ * 				pValue, len - Control write, opcode first
+ * @return      None
+ * @details     Writes from a client that is not streaming are ignored,
+ * 				except the recorder trigger
+ **************************************************************************/
+static void bleStream_Control(const uint16_t connId, const uint8_t* pValue, const uint16_t len)
+{
+	if(len == 0)
+	{
+		return;
+	}//End if
+
+	if(pValue[0] == BLE_STREAM_OP_RECORD)
+	{
+		frameRecorderTrigger(REC_TRIGGER_BLE);
+		return;
+	}//End if
+
+	xSemaphoreTake(mClientMutex, portMAX_DELAY);
+	if(!mClient.mActive || mClient.mConnId != connId)
+	{
+		xSemaphoreGive(mClientMutex);
+		return;
+	}//End if
+
+	switch(pValue[0])
+	{
+		case BLE_STREAM_OP_CREDIT:
+			if(len >= 2)
+			{
+				const uint16_t credits = mClient.mCredits + pValue[1];
+				mClient.mCredits = (credits > BLE_STREAM_MAX_CREDITS) ? BLE_STREAM_MAX_CREDITS : credits;
+			}//End if
+			break;
+
+		case BLE_STREAM_OP_VIEW:
+			if(len >= 2)
+			{
+				mClient.mView = (pValue[1] == BLE_STREAM_VIEW_ROI && len >= 3) ? BLE_STREAM_VIEW_ROI : BLE_STREAM_VIEW_PREVIEW;
+				mClient.mRoi = (len >= 3) ? pValue[2] : 0;
+				mClient.mKeyRequest = true;
+			}//End if
+			break;
+
+		case BLE_STREAM_OP_RATE:
+			if(len >= 2 && pValue[1] > 0)
+			{
+				mClient.mFps = (pValue[1] > BLE_STREAM_MAX_FPS) ? BLE_STREAM_MAX_FPS : pValue[1];
+			}//End if
+			break;
+
+		case BLE_STREAM_OP_KEYFRAME:
+			mClient.mKeyRequest = true;
+			break;
+
+		default:
+			break;
+	}//End switch
+	xSemaphoreGive(mClientMutex);
+	xTaskNotifyGive(mTaskHandle);
+}//End bleStream_Control
+
+/*
+ * ***********************************************************************
+ * @brief       bleStream_Send
+ * @param       None
+ * @return      None
+ * @details     Queue notifications while the client has credits and the
+ * 				stack is not congested. A new frame is only taken once the
+ * 				previous one is sent completely. A failed notification
+ * 				drops the rest of the frame, and the next one is a keyframe.
+ **************************************************************************/
+static void bleStream_Send(void)
+{
+	for(;;)
+	{
+		xSemaphoreTake(mClientMutex, portMAX_DELAY);
+		const bleStreamClient_t client = mClient;
+		mClient.mKeyRequest = false;
+		xSemaphoreGive(mClientMutex);
+
+		if(client.mKeyRequest)
+		{
+			mRefValid = false;												//Next frame is a keyframe
+		}//End if
+
+		if(!client.mActive || client.mCredits == 0 || client.mCongested || mGattsIf == ESP_GATT_IF_NONE)
+		{
+			return;
+		}//End if
+
+		if(mTxChunk >= mTxChunkCount && !bleStream_LoadFrame(&client))
+		{
+			return;
+		}//End if
+
+		const uint16_t len = (mMsgLen - mTxOffset > mTxChunkData) ? mTxChunkData : (mMsgLen - mTxOffset);
+		mChunk[0] = mTxFrameId;
+		mChunk[1] = mTxChunk;
+		mChunk[2] = mTxChunkCount;
+		memcpy(&mChunk[BLE_STREAM_CHUNK_HEADER], &mMsg[mTxOffset], len);
+
+		const esp_err_t err = esp_ble_gatts_send_indicate(mGattsIf, client.mConnId, mHandles[BLE_STREAM_IDX_FRAME_VAL],
+				BLE_STREAM_CHUNK_HEADER + len, mChunk, false);
+		if(err != ESP_OK)
+		{
+			ESP_LOGW(BLSTAG, BLS_WARN_SEND, esp_err_to_name(err));
+			mTxChunk = mTxChunkCount;
+			mRefValid = false;
+			return;
+		}//End if
+
+		xSemaphoreTake(mClientMutex, portMAX_DELAY);
+		if(mClient.mCredits > 0)
+		{
+			--mClient.mCredits;
+		}//End if
+		if(++mTxChunk == mTxChunkCount)
+		{
+			++mClient.mFramesSent;
+		}//End if
+		xSemaphoreGive(mClientMutex);
+		mTxOffset += len;
+	}//End for
+}//End bleStream_Send
+
+/*
+ * ***********************************************************************
+ * @brief       bleStream_SendRules
+ * @param       None
+ * @return      None
+ * @details     Notify every rule event not sent yet to the connections
+ * 				with alarm notifications enabled. Events that arrive with
+ * 				no such connection are dropped.
+ **************************************************************************/
+static void bleStream_SendRules(void)
+{
+	ruleEvent_t event;
+
+	while(ruleEngine_GetEvent(&mRuleCursor, &event))
+	{
+		mAlarmValue[0] = event.mRule;
+		mAlarmValue[1] = event.mRaised ? 1 : 0;
+		mAlarmValue[2] = (uint8_t)(event.mValue & 0xFF);
+		mAlarmValue[3] = (uint8_t)(event.mValue >> 8);
+		mAlarmValue[4] = event.mActive;
+		mAlarmValue[5] = (uint8_t)(event.mSeq & 0xFF);
+		mAlarmValue[6] = (uint8_t)((event.mSeq >> 8) & 0xFF);
+		mAlarmValue[7] = (uint8_t)((event.mSeq >> 16) & 0xFF);
+		mAlarmValue[8] = (uint8_t)((event.mSeq >> 24) & 0xFF);
+
+		for(uint8_t i = 0; i < CONFIG_BT_ACL_CONNECTIONS && mGattsIf != ESP_GATT_IF_NONE; i++)
+		{
+			if(mAlarmOn[i])
+			{
+				const esp_err_t err = esp_ble_gatts_send_indicate(mGattsIf, i, mHandles[BLE_STREAM_IDX_ALARM_VAL],
+						sizeof(mAlarmValue), mAlarmValue, false);
+				if(err != ESP_OK)
+				{
+					ESP_LOGW(BLSTAG, BLS_WARN_SEND, esp_err_to_name(err));
+				}//End if
+			}//End if
+		}//End for
+	}//End while
+}//End bleStream_SendRules
+
+/*
+ * ***********************************************************************
+ * @brief       bleStream_LoadFrame
+ * @param       pClient - Copy of the client state
+ * @return      true if a new frame is ready to send
+ * @details     Take the newest frame once it is due at the client rate,
+ * 				cut out the view and code it. A keyframe is sent first, on
+ * 				request, every BLE_STREAM_KEYFRAME_INTERVAL frames and when
+ * 				the view changes. A frame that does not shrink is sent raw.
+ **************************************************************************/
+static bool bleStream_LoadFrame(const bleStreamClient_t* pClient)
+{
+	const int64_t now = esp_timer_get_time();
+	const int64_t periodUs = 1000000 / pClient->mFps;
+
+	if(now < mNextFrameUs - periodUs / 2)
+	{
+		return false;														//Not due yet, the mailbox keeps the newest frame
+	}//End if
+
+	senxorFrame* frame = framePool_TryReceive(pClient->mFrameSub);
+	if(frame == NULL)
+	{
+		return false;
+	}//End if
+
+	bleView_t view;
+	bleStream_GetView(pClient, &view);
+	bleStream_Downsample(&frame->mFrame[BLE_STREAM_IMAGE_OFFSET], &view, mPixels);
+	const uint32_t seq = frame->mSeq;
+	framePool_Release(frame);
+
+	const size_t pixels = (size_t)view.mWidth * view.mHeight;
+	const size_t rawLen = pixels * sizeof(mPixels[0]);
+	bool isKey = !mRefValid || mFramesSinceKey >= BLE_STREAM_KEYFRAME_INTERVAL || memcmp(&view, &mRefView, sizeof(view)) != 0;
+	uint8_t encoding = TCP_STREAM_ENC_DELTA;
+	uint8_t* pPayload = &mMsg[BLE_STREAM_HEADER_SIZE];
+
+	size_t len = frameCodec_EncodeDelta(mPixels, isKey ? NULL : mRefPixels, pixels, mDeltaBuff, rawLen - 1);
+	if(len > 0)
+	{
+		const size_t lzLen = frameCodec_CompressLZ(mDeltaBuff, len, pPayload, len - 1);
+		if(lzLen > 0)
+		{
+			encoding = TCP_STREAM_ENC_DELTA_LZ;
+			len = lzLen;
+		}
+		else
+		{
+			memcpy(pPayload, mDeltaBuff, len);
+		}//End if-else
+	}
+	else
+	{
+		encoding = TCP_STREAM_ENC_RAW16;									//No gain, send it raw
+		isKey = true;
+		len = rawLen;
+		for(size_t i = 0; i < pixels; i++)
+		{
+			pPayload[2 * i] = (uint8_t)(mPixels[i] & 0xFF);
+			pPayload[2 * i + 1] = (uint8_t)(mPixels[i] >> 8);
+		}//End for
+	}//End if-else
+
+	memcpy(mRefPixels, mPixels, rawLen);
+	mRefView = view;
+	mRefValid = true;
+	mFramesSinceKey = isKey ? 0 : (mFramesSinceKey + 1);
+
+	blobRecord_t blobs;
+	const uint16_t blobLen = blobTrack_GetRecord(&blobs);
+	memcpy(&pPayload[len], &blobs, blobLen);
+
+	mMsg[0] = encoding;
+	mMsg[1] = (isKey ? TCP_STREAM_FLAG_KEYFRAME : 0) | ((blobLen > 0) ? TCP_STREAM_FLAG_BLOBS : 0);
+	mMsg[2] = view.mX;
+	mMsg[3] = view.mY;
+	mMsg[4] = view.mWidth;
+	mMsg[5] = view.mHeight;
+	mMsg[6] = view.mStep;
+	mMsg[7] = 0;
+	mMsg[8] = (uint8_t)(seq & 0xFF);
+	mMsg[9] = (uint8_t)((seq >> 8) & 0xFF);
+	mMsg[10] = (uint8_t)((seq >> 16) & 0xFF);
+	mMsg[11] = (uint8_t)((seq >> 24) & 0xFF);
+	mMsg[12] = (uint8_t)(len & 0xFF);
+	mMsg[13] = (uint8_t)((len >> 8) & 0xFF);
+
+	const uint16_t mtu = (pClient->mConnId < CONFIG_BT_ACL_CONNECTIONS) ? mConnMtu[pClient->mConnId] : pClient->mMtu;
+	mMsgLen = (uint16_t)(BLE_STREAM_HEADER_SIZE + len + blobLen);
+	mTxChunkData = mtu - 3 - BLE_STREAM_CHUNK_HEADER;						//ATT notification header is 3 bytes
+	mTxChunkCount = (uint8_t)((mMsgLen + mTxChunkData - 1) / mTxChunkData);
+	mTxChunk = 0;
+	mTxOffset = 0;
+	++mTxFrameId;
+
+	mNextFrameUs += periodUs;												//Fixed grid so the average rate is exact
+	if(mNextFrameUs <= now)
+	{
+		mNextFrameUs = now + periodUs;
+	}//End if
+	return true;
+}//End bleStream_LoadFrame
+
+/*
+ * ***********************************************************************
+ * @brief       bleStream_GetView
+ * @param       pClient - Copy of the client state
+ * 				pView - Output
+ * @return      None
+ * @details     The preview, or the bounding box of the selected ROI. A
+ * 				box larger than BLE_STREAM_MAX_PIXELS is sent in 2 x 2
+ * 				means. An unused ROI falls back to the preview.
+ **************************************************************************/
+static void bleStream_GetView(const bleStreamClient_t* pClient, bleView_t* pView)
+{
+	uint8_t x, y, w, h;
+
+	if(pClient->mView == BLE_STREAM_VIEW_ROI && roiEngine_GetBounds(pClient->mRoi, &x, &y, &w, &h))
+	{
+		const uint8_t step = ((uint16_t)w * h > BLE_STREAM_MAX_PIXELS) ? BLE_STREAM_PREVIEW_STEP : 1;
+		pView->mX = x;
+		pView->mY = y;
+		pView->mStep = step;
+		pView->mWidth = (w + step - 1) / step;
+		pView->mHeight = (h + step - 1) / step;
+		while((uint16_t)pView->mWidth * pView->mHeight > BLE_STREAM_MAX_PIXELS)
+		{
+			--pView->mHeight;												//Odd box of nearly the full image
+		}//End while
+		return;
+	}//End if
+
+	pView->mX = 0;
+	pView->mY = 0;
+	pView->mStep = BLE_STREAM_PREVIEW_STEP;
+	pView->mWidth = SENXOR_FRAME_WIDTH / BLE_STREAM_PREVIEW_STEP;
+	pView->mHeight = SENXOR_FRAME_HEIGHT / BLE_STREAM_PREVIEW_STEP;
+}//End bleStream_GetView
+
+/*
+ * ***********************************************************************
+ * @brief       bleStream_Downsample
+ * @param       pImage - 80 x 62 image
+ * 				pView - Area to cut out
+ * 				pOut - mWidth x mHeight pixels
+ * @return      None
+ * @details     Rounded mean of each block, blocks at the image edge only
+ * 				count the pixels inside the image
+ **************************************************************************/
+static void bleStream_Downsample(const uint16_t* pImage, const bleView_t* pView, uint16_t* pOut)
+{
+	for(uint8_t r = 0; r < pView->mHeight; r++)
+	{
+		for(uint8_t c = 0; c < pView->mWidth; c++)
+		{
+			uint32_t sum = 0;
+			uint8_t count = 0;
+
+			for(uint8_t dy = 0; dy < pView->mStep; dy++)
+			{
+				const uint16_t y = pView->mY + r * pView->mStep + dy;
+				if(y >= SENXOR_FRAME_HEIGHT)
+				{
+					break;
+				}//End if
+				for(uint8_t dx = 0; dx < pView->mStep; dx++)
+				{
+					const uint16_t x = pView->mX + c * pView->mStep + dx;
+					if(x >= SENXOR_FRAME_WIDTH)
+					{
+						break;
+					}//End if
+					sum += pImage[y * SENXOR_FRAME_WIDTH + x];
+					++count;
+				}//End for
+			}//End for
+
+			*pOut++ = (count > 0) ? (uint16_t)((sum + count / 2) / count) : 0;
+		}//End for
+	}//End for
+}//End bleStream_Downsample
+
+#else
+
+bool bleStreamGetIsClientConnected(void)
+{
+	return false;
+}//End bleStreamGetIsClientConnected
+
+void bleStreamNotifyRule(void)
+{
+}//End bleStreamNotifyRule
+
+#endif
@@ -0,0 +1,494 @@
+/*****************************************************************************
+ * @file     blobTrack.c
+ * @version  1.00
+ * @brief    Hot spot blobs of the thermal image and their tracking.
+ * @date	 15 Oct 2026
+ * @details	 One pass over the image cuts every row into runs of pixels at
+ * 			 or above the threshold. Each run is joined to the runs of the
+ * 			 row above that touch it, sides or corners, with a union-find
+ * 			 whose root is the first run of the blob. A second pass over the
+ * 			 runs, not the pixels, adds up area, centroid and peak per root.
+ *
+ * 			 The largest BLOB_MAX blobs of at least the minimum area are
+ * 			 matched to the tracks of the previous frames, nearest centroid
+ * 			 first within BLOB_TRACK_RADIUS, so a blob keeps its ID while it
+ * 			 moves. A track without a match coasts for BLOB_TRACK_MISSES
+ * 			 frames, then is reported lost once.
+ *
+ * 			 Runs in senxorAnalyse. The record of the last frame is taken by
+ * 			 the v2 stream header and the BLE stream messages.
+ ******************************************************************************/
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <esp_log.h>
+
+#include "blobTrack.h"
+
+#if CONFIG_MI_BLOB_EN
+
+//private:
+// Run of pixels at or above the threshold in one row
+typedef struct blobRun{
+	uint16_t mParent;						//Union-find parent, the run itself for a root
+	uint8_t mY;
+	uint8_t mX0;							//First and last column, both included
+	uint8_t mX1;
+	uint8_t mPeakX;
+	uint16_t mPeak;
+}blobRun_t;
+
+// Sums of one blob while its runs are measured
+typedef struct blobStat{
+	uint32_t mSum2X;						//Twice the sum of the columns
+	uint32_t mSumY;
+	uint16_t mArea;
+	uint16_t mPeak;
+	uint8_t mPeakX;
+	uint8_t mPeakY;
+}blobStat_t;
+
+typedef struct blobTrackSlot{
+	bool mActive;
+	bool mMatched;							//Matched in the current frame
+	uint8_t mMisses;						//Frames without a match
+	blobEntry_t mLast;						//Last reported entry
+}blobTrackSlot_t;
+
+static blobRun_t mRuns[BLOB_MAX_RUNS];
+static blobStat_t mStats[BLOB_MAX_CANDIDATES];
+static uint8_t mStatOf[BLOB_MAX_RUNS];									//Entry of mStats of a root run, 0xFF if not measured
+static blobTrackSlot_t mTracks[BLOB_MAX_TRACKS];
+static uint8_t mNextId = 1;
+
+static portMUX_TYPE mLock = portMUX_INITIALIZER_UNLOCKED;
+static uint16_t mThreshold = BLOB_DEFAULT_THRESHOLD;					//Written by the command tasks
+static uint8_t mMinArea = BLOB_DEFAULT_MIN_AREA;
+static blobRecord_t mRecord;											//Read by the transport tasks
+
+static uint16_t blobTrack_Label(const uint16_t* pImage, const uint16_t threshold, uint8_t* pFlags);
+static uint8_t blobTrack_Measure(const uint16_t runCount, uint8_t* pFlags);
+static void blobTrack_Select(const uint8_t statCount, const uint8_t minArea, blobRecord_t* pRecord);
+static void blobTrack_Match(blobRecord_t* pRecord);
+static uint8_t blobTrack_NewTrack(void);
+
+static inline uint16_t blobTrack_Find(uint16_t run)
+{
+	while (mRuns[run].mParent != run)
+	{
+		mRuns[run].mParent = mRuns[mRuns[run].mParent].mParent;		//Path halving
+		run = mRuns[run].mParent;
+	}//End while
+	return run;
+}
+
+static inline void blobTrack_Union(const uint16_t a, const uint16_t b)
+{
+	const uint16_t rootA = blobTrack_Find(a);
+	const uint16_t rootB = blobTrack_Find(b);
+
+	if (rootA < rootB)
+	{
+		mRuns[rootB].mParent = rootA;
+	}
+	else if (rootB < rootA)
+	{
+		mRuns[rootA].mParent = rootB;
+	}//End if
+}
+
+/*
+ * ***********************************************************************
+ * @brief       blobTrack_Process
+ * @param       pImage - Image of the frame, header rows removed
+ * 				seq - Capture sequence number of the frame
+ * @return      None
+ * @details     Called by senxorAnalyse for every analysed frame
+ **************************************************************************/
+void blobTrack_Process(const uint16_t* pImage, const uint32_t seq)
+{
+	taskENTER_CRITICAL(&mLock);
+	const uint16_t threshold = mThreshold;
+	const uint8_t minArea = mMinArea;
+	taskEXIT_CRITICAL(&mLock);
+
+	blobRecord_t record = {
+		.mSeq = seq,
+		.mCount = 0,
+		.mFlags = 0
+	};
+
+	if (threshold == 0)
+	{
+		memset(mTracks, 0, sizeof(mTracks));
+	}
+	else
+	{
+		const uint16_t runCount = blobTrack_Label(pImage, threshold, &record.mFlags);
+		const uint8_t statCount = blobTrack_Measure(runCount, &record.mFlags);
+		blobTrack_Select(statCount, minArea, &record);
+		blobTrack_Match(&record);
+	}//End if-else
+
+	taskENTER_CRITICAL(&mLock);
+	mRecord = record;
+	taskEXIT_CRITICAL(&mLock);
+}//End blobTrack_Process
+
+/*
+ * ***********************************************************************
+ * @brief       blobTrack_GetRecord
+ * @param       pRecord - Output, blobs of the last analysed frame
+ * @return      Bytes of the record to send, 0 when blob detection is off
+ **************************************************************************/
+uint16_t blobTrack_GetRecord(blobRecord_t* pRecord)
+{
+	taskENTER_CRITICAL(&mLock);
+	*pRecord = mRecord;
+	const bool enabled = (mThreshold != 0);
+	taskEXIT_CRITICAL(&mLock);
+
+	return enabled ? (uint16_t)(BLOB_RECORD_HEADER + pRecord->mCount * sizeof(blobEntry_t)) : 0;
+}//End blobTrack_GetRecord
+
+/*
+ * ***********************************************************************
+ * @brief       blobTrack_Configure
+ * @param       threshold - Smallest pixel of a blob, raw frame units, 0 = off
+ * 				minArea - Smallest blob reported, pixels
+ * @return      None
+ * @details     Not persisted, the Kconfig defaults apply after a reboot
+ **************************************************************************/
+void blobTrack_Configure(const uint16_t threshold, const uint8_t minArea)
+{
+	taskENTER_CRITICAL(&mLock);
+	mThreshold = threshold;
+	mMinArea = (minArea > 0) ? minArea : 1;
+	taskEXIT_CRITICAL(&mLock);
+
+	ESP_LOGI(BLOBTAG, BLOB_INFO_CONFIG, threshold, mMinArea);
+}//End blobTrack_Configure
+
+/*
+ * ***********************************************************************
+ * @brief       blobTrack_GetStatus
+ * @param       pThreshold - Output, threshold in use, 0 = off
+ * 				pMinArea - Output, smallest blob reported
+ * 				pCount - Output, blobs of the last analysed frame
+ * @return      None
+ **************************************************************************/
+void blobTrack_GetStatus(uint16_t* pThreshold, uint8_t* pMinArea, uint8_t* pCount)
+{
+	taskENTER_CRITICAL(&mLock);
+	*pThreshold = mThreshold;
+	*pMinArea = mMinArea;
+	*pCount = mRecord.mCount;
+	taskEXIT_CRITICAL(&mLock);
+}//End blobTrack_GetStatus
+
+/*
+ * ***********************************************************************
+ * @brief       blobTrack_Label
+ * @param       pImage - Image of the frame
+ * 				threshold - Smallest pixel of a blob
+ * 				pFlags - Record flags, BLOB_REC_OVERFLOW is set when the
+ * 				run table is full
+ * @return      Runs found
+ * @details     Runs of consecutive rows are joined when they overlap or
+ * 				touch at a corner. Both rows are sorted by column, so a
+ * 				merge walk finds every pair.
+ **************************************************************************/
+static uint16_t blobTrack_Label(const uint16_t* pImage, const uint16_t threshold, uint8_t* pFlags)
+{
+	uint16_t count = 0;
+	uint16_t prevFirst = 0;
+	bool full = false;
+
+	for (uint8_t y = 0; y < BLOB_HEIGHT && !full; y++)
+	{
+		const uint16_t* pRow = &pImage[y * BLOB_WIDTH];
+		const uint16_t first = count;
+		uint8_t x = 0;
+
+		while (x < BLOB_WIDTH)
+		{
+			if (pRow[x] < threshold)
+			{
+				x++;
+				continue;
+			}//End if
+			if (count == BLOB_MAX_RUNS)
+			{
+				full = true;
+				break;
+			}//End if
+
+			blobRun_t* pRun = &mRuns[count];
+			pRun->mParent = count;
+			pRun->mY = y;
+			pRun->mX0 = x;
+			pRun->mPeak = pRow[x];
+			pRun->mPeakX = x;
+			while (x < BLOB_WIDTH && pRow[x] >= threshold)
+			{
+				if (pRow[x] > pRun->mPeak)
+				{
+					pRun->mPeak = pRow[x];
+					pRun->mPeakX = x;
+				}//End if
+				x++;
+			}//End while
+			pRun->mX1 = x - 1;
+			count++;
+		}//End while
+
+		uint16_t i = prevFirst;
+		uint16_t j = first;
+		while (i < first && j < count)
+		{
+			if (mRuns[i].mX0 <= mRuns[j].mX1 + 1 && mRuns[i].mX1 + 1 >= mRuns[j].mX0)
+			{
+				blobTrack_Union(i, j);
+			}//End if
+			if (mRuns[i].mX1 < mRuns[j].mX1)
+			{
+				i++;
+			}
+			else
+			{
+				j++;
+			}//End if-else
+		}//End while
+		prevFirst = first;
+	}//End for
+
+	if (full)
+	{
+		*pFlags |= BLOB_REC_OVERFLOW;
+	}//End if
+	return count;
+}//End blobTrack_Label
+
+/*
+ * ***********************************************************************
+ * @brief       blobTrack_Measure
+ * @param       runCount - Runs of the frame
+ * 				pFlags - Record flags, BLOB_REC_OVERFLOW is set when there
+ * 				are more blobs than BLOB_MAX_CANDIDATES
+ * @return      Blobs measured
+ * @details     A root is the first run of its blob, so its entry exists
+ * 				before any other run of the blob is added to it.
+ **************************************************************************/
+static uint8_t blobTrack_Measure(const uint16_t runCount, uint8_t* pFlags)
+{
+	uint8_t count = 0;
+
+	for (uint16_t r = 0; r < runCount; r++)
+	{
+		const uint16_t root = blobTrack_Find(r);
+		if (root == r)
+		{
+			if (count == BLOB_MAX_CANDIDATES)
+			{
+				mStatOf[r] = 0xFF;
+				*pFlags |= BLOB_REC_OVERFLOW;
+				continue;
+			}//End if
+			mStatOf[r] = count;
+			memset(&mStats[count], 0, sizeof(mStats[count]));
+			count++;
+		}//End if
+
+		const uint8_t idx = mStatOf[root];
+		if (idx == 0xFF)
+		{
+			continue;
+		}//End if
+
+		const blobRun_t* pRun = &mRuns[r];
+		blobStat_t* pStat = &mStats[idx];
+		const uint16_t len = pRun->mX1 - pRun->mX0 + 1;
+		pStat->mArea += len;
+		pStat->mSum2X += (uint32_t)(pRun->mX0 + pRun->mX1) * len;
+		pStat->mSumY += (uint32_t)pRun->mY * len;
+		if (pRun->mPeak > pStat->mPeak)
+		{
+			pStat->mPeak = pRun->mPeak;
+			pStat->mPeakX = pRun->mPeakX;
+			pStat->mPeakY = pRun->mY;
+		}//End if
+	}//End for
+
+	return count;
+}//End blobTrack_Measure
+
+/*
+ * ***********************************************************************
+ * @brief       blobTrack_Select
+ * @param       statCount - Blobs measured
+ * 				minArea - Smallest blob reported
+ * 				pRecord - Gets the largest BLOB_MAX blobs, largest first,
+ * 				without their IDs
+ * @return      None
+ **************************************************************************/
+static void blobTrack_Select(const uint8_t statCount, const uint8_t minArea, blobRecord_t* pRecord)
+{
+	while (pRecord->mCount < BLOB_MAX)
+	{
+		uint8_t best = 0xFF;
+		uint16_t bestArea = minArea;
+		for (uint8_t i = 0; i < statCount; i++)
+		{
+			if (mStats[i].mArea >= bestArea)
+			{
+				best = i;
+				bestArea = mStats[i].mArea + 1;									//Ties go to the first blob
+			}//End if
+		}//End for
+		if (best == 0xFF)
+		{
+			break;
+		}//End if
+
+		blobStat_t* pStat = &mStats[best];
+		blobEntry_t* pEntry = &pRecord->mBlob[pRecord->mCount++];
+		pEntry->mId = 0;
+		pEntry->mFlags = 0;
+		pEntry->mArea = pStat->mArea;
+		pEntry->mPeak = pStat->mPeak;
+		pEntry->mPeakX = pStat->mPeakX;
+		pEntry->mPeakY = pStat->mPeakY;
+		pEntry->mCx = (uint16_t)((pStat->mSum2X * 128 + pStat->mArea / 2) / pStat->mArea);
+		pEntry->mCy = (uint16_t)((pStat->mSumY * 256 + pStat->mArea / 2) / pStat->mArea);
+		pStat->mArea = 0;														//Taken
+	}//End while
+}//End blobTrack_Select
+
+/*
+ * ***********************************************************************
+ * @brief       blobTrack_Match
+ * @param       pRecord - Blobs of the frame, get their IDs. Tracks that
+ * 				end are appended as lost while there is room.
+ * @return      None
+ * @details     Larger blobs choose first, each takes the nearest free
+ * 				track within BLOB_TRACK_RADIUS or starts a new one.
+ **************************************************************************/
+static void blobTrack_Match(blobRecord_t* pRecord)
+{
+	const int32_t maxDist = (BLOB_TRACK_RADIUS * 256) * (BLOB_TRACK_RADIUS * 256);
+
+	for (uint8_t t = 0; t < BLOB_MAX_TRACKS; t++)
+	{
+		mTracks[t].mMatched = false;
+	}//End for
+
+	for (uint8_t b = 0; b < pRecord->mCount; b++)
+	{
+		blobEntry_t* pEntry = &pRecord->mBlob[b];
+		uint8_t best = 0xFF;
+		int32_t bestDist = maxDist;
+
+		for (uint8_t t = 0; t < BLOB_MAX_TRACKS; t++)
+		{
+			if (!mTracks[t].mActive || mTracks[t].mMatched)
+			{
+				continue;
+			}//End if
+			const int32_t dx = (int32_t)pEntry->mCx - mTracks[t].mLast.mCx;
+			const int32_t dy = (int32_t)pEntry->mCy - mTracks[t].mLast.mCy;
+			const int32_t dist = dx * dx + dy * dy;
+			if (dist <= bestDist)
+			{
+				best = t;
+				bestDist = dist;
+			}//End if
+		}//End for
+
+		if (best == 0xFF)
+		{
+			best = blobTrack_NewTrack();
+			pEntry->mFlags |= BLOB_FLAG_NEW;
+		}//End if
+		pEntry->mId = mTracks[best].mLast.mId;
+		mTracks[best].mMatched = true;
+		mTracks[best].mMisses = 0;
+		mTracks[best].mLast = *pEntry;
+	}//End for
+
+	for (uint8_t t = 0; t < BLOB_MAX_TRACKS; t++)
+	{
+		blobTrackSlot_t* pTrack = &mTracks[t];
+		if (!pTrack->mActive || pTrack->mMatched || ++pTrack->mMisses <= BLOB_TRACK_MISSES)
+		{
+			continue;
+		}//End if
+		pTrack->mActive = false;
+		if (pRecord->mCount < BLOB_MAX)
+		{
+			blobEntry_t* pEntry = &pRecord->mBlob[pRecord->mCount++];
+			*pEntry = pTrack->mLast;
+			pEntry->mFlags = BLOB_FLAG_LOST;
+		}//End if
+	}//End for
+}//End blobTrack_Match
+
+/*
+ * ***********************************************************************
+ * @brief       blobTrack_NewTrack
+ * @param       None
+ * @return      Slot of a new track with a new ID
+ * @details     Takes a free slot, or the unmatched track that has coasted
+ * 				longest. There are more slots than blobs in a record, so
+ * 				one of the two always exists.
+ **************************************************************************/
+static uint8_t blobTrack_NewTrack(void)
+{
+	uint8_t slot = 0xFF;
+
+	for (uint8_t t = 0; t < BLOB_MAX_TRACKS; t++)
+	{
+		if (!mTracks[t].mActive)
+		{
+			slot = t;
+			break;
+		}//End if
+		if (!mTracks[t].mMatched && (slot == 0xFF || mTracks[t].mMisses > mTracks[slot].mMisses))
+		{
+			slot = t;
+		}//End if
+	}//End for
+
+	mTracks[slot].mActive = true;
+	mTracks[slot].mMisses = 0;
+	mTracks[slot].mLast.mId = mNextId;
+	mNextId = (mNextId == UINT8_MAX) ? 1 : (mNextId + 1);
+	return slot;
+}//End blobTrack_NewTrack
+
+#else
+
+void blobTrack_Process(const uint16_t* pImage, const uint32_t seq)
+{
+	(void)pImage;
+	(void)seq;
+}//End blobTrack_Process
+
+uint16_t blobTrack_GetRecord(blobRecord_t* pRecord)
+{
+	(void)pRecord;
+	return 0;
+}//End blobTrack_GetRecord
+
+void blobTrack_Configure(const uint16_t threshold, const uint8_t minArea)
+{
+	(void)threshold;
+	(void)minArea;
+}//End blobTrack_Configure
+
+void blobTrack_GetStatus(uint16_t* pThreshold, uint8_t* pMinArea, uint8_t* pCount)
+{
+	*pThreshold = 0;
+	*pMinArea = 0;
+	*pCount = 0;
+}//End blobTrack_GetStatus
+
+#endif
@@ -0,0 +1,104 @@
+/*****************************************************************************
+ * @file     bootTimeline.c
+ * @version  1.01
+ * @brief    Time of every boot milestone, reported on GET /info.
+ * @date	 14 Oct 2026
+ * @details	 Times are in microseconds of esp_timer, which starts before
+ * 			 app_main, so they read as time since power-on. A milestone is
+ * 			 recorded once, later calls only cost a load and a compare, so
+ * 			 the frame path can mark its first frame without a flag of
+ * 			 its own.
+ ******************************************************************************/
+#include <stdio.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_event.h>
+#include <esp_netif.h>
+#include <freertos/FreeRTOS.h>
+
+#include "bootTimeline.h"
+
+//private:
+static int64_t mMarkUs[BOOT_MARK_COUNT] = {0};						//0 until the milestone is reached
+static portMUX_TYPE mMarkLock = portMUX_INITIALIZER_UNLOCKED;			//64 bit stores are two words
+static const char* const mMarkName[BOOT_MARK_COUNT] = {
+	"peri", "senxor", "wlan", "rest", "servers", "bt", "ip", "first_frame", "first_send"
+};
+
+static void bootTimelineIpHandler(void* arg, esp_event_base_t base, int32_t id, void* data);
+
+/*
+ * ***********************************************************************
+ * @brief       bootTimelineInit
+ * @param       None
+ * @return      None
+ * @details     Watch for the first station IP. Call after Drv_WLAN_Init,
+ * 				which creates the default event loop.
+ **************************************************************************/
+void bootTimelineInit(void)
+{
+	esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &bootTimelineIpHandler, NULL, NULL);
+}
+
+/*
+ * ***********************************************************************
+ * @brief       bootTimelineMark
+ * @param       mark - Milestone reached
+ * @return      None
+ * @details     Record the time of mark, if not recorded yet
+ **************************************************************************/
+void bootTimelineMark(const bootMark_t mark)
+{
+	if (mark >= BOOT_MARK_COUNT || mMarkUs[mark] != 0) {
+		return;
+	}
+	const int64_t nowUs = esp_timer_get_time();
+
+	taskENTER_CRITICAL(&mMarkLock);
+	mMarkUs[mark] = nowUs;
+	taskEXIT_CRITICAL(&mMarkLock);
+	ESP_LOGI(BOOTTAG, BOOT_INFO_MARK, mMarkName[mark], nowUs / 1000);
+}
+
+/*
+ * ***********************************************************************
+ * @brief       bootTimelineGetRptToJson
+ * @param       pWriter - Writer inside the object to add the milestones to
+ * @return      None
+ * @details     Add "<milestone>_ms" for every milestone, null if not
+ * 				reached yet, and the current uptime
+ **************************************************************************/
+void bootTimelineGetRptToJson(jsonWriter_t* pWriter)
+{
+	char key[24];
+	int64_t markUs[BOOT_MARK_COUNT];
+
+	taskENTER_CRITICAL(&mMarkLock);
+	for (uint8_t i = 0; i < BOOT_MARK_COUNT; i++) {
+		markUs[i] = mMarkUs[i];
+	}
+	taskEXIT_CRITICAL(&mMarkLock);
+
+	for (uint8_t i = 0; i < BOOT_MARK_COUNT; i++) {
+		snprintf(key, sizeof(key), "%s_ms", mMarkName[i]);
+		if (markUs[i] == 0) {
+			jsonAddNull(pWriter, key);
+		} else {
+			jsonAddInt(pWriter, key, markUs[i] / 1000);
+		}
+	}
+	jsonAddInt(pWriter, "uptime_ms", esp_timer_get_time() / 1000);
+}
+
+/*
+ * ***********************************************************************
+ * @brief       bootTimelineIpHandler
+ * @param       Event handler arguments, not used
+ * @return      None
+ * @details     Runs in the event loop task, next to the WLAN driver's own
+ * 				handler
+ **************************************************************************/
+static void bootTimelineIpHandler(void* arg, esp_event_base_t base, int32_t id, void* data)
+{
+	bootTimelineMark(BOOT_MARK_IP);
+}
@@ -0,0 +1,119 @@
+/*****************************************************************************
+ * @file     classifierModel.cc
+ * @version  1.00
+ * @brief    TensorFlow Lite Micro interpreter of the flame and pan classifier.
+ * @date	 15 Oct 2026
+ * @details	 The model is the .tflite file of CONFIG_MI_CLASSIFY_MODEL,
+ * 			 embedded in the image by main/CMakeLists.txt. It must be fully
+ * 			 int8 quantised: input 1 x height x width x 1 in Kelvin, output
+ * 			 one score per clsClass_t, in that order. The esp-tflite-micro
+ * 			 component runs the convolution, pooling, fully connected and
+ * 			 softmax kernels with the ESP-NN SIMD versions of the ESP32-S3.
+ *
+ * 			 The only C++ in the firmware, kept behind the C interface of
+ * 			 classifierModel.h. The tensor arena is passed in by
+ * 			 frameClassifier.c.
+ ******************************************************************************/
+#include <esp_log.h>
+
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+#include "classifierModel.h"
+#include "frameClassifier.h"
+
+#define CLS_MODEL_OPS				10
+
+// Embedded by main/CMakeLists.txt under a fixed name
+extern const uint8_t mModelStart[] asm("_binary_classifier_model_tflite_start");
+
+//private:
+static tflite::MicroInterpreter* pInterpreter = nullptr;
+static TfLiteTensor* pOutput = nullptr;
+
+/*
+ * ***********************************************************************
+ * @brief       classifierModel_Init
+ * @param       pArena - Tensor arena, 16 byte aligned
+ * 				arenaSize - Bytes in the arena
+ * 				pInput - Output, the input tensor and its quantisation
+ * @return      false if the model does not fit the arena or the contract
+ * @details     Called once by frameClassifierTask
+ **************************************************************************/
+bool classifierModel_Init(uint8_t* pArena, const size_t arenaSize, clsInput_t* pInput)
+{
+	const tflite::Model* pModel = tflite::GetModel(mModelStart);
+	if (pModel->version() != TFLITE_SCHEMA_VERSION)
+	{
+		ESP_LOGE(CLSTAG, CLS_ERR_SCHEMA, pModel->version(), TFLITE_SCHEMA_VERSION);
+		return false;
+	}//End if
+
+	static tflite::MicroMutableOpResolver<CLS_MODEL_OPS> resolver;
+	resolver.AddConv2D();
+	resolver.AddDepthwiseConv2D();
+	resolver.AddMaxPool2D();
+	resolver.AddAveragePool2D();
+	resolver.AddMean();
+	resolver.AddFullyConnected();
+	resolver.AddAdd();
+	resolver.AddRelu();
+	resolver.AddReshape();
+	resolver.AddSoftmax();
+
+	static tflite::MicroInterpreter interpreter(pModel, resolver, pArena, arenaSize);
+	if (interpreter.AllocateTensors() != kTfLiteOk)
+	{
+		return false;
+	}//End if
+
+	TfLiteTensor* pIn = interpreter.input(0);
+	pOutput = interpreter.output(0);
+	if (pIn->type != kTfLiteInt8 || pIn->dims->size != 4 || pIn->dims->data[3] != 1 || pOutput->type != kTfLiteInt8)
+	{
+		return false;
+	}//End if
+	const int height = pIn->dims->data[1];
+	const int width = pIn->dims->data[2];
+	const int classes = pOutput->dims->data[pOutput->dims->size - 1];
+	if (height < 1 || height > CLS_HEIGHT || width < 1 || width > CLS_WIDTH || classes < CLS_CLASS_COUNT || classes > UINT8_MAX)
+	{
+		return false;
+	}//End if
+
+	pInput->pData = pIn->data.int8;
+	pInput->mScale = pIn->params.scale;
+	pInput->mZeroPoint = pIn->params.zero_point;
+	pInput->mWidth = (uint8_t)width;
+	pInput->mHeight = (uint8_t)height;
+	pInput->mClasses = (uint8_t)classes;
+	pInput->mArenaUsed = interpreter.arena_used_bytes();
+	pInterpreter = &interpreter;
+	return true;
+}//End classifierModel_Init
+
+/*
+ * ***********************************************************************
+ * @brief       classifierModel_Invoke
+ * @param       pScore - Output, score of the first count classes, permille
+ * 				count - Scores wanted, at most clsInput_t.mClasses
+ * @return      false if the interpreter failed
+ * @details     The input tensor is filled by the caller
+ **************************************************************************/
+bool classifierModel_Invoke(uint16_t* pScore, const uint8_t count)
+{
+	if (pInterpreter == nullptr || pInterpreter->Invoke() != kTfLiteOk)
+	{
+		return false;
+	}//End if
+
+	const float scale = pOutput->params.scale * 1000.0f;
+	const int32_t zeroPoint = pOutput->params.zero_point;
+	for (uint8_t i = 0; i < count; i++)
+	{
+		const float permille = (pOutput->data.int8[i] - zeroPoint) * scale + 0.5f;
+		pScore[i] = (permille <= 0.0f) ? 0 : (permille >= 1000.0f) ? 1000 : (uint16_t)permille;
+	}//End for
+	return true;
+}//End classifierModel_Invoke
@@ -1,17 +1,28 @@
 /*****************************************************************************
  * @file     cmdServerTask.c
- * @version  1.0
- * @brief    Command server for handling WREG/RREG/RRSE commands on separate port
+ * @version  1.3
+ * @brief    Command server for handling WREG/RREG/RRSE commands on separate port,
+ *           and pushing SUBS register subscriptions and ALRM rule events
  * @date     31 Dec 2024
+ * @details  One task serves up to CMD_MAX_CLIENTS clients with select().
+ *           Every client has its own streaming parser, so commands split
+ *           across TCP segments and several commands in one segment are
+ *           handled, and answered in order. Client sockets do not block,
+ *           output the socket does not take is queued per client and sent
+ *           once it is writable, RECD clips included.
  *****************************************************************************/
 #include <stdint.h>
+#include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
 #include <sys/param.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <esp_system.h>
 #include <esp_log.h>
+#include <esp_vfs_eventfd.h>
 
 #include <lwip/err.h>
 #include <lwip/sockets.h>
@@ -20,20 +31,31 @@
 
 #include "cmdServerTask.h"
 #include "cmdParser.h"
+#include "senxorTask.h"
+#include "frameRecorder.h"
+#include "ruleEngine.h"
+#include "Drv_CRC.h"
+#include "protoSchema.h"
 
 #define CMDTAG "[CMD_SERVER]"
 
 // Buffers
-static uint8_t mRxBuff[128];
-static uint8_t mAckBuff[64];
-static cmdPhaser mCmdPhaserObj;
+static uint8_t mRxBuff[512];
+static uint8_t mAckBuff[256];
+static uint8_t mPushBuff[128];
+static TaskHandle_t mCmdTaskHandle = NULL;
+static uint32_t mRuleCursor = 0;         // Next rule event to push
+static int mWakeFd = -1;                 // eventfd signalled on new register values, wakes up select()
 
 // Socket file descriptors
 static int cmd_server_sock = -1;
-static int cmd_client_sock = -1;
+
+// Clients
+static cmdClient_t mClients[CMD_MAX_CLIENTS];
+static volatile uint8_t mClientCount = 0;
+static int8_t mCurrentClient = -1;       // Client whose command is being executed
 
 // Flags
-static volatile bool isClientConnected = false;
 static volatile uint8_t pollFreqHz = 0;  // Poll frequency in Hz (0 = stopped)
 
 // TCP keepalive settings
@@ -41,14 +63,15 @@ static int keepAlive = 1;
 static int keepIdle = 5;
 static int keepInterval = 5;
 static int keepCount = 3;
+static int cmdTos = CMD_SERVER_TOS;
 
 /******************************************************************************
  * @brief       cmdServerGetIsClientConnected
- * @return      true if command client is connected
+ * @return      true if a command client is connected
  *****************************************************************************/
 bool cmdServerGetIsClientConnected(void)
 {
-    return isClientConnected;
+    return mClientCount > 0;
 }
 
 /******************************************************************************
@@ -70,12 +93,124 @@ void cmdServerSetPollFreqHz(uint8_t freqHz)
         freqHz = POLL_MAX_FREQ_HZ;
     }
     pollFreqHz = freqHz;
+    senxorTaskNotifyClientChange();
     ESP_LOGI(CMDTAG, "Poll frequency set to %d Hz", pollFreqHz);
 }
 
+/******************************************************************************
+ * @brief       cmdServerSubscribe
+ * @param       pAddr - Registers to push
+ *              count - Number of registers, 0 ends the subscription
+ *              intervalMs - Minimum time between two pushes (0 = every frame)
+ *              threshold - Minimum change of a register before it is pushed again (0 = any change)
+ * @return      false if the command did not come from a command client
+ * @details     Applies to the client that sent the SUBS command
+ *****************************************************************************/
+bool cmdServerSubscribe(const uint8_t* pAddr, const uint8_t count, const uint16_t intervalMs, const uint16_t threshold)
+{
+    if (xTaskGetCurrentTaskHandle() != mCmdTaskHandle || mCurrentClient < 0 || count > SUBS_MAX_REGS) {
+        return false;
+    }
+
+    cmdClient_t* pClient = &mClients[mCurrentClient];
+    memcpy(pClient->mSubRegs, pAddr, count);
+    pClient->mSubCount = count;
+    pClient->mSubIntervalMs = intervalMs;
+    pClient->mSubThreshold = threshold;
+    pClient->mSubPrimed = false;
+    senxorTaskNotifyClientChange();
+
+    ESP_LOGI(CMDTAG, "Subscription of %s: %d registers, %d ms, threshold %d", pClient->mAddr, count, intervalMs, threshold);
+    return true;
+}
+
+/******************************************************************************
+ * @brief       cmdServerGetCurrentAddr
+ * @return      Address of the client whose command is executing, NULL if
+ *              not called by a command of a command client
+ * @details     Lets a command act on the other connections of the same host
+ *****************************************************************************/
+const char* cmdServerGetCurrentAddr(void)
+{
+    if (xTaskGetCurrentTaskHandle() != mCmdTaskHandle || mCurrentClient < 0) {
+        return NULL;
+    }
+    return mClients[mCurrentClient].mAddr;
+}
+
+/******************************************************************************
+ * @brief       cmdServerGetSubscribedRateHz
+ * @return      Highest frame rate any register subscription needs, 0 if none
+ * @details     A subscription without a minimum interval wants every frame
+ *****************************************************************************/
+uint8_t cmdServerGetSubscribedRateHz(void)
+{
+    uint8_t rateHz = 0;
+
+    for (uint8_t i = 0; i < CMD_MAX_CLIENTS; i++) {
+        if (mClients[i].mSock < 0 || mClients[i].mSubCount == 0) {
+            continue;
+        }
+        const uint16_t intervalMs = mClients[i].mSubIntervalMs;
+        const uint32_t clientHz = (intervalMs == 0) ? POLL_MAX_FREQ_HZ : (1000 + intervalMs - 1) / intervalMs;
+        rateHz = MAX(rateHz, (uint8_t)MIN(clientHz, POLL_MAX_FREQ_HZ));
+    }
+    return rateHz;
+}
+
+/******************************************************************************
+ * @brief       cmdServerGetIsSubscribed
+ * @return      true if a command client has a register subscription
+ *****************************************************************************/
+bool cmdServerGetIsSubscribed(void)
+{
+    for (uint8_t i = 0; i < CMD_MAX_CLIENTS; i++) {
+        if (mClients[i].mSock >= 0 && mClients[i].mSubCount > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/******************************************************************************
+ * @brief       cmdServerWake
+ * @details     Wake up the select() of the command task
+ *****************************************************************************/
+static void cmdServerWake(void)
+{
+    if (mWakeFd >= 0) {
+        const uint64_t one = 1;
+        write(mWakeFd, &one, sizeof(one));
+    }
+}
+
+/******************************************************************************
+ * @brief       cmdServerNotifyUpdate
+ * @details     Called by senxorTask once the registers of a new frame are ready.
+ *              The task notification marks the update for cmdServerPush.
+ *****************************************************************************/
+void cmdServerNotifyUpdate(void)
+{
+    if (mCmdTaskHandle != NULL && cmdServerGetIsSubscribed()) {
+        xTaskNotifyGive(mCmdTaskHandle);
+        cmdServerWake();
+    }
+}
+
+/******************************************************************************
+ * @brief       cmdServerNotifyRule
+ * @details     Called by senxorTask when the rule engine queued new events
+ *****************************************************************************/
+void cmdServerNotifyRule(void)
+{
+    if (mCmdTaskHandle != NULL && mClientCount > 0) {
+        cmdServerWake();
+    }
+}
+
 /******************************************************************************
  * @brief       cmdServerStart
- * @details     Initialize and bind the command server socket
+ * @details     Initialize, bind and listen on the command server socket
  *****************************************************************************/
 static void cmdServerStart(void)
 {
@@ -100,118 +235,430 @@ static void cmdServerStart(void)
         return;
     }
 
-    ESP_LOGI(CMDTAG, "Command server bound to port %d", CMD_SERVER_PORT);
+    if (listen(cmd_server_sock, CMD_MAX_CLIENTS) != 0) {
+        ESP_LOGE(CMDTAG, "Listen failed: errno %d", errno);
+        close(cmd_server_sock);
+        cmd_server_sock = -1;
+        return;
+    }
+
+    ESP_LOGI(CMDTAG, "Command server listening on port %d, %d clients max", CMD_SERVER_PORT, CMD_MAX_CLIENTS);
 }
 
 /******************************************************************************
  * @brief       cmdServerAccept
- * @details     Wait for a client to connect
+ * @details     Accept a pending client into a free slot
  *****************************************************************************/
 static void cmdServerAccept(void)
 {
-    if (cmd_server_sock < 0) {
-        ESP_LOGE(CMDTAG, "Server socket not initialized");
+    struct sockaddr_storage source_addr;
+    socklen_t addr_len = sizeof(source_addr);
+
+    int sock = accept(cmd_server_sock, (struct sockaddr *)&source_addr, &addr_len);
+    if (sock < 0) {
+        ESP_LOGE(CMDTAG, "Accept failed: errno %d", errno);
         return;
     }
 
-    if (listen(cmd_server_sock, 1) != 0) {
-        ESP_LOGE(CMDTAG, "Listen failed: errno %d", errno);
+    cmdClient_t* pClient = NULL;
+    for (uint8_t i = 0; i < CMD_MAX_CLIENTS; i++) {
+        if (mClients[i].mSock < 0) {
+            pClient = &mClients[i];
+            break;
+        }
+    }
+
+    if (pClient == NULL) {
+        ESP_LOGW(CMDTAG, "Command client rejected, %d clients connected", CMD_MAX_CLIENTS);
+        close(sock);
         return;
     }
 
-    ESP_LOGI(CMDTAG, "Waiting for command client on port %d...", CMD_SERVER_PORT);
+    // Set TCP keepalive
+    setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, &keepAlive, sizeof(int));
+    setsockopt(sock, IPPROTO_TCP, TCP_KEEPIDLE, &keepIdle, sizeof(int));
+    setsockopt(sock, IPPROTO_TCP, TCP_KEEPINTVL, &keepInterval, sizeof(int));
+    setsockopt(sock, IPPROTO_TCP, TCP_KEEPCNT, &keepCount, sizeof(int));
+    setsockopt(sock, IPPROTO_IP, IP_TOS, &cmdTos, sizeof(int));       // Commands overtake queued frames
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);       // A slow client never blocks the others
+
+    strcpy(pClient->mAddr, "?");
+    if (source_addr.ss_family == PF_INET) {
+        inet_ntoa_r(((struct sockaddr_in *)&source_addr)->sin_addr, pClient->mAddr, sizeof(pClient->mAddr) - 1);
+    }
 
-    struct sockaddr_storage source_addr;
-    socklen_t addr_len = sizeof(source_addr);
+    cmdParser_Init(&pClient->mParser);
+    pClient->mSubCount = 0;
+    pClient->mOutLen = 0;
+#if CONFIG_MI_REC_EN
+    pClient->mClipActive = false;
+#endif
+    pClient->mSock = sock;
+    mClientCount++;
+    senxorTaskNotifyClientChange();
+    ESP_LOGI(CMDTAG, "Command client connected from %s", pClient->mAddr);
+}
+
+/******************************************************************************
+ * @brief       cmdServerClose
+ * @param       idx - Client slot
+ * @details     Close the connection and forget the client state
+ *****************************************************************************/
+static void cmdServerClose(const uint8_t idx)
+{
+    cmdClient_t* pClient = &mClients[idx];
 
-    // Close existing client connection if any
-    if (cmd_client_sock >= 0) {
-        close(cmd_client_sock);
-        cmd_client_sock = -1;
+    if (pClient->mSock < 0) {
+        return;
     }
 
-    cmd_client_sock = accept(cmd_server_sock, (struct sockaddr *)&source_addr, &addr_len);
+    close(pClient->mSock);
+    pClient->mSock = -1;
+    pClient->mSubCount = 0;     // Subscription ends with the connection
+    pClient->mOutLen = 0;
+#if CONFIG_MI_REC_EN
+    if (pClient->mClipActive) {
+        pClient->mClipActive = false;
+        frameRecorderEndDownload();
+    }
+#endif
+    mClientCount--;
 
-    if (cmd_client_sock >= 0) {
-        isClientConnected = true;
+    if (mClientCount == 0) {
+        pollFreqHz = 0;         // Reset poll frequency once the last client is gone
+    }
+    senxorTaskNotifyClientChange();
+    ESP_LOGI(CMDTAG, "Command client %s disconnected", pClient->mAddr);
+}
+
+/******************************************************************************
+ * @brief       cmdServerWrite
+ * @param       idx - Client slot
+ *              data, len - Bytes to write
+ * @return      Bytes the socket took, 0 if it is full, -1 if the client was closed
+ *****************************************************************************/
+static int cmdServerWrite(const uint8_t idx, const uint8_t* data, size_t len)
+{
+    int sent = write(mClients[idx].mSock, data, len);
+    if (sent < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;
+        }
+        ESP_LOGE(CMDTAG, "Send failed: errno %d", errno);
+        cmdServerClose(idx);
+    }
+    return sent;
+}
 
-        // Set TCP keepalive
-        setsockopt(cmd_client_sock, SOL_SOCKET, SO_KEEPALIVE, &keepAlive, sizeof(int));
-        setsockopt(cmd_client_sock, IPPROTO_TCP, TCP_KEEPIDLE, &keepIdle, sizeof(int));
-        setsockopt(cmd_client_sock, IPPROTO_TCP, TCP_KEEPINTVL, &keepInterval, sizeof(int));
-        setsockopt(cmd_client_sock, IPPROTO_TCP, TCP_KEEPCNT, &keepCount, sizeof(int));
+#if CONFIG_MI_REC_EN
+/******************************************************************************
+ * @brief       cmdServerSendClip
+ * @param       idx - Client slot with a download in progress
+ * @return      1 once the clip is sent, 0 if the socket is full,
+ *              -1 if the client was closed
+ * @details     Send the clip straight from the recorder ring until the socket
+ *              is full, then put the CRC32 trailer ahead of the output queued
+ *              during the download.
+ *****************************************************************************/
+static int cmdServerSendClip(const uint8_t idx)
+{
+    static const uint8_t zeros[64] = {0};
+    cmdClient_t* pClient = &mClients[idx];
+    char trailer[CMD_CLIP_CRC_SIZE + 1];
+
+    while (pClient->mClipLeft > 0) {
+        const uint8_t* pData = NULL;
+        size_t span = frameRecorderGetClipSpan(pClient->mClipOffset, &pData);
+
+        // Keep the promised length if the clip ends early, the CRC shows it
+        if (span == 0) {
+            pData = zeros;
+            span = sizeof(zeros);
+        }
+        span = MIN(span, pClient->mClipLeft);
 
-        char addr_str[32];
-        if (source_addr.ss_family == PF_INET) {
-            inet_ntoa_r(((struct sockaddr_in *)&source_addr)->sin_addr, addr_str, sizeof(addr_str) - 1);
+        const int sent = cmdServerWrite(idx, pData, span);
+        if (sent <= 0) {
+            return sent;
         }
-        ESP_LOGI(CMDTAG, "Command client connected from %s", addr_str);
-    } else {
-        ESP_LOGE(CMDTAG, "Accept failed: errno %d", errno);
-        isClientConnected = false;
+        pClient->mClipCrc = Drv_Crc_Crc32(pClient->mClipCrc, pData, sent);
+        pClient->mClipOffset += sent;
+        pClient->mClipLeft -= sent;
+    }
+
+    snprintf(trailer, sizeof(trailer), "%08lX", (unsigned long)pClient->mClipCrc);
+    memmove(&pClient->mOut[CMD_CLIP_CRC_SIZE], pClient->mOut, pClient->mOutLen);
+    memcpy(pClient->mOut, trailer, CMD_CLIP_CRC_SIZE);
+    pClient->mOutLen += CMD_CLIP_CRC_SIZE;
+    pClient->mClipActive = false;
+    frameRecorderEndDownload();
+    return 1;
+}
+#endif
+
+/******************************************************************************
+ * @brief       cmdServerFlush
+ * @param       idx - Client slot
+ * @return      0, or -1 if the client was closed
+ * @details     Send the queued output until the socket is full, the task loop
+ *              goes on once it is writable. A RECD clip goes out between the
+ *              output queued before and after its ack.
+ *****************************************************************************/
+static int cmdServerFlush(const uint8_t idx)
+{
+    cmdClient_t* pClient = &mClients[idx];
+
+    for (;;) {
+        uint16_t tReady = pClient->mOutLen;
+#if CONFIG_MI_REC_EN
+        if (pClient->mClipActive) {
+            tReady = pClient->mClipAt;
+        }
+#endif
+        if (tReady > 0) {
+            const int sent = cmdServerWrite(idx, pClient->mOut, tReady);
+            if (sent <= 0) {
+                return sent;
+            }
+            memmove(pClient->mOut, &pClient->mOut[sent], pClient->mOutLen - sent);
+            pClient->mOutLen -= sent;
+#if CONFIG_MI_REC_EN
+            if (pClient->mClipActive) {
+                pClient->mClipAt -= sent;
+            }
+#endif
+            continue;
+        }
+
+#if CONFIG_MI_REC_EN
+        if (pClient->mClipActive) {
+            const int state = cmdServerSendClip(idx);
+            if (state <= 0) {
+                return state;
+            }
+            continue;
+        }
+#endif
+        return 0;
     }
 }
 
+/******************************************************************************
+ * @brief       cmdServerGetIsSending
+ * @param       idx - Client slot
+ * @return      true if output waits for the socket to drain
+ *****************************************************************************/
+static bool cmdServerGetIsSending(const uint8_t idx)
+{
+#if CONFIG_MI_REC_EN
+    if (mClients[idx].mClipActive) {
+        return true;
+    }
+#endif
+    return mClients[idx].mOutLen > 0;
+}
+
 /******************************************************************************
  * @brief       cmdServerSend
- * @details     Send response to command client
+ * @details     Queue a response or push for a command client and send what
+ *              the socket takes now. A client whose queue overflows does not
+ *              read its responses and is closed.
  *****************************************************************************/
-static int cmdServerSend(const uint8_t* data, size_t len)
+static int cmdServerSend(const uint8_t idx, const uint8_t* data, size_t len)
 {
-    if (!isClientConnected || cmd_client_sock < 0) {
+    cmdClient_t* pClient = &mClients[idx];
+    size_t room = sizeof(pClient->mOut) - pClient->mOutLen;
+
+    if (pClient->mSock < 0) {
         return -1;
     }
 
-    int err = write(cmd_client_sock, data, len);
-    if (err < 0) {
-        ESP_LOGE(CMDTAG, "Send failed: errno %d", errno);
-        isClientConnected = false;
-        pollFreqHz = 0;  // Reset poll frequency on disconnect
+#if CONFIG_MI_REC_EN
+    if (pClient->mClipActive) {
+        room = (room > CMD_CLIP_CRC_SIZE) ? (room - CMD_CLIP_CRC_SIZE) : 0;     // Kept for the trailer
+    }
+#endif
+    if (len > room) {
+        ESP_LOGW(CMDTAG, "Command client %s does not read its responses", pClient->mAddr);
+        cmdServerClose(idx);
+        return -1;
     }
-    return err;
+
+    memcpy(&pClient->mOut[pClient->mOutLen], data, len);
+    pClient->mOutLen += len;
+    return cmdServerFlush(idx);
 }
 
+#if CONFIG_MI_REC_EN
 /******************************************************************************
- * @brief       cmdServerReceive
- * @details     Receive and process commands from client
+ * @brief       cmdServerBeginClip
+ * @param       idx - Client slot
+ *              offset, len - Clip bytes granted by the RECD ack
+ * @details     Start streaming the clip after the output queued so far, the
+ *              ack included. The task loop sends it as the socket drains, so
+ *              the other command clients are not held up. One download at a
+ *              time per client, a second RECD before the trailer closes it.
  *****************************************************************************/
-static int cmdServerReceive(void)
+static void cmdServerBeginClip(const uint8_t idx, uint32_t offset, uint32_t len)
 {
-    if (!isClientConnected || cmd_client_sock < 0) {
-        return -1;
+    cmdClient_t* pClient = &mClients[idx];
+
+    if (pClient->mSock < 0 || pClient->mClipActive) {
+        frameRecorderEndDownload();
+        if (pClient->mSock >= 0) {
+            ESP_LOGW(CMDTAG, "Command client %s sent RECD during a download", pClient->mAddr);
+            cmdServerClose(idx);
+        }
+        return;
     }
 
-    memset(mRxBuff, 0, sizeof(mRxBuff));
+    pClient->mClipActive = true;
+    pClient->mClipAt = pClient->mOutLen;
+    pClient->mClipOffset = offset;
+    pClient->mClipLeft = len;
+    pClient->mClipCrc = 0;
+    cmdServerFlush(idx);
+}
+#endif
 
-    int len = read(cmd_client_sock, mRxBuff, sizeof(mRxBuff) - 1);
+/******************************************************************************
+ * @brief       cmdServerReceive
+ * @param       idx - Client slot with pending data
+ * @details     Receive and process every complete command from a client
+ *****************************************************************************/
+static int cmdServerReceive(const uint8_t idx)
+{
+    cmdClient_t* pClient = &mClients[idx];
+    int len = recv(pClient->mSock, mRxBuff, sizeof(mRxBuff), MSG_DONTWAIT);
 
     if (len < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;
+        }
         ESP_LOGE(CMDTAG, "Receive failed: errno %d", errno);
-        isClientConnected = false;
-        pollFreqHz = 0;  // Reset poll frequency on disconnect
+        cmdServerClose(idx);
         return -1;
     } else if (len == 0) {
-        ESP_LOGI(CMDTAG, "Command client disconnected");
-        isClientConnected = false;
-        pollFreqHz = 0;  // Reset poll frequency on disconnect
+        cmdServerClose(idx);
         return -1;
     }
 
-    ESP_LOGI(CMDTAG, "Received command: %s", mRxBuff);
+    // Parse and execute commands, a segment can hold several or part of one
+    size_t offset = 0;
+    while (offset < (size_t)len && pClient->mSock >= 0) {
+        size_t used = 0;
+        const int result = cmdParser_FeedCmd(&pClient->mParser, &mRxBuff[offset], len - offset, &used);
+        offset += used;
 
-    // Parse and execute command
-    cmdParser_PharseCmd(&mCmdPhaserObj, mRxBuff, len);
-    uint16_t ackSize = cmdParser_CommitCmd(&mCmdPhaserObj, mAckBuff);
+        if (result == CP_CMD_PENDING) {
+            break;
+        }
 
-    if (ackSize > 0) {
-        cmdServerSend(mAckBuff, ackSize);
-    }
+        if (result == CP_CMD_READY) {
+            ESP_LOGD(CMDTAG, "Received command %s from %s", pClient->mParser.mCmd, pClient->mAddr);
+            mCurrentClient = idx;
+            uint16_t ackSize = cmdParser_CommitCmd(&pClient->mParser, mAckBuff);
+            mCurrentClient = -1;
+
+            if (ackSize > 0) {
+                cmdServerSend(idx, mAckBuff, ackSize);
+#if CONFIG_MI_REC_EN
+                uint32_t clipOffset, clipLen;
+                if (cmdParser_GetBulkRange(mAckBuff, ackSize, &clipOffset, &clipLen)) {
+                    cmdServerBeginClip(idx, clipOffset, clipLen);
+                }
+#endif
+            }
+        } else {
+            ESP_LOGW(CMDTAG, "Command %s from %s dropped: %s", pClient->mParser.mCmd, pClient->mAddr, CP_ERR_CRC_FAIL);
+        }
 
-    cmdParser_Init(&mCmdPhaserObj);
+        cmdParser_Init(&pClient->mParser);
+    }
 
     return len;
 }
 
+/******************************************************************************
+ * @brief       cmdServerPush
+ * @param       idx - Client slot
+ * @details     Send the subscribed registers that changed since the last push:
+ *              #[len]SUBV[NN]{[AA][VL][VH]}...[CL][CH][CRC], binary fields as BRWR
+ *****************************************************************************/
+static void cmdServerPush(const uint8_t idx)
+{
+    cmdClient_t* pClient = &mClients[idx];
+
+    if (pClient->mSock < 0 || pClient->mSubCount == 0) {
+        return;
+    }
+
+#if CONFIG_MI_REC_EN
+    if (pClient->mClipActive) {
+        return;                 // The first push after the download carries the changes
+    }
+#endif
+
+    if (pClient->mSubPrimed && (xTaskGetTickCount() - pClient->mSubLastPush) < pdMS_TO_TICKS(pClient->mSubIntervalMs)) {
+        return;
+    }
+
+    uint8_t* pOut = &mPushBuff[PROTO_PACKET_DATA + 1];
+    uint8_t tChanged = 0;
+
+    for (uint8_t i = 0; i < pClient->mSubCount; i++) {
+        const uint16_t tValue = cmdParser_ReadRegister(pClient->mSubRegs[i]);
+        const uint16_t tLast = pClient->mSubLast[i];
+        const uint16_t tDelta = (tValue > tLast) ? (tValue - tLast) : (tLast - tValue);
+
+        if (pClient->mSubPrimed && (tDelta == 0 || tDelta < pClient->mSubThreshold)) {
+            continue;
+        }
+        pClient->mSubLast[i] = tValue;
+        pOut[0] = pClient->mSubRegs[i];
+        pOut[1] = (uint8_t)(tValue & 0xFF);
+        pOut[2] = (uint8_t)(tValue >> 8);
+        pOut += SUBV_REG_SIZE;
+        tChanged++;
+    }
+
+    pClient->mSubPrimed = true;
+    pClient->mSubLastPush = xTaskGetTickCount();
+
+    if (tChanged == 0) {
+        return;
+    }
+
+    mPushBuff[PROTO_PACKET_DATA] = tChanged;
+    const uint16_t tCRC16 = getCRC16(&mPushBuff[PROTO_PACKET_DATA], pOut - &mPushBuff[PROTO_PACKET_DATA]);
+    *pOut++ = (uint8_t)(tCRC16 & 0xFF);
+    *pOut++ = (uint8_t)(tCRC16 >> 8);
+
+    cmdServerSend(idx, mPushBuff, protoPacket_Encode(mPushBuff, PROTO_CMD_SUBV, pOut - &mPushBuff[PROTO_PACKET_DATA], true));
+}
+
+/******************************************************************************
+ * @brief       cmdServerPushRules
+ * @details     Send every rule event not pushed yet to all clients:
+ *              #0012ALRM[II][EE][VVVV][MM][CRC], EE 01 raised, 00 cleared.
+ *              Events that arrive with no client connected are dropped.
+ *****************************************************************************/
+static void cmdServerPushRules(void)
+{
+    ruleEvent_t event;
+
+    while (ruleEngine_GetEvent(&mRuleCursor, &event)) {
+        sprintf((char *)&mPushBuff[PROTO_PACKET_DATA], "%02X%02X%04X%02X", event.mRule, event.mRaised ? 1 : 0, event.mValue, event.mActive);
+        const size_t tLen = protoPacket_Encode(mPushBuff, PROTO_CMD_ALRM, 10, true);
+
+        for (uint8_t i = 0; i < CMD_MAX_CLIENTS; i++) {
+            if (mClients[i].mSock >= 0) {
+                cmdServerSend(i, mPushBuff, tLen);
+            }
+        }
+    }
+}
+
 /******************************************************************************
  * @brief       cmdServerTask
  * @details     Main command server task
@@ -220,25 +667,87 @@ void cmdServerTask(void *pvParameters)
 {
     ESP_LOGI(CMDTAG, "Starting command server task...");
 
-    cmdParser_Init(&mCmdPhaserObj);
-    cmdServerStart();
+    mCmdTaskHandle = xTaskGetCurrentTaskHandle();
+    mRuleCursor = ruleEngine_GetEventCount();
+    for (uint8_t i = 0; i < CMD_MAX_CLIENTS; i++) {
+        mClients[i].mSock = -1;
+        cmdParser_Init(&mClients[i].mParser);
+    }
 
-    // Initial accept
-    cmdServerAccept();
+    const esp_vfs_eventfd_config_t eventfdConfig = ESP_VFS_EVENTD_CONFIG_DEFAULT();
+    const esp_err_t err = esp_vfs_eventfd_register(&eventfdConfig);
+    if (err == ESP_OK || err == ESP_ERR_INVALID_STATE) {    // Already registered by another component
+        mWakeFd = eventfd(0, 0);
+    }
+    if (mWakeFd < 0) {
+        ESP_LOGE(CMDTAG, "Cannot create the wake up eventfd, polling every %d ms instead: errno %d", CMD_SERVER_POLL_MS, errno);
+    }
+    cmdServerStart();
 
     for (;;) {
-        if (!isClientConnected) {
-            ESP_LOGI(CMDTAG, "Waiting for command client...");
-            cmdServerAccept();
+        if (cmd_server_sock < 0) {
+            vTaskDelay(pdMS_TO_TICKS(1000));
+            cmdServerStart();
             continue;
         }
 
-        // Receive and process commands
-        if (cmdServerReceive() < 0) {
-            // Client disconnected, will reconnect in next iteration
+        fd_set readSet;
+        fd_set writeSet;
+        FD_ZERO(&readSet);
+        FD_ZERO(&writeSet);
+        FD_SET(cmd_server_sock, &readSet);
+        int maxSock = cmd_server_sock;
+
+        if (mWakeFd >= 0) {
+            FD_SET(mWakeFd, &readSet);
+            maxSock = MAX(maxSock, mWakeFd);
+        }
+
+        for (uint8_t i = 0; i < CMD_MAX_CLIENTS; i++) {
+            if (mClients[i].mSock >= 0) {
+                FD_SET(mClients[i].mSock, &readSet);
+                if (cmdServerGetIsSending(i)) {
+                    FD_SET(mClients[i].mSock, &writeSet);
+                }
+                maxSock = MAX(maxSock, mClients[i].mSock);
+            }
+        }
+
+        // Subscription and rule pushes wake up on the eventfd, they are polled without it
+        struct timeval timeout = { .tv_sec = 0, .tv_usec = CMD_SERVER_POLL_MS * 1000 };
+        struct timeval* pTimeout = (mWakeFd >= 0) ? NULL : &timeout;
+        int ready = select(maxSock + 1, &readSet, &writeSet, NULL, pTimeout);
+        if (ready < 0) {
+            ESP_LOGE(CMDTAG, "Select failed: errno %d", errno);
+            vTaskDelay(pdMS_TO_TICKS(CMD_SERVER_POLL_MS));
             continue;
         }
 
-        vTaskDelay(pdMS_TO_TICKS(10));
+        if (ready > 0) {
+            if (mWakeFd >= 0 && FD_ISSET(mWakeFd, &readSet)) {
+                uint64_t count;
+                read(mWakeFd, &count, sizeof(count));
+            }
+
+            if (FD_ISSET(cmd_server_sock, &readSet)) {
+                cmdServerAccept();
+            }
+
+            for (uint8_t i = 0; i < CMD_MAX_CLIENTS; i++) {
+                if (mClients[i].mSock >= 0 && FD_ISSET(mClients[i].mSock, &writeSet)) {
+                    cmdServerFlush(i);
+                }
+                if (mClients[i].mSock >= 0 && FD_ISSET(mClients[i].mSock, &readSet)) {
+                    cmdServerReceive(i);
+                }
+            }
+        }
+
+        if (ulTaskNotifyTake(pdTRUE, 0) > 0) {
+            for (uint8_t i = 0; i < CMD_MAX_CLIENTS; i++) {
+                cmdServerPush(i);
+            }
+        }
+        cmdServerPushRules();
     }
 }
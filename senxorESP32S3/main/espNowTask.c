@@ -0,0 +1,755 @@
+/*****************************************************************************
+ * @file     espNowTask.c
+ * @version  1.00
+ * @brief    ESP-NOW link to other ESP32s, without an access point.
+ * @date	 15 Oct 2026
+ * @details	 A gateway or another hood is a peer of the table, which the
+ * 			 command port sets (ESPN) and NVS keeps. Each peer has flags for
+ * 			 what it receives:
+ *
+ * 			 events  every alarm rule event, one packet, sent the moment
+ * 			         senxorTask raises or clears the rule
+ * 			 ROI     statistics of the used ROIs in one packet, every
+ * 			         ESPNOW_STATS_PERIOD_MS
+ * 			 frames  the image at ESPNOW_FPS, coded like a v2 keyframe and
+ * 			         cut into fragments of one packet each
+ *
+ * 			 Every packet is unicast, so the Wi-Fi MAC acknowledges and
+ * 			 retries it, and the next packet waits for the send callback.
+ * 			 A peer that still misses fragments answers with a NACK mask and
+ * 			 gets those fragments again, up to ESPNOW_MAX_NACKS times per
+ * 			 frame. Every frame is a keyframe, so a lost frame never breaks
+ * 			 the next one. Rule events are sent between two fragments, an
+ * 			 alarm never waits for a frame.
+ *
+ * 			 Peers raise the capture demand like a polling client, so the
+ * 			 link works with no stream client and no access point. Events
+ * 			 received from another hood are logged.
+ ******************************************************************************/
+#include <string.h>
+#include <sys/param.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <esp_attr.h>
+#include <esp_log.h>
+#include <esp_mac.h>
+#include <esp_now.h>
+#include <esp_timer.h>
+#include <esp_wifi.h>
+
+#include "DrvNVS.h"
+#include "espNowTask.h"
+#include "frameCodec.h"
+#include "roiEngine.h"
+#include "ruleEngine.h"
+#include "tcpServerTask.h"
+
+#if CONFIG_MI_ESPNOW_EN
+
+_Static_assert((ESPNOW_MSG_MAX + ESPNOW_FRAG_DATA - 1) / ESPNOW_FRAG_DATA <= ESPNOW_MAX_FRAGS, "A frame needs more fragments than a NACK covers");
+_Static_assert(ESPNOW_ROI_HEADER + ROI_MAX_COUNT * ESPNOW_ROI_ENTRY <= ESPNOW_PACKET_MAX, "ROI statistics do not fit in one packet");
+
+// Packet of a peer, handed from the Wi-Fi task to espNowTask
+typedef struct espNowRx{
+	uint8_t mMac[6];
+	uint8_t mLen;
+	uint8_t mData[ESPNOW_RX_MAX];
+}espNowRx_t;
+
+//private:
+static espNowTable_t mTable;
+static portMUX_TYPE mLock = portMUX_INITIALIZER_UNLOCKED;			//mTable, mFlagsAll and mPeersChanged
+static volatile uint8_t mFlagsAll = 0;								//Flags of every peer, ORed
+static bool mPeersChanged = false;									//espNowTask updates the ESP-NOW peer list
+static TaskHandle_t mTaskHandle = NULL;
+static QueueHandle_t mRxQueue = NULL;
+static SemaphoreHandle_t mSendDone = NULL;							//Given by the send callback
+static volatile bool mSendOk = false;								//Status of the last packet sent
+static volatile uint32_t mLastSeq = 0;								//Capture sequence number of the last analysed frame
+
+// Only used by espNowTask
+static espNowPeer_t mAdded[ESPNOW_MAX_PEERS];						//Peers in the ESP-NOW list
+static uint16_t mFailed[ESPNOW_MAX_PEERS];							//Packets the peer did not acknowledge
+static uint8_t mNacks[ESPNOW_MAX_PEERS];							//NACKs served for the current frame
+static uint32_t mRuleCursor = 0;
+static int64_t mNextStatsUs = 0;
+
+// Image handed over by senxorTask, mImageReady set until espNowTask coded it
+static volatile bool mImageReady = false;
+static uint32_t mImageSeq = 0;
+static int64_t mNextFrameUs = 0;
+EXT_RAM_BSS_ATTR static uint16_t mImage[ESPNOW_IMAGE_PIXELS];
+
+// Frame being sent, kept for NACKs until the next one
+EXT_RAM_BSS_ATTR static uint8_t mMsg[ESPNOW_MSG_MAX];
+EXT_RAM_BSS_ATTR static uint8_t mDeltaBuff[ESPNOW_IMAGE_PIXELS * 2];
+static uint16_t mMsgLen = 0;
+static uint16_t mFrameId = 0;
+static uint8_t mFragCount = 0;
+static uint8_t mPacket[ESPNOW_PACKET_MAX];
+
+static void espNow_SendCb(const uint8_t* pMac, esp_now_send_status_t status);
+static void espNow_RecvCb(const esp_now_recv_info_t* pInfo, const uint8_t* pData, int len);
+static void espNow_ApplyPeers(void);
+static int8_t espNow_FindPeer(const uint8_t* pMac);
+static bool espNow_SendTo(const uint8_t idx, const uint8_t* pData, const size_t len);
+static void espNow_SendRules(void);
+static void espNow_SendStats(void);
+static void espNow_SendFrame(void);
+static bool espNow_SendFragment(const uint8_t idx, const uint8_t frag);
+static void espNow_Receive(void);
+static uint8_t espNow_GetFlags(const espNowTable_t* pTable);
+
+/*
+ * ***********************************************************************
+ * @brief       espNowTask
+ * @param       pvParameters - Not used
+ * @return      None
+ * @details     Start ESP-NOW on the running Wi-Fi interface, load the
+ * 				peer table and serve the peers. Must start after
+ * 				Drv_WLAN_Init.
+ **************************************************************************/
+void espNowTask(void *pvParameters)
+{
+	mRxQueue = xQueueCreate(ESPNOW_RX_QUEUE_LEN, sizeof(espNowRx_t));
+	mSendDone = xSemaphoreCreateBinary();
+	mRuleCursor = ruleEngine_GetEventCount();
+
+	esp_err_t err = esp_now_init();
+	if(err == ESP_OK)
+	{
+		err = esp_now_register_send_cb(espNow_SendCb);
+	}//End if
+	if(err == ESP_OK)
+	{
+		err = esp_now_register_recv_cb(espNow_RecvCb);
+	}//End if
+	if(err != ESP_OK)
+	{
+		ESP_LOGE(ESPNOWTAG, ESPNOW_ERR_INIT, esp_err_to_name(err));
+		vTaskDelete(NULL);
+	}//End if
+
+	if(!NVS_ReadBlob(ESPNOW_NVS_KEY, &mTable, sizeof(mTable)) || mTable.mVersion != ESPNOW_PEER_VERSION)
+	{
+		memset(&mTable, 0, sizeof(mTable));								//Start with an empty table
+		mTable.mVersion = ESPNOW_PEER_VERSION;
+	}//End if
+
+	uint8_t peerCnt = 0;
+	for(uint8_t i = 0; i < ESPNOW_MAX_PEERS; i++)
+	{
+		mTable.mPeer[i].mFlags &= ESPNOW_PEER_ALL;						//Drop flags a newer firmware may have written
+		peerCnt += (mTable.mPeer[i].mFlags != 0) ? 1 : 0;
+	}//End for
+	mFlagsAll = espNow_GetFlags(&mTable);
+	mPeersChanged = true;
+	mTaskHandle = xTaskGetCurrentTaskHandle();							//espNow_SetPeer is accepted from now on
+
+	uint8_t channel = 0;
+	wifi_second_chan_t second;
+	esp_wifi_get_channel(&channel, &second);
+	ESP_LOGI(ESPNOWTAG, ESPNOW_INFO_START, channel, peerCnt);
+	senxorTaskNotifyClientChange();										//Capture demand of the saved peers
+
+	for(;;)
+	{
+		ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ESPNOW_WAIT_MS));		//Woken by a rule event, an image, a peer packet or a table change
+
+		if(mPeersChanged)
+		{
+			espNow_ApplyPeers();
+		}//End if
+		espNow_SendRules();
+		espNow_Receive();
+		espNow_SendStats();
+		espNow_SendFrame();
+	}//End for
+}//End espNowTask
+
+/*
+ * ***********************************************************************
+ * @brief       espNowOnFrame
+ * @param       pImage - Image of the frame, header rows removed
+ * 				seq - Capture sequence number
+ * @return      None
+ * @details     Called by senxorAnalyse for every frame. Copies the image
+ * 				when a frame peer is due and the last image is coded.
+ **************************************************************************/
+void espNowOnFrame(const uint16_t* pImage, const uint32_t seq)
+{
+	mLastSeq = seq;
+	if(!(mFlagsAll & ESPNOW_PEER_FRAMES) || mImageReady)
+	{
+		return;
+	}//End if
+
+	const int64_t now = esp_timer_get_time();
+	const int64_t periodUs = 1000000 / ESPNOW_FPS;
+	if(now < mNextFrameUs - periodUs / 2)
+	{
+		return;
+	}//End if
+	mNextFrameUs += periodUs;												//Fixed grid so the average rate is exact
+	if(mNextFrameUs <= now)
+	{
+		mNextFrameUs = now + periodUs;
+	}//End if
+
+	memcpy(mImage, pImage, sizeof(mImage));
+	mImageSeq = seq;
+	mImageReady = true;
+	xTaskNotifyGive(mTaskHandle);
+}//End espNowOnFrame
+
+/*
+ * ***********************************************************************
+ * @brief       espNowNotifyRule
+ * @param       None
+ * @return      None
+ * @details     Called by senxorTask when an alarm rule was raised or cleared
+ **************************************************************************/
+void espNowNotifyRule(void)
+{
+	if(mTaskHandle != NULL)
+	{
+		xTaskNotifyGive(mTaskHandle);
+	}//End if
+}//End espNowNotifyRule
+
+/*
+ * ***********************************************************************
+ * @brief       espNowGetDemandHz
+ * @param       None
+ * @return      Capture rate the peers need, 0 if there are none
+ **************************************************************************/
+uint8_t espNowGetDemandHz(void)
+{
+	const uint8_t flags = mFlagsAll;
+
+	if(flags & ESPNOW_PEER_FRAMES)
+	{
+		return MAX(ESPNOW_FPS, ESPNOW_RATE_HZ);
+	}//End if
+	return (flags != 0) ? ESPNOW_RATE_HZ : 0;
+}//End espNowGetDemandHz
+
+/*
+ * ***********************************************************************
+ * @brief       espNow_SetPeer
+ * @param       idx - Peer slot
+ * 				pMac - Station MAC address of the peer
+ * 				flags - ESPNOW_PEER_*, 0 frees the slot
+ * @return      True if the peer was accepted and stored
+ * @details     espNowTask applies the change. Saves the table to NVS.
+ **************************************************************************/
+bool espNow_SetPeer(const uint8_t idx, const uint8_t* pMac, const uint8_t flags)
+{
+	espNowTable_t table;
+
+	if(idx >= ESPNOW_MAX_PEERS || (flags & ~ESPNOW_PEER_ALL) != 0 || mTaskHandle == NULL)
+	{
+		ESP_LOGE(ESPNOWTAG, ESPNOW_ERR_PEER, idx, "invalid definition");
+		return false;
+	}//End if
+
+	taskENTER_CRITICAL(&mLock);
+	memcpy(mTable.mPeer[idx].mMac, pMac, sizeof(mTable.mPeer[idx].mMac));
+	mTable.mPeer[idx].mFlags = flags;
+	if(flags == 0)
+	{
+		memset(mTable.mPeer[idx].mMac, 0, sizeof(mTable.mPeer[idx].mMac));
+	}//End if
+	mFlagsAll = espNow_GetFlags(&mTable);
+	mPeersChanged = true;
+	table = mTable;
+	taskEXIT_CRITICAL(&mLock);
+
+	NVS_WriteBlob(ESPNOW_NVS_KEY, &table, sizeof(table));
+	ESP_LOGI(ESPNOWTAG, ESPNOW_INFO_PEER, idx, MAC2STR(table.mPeer[idx].mMac), flags);
+	xTaskNotifyGive(mTaskHandle);
+	senxorTaskNotifyClientChange();										//Capture demand changed
+	return true;
+}//End espNow_SetPeer
+
+/*
+ * ***********************************************************************
+ * @brief       espNow_GetPeer
+ * @param       idx - Peer slot
+ * 				pMac - Output, 6 bytes
+ * 				pFlags - Output, ESPNOW_PEER_*, 0 for an unused slot
+ * 				pFailed - Output, packets the peer did not acknowledge
+ * @return      False if idx is out of range
+ **************************************************************************/
+bool espNow_GetPeer(const uint8_t idx, uint8_t* pMac, uint8_t* pFlags, uint16_t* pFailed)
+{
+	if(idx >= ESPNOW_MAX_PEERS)
+	{
+		return false;
+	}//End if
+
+	taskENTER_CRITICAL(&mLock);
+	const espNowPeer_t peer = mTable.mPeer[idx];
+	taskEXIT_CRITICAL(&mLock);
+
+	memcpy(pMac, peer.mMac, sizeof(peer.mMac));
+	*pFlags = peer.mFlags;
+	*pFailed = mFailed[idx];
+	return true;
+}//End espNow_GetPeer
+
+/*
+ * ***********************************************************************
+ * @brief       espNow_SendCb
+ * @param       pMac - Peer of the packet
+ * 				status - Acknowledged or not
+ * @return      None
+ * @details     Runs in the Wi-Fi task
+ **************************************************************************/
+static void espNow_SendCb(const uint8_t* pMac, esp_now_send_status_t status)
+{
+	mSendOk = (status == ESP_NOW_SEND_SUCCESS);
+	xSemaphoreGive(mSendDone);
+}//End espNow_SendCb
+
+/*
+ * ***********************************************************************
+ * @brief       espNow_RecvCb
+ * @param       pInfo - Sender of the packet
+ * 				pData, len - Packet
+ * @return      None
+ * @details     Runs in the Wi-Fi task. Hands packets of this protocol to
+ * 				espNowTask, which checks the sender.
+ **************************************************************************/
+static void espNow_RecvCb(const esp_now_recv_info_t* pInfo, const uint8_t* pData, int len)
+{
+	espNowRx_t rx;
+
+	if(len < 2 || len > ESPNOW_RX_MAX || pData[0] != ESPNOW_MAGIC)
+	{
+		return;
+	}//End if
+
+	memcpy(rx.mMac, pInfo->src_addr, sizeof(rx.mMac));
+	rx.mLen = (uint8_t)len;
+	memcpy(rx.mData, pData, len);
+	if(xQueueSend(mRxQueue, &rx, 0) == pdTRUE)
+	{
+		xTaskNotifyGive(mTaskHandle);
+	}//End if
+}//End espNow_RecvCb
+
+/*
+ * ***********************************************************************
+ * @brief       espNow_ApplyPeers
+ * @param       None
+ * @return      None
+ * @details     Rebuild the ESP-NOW peer list from the table. Peers use
+ * 				the station interface, or the soft AP in AP only mode, on
+ * 				the current channel. The counters of the slots start over.
+ **************************************************************************/
+static void espNow_ApplyPeers(void)
+{
+	espNowTable_t table;
+	wifi_mode_t mode = WIFI_MODE_STA;
+
+	taskENTER_CRITICAL(&mLock);
+	table = mTable;
+	mPeersChanged = false;
+	taskEXIT_CRITICAL(&mLock);
+
+	esp_wifi_get_mode(&mode);
+	for(uint8_t i = 0; i < ESPNOW_MAX_PEERS; i++)
+	{
+		if(mAdded[i].mFlags != 0)
+		{
+			esp_now_del_peer(mAdded[i].mMac);
+		}//End if
+	}//End for
+
+	for(uint8_t i = 0; i < ESPNOW_MAX_PEERS; i++)
+	{
+		if(memcmp(&mAdded[i], &table.mPeer[i], sizeof(mAdded[i])) != 0)
+		{
+			mFailed[i] = 0;
+			mNacks[i] = ESPNOW_MAX_NACKS;										//No NACKs for a frame the peer did not get
+		}//End if
+		mAdded[i] = table.mPeer[i];
+		if(mAdded[i].mFlags == 0)
+		{
+			continue;
+		}//End if
+
+		esp_now_peer_info_t info;
+		memset(&info, 0, sizeof(info));
+		memcpy(info.peer_addr, mAdded[i].mMac, ESP_NOW_ETH_ALEN);
+		info.channel = 0;													//Current channel
+		info.ifidx = (mode == WIFI_MODE_AP) ? WIFI_IF_AP : WIFI_IF_STA;
+		info.encrypt = false;
+		const esp_err_t err = esp_now_add_peer(&info);
+		if(err != ESP_OK && err != ESP_ERR_ESPNOW_EXIST)					//A MAC in two slots is one peer
+		{
+			ESP_LOGE(ESPNOWTAG, ESPNOW_ERR_PEER, i, esp_err_to_name(err));
+			mAdded[i].mFlags = 0;
+		}//End if
+	}//End for
+}//End espNow_ApplyPeers
+
+/*
+ * ***********************************************************************
+ * @brief       espNow_FindPeer
+ * @param       pMac - Sender of a packet
+ * @return      Slot of the peer, -1 if it is not in the table
+ **************************************************************************/
+static int8_t espNow_FindPeer(const uint8_t* pMac)
+{
+	for(uint8_t i = 0; i < ESPNOW_MAX_PEERS; i++)
+	{
+		if(mAdded[i].mFlags != 0 && memcmp(mAdded[i].mMac, pMac, sizeof(mAdded[i].mMac)) == 0)
+		{
+			return (int8_t)i;
+		}//End if
+	}//End for
+	return -1;
+}//End espNow_FindPeer
+
+/*
+ * ***********************************************************************
+ * @brief       espNow_SendTo
+ * @param       idx - Peer slot
+ * 				pData, len - Packet
+ * @return      True if the peer acknowledged the packet
+ * @details     Waits for the send callback, so the Wi-Fi queue never
+ * 				holds more than one packet of this task
+ **************************************************************************/
+static bool espNow_SendTo(const uint8_t idx, const uint8_t* pData, const size_t len)
+{
+	xSemaphoreTake(mSendDone, 0);											//Drop a late callback of an earlier packet
+
+	esp_err_t err = esp_now_send(mAdded[idx].mMac, pData, len);
+	if(err == ESP_ERR_ESPNOW_NO_MEM)
+	{
+		vTaskDelay(1);														//Wi-Fi buffers busy, give them one tick
+		err = esp_now_send(mAdded[idx].mMac, pData, len);
+	}//End if
+	if(err != ESP_OK)
+	{
+		ESP_LOGW(ESPNOWTAG, ESPNOW_WARN_SEND, MAC2STR(mAdded[idx].mMac), esp_err_to_name(err));
+		++mFailed[idx];
+		return false;
+	}//End if
+
+	const bool isAcked = (xSemaphoreTake(mSendDone, pdMS_TO_TICKS(ESPNOW_SEND_WAIT_MS)) == pdTRUE) && mSendOk;
+	if(!isAcked)
+	{
+		++mFailed[idx];
+	}//End if
+	return isAcked;
+}//End espNow_SendTo
+
+/*
+ * ***********************************************************************
+ * @brief       espNow_SendRules
+ * @param       None
+ * @return      None
+ * @details     Send every rule event not sent yet to the event peers:
+ * 				[X][01][rule][raised][value LE16][active][seq LE32].
+ * 				Events that arrive with no event peer are dropped.
+ **************************************************************************/
+static void espNow_SendRules(void)
+{
+	ruleEvent_t event;
+	uint8_t packet[ESPNOW_EVENT_SIZE];
+
+	while(ruleEngine_GetEvent(&mRuleCursor, &event))
+	{
+		packet[0] = ESPNOW_MAGIC;
+		packet[1] = ESPNOW_TYPE_EVENT;
+		packet[2] = event.mRule;
+		packet[3] = event.mRaised ? 1 : 0;
+		packet[4] = (uint8_t)(event.mValue & 0xFF);
+		packet[5] = (uint8_t)(event.mValue >> 8);
+		packet[6] = event.mActive;
+		packet[7] = (uint8_t)(event.mSeq & 0xFF);
+		packet[8] = (uint8_t)((event.mSeq >> 8) & 0xFF);
+		packet[9] = (uint8_t)((event.mSeq >> 16) & 0xFF);
+		packet[10] = (uint8_t)((event.mSeq >> 24) & 0xFF);
+
+		for(uint8_t i = 0; i < ESPNOW_MAX_PEERS; i++)
+		{
+			if(mAdded[i].mFlags & ESPNOW_PEER_EVENTS)
+			{
+				espNow_SendTo(i, packet, sizeof(packet));
+			}//End if
+		}//End for
+	}//End while
+}//End espNow_SendRules
+
+/*
+ * ***********************************************************************
+ * @brief       espNow_SendStats
+ * @param       None
+ * @return      None
+ * @details     Once a period, send the statistics of every ROI with pixels
+ * 				to the ROI peers: [X][02][seq LE32][count], then per ROI
+ * 				[slot][min][max][mean][percentile][hot x][hot y][pixels],
+ * 				16 bit values little endian. Sent with no ROI too, as a
+ * 				heartbeat.
+ **************************************************************************/
+static void espNow_SendStats(void)
+{
+	uint8_t packet[ESPNOW_ROI_HEADER + ROI_MAX_COUNT * ESPNOW_ROI_ENTRY];
+	const int64_t now = esp_timer_get_time();
+
+	if(!(mFlagsAll & ESPNOW_PEER_ROI) || now < mNextStatsUs)
+	{
+		return;
+	}//End if
+	mNextStatsUs = now + (int64_t)ESPNOW_STATS_PERIOD_MS * 1000;
+
+	uint8_t count = 0;
+	size_t pos = ESPNOW_ROI_HEADER;
+	for(uint8_t slot = 0; slot < ROI_MAX_COUNT; slot++)
+	{
+		roiStats_t stats;
+		if(!roiEngine_GetStats(slot, &stats) || stats.mPixels == 0)
+		{
+			continue;
+		}//End if
+		const uint16_t values[] = { stats.mMin, stats.mMax, stats.mMean, stats.mPercentile };
+
+		packet[pos++] = slot;
+		for(uint8_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+		{
+			packet[pos++] = (uint8_t)(values[i] & 0xFF);
+			packet[pos++] = (uint8_t)(values[i] >> 8);
+		}//End for
+		packet[pos++] = stats.mHotX;
+		packet[pos++] = stats.mHotY;
+		packet[pos++] = (uint8_t)(stats.mPixels & 0xFF);
+		packet[pos++] = (uint8_t)(stats.mPixels >> 8);
+		++count;
+	}//End for
+
+	const uint32_t seq = mLastSeq;
+	packet[0] = ESPNOW_MAGIC;
+	packet[1] = ESPNOW_TYPE_ROI;
+	packet[2] = (uint8_t)(seq & 0xFF);
+	packet[3] = (uint8_t)((seq >> 8) & 0xFF);
+	packet[4] = (uint8_t)((seq >> 16) & 0xFF);
+	packet[5] = (uint8_t)((seq >> 24) & 0xFF);
+	packet[6] = count;
+
+	for(uint8_t i = 0; i < ESPNOW_MAX_PEERS; i++)
+	{
+		if(mAdded[i].mFlags & ESPNOW_PEER_ROI)
+		{
+			espNow_SendTo(i, packet, pos);
+		}//End if
+	}//End for
+}//End espNow_SendStats
+
+/*
+ * ***********************************************************************
+ * @brief       espNow_SendFrame
+ * @param       None
+ * @return      None
+ * @details     Code the image handed over by espNowOnFrame as a keyframe
+ * 				with the header of the BLE stream, and send its fragments
+ * 				to the frame peers, one fragment to every peer in turn.
+ * 				A frame that does not shrink is sent raw.
+ **************************************************************************/
+static void espNow_SendFrame(void)
+{
+	if(!mImageReady)
+	{
+		return;
+	}//End if
+
+	const size_t rawLen = sizeof(mImage);
+	uint8_t* pPayload = &mMsg[ESPNOW_MSG_HEADER];
+	uint8_t encoding = TCP_STREAM_ENC_DELTA;
+
+	size_t len = frameCodec_EncodeDelta(mImage, NULL, ESPNOW_IMAGE_PIXELS, mDeltaBuff, rawLen - 1);
+	if(len > 0)
+	{
+		const size_t lzLen = frameCodec_CompressLZ(mDeltaBuff, len, pPayload, len - 1);
+		if(lzLen > 0)
+		{
+			encoding = TCP_STREAM_ENC_DELTA_LZ;
+			len = lzLen;
+		}
+		else
+		{
+			memcpy(pPayload, mDeltaBuff, len);
+		}//End if-else
+	}
+	else
+	{
+		encoding = TCP_STREAM_ENC_RAW16;									//No gain, send it raw
+		len = rawLen;
+		for(size_t i = 0; i < ESPNOW_IMAGE_PIXELS; i++)
+		{
+			pPayload[2 * i] = (uint8_t)(mImage[i] & 0xFF);
+			pPayload[2 * i + 1] = (uint8_t)(mImage[i] >> 8);
+		}//End for
+	}//End if-else
+	const uint32_t seq = mImageSeq;
+	mImageReady = false;													//espNowOnFrame may copy the next image
+
+	blobRecord_t blobs;
+	const uint16_t blobLen = blobTrack_GetRecord(&blobs);
+	memcpy(&pPayload[len], &blobs, blobLen);
+
+	mMsg[0] = encoding;
+	mMsg[1] = TCP_STREAM_FLAG_KEYFRAME | ((blobLen > 0) ? TCP_STREAM_FLAG_BLOBS : 0);
+	mMsg[2] = 0;															//x, y, width, height and step of the view
+	mMsg[3] = 0;
+	mMsg[4] = SENXOR_FRAME_WIDTH;
+	mMsg[5] = SENXOR_FRAME_HEIGHT;
+	mMsg[6] = 1;
+	mMsg[7] = 0;
+	mMsg[8] = (uint8_t)(seq & 0xFF);
+	mMsg[9] = (uint8_t)((seq >> 8) & 0xFF);
+	mMsg[10] = (uint8_t)((seq >> 16) & 0xFF);
+	mMsg[11] = (uint8_t)((seq >> 24) & 0xFF);
+	mMsg[12] = (uint8_t)(len & 0xFF);
+	mMsg[13] = (uint8_t)((len >> 8) & 0xFF);
+
+	mMsgLen = (uint16_t)(ESPNOW_MSG_HEADER + len + blobLen);
+	mFragCount = (uint8_t)((mMsgLen + ESPNOW_FRAG_DATA - 1) / ESPNOW_FRAG_DATA);
+	++mFrameId;
+	memset(mNacks, 0, sizeof(mNacks));
+
+	for(uint8_t frag = 0; frag < mFragCount; frag++)
+	{
+		for(uint8_t i = 0; i < ESPNOW_MAX_PEERS; i++)
+		{
+			if(mAdded[i].mFlags & ESPNOW_PEER_FRAMES)
+			{
+				espNow_SendRules();											//Alarms go ahead of the frame
+				espNow_SendFragment(i, frag);
+			}//End if
+		}//End for
+	}//End for
+}//End espNow_SendFrame
+
+/*
+ * ***********************************************************************
+ * @brief       espNow_SendFragment
+ * @param       idx - Peer slot
+ * 				frag - Fragment of the current frame
+ * @return      True if the peer acknowledged the fragment
+ * @details     [X][03][frame id LE16][fragment][count], then up to
+ * 				ESPNOW_FRAG_DATA bytes of the frame message
+ **************************************************************************/
+static bool espNow_SendFragment(const uint8_t idx, const uint8_t frag)
+{
+	const uint16_t offset = (uint16_t)frag * ESPNOW_FRAG_DATA;
+	const uint16_t len = MIN(ESPNOW_FRAG_DATA, mMsgLen - offset);
+
+	mPacket[0] = ESPNOW_MAGIC;
+	mPacket[1] = ESPNOW_TYPE_FRAG;
+	mPacket[2] = (uint8_t)(mFrameId & 0xFF);
+	mPacket[3] = (uint8_t)(mFrameId >> 8);
+	mPacket[4] = frag;
+	mPacket[5] = mFragCount;
+	memcpy(&mPacket[ESPNOW_FRAG_HEADER], &mMsg[offset], len);
+	return espNow_SendTo(idx, mPacket, ESPNOW_FRAG_HEADER + len);
+}//End espNow_SendFragment
+
+/*
+ * ***********************************************************************
+ * @brief       espNow_Receive
+ * @param       None
+ * @return      None
+ * @details     Packets of unknown senders are ignored. A NACK
+ * 				[X][04][frame id LE16][mask LE64] of the current frame gets
+ * 				the fragments with their bit set sent again. An event of
+ * 				another hood is logged.
+ **************************************************************************/
+static void espNow_Receive(void)
+{
+	espNowRx_t rx;
+
+	while(xQueueReceive(mRxQueue, &rx, 0) == pdTRUE)
+	{
+		const int8_t idx = espNow_FindPeer(rx.mMac);
+		if(idx < 0)
+		{
+			continue;
+		}//End if
+
+		if(rx.mData[1] == ESPNOW_TYPE_NACK && rx.mLen >= ESPNOW_NACK_SIZE)
+		{
+			const uint16_t frameId = (uint16_t)(rx.mData[2] | (rx.mData[3] << 8));
+			if(frameId != mFrameId || mNacks[idx] >= ESPNOW_MAX_NACKS || !(mAdded[idx].mFlags & ESPNOW_PEER_FRAMES))
+			{
+				continue;													//Older frame, or the peer asked too often
+			}//End if
+			++mNacks[idx];
+
+			for(uint8_t frag = 0; frag < mFragCount; frag++)
+			{
+				if(rx.mData[4 + frag / 8] & (1 << (frag % 8)))
+				{
+					espNow_SendRules();
+					espNow_SendFragment((uint8_t)idx, frag);
+				}//End if
+			}//End for
+		}
+		else if(rx.mData[1] == ESPNOW_TYPE_EVENT && rx.mLen >= ESPNOW_EVENT_SIZE)
+		{
+			ESP_LOGI(ESPNOWTAG, ESPNOW_INFO_EVENT, MAC2STR(rx.mMac), rx.mData[2], rx.mData[3] ? "raised" : "cleared",
+					(unsigned)(rx.mData[4] | (rx.mData[5] << 8)));
+		}//End if-else
+	}//End while
+}//End espNow_Receive
+
+/*
+ * ***********************************************************************
+ * @brief       espNow_GetFlags
+ * @param       pTable - Peer table
+ * @return      Flags of every peer, ORed
+ **************************************************************************/
+static uint8_t espNow_GetFlags(const espNowTable_t* pTable)
+{
+	uint8_t flags = 0;
+
+	for(uint8_t i = 0; i < ESPNOW_MAX_PEERS; i++)
+	{
+		flags |= pTable->mPeer[i].mFlags;
+	}//End for
+	return flags;
+}//End espNow_GetFlags
+
+#else
+
+void espNowOnFrame(const uint16_t* pImage, const uint32_t seq)
+{
+	(void)pImage;
+	(void)seq;
+}//End espNowOnFrame
+
+void espNowNotifyRule(void)
+{
+}//End espNowNotifyRule
+
+uint8_t espNowGetDemandHz(void)
+{
+	return 0;
+}//End espNowGetDemandHz
+
+bool espNow_SetPeer(const uint8_t idx, const uint8_t* pMac, const uint8_t flags)
+{
+	return false;
+}//End espNow_SetPeer
+
+bool espNow_GetPeer(const uint8_t idx, uint8_t* pMac, uint8_t* pFlags, uint16_t* pFailed)
+{
+	return false;
+}//End espNow_GetPeer
+
+#endif
@@ -0,0 +1,641 @@
+/*****************************************************************************
+ * @file     flashLog.c
+ * @version  1.01
+ * @brief    Long-duration log of ROI statistics and frames on a flash partition.
+ * @date	 14 Oct 2026
+ * @details	 The sxlog partition is a ring of FLOG_CHUNK_SIZE chunks. Each
+ * 			 chunk starts with a flogChunkHeader_t and holds records in time
+ * 			 order, appended until the next one does not fit. The oldest
+ * 			 chunk is erased when the ring wraps.
+ *
+ * 			 senxorTask stages a sample with flashLogOnFrame, which only
+ * 			 copies and never waits: an ROI statistics record every
+ * 			 FLOG_PERIOD_MS and the image every FLOG_FRAME_PERIOD_MS.
+ * 			 flashLogTask appends it to a RAM image of the newest chunk and
+ * 			 programs whole FLOG_PAGE_SIZE pages as they fill, so a reset
+ * 			 loses at most the last page.
+ *
+ * 			 The RAM index holds the time span of every chunk. GET /log finds
+ * 			 the chunks of a time range by binary search and sends them as
+ * 			 stored, the newest one from RAM.
+ *
+ * 			 Times are on the log clock, milliseconds that continue from the
+ * 			 last record after a reboot. GET /log/status gives its value now.
+ ******************************************************************************/
+#include <string.h>
+#include <stdlib.h>
+#include <sys/param.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_partition.h>
+#include <esp_http_server.h>
+#include <sdkconfig.h>
+
+#include "SenXorLib.h"
+#include "FrameStats.h"
+#include "restServer.h"
+#include "util.h"
+#include "flashLog.h"
+#include "frameCodec.h"
+#include "roiEngine.h"
+#include "tcpServerTask.h"
+#include "senxorTask.h"
+
+#if CONFIG_MI_FLOG_EN
+
+#if (CONFIG_MI_FLOG_CHUNK_KB % 4) != 0
+#error "CONFIG_MI_FLOG_CHUNK_KB must be a multiple of the 4 kB erase sector"
+#endif
+
+//private:
+EXT_RAM_BSS_ATTR static uint8_t mChunkBuff[FLOG_CHUNK_SIZE];		//Newest chunk, erased bytes are 0xFF
+EXT_RAM_BSS_ATTR static flogIndex_t mIndex[FLOG_MAX_CHUNKS];		//Time index, by chunk position
+EXT_RAM_BSS_ATTR static uint16_t mStageImage[FLOG_IMAGE_PIXELS];
+EXT_RAM_BSS_ATTR static uint8_t mDeltaBuff[FLOG_IMAGE_PIXELS * 2];
+EXT_RAM_BSS_ATTR static uint8_t mEncBuff[FLOG_IMAGE_PIXELS * 2];	//Also checks the records at boot
+EXT_RAM_BSS_ATTR static uint8_t mReadBuff[FLOG_READ_CHUNK];		//httpd task
+static flogRoiEntry_t mStageRoi[ROI_MAX_COUNT + 1];				//Used slots and the whole image
+static uint8_t mStageRoiCount = 0;
+static bool mStageHasImage = false;
+static int64_t mStageUs = 0;
+static volatile bool mStageReady = false;							//Set by senxorTask, cleared once written
+static int64_t mNextStatsUs = 0;									//senxorTask only
+static int64_t mNextFrameUs = 0;
+static uint32_t mSkipped = 0;										//Samples due while the last one was still being written
+
+static const esp_partition_t* mPart = NULL;
+static uint16_t mChunkCount = 0;
+static uint16_t mHead = 0;											//Chunk in mChunkBuff
+static bool mIsOpen = false;										//mChunkBuff holds a chunk, opened by the first record
+static uint32_t mFlushed = 0;										//Bytes of mChunkBuff programmed
+static uint64_t mClockBaseMs = 0;									//Log clock at boot
+static SemaphoreHandle_t mLock = NULL;								//Guards mIndex, mChunkBuff and erases against the readers
+static TaskHandle_t mTaskHandle = NULL;								//Set once the log is ready
+
+static void flashLog_LoadIndex(void);
+static void flashLog_ScanChunk(const uint16_t idx);
+static void flashLog_OpenChunk(const uint64_t firstMs);
+static void flashLog_Append(const uint8_t type, const uint8_t encoding, const void* pPayload, const uint16_t len, const uint64_t timeMs);
+static void flashLog_Flush(const bool isClosing);
+static void flashLog_WriteSample(void);
+static uint16_t flashLog_GetOldest(uint16_t* pCount);
+static void flashLog_RegisterUris(void);
+static esp_err_t flashLog_GetHandler(httpd_req_t *req);
+static esp_err_t flashLog_StatusHandler(httpd_req_t *req);
+
+/*
+ * ***********************************************************************
+ * @brief       flashLogTask
+ * @param       pvParameters - Not used
+ * @return      None
+ * @details     Rebuild the time index from flash and write the samples
+ * 				staged by senxorTask
+ **************************************************************************/
+void flashLogTask(void *pvParameters)
+{
+	mPart = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, FLOG_PARTITION_SUBTYPE, FLOG_PARTITION_LABEL);
+	if(mPart == NULL)
+	{
+		ESP_LOGE(FLOGTAG, FLOG_ERR_PARTITION);
+		vTaskDelete(NULL);
+	}//End if
+
+	mChunkCount = MIN(mPart->size / FLOG_CHUNK_SIZE, FLOG_MAX_CHUNKS);
+	mLock = xSemaphoreCreateMutex();
+	flashLog_LoadIndex();
+	flashLog_RegisterUris();
+	ESP_LOGI(FLOGTAG, FLOG_INFO_START, mChunkCount, CONFIG_MI_FLOG_CHUNK_KB, mClockBaseMs);
+
+	mTaskHandle = xTaskGetCurrentTaskHandle();
+	senxorTaskNotifyClientChange();										//Capture demand changed
+
+	for(;;)
+	{
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);						//Woken by flashLogOnFrame
+		if(mStageReady)
+		{
+			flashLog_WriteSample();
+			mStageReady = false;
+		}//End if
+	}//End for
+}//End flashLogTask
+
+/*
+ * ***********************************************************************
+ * @brief       flashLogOnFrame
+ * @param       pImage - Analysed image, header rows removed
+ * @return      None
+ * @details     Called by senxorTask after the ROI analysis. Stages the
+ * 				samples that are due and wakes the log task. A sample due
+ * 				while the last one is still being written is skipped.
+ **************************************************************************/
+void flashLogOnFrame(const uint16_t* pImage)
+{
+	if(mTaskHandle == NULL)
+	{
+		return;
+	}//End if
+
+	const int64_t now = esp_timer_get_time();
+	const bool isStatsDue = now >= mNextStatsUs;
+	const bool isFrameDue = FLOG_FRAME_PERIOD_MS > 0 && now >= mNextFrameUs;
+	if(!isStatsDue && !isFrameDue)
+	{
+		return;
+	}//End if
+
+	if(mStageReady)
+	{
+		++mSkipped;
+		return;
+	}//End if
+
+	mStageRoiCount = 0;
+	if(isStatsDue)
+	{
+		roiStats_t stats;
+		frameStats_t frameStats;
+
+		for(uint8_t i = 0; i < ROI_MAX_COUNT; i++)
+		{
+			if(roiEngine_GetStats(i, &stats) && stats.mPixels > 0)
+			{
+				mStageRoi[mStageRoiCount++] = (flogRoiEntry_t){ i, 0, stats.mMin, stats.mMax, stats.mMean, stats.mPercentile };
+			}//End if
+		}//End for
+		FrameStats_Get(&frameStats);
+		mStageRoi[mStageRoiCount++] = (flogRoiEntry_t){ FLOG_ROI_FRAME, 0, frameStats.mMin, frameStats.mMax, frameStats.mMean, frameStats.mP99 };
+		mNextStatsUs = now + FLOG_PERIOD_MS * 1000LL;
+	}//End if
+
+	mStageHasImage = isFrameDue;
+	if(isFrameDue)
+	{
+		memcpy(mStageImage, pImage, sizeof(mStageImage));
+		mNextFrameUs = now + FLOG_FRAME_PERIOD_MS * 1000LL;
+	}//End if
+
+	mStageUs = now;
+	mStageReady = true;
+	xTaskNotifyGive(mTaskHandle);
+}//End flashLogOnFrame
+
+/*
+ * ***********************************************************************
+ * @brief       flashLogGetDemandHz
+ * @param       None
+ * @return      Frames per second the log needs, 0 if it is not running
+ * @details     None
+ **************************************************************************/
+uint8_t flashLogGetDemandHz(void)
+{
+	return (mTaskHandle != NULL) ? FLOG_DEMAND_HZ : 0;
+}//End flashLogGetDemandHz
+
+/*
+ * ***********************************************************************
+ * @brief       flashLog_LoadIndex
+ * @param       None
+ * @return      None
+ * @details     Read every chunk header and check its records, then start
+ * 				the log clock after the newest record. The first record
+ * 				opens a new chunk after the newest one.
+ **************************************************************************/
+static void flashLog_LoadIndex(void)
+{
+	uint32_t newestSeq = 0;
+
+	for(uint16_t i = 0; i < mChunkCount; i++)
+	{
+		flashLog_ScanChunk(i);
+		if(mIndex[i].mSeq > newestSeq)
+		{
+			newestSeq = mIndex[i].mSeq;
+			mHead = i;
+			mClockBaseMs = mIndex[i].mLastMs + 1;
+		}//End if
+	}//End for
+}//End flashLog_LoadIndex
+
+/*
+ * ***********************************************************************
+ * @brief       flashLog_ScanChunk
+ * @param       idx - Chunk position
+ * @return      None
+ * @details     Index entry of a chunk. The records end at erased flash or
+ * 				at the first one that fails its CRC, cut by a reset.
+ **************************************************************************/
+static void flashLog_ScanChunk(const uint16_t idx)
+{
+	const size_t base = (size_t)idx * FLOG_CHUNK_SIZE;
+	flogChunkHeader_t header;
+	flogRecord_t record;
+
+	memset(&mIndex[idx], 0, sizeof(mIndex[idx]));
+	if(esp_partition_read(mPart, base, &header, sizeof(header)) != ESP_OK
+			|| header.mMagic != FLOG_CHUNK_MAGIC || header.mVersion != FLOG_VERSION || header.mSeq == 0)
+	{
+		return;
+	}//End if
+
+	uint32_t pos = header.mHeaderLen;
+	uint64_t lastMs = header.mFirstMs;
+	while(pos + sizeof(record) <= FLOG_CHUNK_SIZE)
+	{
+		if(esp_partition_read(mPart, base + pos, &record, sizeof(record)) != ESP_OK
+				|| record.mLen == FLOG_REC_EMPTY || record.mLen > sizeof(mEncBuff)
+				|| pos + sizeof(record) + record.mLen > FLOG_CHUNK_SIZE
+				|| esp_partition_read(mPart, base + pos + sizeof(record), mEncBuff, record.mLen) != ESP_OK
+				|| getCRC16(mEncBuff, record.mLen) != record.mCrc)
+		{
+			break;
+		}//End if
+		lastMs = header.mFirstMs + record.mTimeMs;
+		pos += sizeof(record) + record.mLen;
+	}//End while
+
+	mIndex[idx].mSeq = header.mSeq;
+	mIndex[idx].mUsed = pos;
+	mIndex[idx].mFirstMs = header.mFirstMs;
+	mIndex[idx].mLastMs = lastMs;
+}//End flashLog_ScanChunk
+
+/*
+ * ***********************************************************************
+ * @brief       flashLog_OpenChunk
+ * @param       firstMs - Log clock of the first record
+ * @return      None
+ * @details     Erase the chunk after the newest one and start it in
+ * 				mChunkBuff. The readers skip it while it is erased.
+ **************************************************************************/
+static void flashLog_OpenChunk(const uint64_t firstMs)
+{
+	const uint32_t seq = mIndex[mHead].mSeq + 1;
+	const uint16_t next = (mIndex[mHead].mSeq == 0) ? mHead : (mHead + 1) % mChunkCount;		//Empty log starts at position 0
+
+	xSemaphoreTake(mLock, portMAX_DELAY);
+	if(mIndex[next].mSeq != 0)
+	{
+		ESP_LOGI(FLOGTAG, FLOG_INFO_WRAP, next);
+	}//End if
+	mIndex[next].mSeq = 0;
+	const esp_err_t err = esp_partition_erase_range(mPart, (size_t)next * FLOG_CHUNK_SIZE, FLOG_CHUNK_SIZE);
+	if(err != ESP_OK)
+	{
+		ESP_LOGE(FLOGTAG, FLOG_ERR_FLASH, "erase", esp_err_to_name(err));
+	}//End if
+
+	const flogChunkHeader_t header = {
+		.mMagic = FLOG_CHUNK_MAGIC,
+		.mVersion = FLOG_VERSION,
+		.mHeaderLen = sizeof(flogChunkHeader_t),
+		.mReserved = 0,
+		.mSeq = seq,
+		.mFirstMs = firstMs
+	};
+	memset(mChunkBuff, 0xFF, sizeof(mChunkBuff));
+	memcpy(mChunkBuff, &header, sizeof(header));
+	mIndex[next] = (flogIndex_t){ seq, sizeof(header), firstMs, firstMs };
+	mHead = next;
+	mIsOpen = true;
+	mFlushed = 0;
+	xSemaphoreGive(mLock);
+}//End flashLog_OpenChunk
+
+/*
+ * ***********************************************************************
+ * @brief       flashLog_Append
+ * @param       type - flogRecType_t
+ * 				encoding - tcpStreamEncoding_t of a frame, 0 otherwise
+ * 				pPayload, len - Record payload
+ * 				timeMs - Log clock of the sample
+ * @return      None
+ * @details     Append a record to the newest chunk, opening the next
+ * 				chunk when it does not fit, and program the full pages
+ **************************************************************************/
+static void flashLog_Append(const uint8_t type, const uint8_t encoding, const void* pPayload, const uint16_t len, const uint64_t timeMs)
+{
+	const uint32_t total = sizeof(flogRecord_t) + len;
+
+	if(!mIsOpen || mIndex[mHead].mUsed + total > FLOG_CHUNK_SIZE)
+	{
+		if(mIsOpen)
+		{
+			flashLog_Flush(true);
+		}//End if
+		flashLog_OpenChunk(timeMs);
+	}//End if
+
+	flogIndex_t* pChunk = &mIndex[mHead];
+	const flogRecord_t record = {
+		.mLen = len,
+		.mType = type,
+		.mEncoding = encoding,
+		.mTimeMs = (uint32_t)(timeMs - pChunk->mFirstMs),
+		.mCrc = getCRC16(pPayload, len)
+	};
+
+	xSemaphoreTake(mLock, portMAX_DELAY);
+	memcpy(&mChunkBuff[pChunk->mUsed], &record, sizeof(record));
+	memcpy(&mChunkBuff[pChunk->mUsed + sizeof(record)], pPayload, len);
+	pChunk->mUsed += total;
+	pChunk->mLastMs = timeMs;
+	xSemaphoreGive(mLock);
+
+	flashLog_Flush(false);
+}//End flashLog_Append
+
+/*
+ * ***********************************************************************
+ * @brief       flashLog_Flush
+ * @param       isClosing - Also program the last, partly filled page
+ * @return      None
+ * @details     Program the pages of mChunkBuff filled since the last
+ * 				flush. A page is programmed once, when it is full or when
+ * 				the chunk is closed.
+ **************************************************************************/
+static void flashLog_Flush(const bool isClosing)
+{
+	const uint32_t used = mIndex[mHead].mUsed;
+	const uint32_t end = isClosing ? MIN((used + FLOG_PAGE_SIZE - 1) / FLOG_PAGE_SIZE * FLOG_PAGE_SIZE, (uint32_t)FLOG_CHUNK_SIZE)
+									: used / FLOG_PAGE_SIZE * FLOG_PAGE_SIZE;
+
+	if(end <= mFlushed)
+	{
+		return;
+	}//End if
+
+	const esp_err_t err = esp_partition_write(mPart, (size_t)mHead * FLOG_CHUNK_SIZE + mFlushed, &mChunkBuff[mFlushed], end - mFlushed);
+	if(err != ESP_OK)
+	{
+		ESP_LOGE(FLOGTAG, FLOG_ERR_FLASH, "write", esp_err_to_name(err));
+	}//End if
+	mFlushed = end;
+}//End flashLog_Flush
+
+/*
+ * ***********************************************************************
+ * @brief       flashLog_WriteSample
+ * @param       None
+ * @return      None
+ * @details     Append the staged statistics and image. The image is a
+ * 				keyframe, delta coded and LZ compressed when that shrinks it.
+ **************************************************************************/
+static void flashLog_WriteSample(void)
+{
+	const uint64_t timeMs = mClockBaseMs + (uint64_t)(mStageUs / 1000);
+
+	if(mStageRoiCount > 0)
+	{
+		flashLog_Append(FLOG_REC_ROI, 0, mStageRoi, mStageRoiCount * sizeof(flogRoiEntry_t), timeMs);
+	}//End if
+
+	if(mStageHasImage)
+	{
+		const uint8_t* pPayload = (const uint8_t*)mStageImage;
+		size_t len = sizeof(mStageImage);
+		uint8_t encoding = TCP_STREAM_ENC_RAW16;
+
+		const size_t deltaLen = frameCodec_EncodeDelta(mStageImage, NULL, FLOG_IMAGE_PIXELS, mDeltaBuff, sizeof(mDeltaBuff));
+		if(deltaLen > 0)
+		{
+			const size_t lzLen = frameCodec_CompressLZ(mDeltaBuff, deltaLen, mEncBuff, deltaLen - 1);
+			pPayload = (lzLen > 0) ? mEncBuff : mDeltaBuff;
+			len = (lzLen > 0) ? lzLen : deltaLen;
+			encoding = (lzLen > 0) ? TCP_STREAM_ENC_DELTA_LZ : TCP_STREAM_ENC_DELTA;
+		}//End if
+		flashLog_Append(FLOG_REC_FRAME, encoding, pPayload, (uint16_t)len, timeMs);
+	}//End if
+}//End flashLog_WriteSample
+
+/*
+ * ***********************************************************************
+ * @brief       flashLog_GetOldest
+ * @param       pCount - Chunks in the log, in time order from the oldest
+ * @return      Position of the oldest chunk
+ * @details     Call with mLock held. Chunks are written in position
+ * 				order, so going back from the newest the sequence numbers
+ * 				drop by one until the erased or oldest chunk.
+ **************************************************************************/
+static uint16_t flashLog_GetOldest(uint16_t* pCount)
+{
+	const uint32_t newestSeq = mIndex[mHead].mSeq;
+	uint16_t oldest = mHead;
+	uint16_t count = 0;
+
+	for(uint16_t i = 0; i < mChunkCount; i++)
+	{
+		const uint16_t idx = (mHead + mChunkCount - i) % mChunkCount;
+		if(newestSeq == 0 || mIndex[idx].mSeq != newestSeq - i)
+		{
+			break;
+		}//End if
+		oldest = idx;
+		++count;
+	}//End for
+
+	*pCount = count;
+	return oldest;
+}//End flashLog_GetOldest
+
+/*
+ * ***********************************************************************
+ * @brief       flashLog_RegisterUris
+ * @param       None
+ * @return      None
+ * @details     Serve the log on the REST server, in Wi-Fi mode only
+ **************************************************************************/
+static void flashLog_RegisterUris(void)
+{
+	httpd_handle_t server = getRestServerHandler();
+	if(server == NULL)
+	{
+		ESP_LOGW(FLOGTAG, FLOG_WARN_NO_SERVER);
+		return;
+	}//End if
+
+	const httpd_uri_t logUri = {
+		.uri = FLOG_URI,
+		.method = HTTP_GET,
+		.handler = flashLog_GetHandler,
+		.user_ctx = NULL
+	};
+	const httpd_uri_t statusUri = {
+		.uri = FLOG_STATUS_URI,
+		.method = HTTP_GET,
+		.handler = flashLog_StatusHandler,
+		.user_ctx = NULL
+	};
+
+	esp_err_t err = httpd_register_uri_handler(server, &logUri);
+	if(err != ESP_OK)
+	{
+		ESP_LOGE(FLOGTAG, FLOG_ERR_REGISTER, FLOG_URI, esp_err_to_name(err));
+	}//End if
+	err = httpd_register_uri_handler(server, &statusUri);
+	if(err != ESP_OK)
+	{
+		ESP_LOGE(FLOGTAG, FLOG_ERR_REGISTER, FLOG_STATUS_URI, esp_err_to_name(err));
+	}//End if
+}//End flashLog_RegisterUris
+
+/*
+ * ***********************************************************************
+ * @brief       flashLog_GetHandler
+ * @param       req - HTTP request, optional from and to on the log clock (ms)
+ * @return      ESP_OK, or an error to have httpd close the session
+ * @details     Runs in the httpd task. Sends every chunk with records in
+ * 				[from, to] as stored, header first, oldest first. The
+ * 				first and last chunk are found by binary search, the
+ * 				client drops the records outside the range.
+ **************************************************************************/
+static esp_err_t flashLog_GetHandler(httpd_req_t *req)
+{
+	char query[64];
+	char value[24];
+	uint64_t fromMs = 0;
+	uint64_t toMs = UINT64_MAX;
+
+	if(httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK)
+	{
+		if(httpd_query_key_value(query, "from", value, sizeof(value)) == ESP_OK)
+		{
+			fromMs = strtoull(value, NULL, 10);
+		}//End if
+		if(httpd_query_key_value(query, "to", value, sizeof(value)) == ESP_OK)
+		{
+			toMs = strtoull(value, NULL, 10);
+		}//End if
+	}//End if
+
+	uint16_t count;
+	xSemaphoreTake(mLock, portMAX_DELAY);
+	const uint16_t oldest = flashLog_GetOldest(&count);
+	const uint32_t oldestSeq = mIndex[oldest].mSeq;
+
+	// First chunk ending at or after from, then the first starting after to
+	uint16_t lo = 0;
+	uint16_t hi = count;
+	while(lo < hi)
+	{
+		const uint16_t mid = (lo + hi) / 2;
+		if(mIndex[(oldest + mid) % mChunkCount].mLastMs < fromMs)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}//End if-else
+	}//End while
+	const uint16_t first = lo;
+	hi = count;
+	while(lo < hi)
+	{
+		const uint16_t mid = (lo + hi) / 2;
+		if(mIndex[(oldest + mid) % mChunkCount].mFirstMs <= toMs)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}//End if-else
+	}//End while
+	const uint16_t last = lo;
+	xSemaphoreGive(mLock);
+
+	httpd_resp_set_type(req, "application/octet-stream");
+	for(uint16_t k = first; k < last; k++)
+	{
+		const uint16_t idx = (oldest + k) % mChunkCount;
+		const uint32_t seq = oldestSeq + k;
+
+		for(uint32_t pos = 0; ; )
+		{
+			// Stop at the end of the chunk, or if the ring wrapped over it meanwhile
+			xSemaphoreTake(mLock, portMAX_DELAY);
+			const uint32_t len = (mIndex[idx].mSeq == seq && pos < mIndex[idx].mUsed) ? MIN(mIndex[idx].mUsed - pos, FLOG_READ_CHUNK) : 0;
+			if(len > 0)
+			{
+				if(mIsOpen && idx == mHead)
+				{
+					memcpy(mReadBuff, &mChunkBuff[pos], len);
+				}
+				else
+				{
+					esp_partition_read(mPart, (size_t)idx * FLOG_CHUNK_SIZE + pos, mReadBuff, len);
+				}//End if-else
+			}//End if
+			xSemaphoreGive(mLock);
+
+			if(len == 0)
+			{
+				break;
+			}//End if
+			if(httpd_resp_send_chunk(req, (const char*)mReadBuff, len) != ESP_OK)
+			{
+				return ESP_FAIL;
+			}//End if
+			pos += len;
+		}//End for
+	}//End for
+
+	return httpd_resp_send_chunk(req, NULL, 0);
+}//End flashLog_GetHandler
+
+/*
+ * ***********************************************************************
+ * @brief       flashLog_StatusHandler
+ * @param       req - HTTP request
+ * @return      ESP_OK, ESP_FAIL if the client went away
+ * @details     Runs in the httpd task. Log clock now, the span of the log
+ * 				and its use, as JSON.
+ **************************************************************************/
+static esp_err_t flashLog_StatusHandler(httpd_req_t *req)
+{
+	uint16_t count;
+	uint32_t usedBytes = 0;
+
+	xSemaphoreTake(mLock, portMAX_DELAY);
+	const uint16_t oldest = flashLog_GetOldest(&count);
+	const uint64_t oldestMs = (count > 0) ? mIndex[oldest].mFirstMs : 0;
+	const uint64_t newestMs = (count > 0) ? mIndex[mHead].mLastMs : 0;
+	for(uint16_t k = 0; k < count; k++)
+	{
+		usedBytes += mIndex[(oldest + k) % mChunkCount].mUsed;
+	}//End for
+	xSemaphoreGive(mLock);
+
+	jsonWriter_t json;
+	restServer_JsonBegin(&json, req);
+	jsonBeginObject(&json, NULL);
+	jsonAddInt(&json, "now_ms", (int64_t)(mClockBaseMs + (uint64_t)(esp_timer_get_time() / 1000)));
+	jsonAddInt(&json, "oldest_ms", (int64_t)oldestMs);
+	jsonAddInt(&json, "newest_ms", (int64_t)newestMs);
+	jsonAddInt(&json, "chunks", count);
+	jsonAddInt(&json, "chunk_count", mChunkCount);
+	jsonAddInt(&json, "chunk_size", FLOG_CHUNK_SIZE);
+	jsonAddInt(&json, "used_bytes", usedBytes);
+	jsonAddInt(&json, "skipped", mSkipped);
+	jsonEndObject(&json);
+
+	return restServer_JsonEnd(&json, req);
+}//End flashLog_StatusHandler
+
+#else
+
+void flashLogOnFrame(const uint16_t* pImage)
+{
+	(void)pImage;
+}//End flashLogOnFrame
+
+uint8_t flashLogGetDemandHz(void)
+{
+	return 0;
+}//End flashLogGetDemandHz
+
+#endif
@@ -0,0 +1,330 @@
+/*****************************************************************************
+ * @file     frameClassifier.c
+ * @version  1.00
+ * @brief    Flame and pan classification of the frames with a quantised CNN.
+ * @date	 15 Oct 2026
+ * @details	 A hot pan and an unattended flame can have the same maximum,
+ * 			 what tells them apart is the shape of the hot area. This stage
+ * 			 runs a small int8 CNN (classifierModel.cc) on the image or the
+ * 			 bounding box of one ROI, box averaged down to the input of the
+ * 			 model, REG_CLS_RATE times a second.
+ *
+ * 			 frameClassifierOnFrame runs in the analytics stage, so it sees
+ * 			 streamed and polled frames alike, and only copies the image
+ * 			 when an inference is due and the last one is done.
+ * 			 frameClassifierTask classifies it at the lowest application
+ * 			 priority on core 1, in the time the capture and the analytics
+ * 			 leave. The tensor arena stays in internal RAM, the kernels
+ * 			 read it many times per inference.
+ *
+ * 			 The scores go to registers REG_CLS_CLASS-REG_CLS_LATENCY, which
+ * 			 the alarm rules can watch, so a flame raises a rule and its
+ * 			 BLE, ESP-NOW and MQTT events like any other metric.
+ ******************************************************************************/
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_attr.h>
+
+#include "FrameStats.h"
+#include "frameClassifier.h"
+#include "classifierModel.h"
+#include "roiEngine.h"
+#include "senxorTask.h"
+
+#if CONFIG_MI_CLASSIFY_EN
+
+//private:
+EXT_RAM_BSS_ATTR static uint16_t mImage[CLS_PIXELS];					//Image handed over by frameClassifierOnFrame
+static uint8_t mArena[CLS_ARENA_SIZE] __attribute__((aligned(16)));	//Tensor arena, internal RAM
+static clsInput_t mInput;
+static TaskHandle_t mTaskHandle = NULL;
+static volatile bool mReady = false;									//Model loaded
+static volatile bool mImageReady = false;								//mImage waits for the task
+static int64_t mNextUs = 0;												//Next inference due, analytics stage only
+
+static portMUX_TYPE mLock = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t mRate = CLS_DEFAULT_RATE;								//Written by the command tasks
+static uint8_t mRoi = 0;
+static uint8_t mClass = CLS_CLASS_NONE;									//Read by the command tasks and the rules
+static uint16_t mScore[CLS_CLASS_COUNT];
+static uint32_t mLatencyUs = 0;
+static clsStats_t mStats;
+static uint64_t mSumUs = 0;
+
+static void frameClassifier_Prepare(const uint8_t x0, const uint8_t y0, const uint8_t width, const uint8_t height, const uint8_t scale);
+
+/*
+ * ***********************************************************************
+ * @brief       frameClassifierTask
+ * @param       pvParameters - Not used
+ * @return      None
+ * @details     Load the model, then classify every image handed over
+ **************************************************************************/
+void frameClassifierTask(void *pvParameters)
+{
+	if (!classifierModel_Init(mArena, sizeof(mArena), &mInput))
+	{
+		ESP_LOGE(CLSTAG, CLS_ERR_MODEL);
+		vTaskDelete(NULL);
+	}//End if
+	ESP_LOGI(CLSTAG, CLS_INFO_READY, mInput.mWidth, mInput.mHeight, mInput.mClasses, (unsigned)mInput.mArenaUsed, (unsigned)sizeof(mArena));
+
+	mTaskHandle = xTaskGetCurrentTaskHandle();
+	mReady = true;
+	senxorTaskNotifyClientChange();										//Capture demand of the boot rate
+
+	for (;;)
+	{
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		if (!mImageReady)
+		{
+			continue;
+		}//End if
+		const int64_t startUs = esp_timer_get_time();
+
+		taskENTER_CRITICAL(&mLock);
+		const uint8_t roi = mRoi;
+		taskEXIT_CRITICAL(&mLock);
+		uint8_t x = 0, y = 0, width = CLS_WIDTH, height = CLS_HEIGHT;
+		if (roi > 0 && !roiEngine_GetBounds(roi - 1, &x, &y, &width, &height))
+		{
+			x = 0;															//Unused ROI, whole image
+			y = 0;
+			width = CLS_WIDTH;
+			height = CLS_HEIGHT;
+		}//End if
+
+		frameStats_t stats;
+		FrameStats_Get(&stats);
+		frameClassifier_Prepare(x, y, width, height, (stats.mScale > 0) ? stats.mScale : 10);
+		mImageReady = false;												//Input tensor filled, the next image can come
+
+		uint16_t score[CLS_CLASS_COUNT];
+		if (!classifierModel_Invoke(score, CLS_CLASS_COUNT))
+		{
+			ESP_LOGE(CLSTAG, CLS_ERR_INVOKE);
+			continue;
+		}//End if
+		uint8_t best = CLS_CLASS_NONE;
+		for (uint8_t i = 1; i < CLS_CLASS_COUNT; i++)
+		{
+			best = (score[i] > score[best]) ? i : best;
+		}//End for
+		const uint32_t us = (uint32_t)(esp_timer_get_time() - startUs);
+
+		taskENTER_CRITICAL(&mLock);
+		mClass = best;
+		memcpy(mScore, score, sizeof(mScore));
+		mLatencyUs = us;
+		mStats.mInferences++;
+		mStats.mLastUs = us;
+		mStats.mMaxUs = (us > mStats.mMaxUs) ? us : mStats.mMaxUs;
+		mSumUs += us;
+		taskEXIT_CRITICAL(&mLock);
+	}//End for
+}//End frameClassifierTask
+
+/*
+ * ***********************************************************************
+ * @brief       frameClassifierOnFrame
+ * @param       pImage - Image of the frame, header rows removed
+ * @return      None
+ * @details     Called by senxorAnalyse for every frame. Copies the image
+ * 				when an inference is due and the last image is classified.
+ **************************************************************************/
+void frameClassifierOnFrame(const uint16_t* pImage)
+{
+	const uint8_t rate = mRate;
+
+	if (!mReady || rate == 0)
+	{
+		return;
+	}//End if
+
+	const int64_t now = esp_timer_get_time();
+	const int64_t periodUs = 1000000 / rate;
+	if (now < mNextUs - periodUs / 2)
+	{
+		return;
+	}//End if
+	mNextUs += periodUs;													//Fixed grid so the average rate is exact
+	if (mNextUs <= now)
+	{
+		mNextUs = now + periodUs;
+	}//End if
+
+	if (mImageReady)
+	{
+		taskENTER_CRITICAL(&mLock);
+		mStats.mBusy++;
+		taskEXIT_CRITICAL(&mLock);
+		return;
+	}//End if
+	memcpy(mImage, pImage, sizeof(mImage));
+	mImageReady = true;
+	xTaskNotifyGive(mTaskHandle);
+}//End frameClassifierOnFrame
+
+/*
+ * ***********************************************************************
+ * @brief       frameClassifierGetDemandHz
+ * @param       None
+ * @return      Capture rate the classifier needs, 0 while it is off
+ * @details     Keeps capture running without clients, a flame must be
+ * 				seen when nobody watches.
+ **************************************************************************/
+uint8_t frameClassifierGetDemandHz(void)
+{
+	return mReady ? mRate : 0;
+}//End frameClassifierGetDemandHz
+
+/*
+ * ***********************************************************************
+ * @brief       frameClassifier_GetStats
+ * @param       pStats - Output
+ * 				reset - Start the next period
+ * @return      None
+ **************************************************************************/
+void frameClassifier_GetStats(clsStats_t* pStats, const bool reset)
+{
+	taskENTER_CRITICAL(&mLock);
+	*pStats = mStats;
+	const uint64_t sumUs = mSumUs;
+	if (reset)
+	{
+		memset(&mStats, 0, sizeof(mStats));
+		mSumUs = 0;
+	}//End if
+	taskEXIT_CRITICAL(&mLock);
+	pStats->mAvgUs = (pStats->mInferences > 0) ? (uint32_t)(sumUs / pStats->mInferences) : 0;
+}//End frameClassifier_GetStats
+
+/*
+ * ***********************************************************************
+ * @brief       frameClassifier_ReadRegister
+ * @param       regAddr - Register address (REG_CLS_FIRST-REG_CLS_LAST)
+ * @return      Register value
+ **************************************************************************/
+uint16_t frameClassifier_ReadRegister(const uint8_t regAddr)
+{
+	uint16_t value = 0;
+
+	taskENTER_CRITICAL(&mLock);
+	switch (regAddr)
+	{
+		case REG_CLS_RATE:		value = mRate;													break;
+		case REG_CLS_ROI:		value = mRoi;													break;
+		case REG_CLS_CLASS:		value = mClass;													break;
+		case REG_CLS_FLAME:		value = mScore[CLS_CLASS_FLAME];								break;
+		case REG_CLS_PAN:		value = mScore[CLS_CLASS_PAN];									break;
+		case REG_CLS_LATENCY:	value = (mLatencyUs > UINT16_MAX) ? UINT16_MAX : mLatencyUs;	break;
+		default:																				break;
+	}//End switch
+	taskEXIT_CRITICAL(&mLock);
+
+	return value;
+}//End frameClassifier_ReadRegister
+
+/*
+ * ***********************************************************************
+ * @brief       frameClassifier_WriteRegister
+ * @param       regAddr - Register address (REG_CLS_RATE or REG_CLS_ROI)
+ * 				value - Value to write
+ * @return      None
+ * @details     Out of range values are ignored. Not persisted, the
+ * 				Kconfig default rate applies after a reboot.
+ **************************************************************************/
+void frameClassifier_WriteRegister(const uint8_t regAddr, const uint8_t value)
+{
+	taskENTER_CRITICAL(&mLock);
+	if (regAddr == REG_CLS_RATE && value <= CLS_MAX_RATE_HZ)
+	{
+		mRate = value;
+	}
+	else if (regAddr == REG_CLS_ROI && value <= ROI_MAX_COUNT)
+	{
+		mRoi = value;
+	}//End if-else
+	taskEXIT_CRITICAL(&mLock);
+
+	ESP_LOGI(CLSTAG, CLS_INFO_RATE, mRate, mRoi);
+	senxorTaskNotifyClientChange();										//Capture demand changed
+}//End frameClassifier_WriteRegister
+
+/*
+ * ***********************************************************************
+ * @brief       frameClassifier_Prepare
+ * @param       x0, y0 - Top left pixel of the area classified
+ * 				width, height - Size of the area
+ * 				scale - Raw frame units per Kelvin
+ * @return      None
+ * @details     Box average of the area onto the model input, quantised
+ * 				with the scale and zero point of the input tensor. An area
+ * 				smaller than the input repeats its pixels.
+ **************************************************************************/
+static void frameClassifier_Prepare(const uint8_t x0, const uint8_t y0, const uint8_t width, const uint8_t height, const uint8_t scale)
+{
+	const float qPerRaw = 1.0f / ((float)scale * mInput.mScale);
+	const uint8_t outW = mInput.mWidth;
+	const uint8_t outH = mInput.mHeight;
+	int8_t* pOut = mInput.pData;
+
+	for (uint8_t oy = 0; oy < outH; oy++)
+	{
+		const uint8_t ya = y0 + (oy * height) / outH;
+		uint8_t yb = y0 + ((oy + 1) * height) / outH;
+		yb = (yb > ya) ? yb : ya + 1;
+		for (uint8_t ox = 0; ox < outW; ox++)
+		{
+			const uint8_t xa = x0 + (ox * width) / outW;
+			uint8_t xb = x0 + ((ox + 1) * width) / outW;
+			xb = (xb > xa) ? xb : xa + 1;
+			uint32_t sum = 0;
+			for (uint8_t y = ya; y < yb; y++)
+			{
+				const uint16_t* pRow = &mImage[y * CLS_WIDTH];
+				for (uint8_t x = xa; x < xb; x++)
+				{
+					sum += pRow[x];
+				}//End for
+			}//End for
+			const int32_t q = (int32_t)((float)sum * qPerRaw / (float)((yb - ya) * (xb - xa)) + 0.5f) + mInput.mZeroPoint;
+			*pOut++ = (int8_t)((q < INT8_MIN) ? INT8_MIN : (q > INT8_MAX) ? INT8_MAX : q);
+		}//End for
+	}//End for
+}//End frameClassifier_Prepare
+
+#else
+
+void frameClassifierOnFrame(const uint16_t* pImage)
+{
+	(void)pImage;
+}//End frameClassifierOnFrame
+
+uint8_t frameClassifierGetDemandHz(void)
+{
+	return 0;
+}//End frameClassifierGetDemandHz
+
+void frameClassifier_GetStats(clsStats_t* pStats, const bool reset)
+{
+	(void)reset;
+	memset(pStats, 0, sizeof(*pStats));
+}//End frameClassifier_GetStats
+
+uint16_t frameClassifier_ReadRegister(const uint8_t regAddr)
+{
+	(void)regAddr;
+	return 0;
+}//End frameClassifier_ReadRegister
+
+void frameClassifier_WriteRegister(const uint8_t regAddr, const uint8_t value)
+{
+	(void)regAddr;
+	(void)value;
+}//End frameClassifier_WriteRegister
+
+#endif
@@ -0,0 +1,458 @@
+/*****************************************************************************
+ * @file     frameCodec.c
+ * @version  1.02
+ * @brief    Frame encoders of the Wi-Fi frame stream.
+ * @date	 14 Oct 2026
+ * @details	 Delta stage: every pixel is predicted from the same pixel of the
+ * 			 reference frame (delta frame), or from the previous pixel of the
+ * 			 same frame (keyframe). The residual is zigzag mapped and written
+ * 			 as a varint. A 0x00 byte starts a run of zero residuals, followed
+ * 			 by a varint of the run length minus one. A residual varint never
+ * 			 starts with 0x00, so the marker is unambiguous.
+ *
+ * 			 LZ stage: optional byte oriented LZ77 on the delta output, using
+ * 			 the LZ4 block layout. A token holds the literal length (high
+ * 			 nibble) and match length minus FRAME_CODEC_LZ_MIN_MATCH (low
+ * 			 nibble), 15 means more length bytes follow. Literals come next,
+ * 			 then a 16 bit little endian match offset. The last sequence has
+ * 			 literals only.
+ *
+ * 			 Max-pool stage: crops and decimates the image of shaped streams
+ * 			 ahead of the encoders.
+ *
+ * 			 Bit packing: every pixel minus the frame minimum, shifted right
+ * 			 until the frame span fits, as an LSB first stream of 8, 12 or 14
+ * 			 bit values. Lossless while the span fits the width. The kernel
+ * 			 works on two pixels per 32 bit word (SWAR): one subtract, shift
+ * 			 and mask handles both lanes, and whole groups of pixels end on
+ * 			 a byte boundary.
+ *
+ * 			 Both encoders give up and return 0 once the output would not fit
+ * 			 in outMax, so the caller can send the frame raw instead.
+ * 			 The decoders live in the clients (FrameStreamConnection.swift,
+ * 			 client.js).
+ ******************************************************************************/
+#include <string.h>
+
+#include "frameCodec.h"
+
+#define LZ_HASH_SIZE		(1 << FRAME_CODEC_LZ_HASH_BITS)
+
+#define PACK_PAIR(p, i)		((uint32_t)(p)[i] | ((uint32_t)(p)[(i) + 1] << 16))	//Two pixels, one per 16 bit lane
+
+//private:
+static uint16_t mLzTable[LZ_HASH_SIZE];						//Last position + 1 of each hash, 0 if unused. Shared, every candidate is verified
+
+static size_t frameCodec_PutVarint(uint8_t* pOut, size_t pos, const size_t outMax, uint32_t value);
+static size_t frameCodec_PutLength(uint8_t* pOut, size_t pos, const size_t outMax, size_t len);
+static size_t frameCodec_PutSequence(uint8_t* pOut, size_t pos, const size_t outMax, const uint8_t* pLit, const size_t litLen, const size_t offset, const size_t matchLen);
+
+/*
+ * ***********************************************************************
+ * @brief       frameCodec_EncodeDelta
+ * @param       pFrame - Frame to encode
+ * 				pRef - Reference frame, NULL for a keyframe
+ * 				pixels - Number of pixels in pFrame and pRef
+ * 				pOut - Output buffer
+ * 				outMax - Size of the output buffer
+ * @return      Encoded size, 0 if it does not fit in outMax
+ * @details     Delta, zigzag and varint coding with zero run-length.
+ * 				pFrame = pRef gives a few bytes for the whole frame.
+ **************************************************************************/
+size_t frameCodec_EncodeDelta(const uint16_t* pFrame, const uint16_t* pRef, const size_t pixels, uint8_t* pOut, const size_t outMax)
+{
+	size_t pos = 0;
+	uint32_t zeroRun = 0;
+	uint16_t predict = 0;
+
+	for(size_t i = 0; i < pixels; i++)
+	{
+		if(pRef != NULL)
+		{
+			predict = pRef[i];
+		}//End if
+
+		const uint16_t delta = (uint16_t)(pFrame[i] - predict);
+		const uint16_t zigzag = (uint16_t)((delta << 1) ^ ((delta & 0x8000) ? 0xFFFF : 0x0000));
+		predict = pFrame[i];
+
+		if(zigzag == 0)
+		{
+			++zeroRun;
+			continue;
+		}//End if
+
+		if(zeroRun > 0)
+		{
+			if(pos >= outMax)
+			{
+				return 0;
+			}//End if
+			pOut[pos++] = 0x00;
+			pos = frameCodec_PutVarint(pOut, pos, outMax, zeroRun - 1);
+			zeroRun = 0;
+			if(pos == 0)
+			{
+				return 0;
+			}//End if
+		}//End if
+
+		pos = frameCodec_PutVarint(pOut, pos, outMax, zigzag);
+		if(pos == 0)
+		{
+			return 0;
+		}//End if
+	}//End for
+
+	if(zeroRun > 0)
+	{
+		if(pos >= outMax)
+		{
+			return 0;
+		}//End if
+		pOut[pos++] = 0x00;
+		pos = frameCodec_PutVarint(pOut, pos, outMax, zeroRun - 1);
+	}//End if
+
+	return pos;
+}//End frameCodec_EncodeDelta
+
+/*
+ * ***********************************************************************
+ * @brief       frameCodec_CompressLZ
+ * @param       pIn - Input data
+ * 				len - Input size, at most FRAME_CODEC_LZ_MAX_INPUT
+ * 				pOut - Output buffer
+ * 				outMax - Size of the output buffer
+ * @return      Compressed size, 0 if it does not fit in outMax
+ * @details     Greedy single pass LZ77 with a hash table of 4 byte
+ * 				sequences. Not reentrant, the match table is shared.
+ **************************************************************************/
+size_t frameCodec_CompressLZ(const uint8_t* pIn, const size_t len, uint8_t* pOut, const size_t outMax)
+{
+	if(len > FRAME_CODEC_LZ_MAX_INPUT)
+	{
+		return 0;
+	}//End if
+
+	memset(mLzTable, 0, sizeof(mLzTable));
+
+	size_t pos = 0;
+	size_t in = 0;
+	size_t anchor = 0;
+
+	while(in + FRAME_CODEC_LZ_MIN_MATCH <= len)
+	{
+		uint32_t seq;
+		memcpy(&seq, &pIn[in], sizeof(seq));
+		const uint32_t hash = (seq * 2654435761u) >> (32 - FRAME_CODEC_LZ_HASH_BITS);
+		const size_t candidate = mLzTable[hash];
+		mLzTable[hash] = (uint16_t)(in + 1);
+
+		uint32_t candSeq = ~seq;
+		if(candidate != 0 && candidate - 1 < in)								//The table is shared by the stream tasks, stale entries may point ahead
+		{
+			memcpy(&candSeq, &pIn[candidate - 1], sizeof(candSeq));
+		}//End if
+
+		if(candSeq != seq)
+		{
+			++in;
+			continue;
+		}//End if
+
+		const size_t ref = candidate - 1;
+		size_t matchLen = FRAME_CODEC_LZ_MIN_MATCH;
+		while(in + matchLen < len && pIn[ref + matchLen] == pIn[in + matchLen])
+		{
+			++matchLen;
+		}//End while
+
+		pos = frameCodec_PutSequence(pOut, pos, outMax, &pIn[anchor], in - anchor, in - ref, matchLen);
+		if(pos == 0)
+		{
+			return 0;
+		}//End if
+
+		in += matchLen;
+		anchor = in;
+	}//End while
+
+	return frameCodec_PutSequence(pOut, pos, outMax, &pIn[anchor], len - anchor, 0, 0);	//Trailing literals
+}//End frameCodec_CompressLZ
+
+/*
+ * ***********************************************************************
+ * @brief       frameCodec_PoolMax
+ * @param       pImage - First pixel of the image
+ * 				stride - Pixels per image row
+ * 				x, y, width, height - Window to pool, inside the image
+ * 				factor - Block size, 1 copies the window
+ * 				pOut - Output, ceil(width / factor) x ceil(height / factor) pixels
+ * @return      Number of output pixels
+ * @details     Every output pixel is the maximum of a factor x factor block,
+ * 				so a hot spot smaller than a block is not averaged away.
+ * 				Blocks of the last row and column are clipped to the window.
+ **************************************************************************/
+size_t frameCodec_PoolMax(const uint16_t* pImage, const size_t stride, const uint8_t x, const uint8_t y, const uint8_t width, const uint8_t height, const uint8_t factor, uint16_t* pOut)
+{
+	size_t pos = 0;
+
+	for(uint8_t by = 0; by < height; by += factor)
+	{
+		const uint8_t rows = (height - by < factor) ? (height - by) : factor;
+		for(uint8_t bx = 0; bx < width; bx += factor)
+		{
+			const uint8_t cols = (width - bx < factor) ? (width - bx) : factor;
+			const uint16_t* pBlock = &pImage[(size_t)(y + by) * stride + x + bx];
+			uint16_t max = 0;
+
+			for(uint8_t r = 0; r < rows; r++)
+			{
+				for(uint8_t c = 0; c < cols; c++)
+				{
+					if(pBlock[c] > max)
+					{
+						max = pBlock[c];
+					}//End if
+				}//End for
+				pBlock += stride;
+			}//End for
+			pOut[pos++] = max;
+		}//End for
+	}//End for
+
+	return pos;
+}//End frameCodec_PoolMax
+
+/*
+ * ***********************************************************************
+ * @brief       frameCodec_PackBits
+ * @param       pPixels - Pixels to pack
+ * 				pixels - Number of pixels
+ * 				bits - 8, 12 or 14 bits per pixel
+ * 				pOut - Output buffer
+ * 				outMax - Size of the output buffer
+ * @return      Packed size, 0 if it does not fit in outMax or bits is invalid
+ * @details     Output: minimum (16 bit little endian), shift, bits, then
+ * 				the values. A pixel is decoded as
+ * 				minimum + (value << shift), plus half a step if shift > 0.
+ **************************************************************************/
+size_t frameCodec_PackBits(const uint16_t* pPixels, const size_t pixels, const uint8_t bits, uint8_t* pOut, const size_t outMax)
+{
+	if((bits != 8 && bits != 12 && bits != 14) || pixels == 0)
+	{
+		return 0;
+	}//End if
+
+	const size_t len = FRAME_CODEC_PACK_HEADER_SIZE + (pixels * bits + 7) / 8;
+	if(len > outMax)
+	{
+		return 0;
+	}//End if
+
+	uint16_t min = 0xFFFF;
+	uint16_t max = 0;
+	for(size_t i = 0; i < pixels; i++)
+	{
+		min = (pPixels[i] < min) ? pPixels[i] : min;						//MINU / MAXU
+		max = (pPixels[i] > max) ? pPixels[i] : max;
+	}//End for
+
+	uint8_t shift = 0;
+	while(((uint32_t)(max - min) >> shift) >= (1UL << bits))
+	{
+		++shift;
+	}//End while
+
+	pOut[0] = (uint8_t)min;
+	pOut[1] = (uint8_t)(min >> 8);
+	pOut[2] = shift;
+	pOut[3] = bits;
+
+	//No lane borrows, every pixel is at least min
+	const uint32_t base = (uint32_t)min * 0x00010001UL;
+	const uint32_t mask = (uint32_t)(0xFFFFU >> shift) * 0x00010001UL;
+	uint8_t* p = &pOut[FRAME_CODEC_PACK_HEADER_SIZE];
+	size_t i = 0;
+
+	if(bits == 8)
+	{
+		for(; i + 4 <= pixels; i += 4)
+		{
+			const uint32_t w0 = ((PACK_PAIR(pPixels, i) - base) >> shift) & mask;
+			const uint32_t w1 = ((PACK_PAIR(pPixels, i + 2) - base) >> shift) & mask;
+			p[0] = (uint8_t)w0;
+			p[1] = (uint8_t)(w0 >> 16);
+			p[2] = (uint8_t)w1;
+			p[3] = (uint8_t)(w1 >> 16);
+			p += 4;
+		}//End for
+	}
+	else if(bits == 12)
+	{
+		for(; i + 2 <= pixels; i += 2)
+		{
+			const uint32_t w = ((PACK_PAIR(pPixels, i) - base) >> shift) & mask;
+			const uint32_t v = (w & 0x000FFFUL) | ((w >> 4) & 0xFFF000UL);	//Two 12 bit values in 24 bits
+			p[0] = (uint8_t)v;
+			p[1] = (uint8_t)(v >> 8);
+			p[2] = (uint8_t)(v >> 16);
+			p += 3;
+		}//End for
+	}
+	else
+	{
+		for(; i + 4 <= pixels; i += 4)
+		{
+			const uint32_t w0 = ((PACK_PAIR(pPixels, i) - base) >> shift) & mask;
+			const uint32_t w1 = ((PACK_PAIR(pPixels, i + 2) - base) >> shift) & mask;
+			const uint32_t lo = (w0 & 0x3FFFUL) | ((w0 >> 2) & 0x0FFFC000UL);	//Four 14 bit values in 56 bits
+			const uint32_t hi = (w1 & 0x3FFFUL) | ((w1 >> 2) & 0x0FFFC000UL);
+			p[0] = (uint8_t)lo;
+			p[1] = (uint8_t)(lo >> 8);
+			p[2] = (uint8_t)(lo >> 16);
+			p[3] = (uint8_t)((lo >> 24) | (hi << 4));
+			p[4] = (uint8_t)(hi >> 4);
+			p[5] = (uint8_t)(hi >> 12);
+			p[6] = (uint8_t)(hi >> 20);
+			p += 7;
+		}//End for
+	}//End if-else
+
+	//Pixels left over by the groups, from a byte boundary
+	uint32_t acc = 0;
+	uint8_t accBits = 0;
+	for(; i < pixels; i++)
+	{
+		acc |= (uint32_t)((uint16_t)(pPixels[i] - min) >> shift) << accBits;
+		accBits += bits;
+		while(accBits >= 8)
+		{
+			*p++ = (uint8_t)acc;
+			acc >>= 8;
+			accBits -= 8;
+		}//End while
+	}//End for
+	if(accBits > 0)
+	{
+		*p++ = (uint8_t)acc;
+	}//End if
+
+	return len;
+}//End frameCodec_PackBits
+
+/*
+ * ***********************************************************************
+ * @brief       frameCodec_PutVarint
+ * @param       pOut - Output buffer
+ * 				pos - Write position
+ * 				outMax - Size of the output buffer
+ * 				value - Value to write
+ * @return      New write position, 0 on overflow
+ * @details     LEB128: 7 bits per byte, low bits first
+ **************************************************************************/
+static size_t frameCodec_PutVarint(uint8_t* pOut, size_t pos, const size_t outMax, uint32_t value)
+{
+	while(value >= 0x80)
+	{
+		if(pos >= outMax)
+		{
+			return 0;
+		}//End if
+		pOut[pos++] = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}//End while
+
+	if(pos >= outMax)
+	{
+		return 0;
+	}//End if
+	pOut[pos++] = (uint8_t)value;
+	return pos;
+}//End frameCodec_PutVarint
+
+/*
+ * ***********************************************************************
+ * @brief       frameCodec_PutLength
+ * @param       pOut - Output buffer
+ * 				pos - Write position
+ * 				outMax - Size of the output buffer
+ * 				len - Length beyond the 15 held in the token
+ * @return      New write position, 0 on overflow
+ * @details     Extra length bytes of an LZ token: 255 means more follow
+ **************************************************************************/
+static size_t frameCodec_PutLength(uint8_t* pOut, size_t pos, const size_t outMax, size_t len)
+{
+	do
+	{
+		if(pos >= outMax)
+		{
+			return 0;
+		}//End if
+		const uint8_t part = (len >= 255) ? 255 : (uint8_t)len;
+		pOut[pos++] = part;
+		len -= part;
+		if(part < 255)
+		{
+			break;
+		}//End if
+	}while(1);
+
+	return pos;
+}//End frameCodec_PutLength
+
+/*
+ * ***********************************************************************
+ * @brief       frameCodec_PutSequence
+ * @param       pOut - Output buffer
+ * 				pos - Write position
+ * 				outMax - Size of the output buffer
+ * 				pLit - Literals
+ * 				litLen - Number of literals
+ * 				offset - Match distance
+ * 				matchLen - Match length, 0 for the trailing literals
+ * @return      New write position, 0 on overflow
+ * @details     None
+ **************************************************************************/
+static size_t frameCodec_PutSequence(uint8_t* pOut, size_t pos, const size_t outMax, const uint8_t* pLit, const size_t litLen, const size_t offset, const size_t matchLen)
+{
+	const size_t matchCode = (matchLen > 0) ? (matchLen - FRAME_CODEC_LZ_MIN_MATCH) : 0;
+
+	if(pos >= outMax)
+	{
+		return 0;
+	}//End if
+	pOut[pos++] = (uint8_t)(((litLen >= 15) ? 15 : litLen) << 4 | ((matchCode >= 15) ? 15 : matchCode));
+
+	if(litLen >= 15 && (pos = frameCodec_PutLength(pOut, pos, outMax, litLen - 15)) == 0)
+	{
+		return 0;
+	}//End if
+
+	if(pos + litLen > outMax)
+	{
+		return 0;
+	}//End if
+	memcpy(&pOut[pos], pLit, litLen);
+	pos += litLen;
+
+	if(matchLen == 0)
+	{
+		return pos;
+	}//End if
+
+	if(pos + 2 > outMax)
+	{
+		return 0;
+	}//End if
+	pOut[pos++] = (uint8_t)(offset & 0xFF);
+	pOut[pos++] = (uint8_t)(offset >> 8);
+
+	if(matchCode >= 15 && (pos = frameCodec_PutLength(pOut, pos, outMax, matchCode - 15)) == 0)
+	{
+		return 0;
+	}//End if
+
+	return pos;
+}//End frameCodec_PutSequence
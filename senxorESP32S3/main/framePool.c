@@ -0,0 +1,666 @@
+/*****************************************************************************
+ * @file     framePool.c
+ * @version  1.10
+ * @brief    Reference counted pool of thermal frames and publish / subscribe
+ * 			 frame bus between senxorTask and the frame consumers.
+ * @date	 14 Oct 2026
+ * @details	 senxorTask is the only producer. Every subscriber registers its
+ * 			 own mailbox: a single-producer / single-consumer ring of slot
+ * 			 indices with a depth and a backpressure policy. Publishing a frame
+ * 			 only pushes its index and takes a reference, so adding a
+ * 			 subscriber costs no copy of the frame.
+ *
+ * 			 The first MEM_FAST_FRAME_SLOTS slots live in internal RAM and the
+ * 			 rest in PSRAM. Alloc scans from slot 0, so while subscribers
+ * 			 keep up the frame being captured and sent never leaves internal
+ * 			 RAM, and only frames queued behind a slow subscriber spill to
+ * 			 PSRAM. Reference counts and ring indices stay in internal RAM
+ * 			 because atomic compare-and-set is not available on external
+ * 			 memory.
+ ******************************************************************************/
+#include <stdatomic.h>
+#include <string.h>
+#include <unistd.h>
+#include <esp_log.h>
+#include <esp_attr.h>
+
+#include "msg.h"
+#include "framePool.h"
+#include "memProfile.h"
+
+#define MAILBOX_EMPTY_SLOT	0xFF
+
+//Mailbox states
+#define MAILBOX_FREE		0
+#define MAILBOX_BUSY		1										//Being set up or torn down
+#define MAILBOX_ACTIVE		2
+
+typedef struct frameMailbox{
+	atomic_uint mHead;										//Next position to write. Written by producer only
+	atomic_uint mTail;										//Next position to read. Advanced by subscriber, or by producer on overflow
+	atomic_uchar mSlot[FRAME_BUS_MAX_DEPTH];				//Slot index stored at each position
+	atomic_uint mDropped;									//Frames dropped because the subscriber fell behind
+	atomic_uchar mState;									//MAILBOX_FREE / MAILBOX_BUSY / MAILBOX_ACTIVE
+	atomic_uint mPublishers;								//Publishes that found the mailbox active and are not done with it
+	uint8_t mDepth;											//Frames held before the policy applies
+	framePolicy_t mPolicy;									//Backpressure policy
+	TaskHandle_t mTask;										//Task to notify when a frame is pushed
+	int mWakeFd;											//eventfd written when a frame is pushed, -1 if none
+	const char* mName;										//Subscriber name for logging
+}frameMailbox_t;
+
+//private:
+#if MEM_FAST_FRAME_SLOTS
+static senxorFrame mFastSlot[MEM_FAST_FRAME_SLOTS];				//Slots 0 to MEM_FAST_FRAME_SLOTS - 1
+#endif
+EXT_RAM_BSS_ATTR static senxorFrame mBulkSlot[FRAME_POOL_SLOTS - MEM_FAST_FRAME_SLOTS];	//Remaining slots
+static atomic_uint mRefCnt[FRAME_POOL_SLOTS];						//References held on each slot
+static frameMailbox_t mMailbox[FRAME_BUS_MAX_SUBSCRIBERS];			//One mailbox per subscriber
+static atomic_uint mDroppedTotal;									//Drops of every mailbox, kept across subscribers
+static atomic_uint mNoSlotCnt;										//framePool_Alloc failures
+
+_Static_assert((FRAME_BUS_MAX_DEPTH & (FRAME_BUS_MAX_DEPTH - 1)) == 0, "FRAME_BUS_MAX_DEPTH must be a power of 2");
+_Static_assert(FRAME_POOL_SLOTS < MAILBOX_EMPTY_SLOT, "Too many frame slots");
+_Static_assert(MEM_FAST_FRAME_SLOTS < FRAME_POOL_SLOTS, "Too many internal frame slots");
+
+static senxorFrame* framePool_Frame(const uint8_t slot);
+static uint8_t framePool_Slot(const senxorFrame* frame);
+
+static void framePool_Retain(const uint8_t slot);
+static void framePool_ReleaseSlot(const uint8_t slot);
+static void framePool_MailboxPush(frameMailbox_t* box, const uint8_t slot);
+static uint8_t framePool_MailboxPop(frameMailbox_t* box);
+static void framePool_MailboxDrain(frameMailbox_t* box);
+static void framePool_Deliver(frameMailbox_t* box, const uint8_t slot);
+static void framePool_Wake(const frameMailbox_t* box);
+
+/*
+ * ***********************************************************************
+ * @brief       framePool_Init
+ * @param       None
+ * @return      None
+ * @details     Reset all slots and mailboxes. Call once before any task
+ * 				uses the bus.
+ **************************************************************************/
+void framePool_Init(void)
+{
+	ESP_LOGI(MTAG,MAIN_INIT_QUEUE);
+
+	for(uint8_t i = 0; i < FRAME_POOL_SLOTS; i++)
+	{
+		atomic_init(&mRefCnt[i], 0);
+	}//End for
+	atomic_init(&mDroppedTotal, 0);
+	atomic_init(&mNoSlotCnt, 0);
+
+	for(uint8_t i = 0; i < FRAME_BUS_MAX_SUBSCRIBERS; i++)
+	{
+		atomic_init(&mMailbox[i].mHead, 0);
+		atomic_init(&mMailbox[i].mTail, 0);
+		atomic_init(&mMailbox[i].mDropped, 0);
+		atomic_init(&mMailbox[i].mState, MAILBOX_FREE);
+		atomic_init(&mMailbox[i].mPublishers, 0);
+		mMailbox[i].mDepth = 0;
+		mMailbox[i].mPolicy = FRAME_POLICY_DROP_OLDEST;
+		mMailbox[i].mTask = NULL;
+		mMailbox[i].mWakeFd = -1;
+		mMailbox[i].mName = NULL;
+		for(uint8_t j = 0; j < FRAME_BUS_MAX_DEPTH; j++)
+		{
+			atomic_init(&mMailbox[i].mSlot[j], MAILBOX_EMPTY_SLOT);
+		}//End for
+	}//End for
+
+	ESP_LOGI(FPTAG,FP_INIT_INFO,FRAME_POOL_SLOTS,FRAME_BUS_MAX_SUBSCRIBERS);
+}//End framePool_Init
+
+/*
+ * ***********************************************************************
+ * @brief       framePool_Subscribe
+ * @param       name - Subscriber name, used for logging
+ * 				depth - Mailbox depth (1 to FRAME_BUS_MAX_DEPTH)
+ * 				policy - Backpressure policy, as defined in framePolicy_t
+ * 				task - Task to be notified when a new frame is available
+ * @return      Subscriber ID, FRAME_BUS_INVALID_ID if no mailbox is free
+ * @details     Start delivering frames to a subscriber. FRAME_POLICY_LATEST_ONLY
+ * 				always uses a depth of 1.
+ **************************************************************************/
+frameSubscriber_t framePool_Subscribe(const char* name, const uint8_t depth, const framePolicy_t policy, TaskHandle_t task)
+{
+	for(uint8_t i = 0; i < FRAME_BUS_MAX_SUBSCRIBERS; i++)
+	{
+		unsigned char expected = MAILBOX_FREE;
+		if(!atomic_compare_exchange_strong(&mMailbox[i].mState, &expected, MAILBOX_BUSY))
+		{
+			continue;
+		}//End if
+
+		frameMailbox_t* box = &mMailbox[i];
+		framePool_MailboxDrain(box);											//Release frames left by a previous subscriber
+		atomic_store(&box->mDropped, 0);
+
+		box->mPolicy = policy;
+		box->mDepth = (policy == FRAME_POLICY_LATEST_ONLY) ? 1 : depth;
+		if(box->mDepth == 0)
+		{
+			box->mDepth = 1;
+		}
+		else if(box->mDepth > FRAME_BUS_MAX_DEPTH)
+		{
+			box->mDepth = FRAME_BUS_MAX_DEPTH;
+		}//End if-else
+		box->mTask = task;
+		box->mWakeFd = -1;
+		box->mName = name;
+
+		atomic_store_explicit(&box->mState, MAILBOX_ACTIVE, memory_order_release);
+		ESP_LOGI(FPTAG,FP_SUB_INFO,i,name,box->mDepth,policy);
+		return (frameSubscriber_t)i;
+	}//End for
+
+	ESP_LOGE(FPTAG,FP_ERR_SUB_FULL,name);
+	return FRAME_BUS_INVALID_ID;
+}//End framePool_Subscribe
+
+/*
+ * ***********************************************************************
+ * @brief       framePool_Unsubscribe
+ * @param       sub - Subscriber ID
+ * @return      None
+ * @details     Stop delivering frames to a subscriber and return the frames
+ * 				still queued for it to the pool. Must be called from the
+ * 				subscriber task. Once it returns no frame is pushed to the
+ * 				mailbox and its task and eventfd are no longer used, so the
+ * 				task may be deleted and the eventfd closed.
+ **************************************************************************/
+void framePool_Unsubscribe(const frameSubscriber_t sub)
+{
+	if(sub < 0 || sub >= FRAME_BUS_MAX_SUBSCRIBERS)
+	{
+		return;
+	}//End if
+
+	frameMailbox_t* box = &mMailbox[sub];
+	unsigned char expected = MAILBOX_ACTIVE;
+	if(!atomic_compare_exchange_strong(&box->mState, &expected, MAILBOX_BUSY))
+	{
+		return;
+	}//End if
+
+	/*
+	 * A publish that saw the mailbox as active before the state changed may
+	 * still push a frame and wake the subscriber. Wait for it, every later
+	 * publish sees the mailbox busy. A blocking push gives up as soon as the
+	 * mailbox is no longer active.
+	 */
+	while(atomic_load(&box->mPublishers) != 0)
+	{
+		vTaskDelay(1);
+	}//End while
+
+	framePool_MailboxDrain(box);
+	box->mTask = NULL;
+	box->mWakeFd = -1;
+	ESP_LOGI(FPTAG,FP_UNSUB_INFO,sub,box->mName,(unsigned int)atomic_load(&box->mDropped));
+	atomic_store_explicit(&box->mState, MAILBOX_FREE, memory_order_release);
+}//End framePool_Unsubscribe
+
+/*
+ * ***********************************************************************
+ * @brief       framePool_Alloc
+ * @param       None
+ * @return      Pointer to a free frame, NULL if none is free
+ * @details     Producer side. The returned frame is owned by the caller
+ * 				until it is passed to framePool_Publish().
+ **************************************************************************/
+senxorFrame* framePool_Alloc(void)
+{
+	for(uint8_t i = 0; i < FRAME_POOL_SLOTS; i++)
+	{
+		unsigned int expected = 0;
+		if(atomic_compare_exchange_strong_explicit(&mRefCnt[i], &expected, 1, memory_order_acquire, memory_order_relaxed))
+		{
+			return framePool_Frame(i);
+		}//End if
+	}//End for
+
+	atomic_fetch_add_explicit(&mNoSlotCnt, 1, memory_order_relaxed);
+	ESP_LOGW(FPTAG,FP_WARN_NO_SLOT);
+	return NULL;
+}//End framePool_Alloc
+
+/*
+ * ***********************************************************************
+ * @brief       framePool_Publish
+ * @param       frame - Frame obtained from framePool_Alloc()
+ * @return      None
+ * @details     Producer side. Push the frame to every subscriber and give up
+ * 				the producer's reference. Only FRAME_POLICY_BLOCK mailboxes
+ * 				can make this wait, and never longer than FRAME_BUS_BLOCK_MAX_MS.
+ **************************************************************************/
+void framePool_Publish(senxorFrame* frame)
+{
+	const uint8_t slot = framePool_Slot(frame);
+
+	for(uint8_t i = 0; i < FRAME_BUS_MAX_SUBSCRIBERS; i++)
+	{
+		framePool_Deliver(&mMailbox[i], slot);
+	}//End for
+
+	framePool_ReleaseSlot(slot);												//Drop producer reference
+}//End framePool_Publish
+
+/*
+ * ***********************************************************************
+ * @brief       framePool_PublishTo
+ * @param       frame - Frame obtained from framePool_Alloc()
+ * 				sub - Subscriber ID
+ * @return      None
+ * @details     Producer side. framePool_Publish() to one subscriber only,
+ * 				for frames the other consumers must not see. The frame
+ * 				goes back to the pool if the subscriber is not active.
+ **************************************************************************/
+void framePool_PublishTo(senxorFrame* frame, const frameSubscriber_t sub)
+{
+	const uint8_t slot = framePool_Slot(frame);
+
+	if(sub >= 0 && sub < FRAME_BUS_MAX_SUBSCRIBERS)
+	{
+		framePool_Deliver(&mMailbox[sub], slot);
+	}//End if
+
+	framePool_ReleaseSlot(slot);												//Drop producer reference
+}//End framePool_PublishTo
+
+/*
+ * ***********************************************************************
+ * @brief       framePool_SetWakeFd
+ * @param       sub - Subscriber ID
+ * 				fd - eventfd to write on every push, -1 for none
+ * @return      None
+ * @details     For a subscriber that waits in select() rather than on a
+ * 				task notification, so new frames and socket events wake up
+ * 				the same loop. Call from the subscriber right after
+ * 				framePool_Subscribe(), a frame pushed in between is picked
+ * 				up on the next wake.
+ **************************************************************************/
+void framePool_SetWakeFd(const frameSubscriber_t sub, const int fd)
+{
+	if(sub < 0 || sub >= FRAME_BUS_MAX_SUBSCRIBERS)
+	{
+		return;
+	}//End if
+	mMailbox[sub].mWakeFd = fd;
+}//End framePool_SetWakeFd
+
+/*
+ * ***********************************************************************
+ * @brief       framePool_Receive
+ * @param       sub - Subscriber ID
+ * 				timeout - Ticks to wait for a frame
+ * @return      Oldest frame in the mailbox, NULL on timeout
+ * @details     Subscriber side. The frame stays valid until it is returned
+ * 				with framePool_Release().
+ **************************************************************************/
+senxorFrame* framePool_Receive(const frameSubscriber_t sub, const TickType_t timeout)
+{
+	if(sub < 0 || sub >= FRAME_BUS_MAX_SUBSCRIBERS)
+	{
+		return NULL;
+	}//End if
+
+	senxorFrame* frame = framePool_TryReceive(sub);
+	if(frame == NULL)
+	{
+		ulTaskNotifyTake(pdTRUE, timeout);										//Wait for producer
+		frame = framePool_TryReceive(sub);
+	}//End if
+
+	return frame;
+}//End framePool_Receive
+
+/*
+ * ***********************************************************************
+ * @brief       framePool_TryReceive
+ * @param       sub - Subscriber ID
+ * @return      Oldest frame in the mailbox, NULL if empty
+ * @details     Subscriber side. Never waits and leaves the task notification
+ * 				untouched, for tasks that serve several mailboxes and wait
+ * 				on the notification themselves.
+ **************************************************************************/
+senxorFrame* framePool_TryReceive(const frameSubscriber_t sub)
+{
+	if(sub < 0 || sub >= FRAME_BUS_MAX_SUBSCRIBERS)
+	{
+		return NULL;
+	}//End if
+
+	const uint8_t slot = framePool_MailboxPop(&mMailbox[sub]);
+	return (slot == MAILBOX_EMPTY_SLOT) ? NULL : framePool_Frame(slot);
+}//End framePool_TryReceive
+
+/*
+ * ***********************************************************************
+ * @brief       framePool_Release
+ * @param       frame - Frame obtained from framePool_Receive()
+ * @return      None
+ * @details     Subscriber side. Return a frame to the pool.
+ **************************************************************************/
+void framePool_Release(senxorFrame* frame)
+{
+	if(frame == NULL)
+	{
+		return;
+	}//End if
+
+	framePool_ReleaseSlot(framePool_Slot(frame));
+}//End framePool_Release
+
+/*
+ * ***********************************************************************
+ * @brief       framePool_GetDropCount
+ * @param       sub - Subscriber ID
+ * @return      Number of frames dropped for this subscriber
+ * @details     Frames are dropped when the subscriber's mailbox is full.
+ **************************************************************************/
+uint32_t framePool_GetDropCount(const frameSubscriber_t sub)
+{
+	if(sub < 0 || sub >= FRAME_BUS_MAX_SUBSCRIBERS)
+	{
+		return 0;
+	}//End if
+
+	return atomic_load_explicit(&mMailbox[sub].mDropped, memory_order_relaxed);
+}//End framePool_GetDropCount
+
+/*
+ * ***********************************************************************
+ * @brief       framePool_GetSubscriberCount
+ * @param       None
+ * @return      Number of active subscribers
+ * @details     None
+ **************************************************************************/
+uint8_t framePool_GetSubscriberCount(void)
+{
+	uint8_t count = 0;
+	for(uint8_t i = 0; i < FRAME_BUS_MAX_SUBSCRIBERS; i++)
+	{
+		if(atomic_load_explicit(&mMailbox[i].mState, memory_order_relaxed) == MAILBOX_ACTIVE)
+		{
+			++count;
+		}//End if
+	}//End for
+	return count;
+}//End framePool_GetSubscriberCount
+
+/*
+ * ***********************************************************************
+ * @brief       framePool_GetBusStats
+ * @param       pStats - Filled with the bus counters
+ * @return      None
+ * @details     Lock free, the counters are read one at a time, so they
+ * 				may be a frame apart
+ **************************************************************************/
+void framePool_GetBusStats(frameBusStats_t* pStats)
+{
+	pStats->mDropped = atomic_load_explicit(&mDroppedTotal, memory_order_relaxed);
+	pStats->mNoSlot = atomic_load_explicit(&mNoSlotCnt, memory_order_relaxed);
+	pStats->mSubscribers = 0;
+	pStats->mDeepest = 0;
+	pStats->mSlotsUsed = 0;
+
+	for(uint8_t i = 0; i < FRAME_BUS_MAX_SUBSCRIBERS; i++)
+	{
+		uint8_t queued;
+		if(framePool_GetMailboxStats(i, NULL, &queued, NULL, NULL))
+		{
+			++pStats->mSubscribers;
+			pStats->mDeepest = (queued > pStats->mDeepest) ? queued : pStats->mDeepest;
+		}//End if
+	}//End for
+
+	for(uint8_t i = 0; i < FRAME_POOL_SLOTS; i++)
+	{
+		if(atomic_load_explicit(&mRefCnt[i], memory_order_relaxed) != 0)
+		{
+			++pStats->mSlotsUsed;
+		}//End if
+	}//End for
+}//End framePool_GetBusStats
+
+/*
+ * ***********************************************************************
+ * @brief       framePool_GetMailboxStats
+ * @param       sub - Subscriber ID
+ * 				pName, pQueued, pDepth, pDropped - Filled if not NULL
+ * @return      true if the mailbox has an active subscriber
+ * @details     pQueued is the number of frames waiting to be received
+ **************************************************************************/
+bool framePool_GetMailboxStats(const frameSubscriber_t sub, const char** pName, uint8_t* pQueued, uint8_t* pDepth, uint32_t* pDropped)
+{
+	if(sub < 0 || sub >= FRAME_BUS_MAX_SUBSCRIBERS)
+	{
+		return false;
+	}//End if
+
+	frameMailbox_t* box = &mMailbox[sub];
+	if(atomic_load_explicit(&box->mState, memory_order_acquire) != MAILBOX_ACTIVE)
+	{
+		return false;
+	}//End if
+
+	if(pName != NULL)
+	{
+		*pName = box->mName;
+	}//End if
+	if(pQueued != NULL)
+	{
+		const unsigned int tail = atomic_load_explicit(&box->mTail, memory_order_acquire);
+		const unsigned int head = atomic_load_explicit(&box->mHead, memory_order_acquire);
+		*pQueued = (uint8_t)(head - tail);
+	}//End if
+	if(pDepth != NULL)
+	{
+		*pDepth = box->mDepth;
+	}//End if
+	if(pDropped != NULL)
+	{
+		*pDropped = atomic_load_explicit(&box->mDropped, memory_order_relaxed);
+	}//End if
+	return true;
+}//End framePool_GetMailboxStats
+
+/*
+ * ***********************************************************************
+ * @brief       framePool_Frame
+ * @param       slot - Slot index
+ * @return      Frame stored in the slot
+ **************************************************************************/
+static senxorFrame* framePool_Frame(const uint8_t slot)
+{
+#if MEM_FAST_FRAME_SLOTS
+	if(slot < MEM_FAST_FRAME_SLOTS)
+	{
+		return &mFastSlot[slot];
+	}//End if
+#endif
+	return &mBulkSlot[slot - MEM_FAST_FRAME_SLOTS];
+}//End framePool_Frame
+
+/*
+ * ***********************************************************************
+ * @brief       framePool_Slot
+ * @param       frame - Frame owned by the pool
+ * @return      Slot index of the frame
+ **************************************************************************/
+static uint8_t framePool_Slot(const senxorFrame* frame)
+{
+#if MEM_FAST_FRAME_SLOTS
+	if(frame >= mFastSlot && frame < mFastSlot + MEM_FAST_FRAME_SLOTS)
+	{
+		return (uint8_t)(frame - mFastSlot);
+	}//End if
+#endif
+	return (uint8_t)(MEM_FAST_FRAME_SLOTS + (frame - mBulkSlot));
+}//End framePool_Slot
+
+/*
+ * ***********************************************************************
+ * @brief       framePool_Retain
+ * @param       slot - Slot index
+ * @return      None
+ * @details     Add a reference to a slot
+ **************************************************************************/
+static void framePool_Retain(const uint8_t slot)
+{
+	atomic_fetch_add_explicit(&mRefCnt[slot], 1, memory_order_relaxed);
+}//End framePool_Retain
+
+/*
+ * ***********************************************************************
+ * @brief       framePool_ReleaseSlot
+ * @param       slot - Slot index
+ * @return      None
+ * @details     Drop a reference to a slot. The slot becomes free once the
+ * 				count reaches zero.
+ **************************************************************************/
+static void framePool_ReleaseSlot(const uint8_t slot)
+{
+	if(slot >= FRAME_POOL_SLOTS)
+	{
+		return;
+	}//End if
+
+	atomic_fetch_sub_explicit(&mRefCnt[slot], 1, memory_order_release);
+}//End framePool_ReleaseSlot
+
+/*
+ * ***********************************************************************
+ * @brief       framePool_MailboxPush
+ * @param       box - Subscriber mailbox
+ * 				slot - Slot index to push
+ * @return      None
+ * @details     Producer side. If the mailbox is full the oldest entry is
+ * 				claimed by advancing the tail, the same way the subscriber
+ * 				pops, so exactly one side owns each entry.
+ **************************************************************************/
+static void framePool_MailboxPush(frameMailbox_t* box, const uint8_t slot)
+{
+	const unsigned int head = atomic_load_explicit(&box->mHead, memory_order_relaxed);
+	unsigned int tail = atomic_load_explicit(&box->mTail, memory_order_acquire);
+
+	if(box->mPolicy == FRAME_POLICY_BLOCK)
+	{
+		TickType_t waited = 0;
+		while((head - tail) >= box->mDepth && waited < pdMS_TO_TICKS(FRAME_BUS_BLOCK_MAX_MS)
+				&& atomic_load_explicit(&box->mState, memory_order_relaxed) == MAILBOX_ACTIVE)
+		{
+			vTaskDelay(1);														//Give the subscriber time to catch up
+			++waited;
+			tail = atomic_load_explicit(&box->mTail, memory_order_acquire);
+		}//End while
+	}//End if
+
+	while((head - tail) >= box->mDepth)
+	{
+		const uint8_t oldest = atomic_load_explicit(&box->mSlot[tail & (FRAME_BUS_MAX_DEPTH - 1)], memory_order_relaxed);
+		if(atomic_compare_exchange_weak_explicit(&box->mTail, &tail, tail + 1, memory_order_acq_rel, memory_order_acquire))
+		{
+			framePool_ReleaseSlot(oldest);										//Drop oldest frame
+			atomic_fetch_add_explicit(&box->mDropped, 1, memory_order_relaxed);
+			atomic_fetch_add_explicit(&mDroppedTotal, 1, memory_order_relaxed);
+		}//End if
+		//tail is reloaded by the exchange, check again
+	}//End while
+
+	atomic_store_explicit(&box->mSlot[head & (FRAME_BUS_MAX_DEPTH - 1)], slot, memory_order_relaxed);
+	atomic_store_explicit(&box->mHead, head + 1, memory_order_release);		//Publish entry
+}//End framePool_MailboxPush
+
+/*
+ * ***********************************************************************
+ * @brief       framePool_MailboxPop
+ * @param       box - Subscriber mailbox
+ * @return      Slot index, MAILBOX_EMPTY_SLOT if the mailbox is empty
+ * @details     Subscriber side. The entry is read before the tail is moved,
+ * 				if the producer dropped it in between the exchange fails and
+ * 				the next entry is tried.
+ **************************************************************************/
+static uint8_t framePool_MailboxPop(frameMailbox_t* box)
+{
+	unsigned int tail = atomic_load_explicit(&box->mTail, memory_order_acquire);
+
+	for(;;)
+	{
+		const unsigned int head = atomic_load_explicit(&box->mHead, memory_order_acquire);
+		if(tail == head)
+		{
+			return MAILBOX_EMPTY_SLOT;
+		}//End if
+
+		const uint8_t slot = atomic_load_explicit(&box->mSlot[tail & (FRAME_BUS_MAX_DEPTH - 1)], memory_order_relaxed);
+		if(atomic_compare_exchange_weak_explicit(&box->mTail, &tail, tail + 1, memory_order_acq_rel, memory_order_acquire))
+		{
+			return slot;
+		}//End if
+	}//End for
+}//End framePool_MailboxPop
+
+/*
+ * ***********************************************************************
+ * @brief       framePool_MailboxDrain
+ * @param       box - Subscriber mailbox
+ * @return      None
+ * @details     Release every frame still queued in a mailbox
+ **************************************************************************/
+static void framePool_MailboxDrain(frameMailbox_t* box)
+{
+	uint8_t slot;
+	while((slot = framePool_MailboxPop(box)) != MAILBOX_EMPTY_SLOT)
+	{
+		framePool_ReleaseSlot(slot);
+	}//End while
+}//End framePool_MailboxDrain
+
+/*
+ * ***********************************************************************
+ * @brief       framePool_Deliver
+ * @param       box - Subscriber mailbox
+ * 				slot - Slot index to push
+ * @return      None
+ * @details     Producer side. Push the frame and wake the subscriber if
+ * 				the mailbox is active. The publish is counted before the
+ * 				state is read, so framePool_Unsubscribe either sees it and
+ * 				waits for it, or has already made the mailbox busy.
+ **************************************************************************/
+static void framePool_Deliver(frameMailbox_t* box, const uint8_t slot)
+{
+	atomic_fetch_add(&box->mPublishers, 1);
+	if(atomic_load(&box->mState) == MAILBOX_ACTIVE)
+	{
+		framePool_Retain(slot);													//Reference held by the mailbox
+		framePool_MailboxPush(box, slot);
+		framePool_Wake(box);													//Wake up subscriber
+	}//End if
+	atomic_fetch_sub_explicit(&box->mPublishers, 1, memory_order_release);
+}//End framePool_Deliver
+
+/*
+ * ***********************************************************************
+ * @brief       framePool_Wake
+ * @param       box - Mailbox a frame was just pushed to
+ * @return      None
+ * @details     Notify the subscriber task and, if set, signal its eventfd
+ **************************************************************************/
+static void framePool_Wake(const frameMailbox_t* box)
+{
+	if(box->mTask != NULL)
+	{
+		xTaskNotifyGive(box->mTask);
+	}//End if
+	if(box->mWakeFd >= 0)
+	{
+		const uint64_t one = 1;
+		write(box->mWakeFd, &one, sizeof(one));
+	}//End if
+}//End framePool_Wake
@@ -0,0 +1,583 @@
+/*****************************************************************************
+ * @file     frameRecorder.c
+ * @version  1.01
+ * @brief    Pre-trigger frame recorder on a PSRAM ring buffer.
+ * @date	 14 Oct 2026
+ * @details	 The recorder is a frame bus subscriber that keeps capture
+ * 			 running while it is armed. Every frame is coded like the TCP v2
+ * 			 stream (frameCodec.c), delta frames against the previous record
+ * 			 and a keyframe every REC_KEYFRAME_INTERVAL records, and appended
+ * 			 to a byte ring in PSRAM. The oldest records are dropped to make
+ * 			 room, so the ring always holds the most recent frames.
+ *
+ * 			 A trigger (RECC command, BLE stream control write or an ROI
+ * 			 maximum above its threshold) records REC_POST_TRIGGER_MS more,
+ * 			 then freezes the ring. The clip starts at the last keyframe at
+ * 			 least REC_PRE_TRIGGER_MS before the trigger, or at the oldest
+ * 			 keyframe if the ring does not reach that far back. The frozen
+ * 			 clip is read with frameRecorderGetClipSpan, straight from the
+ * 			 ring, by the RECD command on the command port or USB.
+ *
+ * 			 Only frameRecorderTask writes the ring and changes the state,
+ * 			 other tasks post requests and wake it.
+ ******************************************************************************/
+#include <string.h>
+#include <sys/param.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <sdkconfig.h>
+
+#include "SenXorLib.h"
+#include "DrvNVS.h"
+#include "frameRecorder.h"
+#include "frameCodec.h"
+#include "roiEngine.h"
+#include "tcpServerTask.h"
+
+#if CONFIG_MI_REC_EN
+
+//private:
+EXT_RAM_BSS_ATTR static uint8_t mRing[REC_BUFFER_SIZE];				//Records, oldest at mTail
+EXT_RAM_BSS_ATTR static uint16_t mRefFrame[REC_FRAME_PIXELS];		//Last recorded frame, base of the delta records
+EXT_RAM_BSS_ATTR static uint8_t mDeltaBuff[REC_FRAME_PIXELS * 2];
+EXT_RAM_BSS_ATTR static uint8_t mEncBuff[REC_FRAME_PIXELS * 2];
+static uint32_t mHead = 0;											//Write position
+static uint32_t mTail = 0;											//Oldest record
+static uint32_t mUsed = 0;											//Bytes between mTail and mHead
+static uint32_t mRecords = 0;
+static bool mRefValid = false;
+static uint16_t mFramesSinceKey = 0;
+
+static volatile uint8_t mState = REC_STATE_RECORDING;
+static volatile uint8_t mTriggerReq = REC_TRIGGER_NONE;				//Posted by frameRecorderTrigger
+static volatile bool mArmReq = false;								//Posted by frameRecorderArm
+static volatile uint8_t mDownloads = 0;								//Downloads reading the clip, guarded by mLock
+static uint8_t mTrigger = REC_TRIGGER_NONE;
+static bool mTriggerPending = false;								//Next record gets REC_FLAG_TRIGGER
+static int64_t mTriggerUs = 0;
+static int64_t mFrozenUs = 0;
+static recRoiTrigger_t mRoiTrigger = { .mRoi = REC_ROI_NONE };
+
+// Frozen clip
+static recClipHeader_t mClipHeader;
+static uint32_t mClipStart = 0;										//Ring position of the first record
+static uint32_t mClipLen = 0;										//Header and records, 0 until frozen
+
+static TaskHandle_t mTaskHandle = NULL;
+static portMUX_TYPE mLock = portMUX_INITIALIZER_UNLOCKED;
+
+static const char* mTriggerName[REC_TRIGGER_COUNT] = { "none", "command", "BLE", "ROI" };
+
+static void frameRecorder_Append(const senxorFrame* pFrame);
+static void frameRecorder_CheckRoi(void);
+static void frameRecorder_Update(void);
+static void frameRecorder_Freeze(void);
+static void frameRecorder_SetCapture(const bool on);
+static void frameRecorder_DropOldest(void);
+static void frameRecorder_RingWrite(const uint32_t pos, const void* pData, const uint32_t len);
+static void frameRecorder_RingRead(const uint32_t pos, void* pData, const uint32_t len);
+
+/*
+ * ***********************************************************************
+ * @brief       frameRecorderTask
+ * @param       pvParameters - Not used
+ * @return      None
+ * @details     Start capture and record every published frame until a
+ * 				trigger freezes the clip
+ **************************************************************************/
+void frameRecorderTask(void *pvParameters)
+{
+	mTaskHandle = xTaskGetCurrentTaskHandle();
+	if(!NVS_ReadBlob(REC_NVS_KEY, &mRoiTrigger, sizeof(mRoiTrigger)) || (mRoiTrigger.mRoi != REC_ROI_NONE && mRoiTrigger.mRoi >= ROI_MAX_COUNT))
+	{
+		mRoiTrigger.mRoi = REC_ROI_NONE;
+	}//End if
+
+	const frameSubscriber_t frameSub = framePool_Subscribe("rec", 2, FRAME_POLICY_DROP_OLDEST, mTaskHandle);
+	if(frameSub == FRAME_BUS_INVALID_ID)
+	{
+		ESP_LOGE(RECTAG, REC_ERR_SUB);
+		mState = REC_STATE_FROZEN;											//Not a capture client
+		vTaskDelete(NULL);
+	}//End if
+
+	ESP_LOGI(RECTAG, REC_INFO_START, CONFIG_MI_REC_BUFFER_KB, CONFIG_MI_REC_PRE_TRIGGER_S, CONFIG_MI_REC_POST_TRIGGER_S);
+	frameRecorder_SetCapture(true);
+
+	for(;;)
+	{
+		senxorFrame* pFrame = framePool_Receive(frameSub, pdMS_TO_TICKS(REC_WAIT_MS));	//Woken by a frame or a request
+		if(pFrame != NULL)
+		{
+			if(mState != REC_STATE_FROZEN)
+			{
+				frameRecorder_Append(pFrame);
+				frameRecorder_CheckRoi();
+			}//End if
+			framePool_Release(pFrame);
+		}//End if
+		frameRecorder_Update();
+	}//End for
+}//End frameRecorderTask
+
+/*
+ * ***********************************************************************
+ * @brief       frameRecorderGetIsRecording
+ * @param       None
+ * @return      true while the recorder needs frames
+ * @details     None
+ **************************************************************************/
+bool frameRecorderGetIsRecording(void)
+{
+	return mState != REC_STATE_FROZEN;
+}//End frameRecorderGetIsRecording
+
+/*
+ * ***********************************************************************
+ * @brief       frameRecorderTrigger
+ * @param       source - recTrigger_t
+ * @return      None
+ * @details     Ignored unless the recorder is armed and not triggered yet
+ **************************************************************************/
+void frameRecorderTrigger(const uint8_t source)
+{
+	if(source == REC_TRIGGER_NONE || source >= REC_TRIGGER_COUNT)
+	{
+		return;
+	}//End if
+
+	mTriggerReq = source;
+	if(mTaskHandle != NULL)
+	{
+		xTaskNotifyGive(mTaskHandle);
+	}//End if
+}//End frameRecorderTrigger
+
+/*
+ * ***********************************************************************
+ * @brief       frameRecorderArm
+ * @param       None
+ * @return      None
+ * @details     Drop the clip, or a trigger in progress, and record again.
+ * 				Waits for running downloads to end.
+ **************************************************************************/
+void frameRecorderArm(void)
+{
+	mArmReq = true;
+	if(mTaskHandle != NULL)
+	{
+		xTaskNotifyGive(mTaskHandle);
+	}//End if
+}//End frameRecorderArm
+
+/*
+ * ***********************************************************************
+ * @brief       frameRecorderSetRoiTrigger
+ * @param       idx - ROI slot, REC_ROI_NONE to disable the trigger
+ * 				threshold - ROI maximum that fires the trigger
+ * @return      false if idx is not a ROI slot
+ * @details     Saved to NVS
+ **************************************************************************/
+bool frameRecorderSetRoiTrigger(const uint8_t idx, const uint16_t threshold)
+{
+	if(idx != REC_ROI_NONE && idx >= ROI_MAX_COUNT)
+	{
+		return false;
+	}//End if
+
+	const recRoiTrigger_t roiTrigger = { .mRoi = idx, .mReserved = 0, .mThreshold = threshold };
+	taskENTER_CRITICAL(&mLock);
+	mRoiTrigger = roiTrigger;
+	taskEXIT_CRITICAL(&mLock);
+
+	NVS_WriteBlob(REC_NVS_KEY, &roiTrigger, sizeof(roiTrigger));
+	ESP_LOGI(RECTAG, REC_INFO_ROI, idx, threshold);
+	return true;
+}//End frameRecorderSetRoiTrigger
+
+/*
+ * ***********************************************************************
+ * @brief       frameRecorderGetStatus
+ * @param       pState - recState_t
+ * 				pTrigger - recTrigger_t of the last trigger
+ * 				pFrames - Records in the ring, or in the clip once frozen
+ * 				pClipLen - Download size, 0 until frozen
+ * 				pRoi, pThreshold - ROI trigger, REC_ROI_NONE if off
+ * @return      None
+ * @details     None
+ **************************************************************************/
+void frameRecorderGetStatus(uint8_t* pState, uint8_t* pTrigger, uint32_t* pFrames, uint32_t* pClipLen, uint8_t* pRoi, uint16_t* pThreshold)
+{
+	taskENTER_CRITICAL(&mLock);
+	const bool isFrozen = (mState == REC_STATE_FROZEN);
+	*pState = mState;
+	*pTrigger = mTrigger;
+	*pFrames = isFrozen ? mClipHeader.mFrames : mRecords;
+	*pClipLen = isFrozen ? mClipLen : 0;
+	*pRoi = mRoiTrigger.mRoi;
+	*pThreshold = mRoiTrigger.mThreshold;
+	taskEXIT_CRITICAL(&mLock);
+}//End frameRecorderGetStatus
+
+/*
+ * ***********************************************************************
+ * @brief       frameRecorderBeginDownload
+ * @param       None
+ * @return      false if there is no frozen clip
+ * @details     Keeps the clip frozen until frameRecorderEndDownload. Called
+ * 				by the RECD command, the transport that sends the clip ends
+ * 				the download.
+ **************************************************************************/
+bool frameRecorderBeginDownload(void)
+{
+	taskENTER_CRITICAL(&mLock);
+	const bool isFrozen = (mState == REC_STATE_FROZEN && mClipLen > 0);
+	if(isFrozen)
+	{
+		++mDownloads;
+	}//End if
+	taskEXIT_CRITICAL(&mLock);
+	return isFrozen;
+}//End frameRecorderBeginDownload
+
+/*
+ * ***********************************************************************
+ * @brief       frameRecorderEndDownload
+ * @param       None
+ * @return      None
+ * @details     Only after a successful frameRecorderBeginDownload
+ **************************************************************************/
+void frameRecorderEndDownload(void)
+{
+	taskENTER_CRITICAL(&mLock);
+	if(mDownloads > 0)
+	{
+		--mDownloads;
+	}//End if
+	taskEXIT_CRITICAL(&mLock);
+}//End frameRecorderEndDownload
+
+/*
+ * ***********************************************************************
+ * @brief       frameRecorderGetClipSpan
+ * @param       offset - Position in the clip
+ * 				ppData - Set to the clip bytes at offset
+ * @return      Contiguous bytes at *ppData, 0 past the end of the clip
+ * @details     The clip is the recClipHeader_t followed by the records.
+ * 				Call between frameRecorderBeginDownload and
+ * 				frameRecorderEndDownload, nothing is copied.
+ **************************************************************************/
+size_t frameRecorderGetClipSpan(const uint32_t offset, const uint8_t** ppData)
+{
+	if(mDownloads == 0 || offset >= mClipLen)
+	{
+		return 0;
+	}//End if
+
+	if(offset < sizeof(mClipHeader))
+	{
+		*ppData = (const uint8_t*)&mClipHeader + offset;
+		return sizeof(mClipHeader) - offset;
+	}//End if
+
+	const uint32_t pos = (mClipStart + offset - sizeof(mClipHeader)) % REC_BUFFER_SIZE;
+	*ppData = &mRing[pos];
+	return MIN(mClipLen - offset, REC_BUFFER_SIZE - pos);
+}//End frameRecorderGetClipSpan
+
+/*
+ * ***********************************************************************
+ * @brief       frameRecorder_Append
+ * @param       pFrame - Frame to record
+ * @return      None
+ * @details     Code the frame, delta + LZ when it shrinks, and append it
+ * 				to the ring, dropping the oldest records to make room
+ **************************************************************************/
+static void frameRecorder_Append(const senxorFrame* pFrame)
+{
+	bool isKey = !mRefValid || mFramesSinceKey >= REC_KEYFRAME_INTERVAL;
+	const uint8_t* pPayload = (const uint8_t*)pFrame->mFrame;
+	size_t len = sizeof(pFrame->mFrame);
+	uint8_t encoding = TCP_STREAM_ENC_RAW16;
+
+	const size_t deltaLen = frameCodec_EncodeDelta(pFrame->mFrame, isKey ? NULL : mRefFrame, REC_FRAME_PIXELS, mDeltaBuff, sizeof(mDeltaBuff));
+	if(deltaLen > 0)
+	{
+		const size_t lzLen = frameCodec_CompressLZ(mDeltaBuff, deltaLen, mEncBuff, deltaLen - 1);
+		pPayload = (lzLen > 0) ? mEncBuff : mDeltaBuff;
+		len = (lzLen > 0) ? lzLen : deltaLen;
+		encoding = (lzLen > 0) ? TCP_STREAM_ENC_DELTA_LZ : TCP_STREAM_ENC_DELTA;
+	}
+	else
+	{
+		isKey = true;															//Raw, no gain
+	}//End if-else
+
+	memcpy(mRefFrame, pFrame->mFrame, sizeof(mRefFrame));
+	mRefValid = true;
+	mFramesSinceKey = isKey ? 0 : (mFramesSinceKey + 1);
+
+	const recRecord_t record = {
+		.mLen = (uint16_t)len,
+		.mEncoding = encoding,
+		.mFlags = (isKey ? REC_FLAG_KEYFRAME : 0) | (mTriggerPending ? REC_FLAG_TRIGGER : 0),
+		.mSeq = pFrame->mSeq,
+		.mTimestampUs = (uint64_t)pFrame->mTimestampUs
+	};
+	const uint32_t total = sizeof(record) + len;
+
+	while(REC_BUFFER_SIZE - mUsed < total)
+	{
+		frameRecorder_DropOldest();
+	}//End while
+
+	frameRecorder_RingWrite(mHead, &record, sizeof(record));
+	frameRecorder_RingWrite(mHead + sizeof(record), pPayload, len);
+	mHead = (mHead + total) % REC_BUFFER_SIZE;
+	mUsed += total;
+	++mRecords;
+
+	if(mTriggerPending)
+	{
+		mClipHeader.mTriggerSeq = pFrame->mSeq;
+		mTriggerPending = false;
+	}//End if
+}//End frameRecorder_Append
+
+/*
+ * ***********************************************************************
+ * @brief       frameRecorder_CheckRoi
+ * @param       None
+ * @return      None
+ * @details     Fire the ROI trigger when the maximum of the ROI in the
+ * 				last analysed frame reached the threshold
+ **************************************************************************/
+static void frameRecorder_CheckRoi(void)
+{
+	roiStats_t stats;
+
+	if(mState != REC_STATE_RECORDING || mRoiTrigger.mRoi == REC_ROI_NONE)
+	{
+		return;
+	}//End if
+
+	if(roiEngine_GetStats(mRoiTrigger.mRoi, &stats) && stats.mPixels > 0 && stats.mMax >= mRoiTrigger.mThreshold)
+	{
+		mTriggerReq = REC_TRIGGER_ROI;
+	}//End if
+}//End frameRecorder_CheckRoi
+
+/*
+ * ***********************************************************************
+ * @brief       frameRecorder_Update
+ * @param       None
+ * @return      None
+ * @details     Apply the posted requests and advance the state:
+ * 				recording -> triggered -> frozen -> recording
+ **************************************************************************/
+static void frameRecorder_Update(void)
+{
+	const int64_t now = esp_timer_get_time();
+	const uint8_t triggerReq = mTriggerReq;
+	mTriggerReq = REC_TRIGGER_NONE;										//Triggers outside the recording state are dropped
+
+	if(mArmReq)
+	{
+		bool isArmed = false;
+
+		taskENTER_CRITICAL(&mLock);
+		if(mDownloads == 0)
+		{
+			isArmed = (mState == REC_STATE_FROZEN);
+			mState = REC_STATE_RECORDING;
+			mArmReq = false;
+		}//End if
+		taskEXIT_CRITICAL(&mLock);
+
+		if(isArmed)
+		{
+			mRefValid = false;												//Frames were skipped while frozen
+			frameRecorder_SetCapture(true);
+		}//End if
+		if(!mArmReq)
+		{
+			mTriggerPending = false;
+			ESP_LOGI(RECTAG, REC_INFO_ARMED);
+			return;
+		}//End if
+	}//End if
+
+	switch(mState)
+	{
+		case REC_STATE_RECORDING:
+			if(triggerReq != REC_TRIGGER_NONE)
+			{
+				mTrigger = triggerReq;
+				mTriggerUs = now;
+				mTriggerPending = true;
+				mState = REC_STATE_TRIGGERED;
+				ESP_LOGI(RECTAG, REC_INFO_TRIGGER, mTriggerName[triggerReq], CONFIG_MI_REC_POST_TRIGGER_S);
+			}//End if
+			break;
+
+		case REC_STATE_TRIGGERED:
+			if(now - mTriggerUs >= REC_POST_TRIGGER_MS * 1000LL)
+			{
+				frameRecorder_Freeze();
+				mFrozenUs = now;
+				frameRecorder_SetCapture(false);
+			}//End if
+			break;
+
+		case REC_STATE_FROZEN:
+			if(REC_HOLD_MS > 0 && now - mFrozenUs >= REC_HOLD_MS * 1000LL)
+			{
+				mArmReq = true;												//Hold time over, applied on the next pass
+			}//End if
+			break;
+
+		default:
+			break;
+	}//End switch
+}//End frameRecorder_Update
+
+/*
+ * ***********************************************************************
+ * @brief       frameRecorder_Freeze
+ * @param       None
+ * @return      None
+ * @details     Find the first record of the clip, fill the clip header
+ * 				and stop recording
+ **************************************************************************/
+static void frameRecorder_Freeze(void)
+{
+	const uint64_t fromUs = (uint64_t)MAX(0, mTriggerUs - REC_PRE_TRIGGER_MS * 1000LL);
+	uint32_t pos = mTail;
+	uint32_t start = mHead;
+	uint32_t startLeft = 0;												//Ring bytes from start to mHead
+	uint32_t startIdx = mRecords;
+
+	// Last keyframe at or before fromUs, else the oldest keyframe
+	for(uint32_t i = 0, left = mUsed; i < mRecords; i++)
+	{
+		recRecord_t record;
+		frameRecorder_RingRead(pos, &record, sizeof(record));
+
+		if((record.mFlags & REC_FLAG_KEYFRAME) && (record.mTimestampUs <= fromUs || startIdx == mRecords))
+		{
+			start = pos;
+			startLeft = left;
+			startIdx = i;
+		}//End if
+
+		const uint32_t total = sizeof(record) + record.mLen;
+		pos = (pos + total) % REC_BUFFER_SIZE;
+		left -= total;
+	}//End for
+
+	mClipHeader.mMagic = REC_CLIP_MAGIC;
+	mClipHeader.mVersion = REC_CLIP_VERSION;
+	mClipHeader.mHeaderLen = sizeof(mClipHeader);
+	mClipHeader.mWidth = SENXOR_FRAME_WIDTH;
+	mClipHeader.mHeight = REC_FRAME_PIXELS / SENXOR_FRAME_WIDTH;
+	mClipHeader.mFrames = mRecords - startIdx;
+	mClipHeader.mTriggerUs = (uint64_t)mTriggerUs;
+	mClipHeader.mTriggerSource = mTrigger;
+	memset(mClipHeader.mReserved, 0, sizeof(mClipHeader.mReserved));
+
+	taskENTER_CRITICAL(&mLock);
+	mClipStart = start;
+	mClipLen = sizeof(mClipHeader) + startLeft;
+	mState = REC_STATE_FROZEN;
+	taskEXIT_CRITICAL(&mLock);
+
+	ESP_LOGI(RECTAG, REC_INFO_FROZEN, (unsigned)mClipHeader.mFrames, (unsigned)mClipLen);
+}//End frameRecorder_Freeze
+
+/*
+ * ***********************************************************************
+ * @brief       frameRecorder_SetCapture
+ * @param       on - true when recording starts, false when it stops
+ * @return      None
+ * @details     Take or drop the capture reference of the recorder. Calls
+ * 				alternate, the recorder starts recording and freezes.
+ **************************************************************************/
+static void frameRecorder_SetCapture(const bool on)
+{
+	if(on)
+	{
+		senxorAcquireCapture();
+	}
+	else
+	{
+		senxorReleaseCapture();
+	}//End if-else
+}//End frameRecorder_SetCapture
+
+/*
+ * ***********************************************************************
+ * @brief       frameRecorder_DropOldest
+ * @param       None
+ * @return      None
+ * @details     None
+ **************************************************************************/
+static void frameRecorder_DropOldest(void)
+{
+	recRecord_t record;
+
+	frameRecorder_RingRead(mTail, &record, sizeof(record));
+	const uint32_t total = sizeof(record) + record.mLen;
+	mTail = (mTail + total) % REC_BUFFER_SIZE;
+	mUsed -= total;
+	--mRecords;
+}//End frameRecorder_DropOldest
+
+/*
+ * ***********************************************************************
+ * @brief       frameRecorder_RingWrite
+ * @param       pos - Ring position, wraps
+ * 				pData, len - Bytes to write
+ * @return      None
+ * @details     None
+ **************************************************************************/
+static void frameRecorder_RingWrite(const uint32_t pos, const void* pData, const uint32_t len)
+{
+	const uint32_t start = pos % REC_BUFFER_SIZE;
+	const uint32_t first = MIN(len, REC_BUFFER_SIZE - start);
+
+	memcpy(&mRing[start], pData, first);
+	memcpy(mRing, (const uint8_t*)pData + first, len - first);
+}//End frameRecorder_RingWrite
+
+/*
+ * ***********************************************************************
+ * @brief       frameRecorder_RingRead
+ * @param       pos - Ring position, wraps
+ * 				pData, len - Bytes to read
+ * @return      None
+ * @details     None
+ **************************************************************************/
+static void frameRecorder_RingRead(const uint32_t pos, void* pData, const uint32_t len)
+{
+	const uint32_t start = pos % REC_BUFFER_SIZE;
+	const uint32_t first = MIN(len, REC_BUFFER_SIZE - start);
+
+	memcpy(pData, &mRing[start], first);
+	memcpy((uint8_t*)pData + first, mRing, len - first);
+}//End frameRecorder_RingRead
+
+#else
+
+bool frameRecorderGetIsRecording(void)
+{
+	return false;
+}//End frameRecorderGetIsRecording
+
+void frameRecorderTrigger(const uint8_t source)
+{
+	(void)source;
+}//End frameRecorderTrigger
+
+#endif
@@ -0,0 +1,260 @@
+/*****************************************************************************
+ * @file     frameSnapshot.c
+ * @version  1.00
+ * @brief    Colour mapped snapshots on the REST server.
+ * @date	 14 Oct 2026
+ * @details	 GET /snapshot.bmp waits for the next frame, so it works while
+ * 			 streaming and while idle: a waiting request asks senxorTask
+ * 			 for frames, like the flash log, and senxorTask hands the next
+ * 			 image over in line. The httpd task then colour maps and scales
+ * 			 it a few lines at a time with the simpleGFX row kernels, so no
+ * 			 full size bitmap is ever held in memory.
+ *
+ * 			 The file is an RGB565 BMP. ESP-IDF carries a JPEG decoder but
+ * 			 no encoder, and an uncompressed 240 x 186 bitmap is 89 kB, a
+ * 			 fraction of a second on Wi-Fi.
+ ******************************************************************************/
+#include <string.h>
+#include <stdlib.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <esp_log.h>
+#include <esp_attr.h>
+#include <esp_http_server.h>
+#include <sdkconfig.h>
+
+#include "restServer.h"
+#include "simpleGFX.h"
+#include "frameSnapshot.h"
+#include "senxorTask.h"
+
+#if CONFIG_MI_SNAP_EN
+//private:
+EXT_RAM_BSS_ATTR static uint16_t mImage[SNAP_IMAGE_W * SNAP_IMAGE_H];	//Written by senxorTask while mPending
+EXT_RAM_BSS_ATTR static uint16_t mLines[SNAP_CHUNK_LINES * SNAP_MAX_LINE];	//httpd task
+static gfxColourLut_t mLut;												//httpd task
+static volatile bool mPending = false;								//A request waits for a frame
+static SemaphoreHandle_t mReady = NULL;								//Given with the frame in mImage
+static SemaphoreHandle_t mBusy = NULL;								//One snapshot at a time
+
+static esp_err_t frameSnapshot_Handler(httpd_req_t *req);
+
+/*
+ * ***********************************************************************
+ * @brief       frameSnapshotInit
+ * @param       None
+ * @return      None
+ * @details     Register SNAP_URI. Call once the REST server runs.
+ **************************************************************************/
+void frameSnapshotInit(void)
+{
+	httpd_handle_t server = getRestServerHandler();
+	if(server == NULL)
+	{
+		return;
+	}//End if
+
+	mReady = xSemaphoreCreateBinary();
+	mBusy = xSemaphoreCreateMutex();
+	gfxLutReset(&mLut);
+
+	const httpd_uri_t snapUri = {
+		.uri = SNAP_URI,
+		.method = HTTP_GET,
+		.handler = frameSnapshot_Handler,
+		.user_ctx = NULL
+	};
+	const esp_err_t err = httpd_register_uri_handler(server, &snapUri);
+	if(err != ESP_OK)
+	{
+		ESP_LOGE(SNAPTAG, SNAP_ERR_REGISTER, SNAP_URI, esp_err_to_name(err));
+		return;
+	}//End if
+	ESP_LOGI(SNAPTAG, SNAP_INFO_START, CONFIG_MI_SNAP_SCALE, CONFIG_MI_SNAP_COLOURMAP);
+}//End frameSnapshotInit
+
+/*
+ * ***********************************************************************
+ * @brief       frameSnapshotOnFrame
+ * @param       pImage - Image of the frame, header rows removed
+ * @return      None
+ * @details     Called by senxorTask for every frame. Copies the image only
+ * 				while a request waits.
+ **************************************************************************/
+void frameSnapshotOnFrame(const uint16_t* pImage)
+{
+	if(!mPending)
+	{
+		return;
+	}//End if
+	mPending = false;
+	memcpy(mImage, pImage, sizeof(mImage));
+	xSemaphoreGive(mReady);
+}//End frameSnapshotOnFrame
+
+/*
+ * ***********************************************************************
+ * @brief       frameSnapshotGetDemandHz
+ * @param       None
+ * @return      Capture rate a waiting request needs, 0 if none waits
+ **************************************************************************/
+uint8_t frameSnapshotGetDemandHz(void)
+{
+	return mPending ? SNAP_DEMAND_HZ : 0;
+}//End frameSnapshotGetDemandHz
+
+/*
+ * ***********************************************************************
+ * @brief       frameSnapshot_Handler
+ * @param       req - HTTP request, optional scale (1-4), map (0-6) and
+ * 				filter (nearest or bilinear)
+ * @return      ESP_OK, or an error to have httpd close the session
+ * @details     Runs in the httpd task. Waits for the next frame, then sends
+ * 				it as a BMP, SNAP_CHUNK_LINES lines per chunk.
+ **************************************************************************/
+static esp_err_t frameSnapshot_Handler(httpd_req_t *req)
+{
+	char query[64];
+	char value[16];
+	uint8_t scale = CONFIG_MI_SNAP_SCALE;
+	uint8_t map = CONFIG_MI_SNAP_COLOURMAP;
+	bool bilinear = false;
+
+	if(httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK)
+	{
+		if(httpd_query_key_value(query, "scale", value, sizeof(value)) == ESP_OK)
+		{
+			const int v = atoi(value);
+			scale = (v >= 1 && v <= GFX_MAX_SCALE) ? v : scale;
+		}//End if
+		if(httpd_query_key_value(query, "map", value, sizeof(value)) == ESP_OK)
+		{
+			const int v = atoi(value);
+			map = (v >= 0 && v < colourmapCount) ? v : map;
+		}//End if
+		if(httpd_query_key_value(query, "filter", value, sizeof(value)) == ESP_OK)
+		{
+			bilinear = (strcmp(value, "bilinear") == 0);
+		}//End if
+	}//End if
+
+	if(xSemaphoreTake(mBusy, 0) != pdTRUE)
+	{
+		httpd_resp_set_status(req, "503 Service Unavailable");
+		return httpd_resp_sendstr(req, SNAP_ERR_BUSY);
+	}//End if
+
+	xSemaphoreTake(mReady, 0);												//Drop a frame a timed out request left
+	mPending = true;
+	senxorTaskNotifyClientChange();											//Demand changed
+	const bool hasFrame = (xSemaphoreTake(mReady, pdMS_TO_TICKS(SNAP_WAIT_MS)) == pdTRUE);
+	mPending = false;
+	if(!hasFrame)
+	{
+		xSemaphoreGive(mBusy);
+		return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, SNAP_ERR_NO_FRAME);
+	}//End if
+
+	uint16_t minVal;
+	uint16_t maxVal;
+	frameSnapshotGetRange(mImage, &minVal, &maxVal);
+	gfxLutUpdate(&mLut, minVal, maxVal, map);
+
+	const uint16_t outW = SNAP_IMAGE_W * scale;							//A multiple of 2 pixels, no line padding
+	const uint16_t outH = SNAP_IMAGE_H * scale;
+	const uint32_t imageSize = (uint32_t)outW * outH * sizeof(uint16_t);
+	const snapBmpHeader_t header = {
+		.mType = 0x4D42,
+		.mFileSize = sizeof(snapBmpHeader_t) + imageSize,
+		.mDataOffset = sizeof(snapBmpHeader_t),
+		.mInfoSize = 40,
+		.mWidth = outW,
+		.mHeight = -(int32_t)outH,
+		.mPlanes = 1,
+		.mBitCount = 16,
+		.mCompression = 3,
+		.mImageSize = imageSize,
+		.mMask = {0xF800, 0x07E0, 0x001F}
+	};
+
+	httpd_resp_set_type(req, "image/bmp");
+	esp_err_t err = httpd_resp_send_chunk(req, (const char*)&header, sizeof(header));
+
+	uint16_t colour[SNAP_IMAGE_W];
+	uint16_t lines = 0;
+	for(uint16_t y = 0; y < outH && err == ESP_OK; y++)
+	{
+		uint16_t* pLine = &mLines[lines++ * outW];
+		if(bilinear)
+		{
+			gfxUpscaleBilinearRow(mImage, SNAP_IMAGE_W, SNAP_IMAGE_H, scale, y, 0, outW, pLine);
+			gfxLutMapRow(&mLut, pLine, pLine, outW);
+		}
+		else
+		{
+			if(y % scale == 0)
+			{
+				gfxLutMapRow(&mLut, &mImage[(y / scale) * SNAP_IMAGE_W], colour, SNAP_IMAGE_W);	//Colours of the next source row
+			}//End if
+			gfxUpscaleNearestRow(colour, SNAP_IMAGE_W, scale, pLine);
+		}//End if-else
+
+		if(lines == SNAP_CHUNK_LINES || y == outH - 1)
+		{
+			err = httpd_resp_send_chunk(req, (const char*)mLines, lines * outW * sizeof(uint16_t));
+			lines = 0;
+		}//End if
+	}//End for
+	xSemaphoreGive(mBusy);
+
+	if(err != ESP_OK)
+	{
+		return err;															//Client gone
+	}//End if
+	return httpd_resp_send_chunk(req, NULL, 0);
+}//End frameSnapshot_Handler
+
+/*
+ * ***********************************************************************
+ * @brief       frameSnapshotGetRange
+ * @param       pImage - Image, header rows removed
+ * 				pMin, pMax - Colour range of the image
+ * @return      None
+ * @details     Minimum and maximum of pImage, at least SNAP_MIN_SPAN apart.
+ * 				Shared with the JPEG stream, so every snapshot colours alike.
+ **************************************************************************/
+void frameSnapshotGetRange(const uint16_t* pImage, uint16_t* pMin, uint16_t* pMax)
+{
+	uint16_t lo = UINT16_MAX;
+	uint16_t hi = 0;
+
+	for(uint16_t i = 0; i < SNAP_IMAGE_W * SNAP_IMAGE_H; i++)
+	{
+		lo = (pImage[i] < lo) ? pImage[i] : lo;
+		hi = (pImage[i] > hi) ? pImage[i] : hi;
+	}//End for
+	if(hi - lo < SNAP_MIN_SPAN)
+	{
+		hi = (lo > UINT16_MAX - SNAP_MIN_SPAN) ? UINT16_MAX : lo + SNAP_MIN_SPAN;
+	}//End if
+	*pMin = lo;
+	*pMax = hi;
+}//End frameSnapshotGetRange
+
+#else
+
+void frameSnapshotInit(void)
+{
+}//End frameSnapshotInit
+
+void frameSnapshotOnFrame(const uint16_t* pImage)
+{
+	(void)pImage;
+}//End frameSnapshotOnFrame
+
+uint8_t frameSnapshotGetDemandHz(void)
+{
+	return 0;
+}//End frameSnapshotGetDemandHz
+
+#endif
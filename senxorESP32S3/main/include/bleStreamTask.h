@@ -0,0 +1,118 @@
+/*****************************************************************************
+ * @file     bleStreamTask.h
+ * @version  1.02
+ * @brief    Header file for bleStreamTask.c
+ * @date	 14 Oct 2026
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_BLESTREAMTASK_H_
+#define MAIN_INCLUDE_BLESTREAMTASK_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <sdkconfig.h>
+
+#include "framePool.h"
+#include "senxorTask.h"
+#include "blobTrack.h"
+
+#define BLE_STREAM_STACK_SIZE		3072
+#define BLE_STREAM_APP_ID			2									//GATT application ID, Combustion uses 1
+#define BLE_STREAM_WAIT_MS			100									//Longest sleep while a client streams
+#define BLE_STREAM_PREVIEW_STEP		2									//Preview is the mean of 2 x 2 pixel blocks
+#define BLE_STREAM_MAX_PIXELS		((SENXOR_FRAME_WIDTH / BLE_STREAM_PREVIEW_STEP) * (SENXOR_FRAME_HEIGHT / BLE_STREAM_PREVIEW_STEP))	//40 x 31
+#define BLE_STREAM_IMAGE_OFFSET		(2 * SENXOR_FRAME_WIDTH)			//Header rows of the frame, not sent
+#define BLE_STREAM_HEADER_SIZE		14									//Frame header in front of the payload
+#define BLE_STREAM_CHUNK_HEADER		3									//Frame id, chunk index, chunk count
+#define BLE_STREAM_MSG_MAX			(BLE_STREAM_HEADER_SIZE + BLE_STREAM_MAX_PIXELS * 2 + sizeof(blobRecord_t))	//Blob record after the payload
+#define BLE_STREAM_DEFAULT_MTU		23
+#define BLE_STREAM_MAX_CREDITS		64									//Notifications a client may grant in advance
+#define BLE_STREAM_CTRL_MAX			8									//Longest control write
+#define BLE_STREAM_RULE_MSG_SIZE	9									//Alarm notification, one rule event
+#define BLE_STREAM_FPS				CONFIG_MI_BLE_STREAM_FPS
+#define BLE_STREAM_MAX_FPS			25
+#define BLE_STREAM_KEYFRAME_INTERVAL	CONFIG_MI_BLE_STREAM_KEYFRAME_INTERVAL
+
+// Connection interval while streaming, in 1.25 ms units
+#define BLE_STREAM_CONN_INT_MIN		12									//15 ms, the shortest iOS accepts
+#define BLE_STREAM_CONN_INT_MAX		24									//30 ms
+#define BLE_STREAM_CONN_TIMEOUT		400									//4 s, in 10 ms units
+#define BLE_STREAM_DATA_LEN			251									//LE data length extension, octets per link layer packet
+
+// Thermal Stream Service UUID: 5A0B0100-2E1F-4B8C-9D37-6C1E80F3A7B2 (LSB first)
+#define BLE_STREAM_SERVICE_UUID_128 { \
+	0xB2, 0xA7, 0xF3, 0x80, 0x1E, 0x6C, 0x37, 0x9D, \
+	0x8C, 0x4B, 0x1F, 0x2E, 0x00, 0x01, 0x0B, 0x5A  \
+}
+
+// Frame characteristic (notify): 5A0B0101-2E1F-4B8C-9D37-6C1E80F3A7B2
+#define BLE_STREAM_FRAME_UUID_128 { \
+	0xB2, 0xA7, 0xF3, 0x80, 0x1E, 0x6C, 0x37, 0x9D, \
+	0x8C, 0x4B, 0x1F, 0x2E, 0x01, 0x01, 0x0B, 0x5A  \
+}
+
+// Control characteristic (write): 5A0B0102-2E1F-4B8C-9D37-6C1E80F3A7B2
+#define BLE_STREAM_CTRL_UUID_128 { \
+	0xB2, 0xA7, 0xF3, 0x80, 0x1E, 0x6C, 0x37, 0x9D, \
+	0x8C, 0x4B, 0x1F, 0x2E, 0x02, 0x01, 0x0B, 0x5A  \
+}
+
+// Alarm characteristic (notify): 5A0B0103-2E1F-4B8C-9D37-6C1E80F3A7B2
+#define BLE_STREAM_ALARM_UUID_128 { \
+	0xB2, 0xA7, 0xF3, 0x80, 0x1E, 0x6C, 0x37, 0x9D, \
+	0x8C, 0x4B, 0x1F, 0x2E, 0x03, 0x01, 0x0B, 0x5A  \
+}
+
+// Control opcodes, first byte of a control write
+#define BLE_STREAM_OP_CREDIT		0x01								//[n] n more notifications may be sent
+#define BLE_STREAM_OP_VIEW			0x02								//[0] preview, or [1][slot] ROI slot
+#define BLE_STREAM_OP_RATE			0x03								//[fps] 1-BLE_STREAM_MAX_FPS
+#define BLE_STREAM_OP_KEYFRAME		0x04								//Next frame is a keyframe
+#define BLE_STREAM_OP_RECORD		0x05								//Trigger the frame recorder, any connected client
+
+#define BLE_STREAM_VIEW_PREVIEW		0x00
+#define BLE_STREAM_VIEW_ROI			0x01
+
+#define BLSTAG						"[BLE_STREAM]"
+#define BLS_INFO_START				"Thermal stream service registered, app %d."
+#define BLS_INFO_JOIN				"Client %d streaming, MTU %d."
+#define BLS_INFO_LEFT				"Client %d stopped, %u frames sent."
+#define BLS_INFO_VIEW				"View %d x %d at (%d, %d), step %d."
+#define BLS_WARN_BUSY				"Client %d refused: client %d already streams."
+#define BLS_WARN_ROI				"ROI %d unused, view unchanged."
+#define BLS_WARN_SEND				"Notification failed: %s"
+#define BLS_ERR_REGISTER			"Cannot register the stream service: %s"
+
+/*
+ * Area of the image sent to the client. Every sent pixel is the mean of a
+ * mStep x mStep block starting at (mX + column * mStep, mY + row * mStep).
+ */
+typedef struct bleView{
+	uint8_t mX;
+	uint8_t mY;
+	uint8_t mWidth;								//Sent columns
+	uint8_t mHeight;							//Sent rows
+	uint8_t mStep;
+}bleView_t;
+
+typedef struct bleStreamClient{
+	bool mActive;								//Notifications enabled on the frame characteristic
+	uint16_t mConnId;
+	uint16_t mMtu;
+	uint16_t mCredits;							//Notifications the client can still take
+	bool mCongested;							//Stack queue full, wait for the congestion event
+	bool mKeyRequest;							//Client asked for a keyframe
+	uint8_t mFps;
+	uint8_t mView;								//BLE_STREAM_VIEW_*
+	uint8_t mRoi;								//ROI slot of BLE_STREAM_VIEW_ROI
+	frameSubscriber_t mFrameSub;
+	uint32_t mFramesSent;
+}bleStreamClient_t;
+
+void bleStreamTask(void *pvParameters);
+
+bool bleStreamGetIsClientConnected(void);
+
+void bleStreamNotifyRule(void);
+
+#endif /* MAIN_INCLUDE_BLESTREAMTASK_H_ */
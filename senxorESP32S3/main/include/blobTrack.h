@@ -0,0 +1,66 @@
+/*****************************************************************************
+ * @file     blobTrack.h
+ * @version  1.00
+ * @brief    Header file for blobTrack.c
+ * @date	 15 Oct 2026
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_BLOBTRACK_H_
+#define MAIN_INCLUDE_BLOBTRACK_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <sdkconfig.h>
+
+#define BLOB_WIDTH					80
+#define BLOB_HEIGHT					62									//Image rows, header rows removed
+#define BLOB_MAX					8									//Entries of a record, largest blobs first
+#define BLOB_MAX_RUNS				512									//Runs above the threshold in one frame
+#define BLOB_MAX_CANDIDATES			64									//Blobs measured in one frame, before the area filter
+#define BLOB_MAX_TRACKS				(2 * BLOB_MAX)						//Tracked blobs, reported or coasting
+#define BLOB_TRACK_RADIUS			8									//Largest centroid move between two frames, pixels
+#define BLOB_TRACK_MISSES			3									//Frames a track survives without a match
+#if CONFIG_MI_BLOB_EN
+#define BLOB_DEFAULT_THRESHOLD		CONFIG_MI_BLOB_THRESHOLD			//Raw frame units, 0 = off
+#define BLOB_DEFAULT_MIN_AREA		CONFIG_MI_BLOB_MIN_AREA
+#endif
+
+// Entry flags
+#define BLOB_FLAG_NEW				0x01								//First frame of this ID
+#define BLOB_FLAG_LOST				0x02								//Track ended, the other fields are its last position
+
+// Record flags
+#define BLOB_REC_OVERFLOW			0x01								//More runs or blobs than the tables hold, some were not measured
+
+#define BLOBTAG						"[BLOB]"
+#define BLOB_INFO_CONFIG			"Threshold %u, minimum area %d."
+
+// One blob of a frame, 12 bytes on the wire
+typedef struct __attribute__((packed)) blobEntry{
+	uint8_t mId;							//Stable ID while the blob is tracked, never 0
+	uint8_t mFlags;							//BLOB_FLAG_*
+	uint16_t mArea;							//Pixels
+	uint16_t mPeak;							//Hottest pixel, raw frame units
+	uint8_t mPeakX;							//Position of the hottest pixel
+	uint8_t mPeakY;
+	uint16_t mCx;							//Centroid, 1/256 pixel, pixel x is centred on x
+	uint16_t mCy;
+}blobEntry_t;
+
+// Blobs of one frame, only 6 + 12 * mCount bytes are sent
+typedef struct __attribute__((packed)) blobRecord{
+	uint32_t mSeq;							//Capture sequence number of the frame
+	uint8_t mCount;							//Entries in mBlob
+	uint8_t mFlags;							//BLOB_REC_*
+	blobEntry_t mBlob[BLOB_MAX];
+}blobRecord_t;
+
+#define BLOB_RECORD_HEADER			6									//mSeq, mCount and mFlags
+
+void blobTrack_Process(const uint16_t* pImage, const uint32_t seq);
+
+uint16_t blobTrack_GetRecord(blobRecord_t* pRecord);
+
+void blobTrack_Configure(const uint16_t threshold, const uint8_t minArea);
+
+void blobTrack_GetStatus(uint16_t* pThreshold, uint8_t* pMinArea, uint8_t* pCount);
+
+#endif /* MAIN_INCLUDE_BLOBTRACK_H_ */
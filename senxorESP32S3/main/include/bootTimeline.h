@@ -0,0 +1,42 @@
+/*****************************************************************************
+ * @file     bootTimeline.h
+ * @version  1.01
+ * @brief    Header file for bootTimeline.c
+ * @date	 14 Oct 2026
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_BOOTTIMELINE_H_
+#define MAIN_INCLUDE_BOOTTIMELINE_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include "jsonWriter.h"
+
+#define BOOT_BT_TASK_STACK_SIZE		4096		//Bluedroid init, internal RAM as it reads bonding keys from NVS
+#define BOOT_BT_TASK_PRIORITY		5			//Below senxorTask, so a streaming frame is never held up
+
+#define BOOTTAG						"[BOOT]"
+#define BOOT_INFO_MARK				"%s at %lld ms"
+#define BOOT_ERR_BT_TASK			"Cannot start the Bluetooth init task, initialising in line."
+
+/*
+ * Milestones of a boot, every one is recorded the first time it happens
+ */
+typedef enum bootMark{
+	BOOT_MARK_PERI = 0,						//MCU peripherals and NVS ready
+	BOOT_MARK_SENXOR,						//senxorInit done, calibration processed
+	BOOT_MARK_WLAN,							//Wi-Fi started, association runs in the background
+	BOOT_MARK_REST,							//REST server listening
+	BOOT_MARK_SERVERS,						//Frame and command servers listening
+	BOOT_MARK_BT,							//BluFi, Combustion BLE and the BLE stream up
+	BOOT_MARK_IP,							//Station got an IP address
+	BOOT_MARK_FIRST_FRAME,					//First frame captured and analysed
+	BOOT_MARK_FIRST_SEND,					//First frame handed to a frame port client
+	BOOT_MARK_COUNT
+}bootMark_t;
+
+void bootTimelineInit(void);
+
+void bootTimelineMark(const bootMark_t mark);
+
+void bootTimelineGetRptToJson(jsonWriter_t* pWriter);
+
+#endif /* MAIN_INCLUDE_BOOTTIMELINE_H_ */
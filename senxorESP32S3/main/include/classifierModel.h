@@ -0,0 +1,36 @@
+/*****************************************************************************
+ * @file     classifierModel.h
+ * @version  1.00
+ * @brief    Header file for classifierModel.cc
+ * @date	 15 Oct 2026
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_CLASSIFIERMODEL_H_
+#define MAIN_INCLUDE_CLASSIFIERMODEL_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Input tensor of the model, filled by the caller before every inference
+typedef struct clsInput{
+	int8_t* pData;							//Height x width, row major, one channel
+	float mScale;							//Kelvin = (q - mZeroPoint) * mScale
+	int32_t mZeroPoint;
+	uint8_t mWidth;
+	uint8_t mHeight;
+	uint8_t mClasses;						//Model outputs, at least CLS_CLASS_COUNT
+	size_t mArenaUsed;
+}clsInput_t;
+
+bool classifierModel_Init(uint8_t* pArena, const size_t arenaSize, clsInput_t* pInput);
+
+bool classifierModel_Invoke(uint16_t* pScore, const uint8_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MAIN_INCLUDE_CLASSIFIERMODEL_H_ */
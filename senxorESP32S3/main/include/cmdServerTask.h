@@ -1,6 +1,6 @@
 /*****************************************************************************
  * @file     cmdServerTask.h
- * @version  1.0
+ * @version  1.1
  * @brief    Command server for handling WREG/RREG/RRSE commands
  * @date     31 Dec 2024
  *****************************************************************************/
@@ -9,14 +9,51 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <freertos/FreeRTOS.h>
+#include <sdkconfig.h>
+
+#include "cmdParser.h"
 
 #define CMD_SERVER_PORT         3334
 #define CMD_SERVER_STACK_SIZE   4096
 #define POLL_MAX_FREQ_HZ        25   // Camera max frame rate
+#define CMD_SERVER_POLL_MS      10   // select() timeout when the wake up eventfd is not available
+#define CMD_MAX_CLIENTS         CONFIG_MI_CMD_MAX_CLIENTS
+#define CMD_SERVER_TOS          CONFIG_MI_LINK_CMD_TOS   // IP TOS byte, ahead of frames in the WMM queues
+#define CMD_OUT_BUFF_SIZE       1024 // Output queued per client while its socket is full
+#define CMD_CLIP_CRC_SIZE       8    // RECD trailer, CRC32 as hex digits
+
+typedef struct cmdClient{
+    int mSock;                              // Client socket. -1 if the entry is free
+    cmdPhaser mParser;                      // Parser state, a command may span several segments
+    uint8_t mSubRegs[SUBS_MAX_REGS];        // Subscribed registers (SUBS)
+    uint16_t mSubLast[SUBS_MAX_REGS];       // Last value pushed
+    uint8_t mSubCount;                      // 0 = no subscription
+    uint16_t mSubIntervalMs;                // Minimum time between two pushes
+    uint16_t mSubThreshold;                 // Minimum change of a pushed register
+    bool mSubPrimed;                        // false = next push sends every register
+    TickType_t mSubLastPush;                // Time of the last push
+    char mAddr[16];                         // Client IPv4 address
+    uint8_t mOut[CMD_OUT_BUFF_SIZE];        // Output the socket did not take yet
+    uint16_t mOutLen;                       // Bytes queued in mOut
+#if CONFIG_MI_REC_EN
+    bool mClipActive;                       // A RECD clip is being sent
+    uint16_t mClipAt;                       // Bytes of mOut that go out before the clip
+    uint32_t mClipOffset;                   // Next clip byte to send
+    uint32_t mClipLeft;                     // Clip bytes still to send
+    uint32_t mClipCrc;                      // CRC32 of the clip bytes sent
+#endif
+}cmdClient_t;
 
 void cmdServerTask(void *pvParameters);
 bool cmdServerGetIsClientConnected(void);
 uint8_t cmdServerGetPollFreqHz(void);
 void cmdServerSetPollFreqHz(uint8_t freqHz);
+bool cmdServerSubscribe(const uint8_t* pAddr, const uint8_t count, const uint16_t intervalMs, const uint16_t threshold);
+const char* cmdServerGetCurrentAddr(void);
+bool cmdServerGetIsSubscribed(void);
+uint8_t cmdServerGetSubscribedRateHz(void);
+void cmdServerNotifyUpdate(void);
+void cmdServerNotifyRule(void);
 
 #endif /* MAIN_INCLUDE_CMDSERVERTASK_H_ */
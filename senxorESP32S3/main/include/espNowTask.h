@@ -0,0 +1,90 @@
+/*****************************************************************************
+ * @file     espNowTask.h
+ * @version  1.00
+ * @brief    Header file for espNowTask.c
+ * @date	 15 Oct 2026
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_ESPNOWTASK_H_
+#define MAIN_INCLUDE_ESPNOWTASK_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <sdkconfig.h>
+
+#include "senxorTask.h"
+#include "blobTrack.h"
+
+#define ESPNOW_STACK_SIZE			3072
+#define ESPNOW_WAIT_MS				100									//Longest sleep between two checks of the stats period
+#define ESPNOW_SEND_WAIT_MS			20									//Longest wait for the send callback of one packet
+#define ESPNOW_MAX_PEERS			6									//Slots of the peer table
+#define ESPNOW_PEER_VERSION			1									//Layout version of the NVS blob
+#define ESPNOW_NVS_KEY				"espnowpeers"
+#define ESPNOW_RX_QUEUE_LEN			8									//Packets from peers waiting for the task
+#define ESPNOW_RX_MAX				16									//Longest packet a peer sends
+#define ESPNOW_FPS					CONFIG_MI_ESPNOW_FPS
+#define ESPNOW_RATE_HZ				CONFIG_MI_ESPNOW_RATE_HZ
+#define ESPNOW_STATS_PERIOD_MS		CONFIG_MI_ESPNOW_STATS_MS
+#define ESPNOW_MAX_NACKS			3									//Retransmit requests served per frame and peer
+
+// Packet layout, every packet starts with ESPNOW_MAGIC and its type
+#define ESPNOW_PACKET_MAX			250									//ESP_NOW_MAX_DATA_LEN of ESP-NOW v1, which every peer receives
+#define ESPNOW_MAGIC				0x58								//'X'
+#define ESPNOW_TYPE_EVENT			0x01								//Device -> peer, one alarm rule event
+#define ESPNOW_TYPE_ROI				0x02								//Device -> peer, statistics of the used ROIs
+#define ESPNOW_TYPE_FRAG			0x03								//Device -> peer, one fragment of a frame
+#define ESPNOW_TYPE_NACK			0x04								//Peer -> device, fragments of a frame to send again
+#define ESPNOW_EVENT_SIZE			11									//Magic, type, rule, raised, value, active, seq
+#define ESPNOW_ROI_HEADER			7									//Magic, type, seq, count
+#define ESPNOW_ROI_ENTRY			13									//Slot, min, max, mean, percentile, hot x, hot y, pixels
+#define ESPNOW_FRAG_HEADER			6									//Magic, type, frame id, fragment index, fragment count
+#define ESPNOW_FRAG_DATA			(ESPNOW_PACKET_MAX - ESPNOW_FRAG_HEADER)
+#define ESPNOW_NACK_SIZE			12									//Magic, type, frame id, 64 bit mask of missing fragments
+#define ESPNOW_MAX_FRAGS			64									//Fragments the NACK mask covers
+
+// Frame message, cut into fragments; the header is the one of the BLE stream
+#define ESPNOW_IMAGE_OFFSET			(2 * SENXOR_FRAME_WIDTH)			//Header rows of the frame, not sent
+#define ESPNOW_IMAGE_PIXELS			(SENXOR_FRAME_WIDTH * SENXOR_FRAME_HEIGHT)
+#define ESPNOW_MSG_HEADER			14
+#define ESPNOW_MSG_MAX				(ESPNOW_MSG_HEADER + ESPNOW_IMAGE_PIXELS * 2 + sizeof(blobRecord_t))
+
+// Peer flags, the numbers are part of the protocol
+#define ESPNOW_PEER_EVENTS			0x01								//Alarm rule events
+#define ESPNOW_PEER_ROI				0x02								//ROI statistics every ESPNOW_STATS_PERIOD_MS
+#define ESPNOW_PEER_FRAMES			0x04								//Frames at ESPNOW_FPS
+#define ESPNOW_PEER_ALL				(ESPNOW_PEER_EVENTS | ESPNOW_PEER_ROI | ESPNOW_PEER_FRAMES)
+
+#define ESPNOWTAG					"[ESPNOW]"
+#define ESPNOW_INFO_START			"ESP-NOW on channel %d, %d peers."
+#define ESPNOW_INFO_PEER			"Peer %d set: " MACSTR ", flags 0x%02X."
+#define ESPNOW_INFO_EVENT			"Peer " MACSTR ": rule %d %s, value %u."
+#define ESPNOW_WARN_SEND			"Send to " MACSTR " failed: %s"
+#define ESPNOW_ERR_INIT				"Cannot start ESP-NOW: %s"
+#define ESPNOW_ERR_PEER				"Peer %d rejected: %s"
+
+// One peer of the table
+typedef struct __attribute__((packed)) espNowPeer{
+	uint8_t mMac[6];
+	uint8_t mFlags;							//ESPNOW_PEER_*, 0 = unused slot
+}espNowPeer_t;
+
+// Peer table, stored as one NVS blob
+typedef struct espNowTable{
+	uint8_t mVersion;						//ESPNOW_PEER_VERSION
+	espNowPeer_t mPeer[ESPNOW_MAX_PEERS];
+}espNowTable_t;
+
+void espNowTask(void *pvParameters);
+
+void espNowOnFrame(const uint16_t* pImage, const uint32_t seq);
+
+void espNowNotifyRule(void);
+
+uint8_t espNowGetDemandHz(void);
+
+bool espNow_SetPeer(const uint8_t idx, const uint8_t* pMac, const uint8_t flags);
+
+bool espNow_GetPeer(const uint8_t idx, uint8_t* pMac, uint8_t* pFlags, uint16_t* pFailed);
+
+#endif /* MAIN_INCLUDE_ESPNOWTASK_H_ */
@@ -0,0 +1,96 @@
+/*****************************************************************************
+ * @file     flashLog.h
+ * @version  1.00
+ * @brief    Header file for flashLog.c
+ * @date	 14 Oct 2026
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_FLASHLOG_H_
+#define MAIN_INCLUDE_FLASHLOG_H_
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <sdkconfig.h>
+
+#define FLOG_TASK_STACK_SIZE		3072
+#define FLOG_PARTITION_LABEL		"sxlog"
+#define FLOG_PARTITION_SUBTYPE		0x40								//Custom data subtype, see partitions.csv
+#define FLOG_CHUNK_SIZE				(CONFIG_MI_FLOG_CHUNK_KB * 1024)	//Unit of the time index and of erasing
+#define FLOG_PAGE_SIZE				256									//Flash program page, writes are batched to whole pages
+#define FLOG_MAX_CHUNKS				256									//Chunks indexed, a larger partition is used in part
+#define FLOG_PERIOD_MS				(CONFIG_MI_FLOG_PERIOD_S * 1000)
+#define FLOG_FRAME_PERIOD_MS		(CONFIG_MI_FLOG_FRAME_PERIOD_S * 1000)
+#define FLOG_DEMAND_HZ				1									//Slowest capture rate that keeps the ROI statistics fresh
+#define FLOG_IMAGE_PIXELS			(80 * 62)							//Frame records hold the image, header rows removed
+#define FLOG_READ_CHUNK				1024								//Bytes sent per HTTP chunk
+#define FLOG_URI					"/log"
+#define FLOG_STATUS_URI				"/log/status"
+
+#define FLOG_CHUNK_MAGIC			0x474C5853							//"SXLG" in little endian
+#define FLOG_VERSION				1
+#define FLOG_REC_EMPTY				0xFFFF								//mLen of erased flash, end of the chunk
+#define FLOG_ROI_FRAME				0xFF								//flogRoiEntry_t of the whole image
+
+#define FLOGTAG						"[FLASH_LOG]"
+#define FLOG_INFO_START				"Logging to %u chunks of %u kB, clock at %llu ms."
+#define FLOG_INFO_WRAP				"Log wrapped, chunk %u erased."
+#define FLOG_ERR_PARTITION			"No " FLOG_PARTITION_LABEL " partition, flash log stopped."
+#define FLOG_ERR_FLASH				"Flash %s failed: %s"
+#define FLOG_ERR_REGISTER			"Cannot register %s: %s"
+#define FLOG_WARN_NO_SERVER			"REST server not running, the log is kept but not served."
+
+typedef enum flogRecType{
+	FLOG_REC_ROI = 1,						//ROI statistics of every used slot
+	FLOG_REC_FRAME							//Full image
+}flogRecType_t;
+
+/*
+ * First bytes of every chunk, the records follow.
+ * All fields are little endian.
+ */
+typedef struct __attribute__((packed)) flogChunkHeader{
+	uint32_t mMagic;						//FLOG_CHUNK_MAGIC
+	uint8_t mVersion;						//FLOG_VERSION
+	uint8_t mHeaderLen;						//Size of this header
+	uint16_t mReserved;
+	uint32_t mSeq;							//Increments per chunk, the highest is the newest
+	uint64_t mFirstMs;						//Log clock of the first record
+}flogChunkHeader_t;
+
+/*
+ * Header of every record, followed by mLen payload bytes
+ */
+typedef struct __attribute__((packed)) flogRecord{
+	uint16_t mLen;							//Payload size in bytes, FLOG_REC_EMPTY past the last record
+	uint8_t mType;							//flogRecType_t
+	uint8_t mEncoding;						//tcpStreamEncoding_t of a frame, 0 for statistics
+	uint32_t mTimeMs;						//Log clock, relative to the chunk mFirstMs
+	uint16_t mCrc;							//CRC-16 of the payload, a record cut by a reset fails it
+}flogRecord_t;
+
+// One used ROI slot, or FLOG_ROI_FRAME, in a FLOG_REC_ROI payload
+typedef struct __attribute__((packed)) flogRoiEntry{
+	uint8_t mRoi;
+	uint8_t mReserved;
+	uint16_t mMin;
+	uint16_t mMax;
+	uint16_t mMean;
+	uint16_t mPercentile;					//ROI percentile, p99 of the whole image
+}flogRoiEntry_t;
+
+// Chunk in the RAM time index
+typedef struct flogIndex{
+	uint32_t mSeq;							//0 while the chunk is empty
+	uint32_t mUsed;							//Header and records
+	uint64_t mFirstMs;
+	uint64_t mLastMs;						//Log clock of the last record
+}flogIndex_t;
+
+void flashLogTask(void *pvParameters);
+
+void flashLogOnFrame(const uint16_t* pImage);
+
+uint8_t flashLogGetDemandHz(void);
+
+#endif /* MAIN_INCLUDE_FLASHLOG_H_ */
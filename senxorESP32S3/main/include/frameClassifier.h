@@ -0,0 +1,74 @@
+/*****************************************************************************
+ * @file     frameClassifier.h
+ * @version  1.00
+ * @brief    Header file for frameClassifier.c
+ * @date	 15 Oct 2026
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_FRAMECLASSIFIER_H_
+#define MAIN_INCLUDE_FRAMECLASSIFIER_H_
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <sdkconfig.h>
+
+#define CLS_WIDTH					80
+#define CLS_HEIGHT					62									//Image rows, header rows removed
+#define CLS_PIXELS					(CLS_WIDTH * CLS_HEIGHT)
+#define CLS_STACK_SIZE				6144								//The interpreter recurses through the kernels
+#define CLS_TASK_PRIO				1									//Below every other application task, core 1 idle time only
+#define CLS_TASK_CORE				1
+#define CLS_MAX_RATE_HZ				10
+#if CONFIG_MI_CLASSIFY_EN
+#define CLS_DEFAULT_RATE			CONFIG_MI_CLASSIFY_RATE
+#define CLS_ARENA_SIZE				(CONFIG_MI_CLASSIFY_ARENA_KB * 1024)
+#endif
+
+// Classifier registers
+#define REG_CLS_RATE				0xF8								//Inferences per second, 0 = off (R/W)
+#define REG_CLS_ROI					0xF9								//0 = whole image, n = bounding box of ROI slot n - 1 (R/W)
+#define REG_CLS_CLASS				0xFA								//clsClass_t of the last inference (R)
+#define REG_CLS_FLAME				0xFB								//Flame score of the last inference, permille (R, 16-bit)
+#define REG_CLS_PAN					0xFC								//Pan score of the last inference, permille (R, 16-bit)
+#define REG_CLS_LATENCY				0xFD								//Time of the last inference, us, saturates at 65535 (R, 16-bit)
+#define REG_CLS_FIRST				REG_CLS_RATE
+#define REG_CLS_LAST				REG_CLS_LATENCY
+
+#define CLSTAG						"[CLASSIFY]"
+#define CLS_INFO_READY				"Model ready: %dx%d input, %d classes, %u of %u arena bytes used."
+#define CLS_INFO_RATE				"%d inferences per second, ROI %d."
+#define CLS_ERR_SCHEMA				"Model schema version %" PRIu32 ", expected %d."
+#define CLS_ERR_MODEL				"Model rejected, classifier off."
+#define CLS_ERR_INVOKE				"Inference failed."
+
+// Classes, the order of the model outputs and part of the protocol
+typedef enum clsClass{
+	CLS_CLASS_NONE = 0,						//Neither a pan nor a flame
+	CLS_CLASS_PAN,							//Hot cookware, attended or not
+	CLS_CLASS_FLAME,						//Open flame
+	CLS_CLASS_COUNT
+}clsClass_t;
+
+// Inference timing since the previous read
+typedef struct clsStats{
+	uint32_t mInferences;
+	uint32_t mBusy;							//Frames due while the last one was still being classified
+	uint32_t mAvgUs;						//Preprocessing and inference
+	uint32_t mMaxUs;
+	uint32_t mLastUs;
+}clsStats_t;
+
+void frameClassifierTask(void *pvParameters);
+
+void frameClassifierOnFrame(const uint16_t* pImage);
+
+uint8_t frameClassifierGetDemandHz(void);
+
+void frameClassifier_GetStats(clsStats_t* pStats, const bool reset);
+
+uint16_t frameClassifier_ReadRegister(const uint8_t regAddr);
+
+void frameClassifier_WriteRegister(const uint8_t regAddr, const uint8_t value);
+
+#endif /* MAIN_INCLUDE_FRAMECLASSIFIER_H_ */
@@ -0,0 +1,25 @@
+/*****************************************************************************
+ * @file     frameCodec.h
+ * @version  1.02
+ * @brief    Header file for frameCodec.c
+ * @date	 14 Oct 2026
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_FRAMECODEC_H_
+#define MAIN_INCLUDE_FRAMECODEC_H_
+#include <stdint.h>
+#include <stddef.h>
+
+#define FRAME_CODEC_LZ_MIN_MATCH	4									//Shortest match worth an LZ sequence
+#define FRAME_CODEC_LZ_HASH_BITS	12									//Size of the LZ match finder table
+#define FRAME_CODEC_LZ_MAX_INPUT	65535								//Offsets and table entries are 16 bit
+#define FRAME_CODEC_PACK_HEADER_SIZE	4								//Minimum, shift and width ahead of packed pixels
+
+size_t frameCodec_EncodeDelta(const uint16_t* pFrame, const uint16_t* pRef, const size_t pixels, uint8_t* pOut, const size_t outMax);
+
+size_t frameCodec_CompressLZ(const uint8_t* pIn, const size_t len, uint8_t* pOut, const size_t outMax);
+
+size_t frameCodec_PoolMax(const uint16_t* pImage, const size_t stride, const uint8_t x, const uint8_t y, const uint8_t width, const uint8_t height, const uint8_t factor, uint16_t* pOut);
+
+size_t frameCodec_PackBits(const uint16_t* pPixels, const size_t pixels, const uint8_t bits, uint8_t* pOut, const size_t outMax);
+
+#endif /* MAIN_INCLUDE_FRAMECODEC_H_ */
@@ -0,0 +1,116 @@
+/*****************************************************************************
+ * @file     framePool.h
+ * @version  1.10
+ * @brief    Header file for framePool.c
+ * @date	 14 Oct 2026
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_FRAMEPOOL_H_
+#define MAIN_INCLUDE_FRAMEPOOL_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <sdkconfig.h>
+
+#include "senxorTask.h"
+#include "schedProfile.h"
+
+/*
+ * A frame slot can be referenced by the producer, by every mailbox it has been
+ * pushed into, and by the frame a subscriber is holding. The pool is sized so
+ * the producer always finds a free slot when every subscriber uses the maximum
+ * depth: 1 (being written) + per subscriber (mailbox depth + 1 being processed).
+ */
+#if CONFIG_MI_WS_STREAM_EN
+#define FRAME_BUS_WS_SUBSCRIBERS	CONFIG_MI_WS_MAX_CLIENTS
+#else
+#define FRAME_BUS_WS_SUBSCRIBERS	0
+#endif
+#if CONFIG_MI_BLE_STREAM_EN
+#define FRAME_BUS_BLE_SUBSCRIBERS	1
+#else
+#define FRAME_BUS_BLE_SUBSCRIBERS	0
+#endif
+#if CONFIG_MI_REC_EN
+#define FRAME_BUS_REC_SUBSCRIBERS	1
+#else
+#define FRAME_BUS_REC_SUBSCRIBERS	0
+#endif
+#if CONFIG_MI_LCD_LIVE_VIEW
+#define FRAME_BUS_LCD_SUBSCRIBERS	1
+#else
+#define FRAME_BUS_LCD_SUBSCRIBERS	0
+#endif
+#if SCHED_ANALYTICS_SPLIT
+#define FRAME_BUS_ANA_SUBSCRIBERS	1
+#else
+#define FRAME_BUS_ANA_SUBSCRIBERS	0
+#endif
+#if CONFIG_MI_USB_VENDOR_EN
+#define FRAME_BUS_USBV_SUBSCRIBERS	1
+#else
+#define FRAME_BUS_USBV_SUBSCRIBERS	0
+#endif
+#define FRAME_BUS_MAX_SUBSCRIBERS	(CONFIG_MI_TCP_MAX_CLIENTS + FRAME_BUS_WS_SUBSCRIBERS + FRAME_BUS_BLE_SUBSCRIBERS + FRAME_BUS_REC_SUBSCRIBERS + FRAME_BUS_LCD_SUBSCRIBERS + FRAME_BUS_ANA_SUBSCRIBERS + FRAME_BUS_USBV_SUBSCRIBERS + 2)		//One per stream client, WebSocket viewer, BLE stream, recorder, LCD live view, analytics task and USB vendor stream, USB and one spare
+#define FRAME_BUS_MAX_DEPTH			4									//Maximum mailbox depth. Must be a power of 2
+#define FRAME_BUS_BLOCK_MAX_MS		20									//Longest time the producer waits for a FRAME_POLICY_BLOCK mailbox
+#define FRAME_POOL_SLOTS			(1 + FRAME_BUS_MAX_SUBSCRIBERS * (FRAME_BUS_MAX_DEPTH + 1))
+
+#define FRAME_BUS_INVALID_ID		(-1)
+
+#define FPTAG						"[FRAME_BUS]"
+#define FP_INIT_INFO				"Frame bus initialised: %d slots, %d subscribers max."
+#define FP_SUB_INFO					"Subscriber %d (%s) added: depth %d, policy %d."
+#define FP_UNSUB_INFO				"Subscriber %d (%s) removed, %u frames dropped."
+#define FP_WARN_NO_SLOT				"No free frame slot, frame dropped."
+#define FP_ERR_SUB_FULL				"Cannot add subscriber %s: no free mailbox."
+
+/*
+ * Backpressure policy applied by the producer when a mailbox is full
+ */
+typedef enum framePolicy{
+	FRAME_POLICY_LATEST_ONLY = 0,			//Mailbox holds the newest frame only
+	FRAME_POLICY_DROP_OLDEST,				//Oldest queued frame is dropped
+	FRAME_POLICY_BLOCK						//Producer waits up to FRAME_BUS_BLOCK_MAX_MS, then drops the oldest
+}framePolicy_t;
+
+typedef int8_t frameSubscriber_t;
+
+// Counters of the whole bus, since boot
+typedef struct frameBusStats{
+	uint32_t mDropped;						//Frames dropped by full mailboxes, removed subscribers included
+	uint32_t mNoSlot;						//Captured frames not published because every slot was in use
+	uint8_t mSubscribers;					//Active subscribers
+	uint8_t mDeepest;						//Frames waiting in the fullest mailbox
+	uint8_t mSlotsUsed;						//Slots holding a frame
+}frameBusStats_t;
+
+void framePool_Init(void);
+
+frameSubscriber_t framePool_Subscribe(const char* name, const uint8_t depth, const framePolicy_t policy, TaskHandle_t task);
+
+void framePool_Unsubscribe(const frameSubscriber_t sub);
+
+senxorFrame* framePool_Alloc(void);
+
+void framePool_Publish(senxorFrame* frame);
+
+void framePool_PublishTo(senxorFrame* frame, const frameSubscriber_t sub);
+
+void framePool_SetWakeFd(const frameSubscriber_t sub, const int fd);
+
+senxorFrame* framePool_Receive(const frameSubscriber_t sub, const TickType_t timeout);
+
+senxorFrame* framePool_TryReceive(const frameSubscriber_t sub);
+
+void framePool_Release(senxorFrame* frame);
+
+uint32_t framePool_GetDropCount(const frameSubscriber_t sub);
+
+uint8_t framePool_GetSubscriberCount(void);
+
+void framePool_GetBusStats(frameBusStats_t* pStats);
+
+bool framePool_GetMailboxStats(const frameSubscriber_t sub, const char** pName, uint8_t* pQueued, uint8_t* pDepth, uint32_t* pDropped);
+
+#endif /* MAIN_INCLUDE_FRAMEPOOL_H_ */
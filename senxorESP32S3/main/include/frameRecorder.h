@@ -0,0 +1,110 @@
+/*****************************************************************************
+ * @file     frameRecorder.h
+ * @version  1.00
+ * @brief    Header file for frameRecorder.c
+ * @date	 14 Oct 2026
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_FRAMERECORDER_H_
+#define MAIN_INCLUDE_FRAMERECORDER_H_
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <sdkconfig.h>
+
+#include "framePool.h"
+#include "senxorTask.h"
+
+#define REC_TASK_STACK_SIZE			3072
+#define REC_WAIT_MS					100									//Longest sleep, trigger and arm requests are also notified
+#define REC_FRAME_PIXELS			(80 * 64)							//Pixels in senxorFrame.mFrame, header rows included
+#define REC_BUFFER_SIZE				(CONFIG_MI_REC_BUFFER_KB * 1024)	//PSRAM ring of records
+#define REC_PRE_TRIGGER_MS			(CONFIG_MI_REC_PRE_TRIGGER_S * 1000)
+#define REC_POST_TRIGGER_MS			(CONFIG_MI_REC_POST_TRIGGER_S * 1000)
+#define REC_HOLD_MS					(CONFIG_MI_REC_HOLD_S * 1000)		//Frozen clip kept this long, 0 until re-armed
+#define REC_KEYFRAME_INTERVAL		CONFIG_MI_REC_KEYFRAME_INTERVAL		//Longest run of delta records
+#define REC_ROI_NONE				0xFF								//No ROI trigger
+#define REC_NVS_KEY					"rectrig"
+
+#define REC_CLIP_MAGIC				0x43525853							//"SXRC" in little endian
+#define REC_CLIP_VERSION			1
+#define REC_FLAG_KEYFRAME			0x01								//Payload does not depend on the previous record
+#define REC_FLAG_TRIGGER			0x02								//First record after the trigger
+
+#define RECTAG						"[RECORDER]"
+#define REC_INFO_START				"Recording to a %u kB PSRAM ring, %d s before and %d s after a trigger."
+#define REC_INFO_TRIGGER			"Triggered by %s, recording %d s more."
+#define REC_INFO_FROZEN				"Clip frozen: %u frames, %u bytes."
+#define REC_INFO_ARMED				"Recorder armed."
+#define REC_INFO_ROI				"ROI trigger: slot %d at %u."
+#define REC_ERR_SUB					"Cannot subscribe to the frame bus, recorder stopped."
+
+typedef enum recState{
+	REC_STATE_RECORDING = 0,				//Armed, the ring holds the last frames
+	REC_STATE_TRIGGERED,					//Recording the frames after the trigger
+	REC_STATE_FROZEN						//Clip complete, ready for download
+}recState_t;
+
+typedef enum recTrigger{
+	REC_TRIGGER_NONE = 0,
+	REC_TRIGGER_COMMAND,					//RECC command
+	REC_TRIGGER_BLE,						//Write to the BLE stream control characteristic
+	REC_TRIGGER_ROI,						//ROI maximum reached the threshold
+	REC_TRIGGER_COUNT
+}recTrigger_t;
+
+/*
+ * Header of every record in the ring, followed by mLen payload bytes.
+ * All fields are little endian.
+ */
+typedef struct __attribute__((packed)) recRecord{
+	uint16_t mLen;							//Payload size in bytes
+	uint8_t mEncoding;						//tcpStreamEncoding_t of the payload
+	uint8_t mFlags;							//REC_FLAG_*
+	uint32_t mSeq;							//Capture sequence number
+	uint64_t mTimestampUs;					//Capture time in microseconds since boot
+}recRecord_t;
+
+/*
+ * First bytes of a downloaded clip, the records follow
+ */
+typedef struct __attribute__((packed)) recClipHeader{
+	uint32_t mMagic;						//REC_CLIP_MAGIC
+	uint8_t mVersion;						//REC_CLIP_VERSION
+	uint8_t mHeaderLen;						//Size of this header
+	uint8_t mWidth;							//Frame columns
+	uint8_t mHeight;						//Frame rows, header rows included
+	uint32_t mFrames;						//Records in the clip, the first one is a keyframe
+	uint32_t mTriggerSeq;					//Sequence number of the REC_FLAG_TRIGGER record
+	uint64_t mTriggerUs;					//Trigger time in microseconds since boot
+	uint8_t mTriggerSource;					//recTrigger_t
+	uint8_t mReserved[3];
+}recClipHeader_t;
+
+// ROI trigger, stored as one NVS blob
+typedef struct recRoiTrigger{
+	uint8_t mRoi;							//ROI slot, REC_ROI_NONE if off
+	uint8_t mReserved;
+	uint16_t mThreshold;					//Trigger when the ROI maximum reaches this, raw frame units
+}recRoiTrigger_t;
+
+void frameRecorderTask(void *pvParameters);
+
+bool frameRecorderGetIsRecording(void);
+
+void frameRecorderTrigger(const uint8_t source);
+
+void frameRecorderArm(void);
+
+bool frameRecorderSetRoiTrigger(const uint8_t idx, const uint16_t threshold);
+
+void frameRecorderGetStatus(uint8_t* pState, uint8_t* pTrigger, uint32_t* pFrames, uint32_t* pClipLen, uint8_t* pRoi, uint16_t* pThreshold);
+
+bool frameRecorderBeginDownload(void);
+
+void frameRecorderEndDownload(void);
+
+size_t frameRecorderGetClipSpan(const uint32_t offset, const uint8_t** ppData);
+
+#endif /* MAIN_INCLUDE_FRAMERECORDER_H_ */
@@ -0,0 +1,59 @@
+/*****************************************************************************
+ * @file     frameSnapshot.h
+ * @version  1.00
+ * @brief    Header file for frameSnapshot.c
+ * @date	 14 Oct 2026
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_FRAMESNAPSHOT_H_
+#define MAIN_INCLUDE_FRAMESNAPSHOT_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <sdkconfig.h>
+
+#define SNAP_URI					"/snapshot.bmp"
+#define SNAP_IMAGE_W				80
+#define SNAP_IMAGE_H				62									//Image rows, header rows removed
+#define SNAP_WAIT_MS				1500								//Longest wait for the next frame
+#define SNAP_DEMAND_HZ				5									//Capture rate while a request waits
+#define SNAP_CHUNK_LINES			8									//Bitmap lines per HTTP chunk
+#define SNAP_MAX_LINE				(SNAP_IMAGE_W * 4)					//Pixels of a line at the largest scale
+#define SNAP_MIN_SPAN				20									//Narrowest colour range in raw frame units
+
+#define SNAPTAG						"[SNAPSHOT]"
+#define SNAP_INFO_START				"Snapshots on " SNAP_URI ", scale %d, colour map %d."
+#define SNAP_ERR_REGISTER			"Cannot register %s: %s"
+#define SNAP_ERR_NO_FRAME			"No frame captured"
+#define SNAP_ERR_BUSY				"Snapshot in progress"
+
+/*
+ * BMP file and info header with RGB565 bit masks, 66 bytes.
+ * All fields are little endian.
+ */
+typedef struct __attribute__((packed)) snapBmpHeader{
+	uint16_t mType;							//"BM"
+	uint32_t mFileSize;
+	uint32_t mReserved;
+	uint32_t mDataOffset;					//Size of this header
+	uint32_t mInfoSize;						//40, BITMAPINFOHEADER
+	int32_t mWidth;
+	int32_t mHeight;						//Negative, lines are stored top down
+	uint16_t mPlanes;						//1
+	uint16_t mBitCount;						//16
+	uint32_t mCompression;					//3, BI_BITFIELDS
+	uint32_t mImageSize;
+	int32_t mXPelsPerMeter;
+	int32_t mYPelsPerMeter;
+	uint32_t mColoursUsed;
+	uint32_t mColoursImportant;
+	uint32_t mMask[3];						//Red, green and blue of colour565
+}snapBmpHeader_t;
+
+void frameSnapshotInit(void);
+
+void frameSnapshotOnFrame(const uint16_t* pImage);
+
+uint8_t frameSnapshotGetDemandHz(void);
+
+void frameSnapshotGetRange(const uint16_t* pImage, uint16_t* pMin, uint16_t* pMax);
+
+#endif /* MAIN_INCLUDE_FRAMESNAPSHOT_H_ */
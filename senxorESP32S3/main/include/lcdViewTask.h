@@ -0,0 +1,25 @@
+/*****************************************************************************
+ * @file     lcdViewTask.h
+ * @version  1.00
+ * @brief    Header file for lcdViewTask.c
+ * @date	 14 Oct 2026
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_LCDVIEWTASK_H_
+#define MAIN_INCLUDE_LCDVIEWTASK_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <sdkconfig.h>
+
+#define LCD_VIEW_STACK_SIZE			3072
+#define LCD_VIEW_WAIT_MS			500									//Longest wait for a frame
+#define LCD_VIEW_RANGE_SHIFT		2									//Colour range follows the frame range by 1/4 per frame
+#define LCD_VIEW_MIN_SPAN			20									//Narrowest colour range in raw frame units, keeps noise dark
+#define LCD_VIEW_REFRESH_FRAMES		128									//Every tile is redrawn this often, heals text drawn over the image
+
+void lcdViewTask(void *pvParameters);
+
+bool lcdViewGetIsActive(void);
+
+#endif /* MAIN_INCLUDE_LCDVIEWTASK_H_ */
@@ -0,0 +1,54 @@
+/*****************************************************************************
+ * @file     linkAdapt.h
+ * @version  1.00
+ * @brief    Header file for linkAdapt.c
+ * @date	 15 Oct 2026
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_LINKADAPT_H_
+#define MAIN_INCLUDE_LINKADAPT_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <sdkconfig.h>
+
+#define LINK_ADAPT_PERIOD_MS		1000								//Controller period
+#define LINK_UP_PERIODS				5									//Calm periods in a row before a step up
+#define LINK_CALM_PCT				50									//Latency below this share of the target is calm
+#define LINK_BLOCKED_PCT			50									//Share of a period spent blocked that is congestion
+#define LINK_RSSI_NONE				0									//No signal reading, not associated
+#if CONFIG_MI_LINK_ADAPT_DECIMATE
+#define LINK_LEVEL_COUNT			5
+#else
+#define LINK_LEVEL_COUNT			4
+#endif
+
+#define LINKTAG						"[LINK]"
+#define LINK_INFO_LEVEL				"Client %s: level %d, latency %lu ms, blocked %d%%, RSSI %d dBm."
+
+// Stream mode of one level, applied on top of the SFMT and SHAP settings
+typedef struct linkMode{
+	bool mCompress;							//Raw and delta v2 payloads are sent TCP_STREAM_ENC_DELTA_LZ
+	uint8_t mRateDiv;						//Multiplies the SHAP rate divisor
+	uint8_t mDecimation;					//Smallest decimation of v2 payloads
+}linkMode_t;
+
+// Controller state of one stream client
+typedef struct linkAdapt{
+	uint8_t mLevel;							//Index into the mode ladder, 0 = as requested
+	uint8_t mCalmPeriods;					//Calm periods in a row
+	uint32_t mFrames;						//Frames completed in this period
+	uint64_t mLatencySumUs;					//Capture to send completion, summed over mFrames
+	uint64_t mBlockedUs;					//Blocked time of the client at the start of the period
+	int64_t mPeriodStartUs;
+}linkAdapt_t;
+
+void linkAdapt_Reset(linkAdapt_t* pLink, const uint64_t blockedUs);
+
+void linkAdapt_FrameSent(linkAdapt_t* pLink, const int64_t latencyUs);
+
+bool linkAdapt_Update(linkAdapt_t* pLink, const uint64_t blockedUs, const int64_t pendingUs, const int8_t rssi, const char* pName);
+
+const linkMode_t* linkAdapt_GetMode(const linkAdapt_t* pLink);
+
+int8_t linkAdapt_GetRssi(void);
+
+#endif /* MAIN_INCLUDE_LINKADAPT_H_ */
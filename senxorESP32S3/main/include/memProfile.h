@@ -0,0 +1,36 @@
+/*****************************************************************************
+ * @file     memProfile.h
+ * @version  1.00
+ * @brief    Memory placement of the frame path buffers
+ * @date	 14 Oct 2026
+ * @details	 Internal .bss is DMA capable and uncached, PSRAM goes through
+ * 			 the 32 kB data cache shared with flash. Buffers touched by every
+ * 			 frame use MEM_HOT_ATTR, history and bulk tables stay in PSRAM.
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_MEMPROFILE_H_
+#define MAIN_INCLUDE_MEMPROFILE_H_
+#include <esp_attr.h>
+#include <sdkconfig.h>
+
+#if CONFIG_MI_MEM_PROFILE_PSRAM
+#define MEM_HOT_ATTR				EXT_RAM_BSS_ATTR					//Current frames, TX staging, capture and stream task stacks
+#define MEM_CALIB_ATTR				EXT_RAM_BSS_ATTR					//Calibration data, read by every frame
+#define MEM_FAST_FRAME_SLOTS		0
+#define MEM_PROFILE_NAME			"psram"
+#elif CONFIG_MI_MEM_PROFILE_INTERNAL
+#define MEM_HOT_ATTR
+#define MEM_CALIB_ATTR
+#define MEM_FAST_FRAME_SLOTS		CONFIG_MI_MEM_FAST_FRAME_SLOTS
+#define MEM_PROFILE_NAME			"internal"
+#else
+#define MEM_HOT_ATTR
+#define MEM_CALIB_ATTR				EXT_RAM_BSS_ATTR
+#define MEM_FAST_FRAME_SLOTS		CONFIG_MI_MEM_FAST_FRAME_SLOTS
+#define MEM_PROFILE_NAME			"balanced"
+#endif
+
+#define MEMTAG						"[MEM_PROFILE]"
+#define MEM_INFO_PROFILE			"Placement profile %s, %d frame slots in internal RAM."
+#define MEM_INFO_HEAP				"%s free %u bytes, largest block %u, lowest %u."
+
+#endif /* MAIN_INCLUDE_MEMPROFILE_H_ */
@@ -0,0 +1,42 @@
+/*****************************************************************************
+ * @file     microBench.h
+ * @version  1.00
+ * @brief    Header file for microBench.c
+ * @date	 14 Oct 2026
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_MICROBENCH_H_
+#define MAIN_INCLUDE_MICROBENCH_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <sdkconfig.h>
+
+#define BENCH_FRAME_BYTES			(80 * 64 * 2)						//10 kB frame with its header rows, as the frame pool holds it
+#define BENCH_RUN_US				50000								//Time every test runs for
+#define BENCH_BATCH					8									//Iterations between two looks at the clock
+#define BENCH_SPI_REG				0xB1								//Capture state, read only by the benchmark
+#define BENCH_TCP_CHUNK				1024								//Bytes per loopback send
+#define BENCH_TCP_TIMEOUT_MS		500
+
+#define BENCHTAG					"[BENCH]"
+#define BENCH_INFO_RESULT			"Test %d: %lu iterations, %lu cycles each, %lu bytes/s."
+#define BENCH_ERR_ALLOC				"Test %d: no %s buffer."
+#define BENCH_ERR_SOCKET			"Loopback socket failed: errno %d"
+
+// Tests of BNCH, the numbers are part of the protocol
+typedef enum benchTest{
+	BENCH_SPI_REG_READ = 0,					//SenXor register read, the path RREG takes
+	BENCH_MEMCPY_SRAM,						//Frame copy, internal RAM to internal RAM
+	BENCH_MEMCPY_PSRAM,						//Frame copy, PSRAM to PSRAM
+	BENCH_MEMCPY_PSRAM_SRAM,				//Frame copy, PSRAM to internal RAM
+	BENCH_QUADRANT_SCALAR,					//quadrantMax_Scalar on a frame
+	BENCH_QUADRANT_SIMD,					//quadrantMax_Simd on a frame
+	BENCH_CRC_SUM16,						//getCRC over a frame
+	BENCH_CRC16,							//getCRC16 over a frame
+	BENCH_CRC32,							//ROM CRC-32 over a frame
+	BENCH_TCP_LOOPBACK,						//lwIP send and receive over 127.0.0.1
+	BENCH_TEST_COUNT
+}benchTest_t;
+
+bool microBench_Run(const uint8_t test, uint32_t* pIterations, uint32_t* pCycles, uint32_t* pBytesPerSec);
+
+#endif /* MAIN_INCLUDE_MICROBENCH_H_ */
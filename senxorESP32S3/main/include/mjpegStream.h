@@ -0,0 +1,57 @@
+/*****************************************************************************
+ * @file     mjpegStream.h
+ * @version  1.00
+ * @brief    Header file for mjpegStream.c
+ * @date	 14 Oct 2026
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_MJPEGSTREAM_H_
+#define MAIN_INCLUDE_MJPEGSTREAM_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <esp_http_server.h>
+#include <sdkconfig.h>
+
+#include "frameSnapshot.h"
+
+#define MJPEG_SNAP_URI				"/snapshot.jpg"
+#define MJPEG_STREAM_URI			"/mjpeg"
+#define MJPEG_STACK_SIZE			4096
+#define MJPEG_MAX_CLIENTS			CONFIG_MI_SNAP_MJPEG_MAX_CLIENTS
+#define MJPEG_MAX_WAITING			2									//Snapshot requests waiting for the next encode
+#define MJPEG_QUEUE_LEN				(MJPEG_MAX_CLIENTS + MJPEG_MAX_WAITING)
+#define MJPEG_FPS					CONFIG_MI_SNAP_MJPEG_FPS
+#define MJPEG_PERIOD_US				(1000000 / MJPEG_FPS)
+#define MJPEG_WAIT_MS				100									//Longest sleep between two checks of waiting requests
+#define MJPEG_SCALE					CONFIG_MI_SNAP_SCALE				//One encode serves every client, so one size too
+#define MJPEG_W						(SNAP_IMAGE_W * MJPEG_SCALE)
+#define MJPEG_H						(SNAP_IMAGE_H * MJPEG_SCALE)
+#define MJPEG_OUT_SIZE				(MJPEG_W * MJPEG_H * 2)				//Size of the RGB565 image, far above any quality short of 100
+#define MJPEG_BOUNDARY				"sxframe"
+#define MJPEG_PART_MAX				96									//Part header of the multipart stream
+
+#define MJPEGTAG					"[MJPEG]"
+#define MJPEG_INFO_START			"JPEG on " MJPEG_SNAP_URI " and " MJPEG_STREAM_URI ", %d x %d, quality %d, %d fps."
+#define MJPEG_INFO_JOIN				"Viewer joined (fd %d), %d watching."
+#define MJPEG_INFO_LEFT				"Viewer left (fd %d), %u frames sent."
+#define MJPEG_WARN_SIZE				"Frame of quality %d does not fit %d bytes, dropped."
+#define MJPEG_ERR_NO_SERVER			"REST server not running, JPEG snapshots disabled."
+#define MJPEG_ERR_REGISTER			"Cannot register %s: %s"
+#define MJPEG_ERR_FULL				"Too many viewers"
+
+/*
+ * Request handed from the httpd task to mjpegStreamTask
+ */
+typedef struct mjpegClient{
+	httpd_req_t* pReq;						//Async copy, NULL if the entry is free
+	int64_t mSinceUs;						//Time the request arrived
+	uint32_t mFramesSent;
+	bool mIsStream;							//MJPEG_STREAM_URI, else a single snapshot
+}mjpegClient_t;
+
+void mjpegStreamTask(void *pvParameters);
+
+void mjpegOnFrame(const uint16_t* pImage);
+
+uint8_t mjpegGetDemandHz(void);
+
+#endif /* MAIN_INCLUDE_MJPEGSTREAM_H_ */
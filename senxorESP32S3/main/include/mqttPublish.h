@@ -0,0 +1,91 @@
+/*****************************************************************************
+ * @file     mqttPublish.h
+ * @version  1.01
+ * @brief    Header file for mqttPublish.c
+ * @date	 15 Oct 2026
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_MQTTPUBLISH_H_
+#define MAIN_INCLUDE_MQTTPUBLISH_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <sdkconfig.h>
+
+#include "roiEngine.h"
+
+#define MQTT_STACK_SIZE				3072
+#define MQTT_WAIT_MS				1000								//Longest sleep, rule events and batches wake the task
+#define MQTT_SAMPLE_PERIOD_MS		CONFIG_MI_MQTT_SAMPLE_MS
+#define MQTT_BATCH_WINDOW_MS		(CONFIG_MI_MQTT_BATCH_S * 1000)
+#define MQTT_QUEUE_LEN				CONFIG_MI_MQTT_QUEUE_LEN			//Batch slots, closed batches wait in them for the broker
+#define MQTT_BATCH_MAX				2048								//Bytes of one batch message
+#define MQTT_DEMAND_HZ				((1000 + MQTT_SAMPLE_PERIOD_MS - 1) / MQTT_SAMPLE_PERIOD_MS)
+#define MQTT_TOPIC_MAX				64
+#define MQTT_VERSION				2									//First byte of every message
+
+#define MQTT_TOPIC_ROI				"roi"
+#define MQTT_TOPIC_EVENTS			"events"
+#define MQTT_TOPIC_STATUS			"status"
+#define MQTT_STATUS_ONLINE			"online"
+#define MQTT_STATUS_OFFLINE			"offline"
+#define MQTT_ROI_FRAME				0xFF								//mqttRoiEntry_t of the whole image
+
+#define MQTTTAG						"[MQTT]"
+#define MQTT_INFO_START				"Publishing to %s as %s/%s, QoS %d."
+#define MQTT_INFO_CONNECTED			"Connected, %u batches waiting."
+#define MQTT_INFO_DISCONNECTED		"Disconnected, %lu batches dropped so far."
+#define MQTT_ERR_INIT				"Cannot start the MQTT client."
+#define MQTT_ERR_NO_BROKER			"No broker URI set, MQTT stopped."
+
+/*
+ * First bytes of a ROI message, the samples follow. Each sample is a
+ * mqttSample_t and mCount mqttRoiEntry_t. All fields are little endian.
+ */
+typedef struct __attribute__((packed)) mqttBatchHeader{
+	uint8_t mVersion;						//MQTT_VERSION
+	uint8_t mSamples;						//Samples in the message
+	uint16_t mPeriodMs;						//MQTT_SAMPLE_PERIOD_MS
+	uint32_t mUptimeMs;						//Time of the first sample since boot
+	uint32_t mSeq;							//Capture sequence number of the first sample
+	uint64_t mUtcMs;						//mUptimeMs in ms since 1970, 0 before the clock is synchronised
+}mqttBatchHeader_t;
+
+typedef struct __attribute__((packed)) mqttSample{
+	uint16_t mOffsetMs;						//Time after the first sample
+	uint8_t mCount;							//Entries that follow
+}mqttSample_t;
+
+// One used ROI slot, or MQTT_ROI_FRAME
+typedef struct __attribute__((packed)) mqttRoiEntry{
+	uint8_t mRoi;
+	uint16_t mMin;
+	uint16_t mMax;
+	uint16_t mMean;
+	uint16_t mPercentile;					//ROI percentile, p99 of the whole image
+}mqttRoiEntry_t;
+
+// Largest sample, every ROI slot and the whole image
+#define MQTT_SAMPLE_MAX				(sizeof(mqttSample_t) + (ROI_MAX_COUNT + 1) * sizeof(mqttRoiEntry_t))
+
+/*
+ * Event message: MQTT_VERSION, a count byte, then count entries.
+ * Every event that arrived since the last message.
+ */
+typedef struct __attribute__((packed)) mqttEventEntry{
+	uint8_t mRule;							//Rule slot
+	uint8_t mRaised;						//1 raised, 0 cleared
+	uint16_t mValue;						//Metric value that changed the state
+	uint8_t mActive;						//Register 0xF7 after the event
+	uint32_t mSeq;							//Capture sequence number of the frame
+}mqttEventEntry_t;
+
+void mqttPublishTask(void *pvParameters);
+
+void mqttPublishOnFrame(const uint32_t seq);
+
+void mqttPublishNotifyRule(void);
+
+uint8_t mqttPublishGetDemandHz(void);
+
+#endif /* MAIN_INCLUDE_MQTTPUBLISH_H_ */
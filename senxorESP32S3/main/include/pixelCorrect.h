@@ -0,0 +1,79 @@
+/*****************************************************************************
+ * @file     pixelCorrect.h
+ * @version  1.00
+ * @brief    Header file for pixelCorrect.c
+ * @date	 15 Oct 2026
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_PIXELCORRECT_H_
+#define MAIN_INCLUDE_PIXELCORRECT_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <sdkconfig.h>
+
+#include "Customer_Interface.h"										//convCorr_t
+
+#define PIXCORR_WIDTH				80
+#define PIXCORR_HEIGHT				62									//Image rows, header rows removed
+#define PIXCORR_PIXELS				(PIXCORR_WIDTH * PIXCORR_HEIGHT)
+#define PIXCORR_ENTRY_SIZE			4									//Gain and offset, 16-bit little endian each
+#define PIXCORR_MAX_CHUNK			120									//Pixels in one CORR write, fits the 512 byte data field
+#define PIXCORR_MAX_RUNS			512									//Runs of equal pixels the NVS record holds
+#define PIXCORR_NVS_KEY				"pixcorr"
+#define PIXCORR_VERSION				1
+
+#define PIXCORRTAG					"[PIXEL_CORR]"
+#define PIXCORR_INFO_INIT			"Correction map loaded, %d runs."
+#define PIXCORR_INFO_SWAP			"Correction map %s."
+#define PIXCORR_WARN_RUNS			"Correction map of %d runs applied but not saved, at most %d fit NVS."
+
+// CORR operations
+typedef enum pixCorrOp{
+	PIXCORR_OP_STATUS = 0,
+	PIXCORR_OP_WRITE,						//Pixels into the upload buffer
+	PIXCORR_OP_COMMIT,						//Upload buffer in use from the next frame, and saved
+	PIXCORR_OP_CLEAR						//No correction from the next frame
+}pixCorrOp_t;
+
+// CORR status
+typedef enum pixCorrStatus{
+	PIXCORR_STATUS_OK = 0,
+	PIXCORR_STATUS_BAD_LEN,
+	PIXCORR_STATUS_BAD_CRC,
+	PIXCORR_STATUS_BAD_RANGE,				//Pixels past the image, or an unknown operation
+	PIXCORR_STATUS_BUSY						//The last commit is not applied and saved yet
+}pixCorrStatus_t;
+
+// State reported by CORR
+typedef enum pixCorrState{
+	PIXCORR_STATE_OFF = 0,					//No pixel corrected
+	PIXCORR_STATE_ON,
+	PIXCORR_STATE_PENDING					//A commit waits for the next frame
+}pixCorrState_t;
+
+// One run of pixels with the same correction, in image order
+typedef struct pixCorrRun{
+	uint16_t mLength;
+	convCorr_t mCorr;
+}pixCorrRun_t;
+
+// Correction map, stored as one NVS blob
+typedef struct pixCorrStore{
+	uint8_t mVersion;						//PIXCORR_VERSION
+	uint8_t mReserved;
+	uint16_t mRuns;							//Entries used in mRun, 0 for no correction
+	pixCorrRun_t mRun[PIXCORR_MAX_RUNS];
+}pixCorrStore_t;
+
+void pixelCorrect_Init(void);
+
+void pixelCorrect_Update(void);
+
+uint8_t pixelCorrect_Write(const uint16_t start, const uint8_t count, const uint8_t* pEntry);
+
+uint8_t pixelCorrect_Commit(void);
+
+uint8_t pixelCorrect_Clear(void);
+
+void pixelCorrect_GetStatus(uint8_t* pState, bool* pSaved, uint16_t* pWritten);
+
+#endif /* MAIN_INCLUDE_PIXELCORRECT_H_ */
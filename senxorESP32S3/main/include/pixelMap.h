@@ -0,0 +1,68 @@
+/*****************************************************************************
+ * @file     pixelMap.h
+ * @version  1.00
+ * @brief    Header file for pixelMap.c
+ * @date	 14 Oct 2026
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_PIXELMAP_H_
+#define MAIN_INCLUDE_PIXELMAP_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <sdkconfig.h>
+
+#include "Customer_Interface.h"										//pixPatch_t
+
+#define PIXMAP_WIDTH				80
+#define PIXMAP_HEIGHT				62									//Image rows, header rows removed
+#define PIXMAP_PIXELS				(PIXMAP_WIDTH * PIXMAP_HEIGHT)
+#define PIXMAP_MASK_BYTES			((PIXMAP_PIXELS + 7) / 8)
+#define PIXMAP_MAX_BAD				64									//More than this and the scene was not uniform
+#define PIXMAP_SEARCH_RADIUS		3									//Furthest good pixel taken as a replacement
+#define PIXMAP_CAL_FRAMES			CONFIG_MI_PIXMAP_CAL_FRAMES			//Frames averaged by a calibration
+#define PIXMAP_DEFAULT_THRESHOLD	CONFIG_MI_PIXMAP_THRESHOLD			//Raw frame units
+#define PIXMAP_DEMAND_HZ			5									//Capture rate while calibrating
+#define PIXMAP_NVS_KEY				"badpix"
+#define PIXMAP_VERSION				1
+
+#define PIXMAPTAG					"[PIXEL_MAP]"
+#define PIXMAP_INFO_INIT			"%d bad pixels loaded."
+#define PIXMAP_INFO_CAL				"Calibrating over %d frames, threshold %d."
+#define PIXMAP_INFO_DONE			"Calibration done: %d bad pixels, %d without a replacement."
+#define PIXMAP_INFO_CLEAR			"Bad pixel map cleared."
+#define PIXMAP_ERR_TOO_MANY			"Calibration rejected: %d bad pixels, is the scene uniform?"
+
+// BPIX modes
+typedef enum pixMapMode{
+	PIXMAP_MODE_STATUS = 0,
+	PIXMAP_MODE_CALIBRATE,
+	PIXMAP_MODE_CLEAR
+}pixMapMode_t;
+
+// State reported by BPIX
+typedef enum pixMapState{
+	PIXMAP_STATE_IDLE = 0,
+	PIXMAP_STATE_CALIBRATING,
+	PIXMAP_STATE_REJECTED					//Last calibration found more than PIXMAP_MAX_BAD, the map was kept
+}pixMapState_t;
+
+// Bad pixel map, stored as one NVS blob
+typedef struct pixMapStore{
+	uint8_t mVersion;						//PIXMAP_VERSION
+	uint8_t mReserved;
+	uint16_t mCount;						//Bits set in mMask
+	uint8_t mMask[PIXMAP_MASK_BYTES];		//Bit i % 8 of byte i / 8 set if image pixel i is bad
+}pixMapStore_t;
+
+void pixelMap_Init(void);
+
+void pixelMap_Process(uint16_t* pImage);
+
+bool pixelMap_Calibrate(const uint16_t threshold);
+
+void pixelMap_Clear(void);
+
+void pixelMap_GetStatus(uint8_t* pState, uint16_t* pCount);
+
+uint8_t pixelMap_GetDemandHz(void);
+
+#endif /* MAIN_INCLUDE_PIXELMAP_H_ */
@@ -0,0 +1,63 @@
+/*****************************************************************************
+ * @file     quadrantMax.h
+ * @version  1.00
+ * @brief    Header file for quadrantMax.c
+ * @date	 14 Oct 2026
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_QUADRANTMAX_H_
+#define MAIN_INCLUDE_QUADRANTMAX_H_
+#include <stdint.h>
+#include <sdkconfig.h>
+
+#define QUADRANT_MAX_LANES			8									//u16 lanes of a 128 bit PIE register
+#define QUADRANT_BENCH_RUNS			100									//Frames timed per path by quadrantMax_Benchmark
+
+#define QMTAG						"[QUADRANT]"
+#define QM_BENCH_INFO				"Split %d/%d: scalar %lu cycles/frame, SIMD %lu cycles/frame, results %s."
+
+// Quadrant analysis data structure
+typedef struct quadrantData {
+	uint16_t Amax;      // Max value in quadrant A (top-left)
+	uint16_t Acenter;   // Center pixel value in quadrant A
+	uint16_t Bmax;      // Max value in quadrant B (top-right)
+	uint16_t Bcenter;   // Center pixel value in quadrant B
+	uint16_t Cmax;      // Max value in quadrant C (bottom-left)
+	uint16_t Ccenter;   // Center pixel value in quadrant C
+	uint16_t Dmax;      // Max value in quadrant D (bottom-right)
+	uint16_t Dcenter;   // Center pixel value in quadrant D
+	uint8_t Xsplit;     // X split point (0-80)
+	uint8_t Ysplit;     // Y split point (0-62)
+	// Burner coordinates (absolute image coordinates)
+	uint8_t Aburnerx;   // Burner X in quadrant A
+	uint8_t Aburnery;   // Burner Y in quadrant A
+	uint16_t Aburnert;  // Temperature at burner in quadrant A
+	uint8_t Bburnerx;   // Burner X in quadrant B
+	uint8_t Bburnery;   // Burner Y in quadrant B
+	uint16_t Bburnert;  // Temperature at burner in quadrant B
+	uint8_t Cburnerx;   // Burner X in quadrant C
+	uint8_t Cburnery;   // Burner Y in quadrant C
+	uint16_t Cburnert;  // Temperature at burner in quadrant C
+	uint8_t Dburnerx;   // Burner X in quadrant D
+	uint8_t Dburnery;   // Burner Y in quadrant D
+	uint16_t Dburnert;  // Temperature at burner in quadrant D
+} quadrantData_t;
+
+/*
+ * Maxima of the 4 quadrants, pMax[0..3] = A, B, C, D.
+ * pImage points at the first image row, rows are SENXOR_FRAME_WIDTH pixels apart.
+ */
+void quadrantMax_Scalar(const uint16_t* pImage, const uint8_t xsplit, const uint8_t ysplit, uint16_t pMax[4]);
+
+void quadrantMax_Simd(const uint16_t* pImage, const uint8_t xsplit, const uint8_t ysplit, uint16_t pMax[4]);
+
+/*
+ * Maxima, center and burner temperatures of the quadrants of pData->Xsplit
+ * and pData->Ysplit, written to pData.
+ */
+void quadrantMax_Calculate(const uint16_t* pImage, quadrantData_t* pData);
+
+#if CONFIG_MI_QUADRANT_BENCH
+void quadrantMax_Benchmark(const uint16_t* pImage, const uint8_t xsplit, const uint8_t ysplit);
+#endif
+
+#endif /* MAIN_INCLUDE_QUADRANTMAX_H_ */
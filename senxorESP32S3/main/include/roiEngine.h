@@ -0,0 +1,87 @@
+/*****************************************************************************
+ * @file     roiEngine.h
+ * @version  1.00
+ * @brief    Header file for roiEngine.c
+ * @date	 14 Oct 2026
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_ROIENGINE_H_
+#define MAIN_INCLUDE_ROIENGINE_H_
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ROI_MAX_COUNT				16									//ROI slots in the table
+#define ROI_MAX_VERTICES			8									//Polygon vertices per ROI
+#define ROI_HIST_BINS				64									//Histogram bins per ROI for the percentile
+#define ROI_LABEL_NONE				0xFF								//Pixel outside every ROI
+#define ROI_TABLE_VERSION			1									//Layout version of the NVS blob
+#define ROI_NVS_KEY					"roitable"
+#define ROI_DEFAULT_PERCENTILE		95
+
+// ROI shapes
+#define ROI_TYPE_NONE				0x00								//Unused slot
+#define ROI_TYPE_RECT				0x01								//Vertex 0 and 1 are opposite corner pixels, both included
+#define ROI_TYPE_POLYGON			0x02								//3 or more vertices on the pixel grid corners
+
+// ROI register window, the ROI selected by REG_ROI_SEL is read through 0xEA-0xF0
+#define REG_ROI_COUNT				0xE8								//Number of defined ROIs (R)
+#define REG_ROI_SEL					0xE9								//Selected ROI slot (R/W)
+#define REG_ROI_MIN					0xEA								//Minimum (R, 16-bit)
+#define REG_ROI_MAX					0xEB								//Maximum (R, 16-bit)
+#define REG_ROI_MEAN				0xEC								//Mean (R, 16-bit)
+#define REG_ROI_PCT					0xED								//Percentile value (R, 16-bit)
+#define REG_ROI_HOTX				0xEE								//Hot spot column (R)
+#define REG_ROI_HOTY				0xEF								//Hot spot row (R)
+#define REG_ROI_PIXELS				0xF0								//Pixels in the ROI (R, 16-bit)
+#define REG_ROI_FIRST				REG_ROI_COUNT
+#define REG_ROI_LAST				REG_ROI_PIXELS
+
+#define ROITAG						"[ROI]"
+#define ROI_INIT_INFO				"%d ROIs loaded, %d pixels labelled."
+#define ROI_SET_INFO				"ROI %d set: type %d, percentile %d, %d vertices, %d pixels."
+#define ROI_ERR_DEF					"ROI %d rejected: invalid definition."
+
+/*
+ * One ROI of the table. Overlapping ROIs are allowed, a pixel belongs to the
+ * ROI with the lowest slot index.
+ */
+typedef struct roiDef{
+	uint8_t mType;										//ROI_TYPE_*
+	uint8_t mPercentile;								//Percentile to report, 1-100
+	uint8_t mVertexCount;								//2 for a rectangle, 3-ROI_MAX_VERTICES for a polygon
+	uint8_t mVertex[ROI_MAX_VERTICES][2];				//x, y
+}roiDef_t;
+
+// ROI table, stored as one NVS blob
+typedef struct roiTable{
+	uint8_t mVersion;									//ROI_TABLE_VERSION
+	roiDef_t mRoi[ROI_MAX_COUNT];
+}roiTable_t;
+
+// Results of one ROI for the last frame
+typedef struct roiStats{
+	uint16_t mMin;
+	uint16_t mMax;
+	uint16_t mMean;
+	uint16_t mPercentile;								//Value at roiDef_t.mPercentile, resolution of one histogram bin
+	uint8_t mHotX;										//Position of the maximum
+	uint8_t mHotY;
+	uint16_t mPixels;									//0 if the ROI is unused or empty
+}roiStats_t;
+
+void roiEngine_Init(void);
+
+bool roiEngine_SetRoi(const uint8_t idx, const uint8_t type, const uint8_t percentile, const uint8_t vertexCount, const uint8_t* pVertex);
+
+void roiEngine_Process(const uint16_t* pImage);
+
+bool roiEngine_GetStats(const uint8_t idx, roiStats_t* pStats);
+
+bool roiEngine_GetBounds(const uint8_t idx, uint8_t* pX, uint8_t* pY, uint8_t* pWidth, uint8_t* pHeight);
+
+uint16_t roiEngine_ReadStat(const uint8_t idx, const uint8_t regAddr);
+
+uint16_t roiEngine_ReadRegister(const uint8_t regAddr);
+
+void roiEngine_WriteRegister(const uint8_t regAddr, const uint8_t value);
+
+#endif /* MAIN_INCLUDE_ROIENGINE_H_ */
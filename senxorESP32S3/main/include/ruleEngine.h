@@ -0,0 +1,83 @@
+/*****************************************************************************
+ * @file     ruleEngine.h
+ * @version  1.00
+ * @brief    Header file for ruleEngine.c
+ * @date	 15 Oct 2026
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_RULEENGINE_H_
+#define MAIN_INCLUDE_RULEENGINE_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <sdkconfig.h>
+
+#define RULE_MAX_COUNT				8									//Rule slots in the table, one bit each in REG_RULE_ACTIVE
+#define RULE_EVENT_RING				16									//Events a slow reader can fall behind by
+#define RULE_TABLE_VERSION			1									//Layout version of the NVS blob
+#define RULE_NVS_KEY				"ruletable"
+#define RULE_LED_FLASH_MS			250									//Flash interval of the LED of an active rule
+
+// Metrics a rule watches, the numbers are part of the protocol
+#define RULE_METRIC_NONE			0x00								//Unused slot
+#define RULE_METRIC_ROI_MIN			0x01								//mSource is a ROI slot
+#define RULE_METRIC_ROI_MAX			0x02
+#define RULE_METRIC_ROI_MEAN		0x03
+#define RULE_METRIC_ROI_PCT			0x04
+#define RULE_METRIC_REGISTER		0x05								//mSource is a firmware register, 0xC0-0xDF, 0xF1-0xF6 or 0xFA-0xFD
+#define RULE_METRIC_COUNT			0x06
+
+// Comparators
+#define RULE_CMP_ABOVE				0x00								//Raised above the threshold, cleared at or below threshold - hysteresis
+#define RULE_CMP_BELOW				0x01								//Raised below the threshold, cleared at or above threshold + hysteresis
+
+// Rule registers
+#define REG_RULE_ACTIVE				0xF7								//Bit n set while rule n is raised (R)
+
+#define RULETAG						"[RULE]"
+#define RULE_INFO_INIT				"%d rules loaded."
+#define RULE_INFO_SET				"Rule %d set: metric %d, source 0x%02X, compare %d, threshold %u, hysteresis %u, dwell %u00 ms."
+#define RULE_INFO_EVENT				"Rule %d %s at %u."
+#define RULE_ERR_DEF				"Rule %d rejected: invalid definition."
+
+// One rule of the table
+typedef struct __attribute__((packed)) ruleDef{
+	uint8_t mMetric;						//RULE_METRIC_*
+	uint8_t mSource;						//ROI slot or register address
+	uint8_t mCompare;						//RULE_CMP_*
+	uint8_t mLed;							//ledColour shown while raised, 0 = none
+	uint16_t mThreshold;					//Raw frame units, or register value
+	uint16_t mHysteresis;					//Margin back past the threshold that clears the rule
+	uint16_t mDwell;						//Time the condition must hold before the rule is raised, 100 ms units
+}ruleDef_t;
+
+// Rule table, stored as one NVS blob
+typedef struct ruleTable{
+	uint8_t mVersion;						//RULE_TABLE_VERSION
+	ruleDef_t mRule[RULE_MAX_COUNT];
+}ruleTable_t;
+
+// A rule raised or cleared
+typedef struct ruleEvent{
+	uint32_t mSeq;							//Capture sequence number of the frame
+	uint8_t mRule;							//Rule slot
+	bool mRaised;							//true raised, false cleared
+	uint8_t mActive;						//REG_RULE_ACTIVE after the event
+	uint16_t mValue;						//Metric value that changed the state
+}ruleEvent_t;
+
+void ruleEngine_Init(void);
+
+bool ruleEngine_Process(const uint32_t seq);
+
+bool ruleEngine_SetRule(const uint8_t idx, const uint8_t metric, const uint8_t source, const uint8_t compare, const uint8_t led,
+		const uint16_t threshold, const uint16_t hysteresis, const uint16_t dwell);
+
+bool ruleEngine_GetRule(const uint8_t idx, uint8_t* pMetric, uint8_t* pSource, uint8_t* pCompare, uint8_t* pLed,
+		uint16_t* pThreshold, uint16_t* pHysteresis, uint16_t* pDwell, uint8_t* pRaised, uint16_t* pValue);
+
+uint8_t ruleEngine_GetActive(void);
+
+uint32_t ruleEngine_GetEventCount(void);
+
+bool ruleEngine_GetEvent(uint32_t* pCursor, ruleEvent_t* pEvent);
+
+#endif /* MAIN_INCLUDE_RULEENGINE_H_ */
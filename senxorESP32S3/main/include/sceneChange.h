@@ -0,0 +1,65 @@
+/*****************************************************************************
+ * @file     sceneChange.h
+ * @version  1.00
+ * @brief    Header file for sceneChange.c
+ * @date	 15 Oct 2026
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_SCENECHANGE_H_
+#define MAIN_INCLUDE_SCENECHANGE_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <sdkconfig.h>
+
+#define SCENE_WIDTH					80
+#define SCENE_HEIGHT				62									//Image rows, header rows removed
+#define SCENE_PIXELS				(SCENE_WIDTH * SCENE_HEIGHT)
+#define SCENE_MEAN_FRAC_BITS		8									//Fraction bits of the background mean
+#define SCENE_DEV_FRAC_BITS			4									//Fraction bits of the background deviation
+#define SCENE_ABSORB_SHIFT			4									//A changed pixel joins the background 16 times slower
+#if CONFIG_MI_SCENE_EN
+#define SCENE_LEARN_SHIFT			CONFIG_MI_SCENE_LEARN_SHIFT			//Background follows the scene over 2^n frames
+#define SCENE_DEV_K					CONFIG_MI_SCENE_DEV_K				//Deviations a pixel must move to count as changed
+#define SCENE_DEFAULT_MODE			CONFIG_MI_SCENE_MODE_VAL
+#define SCENE_DEFAULT_DELTA			CONFIG_MI_SCENE_DELTA
+#define SCENE_DEFAULT_PIXELS		CONFIG_MI_SCENE_PIXELS
+#define SCENE_DEFAULT_HEARTBEAT		CONFIG_MI_SCENE_HEARTBEAT
+#endif
+
+// Scene change registers
+#define REG_SCENE_MODE				0xD9								//sceneMode_t (R/W)
+#define REG_SCENE_DELTA				0xDA								//Smallest change of a pixel, raw frame units (R/W)
+#define REG_SCENE_PIXELS			0xDB								//Changed pixels that let a frame through (R/W)
+#define REG_SCENE_HEARTBEAT			0xDC								//Longest gap between frames let through, 100 ms units (R/W)
+#define REG_SCENE_COUNT				0xDD								//Changed pixels of the last frame (R, 16-bit)
+#define REG_SCENE_BOX_MIN			0xDE								//Top left changed pixel, x | y << 8 (R, 16-bit)
+#define REG_SCENE_BOX_MAX			0xDF								//Bottom right changed pixel, x | y << 8 (R, 16-bit)
+#define REG_SCENE_FIRST				REG_SCENE_MODE
+#define REG_SCENE_LAST				REG_SCENE_BOX_MAX
+
+#define SCENETAG					"[SCENE]"
+#define SCENE_INFO_MODE				"Mode %d, delta %d, %d pixels, heartbeat %d00 ms."
+
+// Scene change modes, the numbers are part of the protocol
+typedef enum sceneMode{
+	SCENE_MODE_OFF = 0,						//No background model, every frame goes out
+	SCENE_MODE_MEASURE,						//Model and registers updated, every frame goes out
+	SCENE_MODE_GATE,						//Quiet frames skip the analytics and the stream
+	SCENE_MODE_COUNT
+}sceneMode_t;
+
+// Change of the last frame against the background
+typedef struct sceneStatus{
+	uint16_t mCount;						//Changed pixels
+	uint8_t mMinX;							//Bounding box of the changed pixels, all 0 if none
+	uint8_t mMinY;
+	uint8_t mMaxX;
+	uint8_t mMaxY;
+}sceneStatus_t;
+
+bool sceneChange_Process(const uint16_t* pImage);
+
+uint16_t sceneChange_ReadRegister(const uint8_t regAddr);
+
+void sceneChange_WriteRegister(const uint8_t regAddr, const uint8_t value);
+
+#endif /* MAIN_INCLUDE_SCENECHANGE_H_ */
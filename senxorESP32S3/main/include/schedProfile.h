@@ -0,0 +1,41 @@
+/*****************************************************************************
+ * @file     schedProfile.h
+ * @version  1.00
+ * @brief    Core affinity and priority of the frame path tasks
+ * @date	 15 Oct 2026
+ * @details	 Core 0 runs Wi-Fi, lwIP and the servers. Core 1 runs the
+ * 			 capture, and in the split profile the analytics one priority
+ * 			 band below it, so a slow analytics pass or a network burst
+ * 			 never delays the next frame receive.
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_SCHEDPROFILE_H_
+#define MAIN_INCLUDE_SCHEDPROFILE_H_
+#include <freertos/FreeRTOS.h>
+#include <sdkconfig.h>
+
+#if CONFIG_MI_SCHED_PROFILE_SPLIT
+#define SCHED_ANALYTICS_SPLIT		1									//Analytics in senxorAnalyticsTask
+#define SCHED_SENXOR_PRIO			9									//Above every other application task
+#define SCHED_SENXOR_CORE			1
+#define SCHED_ANALYTICS_PRIO		6									//Above the recorder and the LCD, below the capture
+#define SCHED_ANALYTICS_CORE		1
+#define SCHED_TCP_PRIO				7
+#define SCHED_TCP_CORE				0
+#define SCHED_CMD_PRIO				6
+#define SCHED_CMD_CORE				0
+#define SCHED_PROFILE_NAME			"split"
+#else
+#define SCHED_ANALYTICS_SPLIT		0									//Analytics inline in senxorTask
+#define SCHED_SENXOR_PRIO			7
+#define SCHED_SENXOR_CORE			1
+#define SCHED_TCP_PRIO				7
+#define SCHED_TCP_CORE				0
+#define SCHED_CMD_PRIO				6
+#define SCHED_CMD_CORE				0
+#define SCHED_PROFILE_NAME			"shared"
+#endif
+
+#define SCHEDTAG					"[SCHED_PROFILE]"
+#define SCHED_INFO_PROFILE			"Scheduling profile %s, senxorTask priority %d on core %d."
+
+#endif /* MAIN_INCLUDE_SCHEDPROFILE_H_ */
@@ -1,6 +1,6 @@
 /*****************************************************************************
  * @file     senxorTask.h
- * @version  2.01
+ * @version  2.03
  * @brief    Header file for senxorTask.c
  * @date	 21 Jul 2022
  ******************************************************************************/
@@ -13,10 +13,28 @@
 #include "MCU_Dependent.h"
 #include "msg.h"						//Messages
 #include "SenXorLib.h"					//Using SenXor library
+#include "FrameStats.h"					//Frame statistics
 #include "restServer.h"
+#include "Senxor_Capturedata.h"
+#include "quadrantMax.h"				//quadrantData_t
 
 #define SENXOR_TASK_STACK_SIZE	4096	//Task stack size
-#define THERMAL_FRAME_BUFFER_NO 3		//Queue size
+#define SENXOR_ANALYTICS_STACK_SIZE	4096	//senxorAnalyticsTask stack size, split scheduling profile
+
+// Task notification bits
+#define SXR_NOTIFY_FRAME		CAPTURE_NOTIFY_FRAME	//Capture interrupt completed a frame
+#define SXR_NOTIFY_CLIENT		(1 << 1)				//Client connected or left, poll rate or subscription changed
+
+#define SXR_FRAME_WAIT_MS		500		//Longest wait for a frame while capturing before the mode is re-evaluated
+#define SXR_IDLE_WAIT_MS		1000	//Longest sleep without clients, in case a change was not notified
+#define SXR_PM_MIN_FREQ_MHZ		80		//CPU clock when idle with CONFIG_MI_LIGHT_SLEEP_EN
+#define SXR_FRAME_TIME_MAX_US	100000	//Oldest interrupt time taken as the capture time, older is a frame not seen by the task
+
+// Capture error recovery, each level runs when the previous one did not hold
+#define SXR_RECOVER_RESYNC		1		//Restart capture at the next frame, partial frame dropped
+#define SXR_RECOVER_SPI			2		//Also reset the SPI FIFOs and DMA channels
+#define SXR_RECOVER_REINIT		3		//Also reinitialise the SenXor (0xB0 = 3)
+#define SXR_RECOVER_WINDOW_MS	2000	//An error this soon after the previous one escalates
 
 // Frame dimensions
 #define SENXOR_FRAME_WIDTH  80
@@ -60,36 +78,68 @@
 #define DEFAULT_XSPLIT 40
 #define DEFAULT_YSPLIT 31
 
+// Quadrant configuration in NVS
+#define QUADRANT_NVS_KEY        "quadcfg"
+#define QUADRANT_CFG_VERSION    1
+#define QUADRANT_SAVE_QUIET_MS  2000    // Committed this long after the last write, or on SAVE
+
+// Calibration data cache in NVS
+#define CALIB_CACHE_HDR_KEY     "calhdr"
+#define CALIB_CACHE_DATA_KEY    "caldata"
+#define CALIB_CACHE_VERSION     1
+#define CALIB_CACHE_ID_BYTES    64      // Start of the SenXor flash compared with the copy, holds the module's production info
+
+// Written after the data blob, so an interrupted save is never taken for a valid copy
+typedef struct calibCacheHeader {
+	uint8_t mVersion;   // CALIB_CACHE_VERSION
+	uint8_t mModel;     // SenXorModel the data was read from
+	uint16_t mReserved;
+	uint32_t mLen;      // Size of the data blob in bytes
+	uint32_t mCrc;      // CRC-32 of the data blob
+} calibCacheHeader_t;
+
 typedef struct senxorFrame{
 	uint16_t mFrame[80*64];  // Full frame: 2 header rows + 62 image rows
+	uint32_t mSeq;           // Capture sequence number, gaps mean a frame was lost
+	int64_t mTimestampUs;    // Capture time in microseconds since boot
+	frameStats_t mStats;     // Histogram and percentiles of this frame
 }senxorFrame;
 
-// Quadrant analysis data structure
-typedef struct quadrantData {
-	uint16_t Amax;      // Max value in quadrant A (top-left)
-	uint16_t Acenter;   // Center pixel value in quadrant A
-	uint16_t Bmax;      // Max value in quadrant B (top-right)
-	uint16_t Bcenter;   // Center pixel value in quadrant B
-	uint16_t Cmax;      // Max value in quadrant C (bottom-left)
-	uint16_t Ccenter;   // Center pixel value in quadrant C
-	uint16_t Dmax;      // Max value in quadrant D (bottom-right)
-	uint16_t Dcenter;   // Center pixel value in quadrant D
-	uint8_t Xsplit;     // X split point (0-80)
-	uint8_t Ysplit;     // Y split point (0-62)
-	// Burner coordinates (absolute image coordinates)
-	uint8_t Aburnerx;   // Burner X in quadrant A
-	uint8_t Aburnery;   // Burner Y in quadrant A
-	uint16_t Aburnert;  // Temperature at burner in quadrant A
-	uint8_t Bburnerx;   // Burner X in quadrant B
-	uint8_t Bburnery;   // Burner Y in quadrant B
-	uint16_t Bburnert;  // Temperature at burner in quadrant B
-	uint8_t Cburnerx;   // Burner X in quadrant C
-	uint8_t Cburnery;   // Burner Y in quadrant C
-	uint16_t Cburnert;  // Temperature at burner in quadrant C
-	uint8_t Dburnerx;   // Burner X in quadrant D
-	uint8_t Dburnery;   // Burner Y in quadrant D
-	uint16_t Dburnert;  // Temperature at burner in quadrant D
-} quadrantData_t;
+
+// Split and burner registers, saved to NVS as one blob
+typedef struct quadrantConfig {
+	uint8_t mVersion;   // QUADRANT_CFG_VERSION
+	uint8_t mXsplit;
+	uint8_t mYsplit;
+	uint8_t mAburnerx;
+	uint8_t mAburnery;
+	uint8_t mBburnerx;
+	uint8_t mBburnery;
+	uint8_t mCburnerx;
+	uint8_t mCburnery;
+	uint8_t mDburnerx;
+	uint8_t mDburnery;
+} quadrantConfig_t;
+
+// Interval between streamed frames, as seen by senxorTask when it receives them
+typedef struct senxorJitter {
+	uint32_t mIntervals;    // Intervals measured
+	uint32_t mAvgUs;
+	uint32_t mMinUs;
+	uint32_t mMaxUs;
+	uint32_t mStdDevUs;     // Jitter
+	uint32_t mSkipped;      // Frames replaced by a newer one before the analytics task took them
+} senxorJitter_t;
+
+// Capture error recovery since boot
+typedef struct senxorRecovery {
+	uint32_t mErrors;       // SenXorError reports
+	uint32_t mLastError;    // SenXorError of the last report, ERROR_* bits
+	uint32_t mLevel[SXR_RECOVER_REINIT];  // Recoveries run at each level, level 1 first
+	uint32_t mLastUs;       // Error to the next good frame, last recovery
+	uint32_t mMaxUs;        // Longest since boot
+	uint32_t mSpiClockHz;   // Frame clock of the SenXor link
+} senxorRecovery_t;
 
 uint8_t senxorInit(void);
 
@@ -98,7 +148,14 @@ void quadrant_Init(void);
 void quadrant_Calculate(const uint16_t* frameData);
 uint16_t quadrant_ReadRegister(uint8_t regAddr);
 void quadrant_WriteRegister(uint8_t regAddr, uint8_t value);
+void quadrant_SaveConfig(void);
 
 void senxorTask(void * pvParameters);
+void senxorTaskNotifyClientChange(void);
+void senxorAcquireCapture(void);
+void senxorReleaseCapture(void);
+void senxorAnalyticsTask(void * pvParameters);
+void senxorGetFrameJitter(senxorJitter_t* pJitter, const bool reset);
+void senxorGetRecovery(senxorRecovery_t* pRecovery);
 
 #endif /* MAIN_INCLUDE_SENXORTASK_H_ */
@@ -0,0 +1,41 @@
+/*****************************************************************************
+ * @file     spiClockTune.h
+ * @version  1.00
+ * @brief    Header file for spiClockTune.c
+ * @date	 15 Oct 2026
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_SPICLOCKTUNE_H_
+#define MAIN_INCLUDE_SPICLOCKTUNE_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <sdkconfig.h>
+
+#define SPI_TUNE_CLOCKS				{5000000, 6000000, 10000000, 14000000, 20000000}	//Candidates, slowest first
+#define SPI_TUNE_CLOCK_COUNT		5
+#define SPI_TUNE_REGS				{0xB2, 0xB3, 0xBA, 0xE0, 0xE1, 0xE2, 0xE3, 0xE4, 0xE5}	//Read only, constant while idle
+#define SPI_TUNE_REG_COUNT			9
+#define SPI_TUNE_ROUNDS				32									//Reads of every register at each clock
+#define SPI_TUNE_VERIFY_ROUNDS		8									//Reads at the cached clock on a warm boot
+#define SPI_TUNE_CFG_VERSION		1									//Layout version of the NVS blob
+#define SPI_TUNE_NVS_KEY			"spiclk"
+
+#define SPITUNETAG					"[SPI_TUNE]"
+#define SPI_TUNE_INFO_PASS			"%7lu Hz passed."
+#define SPI_TUNE_INFO_FAIL			"%7lu Hz failed, %d of %d reads wrong."
+#define SPI_TUNE_INFO_CACHED		"Cached clock %lu Hz verified."
+#define SPI_TUNE_INFO_SELECT		"Frame clock %lu Hz (fastest passing %lu Hz)."
+#define SPI_TUNE_WARN_BASELINE		"Identity registers unstable at the slowest clock, clock not tuned."
+#define SPI_TUNE_WARN_FALLBACK		"Capture errors, frame clock lowered to %lu Hz."
+
+// Tuned clock, stored as one NVS blob
+typedef struct spiTuneConfig{
+	uint8_t mVersion;						//SPI_TUNE_CFG_VERSION
+	uint8_t mLevel;							//Index into SPI_TUNE_CLOCKS
+	uint8_t mId[SPI_TUNE_REG_COUNT];		//Identity registers of the module it was tuned with
+}spiTuneConfig_t;
+
+void spiClockTune_Run(void);
+
+bool spiClockTune_Fallback(void);
+
+#endif /* MAIN_INCLUDE_SPICLOCKTUNE_H_ */
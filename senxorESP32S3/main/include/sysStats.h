@@ -0,0 +1,70 @@
+/*****************************************************************************
+ * @file     sysStats.h
+ * @version  1.02
+ * @brief    Header file for sysStats.c
+ * @date	 14 Oct 2026
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_SYSSTATS_H_
+#define MAIN_INCLUDE_SYSSTATS_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <sdkconfig.h>
+#include "framePool.h"
+#include "senxorTask.h"
+#include "frameClassifier.h"
+
+#define SYS_STATS_STACK_SIZE		3072
+#define SYS_STATS_PERIOD_MS			(CONFIG_MI_SYS_STATS_PERIOD_S * 1000)
+#define SYS_STATS_RING_SIZE			CONFIG_MI_SYS_STATS_RING			//Samples kept, the oldest is overwritten
+#define SYS_STATS_MAX_TASKS			32									//Tasks sampled, IDF and application
+#define SYS_STATS_URI				"/stats"
+
+#define SYSSTATTAG					"[SYS_STATS]"
+#define SYS_STATS_INFO_START		"Sampling every %d ms, %d samples kept."
+#define SYS_STATS_WARN_TASKS		"%u tasks running, only %d sampled."
+#define SYS_STATS_WARN_NO_SERVER	"REST server not running, " SYS_STATS_URI " not served."
+#define SYS_STATS_ERR_REGISTER		"Cannot register " SYS_STATS_URI ": %s"
+
+// Heap regions reported
+typedef enum sysHeapRegion{
+	SYS_HEAP_INTERNAL = 0,
+	SYS_HEAP_DMA,
+	SYS_HEAP_PSRAM,
+	SYS_HEAP_COUNT
+}sysHeapRegion_t;
+
+// One task of a sample
+typedef struct sysTaskStats{
+	char mName[configMAX_TASK_NAME_LEN];
+	uint16_t mCpuPermille;					//Share of both cores since the previous sample
+	uint16_t mStackFree;					//Lowest free stack since the task started, bytes
+	uint8_t mPriority;
+	uint8_t mState;							//eTaskState
+}sysTaskStats_t;
+
+// One periodic sample
+typedef struct sysStatsSample{
+	uint32_t mTimeMs;						//Uptime at the sample
+	uint32_t mHeapFree[SYS_HEAP_COUNT];
+	uint32_t mHeapMin[SYS_HEAP_COUNT];		//Lowest free heap since boot
+	uint32_t mHeapLargest[SYS_HEAP_COUNT];	//Largest free block
+	frameBusStats_t mBus;
+	senxorJitter_t mCapture;				//Streamed frame intervals since the previous sample
+	senxorRecovery_t mRecovery;				//Capture error recovery since boot
+	clsStats_t mClassify;					//Classifier inferences since the previous sample
+	uint16_t mIdlePermille;					//Both idle tasks, 1000 = both cores idle
+	uint8_t mTaskCount;
+	sysTaskStats_t mTask[SYS_STATS_MAX_TASKS];
+}sysStatsSample_t;
+
+void sysStatsTask(void *pvParameters);
+
+bool sysStats_GetLatest(sysStatsSample_t* pSample);
+
+bool sysStats_GetSummary(uint32_t* pUptimeS, uint32_t* pInternalFree, uint32_t* pInternalMin, uint32_t* pPsramFree, uint32_t* pDropped, uint8_t* pDeepest);
+
+bool sysStats_GetTask(const char* pName, uint16_t* pCpuPermille, uint16_t* pStackFree);
+
+#endif /* MAIN_INCLUDE_SYSSTATS_H_ */
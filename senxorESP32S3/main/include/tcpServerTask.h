@@ -1,18 +1,24 @@
 /*****************************************************************************
  * @file     tcpServerTask.h
- * @version  1.4
+ * @version  1.11
  * @brief    Header file for tcpServerTask.c
  * @date	 17 Jul 2022
  ******************************************************************************/
 #ifndef MAIN_INCLUDE_TCPSERVERTASK_H_
 #define MAIN_INCLUDE_TCPSERVERTASK_H_
+#include <lwip/sockets.h>
 
 #include "DrvNVS.h"
 #include "DrvGPIO.h"
 #include "DrvWLAN.h"
 #include "restServer.h"
 #include "senxorTask.h"
+#include "framePool.h"
+#include "frameCodec.h"
+#include "blobTrack.h"
+#include "linkAdapt.h"
 #include "cmdParser.h"
+#include "Drv_CRC.h"
 #include "msg.h"
 #include "util.h"
 
@@ -30,6 +36,50 @@
 #define KEEPALIVE_INTERVAL       CONFIG_MI_TCP_KEEPALIVE_INTERVAL			//TCP Keep Alive interval
 #define KEEPALIVE_COUNT          CONFIG_MI_TCP_KEEPALIVE_COUNT				//TCP Keep Alive count
 #endif
+#define TCP_MAX_CLIENTS          CONFIG_MI_TCP_MAX_CLIENTS					//Maximum stream clients
+#define TCP_SEND_POLL_MS         10										//Mailbox poll period when the frame bus cannot wake up select()
+#define TCP_IDLE_WAIT_MS         1000									//Longest select() wait, events normally wake the loop first
+
+//Frame stream formats
+#define TCP_STREAM_V1            1										//Raw 10240 byte frames, no delimiter
+#define TCP_STREAM_V2            2										//Each frame preceded by a tcpStreamHeader_t
+#define TCP_STREAM_MAGIC         0x52465853								//"SXFR" in little endian
+#define TCP_STREAM_FLAG_KEYFRAME 0x01									//Payload does not depend on the previous frame
+#define TCP_STREAM_FLAG_STATS    0x02									//Header carries the frameStats_t block
+#define TCP_STREAM_FLAG_CRC32    0x04									//mPayloadCrc holds the CRC32 of the payload
+#define TCP_STREAM_FLAG_SHAPED   0x08									//Payload is the image window of mShape, not the full frame
+#define TCP_STREAM_FLAG_BLOBS    0x10									//Header ends with the used part of mBlobs
+#define TCP_STREAM_FLAG_UTC      0x20									//mUtcUs holds the capture time in UTC
+#define TCP_KEYFRAME_INTERVAL    CONFIG_MI_TCP_KEYFRAME_INTERVAL			//Longest run of delta frames between keyframes
+#define TCP_FRAME_PIXELS         (80 * 64)								//Pixels in senxorFrame.mFrame
+
+//Stream shaping (SHAP command)
+#define TCP_IMAGE_OFFSET         (2 * SENXOR_FRAME_WIDTH)				//Header rows of senxorFrame.mFrame, not part of a shaped image
+#define TCP_IMAGE_PIXELS         (SENXOR_FRAME_WIDTH * SENXOR_FRAME_HEIGHT)
+#define TCP_SHAPE_MAX_RATE_DIV   25										//Longest frame rate divisor, one frame a second at full rate
+#define TCP_FRAME_TOS            CONFIG_MI_LINK_FRAME_TOS				//IP TOS byte of frame traffic, mapped to a WMM access category
+
+//Bit packed payloads
+#define TCP_PACK_HEADER_WORDS    8										//Words of the first header row kept, the clients read words 0-6
+
+//UDP stream
+#if CONFIG_MI_SER_MODE_UDP
+#define TCP_STREAM_LOSSY         1										//Frames can be lost: v2 format with keyframes only
+#define UDP_VIEWER_TIMEOUT_MS    CONFIG_MI_UDP_VIEWER_TIMEOUT				//Viewer removed after this long without a hello
+#if CONFIG_MI_UDP_MULTICAST
+#define UDP_MCAST_ADDR           CONFIG_MI_UDP_MULTICAST_ADDR				//Group the frames are sent to
+#define UDP_MCAST_TTL            CONFIG_MI_UDP_MULTICAST_TTL				//Router hops of the multicast datagrams
+#endif
+#else
+#define TCP_STREAM_LOSSY         0
+#endif
+#define UDP_DATAGRAM_SIZE        1472									//Largest datagram without IP fragmentation on a 1500 byte MTU
+#define UDP_CHUNK_DATA           (UDP_DATAGRAM_SIZE - sizeof(udpChunkHeader_t))	//Frame bytes per datagram
+#define UDP_CHUNK_MAGIC          0x43555853								//"SXUC" in little endian
+#define UDP_HELLO_MAGIC          0x49485853								//"SXHI", viewer joins or stays alive
+#define UDP_BYE_MAGIC            0x59425853								//"SXBY", viewer leaves
+#define UDP_CHUNK_STALL_MS       20										//Rest of a frame is dropped if the stack has no buffer for this long
+
 //Task configuration
 #define TCP_TASK_STACK_SIZE      4096
 
@@ -53,6 +103,8 @@
 #define TCP_ERR_LISTEN			"Error occurred while listening to port %d.\nError code:%d (%s)"
 #define TCP_ERR_SOCK			"Cannot connect to socket %d."
 #define TCP_ERR_TASK_FAIL_INIT	"TCP task failed to initialised. The program will exit now."
+#define TCP_ERR_SELECT			"Error occurred while waiting for socket events.\nError code:%d (%s)"
+#define TCP_ERR_WAKE_FD			"Cannot create the frame wake up eventfd, polling the frame bus instead.\nError code:%d (%s)"
 #define TCP_ERR_TRANS			"Error occurred during receive/transmit phase: Socket: %d | Error: %d (%s)"
 
 #define TCP_SER_INFO			"Server address: %s.Port to be listened: %s."
@@ -69,10 +121,119 @@
 
 #define TCP_MSG_TEST			"Test message from TCP Server."
 #define TCP_WARN_SOCK_EXIST		"Closing the socket now for next use."
+#define TCP_WARN_FULL			"Rejecting %s: maximum of %d clients reached."
+#define TCP_CLIENT_INFO			"Stream clients: %d / %d."
+#define TCP_CLIENT_LEFT			"Frame client %s disconnected"
+#define TCP_WARN_CLIENT_ERR		"Frame client %s dropped, error %d (%s)."
+#define TCP_UDP_VIEWER_JOIN		"UDP viewer %s:%d joined."
+#define TCP_UDP_VIEWER_LEFT		"UDP viewer %s:%d left."
+#define TCP_UDP_MCAST			"Streaming to multicast group %s:%d."
 
-void tcpServerStart(void);
+/*
+ * Frame header of the v2 stream format. All fields are little endian.
+ */
+typedef enum tcpStreamEncoding{
+	TCP_STREAM_ENC_RAW16 = 0,							//80x64 uint16 pixels as captured
+	TCP_STREAM_ENC_DELTA,								//Zigzag varint residuals with zero runs (frameCodec.c)
+	TCP_STREAM_ENC_DELTA_LZ,							//TCP_STREAM_ENC_DELTA compressed with the LZ stage
+	TCP_STREAM_ENC_PACK12,								//Image bit packed to 12 bits per pixel (frameCodec.c)
+	TCP_STREAM_ENC_PACK14,								//Image bit packed to 14 bits per pixel
+	TCP_STREAM_ENC_PACK8,								//Image bit packed to 8 bits per pixel, lossy beyond a 255 count span
+	TCP_STREAM_ENC_COUNT
+}tcpStreamEncoding_t;
+
+typedef struct __attribute__((packed)) tcpStreamShape{
+	uint8_t mX;								//Window of the image, in pixels of the 80x62 image
+	uint8_t mY;
+	uint8_t mWidth;							//0 = full frame, pixels not shaped
+	uint8_t mHeight;
+	uint8_t mDecimation;					//1, 2 or 4: max of each block of mDecimation x mDecimation pixels
+	uint8_t mRateDiv;						//Every mRateDiv-th captured frame is sent
+	uint8_t mOutWidth;						//Columns of the payload image
+	uint8_t mOutHeight;						//Rows of the payload image
+}tcpStreamShape_t;
+
+typedef struct __attribute__((packed)) tcpStreamHeader{
+	uint32_t mMagic;						//TCP_STREAM_MAGIC
+	uint8_t mVersion;						//TCP_STREAM_V2
+	uint8_t mEncoding;						//tcpStreamEncoding_t of the payload
+	uint16_t mHeaderLen;					//Size of this header, payload starts right after it
+	uint32_t mSeq;							//Capture sequence number
+	uint64_t mTimestampUs;					//Capture time in microseconds since boot
+	uint32_t mPayloadLen;					//Payload size in bytes
+	uint8_t mFlags;							//TCP_STREAM_FLAG_*
+	uint8_t mReserved[3];
+	frameStats_t mStats;					//Frame statistics, see FrameStats.h
+	uint32_t mPayloadCrc;					//CRC32 of the payload if TCP_STREAM_FLAG_CRC32, else 0
+	tcpStreamShape_t mShape;				//Shape of the payload if TCP_STREAM_FLAG_SHAPED
+	uint64_t mUtcUs;						//Capture time in microseconds since 1970 if TCP_STREAM_FLAG_UTC, else 0
+	blobRecord_t mBlobs;					//Blob record if TCP_STREAM_FLAG_BLOBS, only its used part is sent
+}tcpStreamHeader_t;
 
-void tcpServerRecvTask(void* pvParameters);
+/*
+ * Header of every datagram of the UDP stream. The v2 header and payload of a
+ * frame are split into chunks of UDP_CHUNK_DATA bytes, chunk n holds the bytes
+ * from n * UDP_CHUNK_DATA. All fields are little endian.
+ */
+typedef struct __attribute__((packed)) udpChunkHeader{
+	uint32_t mMagic;						//UDP_CHUNK_MAGIC
+	uint32_t mFrameId;						//Capture sequence number of the frame
+	uint16_t mChunkIdx;						//Index of this chunk
+	uint16_t mChunkCount;					//Chunks in the frame
+	uint32_t mFrameLen;						//Size of the v2 header and payload
+}udpChunkHeader_t;
+
+typedef struct tcpClient{
+	int mSock;								//Client socket. -1 if the entry is free
+	frameSubscriber_t mFrameSub;			//Frame mailbox of this client
+	senxorFrame* mTxFrame;					//Frame being sent, NULL if idle
+	tcpStreamHeader_t mTxHeader;			//Header sent ahead of mTxFrame
+	uint16_t mTxHeaderLen;					//Size of mTxHeader, 0 in the v1 format
+	uint16_t mTxOffset;						//Bytes of header and frame already sent
+	const uint8_t* mTxPayload;				//Raw frame or encoded copy of mTxFrame
+	uint16_t mTxPayloadLen;					//Size of mTxPayload
+	uint8_t mFormat;						//TCP_STREAM_V1 or TCP_STREAM_V2, requested with SFMT
+	uint8_t mEncoding;						//tcpStreamEncoding_t of the v2 payload, requested with SFMT
+	uint8_t mIntegrity;						//crcMode_t of the v2 payload, requested with SCRC
+	bool mRefValid;							//Client holds a reference frame for delta coding
+	uint8_t mRefEncoding;					//Encoding the reference was set up for
+	uint16_t mFramesSinceKey;				//Delta frames sent since the last keyframe
+	uint32_t mFramesSent;					//Frames sent to this client
+	uint64_t mBytesSent;					//Bytes sent to this client
+	tcpStreamShape_t mShape;				//Window, decimation and rate divisor requested with SHAP
+	int8_t mShapeSlot;						//Entry of the shared shape cache, -1 if the pixels are not shaped
+	uint32_t mNextSeq;						//Rate divisor: first capture sequence number to send, 0 = next frame
+	uint64_t mBlockedUs;					//Time spent waiting for the socket to become writable
+	int64_t mBlockedSinceUs;				//Start of the current wait, 0 if not blocked
+	char mAddr[16];							//Client IPv4 address
+	linkAdapt_t mLink;						//Link adaptation of this client
+	struct sockaddr_in mPeer;				//UDP: viewer or multicast group the chunks are sent to
+	int64_t mLastSeenUs;					//UDP: time of the last viewer hello
+}tcpClient_t;
+
+/*
+ * Stream settings requested by a client address with SFMT, SCRC and SHAP.
+ * Stream clients connecting from the address pick them up, the entry is free
+ * if mAddr is empty.
+ */
+typedef struct tcpStreamRequest{
+	char mAddr[16];							//Client IPv4 address
+	uint8_t mFormat;						//TCP_STREAM_V1 or TCP_STREAM_V2
+	uint8_t mEncoding;						//tcpStreamEncoding_t of the v2 payload
+	uint8_t mIntegrity;						//crcMode_t of the v2 payload, CRC_MODE_SUM16 = none
+	tcpStreamShape_t mShape;
+}tcpStreamRequest_t;
+
+/*
+ * Entry of the shape cache. The image of a shape is pooled once per frame
+ * and shared by every client requesting the same window and decimation.
+ */
+typedef struct tcpShapeCache{
+	uint32_t mSeq;							//Capture sequence number of the pooled image
+	bool mValid;							//Buffer holds the image of mSeq
+}tcpShapeCache_t;
+
+void tcpServerStart(void);
 
 void tcpServerRestart(const bool isFullRestart);
 
@@ -80,10 +241,20 @@ void tcpServerShutdown(void);
 
 void tcpServerTask(void * pvParameters);
 
-int tcpServerSend(const uint8_t* data, const size_t t);
+int tcpServerSend(const uint8_t idx, const uint8_t* data, const size_t t);
 
 bool tcpServerGetIsClientConnected(void);
 
+uint8_t tcpServerGetClientCount(void);
+
+bool tcpServerGetClientStats(const uint8_t idx, uint32_t* pBytesSent, uint32_t* pFramesSent, uint32_t* pFramesDropped, uint32_t* pBlockedMs);
+
+int tcpServerSetStreamFormat(const char* pAddr, uint8_t* pFormat, uint8_t* pEncoding);
+
+int tcpServerSetStreamIntegrity(const char* pAddr, uint8_t* pMode);
+
+int tcpServerSetStreamShape(const char* pAddr, uint8_t* pShape);
+
 void tcpServer_InitThermalBuff(void);
 
 #endif /* MAIN_INCLUDE_TCPSERVERTASK_H_ */
@@ -0,0 +1,49 @@
+/*****************************************************************************
+ * @file     temporalFilter.h
+ * @version  1.00
+ * @brief    Header file for temporalFilter.c
+ * @date	 15 Oct 2026
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_TEMPORALFILTER_H_
+#define MAIN_INCLUDE_TEMPORALFILTER_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <sdkconfig.h>
+
+#define TFILTER_WIDTH				80
+#define TFILTER_HEIGHT				62									//Image rows, header rows removed
+#define TFILTER_PIXELS				(TFILTER_WIDTH * TFILTER_HEIGHT)
+#define TFILTER_FRAC_BITS			4									//Fraction bits of the EWMA state
+#define TFILTER_RESEED_US			1000000								//Longer gap between frames and the filter starts over
+#if CONFIG_MI_TFILTER_EN
+#define TFILTER_MAX_FRAMES			CONFIG_MI_TFILTER_MAX_FRAMES		//Longest box average
+#define TFILTER_DEFAULT_MODE		CONFIG_MI_TFILTER_MODE_VAL
+#define TFILTER_DEFAULT_ALPHA		CONFIG_MI_TFILTER_ALPHA
+#define TFILTER_DEFAULT_FRAMES		CONFIG_MI_TFILTER_FRAMES
+#endif
+
+// Temporal filter registers
+#define REG_TFILT_MODE				0xD6								//tFilterMode_t (R/W)
+#define REG_TFILT_ALPHA				0xD7								//EWMA weight of a new frame, 1/256 units (R/W)
+#define REG_TFILT_FRAMES			0xD8								//Frames of the box average (R/W)
+#define REG_TFILT_FIRST				REG_TFILT_MODE
+#define REG_TFILT_LAST				REG_TFILT_FRAMES
+
+#define TFILTERTAG					"[TFILTER]"
+#define TFILTER_INFO_MODE			"Mode %d, alpha %d/256, %d frames."
+
+// Filter modes, the numbers are part of the protocol
+typedef enum tFilterMode{
+	TFILTER_MODE_OFF = 0,
+	TFILTER_MODE_EWMA,						//Exponentially weighted moving average
+	TFILTER_MODE_BOX,						//Mean of the last N frames
+	TFILTER_MODE_COUNT
+}tFilterMode_t;
+
+void temporalFilter_Process(uint16_t* pImage);
+
+uint16_t temporalFilter_ReadRegister(const uint8_t regAddr);
+
+void temporalFilter_WriteRegister(const uint8_t regAddr, const uint8_t value);
+
+#endif /* MAIN_INCLUDE_TEMPORALFILTER_H_ */
@@ -11,10 +11,20 @@
 #include "DrvUSB.h"
 #include "senxorTask.h"
 #include "cmdParser.h"
-
-#define USB_TX_SIZE                             4+4+4+(160+80+80*63)*2+4                                               // Panther requires 39696 bytes 
+#include "Drv_CRC.h"
+
+#define USB_TX_HEAD_SIZE                        (4+4+4+80*2)                                                           // Delimiter, length, command and 80 unused words
+#define USB_TX_FRAME_BYTES                      ((80+80*62)*2)                                                         // Sent straight from the frame slot
+#define USB_TX_SIZE                             (USB_TX_HEAD_SIZE+USB_TX_FRAME_BYTES+4)                                // Panther requires 39696 bytes 
+#define USB_TX_TAIL_SIZE                        8                                                                      // Longest integrity check text (CRC32)
+#define USB_TX_WAIT_MS                          10                                                                     // Recheck period while waiting for TX FIFO space
+#define USB_TX_STALL_MS                         100                                                                    // Frame dropped if the FIFO has no room by then
+#define USB_STATS_PERIOD_MS                     10000                                                                  // Throughput log period
 #define USB_TASK_STACK_SIZE                     4096
 #define USB_TX_PACKET_SIZE                      CONFIG_TINYUSB_CDC_TX_BUFSIZE / 2
+#define USB_CRC_BENCH_RUNS                      20                                                                     // Frames timed per check by the CRC benchmark
+#define USB_BULK_CHUNK                          USB_TX_PACKET_SIZE                                                     // Largest piece of a RECD clip queued at once
+#define USB_BULK_FILL_SIZE                      64                                                                     // Zeros sent if the clip ends before the promised length
 
 // Debug message
 #define USBTaskTAG 							    "[USB_TASK]"
@@ -25,9 +35,14 @@
 #define USBTASK_ERR_TASK_FAIL_INIT				"USBTask task failed to initialised. USB function will not be avaliable."
 #define USBTASK_ERR_TASK_QUEUE_INIT_FAIL		"Cannot allocate queue for MI48 task. USB function will not be avaliable."
 #define USBTASK_ERR_RX_LEN_TOO_SHORT            "Invalid EVK command."
-#define USBTASK_INFO_REMAIN_BYTES               "Sending remaining %d bytes"
+#define USBTASK_WARN_TX_STALL                   "Host not reading, frame dropped (%u bytes free)."
+#define USBTASK_WARN_BULK_BUSY                  "Clip download in progress, command dropped."
+#define USBTASK_WARN_BULK_STALL                 "Host not reading, clip download aborted at %lu bytes left."
 #define USBTASK_INFO_INIT						"USB Task initialising... Running on Core %d."
 #define USBTASK_INFO_TASK_RESUME                "USB Task resumed."
+#define USBTASK_INFO_INTEGRITY                  "Frame integrity check: %s"
+#define USBTASK_INFO_CRC_BENCH                  "CRC benchmark over %u bytes (cycles/frame): sum16 %lu, crc16 %lu, rom crc32 %lu"
+#define USBTASK_INFO_STATS                      "Streamed %lu frames (%lu.%lu fps), %lu kB/s, %lu dropped."
 
 
 
@@ -35,4 +50,8 @@ void usbSerialTask(void * pvParameters);
 
 void usbSerialTask_InitThermalBuff(void);
 
+void usbSerialSetIntegrity(const uint8_t mode);
+
+uint8_t usbSerialGetIntegrity(void);
+
 #endif
@@ -0,0 +1,36 @@
+/*****************************************************************************
+ * @file     usbVendorTask.h
+ * @version  1.00
+ * @brief    Header file for usbVendorTask.c
+ * @date	 15 Oct 2026
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_USBVENDORTASK_H_
+#define MAIN_INCLUDE_USBVENDORTASK_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <sdkconfig.h>
+
+#define USB_VENDOR_ITF				0									//Vendor interface of the default descriptor
+#define USB_VENDOR_STACK_SIZE		3072
+#define USB_VENDOR_WAIT_MS			10									//Recheck period while waiting for TX FIFO space
+#define USB_VENDOR_STALL_MS			100									//Frame abandoned if the FIFO has no room by then
+#define USB_VENDOR_STATS_PERIOD_MS	10000								//Throughput log period
+#define USB_VENDOR_POLL_MS			100									//Longest wait between two reads of the bulk OUT endpoint
+#define USB_VENDOR_MSG_LEN			4
+#define USB_VENDOR_MSG_HELLO		"SXHI"								//Reader starts the stream
+#define USB_VENDOR_MSG_BYE			"SXBY"								//Reader stops the stream
+
+#define USBVTAG						"[USB_VENDOR]"
+#define USBV_INFO_INIT				"Vendor bulk stream running on core %d, %d byte TX FIFO."
+#define USBV_INFO_JOIN				"Reader attached."
+#define USBV_INFO_LEFT				"Reader left."
+#define USBV_INFO_STATS				"Streamed %lu frames (%lu.%lu fps), %lu kB/s, %lu dropped, %lu cut."
+#define USBV_WARN_STALL				"Host not reading, frame cut after %lu of %lu bytes."
+
+void usbVendorTask(void *pvParameters);
+
+bool usbVendorGetIsClientConnected(void);
+
+#endif /* MAIN_INCLUDE_USBVENDORTASK_H_ */
@@ -0,0 +1,44 @@
+/*****************************************************************************
+ * @file     wsStreamTask.h
+ * @version  1.00
+ * @brief    Header file for wsStreamTask.c
+ * @date	 14 Oct 2026
+ ******************************************************************************/
+#ifndef MAIN_INCLUDE_WSSTREAMTASK_H_
+#define MAIN_INCLUDE_WSSTREAMTASK_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <sdkconfig.h>
+
+#include "framePool.h"
+
+#define WS_STREAM_URI				"/stream"
+#define WS_STREAM_STACK_SIZE		3072
+#define WS_MAX_CLIENTS				FRAME_BUS_WS_SUBSCRIBERS
+#define WS_STREAM_WAIT_MS			100									//Longest wait between two checks of closed sessions
+#define WS_IMAGE_OFFSET				80									//Header row of the frame, not sent
+#define WS_IMAGE_PIXELS				(80 * 62)							//Pixels in one WebSocket message
+#define WS_RX_MAX					64									//Largest message accepted from a viewer
+
+#define WSTAG						"[WS_STREAM]"
+#define WS_INFO_START				"WebSocket stream on %s, %d viewers max."
+#define WS_INFO_JOIN				"Viewer %d joined (fd %d)."
+#define WS_INFO_LEFT				"Viewer %d left (fd %d), %u frames sent, %u dropped."
+#define WS_WARN_FULL				"Viewer refused (fd %d): server full."
+#define WS_WARN_SEND				"Send to viewer %d failed: %s"
+#define WS_ERR_NO_SERVER			"REST server not running, WebSocket stream disabled."
+#define WS_ERR_REGISTER				"Cannot register %s: %s"
+
+typedef struct wsClient{
+	int mFd;								//Socket of the WebSocket session, -1 if the entry is free
+	frameSubscriber_t mFrameSub;			//Frame mailbox of this viewer
+	uint32_t mFramesSent;					//Frames sent to this viewer
+}wsClient_t;
+
+void wsStreamTask(void *pvParameters);
+
+bool wsStreamGetIsClientConnected(void);
+
+#endif /* MAIN_INCLUDE_WSSTREAMTASK_H_ */
@@ -0,0 +1,109 @@
+/*****************************************************************************
+ * @file     lcdViewTask.c
+ * @version  1.01
+ * @brief    Thermal live view on the on-board LCD.
+ * @date	 14 Oct 2026
+ * @details	 The live view is a frame bus subscriber that keeps capture
+ * 			 running, like the recorder. It takes the newest frame only, so
+ * 			 a slow panel drops frames here and never holds up senxorTask.
+ * 			 The colour range follows the frame minimum and maximum
+ * 			 smoothly, a range that jumps with every frame would recolour,
+ * 			 and so redraw, the whole image each time.
+ ******************************************************************************/
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <sdkconfig.h>
+
+#include "SenXorLib.h"
+#include "msg.h"
+#include "lcdViewTask.h"
+#include "framePool.h"
+#include "senxorTask.h"
+
+#if CONFIG_MI_LCD_LIVE_VIEW
+#include "DrvLCD.h"
+
+//private:
+static volatile bool mActive = false;									//Subscribed, capture is kept running
+
+/*
+ * ***********************************************************************
+ * @brief       lcdViewTask
+ * @param       pvParameters - Not used
+ * @return      None
+ * @details     Start capture and draw every frame received
+ **************************************************************************/
+void lcdViewTask(void *pvParameters)
+{
+	ESP_LOGI(LCDTAG, LCD_TASK_INFO, xPortGetCoreID());
+	if(!lcdLiveViewInit(CONFIG_MI_LCD_LIVE_COLOURMAP))
+	{
+		vTaskDelete(NULL);
+	}//End if
+
+	const frameSubscriber_t frameSub = framePool_Subscribe("lcd", 1, FRAME_POLICY_LATEST_ONLY, xTaskGetCurrentTaskHandle());
+	if(frameSub == FRAME_BUS_INVALID_ID)
+	{
+		ESP_LOGE(LCDTAG, LCD_ERR_LIVE_SUB);
+		vTaskDelete(NULL);
+	}//End if
+
+	mActive = true;
+	senxorAcquireCapture();													//Held for good, the live view never stops
+
+	int32_t rangeLo = -1;														//Smoothed colour range, -1 until the first frame
+	int32_t rangeHi = -1;
+	uint32_t frames = 0;
+
+	for(;;)
+	{
+		senxorFrame* pFrame = framePool_Receive(frameSub, pdMS_TO_TICKS(LCD_VIEW_WAIT_MS));
+		if(pFrame == NULL)
+		{
+			continue;
+		}//End if
+
+		if(rangeLo < 0)
+		{
+			rangeLo = pFrame->mStats.mMin;
+			rangeHi = pFrame->mStats.mMax;
+		}
+		else
+		{
+			rangeLo += ((int32_t)pFrame->mStats.mMin - rangeLo) >> LCD_VIEW_RANGE_SHIFT;
+			rangeHi += ((int32_t)pFrame->mStats.mMax - rangeHi) >> LCD_VIEW_RANGE_SHIFT;
+		}//End if-else
+		const uint16_t lo = (uint16_t)rangeLo;
+		const uint16_t hi = (uint16_t)((rangeHi - rangeLo < LCD_VIEW_MIN_SPAN) ? rangeLo + LCD_VIEW_MIN_SPAN : rangeHi);
+
+		if(++frames % LCD_VIEW_REFRESH_FRAMES == 0)
+		{
+			lcdLiveViewInvalidate();
+		}//End if
+		lcdLiveViewDraw(pFrame->mFrame + (2 * LCD_SENXOR_FRAME_W), lo, hi);	//Image starts after 2 header rows
+		framePool_Release(pFrame);
+	}//End for
+}//End lcdViewTask
+
+/*
+ * ***********************************************************************
+ * @brief       lcdViewGetIsActive
+ * @param       None
+ * @return      true while the live view needs frames
+ * @details     None
+ **************************************************************************/
+bool lcdViewGetIsActive(void)
+{
+	return mActive;
+}//End lcdViewGetIsActive
+
+#else
+
+bool lcdViewGetIsActive(void)
+{
+	return false;
+}//End lcdViewGetIsActive
+
+#endif
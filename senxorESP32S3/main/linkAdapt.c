@@ -0,0 +1,201 @@
+/*****************************************************************************
+ * @file     linkAdapt.c
+ * @version  1.00
+ * @brief    Per-client adaptation of the frame stream to the Wi-Fi link.
+ * @date	 15 Oct 2026
+ * @details	 tcpServerTask reports every frame it completes with its delay
+ * 			 from capture, and once a period the time the client spent
+ * 			 blocked and the age of the frame still being sent. A period
+ * 			 over the latency target, or mostly blocked, steps the client
+ * 			 one level down the mode ladder at once. LINK_UP_PERIODS calm
+ * 			 periods in a row step it back up, and a weak signal holds it
+ * 			 where it is. The ladder trades compression first, then frame
+ * 			 rate, then resolution:
+ *
+ * 			 0  as requested with SFMT and SHAP
+ * 			 1  raw and delta v2 payloads delta + LZ coded
+ * 			 2  every 2nd frame
+ * 			 3  every 4th frame
+ * 			 4  v2 image max pooled 2 x 2 (CONFIG_MI_LINK_ADAPT_DECIMATE)
+ *
+ * 			 esp_wifi has no public TX retry counter. Retries show up as
+ * 			 send buffers that do not drain, which is the blocked time.
+ ******************************************************************************/
+#include <string.h>
+#include <sys/param.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_wifi.h>
+
+#include "linkAdapt.h"
+
+//private:
+static const linkMode_t mModes[] = {
+	{ .mCompress = false, .mRateDiv = 1, .mDecimation = 1 },
+	{ .mCompress = true,  .mRateDiv = 1, .mDecimation = 1 },
+	{ .mCompress = true,  .mRateDiv = 2, .mDecimation = 1 },
+	{ .mCompress = true,  .mRateDiv = 4, .mDecimation = 1 },
+	{ .mCompress = true,  .mRateDiv = 4, .mDecimation = 2 },
+};
+
+#if CONFIG_MI_LINK_ADAPT_EN
+
+/*
+ * ***********************************************************************
+ * @brief       linkAdapt_Reset
+ * @param       pLink - Controller of the client
+ * 				blockedUs - Blocked time of the client so far
+ * @return      None
+ * @details     Called when a client joins, it starts as requested
+ **************************************************************************/
+void linkAdapt_Reset(linkAdapt_t* pLink, const uint64_t blockedUs)
+{
+	memset(pLink, 0, sizeof(*pLink));
+	pLink->mBlockedUs = blockedUs;
+	pLink->mPeriodStartUs = esp_timer_get_time();
+}//End linkAdapt_Reset
+
+/*
+ * ***********************************************************************
+ * @brief       linkAdapt_FrameSent
+ * @param       pLink - Controller of the client
+ * 				latencyUs - Capture to send completion of the frame
+ * @return      None
+ **************************************************************************/
+void linkAdapt_FrameSent(linkAdapt_t* pLink, const int64_t latencyUs)
+{
+	pLink->mFrames++;
+	pLink->mLatencySumUs += (latencyUs > 0) ? (uint64_t)latencyUs : 0;
+}//End linkAdapt_FrameSent
+
+/*
+ * ***********************************************************************
+ * @brief       linkAdapt_Update
+ * @param       pLink - Controller of the client
+ * 				blockedUs - Blocked time of the client so far, the current
+ * 				wait included
+ * 				pendingUs - Age of the frame being sent, 0 if idle
+ * 				rssi - Signal of the link in dBm, LINK_RSSI_NONE if unknown
+ * 				pName - Client, for the log
+ * @return      True if the level changed
+ * @details     Called every loop of tcpServerTask, acts once a period
+ **************************************************************************/
+bool linkAdapt_Update(linkAdapt_t* pLink, const uint64_t blockedUs, const int64_t pendingUs, const int8_t rssi, const char* pName)
+{
+	const int64_t now = esp_timer_get_time();
+	const int64_t periodUs = now - pLink->mPeriodStartUs;
+
+	if(periodUs < (int64_t)LINK_ADAPT_PERIOD_MS * 1000)
+	{
+		return false;
+	}//End if
+
+	const uint32_t latencyMs = (pLink->mFrames > 0) ? (uint32_t)(pLink->mLatencySumUs / pLink->mFrames / 1000) : 0;
+	const uint32_t worstMs = MAX(latencyMs, (uint32_t)(MAX(pendingUs, 0) / 1000));		//A stuck frame counts even if nothing completed
+	const int blockedPct = (int)(((blockedUs - pLink->mBlockedUs) * 100) / (uint64_t)periodUs);
+	const bool isCongested = (worstMs > CONFIG_MI_LINK_LATENCY_MS) || (blockedPct >= LINK_BLOCKED_PCT);
+	const bool isWeak = (rssi != LINK_RSSI_NONE) && (rssi < CONFIG_MI_LINK_RSSI_WEAK);
+	const bool isCalm = !isCongested && !isWeak && (worstMs * 100 < CONFIG_MI_LINK_LATENCY_MS * LINK_CALM_PCT);
+	const uint8_t level = pLink->mLevel;
+
+	if(isCongested)
+	{
+		pLink->mCalmPeriods = 0;
+		pLink->mLevel = MIN(level + 1, LINK_LEVEL_COUNT - 1);
+	}
+	else if(isCalm && level > 0)
+	{
+		if(++pLink->mCalmPeriods >= LINK_UP_PERIODS)
+		{
+			pLink->mCalmPeriods = 0;
+			pLink->mLevel = level - 1;
+		}//End if
+	}
+	else
+	{
+		pLink->mCalmPeriods = 0;
+	}//End if-else
+
+	pLink->mFrames = 0;
+	pLink->mLatencySumUs = 0;
+	pLink->mBlockedUs = blockedUs;
+	pLink->mPeriodStartUs = now;
+
+	if(pLink->mLevel != level)
+	{
+		ESP_LOGI(LINKTAG, LINK_INFO_LEVEL, pName, pLink->mLevel, (unsigned long)worstMs, blockedPct, rssi);
+		return true;
+	}//End if
+	return false;
+}//End linkAdapt_Update
+
+#else
+
+void linkAdapt_Reset(linkAdapt_t* pLink, const uint64_t blockedUs)
+{
+	memset(pLink, 0, sizeof(*pLink));
+}//End linkAdapt_Reset
+
+void linkAdapt_FrameSent(linkAdapt_t* pLink, const int64_t latencyUs)
+{
+}//End linkAdapt_FrameSent
+
+bool linkAdapt_Update(linkAdapt_t* pLink, const uint64_t blockedUs, const int64_t pendingUs, const int8_t rssi, const char* pName)
+{
+	return false;
+}//End linkAdapt_Update
+
+#endif
+
+/*
+ * ***********************************************************************
+ * @brief       linkAdapt_GetMode
+ * @param       pLink - Controller of the client
+ * @return      Stream mode of its level
+ **************************************************************************/
+const linkMode_t* linkAdapt_GetMode(const linkAdapt_t* pLink)
+{
+	return &mModes[MIN(pLink->mLevel, LINK_LEVEL_COUNT - 1)];
+}//End linkAdapt_GetMode
+
+/*
+ * ***********************************************************************
+ * @brief       linkAdapt_GetRssi
+ * @param       None
+ * @return      Signal in dBm, LINK_RSSI_NONE if there is no link
+ * @details     The signal of the access point in station mode. On the
+ * 				soft AP, the weakest station, which the clients may be.
+ **************************************************************************/
+int8_t linkAdapt_GetRssi(void)
+{
+	wifi_mode_t mode;
+	int8_t rssi = LINK_RSSI_NONE;
+
+	if(esp_wifi_get_mode(&mode) != ESP_OK)
+	{
+		return LINK_RSSI_NONE;
+	}//End if
+
+	if(mode == WIFI_MODE_STA || mode == WIFI_MODE_APSTA)
+	{
+		wifi_ap_record_t apInfo;
+		if(esp_wifi_sta_get_ap_info(&apInfo) == ESP_OK)
+		{
+			rssi = apInfo.rssi;
+		}//End if
+	}//End if
+
+	if(mode == WIFI_MODE_AP || mode == WIFI_MODE_APSTA)
+	{
+		wifi_sta_list_t staList;
+		if(esp_wifi_ap_get_sta_list(&staList) == ESP_OK)
+		{
+			for(int i = 0; i < staList.num; i++)
+			{
+				rssi = (rssi == LINK_RSSI_NONE) ? staList.sta[i].rssi : MIN(rssi, staList.sta[i].rssi);
+			}//End for
+		}//End if
+	}//End if
+
+	return rssi;
+}//End linkAdapt_GetRssi
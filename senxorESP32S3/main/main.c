@@ -1,6 +1,6 @@
 /*****************************************************************************
  * @file     main.c
- * @version  2.04
+ * @version  2.07
  * @brief    Program entry point
  * @date	 24 May 2022
  ******************************************************************************/
@@ -20,6 +20,27 @@
 #include "tcpServerTask.h"			//tcpServerTask (frame streaming)
 #include "cmdServerTask.h"			//cmdServerTask (command handling)
 #include "usbSerialTask.h"			//usbSerialTask
+#include "usbVendorTask.h"			//usbVendorTask (USB vendor bulk frame stream)
+#include "wsStreamTask.h"			//wsStreamTask (WebSocket frame stream)
+#include "bleStreamTask.h"			//bleStreamTask (BLE frame stream)
+#include "frameRecorder.h"			//frameRecorderTask (pre-trigger recorder)
+#include "lcdViewTask.h"			//lcdViewTask (LCD live view)
+#include "frameClassifier.h"		//frameClassifierTask (flame and pan classifier)
+#include "frameSnapshot.h"			//GET /snapshot.bmp
+#include "mjpegStream.h"			//mjpegStreamTask (GET /snapshot.jpg and /mjpeg)
+#include "espNowTask.h"				//espNowTask (ESP-NOW peers)
+#include "mqttPublish.h"			//mqttPublishTask (ROI statistics and rule events to MQTT)
+#include "flashLog.h"				//flashLogTask (ROI statistics and frames to flash)
+#include "framePool.h"				//Frame buffer pool
+#include "roiEngine.h"				//Regions of interest
+#include "ruleEngine.h"				//Alarm rules
+#include "pixelMap.h"				//Bad pixel map
+#include "pixelCorrect.h"			//Per-pixel correction map
+#include "LatencyTrace.h"			//Per-stage latency
+#include "bootTimeline.h"			//Boot milestones
+#include "memProfile.h"				//Buffer placement
+#include "schedProfile.h"			//Task priorities and cores
+#include "sysStats.h"				//sysStatsTask (GET /stats and SYST)
 
 //BLE:
 #include "Drv_CombustionBle.h"		//Combustion-compatible BLE
@@ -29,7 +50,10 @@ MCU_REG MCU_REGISTER;
 
 //private:
 static void ESP32_Net_Init(void);
+static void ESP32_BT_Init(void);
+static void btInitTask(void *pvParameters);
 static uint8_t initCheck(void);
+static void memProfileReport(void);
 
 //Stack buffers for tasks
 #if CONFIG_MI_LED_EN
@@ -38,15 +62,21 @@ static StaticTask_t ledTaskBuffer;
 extern TaskHandle_t ledCtrlTaskHandle;
 #endif
 
-#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+#if CONFIG_FREERTOS_USE_STATS_FORMATTING_FUNCTIONS
 EXT_RAM_BSS_ATTR char ptrTaskList[2500];
 #endif
 
-EXT_RAM_BSS_ATTR static StackType_t senxorTaskStack[SENXOR_TASK_STACK_SIZE];
+MEM_HOT_ATTR static StackType_t senxorTaskStack[SENXOR_TASK_STACK_SIZE];
 static StaticTask_t senxorTaskBuffer;
 extern TaskHandle_t senxorTaskHandle;
 
-EXT_RAM_BSS_ATTR static StackType_t tcpServerTaskStack[TCP_TASK_STACK_SIZE];
+#if SCHED_ANALYTICS_SPLIT
+MEM_HOT_ATTR static StackType_t senxorAnalyticsTaskStack[SENXOR_ANALYTICS_STACK_SIZE];
+static StaticTask_t senxorAnalyticsTaskBuffer;
+extern TaskHandle_t senxorAnalyticsTaskHandle;
+#endif
+
+MEM_HOT_ATTR static StackType_t tcpServerTaskStack[TCP_TASK_STACK_SIZE];
 static StaticTask_t tcpServerTaskBuffer;
 extern TaskHandle_t tcpServerTaskHandle;
 
@@ -57,6 +87,62 @@ extern TaskHandle_t usbSerialTaskHandle;
 EXT_RAM_BSS_ATTR static StackType_t cmdServerTaskStack[CMD_SERVER_STACK_SIZE];
 static StaticTask_t cmdServerTaskBuffer;
 static TaskHandle_t cmdServerTaskHandle;
+
+#if CONFIG_MI_WS_STREAM_EN
+EXT_RAM_BSS_ATTR static StackType_t wsStreamTaskStack[WS_STREAM_STACK_SIZE];
+static StaticTask_t wsStreamTaskBuffer;
+static TaskHandle_t wsStreamTaskHandle;
+#endif
+#if CONFIG_MI_USB_VENDOR_EN
+EXT_RAM_BSS_ATTR static StackType_t usbVendorTaskStack[USB_VENDOR_STACK_SIZE];
+static StaticTask_t usbVendorTaskBuffer;
+static TaskHandle_t usbVendorTaskHandle;
+#endif
+#if CONFIG_MI_BLE_STREAM_EN
+EXT_RAM_BSS_ATTR static StackType_t bleStreamTaskStack[BLE_STREAM_STACK_SIZE];
+static StaticTask_t bleStreamTaskBuffer;
+static TaskHandle_t bleStreamTaskHandle;
+#endif
+#if CONFIG_MI_REC_EN
+EXT_RAM_BSS_ATTR static StackType_t frameRecorderTaskStack[REC_TASK_STACK_SIZE];
+static StaticTask_t frameRecorderTaskBuffer;
+static TaskHandle_t frameRecorderTaskHandle;
+#endif
+#if CONFIG_MI_LCD_LIVE_VIEW
+EXT_RAM_BSS_ATTR static StackType_t lcdViewTaskStack[LCD_VIEW_STACK_SIZE];
+static StaticTask_t lcdViewTaskBuffer;
+static TaskHandle_t lcdViewTaskHandle;
+#endif
+#if CONFIG_MI_CLASSIFY_EN
+static StackType_t frameClassifierTaskStack[CLS_STACK_SIZE];			//Internal RAM, the kernels keep their state on it
+static StaticTask_t frameClassifierTaskBuffer;
+static TaskHandle_t frameClassifierTaskHandle;
+#endif
+#if CONFIG_MI_SNAP_JPEG_EN
+EXT_RAM_BSS_ATTR static StackType_t mjpegTaskStack[MJPEG_STACK_SIZE];
+static StaticTask_t mjpegTaskBuffer;
+static TaskHandle_t mjpegTaskHandle;
+#endif
+#if CONFIG_MI_ESPNOW_EN
+EXT_RAM_BSS_ATTR static StackType_t espNowTaskStack[ESPNOW_STACK_SIZE];
+static StaticTask_t espNowTaskBuffer;
+static TaskHandle_t espNowTaskHandle;
+#endif
+#if CONFIG_MI_MQTT_EN
+EXT_RAM_BSS_ATTR static StackType_t mqttTaskStack[MQTT_STACK_SIZE];
+static StaticTask_t mqttTaskBuffer;
+static TaskHandle_t mqttTaskHandle;
+#endif
+#if CONFIG_MI_FLOG_EN
+static StackType_t flashLogTaskStack[FLOG_TASK_STACK_SIZE];			//Internal RAM, PSRAM is off while flash is programmed
+static StaticTask_t flashLogTaskBuffer;
+static TaskHandle_t flashLogTaskHandle;
+#endif
+#if CONFIG_MI_SYS_STATS_EN
+EXT_RAM_BSS_ATTR static StackType_t sysStatsTaskStack[SYS_STATS_STACK_SIZE];
+static StaticTask_t sysStatsTaskBuffer;
+static TaskHandle_t sysStatsTaskHandle;
+#endif
 /******************************************************************************
  * @brief       app_main
  * @param       none
@@ -65,7 +151,7 @@ static TaskHandle_t cmdServerTaskHandle;
  *****************************************************************************/
 void app_main(void)
 {
-#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+#if CONFIG_FREERTOS_USE_STATS_FORMATTING_FUNCTIONS
 	vTaskList(ptrTaskList);
 	ESP_LOGI(MTAG,"%s\r\n",ptrTaskList);
 #endif
@@ -86,7 +172,16 @@ void app_main(void)
 
 
 	ESP32_Peri_Init();																									//Initialise MCU peripherals
+	bootTimelineMark(BOOT_MARK_PERI);
 	quadrant_Init();																									//Initialise quadrant analysis
+	roiEngine_Init();																									//Load the ROI table
+	ruleEngine_Init();																									//Load the alarm rules
+	pixelMap_Init();																									//Load the bad pixel map
+	pixelCorrect_Init();																								//Load the per-pixel correction map
+	framePool_Init();																									//Initialise frame pool before any task uses it
+#if CONFIG_MI_LATENCY_TRACE_EN
+	LatencyTrace_Init();																								//Clear the latency rings before capture starts
+#endif
 
 	if(senxorInit() != 0)
 	{
@@ -96,6 +191,7 @@ void app_main(void)
 	#endif
 		vTaskDelete(NULL);
 	}//End if
+	bootTimelineMark(BOOT_MARK_SENXOR);
 
 #if CONFIG_MI_LED_EN
 	ledCtrlTaskHandle = xTaskCreateStatic(ledCtrlTask, "ledCtrlTask", LED_TASK_STACK_SIZE, NULL, tskIDLE_PRIORITY, ledTaskStack, &ledTaskBuffer);
@@ -103,9 +199,14 @@ void app_main(void)
 	{
 		ESP_LOGW(LEDTAG,LED_ERR_TASK_FAIL_INIT);
 	}//End if
+#endif
+#if SCHED_ANALYTICS_SPLIT
+	// Analytics of the capture, created first so no frame is handed over before it runs
+	senxorAnalyticsTaskHandle = xTaskCreateStaticPinnedToCore(senxorAnalyticsTask, "senxorAnalytics", SENXOR_ANALYTICS_STACK_SIZE, NULL, SCHED_ANALYTICS_PRIO, senxorAnalyticsTaskStack, &senxorAnalyticsTaskBuffer, SCHED_ANALYTICS_CORE);
 #endif
 	//Summoning SenXor task
-	senxorTaskHandle = xTaskCreateStaticPinnedToCore(senxorTask, "senxorTask", SENXOR_TASK_STACK_SIZE, NULL, 7, senxorTaskStack, &senxorTaskBuffer, 1);
+	ESP_LOGI(SCHEDTAG,SCHED_INFO_PROFILE,SCHED_PROFILE_NAME,SCHED_SENXOR_PRIO,SCHED_SENXOR_CORE);
+	senxorTaskHandle = xTaskCreateStaticPinnedToCore(senxorTask, "senxorTask", SENXOR_TASK_STACK_SIZE, NULL, SCHED_SENXOR_PRIO, senxorTaskStack, &senxorTaskBuffer, SCHED_SENXOR_CORE);
 	if(!senxorTaskHandle)
 	{
 		ESP_LOGE(SXRTAG,SXR_ERR_TASK_FAIL_INIT);
@@ -115,21 +216,117 @@ void app_main(void)
 	// //WARNING: Net components should be enabled only after SenXor is initialised.
 	ESP32_Net_Init();
 
-	// Frame streaming server (port 3333)
-	tcpServerTaskHandle = xTaskCreateStaticPinnedToCore(tcpServerTask, "tcpServerTask", TCP_TASK_STACK_SIZE, NULL, 7, tcpServerTaskStack, &tcpServerTaskBuffer, 0);
+	// Frame streaming server (port 3333), listening before the station has its IP
+	tcpServerTaskHandle = xTaskCreateStaticPinnedToCore(tcpServerTask, "tcpServerTask", TCP_TASK_STACK_SIZE, NULL, SCHED_TCP_PRIO, tcpServerTaskStack, &tcpServerTaskBuffer, SCHED_TCP_CORE);
 
 	// Command server (port 3334)
-	cmdServerTaskHandle = xTaskCreateStaticPinnedToCore(cmdServerTask, "cmdServerTask", CMD_SERVER_STACK_SIZE, NULL, 6, cmdServerTaskStack, &cmdServerTaskBuffer, 0);
+	cmdServerTaskHandle = xTaskCreateStaticPinnedToCore(cmdServerTask, "cmdServerTask", CMD_SERVER_STACK_SIZE, NULL, SCHED_CMD_PRIO, cmdServerTaskStack, &cmdServerTaskBuffer, SCHED_CMD_CORE);
+	bootTimelineMark(BOOT_MARK_SERVERS);
+
+#if CONFIG_MI_WS_STREAM_EN
+	// WebSocket frame stream (/stream on the REST server, Wi-Fi mode only)
+	if(getRestServerHandler() != NULL)
+	{
+		wsStreamTaskHandle = xTaskCreateStaticPinnedToCore(wsStreamTask, "wsStreamTask", WS_STREAM_STACK_SIZE, NULL, 5, wsStreamTaskStack, &wsStreamTaskBuffer, 0);
+	}//End if
+#endif
+
+#if CONFIG_MI_USB_VENDOR_EN
+	// Vendor bulk frame stream, USB mode only; the CDC port keeps the commands
+	if(MCU_getOpMode() == USB_MODE)
+	{
+		usbVendorTaskHandle = xTaskCreateStaticPinnedToCore(usbVendorTask, "usbVendorTask", USB_VENDOR_STACK_SIZE, NULL, 5, usbVendorTaskStack, &usbVendorTaskBuffer, 0);
+	}//End if
+#endif
+
+	frameSnapshotInit();							//GET /snapshot.bmp, Wi-Fi mode only
+
+#if CONFIG_MI_SNAP_JPEG_EN
+	// JPEG snapshots and MJPEG preview, encoded on the network core so capture is never held up
+	if(getRestServerHandler() != NULL)
+	{
+		mjpegTaskHandle = xTaskCreateStaticPinnedToCore(mjpegStreamTask, "mjpegStreamTask", MJPEG_STACK_SIZE, NULL, 4, mjpegTaskStack, &mjpegTaskBuffer, 0);
+	}//End if
+#endif
+
+#if CONFIG_MI_ESPNOW_EN
+	// ESP-NOW peers, on the running Wi-Fi interface and channel, Wi-Fi mode only
+	if(MCU_getOpMode() == WLAN_MODE)
+	{
+		espNowTaskHandle = xTaskCreateStaticPinnedToCore(espNowTask, "espNowTask", ESPNOW_STACK_SIZE, NULL, 5, espNowTaskStack, &espNowTaskBuffer, 0);
+	}//End if
+#endif
+
+#if CONFIG_MI_MQTT_EN
+	// MQTT telemetry, on the network core; the client reconnects by itself once the station has its IP
+	if(MCU_getOpMode() == WLAN_MODE)
+	{
+		mqttTaskHandle = xTaskCreateStaticPinnedToCore(mqttPublishTask, "mqttPublishTask", MQTT_STACK_SIZE, NULL, 3, mqttTaskStack, &mqttTaskBuffer, 0);
+	}//End if
+#endif
+
+#if CONFIG_MI_REC_EN
+	// Pre-trigger recorder, encodes next to senxorTask so the network core stays free
+	frameRecorderTaskHandle = xTaskCreateStaticPinnedToCore(frameRecorderTask, "frameRecorderTask", REC_TASK_STACK_SIZE, NULL, 4, frameRecorderTaskStack, &frameRecorderTaskBuffer, 1);
+#endif
+
+#if CONFIG_MI_LCD_LIVE_VIEW
+	// LCD live view, draws next to senxorTask; the lowest priority of the frame consumers
+	lcdViewTaskHandle = xTaskCreateStaticPinnedToCore(lcdViewTask, "lcdViewTask", LCD_VIEW_STACK_SIZE, NULL, 3, lcdViewTaskStack, &lcdViewTaskBuffer, 1);
+#endif
+
+#if CONFIG_MI_CLASSIFY_EN
+	// Flame and pan classifier, core 1 time left by the capture and the analytics
+	frameClassifierTaskHandle = xTaskCreateStaticPinnedToCore(frameClassifierTask, "frameClassifier", CLS_STACK_SIZE, NULL, CLS_TASK_PRIO, frameClassifierTaskStack, &frameClassifierTaskBuffer, CLS_TASK_CORE);
+#endif
+
+#if CONFIG_MI_FLOG_EN
+	// Flash log, after the REST server so it can serve /log
+	flashLogTaskHandle = xTaskCreateStaticPinnedToCore(flashLogTask, "flashLogTask", FLOG_TASK_STACK_SIZE, NULL, 3, flashLogTaskStack, &flashLogTaskBuffer, 0);
+#endif
+
+#if CONFIG_MI_SYS_STATS_EN
+	// Telemetry, after the REST server so it can serve /stats; every task it reports is created by now
+	sysStatsTaskHandle = xTaskCreateStaticPinnedToCore(sysStatsTask, "sysStatsTask", SYS_STATS_STACK_SIZE, NULL, 2, sysStatsTaskStack, &sysStatsTaskBuffer, 0);
+#endif
+
+	memProfileReport();								//Headroom left by the placement profile, Bluetooth may still be starting
 }
 /******************************************************************************
  * @brief       ESP32_Net_Init
  * @param       None
  * @return      None
- * @details     Initialise network related components
+ * @details     Initialise network related components. Wi-Fi starts first
+ * 				so the association runs while Bluetooth comes up on core 1,
+ * 				and the frame servers do not wait for BluFi.
  *****************************************************************************/
 static void ESP32_Net_Init(void)
 {
+	Drv_WLAN_Init();								//Initialise WiFi, BluFi needs it before provisioning
+	bootTimelineMark(BOOT_MARK_WLAN);
+	if(MCU_getOpMode() == WLAN_MODE)
+	{
+		bootTimelineInit();							//Watch for the station IP
+		restServer_Init();								//Initialise REST server also
+		bootTimelineMark(BOOT_MARK_REST);
+	}
+
+	//Bluetooth in parallel, the Bluedroid stack takes the longest to start
+	if(xTaskCreatePinnedToCore(btInitTask, "btInitTask", BOOT_BT_TASK_STACK_SIZE, NULL, BOOT_BT_TASK_PRIORITY, NULL, 1) != pdPASS)
+	{
+		ESP_LOGW(BOOTTAG,BOOT_ERR_BT_TASK);
+		ESP32_BT_Init();
+	}//End if
+}//End ESP32_Net_Init
 
+/******************************************************************************
+ * @brief       ESP32_BT_Init
+ * @param       None
+ * @return      None
+ * @details     Initialise BluFi, the Combustion service and the BLE stream
+ *****************************************************************************/
+static void ESP32_BT_Init(void)
+{
 #if (CONFIG_SOC_BT_SUPPORTED)
 #if (CONFIG_BT_ENABLED) && (CONFIG_BT_BLUEDROID_ENABLED) && (CONFIG_MI_BFI_EN)
 	Drv_BT_Init();									//Initialise Bluetooth for bluefi
@@ -140,14 +337,41 @@ static void ESP32_Net_Init(void)
 #else
 	ESP_LOGE(MTAG,BT_ERR_NOT_SUPPORTED);
 #endif
-	Drv_WLAN_Init();								//Initialise WiFi
-	if(MCU_getOpMode() == WLAN_MODE)
-	{
-		
-		restServer_Init();								//Initialise REST server also
-	}
-}//End ESP32_Net_Init
 
+#if CONFIG_MI_BLE_STREAM_EN
+	// BLE frame stream, next to the Combustion service
+	bleStreamTaskHandle = xTaskCreateStaticPinnedToCore(bleStreamTask, "bleStreamTask", BLE_STREAM_STACK_SIZE, NULL, 5, bleStreamTaskStack, &bleStreamTaskBuffer, 0);
+#endif
+	bootTimelineMark(BOOT_MARK_BT);
+}//End ESP32_BT_Init
+
+/******************************************************************************
+ * @brief       btInitTask
+ * @param       pvParameters - Not used
+ * @return      None
+ * @details     One-shot task running ESP32_BT_Init next to app_main
+ *****************************************************************************/
+static void btInitTask(void *pvParameters)
+{
+	ESP32_BT_Init();
+	vTaskDelete(NULL);
+}//End btInitTask
+
+
+/******************************************************************************
+ * @brief       memProfileReport
+ * @param       None
+ * @return      None
+ * @details     Log the placement profile and the heap left in internal,
+ * 				DMA capable and external RAM
+ *****************************************************************************/
+static void memProfileReport(void)
+{
+	ESP_LOGI(MEMTAG,MEM_INFO_PROFILE,MEM_PROFILE_NAME,MEM_FAST_FRAME_SLOTS);
+	ESP_LOGI(MEMTAG,MEM_INFO_HEAP,"Internal",heap_caps_get_free_size(MALLOC_CAP_INTERNAL),heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL),heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL));
+	ESP_LOGI(MEMTAG,MEM_INFO_HEAP,"DMA",heap_caps_get_free_size(MALLOC_CAP_DMA),heap_caps_get_largest_free_block(MALLOC_CAP_DMA),heap_caps_get_minimum_free_size(MALLOC_CAP_DMA));
+	ESP_LOGI(MEMTAG,MEM_INFO_HEAP,"PSRAM",heap_caps_get_free_size(MALLOC_CAP_SPIRAM),heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM),heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM));
+}//End memProfileReport
 
 /******************************************************************************
  * @brief       initCheck
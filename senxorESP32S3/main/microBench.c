@@ -0,0 +1,308 @@
+/*****************************************************************************
+ * @file     microBench.c
+ * @version  1.00
+ * @brief    On-target microbenchmarks, run by the BNCH command.
+ * @date	 14 Oct 2026
+ * @details	 Every test repeats one operation for BENCH_RUN_US in the task
+ * 			 of the command port that asked for it and reports the average.
+ * 			 Wall time from esp_timer is converted to CPU cycles at the
+ * 			 current clock, so a task preempted during a test shows up as
+ * 			 slower rather than as a wrong cycle count. Run them on an idle
+ * 			 device to compare boards: the same build on a quad and an octal
+ * 			 PSRAM module differs in the PSRAM copies only.
+ *
+ * 			 Buffers are allocated for the test and freed afterwards, the
+ * 			 frame sized ones take 10 kB of internal RAM each for 50 ms.
+ ******************************************************************************/
+#include <string.h>
+#include <errno.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include <esp_rom_sys.h>
+#include <lwip/sockets.h>
+#include <sdkconfig.h>
+
+#include "SenXorLib.h"
+#include "Drv_CRC.h"
+#include "util.h"
+#include "senxorTask.h"
+#include "quadrantMax.h"
+#include "microBench.h"
+
+#if CONFIG_MI_BENCH_EN
+//private:
+typedef struct benchCtx{
+	uint8_t* pSrc;
+	uint8_t* pDst;
+	uint8_t mXsplit;
+	uint8_t mYsplit;
+	int mTxSock;							//Loopback pair, -1 if not open
+	int mRxSock;
+}benchCtx_t;
+
+static volatile uint32_t mSink = 0;										//Keeps results the compiler would drop
+
+static bool microBench_Setup(const uint8_t test, benchCtx_t* pCtx, uint32_t* pBytes);
+static bool microBench_Step(const uint8_t test, benchCtx_t* pCtx);
+static void microBench_Teardown(benchCtx_t* pCtx);
+static bool microBench_OpenLoopback(benchCtx_t* pCtx);
+
+/*
+ * ***********************************************************************
+ * @brief       microBench_Run
+ * @param       test - benchTest_t
+ * 				pIterations - Operations done
+ * 				pCycles - Average CPU cycles per operation
+ * 				pBytesPerSec - Bytes moved or checked per second, 0 if the
+ * 				test has no payload
+ * @return      true if the test ran
+ * @details     Blocks the caller for about BENCH_RUN_US
+ **************************************************************************/
+bool microBench_Run(const uint8_t test, uint32_t* pIterations, uint32_t* pCycles, uint32_t* pBytesPerSec)
+{
+	benchCtx_t ctx = {
+		.pSrc = NULL,
+		.pDst = NULL,
+		.mTxSock = -1,
+		.mRxSock = -1
+	};
+	uint32_t bytes = 0;
+
+	if(test >= BENCH_TEST_COUNT || !microBench_Setup(test, &ctx, &bytes))
+	{
+		microBench_Teardown(&ctx);
+		return false;
+	}//End if
+
+	bool ok = true;
+	uint32_t iterations = 0;
+	int64_t elapsedUs;
+	const int64_t startUs = esp_timer_get_time();
+	do
+	{
+		for(uint8_t i = 0; i < BENCH_BATCH && ok; i++)
+		{
+			ok = microBench_Step(test, &ctx);
+		}//End for
+		iterations += BENCH_BATCH;
+		elapsedUs = esp_timer_get_time() - startUs;
+	} while(ok && elapsedUs < BENCH_RUN_US);
+	microBench_Teardown(&ctx);
+
+	if(!ok)
+	{
+		return false;
+	}//End if
+	*pIterations = iterations;
+	*pCycles = (uint32_t)((elapsedUs * esp_rom_get_cpu_ticks_per_us()) / iterations);
+	*pBytesPerSec = (uint32_t)(((uint64_t)bytes * iterations * 1000000) / elapsedUs);
+	ESP_LOGI(BENCHTAG, BENCH_INFO_RESULT, test, (unsigned long)*pIterations, (unsigned long)*pCycles, (unsigned long)*pBytesPerSec);
+	return true;
+}//End microBench_Run
+
+/*
+ * ***********************************************************************
+ * @brief       microBench_Setup
+ * @param       test - benchTest_t
+ * 				pCtx - Buffers and sockets of the test
+ * 				pBytes - Payload of one operation
+ * @return      false if a buffer or socket is not available
+ **************************************************************************/
+static bool microBench_Setup(const uint8_t test, benchCtx_t* pCtx, uint32_t* pBytes)
+{
+	uint32_t srcCaps = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+	uint32_t dstCaps = 0;												//No destination buffer
+
+	switch(test)
+	{
+		case BENCH_SPI_REG_READ:
+			*pBytes = 1;
+			return true;
+		case BENCH_MEMCPY_SRAM:
+			dstCaps = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+			break;
+		case BENCH_MEMCPY_PSRAM:
+			srcCaps = MALLOC_CAP_SPIRAM;
+			dstCaps = MALLOC_CAP_SPIRAM;
+			break;
+		case BENCH_MEMCPY_PSRAM_SRAM:
+			srcCaps = MALLOC_CAP_SPIRAM;
+			dstCaps = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+			break;
+		case BENCH_TCP_LOOPBACK:
+			srcCaps = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+			dstCaps = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+			break;
+		default:
+			break;
+	}//End switch
+
+	*pBytes = (test == BENCH_TCP_LOOPBACK) ? BENCH_TCP_CHUNK : BENCH_FRAME_BYTES;
+	pCtx->pSrc = heap_caps_malloc(BENCH_FRAME_BYTES, srcCaps);
+	pCtx->pDst = (dstCaps != 0) ? heap_caps_malloc(BENCH_FRAME_BYTES, dstCaps) : NULL;
+	if(pCtx->pSrc == NULL || (dstCaps != 0 && pCtx->pDst == NULL))
+	{
+		ESP_LOGE(BENCHTAG, BENCH_ERR_ALLOC, test, (srcCaps & MALLOC_CAP_SPIRAM) ? "PSRAM" : "internal RAM");
+		return false;
+	}//End if
+
+	uint16_t* pFrame = (uint16_t*)pCtx->pSrc;
+	for(uint16_t i = 0; i < BENCH_FRAME_BYTES / sizeof(uint16_t); i++)
+	{
+		pFrame[i] = 2930 + (i * 7) % 400;									//Room temperature and a little, in dK
+	}//End for
+	pCtx->mXsplit = quadrant_ReadRegister(0xC0);							//The split in use, as a frame is analysed
+	pCtx->mYsplit = quadrant_ReadRegister(0xC1);
+
+	return (test == BENCH_TCP_LOOPBACK) ? microBench_OpenLoopback(pCtx) : true;
+}//End microBench_Setup
+
+/*
+ * ***********************************************************************
+ * @brief       microBench_Step
+ * @param       test - benchTest_t
+ * 				pCtx - Buffers and sockets of the test
+ * @return      false if the operation failed
+ **************************************************************************/
+static bool microBench_Step(const uint8_t test, benchCtx_t* pCtx)
+{
+	const uint16_t* pImage = (const uint16_t*)pCtx->pSrc + 2 * SENXOR_FRAME_WIDTH;	//Image after the 2 header rows
+	uint16_t quadMax[4];
+
+	switch(test)
+	{
+		case BENCH_SPI_REG_READ:
+			mSink += Acces_Read_Reg(BENCH_SPI_REG);
+			return true;
+		case BENCH_MEMCPY_SRAM:
+		case BENCH_MEMCPY_PSRAM:
+		case BENCH_MEMCPY_PSRAM_SRAM:
+			memcpy(pCtx->pDst, pCtx->pSrc, BENCH_FRAME_BYTES);
+			mSink += pCtx->pDst[BENCH_FRAME_BYTES - 1];
+			return true;
+		case BENCH_QUADRANT_SCALAR:
+			quadrantMax_Scalar(pImage, pCtx->mXsplit, pCtx->mYsplit, quadMax);
+			mSink += quadMax[0];
+			return true;
+		case BENCH_QUADRANT_SIMD:
+			quadrantMax_Simd(pImage, pCtx->mXsplit, pCtx->mYsplit, quadMax);
+			mSink += quadMax[0];
+			return true;
+		case BENCH_CRC_SUM16:
+			mSink += getCRC(pCtx->pSrc, BENCH_FRAME_BYTES);
+			return true;
+		case BENCH_CRC16:
+			mSink += getCRC16(pCtx->pSrc, BENCH_FRAME_BYTES);
+			return true;
+		case BENCH_CRC32:
+			mSink += Drv_Crc_Crc32(0, pCtx->pSrc, BENCH_FRAME_BYTES);
+			return true;
+		case BENCH_TCP_LOOPBACK:
+		{
+			if(send(pCtx->mTxSock, pCtx->pSrc, BENCH_TCP_CHUNK, 0) != BENCH_TCP_CHUNK)
+			{
+				return false;
+			}//End if
+			int received = 0;
+			while(received < BENCH_TCP_CHUNK)
+			{
+				const int len = recv(pCtx->mRxSock, pCtx->pDst + received, BENCH_TCP_CHUNK - received, 0);
+				if(len <= 0)
+				{
+					return false;												//Timed out or closed
+				}//End if
+				received += len;
+			}//End while
+			return true;
+		}
+		default:
+			return false;
+	}//End switch
+}//End microBench_Step
+
+/*
+ * ***********************************************************************
+ * @brief       microBench_OpenLoopback
+ * @param       pCtx - Gets the connected pair
+ * @return      false if a socket call failed
+ * @details     Listen on an ephemeral port of 127.0.0.1, connect to it and
+ * 				accept. lwIP loops the segments back through tcpip_thread.
+ **************************************************************************/
+static bool microBench_OpenLoopback(benchCtx_t* pCtx)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_port = 0,
+		.sin_addr.s_addr = htonl(INADDR_LOOPBACK)
+	};
+	socklen_t addrLen = sizeof(addr);
+	const struct timeval timeout = {
+		.tv_sec = 0,
+		.tv_usec = BENCH_TCP_TIMEOUT_MS * 1000
+	};
+	const int nodelay = 1;
+	bool ok = false;
+
+	const int listenSock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if(listenSock >= 0 &&
+	   bind(listenSock, (struct sockaddr*)&addr, sizeof(addr)) == 0 &&
+	   listen(listenSock, 1) == 0 &&
+	   getsockname(listenSock, (struct sockaddr*)&addr, &addrLen) == 0)
+	{
+		pCtx->mTxSock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		if(pCtx->mTxSock >= 0 && connect(pCtx->mTxSock, (struct sockaddr*)&addr, sizeof(addr)) == 0)
+		{
+			pCtx->mRxSock = accept(listenSock, NULL, NULL);
+			ok = (pCtx->mRxSock >= 0);
+		}//End if
+	}//End if
+
+	if(ok)
+	{
+		setsockopt(pCtx->mTxSock, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));	//Every chunk goes out at once, as a frame does
+		setsockopt(pCtx->mRxSock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	}
+	else
+	{
+		ESP_LOGE(BENCHTAG, BENCH_ERR_SOCKET, errno);
+	}//End if-else
+	if(listenSock >= 0)
+	{
+		close(listenSock);
+	}//End if
+	return ok;
+}//End microBench_OpenLoopback
+
+/*
+ * ***********************************************************************
+ * @brief       microBench_Teardown
+ * @param       pCtx - Buffers and sockets to release
+ * @return      None
+ **************************************************************************/
+static void microBench_Teardown(benchCtx_t* pCtx)
+{
+	if(pCtx->mTxSock >= 0)
+	{
+		close(pCtx->mTxSock);
+	}//End if
+	if(pCtx->mRxSock >= 0)
+	{
+		close(pCtx->mRxSock);
+	}//End if
+	heap_caps_free(pCtx->pSrc);
+	heap_caps_free(pCtx->pDst);
+}//End microBench_Teardown
+
+#else
+
+bool microBench_Run(const uint8_t test, uint32_t* pIterations, uint32_t* pCycles, uint32_t* pBytesPerSec)
+{
+	(void)test;
+	(void)pIterations;
+	(void)pCycles;
+	(void)pBytesPerSec;
+	return false;
+}//End microBench_Run
+
+#endif
@@ -0,0 +1,376 @@
+/*****************************************************************************
+ * @file     mjpegStream.c
+ * @version  1.00
+ * @brief    JPEG snapshots and an MJPEG preview on the REST server.
+ * @date	 14 Oct 2026
+ * @details	 GET /snapshot.jpg answers with the next frame as a JPEG, GET
+ * 			 /mjpeg keeps the response open as a multipart stream that a
+ * 			 browser shows in a plain <img> tag.
+ *
+ * 			 Both hand their request to mjpegStreamTask with
+ * 			 httpd_req_async_handler_begin, so the httpd task is free again
+ * 			 at once. senxorTask copies a frame in at most MJPEG_FPS times a
+ * 			 second, and only while somebody waits. mjpegStreamTask colour
+ * 			 maps it with the snapshot's range and LUT, encodes it once and
+ * 			 sends the same JPEG to every client. It runs on core 0, next
+ * 			 to the network, so the encode never delays a capture.
+ *
+ * 			 A slow viewer delays the others by at most the httpd send
+ * 			 timeout, then its session is dropped.
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <esp_log.h>
+#include <esp_attr.h>
+#include <esp_timer.h>
+#include <esp_http_server.h>
+#include <sdkconfig.h>
+
+#include "restServer.h"
+#include "simpleGFX.h"
+#include "jpegEnc.h"
+#include "frameSnapshot.h"
+#include "mjpegStream.h"
+#include "senxorTask.h"
+
+#if CONFIG_MI_SNAP_JPEG_EN
+//private:
+EXT_RAM_BSS_ATTR static uint16_t mImage[SNAP_IMAGE_W * SNAP_IMAGE_H];	//Written by senxorTask while !mImageReady
+EXT_RAM_BSS_ATTR static uint16_t mRgb[MJPEG_W * MJPEG_H];				//mjpegStreamTask
+EXT_RAM_BSS_ATTR static uint8_t mJpeg[MJPEG_OUT_SIZE];					//Shared by every client of one frame
+static jpegEncoder_t mEncoder;
+static gfxColourLut_t mLut;
+static mjpegClient_t mClients[MJPEG_MAX_CLIENTS + MJPEG_MAX_WAITING];	//mjpegStreamTask only
+static QueueHandle_t mNewClients = NULL;								//Async requests from the httpd task
+static TaskHandle_t mTaskHandle = NULL;
+static volatile bool mImageReady = false;								//mImage holds a frame not encoded yet
+static volatile uint8_t mStreamCount = 0;
+static volatile uint8_t mWaitCount = 0;
+static int64_t mLastFrameUs = 0;										//senxorTask
+
+static esp_err_t mjpegStream_Handler(httpd_req_t *req);
+static void mjpegStream_Accept(void);
+static void mjpegStream_Encode(void);
+static void mjpegStream_Send(const size_t len);
+static void mjpegStream_Expire(void);
+static void mjpegStream_Remove(const uint8_t idx);
+
+/*
+ * ***********************************************************************
+ * @brief       mjpegStreamTask
+ * @param       pvParameters - Not used
+ * @return      None
+ * @details     Register MJPEG_SNAP_URI and MJPEG_STREAM_URI on the REST
+ * 				server, then encode every frame senxorTask hands over
+ **************************************************************************/
+void mjpegStreamTask(void *pvParameters)
+{
+	mTaskHandle = xTaskGetCurrentTaskHandle();
+	mNewClients = xQueueCreate(MJPEG_QUEUE_LEN, sizeof(mjpegClient_t));
+	memset(mClients, 0, sizeof(mClients));
+	jpegEncSetQuality(&mEncoder, CONFIG_MI_SNAP_JPEG_QUALITY);
+	gfxLutReset(&mLut);
+
+	httpd_handle_t server = getRestServerHandler();
+	if(server == NULL)
+	{
+		ESP_LOGE(MJPEGTAG, MJPEG_ERR_NO_SERVER);
+		vTaskDelete(NULL);
+	}//End if
+
+	const httpd_uri_t uris[] = {
+		{.uri = MJPEG_SNAP_URI, .method = HTTP_GET, .handler = mjpegStream_Handler, .user_ctx = (void*)false},
+		{.uri = MJPEG_STREAM_URI, .method = HTTP_GET, .handler = mjpegStream_Handler, .user_ctx = (void*)true}
+	};
+	for(uint8_t i = 0; i < sizeof(uris) / sizeof(uris[0]); i++)
+	{
+		const esp_err_t err = httpd_register_uri_handler(server, &uris[i]);
+		if(err != ESP_OK)
+		{
+			ESP_LOGE(MJPEGTAG, MJPEG_ERR_REGISTER, uris[i].uri, esp_err_to_name(err));
+		}//End if
+	}//End for
+	ESP_LOGI(MJPEGTAG, MJPEG_INFO_START, MJPEG_W, MJPEG_H, mEncoder.mQuality, MJPEG_FPS);
+
+	for(;;)
+	{
+		ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(MJPEG_WAIT_MS));			//Woken by a frame or a new request
+		mjpegStream_Accept();
+		if(mImageReady)
+		{
+			mjpegStream_Encode();
+		}//End if
+		mjpegStream_Expire();
+	}//End for
+}//End mjpegStreamTask
+
+/*
+ * ***********************************************************************
+ * @brief       mjpegOnFrame
+ * @param       pImage - Image of the frame, header rows removed
+ * @return      None
+ * @details     Called by senxorTask for every frame. Copies the image when
+ * 				a client waits, the last one is encoded and a stream is due.
+ **************************************************************************/
+void mjpegOnFrame(const uint16_t* pImage)
+{
+	if(mImageReady || (mStreamCount == 0 && mWaitCount == 0))
+	{
+		return;
+	}//End if
+
+	const int64_t nowUs = esp_timer_get_time();
+	if(mWaitCount == 0 && nowUs - mLastFrameUs < MJPEG_PERIOD_US)
+	{
+		return;																//A snapshot takes the next frame, a stream keeps its rate
+	}//End if
+	mLastFrameUs = nowUs;
+	memcpy(mImage, pImage, sizeof(mImage));
+	mImageReady = true;
+	xTaskNotifyGive(mTaskHandle);
+}//End mjpegOnFrame
+
+/*
+ * ***********************************************************************
+ * @brief       mjpegGetDemandHz
+ * @param       None
+ * @return      Capture rate the clients need, 0 if there are none
+ **************************************************************************/
+uint8_t mjpegGetDemandHz(void)
+{
+	if(mStreamCount > 0)
+	{
+		return MJPEG_FPS;
+	}//End if
+	return (mWaitCount > 0) ? SNAP_DEMAND_HZ : 0;
+}//End mjpegGetDemandHz
+
+/*
+ * ***********************************************************************
+ * @brief       mjpegStream_Handler
+ * @param       req - HTTP request, user_ctx true for the stream
+ * @return      ESP_OK, or an error to have httpd close the session
+ * @details     Runs in the httpd task. Hands an async copy of the request
+ * 				to mjpegStreamTask, which answers and completes it.
+ **************************************************************************/
+static esp_err_t mjpegStream_Handler(httpd_req_t *req)
+{
+	mjpegClient_t client = {
+		.pReq = NULL,
+		.mSinceUs = esp_timer_get_time(),
+		.mFramesSent = 0,
+		.mIsStream = (bool)req->user_ctx
+	};
+
+	esp_err_t err = httpd_req_async_handler_begin(req, &client.pReq);
+	if(err != ESP_OK)
+	{
+		return err;
+	}//End if
+	if(xQueueSend(mNewClients, &client, 0) != pdTRUE)
+	{
+		httpd_resp_set_status(client.pReq, "503 Service Unavailable");
+		httpd_resp_sendstr(client.pReq, MJPEG_ERR_FULL);
+		return httpd_req_async_handler_complete(client.pReq);
+	}//End if
+	xTaskNotifyGive(mTaskHandle);
+	return ESP_OK;
+}//End mjpegStream_Handler
+
+/*
+ * ***********************************************************************
+ * @brief       mjpegStream_Accept
+ * @param       None
+ * @return      None
+ * @details     Move new requests into mClients. A stream sends its
+ * 				response header now, the parts follow frame by frame.
+ **************************************************************************/
+static void mjpegStream_Accept(void)
+{
+	mjpegClient_t client;
+	bool changed = false;
+
+	while(xQueueReceive(mNewClients, &client, 0) == pdTRUE)
+	{
+		uint8_t idx = 0;
+		const uint8_t first = client.mIsStream ? 0 : MJPEG_MAX_CLIENTS;	//Streams and snapshots have slots of their own
+		const uint8_t last = client.mIsStream ? MJPEG_MAX_CLIENTS : MJPEG_MAX_CLIENTS + MJPEG_MAX_WAITING;
+		for(idx = first; idx < last && mClients[idx].pReq != NULL; idx++)
+		{
+		}//End for
+		if(idx == last)
+		{
+			httpd_resp_set_status(client.pReq, "503 Service Unavailable");
+			httpd_resp_sendstr(client.pReq, MJPEG_ERR_FULL);
+			httpd_req_async_handler_complete(client.pReq);
+			continue;
+		}//End if
+
+		mClients[idx] = client;
+		if(client.mIsStream)
+		{
+			httpd_resp_set_type(client.pReq, "multipart/x-mixed-replace; boundary=" MJPEG_BOUNDARY);
+			httpd_resp_set_hdr(client.pReq, "Cache-Control", "no-cache");
+			mStreamCount++;
+			ESP_LOGI(MJPEGTAG, MJPEG_INFO_JOIN, httpd_req_to_sockfd(client.pReq), mStreamCount);
+		}
+		else
+		{
+			mWaitCount++;
+		}//End if-else
+		changed = true;
+	}//End while
+
+	if(changed)
+	{
+		senxorTaskNotifyClientChange();										//Demand changed
+	}//End if
+}//End mjpegStream_Accept
+
+/*
+ * ***********************************************************************
+ * @brief       mjpegStream_Encode
+ * @param       None
+ * @return      None
+ * @details     Colour map and scale mImage into mRgb, release mImage to
+ * 				senxorTask, then encode and send
+ **************************************************************************/
+static void mjpegStream_Encode(void)
+{
+	uint16_t minVal;
+	uint16_t maxVal;
+#if !CONFIG_MI_SNAP_JPEG_BILINEAR
+	uint16_t colour[SNAP_IMAGE_W];
+#endif
+
+	frameSnapshotGetRange(mImage, &minVal, &maxVal);
+	gfxLutUpdate(&mLut, minVal, maxVal, CONFIG_MI_SNAP_COLOURMAP);
+	for(uint16_t y = 0; y < MJPEG_H; y++)
+	{
+		uint16_t* pLine = &mRgb[y * MJPEG_W];
+#if CONFIG_MI_SNAP_JPEG_BILINEAR
+		gfxUpscaleBilinearRow(mImage, SNAP_IMAGE_W, SNAP_IMAGE_H, MJPEG_SCALE, y, 0, MJPEG_W, pLine);
+		gfxLutMapRow(&mLut, pLine, pLine, MJPEG_W);
+#else
+		if(y % MJPEG_SCALE == 0)
+		{
+			gfxLutMapRow(&mLut, &mImage[(y / MJPEG_SCALE) * SNAP_IMAGE_W], colour, SNAP_IMAGE_W);	//Colours of the next source row
+		}//End if
+		gfxUpscaleNearestRow(colour, SNAP_IMAGE_W, MJPEG_SCALE, pLine);
+#endif
+	}//End for
+	mImageReady = false;
+
+	const size_t len = jpegEncodeRgb565(&mEncoder, mRgb, MJPEG_W, MJPEG_H, mJpeg, sizeof(mJpeg));
+	if(len == 0)
+	{
+		ESP_LOGW(MJPEGTAG, MJPEG_WARN_SIZE, mEncoder.mQuality, (int)sizeof(mJpeg));
+		return;
+	}//End if
+	mjpegStream_Send(len);
+}//End mjpegStream_Encode
+
+/*
+ * ***********************************************************************
+ * @brief       mjpegStream_Send
+ * @param       len - Bytes of the JPEG in mJpeg
+ * @return      None
+ * @details     One multipart part to every stream, the whole file to every
+ * 				waiting snapshot
+ **************************************************************************/
+static void mjpegStream_Send(const size_t len)
+{
+	char part[MJPEG_PART_MAX];
+	const int partLen = snprintf(part, sizeof(part), "\r\n--" MJPEG_BOUNDARY "\r\nContent-Type: image/jpeg\r\nContent-Length: %u\r\n\r\n", (unsigned)len);
+
+	for(uint8_t i = 0; i < MJPEG_MAX_CLIENTS + MJPEG_MAX_WAITING; i++)
+	{
+		httpd_req_t* pReq = mClients[i].pReq;
+		if(pReq == NULL)
+		{
+			continue;
+		}//End if
+
+		esp_err_t err;
+		if(mClients[i].mIsStream)
+		{
+			err = httpd_resp_send_chunk(pReq, part, partLen);
+			if(err == ESP_OK)
+			{
+				err = httpd_resp_send_chunk(pReq, (const char*)mJpeg, len);
+			}//End if
+			if(err == ESP_OK)
+			{
+				mClients[i].mFramesSent++;
+				continue;
+			}//End if
+		}
+		else
+		{
+			httpd_resp_set_type(pReq, "image/jpeg");
+			httpd_resp_send(pReq, (const char*)mJpeg, len);
+		}//End if-else
+		mjpegStream_Remove(i);												//Snapshot answered, or the viewer is gone
+	}//End for
+}//End mjpegStream_Send
+
+/*
+ * ***********************************************************************
+ * @brief       mjpegStream_Expire
+ * @param       None
+ * @return      None
+ * @details     Answer snapshots that waited SNAP_WAIT_MS without a frame
+ **************************************************************************/
+static void mjpegStream_Expire(void)
+{
+	const int64_t nowUs = esp_timer_get_time();
+
+	for(uint8_t i = MJPEG_MAX_CLIENTS; i < MJPEG_MAX_CLIENTS + MJPEG_MAX_WAITING; i++)
+	{
+		if(mClients[i].pReq != NULL && nowUs - mClients[i].mSinceUs > SNAP_WAIT_MS * 1000LL)
+		{
+			httpd_resp_send_err(mClients[i].pReq, HTTPD_500_INTERNAL_SERVER_ERROR, SNAP_ERR_NO_FRAME);
+			mjpegStream_Remove(i);
+		}//End if
+	}//End for
+}//End mjpegStream_Expire
+
+/*
+ * ***********************************************************************
+ * @brief       mjpegStream_Remove
+ * @param       idx - Entry of mClients
+ * @return      None
+ * @details     Complete the async request and free the entry
+ **************************************************************************/
+static void mjpegStream_Remove(const uint8_t idx)
+{
+	if(mClients[idx].mIsStream)
+	{
+		ESP_LOGI(MJPEGTAG, MJPEG_INFO_LEFT, httpd_req_to_sockfd(mClients[idx].pReq), mClients[idx].mFramesSent);
+		mStreamCount--;
+	}
+	else
+	{
+		mWaitCount--;
+	}//End if-else
+	httpd_req_async_handler_complete(mClients[idx].pReq);
+	mClients[idx].pReq = NULL;
+	senxorTaskNotifyClientChange();											//Demand changed
+}//End mjpegStream_Remove
+
+#else
+
+void mjpegOnFrame(const uint16_t* pImage)
+{
+	(void)pImage;
+}//End mjpegOnFrame
+
+uint8_t mjpegGetDemandHz(void)
+{
+	return 0;
+}//End mjpegGetDemandHz
+
+#endif
@@ -0,0 +1,388 @@
+/*****************************************************************************
+ * @file     mqttPublish.c
+ * @version  1.01
+ * @brief    ROI statistics and alarm rule events to an MQTT broker.
+ * @date	 15 Oct 2026
+ * @details	 senxorTask adds an ROI sample to the open batch every
+ * 			 MQTT_SAMPLE_PERIOD_MS with mqttPublishOnFrame, which only
+ * 			 copies and never waits. A batch closes after
+ * 			 MQTT_BATCH_WINDOW_MS, or when the next sample may not fit,
+ * 			 and waits in one of MQTT_QUEUE_LEN slots for mqttPublishTask.
+ * 			 With every slot waiting, the oldest batch is dropped, so a
+ * 			 broker outage costs data and never holds up capture.
+ *
+ * 			 mqttPublishTask runs on core 0 and publishes the batches and
+ * 			 every rule event in compact binary messages, see protocol.md.
+ * 			 Nothing is published while the client is disconnected; the
+ * 			 rule events wait in the ruleEngine ring meanwhile.
+ *
+ * 			 Topics are <prefix>/<device ID>/roi, events and status. The
+ * 			 device ID is the BT MAC of the Device ID registers. The status
+ * 			 is retained, "offline" is the last will.
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <esp_attr.h>
+#include <esp_log.h>
+#include <esp_mac.h>
+#include <esp_timer.h>
+#include <mqtt_client.h>
+#include <sdkconfig.h>
+
+#include "DrvWLAN.h"
+#include "FrameStats.h"
+#include "mqttPublish.h"
+#include "roiEngine.h"
+#include "ruleEngine.h"
+#include "senxorTask.h"
+#include "protoSchema.h"
+
+#if CONFIG_MI_MQTT_EN
+
+_Static_assert(MQTT_BATCH_WINDOW_MS <= UINT16_MAX, "Sample offsets are 16 bit");
+_Static_assert(sizeof(mqttBatchHeader_t) + MQTT_SAMPLE_MAX <= MQTT_BATCH_MAX, "A batch must hold one sample");
+PROTO_CHECK_MQTT_BATCH_HEADER(mqttBatchHeader_t);
+PROTO_CHECK_MQTT_SAMPLE(mqttSample_t);
+PROTO_CHECK_MQTT_ROI_ENTRY(mqttRoiEntry_t);
+PROTO_CHECK_MQTT_EVENT_ENTRY(mqttEventEntry_t);
+
+//private:
+EXT_RAM_BSS_ATTR static uint8_t mBatch[MQTT_QUEUE_LEN][MQTT_BATCH_MAX];
+static uint16_t mBatchLen[MQTT_QUEUE_LEN];
+static QueueHandle_t mFreeQueue = NULL;								//Slots free to fill
+static QueueHandle_t mReadyQueue = NULL;								//Closed batches, oldest first
+static TaskHandle_t mTaskHandle = NULL;								//Set once the client is started
+static esp_mqtt_client_handle_t mClient = NULL;
+static volatile bool mIsConnected = false;
+static volatile uint32_t mDropped = 0;									//Batches dropped for a newer one
+
+// Open batch, senxorTask only
+static bool mIsOpen = false;
+static uint8_t mSlot = 0;
+static int64_t mBatchStartUs = 0;
+static int64_t mNextSampleUs = 0;
+
+// mqttPublishTask only
+static uint32_t mRuleCursor = 0;
+static char mTopicRoi[MQTT_TOPIC_MAX];
+static char mTopicEvents[MQTT_TOPIC_MAX];
+static char mTopicStatus[MQTT_TOPIC_MAX];
+static uint8_t mEventMsg[2 + RULE_EVENT_RING * sizeof(mqttEventEntry_t)];
+
+static void mqttPublish_EventHandler(void* pArgs, esp_event_base_t base, int32_t eventId, void* pEventData);
+static bool mqttPublish_OpenBatch(const int64_t now, const uint32_t seq);
+static void mqttPublish_CloseBatch(void);
+static void mqttPublish_SendEvents(void);
+static void mqttPublish_SendBatches(void);
+
+/*
+ * ***********************************************************************
+ * @brief       mqttPublishTask
+ * @param       pvParameters - Not used
+ * @return      None
+ * @details     Start the client and publish what senxorTask staged.
+ * 				Must start after the network is up.
+ **************************************************************************/
+void mqttPublishTask(void *pvParameters)
+{
+	uint8_t deviceId[6];
+	char clientId[24];
+
+	if(strlen(CONFIG_MI_MQTT_BROKER_URI) == 0)
+	{
+		ESP_LOGW(MQTTTAG, MQTT_ERR_NO_BROKER);
+		vTaskDelete(NULL);
+	}//End if
+
+	esp_read_mac(deviceId, ESP_MAC_BT);
+	snprintf(clientId, sizeof(clientId), "senxor-%02X%02X%02X%02X%02X%02X",
+			deviceId[0], deviceId[1], deviceId[2], deviceId[3], deviceId[4], deviceId[5]);
+	snprintf(mTopicRoi, sizeof(mTopicRoi), "%s/%s/" MQTT_TOPIC_ROI, CONFIG_MI_MQTT_TOPIC_PREFIX, &clientId[7]);
+	snprintf(mTopicEvents, sizeof(mTopicEvents), "%s/%s/" MQTT_TOPIC_EVENTS, CONFIG_MI_MQTT_TOPIC_PREFIX, &clientId[7]);
+	snprintf(mTopicStatus, sizeof(mTopicStatus), "%s/%s/" MQTT_TOPIC_STATUS, CONFIG_MI_MQTT_TOPIC_PREFIX, &clientId[7]);
+
+	mFreeQueue = xQueueCreate(MQTT_QUEUE_LEN, sizeof(uint8_t));
+	mReadyQueue = xQueueCreate(MQTT_QUEUE_LEN, sizeof(uint8_t));
+	for(uint8_t i = 0; i < MQTT_QUEUE_LEN; i++)
+	{
+		xQueueSend(mFreeQueue, &i, 0);
+	}//End for
+	mRuleCursor = ruleEngine_GetEventCount();
+
+	const esp_mqtt_client_config_t config = {
+		.broker.address.uri = CONFIG_MI_MQTT_BROKER_URI,
+		.credentials.client_id = clientId,
+		.session.last_will = {
+			.topic = mTopicStatus,
+			.msg = MQTT_STATUS_OFFLINE,
+			.qos = 1,
+			.retain = 1
+		},
+		.outbox.limit = MQTT_QUEUE_LEN * MQTT_BATCH_MAX,				//QoS 1 and 2 messages not acknowledged yet
+	};
+	mClient = esp_mqtt_client_init(&config);
+	if(mClient == NULL
+			|| esp_mqtt_client_register_event(mClient, ESP_EVENT_ANY_ID, mqttPublish_EventHandler, NULL) != ESP_OK
+			|| esp_mqtt_client_start(mClient) != ESP_OK)
+	{
+		ESP_LOGE(MQTTTAG, MQTT_ERR_INIT);
+		vTaskDelete(NULL);
+	}//End if
+	ESP_LOGI(MQTTTAG, MQTT_INFO_START, CONFIG_MI_MQTT_BROKER_URI, CONFIG_MI_MQTT_TOPIC_PREFIX, &clientId[7], CONFIG_MI_MQTT_QOS);
+
+	mTaskHandle = xTaskGetCurrentTaskHandle();
+	senxorTaskNotifyClientChange();										//Capture demand changed
+
+	for(;;)
+	{
+		ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(MQTT_WAIT_MS));		//Woken by a batch, a rule event or the connection
+		if(mIsConnected)
+		{
+			mqttPublish_SendEvents();
+			mqttPublish_SendBatches();
+		}//End if
+	}//End for
+}//End mqttPublishTask
+
+/*
+ * ***********************************************************************
+ * @brief       mqttPublishOnFrame
+ * @param       seq - Capture sequence number of the analysed frame
+ * @return      None
+ * @details     Called by senxorTask after the ROI analysis. Adds a sample
+ * 				to the open batch when one is due, closes the batch once
+ * 				its window is over and wakes the task.
+ **************************************************************************/
+void mqttPublishOnFrame(const uint32_t seq)
+{
+	if(mTaskHandle == NULL)
+	{
+		return;
+	}//End if
+
+	const int64_t now = esp_timer_get_time();
+	if(now < mNextSampleUs)
+	{
+		return;
+	}//End if
+	mNextSampleUs = now + MQTT_SAMPLE_PERIOD_MS * 1000LL;
+
+	if(!mIsOpen && !mqttPublish_OpenBatch(now, seq))
+	{
+		return;
+	}//End if
+
+	uint8_t* pBatch = mBatch[mSlot];
+	mqttBatchHeader_t* pHeader = (mqttBatchHeader_t*)pBatch;
+	mqttSample_t* pSample = (mqttSample_t*)&pBatch[mBatchLen[mSlot]];
+	mqttRoiEntry_t* pEntry = (mqttRoiEntry_t*)&pBatch[mBatchLen[mSlot] + sizeof(mqttSample_t)];
+	roiStats_t stats;
+	frameStats_t frameStats;
+
+	pSample->mOffsetMs = (uint16_t)((now - mBatchStartUs) / 1000);
+	pSample->mCount = 0;
+	for(uint8_t i = 0; i < ROI_MAX_COUNT; i++)
+	{
+		if(roiEngine_GetStats(i, &stats) && stats.mPixels > 0)
+		{
+			pEntry[pSample->mCount++] = (mqttRoiEntry_t){ i, stats.mMin, stats.mMax, stats.mMean, stats.mPercentile };
+		}//End if
+	}//End for
+	FrameStats_Get(&frameStats);
+	pEntry[pSample->mCount++] = (mqttRoiEntry_t){ MQTT_ROI_FRAME, frameStats.mMin, frameStats.mMax, frameStats.mMean, frameStats.mP99 };
+
+	mBatchLen[mSlot] += sizeof(mqttSample_t) + pSample->mCount * sizeof(mqttRoiEntry_t);
+	pHeader->mSamples++;
+
+	const bool isWindowOver = now + MQTT_SAMPLE_PERIOD_MS * 1000LL - mBatchStartUs > MQTT_BATCH_WINDOW_MS * 1000LL;
+	if(isWindowOver || mBatchLen[mSlot] + MQTT_SAMPLE_MAX > MQTT_BATCH_MAX || pHeader->mSamples == UINT8_MAX)
+	{
+		mqttPublish_CloseBatch();
+	}//End if
+}//End mqttPublishOnFrame
+
+/*
+ * ***********************************************************************
+ * @brief       mqttPublishNotifyRule
+ * @param       None
+ * @return      None
+ * @details     Called by senxorTask when an alarm rule was raised or cleared
+ **************************************************************************/
+void mqttPublishNotifyRule(void)
+{
+	if(mTaskHandle != NULL)
+	{
+		xTaskNotifyGive(mTaskHandle);
+	}//End if
+}//End mqttPublishNotifyRule
+
+/*
+ * ***********************************************************************
+ * @brief       mqttPublishGetDemandHz
+ * @param       None
+ * @return      Frames per second the samples need, 0 if not running
+ **************************************************************************/
+uint8_t mqttPublishGetDemandHz(void)
+{
+	return (mTaskHandle != NULL) ? MQTT_DEMAND_HZ : 0;
+}//End mqttPublishGetDemandHz
+
+/*
+ * ***********************************************************************
+ * @brief       mqttPublish_EventHandler
+ * @param       pArgs - Not used
+ * 				base - MQTT_EVENTS
+ * 				eventId - esp_mqtt_event_id_t
+ * 				pEventData - esp_mqtt_event_handle_t
+ * @return      None
+ * @details     Runs in the task of the MQTT client
+ **************************************************************************/
+static void mqttPublish_EventHandler(void* pArgs, esp_event_base_t base, int32_t eventId, void* pEventData)
+{
+	switch(eventId)
+	{
+		case MQTT_EVENT_CONNECTED:
+			esp_mqtt_client_publish(mClient, mTopicStatus, MQTT_STATUS_ONLINE, 0, 1, 1);
+			mIsConnected = true;
+			ESP_LOGI(MQTTTAG, MQTT_INFO_CONNECTED, (unsigned)uxQueueMessagesWaiting(mReadyQueue));
+			if(mTaskHandle != NULL)										//The first connection may beat the task
+			{
+				xTaskNotifyGive(mTaskHandle);
+			}//End if
+			break;
+		case MQTT_EVENT_DISCONNECTED:
+			if(mIsConnected)
+			{
+				ESP_LOGW(MQTTTAG, MQTT_INFO_DISCONNECTED, (unsigned long)mDropped);
+			}//End if
+			mIsConnected = false;										//The client reconnects by itself
+			break;
+		default:
+			break;
+	}//End switch
+}//End mqttPublish_EventHandler
+
+/*
+ * ***********************************************************************
+ * @brief       mqttPublish_OpenBatch
+ * @param       now - Time of the first sample
+ * 				seq - Capture sequence number of the first sample
+ * @return      False if no slot is free
+ * @details     Takes a free slot, or the oldest waiting batch when the
+ * 				broker is behind
+ **************************************************************************/
+static bool mqttPublish_OpenBatch(const int64_t now, const uint32_t seq)
+{
+	if(xQueueReceive(mFreeQueue, &mSlot, 0) != pdTRUE)
+	{
+		if(xQueueReceive(mReadyQueue, &mSlot, 0) != pdTRUE)
+		{
+			return false;												//Every slot is being published
+		}//End if
+		++mDropped;
+	}//End if
+
+	mqttBatchHeader_t* pHeader = (mqttBatchHeader_t*)mBatch[mSlot];
+	pHeader->mVersion = MQTT_VERSION;
+	pHeader->mSamples = 0;
+	pHeader->mPeriodMs = MQTT_SAMPLE_PERIOD_MS;
+	pHeader->mUptimeMs = (uint32_t)(now / 1000);
+	pHeader->mSeq = seq;
+	const int64_t utcOffsetUs = Drv_WLAN_getUtcOffsetUs();
+	pHeader->mUtcMs = (utcOffsetUs != 0) ? (uint64_t)((now + utcOffsetUs) / 1000) : 0;
+	mBatchLen[mSlot] = sizeof(mqttBatchHeader_t);
+	mBatchStartUs = now;
+	mIsOpen = true;
+	return true;
+}//End mqttPublish_OpenBatch
+
+/*
+ * ***********************************************************************
+ * @brief       mqttPublish_CloseBatch
+ * @param       None
+ * @return      None
+ * @details     The ready queue holds every slot, so this never fails
+ **************************************************************************/
+static void mqttPublish_CloseBatch(void)
+{
+	xQueueSend(mReadyQueue, &mSlot, 0);
+	mIsOpen = false;
+	xTaskNotifyGive(mTaskHandle);
+}//End mqttPublish_CloseBatch
+
+/*
+ * ***********************************************************************
+ * @brief       mqttPublish_SendEvents
+ * @param       None
+ * @return      None
+ * @details     Publish every rule event since the last message in one
+ * 				message. The cursor only moves on once it is published.
+ **************************************************************************/
+static void mqttPublish_SendEvents(void)
+{
+	uint32_t cursor = mRuleCursor;
+	ruleEvent_t event;
+	uint8_t count = 0;
+
+	mqttEventEntry_t* pEntry = (mqttEventEntry_t*)&mEventMsg[2];
+	while(count < RULE_EVENT_RING && ruleEngine_GetEvent(&cursor, &event))
+	{
+		pEntry[count++] = (mqttEventEntry_t){ event.mRule, event.mRaised ? 1 : 0, event.mValue, event.mActive, event.mSeq };
+	}//End while
+	if(count == 0)
+	{
+		return;
+	}//End if
+
+	mEventMsg[0] = MQTT_VERSION;
+	mEventMsg[1] = count;
+	if(esp_mqtt_client_publish(mClient, mTopicEvents, (const char*)mEventMsg, 2 + count * sizeof(mqttEventEntry_t), CONFIG_MI_MQTT_QOS, 0) >= 0)
+	{
+		mRuleCursor = cursor;
+	}//End if
+}//End mqttPublish_SendEvents
+
+/*
+ * ***********************************************************************
+ * @brief       mqttPublish_SendBatches
+ * @param       None
+ * @return      None
+ * @details     Publish the waiting batches, oldest first. A batch that
+ * 				fails goes back to the front and waits for the next
+ * 				connection. Rule events go between two batches.
+ **************************************************************************/
+static void mqttPublish_SendBatches(void)
+{
+	uint8_t slot;
+
+	while(mIsConnected && xQueueReceive(mReadyQueue, &slot, 0) == pdTRUE)
+	{
+		if(esp_mqtt_client_publish(mClient, mTopicRoi, (const char*)mBatch[slot], mBatchLen[slot], CONFIG_MI_MQTT_QOS, 0) < 0)
+		{
+			xQueueSendToFront(mReadyQueue, &slot, 0);
+			return;
+		}//End if
+		xQueueSend(mFreeQueue, &slot, 0);
+		mqttPublish_SendEvents();
+	}//End while
+}//End mqttPublish_SendBatches
+
+#else
+
+void mqttPublishOnFrame(const uint32_t seq)
+{
+}//End mqttPublishOnFrame
+
+void mqttPublishNotifyRule(void)
+{
+}//End mqttPublishNotifyRule
+
+uint8_t mqttPublishGetDemandHz(void)
+{
+	return 0;
+}//End mqttPublishGetDemandHz
+
+#endif
@@ -0,0 +1,336 @@
+/*****************************************************************************
+ * @file     pixelCorrect.c
+ * @version  1.00
+ * @brief    Persistent per-pixel gain and offset correction map.
+ * @date	 15 Oct 2026
+ * @details	 Corrects the emissivity of surfaces such as stainless hoods
+ * 			 and pans, region by region: every image pixel has a Q2.14 gain
+ * 			 and an offset in raw frame units. The unit conversion pass of
+ * 			 Customer_Interface.c applies them with the bad pixel patch, so
+ * 			 the map costs no extra pass over the frame. It is read for
+ * 			 every pixel of every frame and so kept in internal RAM.
+ *
+ * 			 Clients upload the map in chunks with CORR into a PSRAM buffer
+ * 			 that starts as the map in use, then commit it. senxorTask
+ * 			 copies a commit in between two frames, the esp_timer task
+ * 			 saves it to NVS as runs of equal pixels. A map of more than
+ * 			 PIXCORR_MAX_RUNS runs is applied but not saved.
+ ******************************************************************************/
+#include <string.h>
+#include <sys/param.h>
+#include <freertos/FreeRTOS.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_attr.h>
+
+#include "DrvNVS.h"
+#include "pixelCorrect.h"
+
+#if CONFIG_MI_PIXCORR_EN
+
+//private:
+static convCorr_t mMap[PIXCORR_PIXELS];								//Map in use
+EXT_RAM_BSS_ATTR static convCorr_t mUpload[PIXCORR_PIXELS];			//Map in use and the CORR writes since
+EXT_RAM_BSS_ATTR static convCorr_t mCommitted[PIXCORR_PIXELS];		//Last commit, copied by senxorTask and saved by the esp_timer task
+static pixCorrStore_t mStore;										//NVS image, internal RAM for the flash write
+static portMUX_TYPE mLock = portMUX_INITIALIZER_UNLOCKED;
+static esp_timer_handle_t mSaveTimer = NULL;						//NVS writes run in the esp_timer task, its stack is internal RAM
+
+static volatile bool mSwapPending = false;							//Set by a commit, cleared by senxorTask
+static volatile bool mSavePending = false;							//Set by a commit, cleared by the save
+static volatile bool mEnabled = false;
+static volatile bool mSaved = true;
+static volatile uint16_t mWritten = 0;								//Pixels written since the last commit
+
+static bool pixelCorrect_IsIdentity(const convCorr_t* pMap);
+static uint16_t pixelCorrect_Encode(const convCorr_t* pMap, pixCorrStore_t* pStore);
+static bool pixelCorrect_Decode(const pixCorrStore_t* pStore, convCorr_t* pMap);
+static void pixelCorrect_SaveTimerCallback(void* arg);
+
+/*
+ * ***********************************************************************
+ * @brief       pixelCorrect_Init
+ * @param       None
+ * @return      None
+ * @details     Load the map from NVS and hand it to the conversion pass
+ **************************************************************************/
+void pixelCorrect_Init(void)
+{
+	for (uint16_t i = 0; i < PIXCORR_PIXELS; i++)
+	{
+		mMap[i].mGain = CONV_GAIN_UNITY;
+		mMap[i].mOffset = 0;
+	}//End for
+
+	if (NVS_ReadBlob(PIXCORR_NVS_KEY, &mStore, sizeof(mStore)) && mStore.mVersion == PIXCORR_VERSION && mStore.mRuns > 0)
+	{
+		if (!pixelCorrect_Decode(&mStore, mMap))
+		{
+			pixelCorrect_Decode(NULL, mMap);
+		}//End if
+	}//End if
+	memcpy(mUpload, mMap, sizeof(mUpload));
+	memcpy(mCommitted, mMap, sizeof(mCommitted));
+
+	mEnabled = !pixelCorrect_IsIdentity(mMap);
+	Customer_SetPixelCorrection(mEnabled ? mMap : NULL);
+
+	const esp_timer_create_args_t saveTimerArgs = {
+		.callback = pixelCorrect_SaveTimerCallback,
+		.name = "pixcorrsave"
+	};
+	esp_timer_create(&saveTimerArgs, &mSaveTimer);
+
+	ESP_LOGI(PIXCORRTAG, PIXCORR_INFO_INIT, mEnabled ? mStore.mRuns : 0);
+}//End pixelCorrect_Init
+
+/*
+ * ***********************************************************************
+ * @brief       pixelCorrect_Update
+ * @param       None
+ * @return      None
+ * @details     Called by senxorTask for every frame, before the conversion
+ * 				pass. Takes a waiting commit in.
+ **************************************************************************/
+void pixelCorrect_Update(void)
+{
+	if (!mSwapPending)
+	{
+		return;
+	}//End if
+
+	memcpy(mMap, mCommitted, sizeof(mMap));
+	mEnabled = !pixelCorrect_IsIdentity(mMap);
+	Customer_SetPixelCorrection(mEnabled ? mMap : NULL);				//Identity costs nothing
+	mSwapPending = false;
+	ESP_LOGI(PIXCORRTAG, PIXCORR_INFO_SWAP, mEnabled ? "applied" : "cleared");
+}//End pixelCorrect_Update
+
+/*
+ * ***********************************************************************
+ * @brief       pixelCorrect_Write
+ * @param       start - First image pixel
+ * 				count - Pixels, at most PIXCORR_MAX_CHUNK
+ * 				pEntry - count entries: gain, offset, 16-bit little endian each
+ * @return      pixCorrStatus_t
+ * @details     Into the upload buffer, applied by the next commit
+ **************************************************************************/
+uint8_t pixelCorrect_Write(const uint16_t start, const uint8_t count, const uint8_t* pEntry)
+{
+	if (count > PIXCORR_MAX_CHUNK || start + count > PIXCORR_PIXELS)
+	{
+		return PIXCORR_STATUS_BAD_RANGE;
+	}//End if
+
+	for (uint16_t i = start; i < start + count; i++, pEntry += PIXCORR_ENTRY_SIZE)
+	{
+		mUpload[i].mGain = (uint16_t)(pEntry[0] | (pEntry[1] << 8));
+		mUpload[i].mOffset = (int16_t)(pEntry[2] | (pEntry[3] << 8));
+	}//End for
+	mWritten = MIN(PIXCORR_PIXELS, mWritten + count);
+	return PIXCORR_STATUS_OK;
+}//End pixelCorrect_Write
+
+/*
+ * ***********************************************************************
+ * @brief       pixelCorrect_Commit
+ * @param       None
+ * @return      pixCorrStatus_t, PIXCORR_STATUS_BUSY until the last
+ * 				commit is applied and saved
+ * @details     The upload buffer is applied from the next frame, and saved
+ **************************************************************************/
+uint8_t pixelCorrect_Commit(void)
+{
+	taskENTER_CRITICAL(&mLock);
+	const bool busy = mSwapPending || mSavePending;
+	mSavePending = true;												//Claims mCommitted
+	taskEXIT_CRITICAL(&mLock);
+
+	if (busy)
+	{
+		return PIXCORR_STATUS_BUSY;
+	}//End if
+
+	memcpy(mCommitted, mUpload, sizeof(mCommitted));
+	mWritten = 0;
+	mSwapPending = true;
+	esp_timer_start_once(mSaveTimer, 0);
+	return PIXCORR_STATUS_OK;
+}//End pixelCorrect_Commit
+
+/*
+ * ***********************************************************************
+ * @brief       pixelCorrect_Clear
+ * @param       None
+ * @return      pixCorrStatus_t
+ * @details     Commit a map that corrects nothing
+ **************************************************************************/
+uint8_t pixelCorrect_Clear(void)
+{
+	if (mSwapPending || mSavePending)
+	{
+		return PIXCORR_STATUS_BUSY;
+	}//End if
+
+	pixelCorrect_Decode(NULL, mUpload);
+	return pixelCorrect_Commit();
+}//End pixelCorrect_Clear
+
+/*
+ * ***********************************************************************
+ * @brief       pixelCorrect_GetStatus
+ * @param       pState - pixCorrState_t
+ * 				pSaved - false if the map in use did not fit NVS
+ * 				pWritten - Pixels written since the last commit
+ * @return      None
+ **************************************************************************/
+void pixelCorrect_GetStatus(uint8_t* pState, bool* pSaved, uint16_t* pWritten)
+{
+	*pState = mSwapPending ? PIXCORR_STATE_PENDING : mEnabled ? PIXCORR_STATE_ON : PIXCORR_STATE_OFF;
+	*pSaved = mSaved;
+	*pWritten = mWritten;
+}//End pixelCorrect_GetStatus
+
+/*
+ * ***********************************************************************
+ * @brief       pixelCorrect_IsIdentity
+ * @param       pMap - Map
+ * @return      true if no pixel is changed by the map
+ **************************************************************************/
+static bool pixelCorrect_IsIdentity(const convCorr_t* pMap)
+{
+	for (uint16_t i = 0; i < PIXCORR_PIXELS; i++)
+	{
+		if (pMap[i].mGain != CONV_GAIN_UNITY || pMap[i].mOffset != 0)
+		{
+			return false;
+		}//End if
+	}//End for
+	return true;
+}//End pixelCorrect_IsIdentity
+
+/*
+ * ***********************************************************************
+ * @brief       pixelCorrect_Encode
+ * @param       pMap - Map
+ * 				pStore - Filled with the first PIXCORR_MAX_RUNS runs
+ * @return      Runs of the whole map, more than PIXCORR_MAX_RUNS if it
+ * 				does not fit
+ **************************************************************************/
+static uint16_t pixelCorrect_Encode(const convCorr_t* pMap, pixCorrStore_t* pStore)
+{
+	uint16_t runs = 0;
+
+	memset(pStore, 0, sizeof(*pStore));
+	pStore->mVersion = PIXCORR_VERSION;
+	for (uint16_t i = 0; i < PIXCORR_PIXELS; i++)
+	{
+		const bool same = (runs > 0) && pMap[i].mGain == pMap[i - 1].mGain && pMap[i].mOffset == pMap[i - 1].mOffset;
+		if (!same)
+		{
+			runs++;
+		}//End if
+		if (runs <= PIXCORR_MAX_RUNS)
+		{
+			pStore->mRun[runs - 1].mLength++;
+			pStore->mRun[runs - 1].mCorr = pMap[i];
+		}//End if
+	}//End for
+	pStore->mRuns = MIN(runs, PIXCORR_MAX_RUNS);
+	return runs;
+}//End pixelCorrect_Encode
+
+/*
+ * ***********************************************************************
+ * @brief       pixelCorrect_Decode
+ * @param       pStore - Runs, NULL for a map that corrects nothing
+ * 				pMap - Filled
+ * @return      false if the runs do not cover the image exactly
+ **************************************************************************/
+static bool pixelCorrect_Decode(const pixCorrStore_t* pStore, convCorr_t* pMap)
+{
+	uint16_t idx = 0;
+
+	if (pStore == NULL)
+	{
+		for (uint16_t i = 0; i < PIXCORR_PIXELS; i++)
+		{
+			pMap[i].mGain = CONV_GAIN_UNITY;
+			pMap[i].mOffset = 0;
+		}//End for
+		return true;
+	}//End if
+
+	for (uint16_t r = 0; r < pStore->mRuns && r < PIXCORR_MAX_RUNS; r++)
+	{
+		if (idx + pStore->mRun[r].mLength > PIXCORR_PIXELS)
+		{
+			return false;
+		}//End if
+		for (uint16_t n = 0; n < pStore->mRun[r].mLength; n++)
+		{
+			pMap[idx++] = pStore->mRun[r].mCorr;
+		}//End for
+	}//End for
+	return idx == PIXCORR_PIXELS;
+}//End pixelCorrect_Decode
+
+/*
+ * ***********************************************************************
+ * @brief       pixelCorrect_SaveTimerCallback
+ * @param       arg - Not used
+ * @return      None
+ * @details     Write the last commit to NVS. A map of too many runs is
+ * 				saved as no correction, a reboot must not bring back an
+ * 				older map.
+ **************************************************************************/
+static void pixelCorrect_SaveTimerCallback(void* arg)
+{
+	const uint16_t runs = pixelCorrect_Encode(mCommitted, &mStore);
+
+	mSaved = (runs <= PIXCORR_MAX_RUNS);
+	if (!mSaved)
+	{
+		mStore.mRuns = 0;
+		ESP_LOGW(PIXCORRTAG, PIXCORR_WARN_RUNS, runs, PIXCORR_MAX_RUNS);
+	}//End if
+	NVS_WriteBlob(PIXCORR_NVS_KEY, &mStore, sizeof(mStore));
+	mSavePending = false;
+}//End pixelCorrect_SaveTimerCallback
+
+#else
+
+void pixelCorrect_Init(void)
+{
+}//End pixelCorrect_Init
+
+void pixelCorrect_Update(void)
+{
+}//End pixelCorrect_Update
+
+uint8_t pixelCorrect_Write(const uint16_t start, const uint8_t count, const uint8_t* pEntry)
+{
+	(void)start;
+	(void)count;
+	(void)pEntry;
+	return PIXCORR_STATUS_BAD_RANGE;
+}//End pixelCorrect_Write
+
+uint8_t pixelCorrect_Commit(void)
+{
+	return PIXCORR_STATUS_BAD_RANGE;
+}//End pixelCorrect_Commit
+
+uint8_t pixelCorrect_Clear(void)
+{
+	return PIXCORR_STATUS_BAD_RANGE;
+}//End pixelCorrect_Clear
+
+void pixelCorrect_GetStatus(uint8_t* pState, bool* pSaved, uint16_t* pWritten)
+{
+	*pState = PIXCORR_STATE_OFF;
+	*pSaved = true;
+	*pWritten = 0;
+}//End pixelCorrect_GetStatus
+
+#endif
@@ -0,0 +1,416 @@
+/*****************************************************************************
+ * @file     pixelMap.c
+ * @version  1.00
+ * @brief    Persistent bad pixel map and its per-frame correction.
+ * @date	 14 Oct 2026
+ * @details	 The map is a bitmask of the image pixels, kept in NVS. At load
+ * 			 every bad pixel gets the index of its nearest good pixel, and
+ * 			 the pairs form a patch list. The unit conversion pass of
+ * 			 Customer_Interface.c copies the replacement values as it goes,
+ * 			 so the patch adds no pass over the frame. pixelMap_Process
+ * 			 patches a frame the conversion did not, one load and store per
+ * 			 bad pixel.
+ *
+ * 			 A calibration (BPIX 01) averages PIXMAP_CAL_FRAMES frames of a
+ * 			 uniform scene. A pixel is bad when its mean is further than the
+ * 			 threshold from the median of its neighbours, or when it read 0.
+ * 			 It runs in senxorTask on the unpatched frames: the conversion
+ * 			 pass leaves the patch to pixelMap_Process meanwhile, so the map
+ * 			 in use stays applied to the stream until the new one replaces it.
+ ******************************************************************************/
+#include <string.h>
+#include <stdlib.h>
+#include <freertos/FreeRTOS.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include "DrvNVS.h"
+#include "pixelMap.h"
+
+#if CONFIG_MI_PIXMAP_EN
+
+//private:
+static pixMapStore_t mStore;										//Map in use, also the NVS image
+static pixPatch_t mPatch[PIXMAP_MAX_BAD];
+static volatile uint16_t mPatchCount = 0;
+static pixPatch_t mPatchNew[PIXMAP_MAX_BAD];						//Built by senxorTask, then swapped in
+static portMUX_TYPE mLock = portMUX_INITIALIZER_UNLOCKED;
+static esp_timer_handle_t mSaveTimer = NULL;						//NVS writes run in the esp_timer task, its stack is internal RAM
+
+static volatile uint8_t mState = PIXMAP_STATE_IDLE;
+static volatile bool mCalRequest = false;							//Set by BPIX, taken by senxorTask
+static uint16_t mCalThreshold = PIXMAP_DEFAULT_THRESHOLD;
+static uint16_t mCalFrames = 0;
+EXT_RAM_BSS_ATTR static uint32_t mCalSum[PIXMAP_PIXELS];
+static uint8_t mCalZero[PIXMAP_MASK_BYTES];							//Pixels that read 0 in any frame
+static uint8_t mCalMask[PIXMAP_MASK_BYTES];
+
+static uint16_t pixelMap_BuildPatches(const uint8_t* pMask, pixPatch_t* pPatch, uint16_t* pUnpatched);
+static void pixelMap_Finish(void);
+static uint32_t pixelMap_NeighbourMedian(const int x, const int y);
+static void pixelMap_SaveTimerCallback(void* arg);
+
+static inline bool pixelMap_IsSet(const uint8_t* pMask, const uint16_t idx)
+{
+	return (pMask[idx >> 3] >> (idx & 7)) & 1;
+}
+
+static inline void pixelMap_Set(uint8_t* pMask, const uint16_t idx)
+{
+	pMask[idx >> 3] |= (uint8_t)(1 << (idx & 7));
+}
+
+/*
+ * ***********************************************************************
+ * @brief       pixelMap_Init
+ * @param       None
+ * @return      None
+ * @details     Load the map from NVS and build its patch list
+ **************************************************************************/
+void pixelMap_Init(void)
+{
+	uint16_t unpatched = 0;
+
+	if (!NVS_ReadBlob(PIXMAP_NVS_KEY, &mStore, sizeof(mStore)) || mStore.mVersion != PIXMAP_VERSION)
+	{
+		memset(&mStore, 0, sizeof(mStore));
+		mStore.mVersion = PIXMAP_VERSION;
+	}//End if
+
+	mPatchCount = pixelMap_BuildPatches(mStore.mMask, mPatch, &unpatched);
+	mStore.mCount = mPatchCount + unpatched;
+	Customer_SetPixelPatch(mPatch, mPatchCount);
+
+	const esp_timer_create_args_t saveTimerArgs = {
+		.callback = pixelMap_SaveTimerCallback,
+		.name = "pixmapsave"
+	};
+	esp_timer_create(&saveTimerArgs, &mSaveTimer);
+
+	ESP_LOGI(PIXMAPTAG, PIXMAP_INFO_INIT, mStore.mCount);
+}//End pixelMap_Init
+
+/*
+ * ***********************************************************************
+ * @brief       pixelMap_Process
+ * @param       pImage - Image of the frame, header rows removed, corrected in place
+ * @return      None
+ * @details     Called by senxorTask for every frame, before the analytics.
+ * 				A calibration in progress takes the unpatched values first.
+ **************************************************************************/
+void pixelMap_Process(uint16_t* pImage)
+{
+	const bool patched = Customer_GetPixelPatched();					//In the conversion pass
+
+	if (mCalRequest)
+	{
+		memset(mCalSum, 0, sizeof(mCalSum));
+		memset(mCalZero, 0, sizeof(mCalZero));
+		mCalFrames = 0;
+		mCalRequest = false;
+	}//End if
+
+	if (mState == PIXMAP_STATE_CALIBRATING && !patched)				//Converted before the calibration started otherwise
+	{
+		for (uint16_t i = 0; i < PIXMAP_PIXELS; i++)
+		{
+			mCalSum[i] += pImage[i];
+			if (pImage[i] == 0)
+			{
+				pixelMap_Set(mCalZero, i);
+			}//End if
+		}//End for
+		if (++mCalFrames >= PIXMAP_CAL_FRAMES)
+		{
+			pixelMap_Finish();
+		}//End if
+	}//End if
+
+	if (patched)
+	{
+		return;
+	}//End if
+
+	const uint16_t count = mPatchCount;
+	for (uint16_t i = 0; i < count; i++)
+	{
+		pImage[mPatch[i].mDst] = pImage[mPatch[i].mSrc];
+	}//End for
+}//End pixelMap_Process
+
+/*
+ * ***********************************************************************
+ * @brief       pixelMap_Calibrate
+ * @param       threshold - Largest normal distance from the neighbour median, raw frame units
+ * @return      False if a calibration is already running
+ * @details     Start a calibration on the next frame. The sensor must see
+ * 				a uniform scene until it ends.
+ **************************************************************************/
+bool pixelMap_Calibrate(const uint16_t threshold)
+{
+	if (mState == PIXMAP_STATE_CALIBRATING)
+	{
+		return false;
+	}//End if
+
+	mCalThreshold = (threshold == 0) ? PIXMAP_DEFAULT_THRESHOLD : threshold;
+	Customer_SetPixelPatch(mPatch, 0);									//pixelMap_Process patches until the calibration ends
+	mCalRequest = true;
+	mState = PIXMAP_STATE_CALIBRATING;
+	ESP_LOGI(PIXMAPTAG, PIXMAP_INFO_CAL, PIXMAP_CAL_FRAMES, mCalThreshold);
+	return true;
+}//End pixelMap_Calibrate
+
+/*
+ * ***********************************************************************
+ * @brief       pixelMap_Clear
+ * @param       None
+ * @return      None
+ * @details     Forget every bad pixel. A calibration in progress goes on.
+ **************************************************************************/
+void pixelMap_Clear(void)
+{
+	taskENTER_CRITICAL(&mLock);
+	mPatchCount = 0;
+	memset(mStore.mMask, 0, sizeof(mStore.mMask));
+	mStore.mCount = 0;
+	taskEXIT_CRITICAL(&mLock);
+	Customer_SetPixelPatch(mPatch, 0);
+
+	if (mState == PIXMAP_STATE_REJECTED)
+	{
+		mState = PIXMAP_STATE_IDLE;
+	}//End if
+	esp_timer_start_once(mSaveTimer, 0);
+	ESP_LOGI(PIXMAPTAG, PIXMAP_INFO_CLEAR);
+}//End pixelMap_Clear
+
+/*
+ * ***********************************************************************
+ * @brief       pixelMap_GetStatus
+ * @param       pState - pixMapState_t
+ * 				pCount - Bad pixels in the map
+ * @return      None
+ **************************************************************************/
+void pixelMap_GetStatus(uint8_t* pState, uint16_t* pCount)
+{
+	*pState = mState;
+	*pCount = mStore.mCount;
+}//End pixelMap_GetStatus
+
+/*
+ * ***********************************************************************
+ * @brief       pixelMap_GetDemandHz
+ * @param       None
+ * @return      Capture rate a calibration needs, 0 if none is running
+ **************************************************************************/
+uint8_t pixelMap_GetDemandHz(void)
+{
+	return (mState == PIXMAP_STATE_CALIBRATING) ? PIXMAP_DEMAND_HZ : 0;
+}//End pixelMap_GetDemandHz
+
+/*
+ * ***********************************************************************
+ * @brief       pixelMap_Finish
+ * @param       None
+ * @return      None
+ * @details     Judge every pixel against its neighbours and swap the new
+ * 				map in. Runs once per calibration in senxorTask.
+ **************************************************************************/
+static void pixelMap_Finish(void)
+{
+	uint16_t bad = 0;
+	uint16_t unpatched = 0;
+
+	memcpy(mCalMask, mCalZero, sizeof(mCalMask));
+	for (int y = 0; y < PIXMAP_HEIGHT; y++)
+	{
+		for (int x = 0; x < PIXMAP_WIDTH; x++)
+		{
+			const uint16_t idx = y * PIXMAP_WIDTH + x;
+			const uint32_t mean = mCalSum[idx] / PIXMAP_CAL_FRAMES;
+			const uint32_t median = pixelMap_NeighbourMedian(x, y);
+			const uint32_t dist = (mean > median) ? mean - median : median - mean;
+
+			if (dist > mCalThreshold)
+			{
+				pixelMap_Set(mCalMask, idx);
+			}//End if
+			bad += pixelMap_IsSet(mCalMask, idx);
+		}//End for
+	}//End for
+
+	if (bad > PIXMAP_MAX_BAD)
+	{
+		mState = PIXMAP_STATE_REJECTED;
+		Customer_SetPixelPatch(mPatch, mPatchCount);						//Back to the map in use
+		ESP_LOGE(PIXMAPTAG, PIXMAP_ERR_TOO_MANY, bad);
+		return;
+	}//End if
+
+	const uint16_t count = pixelMap_BuildPatches(mCalMask, mPatchNew, &unpatched);
+
+	taskENTER_CRITICAL(&mLock);
+	memcpy(mStore.mMask, mCalMask, sizeof(mStore.mMask));
+	mStore.mCount = bad;
+	memcpy(mPatch, mPatchNew, count * sizeof(pixPatch_t));
+	mPatchCount = count;
+	taskEXIT_CRITICAL(&mLock);
+	Customer_SetPixelPatch(mPatch, count);
+
+	mState = PIXMAP_STATE_IDLE;
+	esp_timer_start_once(mSaveTimer, 0);
+	ESP_LOGI(PIXMAPTAG, PIXMAP_INFO_DONE, bad, unpatched);
+}//End pixelMap_Finish
+
+/*
+ * ***********************************************************************
+ * @brief       pixelMap_NeighbourMedian
+ * @param       x, y - Pixel
+ * @return      Median of the calibration means of the 8 neighbours inside the image
+ **************************************************************************/
+static uint32_t pixelMap_NeighbourMedian(const int x, const int y)
+{
+	uint32_t val[8];
+	uint8_t n = 0;
+
+	for (int dy = -1; dy <= 1; dy++)
+	{
+		for (int dx = -1; dx <= 1; dx++)
+		{
+			const int nx = x + dx;
+			const int ny = y + dy;
+			if ((dx == 0 && dy == 0) || nx < 0 || ny < 0 || nx >= PIXMAP_WIDTH || ny >= PIXMAP_HEIGHT)
+			{
+				continue;
+			}//End if
+
+			//Insertion sort, at most 8 values
+			const uint32_t mean = mCalSum[ny * PIXMAP_WIDTH + nx] / PIXMAP_CAL_FRAMES;
+			uint8_t j = n++;
+			while (j > 0 && val[j - 1] > mean)
+			{
+				val[j] = val[j - 1];
+				j--;
+			}//End while
+			val[j] = mean;
+		}//End for
+	}//End for
+	return val[n / 2];
+}//End pixelMap_NeighbourMedian
+
+/*
+ * ***********************************************************************
+ * @brief       pixelMap_BuildPatches
+ * @param       pMask - Bad pixel mask
+ * 				pPatch - PIXMAP_MAX_BAD entries, filled
+ * 				pUnpatched - Bad pixels with no good pixel within PIXMAP_SEARCH_RADIUS
+ * @return      Entries in pPatch
+ * @details     The replacement is the closest good pixel, the direct
+ * 				neighbours before the diagonal ones
+ **************************************************************************/
+static uint16_t pixelMap_BuildPatches(const uint8_t* pMask, pixPatch_t* pPatch, uint16_t* pUnpatched)
+{
+	uint16_t count = 0;
+
+	*pUnpatched = 0;
+	for (uint16_t idx = 0; idx < PIXMAP_PIXELS; idx++)
+	{
+		if (!pixelMap_IsSet(pMask, idx))
+		{
+			continue;
+		}//End if
+
+		const int x = idx % PIXMAP_WIDTH;
+		const int y = idx / PIXMAP_WIDTH;
+		int bestSrc = -1;
+		int bestDist = INT32_MAX;
+
+		for (int r = 1; r <= PIXMAP_SEARCH_RADIUS && bestSrc < 0; r++)
+		{
+			for (int dy = -r; dy <= r; dy++)
+			{
+				for (int dx = -r; dx <= r; dx++)
+				{
+					const int nx = x + dx;
+					const int ny = y + dy;
+					const int dist = dx * dx + dy * dy;
+					if (abs(dx) != r && abs(dy) != r)
+					{
+						continue;											//Inside the ring, already searched
+					}//End if
+					if (nx < 0 || ny < 0 || nx >= PIXMAP_WIDTH || ny >= PIXMAP_HEIGHT || dist >= bestDist)
+					{
+						continue;
+					}//End if
+					if (!pixelMap_IsSet(pMask, ny * PIXMAP_WIDTH + nx))
+					{
+						bestSrc = ny * PIXMAP_WIDTH + nx;
+						bestDist = dist;
+					}//End if
+				}//End for
+			}//End for
+		}//End for
+
+		if (bestSrc < 0 || count >= PIXMAP_MAX_BAD)
+		{
+			(*pUnpatched)++;
+			continue;
+		}//End if
+		pPatch[count].mDst = idx;
+		pPatch[count].mSrc = (uint16_t)bestSrc;
+		count++;
+	}//End for
+	return count;
+}//End pixelMap_BuildPatches
+
+/*
+ * ***********************************************************************
+ * @brief       pixelMap_SaveTimerCallback
+ * @param       arg - Not used
+ * @return      None
+ * @details     Write the map to NVS
+ **************************************************************************/
+static void pixelMap_SaveTimerCallback(void* arg)
+{
+	static pixMapStore_t store;											//esp_timer task only
+
+	taskENTER_CRITICAL(&mLock);
+	memcpy(&store, &mStore, sizeof(store));
+	taskEXIT_CRITICAL(&mLock);
+	NVS_WriteBlob(PIXMAP_NVS_KEY, &store, sizeof(store));
+}//End pixelMap_SaveTimerCallback
+
+#else
+
+void pixelMap_Init(void)
+{
+}//End pixelMap_Init
+
+void pixelMap_Process(uint16_t* pImage)
+{
+	(void)pImage;
+}//End pixelMap_Process
+
+bool pixelMap_Calibrate(const uint16_t threshold)
+{
+	(void)threshold;
+	return false;
+}//End pixelMap_Calibrate
+
+void pixelMap_Clear(void)
+{
+}//End pixelMap_Clear
+
+void pixelMap_GetStatus(uint8_t* pState, uint16_t* pCount)
+{
+	*pState = PIXMAP_STATE_IDLE;
+	*pCount = 0;
+}//End pixelMap_GetStatus
+
+uint8_t pixelMap_GetDemandHz(void)
+{
+	return 0;
+}//End pixelMap_GetDemandHz
+
+#endif
@@ -0,0 +1,296 @@
+/*****************************************************************************
+ * @file     quadrantMax.c
+ * @version  1.00
+ * @brief    Quadrant maxima of the thermal image.
+ * @date	 14 Oct 2026
+ * @details	 Every image row is divided at Xsplit into two contiguous spans.
+ * 			 The spans of the rows above Ysplit belong to A and B, the ones
+ * 			 below to C and D, so a quadrant is a rectangle reduced without
+ * 			 any per-pixel test.
+ *
+ * 			 On the ESP32-S3 the 16 byte aligned part of a rectangle is reduced
+ * 			 with the PIE 128 bit vector unit, 8 pixels per instruction. PIE
+ * 			 only has a signed 16 bit max, so pixels are XORed with 0x8000
+ * 			 first, which maps unsigned order onto signed order and keeps the
+ * 			 result bit exact with the scalar reference. The up to 7 columns
+ * 			 left on each side of the aligned part are reduced in C.
+ ******************************************************************************/
+#include <esp_log.h>
+#include <esp_cpu.h>
+#include <string.h>
+
+#include "quadrantMax.h"
+#include "senxorTask.h"
+
+//private:
+static uint16_t quadrantMax_Strip(const uint16_t* pImage, const uint8_t x0, const uint8_t x1, const uint8_t y0, const uint8_t y1);
+static uint16_t quadrantMax_Span(const uint16_t* pImage, const uint8_t x0, const uint8_t x1, const uint8_t y0, const uint8_t y1);
+#if CONFIG_IDF_TARGET_ESP32S3
+static uint16_t quadrantMax_Vector(const uint16_t* pStart, uint32_t rows, const uint32_t chunks);
+#endif
+
+/*
+ * ***********************************************************************
+ * @brief       quadrantMax_Scalar
+ * @param       pImage - First image row
+ * 				xsplit - First column of B and D
+ * 				ysplit - First row of C and D
+ * 				pMax - Output, maxima of A, B, C and D
+ * @return      None
+ * @details     Reference implementation, one compare per pixel
+ **************************************************************************/
+void quadrantMax_Scalar(const uint16_t* pImage, const uint8_t xsplit, const uint8_t ysplit, uint16_t pMax[4])
+{
+	uint16_t Amax = 0, Bmax = 0, Cmax = 0, Dmax = 0;
+
+	for (uint8_t y = 0; y < SENXOR_FRAME_HEIGHT; y++) {
+		for (uint8_t x = 0; x < SENXOR_FRAME_WIDTH; x++) {
+			uint16_t pixel = pImage[y * SENXOR_FRAME_WIDTH + x];
+
+			if (x < xsplit && y < ysplit) {
+				// Quadrant A (top-left)
+				if (pixel > Amax) Amax = pixel;
+			} else if (x >= xsplit && y < ysplit) {
+				// Quadrant B (top-right)
+				if (pixel > Bmax) Bmax = pixel;
+			} else if (x < xsplit && y >= ysplit) {
+				// Quadrant C (bottom-left)
+				if (pixel > Cmax) Cmax = pixel;
+			} else {
+				// Quadrant D (bottom-right)
+				if (pixel > Dmax) Dmax = pixel;
+			}
+		}
+	}
+
+	pMax[0] = Amax;
+	pMax[1] = Bmax;
+	pMax[2] = Cmax;
+	pMax[3] = Dmax;
+}//End quadrantMax_Scalar
+
+/*
+ * ***********************************************************************
+ * @brief       quadrantMax_Simd
+ * @param       pImage - First image row
+ * 				xsplit - First column of B and D
+ * 				ysplit - First row of C and D
+ * 				pMax - Output, maxima of A, B, C and D
+ * @return      None
+ * @details     Row split implementation, same results as quadrantMax_Scalar
+ **************************************************************************/
+void quadrantMax_Simd(const uint16_t* pImage, const uint8_t xsplit, const uint8_t ysplit, uint16_t pMax[4])
+{
+	const uint8_t xs = (xsplit > SENXOR_FRAME_WIDTH) ? SENXOR_FRAME_WIDTH : xsplit;
+	const uint8_t ys = (ysplit > SENXOR_FRAME_HEIGHT) ? SENXOR_FRAME_HEIGHT : ysplit;
+
+	pMax[0] = quadrantMax_Span(pImage, 0, xs, 0, ys);
+	pMax[1] = quadrantMax_Span(pImage, xs, SENXOR_FRAME_WIDTH, 0, ys);
+	pMax[2] = quadrantMax_Span(pImage, 0, xs, ys, SENXOR_FRAME_HEIGHT);
+	pMax[3] = quadrantMax_Span(pImage, xs, SENXOR_FRAME_WIDTH, ys, SENXOR_FRAME_HEIGHT);
+}//End quadrantMax_Simd
+
+/*
+ * ***********************************************************************
+ * @brief       quadrantMax_Calculate
+ * @param       pImage - First image row
+ * 				pData - Split and burner coordinates in, maxima, center and
+ * 						burner temperatures out
+ * @return      None
+ * @details     Quadrant analysis of one frame, the part of
+ * 				quadrant_Calculate that does not touch the radio
+ **************************************************************************/
+void quadrantMax_Calculate(const uint16_t* pImage, quadrantData_t* pData)
+{
+	const uint8_t xsplit = pData->Xsplit;
+	const uint8_t ysplit = pData->Ysplit;
+
+	// Max for each quadrant, rows split at Xsplit and reduced span by span
+	uint16_t quadMax[4];
+	quadrantMax_Simd(pImage, xsplit, ysplit, quadMax);
+
+	// Calculate center pixel coordinates for each quadrant
+	uint8_t Acx = xsplit / 2;
+	uint8_t Acy = ysplit / 2;
+	uint8_t Bcx = xsplit + (SENXOR_FRAME_WIDTH - xsplit) / 2;
+	uint8_t Bcy = ysplit / 2;
+	uint8_t Ccx = xsplit / 2;
+	uint8_t Ccy = ysplit + (SENXOR_FRAME_HEIGHT - ysplit) / 2;
+	uint8_t Dcx = xsplit + (SENXOR_FRAME_WIDTH - xsplit) / 2;
+	uint8_t Dcy = ysplit + (SENXOR_FRAME_HEIGHT - ysplit) / 2;
+
+	// Clamp center coordinates to valid range
+	if (Acx >= SENXOR_FRAME_WIDTH) Acx = SENXOR_FRAME_WIDTH - 1;
+	if (Acy >= SENXOR_FRAME_HEIGHT) Acy = SENXOR_FRAME_HEIGHT - 1;
+	if (Bcx >= SENXOR_FRAME_WIDTH) Bcx = SENXOR_FRAME_WIDTH - 1;
+	if (Bcy >= SENXOR_FRAME_HEIGHT) Bcy = SENXOR_FRAME_HEIGHT - 1;
+	if (Ccx >= SENXOR_FRAME_WIDTH) Ccx = SENXOR_FRAME_WIDTH - 1;
+	if (Ccy >= SENXOR_FRAME_HEIGHT) Ccy = SENXOR_FRAME_HEIGHT - 1;
+	if (Dcx >= SENXOR_FRAME_WIDTH) Dcx = SENXOR_FRAME_WIDTH - 1;
+	if (Dcy >= SENXOR_FRAME_HEIGHT) Dcy = SENXOR_FRAME_HEIGHT - 1;
+
+	// Store results
+	pData->Amax = quadMax[0];
+	pData->Acenter = pImage[Acy * SENXOR_FRAME_WIDTH + Acx];
+	pData->Bmax = quadMax[1];
+	pData->Bcenter = pImage[Bcy * SENXOR_FRAME_WIDTH + Bcx];
+	pData->Cmax = quadMax[2];
+	pData->Ccenter = pImage[Ccy * SENXOR_FRAME_WIDTH + Ccx];
+	pData->Dmax = quadMax[3];
+	pData->Dcenter = pImage[Dcy * SENXOR_FRAME_WIDTH + Dcx];
+
+	// Read burner temperatures at stored coordinates
+	pData->Aburnert = pImage[pData->Aburnery * SENXOR_FRAME_WIDTH + pData->Aburnerx];
+	pData->Bburnert = pImage[pData->Bburnery * SENXOR_FRAME_WIDTH + pData->Bburnerx];
+	pData->Cburnert = pImage[pData->Cburnery * SENXOR_FRAME_WIDTH + pData->Cburnerx];
+	pData->Dburnert = pImage[pData->Dburnery * SENXOR_FRAME_WIDTH + pData->Dburnerx];
+}//End quadrantMax_Calculate
+
+#if CONFIG_MI_QUADRANT_BENCH
+/*
+ * ***********************************************************************
+ * @brief       quadrantMax_Benchmark
+ * @param       pImage - First image row
+ * 				xsplit - First column of B and D
+ * 				ysplit - First row of C and D
+ * @return      None
+ * @details     Time both implementations on the same frame and log the
+ * 				cycles per frame. Cycles are counted at the CPU clock.
+ **************************************************************************/
+void quadrantMax_Benchmark(const uint16_t* pImage, const uint8_t xsplit, const uint8_t ysplit)
+{
+	uint16_t scalarMax[4];
+	uint16_t simdMax[4];
+
+	uint32_t start = esp_cpu_get_cycle_count();
+	for (uint8_t i = 0; i < QUADRANT_BENCH_RUNS; i++)
+	{
+		quadrantMax_Scalar(pImage, xsplit, ysplit, scalarMax);
+	}//End for
+	const uint32_t scalarCycles = (esp_cpu_get_cycle_count() - start) / QUADRANT_BENCH_RUNS;
+
+	start = esp_cpu_get_cycle_count();
+	for (uint8_t i = 0; i < QUADRANT_BENCH_RUNS; i++)
+	{
+		quadrantMax_Simd(pImage, xsplit, ysplit, simdMax);
+	}//End for
+	const uint32_t simdCycles = (esp_cpu_get_cycle_count() - start) / QUADRANT_BENCH_RUNS;
+
+	ESP_LOGI(QMTAG, QM_BENCH_INFO, xsplit, ysplit, (unsigned long)scalarCycles, (unsigned long)simdCycles,
+			 (memcmp(scalarMax, simdMax, sizeof(scalarMax)) == 0) ? "match" : "DIFFER");
+}//End quadrantMax_Benchmark
+#endif
+
+/*
+ * ***********************************************************************
+ * @brief       quadrantMax_Strip
+ * @param       pImage - First image row
+ * 				x0, x1 - Column range, x1 excluded
+ * 				y0, y1 - Row range, y1 excluded
+ * @return      Maximum of the rectangle, 0 if it is empty
+ * @details     Scalar reduction, the compare compiles to MAXU
+ **************************************************************************/
+static uint16_t quadrantMax_Strip(const uint16_t* pImage, const uint8_t x0, const uint8_t x1, const uint8_t y0, const uint8_t y1)
+{
+	uint16_t max = 0;
+
+	for (uint8_t y = y0; y < y1; y++)
+	{
+		const uint16_t* pRow = &pImage[y * SENXOR_FRAME_WIDTH];
+		for (uint8_t x = x0; x < x1; x++)
+		{
+			max = (pRow[x] > max) ? pRow[x] : max;
+		}//End for
+	}//End for
+
+	return max;
+}//End quadrantMax_Strip
+
+/*
+ * ***********************************************************************
+ * @brief       quadrantMax_Span
+ * @param       pImage - First image row
+ * 				x0, x1 - Column range, x1 excluded
+ * 				y0, y1 - Row range, y1 excluded
+ * @return      Maximum of the rectangle, 0 if it is empty
+ * @details     A row is 160 bytes, so the 16 byte aligned columns are the
+ * 				same in every row and the rectangle splits into an aligned
+ * 				block and two narrow strips.
+ **************************************************************************/
+static uint16_t quadrantMax_Span(const uint16_t* pImage, const uint8_t x0, const uint8_t x1, const uint8_t y0, const uint8_t y1)
+{
+	if (x0 >= x1 || y0 >= y1)
+	{
+		return 0;
+	}//End if
+
+#if CONFIG_IDF_TARGET_ESP32S3
+	const uint8_t skip = (uint8_t)(((16 - ((uintptr_t)&pImage[x0] & 15)) & 15) / sizeof(uint16_t));
+	const uint8_t va = x0 + skip;												//First aligned column
+	const uint8_t chunks = (va < x1) ? (x1 - va) / QUADRANT_MAX_LANES : 0;
+	const uint8_t vb = va + chunks * QUADRANT_MAX_LANES;						//End of the aligned block
+
+	if (chunks > 0)
+	{
+		uint16_t max = quadrantMax_Vector(&pImage[y0 * SENXOR_FRAME_WIDTH + va], y1 - y0, chunks);
+		const uint16_t left = quadrantMax_Strip(pImage, x0, va, y0, y1);
+		const uint16_t right = quadrantMax_Strip(pImage, vb, x1, y0, y1);
+		max = (left > max) ? left : max;
+		max = (right > max) ? right : max;
+		return max;
+	}//End if
+#endif
+
+	return quadrantMax_Strip(pImage, x0, x1, y0, y1);
+}//End quadrantMax_Span
+
+#if CONFIG_IDF_TARGET_ESP32S3
+/*
+ * ***********************************************************************
+ * @brief       quadrantMax_Vector
+ * @param       pStart - First pixel, 16 byte aligned
+ * 				rows - Number of rows, at least 1
+ * 				chunks - 8 pixel chunks per row, at least 1
+ * @return      Maximum of the block
+ * @details     PIE reduction. q2 holds the 0x8000 bias, q1 the running
+ * 				maximum in biased form, starting at biased 0.
+ **************************************************************************/
+static uint16_t quadrantMax_Vector(const uint16_t* pStart, uint32_t rows, const uint32_t chunks)
+{
+	static const uint16_t bias = 0x8000;
+	uint16_t lanes[QUADRANT_MAX_LANES] __attribute__((aligned(16)));
+	const int32_t rowSkip = (int32_t)(SENXOR_FRAME_WIDTH - chunks * QUADRANT_MAX_LANES) * (int32_t)sizeof(uint16_t);
+	const uint16_t* p = pStart;
+	uint16_t* pLanes = lanes;
+	uint32_t count;
+
+	__asm__ volatile(
+		"ee.vldbc.16	q2, %[bias]				\n"
+		"ee.vldbc.16	q1, %[bias]				\n"
+		"1:										\n"
+		"mov			%[count], %[chunks]		\n"
+		"2:										\n"
+		"ee.vld.128.ip	q0, %[p], 16			\n"
+		"ee.xorq		q0, q0, q2				\n"
+		"ee.vmax.s16	q1, q1, q0				\n"
+		"addi			%[count], %[count], -1	\n"
+		"bnez			%[count], 2b			\n"
+		"add			%[p], %[p], %[rowSkip]	\n"
+		"addi			%[rows], %[rows], -1	\n"
+		"bnez			%[rows], 1b				\n"
+		"ee.xorq		q1, q1, q2				\n"
+		"ee.vst.128.ip	q1, %[lanes], 0			\n"
+		: [p] "+r" (p), [rows] "+r" (rows), [count] "=&r" (count), [lanes] "+r" (pLanes)
+		: [chunks] "r" (chunks), [rowSkip] "r" (rowSkip), [bias] "r" (&bias)
+		: "memory"
+	);
+
+	uint16_t max = lanes[0];
+	for (uint8_t i = 1; i < QUADRANT_MAX_LANES; i++)
+	{
+		max = (lanes[i] > max) ? lanes[i] : max;
+	}//End for
+
+	return max;
+}//End quadrantMax_Vector
+#endif
@@ -0,0 +1,535 @@
+/*****************************************************************************
+ * @file     roiEngine.c
+ * @version  1.00
+ * @brief    Regions of interest on the thermal image.
+ * @date	 14 Oct 2026
+ * @details	 The ROI table is turned into a label map holding the ROI slot of
+ * 			 every image pixel, rebuilt only when the table changes. A frame
+ * 			 is then reduced in one pass that reads each pixel and its label
+ * 			 once, so the cost does not grow with the number of ROIs.
+ *
+ * 			 The percentile comes from a ROI_HIST_BINS bin histogram. Its
+ * 			 range follows the minimum and maximum of the previous frame with
+ * 			 a power of 2 bin width, so ROIs spanning less than ROI_HIST_BINS
+ * 			 counts get an exact percentile once the scene is stable. Values
+ * 			 outside the range land in the end bins and the result is clamped
+ * 			 to the measured minimum and maximum.
+ ******************************************************************************/
+#include <esp_log.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include "roiEngine.h"
+#include "senxorTask.h"
+#include "DrvNVS.h"
+
+#define ROI_PIXELS			(SENXOR_FRAME_WIDTH * SENXOR_FRAME_HEIGHT)
+#define ROI_HIST_FULL_SHIFT	10									//Bin width covering 16 bits with ROI_HIST_BINS bins
+
+// Per ROI accumulator of the running frame
+typedef struct roiAcc{
+	uint32_t mSum;
+	uint16_t mCount;
+	uint16_t mMin;
+	uint16_t mMax;
+	uint16_t mHotIdx;								//Pixel index of the maximum
+	uint16_t mHistLo;								//Value of the first histogram bin
+	uint8_t mHistShift;								//Bin width is 1 << mHistShift
+	uint16_t mHist[ROI_HIST_BINS];
+}roiAcc_t;
+
+//private:
+static roiTable_t mRoiTable;
+static uint8_t mLabelMap[ROI_PIXELS];						//ROI slot of every pixel, ROI_LABEL_NONE if none
+static roiAcc_t mAcc[ROI_MAX_COUNT];
+static roiStats_t mStats[ROI_MAX_COUNT];
+static uint8_t mRoiSel = 0;									//Slot shown in the register window
+static SemaphoreHandle_t mRoiLock = NULL;					//Table, label map and results
+
+static bool roiEngine_IsValid(const roiDef_t* pDef);
+static bool roiEngine_Contains(const roiDef_t* pDef, const uint8_t x, const uint8_t y);
+static void roiEngine_BuildLabels(void);
+static void roiEngine_Finish(const uint8_t idx);
+
+/*
+ * ***********************************************************************
+ * @brief       roiEngine_Init
+ * @param       None
+ * @return      None
+ * @details     Load the ROI table from NVS. Must run after the NVS
+ * 				partition is mounted.
+ **************************************************************************/
+void roiEngine_Init(void)
+{
+	mRoiLock = xSemaphoreCreateMutex();
+
+	memset(&mRoiTable, 0, sizeof(mRoiTable));
+	if (!NVS_ReadBlob(ROI_NVS_KEY, &mRoiTable, sizeof(mRoiTable)) || mRoiTable.mVersion != ROI_TABLE_VERSION)
+	{
+		memset(&mRoiTable, 0, sizeof(mRoiTable));				//Start with an empty table
+		mRoiTable.mVersion = ROI_TABLE_VERSION;
+	}//End if
+
+	uint8_t roiCnt = 0;
+	for (uint8_t i = 0; i < ROI_MAX_COUNT; i++)
+	{
+		if (!roiEngine_IsValid(&mRoiTable.mRoi[i]))
+		{
+			mRoiTable.mRoi[i].mType = ROI_TYPE_NONE;				//Drop slots a newer firmware may have written
+		}//End if
+		roiCnt += (mRoiTable.mRoi[i].mType != ROI_TYPE_NONE) ? 1 : 0;
+		mAcc[i].mHistShift = ROI_HIST_FULL_SHIFT;				//Full range until a frame has been seen
+	}//End for
+
+	roiEngine_BuildLabels();
+
+	uint16_t labelled = 0;
+	for (uint16_t i = 0; i < ROI_PIXELS; i++)
+	{
+		labelled += (mLabelMap[i] != ROI_LABEL_NONE) ? 1 : 0;
+	}//End for
+	ESP_LOGI(ROITAG, ROI_INIT_INFO, roiCnt, labelled);
+}//End roiEngine_Init
+
+/*
+ * ***********************************************************************
+ * @brief       roiEngine_SetRoi
+ * @param       idx - ROI slot
+ * 				type - ROI_TYPE_*, ROI_TYPE_NONE clears the slot
+ * 				percentile - Percentile to report, 1-100
+ * 				vertexCount - Number of vertices in pVertex
+ * 				pVertex - x0, y0, x1, y1...
+ * @return      True if the definition was accepted and stored
+ * @details     Rebuild the label map and save the table to NVS
+ **************************************************************************/
+bool roiEngine_SetRoi(const uint8_t idx, const uint8_t type, const uint8_t percentile, const uint8_t vertexCount, const uint8_t* pVertex)
+{
+	roiDef_t def;
+
+	memset(&def, 0, sizeof(def));
+	def.mType = type;
+	def.mPercentile = percentile;
+	def.mVertexCount = vertexCount;
+	if (vertexCount <= ROI_MAX_VERTICES && pVertex != NULL)
+	{
+		memcpy(def.mVertex, pVertex, vertexCount * 2);
+	}//End if
+
+	if (idx >= ROI_MAX_COUNT || (type != ROI_TYPE_NONE && pVertex == NULL) || !roiEngine_IsValid(&def))
+	{
+		ESP_LOGE(ROITAG, ROI_ERR_DEF, idx);
+		return false;
+	}//End if
+
+	xSemaphoreTake(mRoiLock, portMAX_DELAY);
+	mRoiTable.mRoi[idx] = def;
+	roiEngine_BuildLabels();
+	memset(&mStats[idx], 0, sizeof(mStats[idx]));
+	mAcc[idx].mHistShift = ROI_HIST_FULL_SHIFT;
+	mAcc[idx].mHistLo = 0;
+
+	uint16_t pixels = 0;
+	for (uint16_t i = 0; i < ROI_PIXELS; i++)
+	{
+		pixels += (mLabelMap[i] == idx) ? 1 : 0;
+	}//End for
+	xSemaphoreGive(mRoiLock);
+
+	NVS_WriteBlob(ROI_NVS_KEY, &mRoiTable, sizeof(mRoiTable));
+	ESP_LOGI(ROITAG, ROI_SET_INFO, idx, type, percentile, vertexCount, pixels);
+	return true;
+}//End roiEngine_SetRoi
+
+/*
+ * ***********************************************************************
+ * @brief       roiEngine_Process
+ * @param       pImage - First image row, SENXOR_FRAME_HEIGHT rows of SENXOR_FRAME_WIDTH pixels
+ * @return      None
+ * @details     Single pass reduction of all ROIs
+ **************************************************************************/
+void roiEngine_Process(const uint16_t* pImage)
+{
+	if (pImage == NULL || mRoiLock == NULL)
+	{
+		return;
+	}//End if
+
+	xSemaphoreTake(mRoiLock, portMAX_DELAY);
+
+	for (uint8_t i = 0; i < ROI_MAX_COUNT; i++)
+	{
+		roiAcc_t* pAcc = &mAcc[i];
+		pAcc->mSum = 0;
+		pAcc->mCount = 0;
+		pAcc->mMin = 0xFFFF;
+		pAcc->mMax = 0;
+		pAcc->mHotIdx = 0;
+		memset(pAcc->mHist, 0, sizeof(pAcc->mHist));
+	}//End for
+
+	for (uint16_t i = 0; i < ROI_PIXELS; i++)
+	{
+		const uint8_t label = mLabelMap[i];
+		if (label == ROI_LABEL_NONE)
+		{
+			continue;
+		}//End if
+
+		roiAcc_t* pAcc = &mAcc[label];
+		const uint16_t pixel = pImage[i];
+
+		pAcc->mSum += pixel;
+		++pAcc->mCount;
+		pAcc->mMin = (pixel < pAcc->mMin) ? pixel : pAcc->mMin;
+		if (pixel > pAcc->mMax)
+		{
+			pAcc->mMax = pixel;
+			pAcc->mHotIdx = i;
+		}//End if
+
+		const int32_t bin = ((int32_t)pixel - pAcc->mHistLo) >> pAcc->mHistShift;
+		++pAcc->mHist[(bin < 0) ? 0 : (bin >= ROI_HIST_BINS) ? ROI_HIST_BINS - 1 : bin];
+	}//End for
+
+	for (uint8_t i = 0; i < ROI_MAX_COUNT; i++)
+	{
+		roiEngine_Finish(i);
+	}//End for
+
+	xSemaphoreGive(mRoiLock);
+}//End roiEngine_Process
+
+/*
+ * ***********************************************************************
+ * @brief       roiEngine_GetStats
+ * @param       idx - ROI slot
+ * 				pStats - Output
+ * @return      False if idx is out of range
+ * @details     Results of the last processed frame
+ **************************************************************************/
+bool roiEngine_GetStats(const uint8_t idx, roiStats_t* pStats)
+{
+	if (idx >= ROI_MAX_COUNT || pStats == NULL)
+	{
+		return false;
+	}//End if
+
+	xSemaphoreTake(mRoiLock, portMAX_DELAY);
+	*pStats = mStats[idx];
+	xSemaphoreGive(mRoiLock);
+	return true;
+}//End roiEngine_GetStats
+
+/*
+ * ***********************************************************************
+ * @brief       roiEngine_GetBounds
+ * @param       idx - ROI slot
+ * 				pX, pY - First pixel of the bounding box
+ * 				pWidth, pHeight - Size of the bounding box in pixels
+ * @return      False if idx is out of range, unused or empty
+ * @details     Smallest rectangle of pixels holding the ROI
+ **************************************************************************/
+bool roiEngine_GetBounds(const uint8_t idx, uint8_t* pX, uint8_t* pY, uint8_t* pWidth, uint8_t* pHeight)
+{
+	if (idx >= ROI_MAX_COUNT)
+	{
+		return false;
+	}//End if
+
+	xSemaphoreTake(mRoiLock, portMAX_DELAY);
+	const roiDef_t def = mRoiTable.mRoi[idx];
+	xSemaphoreGive(mRoiLock);
+
+	if (def.mType == ROI_TYPE_NONE || def.mVertexCount == 0)
+	{
+		return false;
+	}//End if
+
+	uint8_t x0 = def.mVertex[0][0], x1 = def.mVertex[0][0];
+	uint8_t y0 = def.mVertex[0][1], y1 = def.mVertex[0][1];
+	for (uint8_t v = 1; v < def.mVertexCount; v++)
+	{
+		x0 = (def.mVertex[v][0] < x0) ? def.mVertex[v][0] : x0;
+		x1 = (def.mVertex[v][0] > x1) ? def.mVertex[v][0] : x1;
+		y0 = (def.mVertex[v][1] < y0) ? def.mVertex[v][1] : y0;
+		y1 = (def.mVertex[v][1] > y1) ? def.mVertex[v][1] : y1;
+	}//End for
+
+	if (def.mType == ROI_TYPE_RECT)
+	{
+		++x1;													//Corners are pixels, both included
+		++y1;
+	}//End if
+
+	if (x1 <= x0 || y1 <= y0)
+	{
+		return false;
+	}//End if
+
+	*pX = x0;
+	*pY = y0;
+	*pWidth = x1 - x0;
+	*pHeight = y1 - y0;
+	return true;
+}//End roiEngine_GetBounds
+
+/*
+ * ***********************************************************************
+ * @brief       roiEngine_ReadStat
+ * @param       idx - ROI slot
+ * 				regAddr - Field, as its register address (REG_ROI_MIN-REG_ROI_PIXELS)
+ * @return      Field value, 0 for an unused ROI
+ * @details     One result field of the last processed frame
+ **************************************************************************/
+uint16_t roiEngine_ReadStat(const uint8_t idx, const uint8_t regAddr)
+{
+	roiStats_t stats;
+
+	if (!roiEngine_GetStats(idx, &stats))
+	{
+		return 0;
+	}//End if
+
+	switch (regAddr) {
+		case REG_ROI_MIN:     return stats.mMin;
+		case REG_ROI_MAX:     return stats.mMax;
+		case REG_ROI_MEAN:    return stats.mMean;
+		case REG_ROI_PCT:     return stats.mPercentile;
+		case REG_ROI_HOTX:    return stats.mHotX;
+		case REG_ROI_HOTY:    return stats.mHotY;
+		case REG_ROI_PIXELS:  return stats.mPixels;
+		default:              return 0;
+	}
+}//End roiEngine_ReadStat
+
+/*
+ * ***********************************************************************
+ * @brief       roiEngine_ReadRegister
+ * @param       regAddr - Register address (REG_ROI_FIRST-REG_ROI_LAST)
+ * @return      Register value
+ * @details     Statistics of the ROI selected by REG_ROI_SEL
+ **************************************************************************/
+uint16_t roiEngine_ReadRegister(const uint8_t regAddr)
+{
+	if (regAddr == REG_ROI_COUNT)
+	{
+		uint8_t roiCnt = 0;
+		for (uint8_t i = 0; i < ROI_MAX_COUNT; i++)
+		{
+			roiCnt += (mRoiTable.mRoi[i].mType != ROI_TYPE_NONE) ? 1 : 0;
+		}//End for
+		return roiCnt;
+	}//End if
+
+	if (regAddr == REG_ROI_SEL)
+	{
+		return mRoiSel;
+	}//End if
+
+	return roiEngine_ReadStat(mRoiSel, regAddr);
+}//End roiEngine_ReadRegister
+
+/*
+ * ***********************************************************************
+ * @brief       roiEngine_WriteRegister
+ * @param       regAddr - Register address, only REG_ROI_SEL is writable
+ * 				value - Value to write
+ * @return      None
+ * @details     Select the ROI shown in the register window
+ **************************************************************************/
+void roiEngine_WriteRegister(const uint8_t regAddr, const uint8_t value)
+{
+	if (regAddr == REG_ROI_SEL && value < ROI_MAX_COUNT)
+	{
+		mRoiSel = value;
+	}//End if
+}//End roiEngine_WriteRegister
+
+/*
+ * ***********************************************************************
+ * @brief       roiEngine_IsValid
+ * @param       pDef - Definition to check
+ * @return      True if the definition can be used
+ * @details     Rectangle corners must be image pixels, polygon vertices
+ * 				grid corners (0-SENXOR_FRAME_WIDTH, 0-SENXOR_FRAME_HEIGHT)
+ **************************************************************************/
+static bool roiEngine_IsValid(const roiDef_t* pDef)
+{
+	if (pDef->mType == ROI_TYPE_NONE)
+	{
+		return true;
+	}//End if
+
+	if (pDef->mPercentile < 1 || pDef->mPercentile > 100)
+	{
+		return false;
+	}//End if
+
+	uint8_t maxX = SENXOR_FRAME_WIDTH;
+	uint8_t maxY = SENXOR_FRAME_HEIGHT;
+
+	if (pDef->mType == ROI_TYPE_RECT)
+	{
+		if (pDef->mVertexCount != 2)
+		{
+			return false;
+		}//End if
+		maxX = SENXOR_FRAME_WIDTH - 1;
+		maxY = SENXOR_FRAME_HEIGHT - 1;
+	}
+	else if (pDef->mType != ROI_TYPE_POLYGON || pDef->mVertexCount < 3 || pDef->mVertexCount > ROI_MAX_VERTICES)
+	{
+		return false;
+	}//End if-else
+
+	for (uint8_t v = 0; v < pDef->mVertexCount; v++)
+	{
+		if (pDef->mVertex[v][0] > maxX || pDef->mVertex[v][1] > maxY)
+		{
+			return false;
+		}//End if
+	}//End for
+
+	return true;
+}//End roiEngine_IsValid
+
+/*
+ * ***********************************************************************
+ * @brief       roiEngine_Contains
+ * @param       pDef - Valid ROI definition
+ * 				x, y - Pixel
+ * @return      True if the pixel belongs to the ROI
+ * @details     Polygons use the even-odd rule on the pixel centre, in
+ * 				doubled coordinates so everything stays integer
+ **************************************************************************/
+static bool roiEngine_Contains(const roiDef_t* pDef, const uint8_t x, const uint8_t y)
+{
+	if (pDef->mType == ROI_TYPE_RECT)
+	{
+		const uint8_t x0 = (pDef->mVertex[0][0] < pDef->mVertex[1][0]) ? pDef->mVertex[0][0] : pDef->mVertex[1][0];
+		const uint8_t x1 = (pDef->mVertex[0][0] < pDef->mVertex[1][0]) ? pDef->mVertex[1][0] : pDef->mVertex[0][0];
+		const uint8_t y0 = (pDef->mVertex[0][1] < pDef->mVertex[1][1]) ? pDef->mVertex[0][1] : pDef->mVertex[1][1];
+		const uint8_t y1 = (pDef->mVertex[0][1] < pDef->mVertex[1][1]) ? pDef->mVertex[1][1] : pDef->mVertex[0][1];
+		return (x >= x0 && x <= x1 && y >= y0 && y <= y1);
+	}//End if
+
+	if (pDef->mType != ROI_TYPE_POLYGON)
+	{
+		return false;
+	}//End if
+
+	const int32_t px = 2 * x + 1;
+	const int32_t py = 2 * y + 1;
+	bool inside = false;
+
+	for (uint8_t v = 0, u = pDef->mVertexCount - 1; v < pDef->mVertexCount; u = v++)
+	{
+		const int32_t ax = 2 * pDef->mVertex[u][0];
+		const int32_t ay = 2 * pDef->mVertex[u][1];
+		const int32_t bx = 2 * pDef->mVertex[v][0];
+		const int32_t by = 2 * pDef->mVertex[v][1];
+
+		if ((ay > py) == (by > py))
+		{
+			continue;												//Edge does not cross this row
+		}//End if
+
+		const int32_t lhs = (px - ax) * (by - ay);
+		const int32_t rhs = (py - ay) * (bx - ax);
+		if ((by > ay) ? (lhs < rhs) : (lhs > rhs))
+		{
+			inside = !inside;										//Edge crosses right of the pixel centre
+		}//End if
+	}//End for
+
+	return inside;
+}//End roiEngine_Contains
+
+/*
+ * ***********************************************************************
+ * @brief       roiEngine_BuildLabels
+ * @param       None
+ * @return      None
+ * @details     Rasterise the ROI table. Lower slots win on overlap.
+ **************************************************************************/
+static void roiEngine_BuildLabels(void)
+{
+	memset(mLabelMap, ROI_LABEL_NONE, sizeof(mLabelMap));
+
+	for (uint8_t i = 0; i < ROI_MAX_COUNT; i++)
+	{
+		const roiDef_t* pDef = &mRoiTable.mRoi[i];
+		if (pDef->mType == ROI_TYPE_NONE)
+		{
+			continue;
+		}//End if
+
+		for (uint8_t y = 0; y < SENXOR_FRAME_HEIGHT; y++)
+		{
+			for (uint8_t x = 0; x < SENXOR_FRAME_WIDTH; x++)
+			{
+				uint8_t* pLabel = &mLabelMap[y * SENXOR_FRAME_WIDTH + x];
+				if (*pLabel == ROI_LABEL_NONE && roiEngine_Contains(pDef, x, y))
+				{
+					*pLabel = i;
+				}//End if
+			}//End for
+		}//End for
+	}//End for
+}//End roiEngine_BuildLabels
+
+/*
+ * ***********************************************************************
+ * @brief       roiEngine_Finish
+ * @param       idx - ROI slot
+ * @return      None
+ * @details     Turn the accumulator into results and move the histogram
+ * 				range onto this frame's minimum and maximum
+ **************************************************************************/
+static void roiEngine_Finish(const uint8_t idx)
+{
+	roiAcc_t* pAcc = &mAcc[idx];
+	roiStats_t* pStats = &mStats[idx];
+
+	if (pAcc->mCount == 0)
+	{
+		memset(pStats, 0, sizeof(*pStats));
+		return;
+	}//End if
+
+	pStats->mMin = pAcc->mMin;
+	pStats->mMax = pAcc->mMax;
+	pStats->mMean = (uint16_t)((pAcc->mSum + pAcc->mCount / 2) / pAcc->mCount);
+	pStats->mHotX = pAcc->mHotIdx % SENXOR_FRAME_WIDTH;
+	pStats->mHotY = pAcc->mHotIdx / SENXOR_FRAME_WIDTH;
+	pStats->mPixels = pAcc->mCount;
+
+	// Nearest rank percentile
+	const uint32_t rank = ((uint32_t)mRoiTable.mRoi[idx].mPercentile * pAcc->mCount + 99) / 100;
+	uint32_t cumulative = 0;
+	uint8_t bin = 0;
+	for (; bin < ROI_HIST_BINS - 1; bin++)
+	{
+		cumulative += pAcc->mHist[bin];
+		if (cumulative >= rank)
+		{
+			break;
+		}//End if
+	}//End for
+
+	int32_t value = pAcc->mHistLo + ((int32_t)bin << pAcc->mHistShift) + ((1 << pAcc->mHistShift) >> 1);
+	value = (value < pAcc->mMin) ? pAcc->mMin : value;
+	value = (value > pAcc->mMax) ? pAcc->mMax : value;
+	pStats->mPercentile = (uint16_t)value;
+
+	// Smallest power of 2 bin width covering this frame's range
+	const uint32_t range = pAcc->mMax - pAcc->mMin;
+	uint8_t shift = 0;
+	while ((range >> shift) >= ROI_HIST_BINS)
+	{
+		++shift;
+	}//End while
+	pAcc->mHistShift = shift;
+	pAcc->mHistLo = pAcc->mMin;
+}//End roiEngine_Finish
@@ -0,0 +1,500 @@
+/*****************************************************************************
+ * @file     ruleEngine.c
+ * @version  1.00
+ * @brief    Alarm rules evaluated on the device at frame rate.
+ * @date	 15 Oct 2026
+ * @details	 Every rule compares one ROI statistic or firmware register with
+ * 			 a threshold. It is raised once the condition has held for its
+ * 			 dwell time and cleared once the value is back past the threshold
+ * 			 by the hysteresis, so a value sitting on the threshold does not
+ * 			 chatter. ruleEngine_Process runs in senxorAnalyse after the
+ * 			 ROIs and costs one metric read and compare per rule.
+ *
+ * 			 Every raise and clear goes into an event ring. The command
+ * 			 server and the BLE stream read it with their own cursor and
+ * 			 push the event at once; a reader that falls more than
+ * 			 RULE_EVENT_RING events behind skips the oldest. The LED flashes
+ * 			 the colour of the lowest raised rule that has one.
+ *
+ * 			 The table is saved to NVS with every change, like the ROI table.
+ ******************************************************************************/
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include "DrvNVS.h"
+#include "ruleEngine.h"
+#include "roiEngine.h"
+#include "cmdParser.h"
+#include "ledCtrlTask.h"
+#include "tcpServerTask.h"
+
+#if CONFIG_MI_RULE_EN
+
+// Evaluation state of one rule, only used by ruleEngine_Process
+typedef struct ruleState{
+	bool mRaised;
+	int64_t mSinceUs;						//Time the condition started to hold, 0 if it does not
+}ruleState_t;
+
+//private:
+static ruleTable_t mTable;
+static ruleState_t mState[RULE_MAX_COUNT];
+static bool mLedShown = false;											//The LED shows a rule, restore it when none is raised
+
+static portMUX_TYPE mLock = portMUX_INITIALIZER_UNLOCKED;				//Table, results and event ring
+static uint8_t mReset = 0;												//Rules redefined since the last frame, one bit each
+static uint8_t mActive = 0;												//REG_RULE_ACTIVE
+static uint16_t mValue[RULE_MAX_COUNT];									//Last value of every rule
+static ruleEvent_t mEvents[RULE_EVENT_RING];
+static uint32_t mEventCount = 0;										//Events since boot, the next one goes to mEventCount % RULE_EVENT_RING
+
+static bool ruleEngine_IsValid(const ruleDef_t* pDef);
+static bool ruleEngine_ReadMetric(const ruleDef_t* pDef, uint16_t* pValue);
+static void ruleEngine_PushEvent(const uint32_t seq, const uint8_t idx, const bool raised, const uint8_t active, const uint16_t value);
+static void ruleEngine_ShowLed(const ruleDef_t* pRules, const uint8_t active);
+
+/*
+ * ***********************************************************************
+ * @brief       ruleEngine_Init
+ * @param       None
+ * @return      None
+ * @details     Load the rule table from NVS. Must run after the NVS
+ * 				partition is mounted.
+ **************************************************************************/
+void ruleEngine_Init(void)
+{
+	if (!NVS_ReadBlob(RULE_NVS_KEY, &mTable, sizeof(mTable)) || mTable.mVersion != RULE_TABLE_VERSION)
+	{
+		memset(&mTable, 0, sizeof(mTable));							//Start with an empty table
+		mTable.mVersion = RULE_TABLE_VERSION;
+	}//End if
+
+	uint8_t ruleCnt = 0;
+	for (uint8_t i = 0; i < RULE_MAX_COUNT; i++)
+	{
+		if (!ruleEngine_IsValid(&mTable.mRule[i]))
+		{
+			mTable.mRule[i].mMetric = RULE_METRIC_NONE;				//Drop slots a newer firmware may have written
+		}//End if
+		ruleCnt += (mTable.mRule[i].mMetric != RULE_METRIC_NONE) ? 1 : 0;
+	}//End for
+
+	ESP_LOGI(RULETAG, RULE_INFO_INIT, ruleCnt);
+}//End ruleEngine_Init
+
+/*
+ * ***********************************************************************
+ * @brief       ruleEngine_Process
+ * @param       seq - Capture sequence number of the frame
+ * @return      true if a rule was raised or cleared
+ * @details     Called by senxorAnalyse after roiEngine_Process. A rule
+ * 				on an unused or empty ROI keeps its state.
+ **************************************************************************/
+bool ruleEngine_Process(const uint32_t seq)
+{
+	ruleDef_t rules[RULE_MAX_COUNT];
+	uint16_t values[RULE_MAX_COUNT];
+
+	taskENTER_CRITICAL(&mLock);
+	memcpy(rules, mTable.mRule, sizeof(rules));
+	memcpy(values, mValue, sizeof(values));
+	const uint8_t reset = mReset;
+	mReset = 0;
+	uint8_t active = mActive;
+	taskEXIT_CRITICAL(&mLock);
+
+	const int64_t nowUs = esp_timer_get_time();
+	bool changed = false;
+
+	for (uint8_t i = 0; i < RULE_MAX_COUNT; i++)
+	{
+		const ruleDef_t* pRule = &rules[i];
+		ruleState_t* pState = &mState[i];
+		const uint8_t bit = (uint8_t)(1 << i);
+
+		if (reset & bit)
+		{
+			if (pState->mRaised)
+			{
+				active &= ~bit;											//A redefined rule starts cleared, tell the clients
+				ruleEngine_PushEvent(seq, i, false, active, values[i]);
+				changed = true;
+			}//End if
+			memset(pState, 0, sizeof(*pState));
+			values[i] = 0;
+		}//End if
+
+		uint16_t value;
+		if (pRule->mMetric == RULE_METRIC_NONE || !ruleEngine_ReadMetric(pRule, &value))
+		{
+			continue;
+		}//End if
+		values[i] = value;
+
+		const bool isAbove = (pRule->mCompare == RULE_CMP_ABOVE);
+		if (!pState->mRaised)
+		{
+			const bool holds = isAbove ? (value > pRule->mThreshold) : (value < pRule->mThreshold);
+			if (!holds)
+			{
+				pState->mSinceUs = 0;
+				continue;
+			}//End if
+			pState->mSinceUs = (pState->mSinceUs == 0) ? nowUs : pState->mSinceUs;
+			if (nowUs - pState->mSinceUs < pRule->mDwell * 100000LL)
+			{
+				continue;
+			}//End if
+		}
+		else
+		{
+			const bool clears = isAbove ? ((int32_t)value + pRule->mHysteresis <= pRule->mThreshold)
+										: ((int32_t)value >= (int32_t)pRule->mThreshold + pRule->mHysteresis);
+			if (!clears)
+			{
+				continue;
+			}//End if
+			pState->mSinceUs = 0;
+		}//End if-else
+
+		pState->mRaised = !pState->mRaised;
+		active ^= bit;
+		ruleEngine_PushEvent(seq, i, pState->mRaised, active, value);
+		ESP_LOGI(RULETAG, RULE_INFO_EVENT, i, pState->mRaised ? "raised" : "cleared", value);
+		changed = true;
+	}//End for
+
+	taskENTER_CRITICAL(&mLock);
+	memcpy(mValue, values, sizeof(mValue));
+	mActive = active;
+	taskEXIT_CRITICAL(&mLock);
+
+	if (changed)
+	{
+		ruleEngine_ShowLed(rules, active);
+	}//End if
+	return changed;
+}//End ruleEngine_Process
+
+/*
+ * ***********************************************************************
+ * @brief       ruleEngine_SetRule
+ * @param       idx - Rule slot
+ * 				metric - RULE_METRIC_*, RULE_METRIC_NONE clears the slot
+ * 				source - ROI slot or register address
+ * 				compare - RULE_CMP_*
+ * 				led - ledColour shown while raised, 0 = none
+ * 				threshold, hysteresis - Raw frame units or register value
+ * 				dwell - Time the condition must hold, 100 ms units
+ * @return      True if the definition was accepted and stored
+ * @details     The rule starts over cleared from the next frame. Saves
+ * 				the table to NVS.
+ **************************************************************************/
+bool ruleEngine_SetRule(const uint8_t idx, const uint8_t metric, const uint8_t source, const uint8_t compare, const uint8_t led,
+		const uint16_t threshold, const uint16_t hysteresis, const uint16_t dwell)
+{
+	const ruleDef_t def = {
+		.mMetric = metric,
+		.mSource = source,
+		.mCompare = compare,
+		.mLed = led,
+		.mThreshold = threshold,
+		.mHysteresis = hysteresis,
+		.mDwell = dwell
+	};
+	ruleTable_t table;
+
+	if (idx >= RULE_MAX_COUNT || !ruleEngine_IsValid(&def))
+	{
+		ESP_LOGE(RULETAG, RULE_ERR_DEF, idx);
+		return false;
+	}//End if
+
+	taskENTER_CRITICAL(&mLock);
+	mTable.mRule[idx] = def;
+	mReset |= (uint8_t)(1 << idx);
+	table = mTable;
+	taskEXIT_CRITICAL(&mLock);
+
+	NVS_WriteBlob(RULE_NVS_KEY, &table, sizeof(table));
+	ESP_LOGI(RULETAG, RULE_INFO_SET, idx, metric, source, compare, threshold, hysteresis, dwell);
+	return true;
+}//End ruleEngine_SetRule
+
+/*
+ * ***********************************************************************
+ * @brief       ruleEngine_GetRule
+ * @param       idx - Rule slot
+ * 				pMetric ... pDwell - Output, definition as for ruleEngine_SetRule
+ * 				pRaised - Output, 1 while the rule is raised
+ * 				pValue - Output, metric value of the last frame
+ * @return      False if idx is out of range
+ **************************************************************************/
+bool ruleEngine_GetRule(const uint8_t idx, uint8_t* pMetric, uint8_t* pSource, uint8_t* pCompare, uint8_t* pLed,
+		uint16_t* pThreshold, uint16_t* pHysteresis, uint16_t* pDwell, uint8_t* pRaised, uint16_t* pValue)
+{
+	if (idx >= RULE_MAX_COUNT)
+	{
+		return false;
+	}//End if
+
+	taskENTER_CRITICAL(&mLock);
+	const ruleDef_t def = mTable.mRule[idx];
+	*pRaised = (mActive >> idx) & 1;
+	*pValue = mValue[idx];
+	taskEXIT_CRITICAL(&mLock);
+
+	*pMetric = def.mMetric;
+	*pSource = def.mSource;
+	*pCompare = def.mCompare;
+	*pLed = def.mLed;
+	*pThreshold = def.mThreshold;
+	*pHysteresis = def.mHysteresis;
+	*pDwell = def.mDwell;
+	return true;
+}//End ruleEngine_GetRule
+
+/*
+ * ***********************************************************************
+ * @brief       ruleEngine_GetActive
+ * @param       None
+ * @return      REG_RULE_ACTIVE, bit n set while rule n is raised
+ **************************************************************************/
+uint8_t ruleEngine_GetActive(void)
+{
+	return mActive;
+}//End ruleEngine_GetActive
+
+/*
+ * ***********************************************************************
+ * @brief       ruleEngine_GetEventCount
+ * @param       None
+ * @return      Events since boot, the cursor of a reader that wants new
+ * 				events only
+ **************************************************************************/
+uint32_t ruleEngine_GetEventCount(void)
+{
+	taskENTER_CRITICAL(&mLock);
+	const uint32_t count = mEventCount;
+	taskEXIT_CRITICAL(&mLock);
+	return count;
+}//End ruleEngine_GetEventCount
+
+/*
+ * ***********************************************************************
+ * @brief       ruleEngine_GetEvent
+ * @param       pCursor - Reader's position, advanced past the event
+ * 				pEvent - Output
+ * @return      False if the reader has seen every event
+ * @details     A reader too far behind continues with the oldest event
+ * 				still in the ring.
+ **************************************************************************/
+bool ruleEngine_GetEvent(uint32_t* pCursor, ruleEvent_t* pEvent)
+{
+	bool found = false;
+
+	taskENTER_CRITICAL(&mLock);
+	if (*pCursor != mEventCount)
+	{
+		if (mEventCount - *pCursor > RULE_EVENT_RING)
+		{
+			*pCursor = mEventCount - RULE_EVENT_RING;
+		}//End if
+		*pEvent = mEvents[*pCursor % RULE_EVENT_RING];
+		++*pCursor;
+		found = true;
+	}//End if
+	taskEXIT_CRITICAL(&mLock);
+
+	return found;
+}//End ruleEngine_GetEvent
+
+/*
+ * ***********************************************************************
+ * @brief       ruleEngine_IsValid
+ * @param       pDef - Rule definition
+ * @return      True if the rule can be evaluated, or is unused
+ * @details     Register rules are limited to the firmware registers, a
+ * 				SenXor register would cost an SPI read every frame. The ROI
+ * 				register window is left out, its slot follows REG_ROI_SEL.
+ * 				The classifier results are in, its rate and ROI are not.
+ **************************************************************************/
+static bool ruleEngine_IsValid(const ruleDef_t* pDef)
+{
+	if (pDef->mMetric == RULE_METRIC_NONE)
+	{
+		return true;
+	}//End if
+	if (pDef->mMetric >= RULE_METRIC_COUNT || pDef->mCompare > RULE_CMP_BELOW || pDef->mLed > PINK_LED)
+	{
+		return false;
+	}//End if
+	if (pDef->mMetric == RULE_METRIC_REGISTER)
+	{
+		return (pDef->mSource >= 0xC0 && pDef->mSource <= 0xDF) || (pDef->mSource >= 0xF1 && pDef->mSource <= 0xF6) || (pDef->mSource >= 0xFA && pDef->mSource <= 0xFD);
+	}//End if
+	return pDef->mSource < ROI_MAX_COUNT;
+}//End ruleEngine_IsValid
+
+/*
+ * ***********************************************************************
+ * @brief       ruleEngine_ReadMetric
+ * @param       pDef - Rule definition
+ * 				pValue - Output
+ * @return      False if the ROI is unused or empty
+ **************************************************************************/
+static bool ruleEngine_ReadMetric(const ruleDef_t* pDef, uint16_t* pValue)
+{
+	roiStats_t stats;
+
+	if (pDef->mMetric == RULE_METRIC_REGISTER)
+	{
+		*pValue = cmdParser_ReadRegister(pDef->mSource);
+		return true;
+	}//End if
+
+	if (!roiEngine_GetStats(pDef->mSource, &stats) || stats.mPixels == 0)
+	{
+		return false;
+	}//End if
+
+	switch (pDef->mMetric)
+	{
+		case RULE_METRIC_ROI_MIN:	*pValue = stats.mMin;			break;
+		case RULE_METRIC_ROI_MAX:	*pValue = stats.mMax;			break;
+		case RULE_METRIC_ROI_MEAN:	*pValue = stats.mMean;			break;
+		default:					*pValue = stats.mPercentile;	break;
+	}//End switch
+	return true;
+}//End ruleEngine_ReadMetric
+
+/*
+ * ***********************************************************************
+ * @brief       ruleEngine_PushEvent
+ * @param       seq - Capture sequence number of the frame
+ * 				idx - Rule slot
+ * 				raised - true raised, false cleared
+ * 				active - REG_RULE_ACTIVE after the event
+ * 				value - Metric value
+ * @return      None
+ **************************************************************************/
+static void ruleEngine_PushEvent(const uint32_t seq, const uint8_t idx, const bool raised, const uint8_t active, const uint16_t value)
+{
+	const ruleEvent_t event = {
+		.mSeq = seq,
+		.mRule = idx,
+		.mRaised = raised,
+		.mActive = active,
+		.mValue = value
+	};
+
+	taskENTER_CRITICAL(&mLock);
+	mEvents[mEventCount % RULE_EVENT_RING] = event;
+	++mEventCount;
+	taskEXIT_CRITICAL(&mLock);
+}//End ruleEngine_PushEvent
+
+/*
+ * ***********************************************************************
+ * @brief       ruleEngine_ShowLed
+ * @param       pRules - Rule table
+ * 				active - Raised rules
+ * @return      None
+ * @details     Flash the colour of the lowest raised rule with an LED.
+ * 				With none, go back to the connection colour the TCP server
+ * 				sets.
+ **************************************************************************/
+static void ruleEngine_ShowLed(const ruleDef_t* pRules, const uint8_t active)
+{
+#if CONFIG_MI_LED_EN
+	for (uint8_t i = 0; i < RULE_MAX_COUNT; i++)
+	{
+		if (((active >> i) & 1) && pRules[i].mLed != OFF)
+		{
+			ledCtrlSingleSet((ledColour)pRules[i].mLed, LED_ON, RULE_LED_FLASH_MS);
+			mLedShown = true;
+			return;
+		}//End if
+	}//End for
+
+	if (mLedShown)
+	{
+		mLedShown = false;
+		if (tcpServerGetIsClientConnected())
+		{
+			ledCtrlSingleSet(GREEN_LED, LED_ON, 0);
+		}
+		else
+		{
+			ledCtrlSingleSet(YELLOW_LED, LED_ON, 500);
+		}//End if-else
+	}//End if
+#else
+	(void)pRules;
+	(void)active;
+	(void)mLedShown;
+#endif
+}//End ruleEngine_ShowLed
+
+#else
+
+void ruleEngine_Init(void)
+{
+}//End ruleEngine_Init
+
+bool ruleEngine_Process(const uint32_t seq)
+{
+	(void)seq;
+	return false;
+}//End ruleEngine_Process
+
+bool ruleEngine_SetRule(const uint8_t idx, const uint8_t metric, const uint8_t source, const uint8_t compare, const uint8_t led,
+		const uint16_t threshold, const uint16_t hysteresis, const uint16_t dwell)
+{
+	(void)idx;
+	(void)metric;
+	(void)source;
+	(void)compare;
+	(void)led;
+	(void)threshold;
+	(void)hysteresis;
+	(void)dwell;
+	return false;
+}//End ruleEngine_SetRule
+
+bool ruleEngine_GetRule(const uint8_t idx, uint8_t* pMetric, uint8_t* pSource, uint8_t* pCompare, uint8_t* pLed,
+		uint16_t* pThreshold, uint16_t* pHysteresis, uint16_t* pDwell, uint8_t* pRaised, uint16_t* pValue)
+{
+	(void)idx;
+	(void)pMetric;
+	(void)pSource;
+	(void)pCompare;
+	(void)pLed;
+	(void)pThreshold;
+	(void)pHysteresis;
+	(void)pDwell;
+	(void)pRaised;
+	(void)pValue;
+	return false;
+}//End ruleEngine_GetRule
+
+uint8_t ruleEngine_GetActive(void)
+{
+	return 0;
+}//End ruleEngine_GetActive
+
+uint32_t ruleEngine_GetEventCount(void)
+{
+	return 0;
+}//End ruleEngine_GetEventCount
+
+bool ruleEngine_GetEvent(uint32_t* pCursor, ruleEvent_t* pEvent)
+{
+	(void)pCursor;
+	(void)pEvent;
+	return false;
+}//End ruleEngine_GetEvent
+
+#endif
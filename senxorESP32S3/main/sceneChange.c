@@ -0,0 +1,250 @@
+/*****************************************************************************
+ * @file     sceneChange.c
+ * @version  1.00
+ * @brief    Per-pixel background model and change gating of the frames.
+ * @date	 15 Oct 2026
+ * @details	 Every pixel has a background mean and a mean absolute deviation,
+ * 			 both fixed point and following the scene over 2^SCENE_LEARN_SHIFT
+ * 			 frames. A pixel has changed when it is further from its mean than
+ * 			 SCENE_DEV_K deviations plus the delta register. Changed pixels
+ * 			 still move the mean, 2^SCENE_ABSORB_SHIFT times slower, so an object
+ * 			 left in the scene becomes background and the deviation is not
+ * 			 widened by it.
+ *
+ * 			 sceneChange_Process runs in senxorTask on every frame, after the
+ * 			 filters. In SCENE_MODE_GATE it lets a frame through to the
+ * 			 analytics and the stream only when enough pixels changed or the
+ * 			 heartbeat is due, so a static scene costs the capture and this
+ * 			 pass only. Every frame goes through while the model learns.
+ ******************************************************************************/
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include "memProfile.h"
+#include "sceneChange.h"
+
+#if CONFIG_MI_SCENE_EN
+
+//private:
+MEM_HOT_ATTR static uint32_t mMean[SCENE_PIXELS];						//SCENE_MEAN_FRAC_BITS fixed point
+MEM_HOT_ATTR static uint16_t mDev[SCENE_PIXELS];						//SCENE_DEV_FRAC_BITS fixed point
+static uint16_t mLearnLeft = 0;											//Frames until the model is trusted
+static int64_t mLastPassUs = 0;											//Time of the last frame let through
+
+static portMUX_TYPE mLock = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t mMode = SCENE_DEFAULT_MODE;								//Written by the command tasks
+static uint8_t mDelta = SCENE_DEFAULT_DELTA;
+static uint8_t mPixels = SCENE_DEFAULT_PIXELS;
+static uint8_t mHeartbeat = SCENE_DEFAULT_HEARTBEAT;
+static bool mReseed = true;
+static sceneStatus_t mStatus;											//Read by the command tasks
+
+static void sceneChange_Seed(const uint16_t* pImage);
+static void sceneChange_Update(const uint16_t* pImage, const uint8_t delta, sceneStatus_t* pStatus);
+
+/*
+ * ***********************************************************************
+ * @brief       sceneChange_Process
+ * @param       pImage - Image of the frame, header rows removed
+ * @return      true if the frame goes on to the analytics and the stream
+ * @details     Called by senxorTask for every frame, after temporalFilter_Process
+ **************************************************************************/
+bool sceneChange_Process(const uint16_t* pImage)
+{
+	taskENTER_CRITICAL(&mLock);
+	const uint8_t mode = mMode;
+	const uint8_t delta = mDelta;
+	const uint8_t pixels = mPixels;
+	const int64_t heartbeatUs = mHeartbeat * 100000LL;
+	const bool seed = mReseed;
+	mReseed = false;
+	taskEXIT_CRITICAL(&mLock);
+
+	if (mode == SCENE_MODE_OFF)
+	{
+		return true;
+	}//End if
+
+	if (seed)
+	{
+		sceneChange_Seed(pImage);
+	}//End if
+
+	sceneStatus_t status;
+	sceneChange_Update(pImage, delta, &status);
+	taskENTER_CRITICAL(&mLock);
+	mStatus = status;
+	taskEXIT_CRITICAL(&mLock);
+
+	const int64_t nowUs = esp_timer_get_time();
+	bool pass = (mode != SCENE_MODE_GATE) || (mLearnLeft > 0) || (status.mCount >= pixels) || (nowUs - mLastPassUs >= heartbeatUs);
+	if (mLearnLeft > 0)
+	{
+		mLearnLeft--;
+	}//End if
+	if (pass)
+	{
+		mLastPassUs = nowUs;
+	}//End if
+
+	return pass;
+}//End sceneChange_Process
+
+/*
+ * ***********************************************************************
+ * @brief       sceneChange_ReadRegister
+ * @param       regAddr - Register address (REG_SCENE_FIRST-REG_SCENE_LAST)
+ * @return      Register value
+ **************************************************************************/
+uint16_t sceneChange_ReadRegister(const uint8_t regAddr)
+{
+	uint16_t value = 0;
+
+	taskENTER_CRITICAL(&mLock);
+	switch (regAddr)
+	{
+		case REG_SCENE_MODE:		value = mMode;										break;
+		case REG_SCENE_DELTA:		value = mDelta;										break;
+		case REG_SCENE_PIXELS:		value = mPixels;									break;
+		case REG_SCENE_HEARTBEAT:	value = mHeartbeat;									break;
+		case REG_SCENE_COUNT:		value = mStatus.mCount;								break;
+		case REG_SCENE_BOX_MIN:		value = mStatus.mMinX | (mStatus.mMinY << 8);		break;
+		case REG_SCENE_BOX_MAX:		value = mStatus.mMaxX | (mStatus.mMaxY << 8);		break;
+		default:																		break;
+	}//End switch
+	taskEXIT_CRITICAL(&mLock);
+
+	return value;
+}//End sceneChange_ReadRegister
+
+/*
+ * ***********************************************************************
+ * @brief       sceneChange_WriteRegister
+ * @param       regAddr - Register address (REG_SCENE_MODE-REG_SCENE_HEARTBEAT)
+ * 				value - Value to write
+ * @return      None
+ * @details     Out of range values are ignored. Not persisted, the
+ * 				Kconfig defaults apply after a reboot. Turning the model on
+ * 				starts it over from the next frame.
+ **************************************************************************/
+void sceneChange_WriteRegister(const uint8_t regAddr, const uint8_t value)
+{
+	taskENTER_CRITICAL(&mLock);
+	if (regAddr == REG_SCENE_MODE && value < SCENE_MODE_COUNT)
+	{
+		mReseed = mReseed || (mMode == SCENE_MODE_OFF && value != SCENE_MODE_OFF);
+		mMode = value;
+	}
+	else if (regAddr == REG_SCENE_DELTA)
+	{
+		mDelta = value;
+	}
+	else if (regAddr == REG_SCENE_PIXELS && value > 0)
+	{
+		mPixels = value;
+	}
+	else if (regAddr == REG_SCENE_HEARTBEAT && value > 0)
+	{
+		mHeartbeat = value;
+	}//End if
+	taskEXIT_CRITICAL(&mLock);
+
+	ESP_LOGI(SCENETAG, SCENE_INFO_MODE, mMode, mDelta, mPixels, mHeartbeat);
+}//End sceneChange_WriteRegister
+
+/*
+ * ***********************************************************************
+ * @brief       sceneChange_Seed
+ * @param       pImage - Image taken as the background
+ * @return      None
+ * @details     The deviation starts at 0, the delta register keeps the
+ * 				noise out until the model has learnt it.
+ **************************************************************************/
+static void sceneChange_Seed(const uint16_t* pImage)
+{
+	for (uint16_t i = 0; i < SCENE_PIXELS; i++)
+	{
+		mMean[i] = (uint32_t)pImage[i] << SCENE_MEAN_FRAC_BITS;
+	}//End for
+	memset(mDev, 0, sizeof(mDev));
+	mLearnLeft = 1 << SCENE_LEARN_SHIFT;
+}//End sceneChange_Seed
+
+/*
+ * ***********************************************************************
+ * @brief       sceneChange_Update
+ * @param       pImage - Image of the frame
+ * 				delta - Smallest change of a pixel, raw frame units
+ * 				pStatus - Output, changed pixels and their bounding box
+ * @return      None
+ * @details     Classify every pixel against the model, then move the model
+ * 				towards it. Distances are compared on the deviation scale.
+ **************************************************************************/
+static void sceneChange_Update(const uint16_t* pImage, const uint8_t delta, sceneStatus_t* pStatus)
+{
+	const uint32_t minDist = (uint32_t)delta << SCENE_DEV_FRAC_BITS;
+	uint16_t count = 0;
+	uint8_t minX = SCENE_WIDTH, minY = SCENE_HEIGHT, maxX = 0, maxY = 0;
+
+	for (uint8_t y = 0; y < SCENE_HEIGHT; y++)
+	{
+		const uint16_t row = y * SCENE_WIDTH;
+		uint16_t rowCount = 0;
+		for (uint8_t x = 0; x < SCENE_WIDTH; x++)
+		{
+			const uint16_t i = row + x;
+			const int32_t diff = (int32_t)((uint32_t)pImage[i] << SCENE_MEAN_FRAC_BITS) - (int32_t)mMean[i];
+			uint32_t dist = (uint32_t)((diff < 0) ? -diff : diff) >> (SCENE_MEAN_FRAC_BITS - SCENE_DEV_FRAC_BITS);
+			dist = (dist > UINT16_MAX) ? UINT16_MAX : dist;
+
+			if (dist > SCENE_DEV_K * (uint32_t)mDev[i] + minDist)
+			{
+				mMean[i] += (uint32_t)(diff >> (SCENE_LEARN_SHIFT + SCENE_ABSORB_SHIFT));
+				minX = (x < minX) ? x : minX;
+				maxX = (x > maxX) ? x : maxX;
+				rowCount++;
+			}
+			else
+			{
+				mMean[i] += (uint32_t)(diff >> SCENE_LEARN_SHIFT);
+				mDev[i] += (int16_t)(((int32_t)dist - (int32_t)mDev[i]) >> SCENE_LEARN_SHIFT);
+			}//End if-else
+		}//End for
+		if (rowCount > 0)
+		{
+			minY = (y < minY) ? y : minY;
+			maxY = y;
+			count += rowCount;
+		}//End if
+	}//End for
+
+	pStatus->mCount = count;
+	pStatus->mMinX = (count > 0) ? minX : 0;
+	pStatus->mMinY = (count > 0) ? minY : 0;
+	pStatus->mMaxX = maxX;
+	pStatus->mMaxY = maxY;
+}//End sceneChange_Update
+
+#else
+
+bool sceneChange_Process(const uint16_t* pImage)
+{
+	(void)pImage;
+	return true;
+}//End sceneChange_Process
+
+uint16_t sceneChange_ReadRegister(const uint8_t regAddr)
+{
+	(void)regAddr;
+	return 0;
+}//End sceneChange_ReadRegister
+
+void sceneChange_WriteRegister(const uint8_t regAddr, const uint8_t value)
+{
+	(void)regAddr;
+	(void)value;
+}//End sceneChange_WriteRegister
+
+#endif
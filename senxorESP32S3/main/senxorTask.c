@@ -1,10 +1,16 @@
 /*****************************************************************************
  * @file     senxorTask.c
- * @version  2.01
+ * @version  2.07
  * @brief    FreeRTOS task for interfacing with SenXor
  * @date	 11 Jul 2022
  ******************************************************************************/
 #include <esp_log.h>				//ESP logger
+#include <esp_timer.h>				//Frame capture timestamps
+#include <esp_pm.h>					//Frequency scaling and light sleep
+#include <sys/param.h>				//MAX
+#include <string.h>					//memcmp
+#include <math.h>					//sqrt
+#include <freertos/semphr.h>			//Capture demand
 #include "Customer_Interface.h"
 #include "DrvLED.h"
 #include "DrvNVS.h"
@@ -16,22 +22,83 @@
 #include "SenXorLib.h"				//SenXor library
 #include "SenXor_Capturedata.h"		//Interrupt handler
 #include "senxorTask.h"
+#include "framePool.h"			//Frame buffer pool
+#include "quadrantMax.h"			//Quadrant maxima
+#include "roiEngine.h"				//Regions of interest
+#include "LatencyTrace.h"			//Per-stage latency
 #include "tcpServerTask.h"
 #include "cmdServerTask.h"
+#include "bleStreamTask.h"
+#include "flashLog.h"
+#include "frameSnapshot.h"
+#include "mjpegStream.h"
+#include "espNowTask.h"
+#include "mqttPublish.h"
+#include "bootTimeline.h"
+#include "pixelMap.h"				//Bad pixel correction
+#include "pixelCorrect.h"			//Per-pixel gain and offset
+#include "temporalFilter.h"			//Temporal noise filter
+#include "sceneChange.h"			//Background model and change gating
+#include "blobTrack.h"				//Hot spot blobs
+#include "ruleEngine.h"				//Alarm rules
+#include "frameClassifier.h"			//Flame and pan classifier
+#include "spiClockTune.h"			//SPI clock of the SenXor link
 #include "util.h"
 #include "ledCtrlTask.h"			//LED control task
 #include "Drv_CombustionBle.h"		//Combustion-compatible BLE
+#include "Drv_CRC.h"				//Calibration cache checksum
+#include "memProfile.h"				//Buffer placement
+#include "schedProfile.h"			//Analytics task split
 
 //public:
-EXT_RAM_BSS_ATTR uint16_t CalibData_BufferData[CALIBDATA_FLASH_SIZE];			//Array to hold the calibration data
-EXT_RAM_BSS_ATTR QueueHandle_t senxorFrameQueue = NULL;
+MEM_CALIB_ATTR uint16_t CalibData_BufferData[CALIBDATA_FLASH_SIZE];			//Array to hold the calibration data
 
 TaskHandle_t senxorTaskHandle = NULL;
 //private:
-EXT_RAM_BSS_ATTR static senxorFrame mSenxorFrameObj;
 static quadrantData_t mQuadrantData;  // Quadrant analysis data
 static uint8_t mDeviceId[6] = {0};    // BT MAC address for device identification
-static void senxorTask_Init(void);
+static uint32_t mFrameSeq = 0;        // Sequence number of the next frame let through by sceneChange
+static esp_timer_handle_t mQuadrantSaveTimer = NULL;  // Restarted by every write, commits once the writes stop
+static volatile bool mQuadrantDirty = false;          // Registers changed since the last commit
+static portMUX_TYPE mQuadrantLock = portMUX_INITIALIZER_UNLOCKED;
+static volatile uint8_t mCaptureRefs = 0;         // Stream clients, recorder and live view that need continuous capture
+static SemaphoreHandle_t mCaptureMutex = NULL;    // Orders the 0xB1 writes of the first and last reference
+static StaticSemaphore_t mCaptureMutexBuffer;
+#if CONFIG_MI_LIGHT_SLEEP_EN
+static esp_pm_lock_handle_t mCaptureLock = NULL;  // Held while the sensor captures, so no DATA_AV is slept through
+#endif
+static int64_t mJitterPrevUs = 0;                 // Receive time of the previous streamed frame, 0 after a mode change
+static uint32_t mJitterCount = 0;
+static uint32_t mJitterMinUs = 0;
+static uint32_t mJitterMaxUs = 0;
+static uint64_t mJitterSumUs = 0;
+static uint64_t mJitterSumSqUs = 0;
+static portMUX_TYPE mJitterLock = portMUX_INITIALIZER_UNLOCKED;
+
+static senxorRecovery_t mRecovery;                // Read by sysStatsTask
+static uint8_t mRecoverLevel = 0;                 // Level of the last recovery
+static int64_t mRecoverErrorUs = 0;               // Time of the last error
+static int64_t mRecoverStartUs = 0;               // Time of the error being recovered, 0 once a frame arrived
+static portMUX_TYPE mRecoveryLock = portMUX_INITIALIZER_UNLOCKED;
+#if SCHED_ANALYTICS_SPLIT
+TaskHandle_t senxorAnalyticsTaskHandle = NULL;
+static frameSubscriber_t mAnalyticsSub = FRAME_BUS_INVALID_ID;  // Frame bus mailbox of senxorAnalyticsTask
+static uint32_t mAnalyticsSkipBase = 0;           // Mailbox drops at the last jitter reset
+#endif
+
+static void senxorStreamFrame(void);
+static void senxorPollFrame(void);
+static void senxorAnalyse(const uint16_t* senxorData, const uint32_t seq);
+static void senxorJitterUpdate(const int64_t receiveUs);
+static void senxorRecoveryDone(const int64_t receiveUs);
+static int64_t senxorFrameTimeUs(const int64_t receiveUs);
+static uint8_t senxorGetDemandHz(void);
+static void senxorPowerInit(void);
+static void senxorCaptureHold(const bool hold);
+static void senxorLoadCalibration(void);
+static void quadrant_LoadLegacyConfig(quadrantConfig_t* pCfg);
+static void quadrant_MarkDirty(void);
+static void quadrant_SaveTimerCallback(void* arg);
 
 
 /*
@@ -39,11 +106,15 @@ static void senxorTask_Init(void);
  * @brief       senxorInit
  * @param       None
  * @return      None
- * @details     Initialise SenXor
+ * @details     Initialise SenXor. Every phase is timed, the log shows where
+ * 				the cold start goes.
  **************************************************************************/
 uint8_t senxorInit(void)
 {
+	const int64_t startUs = esp_timer_get_time();
+	int64_t phaseUs = startUs;
 
+	mCaptureMutex = xSemaphoreCreateMutexStatic(&mCaptureMutexBuffer);
 	Initialize_McuRegister();																//Initialise SenXor software registers
 
 	Power_On_Senxor(1);																//Power up SenXor and determine its model
@@ -56,30 +127,111 @@ uint8_t senxorInit(void)
 #endif
 		return 1; 																			//Exit program immediately if failed.
 	}//End if
+	ESP_LOGI(SXRTAG,SXR_BOOT_PHASE,"power-on",esp_timer_get_time() - phaseUs);
+	phaseUs = esp_timer_get_time();
+
+	senxorLoadCalibration();																//Load calibration data from the cache or flash
+	ESP_LOGI(SXRTAG,SXR_BOOT_PHASE,"calibration",esp_timer_get_time() - phaseUs);
+	phaseUs = esp_timer_get_time();
 
-	Read_CalibrationData();																	//Load calibration data from flash
 	ESP_LOGI(SXRTAG,SXR_PROCESS_CALI);
 	Process_CalibrationData(1,(uint16_t*)CalibData_BufferData);		//Process calibration data
+	ESP_LOGI(SXRTAG,SXR_BOOT_PHASE,"processing",esp_timer_get_time() - phaseUs);
+	phaseUs = esp_timer_get_time();
+
 	ESP_LOGI(SXRTAG,SXR_FITLER_INIT);
 	Initialize_Filter();																	//Initialise filters
 	Read_AGC_LUT();																			//Read auto gain
+	ESP_LOGI(SXRTAG,SXR_BOOT_PHASE,"filter / AGC",esp_timer_get_time() - phaseUs);
+	ESP_LOGI(SXRTAG,SXR_BOOT_PHASE,"total",esp_timer_get_time() - startUs);
 
 	/*
 	 * If TCP server is used, TCP server should be started BEFORE SenXor starting capture.
 	 */
 	Acces_Write_Reg(0xB1,0);													//Stop capturing
+	spiClockTune_Run();																		//Fastest reliable frame clock, capture stopped
 
 	ESP_LOGI(SXRTAG,SXR_INIT_DONE);
 
 	return 0;
 }
 
+/*
+ * ***********************************************************************
+ * @brief       senxorLoadCalibration
+ * @param       None
+ * @return      None
+ * @details     Fill CalibData_BufferData. The copy in NVS is used when its
+ * 				checksum holds and its first CALIB_CACHE_ID_BYTES match the
+ * 				SenXor flash, so a swapped module is read again. Otherwise
+ * 				the whole SenXor flash is read over SPI and cached.
+ * 				Process_CalibrationData and Read_AGC_LUT run on every boot,
+ * 				their results stay inside SenXorLib.
+ **************************************************************************/
+static void senxorLoadCalibration(void)
+{
+#if CONFIG_MI_CALIB_CACHE_EN
+	uint8_t head[CALIB_CACHE_ID_BYTES];
+	calibCacheHeader_t hdr;
+	const char* reason = NULL;
+	const bool isFlashOk = Read_CalibrationHead(head, sizeof(head));
+
+	if (!isFlashOk) {
+		reason = "unusable, no SenXor flash";
+	} else if (!NVS_ReadBlob(CALIB_CACHE_HDR_KEY, &hdr, sizeof(hdr))) {
+		reason = "empty";
+	} else if (hdr.mVersion != CALIB_CACHE_VERSION || hdr.mModel != SenXorModel || hdr.mLen != sizeof(CalibData_BufferData)) {
+		reason = "outdated";
+	} else if (!NVS_ReadBlob(CALIB_CACHE_DATA_KEY, CalibData_BufferData, sizeof(CalibData_BufferData))
+			|| Drv_Crc_Crc32(0, (const uint8_t*)CalibData_BufferData, sizeof(CalibData_BufferData)) != hdr.mCrc) {
+		reason = "corrupt";
+	} else if (memcmp(head, CalibData_BufferData, sizeof(head)) != 0) {
+		reason = "from another module";
+	}
+
+	if (reason == NULL) {
+		ESP_LOGI(SXRTAG, SXR_CALI_CACHE_HIT);
+		return;
+	}
+	ESP_LOGI(SXRTAG, SXR_CALI_CACHE_MISS, reason);
+#endif
+
+	ESP_LOGI(SXRTAG,SXR_FLASH_RD_INIT);
+	Read_CalibrationData();																	//Load calibration data from flash
+	ESP_LOGI(SXRTAG,SXR_FLASH_RD_DONE);
+
+#if CONFIG_MI_CALIB_CACHE_EN
+	if (isFlashOk) {
+		hdr.mVersion = CALIB_CACHE_VERSION;
+		hdr.mModel = SenXorModel;
+		hdr.mReserved = 0;
+		hdr.mLen = sizeof(CalibData_BufferData);
+		hdr.mCrc = Drv_Crc_Crc32(0, (const uint8_t*)CalibData_BufferData, sizeof(CalibData_BufferData));
+		NVS_WriteBlob(CALIB_CACHE_DATA_KEY, CalibData_BufferData, sizeof(CalibData_BufferData));
+		NVS_WriteBlob(CALIB_CACHE_HDR_KEY, &hdr, sizeof(hdr));
+		ESP_LOGI(SXRTAG, SXR_CALI_CACHE_SAVED, (unsigned)sizeof(CalibData_BufferData));
+	}
+#endif
+}
+
 /*
  * ***********************************************************************
  * @brief       senxorTask
  * @param       pvParameters - Task arguments
  * @return      None
- * @details     SenXor task
+ * @details     SenXor task. Sleeps until the capture interrupt completes a
+ * 				frame (SXR_NOTIFY_FRAME) or a client connects, leaves or
+ * 				changes its poll rate (SXR_NOTIFY_CLIENT).
+ * 				Mode 1: a frame port (3333), WebSocket or BLE client is streaming,
+ * 				or the recorder is armed, every frame is processed and published.
+ * 				Mode 2: command or BLE clients want frames. The rate is the
+ * 				highest any of them asked for. Up to
+ * 				CONFIG_MI_SINGLE_SHOT_MAX_HZ one frame is captured per
+ * 				deadline and the sensor idles in between, above it capture
+ * 				runs continuously and frames are taken on the deadline grid.
+ * 				Mode 3: idle, capture stopped if this task started it.
+ * 				In modes 1 and 2 the scene change gate (register 0xD9) can
+ * 				hold back the frames of a static scene after the filters.
  **************************************************************************/
 void senxorTask(void * pvParameters)
 {
@@ -88,149 +240,662 @@ void senxorTask(void * pvParameters)
 	ESP_LOGI(SXRTAG,MAIN_FREE_RAM " / " MAIN_TOTAL_RAM,heap_caps_get_free_size(MALLOC_CAP_INTERNAL), heap_caps_get_total_size(MALLOC_CAP_INTERNAL));				//Display the total amount of DRAM
 	ESP_LOGI(SXRTAG,MAIN_FREE_SPIRAM " / " MAIN_TOTAL_SPIRAM,heap_caps_get_free_size(MALLOC_CAP_SPIRAM), heap_caps_get_total_size(MALLOC_CAP_SPIRAM));				//Display the total amount of PSRAM
 
-	senxorTask_Init();																																					//Initialise queue
-
-	TickType_t lastPollTime = 0;
 	bool pollCaptureStarted = false;  // Track if we started capture for polling mode
+	bool pollSingleShot = false;      // Capture started as single shots rather than continuous
+	bool shotPending = false;         // Single shot requested, frame not yet received
+	int64_t shotStartUs = 0;          // Time the pending shot was requested
+	int64_t pollDeadlineUs = 0;       // Time the next polled frame is due
+	TickType_t waitTicks = pdMS_TO_TICKS(SXR_IDLE_WAIT_MS);
+
+	senxorPowerInit();
+	Capture_SetFrameTask(xTaskGetCurrentTaskHandle());								//Frame-complete interrupt wakes this task
 
 	for(;;)
 	{
-		bool framePortConnected = tcpServerGetIsClientConnected();
-		bool cmdPortConnected = cmdServerGetIsClientConnected();
-		uint8_t pollFreq = cmdServerGetPollFreqHz();
-		bool bleConnected = combustionBle_GetConnectionCount() > 0;
+		uint32_t events = 0;
+		xTaskNotifyWait(0, UINT32_MAX, &events, waitTicks);						//Frame, client change or timeout
 
-		// Mode 1: Frame streaming port (3333) connected - normal streaming behavior
+		bool framePortConnected = (mCaptureRefs > 0);
+		uint8_t demandHz = senxorGetDemandHz();
+
+		// Mode 1: Frame streaming port (3333), WebSocket viewer, BLE stream, recorder, LCD live view or USB vendor reader - normal streaming behavior
 		if (framePortConnected)
 		{
 			// If we had started capture for polling, frame streaming will take over
+			if (pollCaptureStarted && pollSingleShot)
+			{
+				Acces_Write_Reg(0xB1, 0x03);  // A stream client may have started capture between two shots
+			}
 			pollCaptureStarted = false;
+			shotPending = false;
+			senxorCaptureHold(true);
 
-			if ( (Acces_Read_Reg(0xB1) & B1_SINGLE_CONT) || (Acces_Read_Reg(0xB1) & B1_START_CAPTURE) )
+			if (events & SXR_NOTIFY_FRAME)
 			{
-				DataFrameReceiveSenxor();													//Receive frame from SenXor
-				const uint16_t* senxorData = DataFrameGetPointer();							//Get processed frame
-
-				if (senxorData != 0)
-				{
-#ifdef CONFIG_MI_SENXOR_DBG
-					printSenXorLog(senxorData);
-#endif
-					memcpy(mSenxorFrameObj.mFrame,senxorData,sizeof(mSenxorFrameObj.mFrame));	//Get a copy of thermal frame
-					quadrant_Calculate(senxorData);												//Calculate quadrant analysis values
-					senxorFrame* pSenxorFrameObj = &mSenxorFrameObj;							//Create a pointer to the copy of thermal frame  for sending to queue
-					xQueueSend(senxorFrameQueue, (void *)&pSenxorFrameObj, 0);					//Send to queue and do not wait for queue
-				}//End if
-				DataFrameProcess();															//Thermal frame post-processing
+				senxorStreamFrame();
 			}//End if
-			vTaskDelay(1);
+			waitTicks = pdMS_TO_TICKS(SXR_FRAME_WAIT_MS);
 		}
-		// Mode 2: Command port (3334) connected with polling enabled, OR BLE clients connected
-		else if ((cmdPortConnected && pollFreq > 0) || bleConnected)
+		// Mode 2: Command port (3334) polling or subscribed, OR BLE clients connected
+		else if (demandHz > 0)
 		{
-			// Start continuous capture if not already running
-			if (!pollCaptureStarted)
+			mJitterPrevUs = 0;  // Only streamed frames are measured
+			const bool singleShot = demandHz <= CONFIG_MI_SINGLE_SHOT_MAX_HZ;
+			const int64_t periodUs = 1000000 / demandHz;
+			const int64_t now = esp_timer_get_time();
+
+			// (Re)start capture when polling begins or the demand crosses the single-shot limit
+			if (!pollCaptureStarted || singleShot != pollSingleShot)
 			{
-				if (bleConnected) {
-					ESP_LOGI(SXRTAG, "Starting capture for BLE mode (%d clients)", combustionBle_GetConnectionCount());
-				} else {
-					ESP_LOGI(SXRTAG, "Starting capture for polling mode at %d Hz", pollFreq);
-				}
-				Acces_Write_Reg(0xB1, 0x03);  // Start continuous capture
+				ESP_LOGI(SXRTAG, SXR_CAP_DEMAND, demandHz, singleShot ? "single shot" : "continuous");
+				Acces_Write_Reg(0xB1, singleShot ? 0x00 : 0x03);  // Shots are requested at each deadline
+				senxorCaptureHold(!singleShot);
 				pollCaptureStarted = true;
-				lastPollTime = xTaskGetTickCount();  // Reset timer
-				vTaskDelay(pdMS_TO_TICKS(50));  // Give sensor time to start
-			}
-
-			// Calculate delay based on poll frequency (use 25Hz for BLE if no poll freq set)
-			uint8_t effectiveFreq = (pollFreq > 0) ? pollFreq : 25;
-			TickType_t pollDelayMs = 1000 / effectiveFreq;
-			TickType_t currentTime = xTaskGetTickCount();
+				pollSingleShot = singleShot;
+				shotPending = false;
+				pollDeadlineUs = now;         // First frame is due at once
+				events &= ~SXR_NOTIFY_FRAME;  // A frame of the previous mode is not a shot
+			}//End if
 
-			if (1 || (currentTime - lastPollTime) >= pdMS_TO_TICKS(pollDelayMs))
+			if (singleShot)
 			{
-				lastPollTime = currentTime;
-
-				DataFrameReceiveSenxor();
-				const uint16_t* senxorData = DataFrameGetPointer();
+				// Shot done, or lost: release the sensor until the next deadline
+				if (shotPending && ((events & SXR_NOTIFY_FRAME) || now - shotStartUs >= SXR_FRAME_WAIT_MS * 1000LL))
+				{
+					if (events & SXR_NOTIFY_FRAME)
+					{
+						senxorPollFrame();
+					}//End if
+					shotPending = false;
+					senxorCaptureHold(false);
+					pollDeadlineUs += periodUs;
+					if (pollDeadlineUs <= now)
+					{
+						pollDeadlineUs = now + periodUs;
+					}//End if
+				}//End if
 
-				if (senxorData != 0)
+				if (!shotPending && now >= pollDeadlineUs)
 				{
-					quadrant_Calculate(senxorData);  // Update quadrant registers and BLE
-					ESP_LOGD(SXRTAG, "Poll update: Amax=%u Dmax=%u",
-							 quadrant_ReadRegister(0xC2), quadrant_ReadRegister(0xC8));
-				}
-				DataFrameProcess();
+					senxorCaptureHold(true);
+					Acces_Write_Reg(0xB1, B1_START_CAPTURE);  // Capture one frame
+					shotPending = true;
+					shotStartUs = now;
+				}//End if
+
+				// Sleep until the shot completes or, rounded up, until the next deadline
+				waitTicks = shotPending ? pdMS_TO_TICKS(SXR_FRAME_WAIT_MS)
+							: (TickType_t)((pollDeadlineUs - now + portTICK_PERIOD_MS * 1000 - 1) / (portTICK_PERIOD_MS * 1000));
 			}
-			vTaskDelay(1);
+			// A frame up to half a period early is taken, so sensor jitter does not skip it
+			else
+			{
+				if ((events & SXR_NOTIFY_FRAME) && now >= pollDeadlineUs - periodUs / 2)
+				{
+					senxorPollFrame();
+					pollDeadlineUs += periodUs;   // Fixed grid: the average rate is exact
+					if (pollDeadlineUs <= now)
+					{
+						pollDeadlineUs = now + periodUs;  // Frames stalled, restart the grid instead of bursting
+					}//End if
+				}//End if
+				waitTicks = pdMS_TO_TICKS(SXR_FRAME_WAIT_MS);
+			}//End if-else
 		}
 		// Mode 3: Neither port connected and no BLE clients
 		else
 		{
+			mJitterPrevUs = 0;
 			// Stop capture if we started it for polling/BLE
 			if (pollCaptureStarted)
 			{
 				ESP_LOGI(SXRTAG, "Stopping capture (no active clients)");
 				Acces_Write_Reg(0xB1, 0x00);  // Stop capture
 				pollCaptureStarted = false;
+				shotPending = false;
 			}
-			vTaskDelay(pdMS_TO_TICKS(100));  // Sleep longer when idle
+			senxorCaptureHold(false);
+			waitTicks = pdMS_TO_TICKS(SXR_IDLE_WAIT_MS);
 		}
 	}//End for
 }//End senxorTask
 
+/*
+ * ***********************************************************************
+ * @brief       senxorTaskNotifyClientChange
+ * @param       None
+ * @return      None
+ * @details     Wake senxorTask to re-evaluate its mode. Called when a
+ * 				stream, command or BLE client connects or leaves, and when
+ * 				the poll rate or a subscription changes.
+ **************************************************************************/
+void senxorTaskNotifyClientChange(void)
+{
+	if (senxorTaskHandle != NULL)
+	{
+		xTaskNotify(senxorTaskHandle, SXR_NOTIFY_CLIENT, eSetBits);
+	}//End if
+}//End senxorTaskNotifyClientChange
 
 /*
  * ***********************************************************************
- * @brief       DataFrameReceiveError
+ * @brief       senxorAcquireCapture
  * @param       None
  * @return      None
- * @details     Frame receive error handler
+ * @details     A stream client, the recorder or the live view needs
+ * 				continuous capture. The first reference starts it.
  **************************************************************************/
-void DataFrameReceiveError(void)
+void senxorAcquireCapture(void)
 {
-	if(SenXorError)
-    {
-	  ESP_LOGE(SXRTAG,SXR_ERR,SenXorError);
-	  ESP_LOGW(SXRTAG,SXR_WARN_RECR);
-      SenXorError = 0;                                                    //Clear error flag
-      Acces_Write_Reg(0xB1,0);                                            //Stop capturing
-      Acces_Write_Reg(0xB0,3);                                            //Reinitialise SenXor
-    }//End if
-}
+	xSemaphoreTake(mCaptureMutex, portMAX_DELAY);
+	if (mCaptureRefs++ == 0)
+	{
+		Acces_Write_Reg(0xB1, 0x03);											//Start capture
+	}//End if
+	xSemaphoreGive(mCaptureMutex);
+	senxorTaskNotifyClientChange();
+}//End senxorAcquireCapture
+
+/*
+ * ***********************************************************************
+ * @brief       senxorReleaseCapture
+ * @param       None
+ * @return      None
+ * @details     Drop a reference taken with senxorAcquireCapture. The last
+ * 				one stops capture.
+ **************************************************************************/
+void senxorReleaseCapture(void)
+{
+	xSemaphoreTake(mCaptureMutex, portMAX_DELAY);
+	if (mCaptureRefs > 0 && --mCaptureRefs == 0)
+	{
+		Acces_Write_Reg(0xB1, 0x00);											//Stop capture
+	}//End if
+	xSemaphoreGive(mCaptureMutex);
+	senxorTaskNotifyClientChange();
+}//End senxorReleaseCapture
+
+/*
+ * ***********************************************************************
+ * @brief       senxorGetDemandHz
+ * @param       None
+ * @return      Frames per second wanted by the command and BLE clients
+ * 				and the flash log, 0 if none of them wants frames
+ * @details     The highest of the POLL rate, the fastest register
+ * 				subscription, the BLE advert update rate, the flash log,
+ * 				a bad pixel calibration, a waiting snapshot, the MJPEG
+ * 				viewers, the ESP-NOW peers and the MQTT samples
+ **************************************************************************/
+static uint8_t senxorGetDemandHz(void)
+{
+	uint8_t demandHz = MAX(MAX(flashLogGetDemandHz(), pixelMap_GetDemandHz()), frameSnapshotGetDemandHz());
+	demandHz = MAX(demandHz, mjpegGetDemandHz());
+	demandHz = MAX(demandHz, MAX(espNowGetDemandHz(), mqttPublishGetDemandHz()));
+	demandHz = MAX(demandHz, frameClassifierGetDemandHz());
+
+	if (cmdServerGetIsClientConnected())
+	{
+		demandHz = MAX(demandHz, MAX(cmdServerGetPollFreqHz(), cmdServerGetSubscribedRateHz()));
+	}//End if
+	if (combustionBle_GetConnectionCount() > 0)
+	{
+		demandHz = MAX(demandHz, COMBUSTION_UPDATE_RATE_HZ);  // Adverts do not refresh any faster
+	}//End if
+	return demandHz;
+}//End senxorGetDemandHz
+
+/*
+ * ***********************************************************************
+ * @brief       senxorPowerInit
+ * @param       None
+ * @return      None
+ * @details     With CONFIG_MI_LIGHT_SLEEP_EN, scale the CPU down to
+ * 				SXR_PM_MIN_FREQ_MHZ and allow light sleep while no capture
+ * 				is running. Takes the place of PowerDownChangeClock and
+ * 				CPU_SENXORPowerDown, whose MCU drivers this port lacks.
+ **************************************************************************/
+static void senxorPowerInit(void)
+{
+#if CONFIG_MI_LIGHT_SLEEP_EN
+	const esp_pm_config_t pmConfig = {
+		.max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+		.min_freq_mhz = SXR_PM_MIN_FREQ_MHZ,
+		.light_sleep_enable = true
+	};
+	esp_err_t err = esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "capture", &mCaptureLock);
+	if (err == ESP_OK)
+	{
+		err = esp_pm_configure(&pmConfig);
+	}//End if
+	if (err != ESP_OK)
+	{
+		ESP_LOGW(SXRTAG, SXR_PM_WARN, esp_err_to_name(err));
+		return;
+	}//End if
+	ESP_LOGI(SXRTAG, SXR_PM_INFO, SXR_PM_MIN_FREQ_MHZ, CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+#endif
+}//End senxorPowerInit
+
+/*
+ * ***********************************************************************
+ * @brief       senxorCaptureHold
+ * @param       hold - true while the sensor captures
+ * @return      None
+ * @details     Keep the CPU out of light sleep while a frame is on its
+ * 				way. Calls that do not change the state are ignored.
+ **************************************************************************/
+static void senxorCaptureHold(const bool hold)
+{
+#if CONFIG_MI_LIGHT_SLEEP_EN
+	static bool held = false;
+
+	if (mCaptureLock == NULL || hold == held)
+	{
+		return;
+	}//End if
+	if (hold)
+	{
+		esp_pm_lock_acquire(mCaptureLock);
+	}
+	else
+	{
+		esp_pm_lock_release(mCaptureLock);
+	}//End if-else
+	held = hold;
+#else
+	(void)hold;
+#endif
+}//End senxorCaptureHold
+
+/*
+ * ***********************************************************************
+ * @brief       senxorStreamFrame
+ * @param       None
+ * @return      None
+ * @details     Receive a completed frame and publish a copy to the frame
+ * 				bus. The shared scheduling profile analyses it first, the
+ * 				split profile leaves that to senxorAnalyticsTask, one of
+ * 				the subscribers, and runs DataFrameProcess while the frame
+ * 				is analysed and sent. A frame held back by sceneChange is
+ * 				neither analysed nor published and takes no sequence number.
+ **************************************************************************/
+static void senxorStreamFrame(void)
+{
+	DataFrameReceiveSenxor();													//Receive frame from SenXor
+	const int64_t captureUs = esp_timer_get_time();								//Capture time of this frame
+	uint16_t* senxorData = DataFrameGetPointer();								//Get processed frame, bad pixels are patched in place
 
+	if (senxorData != 0)
+	{
+#ifdef CONFIG_MI_SENXOR_DBG
+		printSenXorLog(senxorData);
+#endif
+		bootTimelineMark(BOOT_MARK_FIRST_FRAME);
+		senxorRecoveryDone(captureUs);
+		senxorJitterUpdate(captureUs);
+		pixelMap_Process(senxorData + (2 * SENXOR_FRAME_WIDTH));		//Patch bad pixels the conversion pass did not
+		temporalFilter_Process(senxorData + (2 * SENXOR_FRAME_WIDTH));	//Then filter over time, the stream gets the filtered image
+	}//End if
+
+	if (senxorData != 0 && sceneChange_Process(senxorData + (2 * SENXOR_FRAME_WIDTH)))	//A quiet frame of a gated scene ends here
+	{
+		const uint32_t seq = mFrameSeq++;											//Counted even when no slot is free, not for gated frames
+		LATENCY_TRACE_CAPTURE(seq);
+		LATENCY_TRACE_AT(LAT_STAGE_RECEIVE, seq, captureUs);
+		senxorFrame* pSenxorFrameObj = framePool_Alloc();							//Get a free slot from the frame pool
+		if (pSenxorFrameObj != NULL)
+		{
+			memcpy(pSenxorFrameObj->mFrame,senxorData,sizeof(pSenxorFrameObj->mFrame));	//Get a copy of thermal frame
+			pSenxorFrameObj->mSeq = seq;
+			pSenxorFrameObj->mTimestampUs = senxorFrameTimeUs(captureUs);
+			FrameStats_Get(&pSenxorFrameObj->mStats);
+		}//End if
+#if !SCHED_ANALYTICS_SPLIT
+		senxorAnalyse(senxorData, seq);												//Shared profile, analytics before the frame goes out
+#endif
+		if (pSenxorFrameObj != NULL)
+		{
+			framePool_Publish(pSenxorFrameObj);										//Hand the copy to consumers, never blocks
+			LATENCY_TRACE(LAT_STAGE_PUBLISH, seq);
+		}//End if
+	}//End if
+	pixelCorrect_Update();														//Take a committed correction map in between two frames
+	DataFrameProcess();															//Thermal frame post-processing, correction and bad pixels in the conversion pass
+}//End senxorStreamFrame
 
 /*
  * ***********************************************************************
- * @brief       senxorTask_Init
+ * @brief       senxorPollFrame
  * @param       None
  * @return      None
- * @details     Initialise SenXorTask
+ * @details     Receive and analyse a completed frame for the command and
+ * 				BLE clients, without publishing it to the stream consumers.
+ * 				In the split scheduling profile the copy goes to the
+ * 				analytics mailbox only.
  **************************************************************************/
-static void senxorTask_Init(void)
+static void senxorPollFrame(void)
 {
-	ESP_LOGI(MTAG,MAIN_INIT_QUEUE);
+	DataFrameReceiveSenxor();
+	const int64_t captureUs = esp_timer_get_time();
+	uint16_t* senxorData = DataFrameGetPointer();
 
-	senxorFrameQueue = xQueueCreate(THERMAL_FRAME_BUFFER_NO, sizeof(uint16_t*));
-	if( senxorFrameQueue == 0 )
+	if (senxorData != 0)
 	{
-		vTaskDelete(NULL);
+		bootTimelineMark(BOOT_MARK_FIRST_FRAME);
+		senxorRecoveryDone(captureUs);
+		pixelMap_Process(senxorData + (2 * SENXOR_FRAME_WIDTH));  // Patch bad pixels the conversion pass did not
+		temporalFilter_Process(senxorData + (2 * SENXOR_FRAME_WIDTH));  // Filter over time
 	}
 
+	if (senxorData != 0 && sceneChange_Process(senxorData + (2 * SENXOR_FRAME_WIDTH)))  // Quiet frames of a gated scene skip the analytics
+	{
+		const uint32_t seq = mFrameSeq++;
+#if SCHED_ANALYTICS_SPLIT
+		senxorFrame* pSenxorFrameObj = framePool_Alloc();
+		if (pSenxorFrameObj != NULL)
+		{
+			memcpy(pSenxorFrameObj->mFrame, senxorData, sizeof(pSenxorFrameObj->mFrame));
+			pSenxorFrameObj->mSeq = seq;
+			pSenxorFrameObj->mTimestampUs = senxorFrameTimeUs(captureUs);
+			FrameStats_Get(&pSenxorFrameObj->mStats);
+			framePool_PublishTo(pSenxorFrameObj, mAnalyticsSub);  // Quadrant, ROI, log, snapshot and subscribed registers
+		}//End if
+#else
+		senxorAnalyse(senxorData, seq);  // Quadrant, ROI, log, snapshot and subscribed registers
+		ESP_LOGD(SXRTAG, "Poll update: Amax=%u Dmax=%u",
+				 quadrant_ReadRegister(0xC2), quadrant_ReadRegister(0xC8));
+		(void)captureUs;
+#endif
+	}//End if
+	pixelCorrect_Update();
+	DataFrameProcess();
+}//End senxorPollFrame
+
+/*
+ * ***********************************************************************
+ * @brief       senxorAnalyse
+ * @param       senxorData - Full frame, 2 header rows then the image
+ * 				seq - Capture sequence number
+ * @return      None
+ * @details     Quadrant, ROI and blob analysis and the alarm rules,
+ * 				then the consumers that copy the image when they need it.
+ * 				None of them waits.
+ **************************************************************************/
+static void senxorAnalyse(const uint16_t* senxorData, const uint32_t seq)
+{
+	LATENCY_FUNC_BEGIN(LAT_FUNC_QUADRANT);
+	quadrant_Calculate(senxorData);												//Calculate quadrant analysis values
+	LATENCY_FUNC_END(LAT_FUNC_QUADRANT);
+	roiEngine_Process(senxorData + (2 * SENXOR_FRAME_WIDTH));					//ROI statistics, image starts after 2 header rows
+	blobTrack_Process(senxorData + (2 * SENXOR_FRAME_WIDTH), seq);				//Blobs and their tracks for the stream record
+	if (ruleEngine_Process(seq))												//Alarm rules, after the ROIs they read
+	{
+		bleStreamNotifyRule();
+		cmdServerNotifyRule();
+		espNowNotifyRule();
+		mqttPublishNotifyRule();
+	}//End if
+	flashLogOnFrame(senxorData + (2 * SENXOR_FRAME_WIDTH));						//Stage a log sample when one is due, never waits
+	mqttPublishOnFrame(seq);													//Add an MQTT sample when one is due, never waits
+	frameSnapshotOnFrame(senxorData + (2 * SENXOR_FRAME_WIDTH));				//Hand the image to a waiting snapshot request
+	mjpegOnFrame(senxorData + (2 * SENXOR_FRAME_WIDTH));						//Copy for the JPEG encoder when a client is due
+	espNowOnFrame(senxorData + (2 * SENXOR_FRAME_WIDTH), seq);					//Copy for the ESP-NOW frame peers when one is due
+	frameClassifierOnFrame(senxorData + (2 * SENXOR_FRAME_WIDTH));				//Copy for the classifier when an inference is due
+	LATENCY_TRACE(LAT_STAGE_ANALYTICS, seq);									//Polled frames have no receive stage, the reader skips them
+	cmdServerNotifyUpdate();													//Push subscribed registers
+}//End senxorAnalyse
+
+#if SCHED_ANALYTICS_SPLIT
+/*
+ * ***********************************************************************
+ * @brief       senxorAnalyticsTask
+ * @param       pvParameters - Not used
+ * @return      None
+ * @details     Split scheduling profile only. The analytics stage of the
+ * 				pipeline: takes the newest frame from its frame bus
+ * 				mailbox while senxorTask captures the next one into another
+ * 				slot and the transport tasks send an earlier one.
+ **************************************************************************/
+void senxorAnalyticsTask(void * pvParameters)
+{
+	mAnalyticsSub = framePool_Subscribe("ana", 1, FRAME_POLICY_LATEST_ONLY, xTaskGetCurrentTaskHandle());
+
+	for(;;)
+	{
+		senxorFrame* pFrame = framePool_Receive(mAnalyticsSub, portMAX_DELAY);
+		if (pFrame != NULL)
+		{
+			senxorAnalyse(pFrame->mFrame, pFrame->mSeq);
+			framePool_Release(pFrame);
+		}//End if
+	}//End for
+}//End senxorAnalyticsTask
+#endif
+
+/*
+ * ***********************************************************************
+ * @brief       senxorFrameTimeUs
+ * @param       receiveUs - Time the frame was received
+ * @return      Capture time of the frame
+ * @details     The capture interrupt takes the time the last block of the
+ * 				frame arrived, before the library processes it. That time
+ * 				does not wait on the scheduler and is the one used to align
+ * 				frames of several cameras. Without a recent one, e.g. when
+ * 				polled, the receive time is used.
+ **************************************************************************/
+static int64_t senxorFrameTimeUs(const int64_t receiveUs)
+{
+	const int64_t frameUs = Capture_GetFrameTimeUs();
+
+	if (frameUs > 0 && frameUs <= receiveUs && (receiveUs - frameUs) < SXR_FRAME_TIME_MAX_US)
+	{
+		return frameUs;
+	}//End if
+	return receiveUs;
+}//End senxorFrameTimeUs
+
+/*
+ * ***********************************************************************
+ * @brief       senxorJitterUpdate
+ * @param       receiveUs - Time the frame was received
+ * @return      None
+ * @details     Add the interval since the previous streamed frame
+ **************************************************************************/
+static void senxorJitterUpdate(const int64_t receiveUs)
+{
+	const int64_t prevUs = mJitterPrevUs;
+
+	mJitterPrevUs = receiveUs;
+	if (prevUs == 0)
+	{
+		return;
+	}//End if
+
+	const uint32_t intervalUs = (uint32_t)(receiveUs - prevUs);
+	taskENTER_CRITICAL(&mJitterLock);
+	if (mJitterCount == 0 || intervalUs < mJitterMinUs)
+	{
+		mJitterMinUs = intervalUs;
+	}//End if
+	mJitterMaxUs = MAX(mJitterMaxUs, intervalUs);
+	mJitterSumUs += intervalUs;
+	mJitterSumSqUs += (uint64_t)intervalUs * intervalUs;
+	++mJitterCount;
+	taskEXIT_CRITICAL(&mJitterLock);
+}//End senxorJitterUpdate
+
+/*
+ * ***********************************************************************
+ * @brief       senxorGetFrameJitter
+ * @param       pJitter - Filled with the intervals since the last reset
+ * 				reset - Start a new measurement
+ * @return      None
+ * @details     Streamed frames only, polled frames and single shots
+ * 				follow their own deadlines
+ **************************************************************************/
+void senxorGetFrameJitter(senxorJitter_t* pJitter, const bool reset)
+{
+	taskENTER_CRITICAL(&mJitterLock);
+	const uint32_t count = mJitterCount;
+	const uint64_t sum = mJitterSumUs;
+	const uint64_t sumSq = mJitterSumSqUs;
+	pJitter->mMinUs = mJitterMinUs;
+	pJitter->mMaxUs = mJitterMaxUs;
+	if (reset)
+	{
+		mJitterCount = 0;
+		mJitterMinUs = 0;
+		mJitterMaxUs = 0;
+		mJitterSumUs = 0;
+		mJitterSumSqUs = 0;
+	}//End if
+	taskEXIT_CRITICAL(&mJitterLock);
+
+	pJitter->mIntervals = count;
+	pJitter->mAvgUs = (count == 0) ? 0 : (uint32_t)(sum / count);
+	pJitter->mStdDevUs = 0;
+	if (count > 1)
+	{
+		const double mean = (double)sum / count;
+		const double variance = (double)sumSq / count - mean * mean;
+		pJitter->mStdDevUs = (variance > 0) ? (uint32_t)sqrt(variance) : 0;
+	}//End if
+#if SCHED_ANALYTICS_SPLIT
+	const uint32_t skipped = framePool_GetDropCount(mAnalyticsSub);			//Since boot, one reader resets
+	pJitter->mSkipped = skipped - mAnalyticsSkipBase;
+	if (reset)
+	{
+		mAnalyticsSkipBase = skipped;
+	}//End if
+#else
+	pJitter->mSkipped = 0;
+#endif
+}//End senxorGetFrameJitter
+
+
+/*
+ * ***********************************************************************
+ * @brief       senxorGetRecovery
+ * @param       pRecovery - Output, capture error recovery since boot
+ * @return      None
+ **************************************************************************/
+void senxorGetRecovery(senxorRecovery_t* pRecovery)
+{
+	taskENTER_CRITICAL(&mRecoveryLock);
+	*pRecovery = mRecovery;
+	taskEXIT_CRITICAL(&mRecoveryLock);
+	pRecovery->mSpiClockHz = Drv_SPI_GetFrameClock();
+}//End senxorGetRecovery
+
+/*
+ * ***********************************************************************
+ * @brief       senxorRecoveryDone
+ * @param       receiveUs - Time the frame was received
+ * @return      None
+ * @details     Called for every good frame, ends a running recovery and
+ * 				records how long the capture was interrupted
+ **************************************************************************/
+static void senxorRecoveryDone(const int64_t receiveUs)
+{
+	if (mRecoverStartUs == 0)
+	{
+		return;
+	}//End if
+
+	const uint32_t gapUs = (uint32_t)(receiveUs - mRecoverStartUs);
+	mRecoverStartUs = 0;
+	taskENTER_CRITICAL(&mRecoveryLock);
+	mRecovery.mLastUs = gapUs;
+	mRecovery.mMaxUs = MAX(mRecovery.mMaxUs, gapUs);
+	taskEXIT_CRITICAL(&mRecoveryLock);
+	ESP_LOGI(SXRTAG, SXR_INFO_RECOVERED, (unsigned long)gapUs);
+}//End senxorRecoveryDone
+
+/*
+ * ***********************************************************************
+ * @brief       DataFrameReceiveError
+ * @param       None
+ * @return      None
+ * @details     Frame receive error handler, called by SenXorLib in
+ * 				senxorTask. Recovery starts with the cheapest step that can
+ * 				clear a transient SPI glitch, stopping capture and starting
+ * 				it again at the next frame boundary. An error within
+ * 				SXR_RECOVER_WINDOW_MS of the previous one also resets the
+ * 				SPI engine and lowers a tuned SPI clock one step, a third
+ * 				reinitialises the SenXor. The capture
+ * 				mode is restored at every level, so the clients never have
+ * 				to start it again.
+ **************************************************************************/
+void DataFrameReceiveError(void)
+{
+	static const char* const levelName[] = {"resync", "SPI restart", "SenXor reinit"};
+
+	if(SenXorError)
+    {
+	  const int64_t nowUs = esp_timer_get_time();
+	  const uint32_t error = SenXorError;
+	  const uint8_t capture = Acces_Read_Reg(0xB1) & (B1_START_CAPTURE | B1_SINGLE_CONT);
+	  ESP_LOGE(SXRTAG,SXR_ERR,error);
+	  SenXorError = 0;                                                    //Clear error flag
+
+	  const bool repeated = (mRecoverErrorUs != 0) && (nowUs - mRecoverErrorUs < SXR_RECOVER_WINDOW_MS * 1000LL);
+	  mRecoverLevel = repeated ? MIN(mRecoverLevel + 1, SXR_RECOVER_REINIT) : SXR_RECOVER_RESYNC;
+	  mRecoverErrorUs = nowUs;
+	  if (capture == 0)
+	  {
+		  mRecoverStartUs = 0;                                            //No frame expected, nothing to measure
+	  }
+	  else if (mRecoverStartUs == 0)
+	  {
+		  mRecoverStartUs = nowUs;                                        //Measured from the first error of a burst
+	  }//End if-else
+	  ESP_LOGW(SXRTAG,SXR_WARN_RECR_LEVEL,mRecoverLevel,levelName[mRecoverLevel - 1]);
+
+      Acces_Write_Reg(0xB1,0);                                            //Stop capturing
+      Capture_Reset();                                                    //Drop the partial frame
+      if (mRecoverLevel >= SXR_RECOVER_SPI)
+      {
+    	  spiClockTune_Fallback();                                        //One clock step down, if tuned
+    	  Drv_SPI_Restart();                                              //Empty the FIFOs, reset the DMA channels
+      }//End if
+      if (mRecoverLevel >= SXR_RECOVER_REINIT)
+      {
+    	  Acces_Write_Reg(0xB0,3);                                        //Reinitialise SenXor
+    	  Customer_InvalidateTgain();                                     //0xB9 may be back to its default
+      }//End if
+      if (capture != 0)
+      {
+    	  Acces_Write_Reg(0xB1,capture);                                  //Resume at the next frame
+      }//End if
+
+	  taskENTER_CRITICAL(&mRecoveryLock);
+	  mRecovery.mErrors++;
+	  mRecovery.mLastError = error;
+	  mRecovery.mLevel[mRecoverLevel - 1]++;
+	  taskEXIT_CRITICAL(&mRecoveryLock);
+    }//End if
 }
 
+
 /*
  * ***********************************************************************
  * @brief       quadrant_Init
  * @param       None
  * @return      None
- * @details     Initialize quadrant analysis, load split values from NVS
+ * @details     Initialize quadrant analysis, load the split and burner
+ * 				configuration from NVS with one blob read
  **************************************************************************/
 void quadrant_Init(void)
 {
-	// Load Xsplit and Ysplit from NVS, use defaults if not found
-	mQuadrantData.Xsplit = NVS_ReadU8("xsplit", DEFAULT_XSPLIT);
-	mQuadrantData.Ysplit = NVS_ReadU8("ysplit", DEFAULT_YSPLIT);
+	quadrantConfig_t cfg;
+
+	// Load the configuration blob, or migrate the per-register keys of older firmware once
+	if (!NVS_ReadBlob(QUADRANT_NVS_KEY, &cfg, sizeof(cfg)) || cfg.mVersion != QUADRANT_CFG_VERSION) {
+		quadrant_LoadLegacyConfig(&cfg);
+		NVS_WriteBlob(QUADRANT_NVS_KEY, &cfg, sizeof(cfg));
+	}
+	mQuadrantData.Xsplit = cfg.mXsplit;
+	mQuadrantData.Ysplit = cfg.mYsplit;
 
 	// Validate ranges
 	if (mQuadrantData.Xsplit > SENXOR_FRAME_WIDTH) {
@@ -250,25 +915,15 @@ void quadrant_Init(void)
 	mQuadrantData.Dmax = 0;
 	mQuadrantData.Dcenter = 0;
 
-	// Calculate default burner coordinates (center of each quadrant)
-	uint8_t defAx = DEFAULT_XSPLIT / 2;
-	uint8_t defAy = DEFAULT_YSPLIT / 2;
-	uint8_t defBx = DEFAULT_XSPLIT + (SENXOR_FRAME_WIDTH - DEFAULT_XSPLIT) / 2;
-	uint8_t defBy = DEFAULT_YSPLIT / 2;
-	uint8_t defCx = DEFAULT_XSPLIT / 2;
-	uint8_t defCy = DEFAULT_YSPLIT + (SENXOR_FRAME_HEIGHT - DEFAULT_YSPLIT) / 2;
-	uint8_t defDx = DEFAULT_XSPLIT + (SENXOR_FRAME_WIDTH - DEFAULT_XSPLIT) / 2;
-	uint8_t defDy = DEFAULT_YSPLIT + (SENXOR_FRAME_HEIGHT - DEFAULT_YSPLIT) / 2;
-
-	// Load burner coordinates from NVS, use defaults if not found
-	mQuadrantData.Aburnerx = NVS_ReadU8("aburnerx", defAx);
-	mQuadrantData.Aburnery = NVS_ReadU8("aburnery", defAy);
-	mQuadrantData.Bburnerx = NVS_ReadU8("bburnerx", defBx);
-	mQuadrantData.Bburnery = NVS_ReadU8("bburnery", defBy);
-	mQuadrantData.Cburnerx = NVS_ReadU8("cburnerx", defCx);
-	mQuadrantData.Cburnery = NVS_ReadU8("cburnery", defCy);
-	mQuadrantData.Dburnerx = NVS_ReadU8("dburnerx", defDx);
-	mQuadrantData.Dburnery = NVS_ReadU8("dburnery", defDy);
+	// Burner coordinates
+	mQuadrantData.Aburnerx = cfg.mAburnerx;
+	mQuadrantData.Aburnery = cfg.mAburnery;
+	mQuadrantData.Bburnerx = cfg.mBburnerx;
+	mQuadrantData.Bburnery = cfg.mBburnery;
+	mQuadrantData.Cburnerx = cfg.mCburnerx;
+	mQuadrantData.Cburnery = cfg.mCburnery;
+	mQuadrantData.Dburnerx = cfg.mDburnerx;
+	mQuadrantData.Dburnery = cfg.mDburnery;
 
 	// Initialize burner temperature values to 0
 	mQuadrantData.Aburnert = 0;
@@ -276,6 +931,13 @@ void quadrant_Init(void)
 	mQuadrantData.Cburnert = 0;
 	mQuadrantData.Dburnert = 0;
 
+	// Register writes are committed together once they stop
+	const esp_timer_create_args_t saveTimerArgs = {
+		.callback = quadrant_SaveTimerCallback,
+		.name = "quadsave"
+	};
+	esp_timer_create(&saveTimerArgs, &mQuadrantSaveTimer);
+
 	// Read BT MAC address for device identification
 	esp_read_mac(mDeviceId, ESP_MAC_BT);
 
@@ -296,7 +958,8 @@ void quadrant_Init(void)
  * @brief       quadrant_Calculate
  * @param       frameData - Pointer to thermal frame data (80x64 pixels)
  * @return      None
- * @details     Calculate quadrant max and center values from frame data
+ * @details     Calculate quadrant max and center values from frame data,
+ * 				see quadrantMax_Calculate, and hand them to Combustion BLE
  **************************************************************************/
 void quadrant_Calculate(const uint16_t* frameData)
 {
@@ -304,71 +967,20 @@ void quadrant_Calculate(const uint16_t* frameData)
 		return;
 	}
 
-	uint8_t xsplit = mQuadrantData.Xsplit;
-	uint8_t ysplit = mQuadrantData.Ysplit;
-
-	// Reset max values
-	uint16_t Amax = 0, Bmax = 0, Cmax = 0, Dmax = 0;
-
 	// Skip first 2 header rows - image data starts at row 2 (index 160)
 	const uint16_t* imageData = frameData + (2 * SENXOR_FRAME_WIDTH);
 
-	// Scan all pixels and find max for each quadrant
-	for (uint8_t y = 0; y < SENXOR_FRAME_HEIGHT; y++) {
-		for (uint8_t x = 0; x < SENXOR_FRAME_WIDTH; x++) {
-			uint16_t pixel = imageData[y * SENXOR_FRAME_WIDTH + x];
-
-			if (x < xsplit && y < ysplit) {
-				// Quadrant A (top-left)
-				if (pixel > Amax) Amax = pixel;
-			} else if (x >= xsplit && y < ysplit) {
-				// Quadrant B (top-right)
-				if (pixel > Bmax) Bmax = pixel;
-			} else if (x < xsplit && y >= ysplit) {
-				// Quadrant C (bottom-left)
-				if (pixel > Cmax) Cmax = pixel;
-			} else {
-				// Quadrant D (bottom-right)
-				if (pixel > Dmax) Dmax = pixel;
-			}
-		}
+#if CONFIG_MI_QUADRANT_BENCH
+	const uint8_t xsplit = mQuadrantData.Xsplit;
+	const uint8_t ysplit = mQuadrantData.Ysplit;
+	static int16_t benchSplit = -1;
+	if (benchSplit != (xsplit << 8 | ysplit)) {
+		benchSplit = xsplit << 8 | ysplit;									// Time both paths again whenever the split moves
+		quadrantMax_Benchmark(imageData, xsplit, ysplit);
 	}
+#endif
 
-	// Calculate center pixel coordinates for each quadrant
-	uint8_t Acx = xsplit / 2;
-	uint8_t Acy = ysplit / 2;
-	uint8_t Bcx = xsplit + (SENXOR_FRAME_WIDTH - xsplit) / 2;
-	uint8_t Bcy = ysplit / 2;
-	uint8_t Ccx = xsplit / 2;
-	uint8_t Ccy = ysplit + (SENXOR_FRAME_HEIGHT - ysplit) / 2;
-	uint8_t Dcx = xsplit + (SENXOR_FRAME_WIDTH - xsplit) / 2;
-	uint8_t Dcy = ysplit + (SENXOR_FRAME_HEIGHT - ysplit) / 2;
-
-	// Clamp center coordinates to valid range
-	if (Acx >= SENXOR_FRAME_WIDTH) Acx = SENXOR_FRAME_WIDTH - 1;
-	if (Acy >= SENXOR_FRAME_HEIGHT) Acy = SENXOR_FRAME_HEIGHT - 1;
-	if (Bcx >= SENXOR_FRAME_WIDTH) Bcx = SENXOR_FRAME_WIDTH - 1;
-	if (Bcy >= SENXOR_FRAME_HEIGHT) Bcy = SENXOR_FRAME_HEIGHT - 1;
-	if (Ccx >= SENXOR_FRAME_WIDTH) Ccx = SENXOR_FRAME_WIDTH - 1;
-	if (Ccy >= SENXOR_FRAME_HEIGHT) Ccy = SENXOR_FRAME_HEIGHT - 1;
-	if (Dcx >= SENXOR_FRAME_WIDTH) Dcx = SENXOR_FRAME_WIDTH - 1;
-	if (Dcy >= SENXOR_FRAME_HEIGHT) Dcy = SENXOR_FRAME_HEIGHT - 1;
-
-	// Store results (use imageData which is offset past headers)
-	mQuadrantData.Amax = Amax;
-	mQuadrantData.Acenter = imageData[Acy * SENXOR_FRAME_WIDTH + Acx];
-	mQuadrantData.Bmax = Bmax;
-	mQuadrantData.Bcenter = imageData[Bcy * SENXOR_FRAME_WIDTH + Bcx];
-	mQuadrantData.Cmax = Cmax;
-	mQuadrantData.Ccenter = imageData[Ccy * SENXOR_FRAME_WIDTH + Ccx];
-	mQuadrantData.Dmax = Dmax;
-	mQuadrantData.Dcenter = imageData[Dcy * SENXOR_FRAME_WIDTH + Dcx];
-
-	// Read burner temperatures at stored coordinates
-	mQuadrantData.Aburnert = imageData[mQuadrantData.Aburnery * SENXOR_FRAME_WIDTH + mQuadrantData.Aburnerx];
-	mQuadrantData.Bburnert = imageData[mQuadrantData.Bburnery * SENXOR_FRAME_WIDTH + mQuadrantData.Bburnerx];
-	mQuadrantData.Cburnert = imageData[mQuadrantData.Cburnery * SENXOR_FRAME_WIDTH + mQuadrantData.Cburnerx];
-	mQuadrantData.Dburnert = imageData[mQuadrantData.Dburnery * SENXOR_FRAME_WIDTH + mQuadrantData.Dburnerx];
+	quadrantMax_Calculate(imageData, &mQuadrantData);
 
 	// Update Combustion BLE with latest temperatures
 	uint16_t combustion_temps[8] = {
@@ -429,7 +1041,9 @@ uint16_t quadrant_ReadRegister(uint8_t regAddr)
  * @param       regAddr - Register address (0xC0, 0xC1, or burner coords)
  * @param       value - Value to write
  * @return      None
- * @details     Write quadrant register (split values and burner coordinates)
+ * @details     Write quadrant register (split values and burner coordinates).
+ * 				NVS is written QUADRANT_SAVE_QUIET_MS after the last write,
+ * 				so a burst of WREGs costs one commit.
  **************************************************************************/
 void quadrant_WriteRegister(uint8_t regAddr, uint8_t value)
 {
@@ -440,14 +1054,14 @@ void quadrant_WriteRegister(uint8_t regAddr, uint8_t value)
 		case REG_XSPLIT:
 			if (value <= SENXOR_FRAME_WIDTH) {
 				mQuadrantData.Xsplit = value;
-				NVS_WriteU8("xsplit", value);
+				quadrant_MarkDirty();
 				ESP_LOGI(SXRTAG, "Xsplit set to %d", value);
 			}
 			break;
 		case REG_YSPLIT:
 			if (value <= SENXOR_FRAME_HEIGHT) {
 				mQuadrantData.Ysplit = value;
-				NVS_WriteU8("ysplit", value);
+				quadrant_MarkDirty();
 				ESP_LOGI(SXRTAG, "Ysplit set to %d", value);
 			}
 			break;
@@ -455,13 +1069,13 @@ void quadrant_WriteRegister(uint8_t regAddr, uint8_t value)
 		case REG_ABURNERX:
 			if (value >= xsplit) value = xsplit > 0 ? xsplit - 1 : 0;
 			mQuadrantData.Aburnerx = value;
-			NVS_WriteU8("aburnerx", value);
+			quadrant_MarkDirty();
 			ESP_LOGI(SXRTAG, "Aburnerx set to %d", value);
 			break;
 		case REG_ABURNERY:
 			if (value >= ysplit) value = ysplit > 0 ? ysplit - 1 : 0;
 			mQuadrantData.Aburnery = value;
-			NVS_WriteU8("aburnery", value);
+			quadrant_MarkDirty();
 			ESP_LOGI(SXRTAG, "Aburnery set to %d", value);
 			break;
 		// Quadrant B burner (top-right): x in [xsplit, 79], y in [0, ysplit-1]
@@ -469,27 +1083,27 @@ void quadrant_WriteRegister(uint8_t regAddr, uint8_t value)
 			if (value < xsplit) value = xsplit;
 			if (value >= SENXOR_FRAME_WIDTH) value = SENXOR_FRAME_WIDTH - 1;
 			mQuadrantData.Bburnerx = value;
-			NVS_WriteU8("bburnerx", value);
+			quadrant_MarkDirty();
 			ESP_LOGI(SXRTAG, "Bburnerx set to %d", value);
 			break;
 		case REG_BBURNERY:
 			if (value >= ysplit) value = ysplit > 0 ? ysplit - 1 : 0;
 			mQuadrantData.Bburnery = value;
-			NVS_WriteU8("bburnery", value);
+			quadrant_MarkDirty();
 			ESP_LOGI(SXRTAG, "Bburnery set to %d", value);
 			break;
 		// Quadrant C burner (bottom-left): x in [0, xsplit-1], y in [ysplit, 61]
 		case REG_CBURNERX:
 			if (value >= xsplit) value = xsplit > 0 ? xsplit - 1 : 0;
 			mQuadrantData.Cburnerx = value;
-			NVS_WriteU8("cburnerx", value);
+			quadrant_MarkDirty();
 			ESP_LOGI(SXRTAG, "Cburnerx set to %d", value);
 			break;
 		case REG_CBURNERY:
 			if (value < ysplit) value = ysplit;
 			if (value >= SENXOR_FRAME_HEIGHT) value = SENXOR_FRAME_HEIGHT - 1;
 			mQuadrantData.Cburnery = value;
-			NVS_WriteU8("cburnery", value);
+			quadrant_MarkDirty();
 			ESP_LOGI(SXRTAG, "Cburnery set to %d", value);
 			break;
 		// Quadrant D burner (bottom-right): x in [xsplit, 79], y in [ysplit, 61]
@@ -497,14 +1111,14 @@ void quadrant_WriteRegister(uint8_t regAddr, uint8_t value)
 			if (value < xsplit) value = xsplit;
 			if (value >= SENXOR_FRAME_WIDTH) value = SENXOR_FRAME_WIDTH - 1;
 			mQuadrantData.Dburnerx = value;
-			NVS_WriteU8("dburnerx", value);
+			quadrant_MarkDirty();
 			ESP_LOGI(SXRTAG, "Dburnerx set to %d", value);
 			break;
 		case REG_DBURNERY:
 			if (value < ysplit) value = ysplit;
 			if (value >= SENXOR_FRAME_HEIGHT) value = SENXOR_FRAME_HEIGHT - 1;
 			mQuadrantData.Dburnery = value;
-			NVS_WriteU8("dburnery", value);
+			quadrant_MarkDirty();
 			ESP_LOGI(SXRTAG, "Dburnery set to %d", value);
 			break;
 		default:
@@ -512,3 +1126,96 @@ void quadrant_WriteRegister(uint8_t regAddr, uint8_t value)
 			break;
 	}
 }
+
+/*
+ * ***********************************************************************
+ * @brief       quadrant_SaveConfig
+ * @param       None
+ * @return      None
+ * @details     Commit the split and burner registers as one NVS blob if
+ * 				any changed. Called by the SAVE command and by the quiet
+ * 				period timer.
+ **************************************************************************/
+void quadrant_SaveConfig(void)
+{
+	quadrantConfig_t cfg;
+
+	taskENTER_CRITICAL(&mQuadrantLock);
+	const bool isDirty = mQuadrantDirty;
+	mQuadrantDirty = false;  // Cleared before the copy, a write from now on is saved again
+	taskEXIT_CRITICAL(&mQuadrantLock);
+	if (!isDirty) {
+		return;
+	}
+
+	if (mQuadrantSaveTimer != NULL) {
+		esp_timer_stop(mQuadrantSaveTimer);  // Not running when called from it
+	}
+
+	cfg.mVersion = QUADRANT_CFG_VERSION;
+	cfg.mXsplit = mQuadrantData.Xsplit;
+	cfg.mYsplit = mQuadrantData.Ysplit;
+	cfg.mAburnerx = mQuadrantData.Aburnerx;
+	cfg.mAburnery = mQuadrantData.Aburnery;
+	cfg.mBburnerx = mQuadrantData.Bburnerx;
+	cfg.mBburnery = mQuadrantData.Bburnery;
+	cfg.mCburnerx = mQuadrantData.Cburnerx;
+	cfg.mCburnery = mQuadrantData.Cburnery;
+	cfg.mDburnerx = mQuadrantData.Dburnerx;
+	cfg.mDburnery = mQuadrantData.Dburnery;
+	NVS_WriteBlob(QUADRANT_NVS_KEY, &cfg, sizeof(cfg));
+	ESP_LOGI(SXRTAG, "Quadrant configuration saved");
+}
+
+/*
+ * ***********************************************************************
+ * @brief       quadrant_LoadLegacyConfig
+ * @param       pCfg - Filled with the per-register NVS keys, or the defaults
+ * @return      None
+ * @details     Firmware before the configuration blob kept every register
+ * 				under its own key. Only read once, when the blob is missing.
+ **************************************************************************/
+static void quadrant_LoadLegacyConfig(quadrantConfig_t* pCfg)
+{
+	// Default burner coordinates are the center of each quadrant
+	pCfg->mVersion = QUADRANT_CFG_VERSION;
+	pCfg->mXsplit = NVS_ReadU8("xsplit", DEFAULT_XSPLIT);
+	pCfg->mYsplit = NVS_ReadU8("ysplit", DEFAULT_YSPLIT);
+	pCfg->mAburnerx = NVS_ReadU8("aburnerx", DEFAULT_XSPLIT / 2);
+	pCfg->mAburnery = NVS_ReadU8("aburnery", DEFAULT_YSPLIT / 2);
+	pCfg->mBburnerx = NVS_ReadU8("bburnerx", DEFAULT_XSPLIT + (SENXOR_FRAME_WIDTH - DEFAULT_XSPLIT) / 2);
+	pCfg->mBburnery = NVS_ReadU8("bburnery", DEFAULT_YSPLIT / 2);
+	pCfg->mCburnerx = NVS_ReadU8("cburnerx", DEFAULT_XSPLIT / 2);
+	pCfg->mCburnery = NVS_ReadU8("cburnery", DEFAULT_YSPLIT + (SENXOR_FRAME_HEIGHT - DEFAULT_YSPLIT) / 2);
+	pCfg->mDburnerx = NVS_ReadU8("dburnerx", DEFAULT_XSPLIT + (SENXOR_FRAME_WIDTH - DEFAULT_XSPLIT) / 2);
+	pCfg->mDburnery = NVS_ReadU8("dburnery", DEFAULT_YSPLIT + (SENXOR_FRAME_HEIGHT - DEFAULT_YSPLIT) / 2);
+}
+
+/*
+ * ***********************************************************************
+ * @brief       quadrant_MarkDirty
+ * @param       None
+ * @return      None
+ * @details     Restart the quiet period, the commit follows the last write
+ **************************************************************************/
+static void quadrant_MarkDirty(void)
+{
+	mQuadrantDirty = true;
+	if (mQuadrantSaveTimer != NULL) {
+		esp_timer_stop(mQuadrantSaveTimer);
+		esp_timer_start_once(mQuadrantSaveTimer, QUADRANT_SAVE_QUIET_MS * 1000ULL);
+	}
+}
+
+/*
+ * ***********************************************************************
+ * @brief       quadrant_SaveTimerCallback
+ * @param       arg - Not used
+ * @return      None
+ * @details     Runs in the esp_timer task, which has an internal RAM stack
+ * 				for the flash write. One blob commit takes a few ms.
+ **************************************************************************/
+static void quadrant_SaveTimerCallback(void* arg)
+{
+	quadrant_SaveConfig();
+}
@@ -0,0 +1,179 @@
+/*****************************************************************************
+ * @file     spiClockTune.c
+ * @version  1.00
+ * @brief    Boot time selection of the SPI clock of the SenXor link.
+ * @date	 15 Oct 2026
+ * @details	 The capture interrupt reads the frame word by word, so its time
+ * 			 scales with the SPI clock, and the clock a board carries depends
+ * 			 on its wiring. spiClockTune_Run reads the identity registers at
+ * 			 the slowest clock, then again SPI_TUNE_ROUNDS times at each
+ * 			 faster clock, and stops at the first clock with a wrong read.
+ * 			 Capture runs CONFIG_MI_SPI_TUNE_MARGIN steps below the fastest
+ * 			 clock that passed.
+ *
+ * 			 The result is saved with the identity of the module. A warm boot
+ * 			 with the same module only checks the saved clock with a short
+ * 			 test, and tunes again if it fails. spiClockTune_Fallback steps the
+ * 			 clock down after a capture error burst and saves it.
+ ******************************************************************************/
+#include <string.h>
+#include <esp_log.h>
+
+#include "DrvNVS.h"
+#include "DrvSPIHost.h"
+#include "spiClockTune.h"
+
+#if CONFIG_MI_SPI_TUNE_EN
+
+//private:
+static const uint32_t mClocks[SPI_TUNE_CLOCK_COUNT] = SPI_TUNE_CLOCKS;
+static const uint8_t mRegs[SPI_TUNE_REG_COUNT] = SPI_TUNE_REGS;
+static spiTuneConfig_t mConfig;
+
+static bool spiClockTune_ReadId(uint8_t* pId);
+static uint16_t spiClockTune_Test(const uint8_t level, const uint8_t* pId, const uint16_t rounds);
+static void spiClockTune_Apply(const uint8_t level);
+
+/*
+ * ***********************************************************************
+ * @brief       spiClockTune_Run
+ * @param       None
+ * @return      None
+ * @details     Called by senxorInit once the SenXor is initialised and
+ * 				capture is stopped. Leaves the frame clock as it was when
+ * 				the identity cannot be read reliably.
+ **************************************************************************/
+void spiClockTune_Run(void)
+{
+	uint8_t id[SPI_TUNE_REG_COUNT];
+
+	spiClockTune_Apply(0);
+	if (!spiClockTune_ReadId(id))
+	{
+		ESP_LOGW(SPITUNETAG, SPI_TUNE_WARN_BASELINE);
+		Drv_SPI_SetFrameClock(0);
+		return;
+	}//End if
+
+	// Same module as last time: check the saved clock only
+	if (NVS_ReadBlob(SPI_TUNE_NVS_KEY, &mConfig, sizeof(mConfig)) && mConfig.mVersion == SPI_TUNE_CFG_VERSION
+			&& mConfig.mLevel < SPI_TUNE_CLOCK_COUNT && memcmp(mConfig.mId, id, sizeof(id)) == 0
+			&& spiClockTune_Test(mConfig.mLevel, id, SPI_TUNE_VERIFY_ROUNDS) == 0)
+	{
+		ESP_LOGI(SPITUNETAG, SPI_TUNE_INFO_CACHED, (unsigned long)mClocks[mConfig.mLevel]);
+		spiClockTune_Apply(mConfig.mLevel);
+		return;
+	}//End if
+
+	uint8_t fastest = 0;
+	for (uint8_t level = 1; level < SPI_TUNE_CLOCK_COUNT; level++)
+	{
+		const uint16_t errors = spiClockTune_Test(level, id, SPI_TUNE_ROUNDS);
+		if (errors > 0)
+		{
+			ESP_LOGI(SPITUNETAG, SPI_TUNE_INFO_FAIL, (unsigned long)mClocks[level], errors, SPI_TUNE_ROUNDS * SPI_TUNE_REG_COUNT);
+			break;
+		}//End if
+		ESP_LOGI(SPITUNETAG, SPI_TUNE_INFO_PASS, (unsigned long)mClocks[level]);
+		fastest = level;
+	}//End for
+
+	mConfig.mVersion = SPI_TUNE_CFG_VERSION;
+	mConfig.mLevel = (fastest > CONFIG_MI_SPI_TUNE_MARGIN) ? (fastest - CONFIG_MI_SPI_TUNE_MARGIN) : 0;
+	memcpy(mConfig.mId, id, sizeof(id));
+	NVS_WriteBlob(SPI_TUNE_NVS_KEY, &mConfig, sizeof(mConfig));
+
+	ESP_LOGI(SPITUNETAG, SPI_TUNE_INFO_SELECT, (unsigned long)mClocks[mConfig.mLevel], (unsigned long)mClocks[fastest]);
+	spiClockTune_Apply(mConfig.mLevel);
+}//End spiClockTune_Run
+
+/*
+ * ***********************************************************************
+ * @brief       spiClockTune_Fallback
+ * @param       None
+ * @return      False if the clock is already the slowest
+ * @details     Called by senxorTask on a capture error burst, with capture
+ * 				stopped. The lower clock is saved, so the next boot keeps it.
+ **************************************************************************/
+bool spiClockTune_Fallback(void)
+{
+	if (mConfig.mVersion != SPI_TUNE_CFG_VERSION || mConfig.mLevel == 0)
+	{
+		return false;
+	}//End if
+
+	mConfig.mLevel--;
+	NVS_WriteBlob(SPI_TUNE_NVS_KEY, &mConfig, sizeof(mConfig));
+	spiClockTune_Apply(mConfig.mLevel);
+	ESP_LOGW(SPITUNETAG, SPI_TUNE_WARN_FALLBACK, (unsigned long)mClocks[mConfig.mLevel]);
+	return true;
+}//End spiClockTune_Fallback
+
+/*
+ * ***********************************************************************
+ * @brief       spiClockTune_ReadId
+ * @param       pId - Output, identity registers
+ * @return      False if three reads at the slowest clock disagree, or the
+ * 				bus reads all zeros or all ones
+ **************************************************************************/
+static bool spiClockTune_ReadId(uint8_t* pId)
+{
+	bool allZero = true, allOnes = true;
+
+	for (uint8_t i = 0; i < SPI_TUNE_REG_COUNT; i++)
+	{
+		pId[i] = (uint8_t)Drv_SPI_Senxor_Read_Reg(mRegs[i]);
+		allZero = allZero && (pId[i] == 0x00);
+		allOnes = allOnes && (pId[i] == 0xFF);
+	}//End for
+
+	return !allZero && !allOnes && spiClockTune_Test(0, pId, 2) == 0;
+}//End spiClockTune_ReadId
+
+/*
+ * ***********************************************************************
+ * @brief       spiClockTune_Test
+ * @param       level - Index into SPI_TUNE_CLOCKS
+ * 				pId - Expected identity registers
+ * 				rounds - Reads of every register
+ * @return      Wrong reads
+ **************************************************************************/
+static uint16_t spiClockTune_Test(const uint8_t level, const uint8_t* pId, const uint16_t rounds)
+{
+	uint16_t errors = 0;
+
+	spiClockTune_Apply(level);
+	for (uint16_t r = 0; r < rounds; r++)
+	{
+		for (uint8_t i = 0; i < SPI_TUNE_REG_COUNT; i++)
+		{
+			errors += ((uint8_t)Drv_SPI_Senxor_Read_Reg(mRegs[i]) != pId[i]) ? 1 : 0;
+		}//End for
+	}//End for
+
+	return errors;
+}//End spiClockTune_Test
+
+/*
+ * ***********************************************************************
+ * @brief       spiClockTune_Apply
+ * @param       level - Index into SPI_TUNE_CLOCKS
+ * @return      None
+ **************************************************************************/
+static void spiClockTune_Apply(const uint8_t level)
+{
+	Drv_SPI_SetFrameClock(mClocks[level]);
+}//End spiClockTune_Apply
+
+#else
+
+void spiClockTune_Run(void)
+{
+}//End spiClockTune_Run
+
+bool spiClockTune_Fallback(void)
+{
+	return false;
+}//End spiClockTune_Fallback
+
+#endif
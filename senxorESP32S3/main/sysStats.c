@@ -0,0 +1,463 @@
+/*****************************************************************************
+ * @file     sysStats.c
+ * @version  1.03
+ * @brief    Periodic task, heap and frame bus telemetry, served on GET
+ * 			 /stats and with the SYST command.
+ * @date	 14 Oct 2026
+ * @details	 Every SYS_STATS_PERIOD_MS one sample is taken into a ring:
+ * 			 CPU share and stack high-water mark of every task, free heap by
+ * 			 region and the frame bus counters. Readers copy from the ring,
+ * 			 so a request never walks the task list itself. A sample costs
+ * 			 one uxTaskGetSystemState, a few hundred microseconds with the
+ * 			 scheduler suspended.
+ *
+ * 			 CPU shares come from the FreeRTOS run time counters, in
+ * 			 microseconds of esp_timer. They are a share of both cores, so
+ * 			 a task spinning on one core reads 50 %.
+ ******************************************************************************/
+#include <string.h>
+#include <stdlib.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include <esp_http_server.h>
+#include <sdkconfig.h>
+#include "restServer.h"
+#include "sysStats.h"
+#include "schedProfile.h"
+
+#if CONFIG_MI_SYS_STATS_EN
+
+//private:
+EXT_RAM_BSS_ATTR static sysStatsSample_t mRing[SYS_STATS_RING_SIZE];	//Newest at mHead - 1
+EXT_RAM_BSS_ATTR static sysStatsSample_t mWork;							//Sample being taken
+EXT_RAM_BSS_ATTR static TaskStatus_t mStatus[SYS_STATS_MAX_TASKS];
+static TaskHandle_t mPrevHandle[SYS_STATS_MAX_TASKS];					//Tasks of the previous sample
+static configRUN_TIME_COUNTER_TYPE mPrevRunTime[SYS_STATS_MAX_TASKS];
+static uint8_t mPrevCount = 0;
+static configRUN_TIME_COUNTER_TYPE mPrevTotal = 0;
+static uint16_t mHead = 0;
+static uint16_t mCount = 0;
+static SemaphoreHandle_t mLock = NULL;
+static StaticSemaphore_t mLockBuffer;
+static const uint32_t mHeapCaps[SYS_HEAP_COUNT] = {MALLOC_CAP_INTERNAL, MALLOC_CAP_DMA, MALLOC_CAP_SPIRAM};
+static const char* const mHeapName[SYS_HEAP_COUNT] = {"internal", "dma", "psram"};
+
+// Fields of one history entry of GET /stats
+typedef struct sysStatsHistory{
+	uint32_t mTimeMs;
+	uint32_t mInternalFree;
+	uint32_t mPsramFree;
+	uint32_t mDropped;
+	uint32_t mJitterUs;
+	uint32_t mIntervalMaxUs;
+	uint16_t mIdlePermille;
+}sysStatsHistory_t;
+
+EXT_RAM_BSS_ATTR static sysStatsSample_t mReply;						//Newest sample of the reply being sent, httpd task only
+EXT_RAM_BSS_ATTR static sysStatsHistory_t mHistory[SYS_STATS_RING_SIZE];	//History of the reply being sent
+
+static void sysStats_Sample(void);
+static void sysStats_SampleTasks(sysStatsSample_t* pSample);
+static void sysStats_RegisterUri(void);
+static esp_err_t sysStats_GetHandler(httpd_req_t *req);
+
+/*
+ * ***********************************************************************
+ * @brief       sysStatsTask
+ * @param       pvParameters - Not used
+ * @return      None
+ * @details     Take one sample every SYS_STATS_PERIOD_MS
+ **************************************************************************/
+void sysStatsTask(void *pvParameters)
+{
+	mLock = xSemaphoreCreateMutexStatic(&mLockBuffer);
+	sysStats_RegisterUri();
+	ESP_LOGI(SYSSTATTAG, SYS_STATS_INFO_START, SYS_STATS_PERIOD_MS, SYS_STATS_RING_SIZE);
+
+	TickType_t lastWake = xTaskGetTickCount();
+	for(;;)
+	{
+		sysStats_Sample();
+		vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(SYS_STATS_PERIOD_MS));
+	}//End for
+}//End sysStatsTask
+
+/*
+ * ***********************************************************************
+ * @brief       sysStats_GetLatest
+ * @param       pSample - Filled with the newest sample
+ * @return      false if no sample was taken yet
+ **************************************************************************/
+bool sysStats_GetLatest(sysStatsSample_t* pSample)
+{
+	if(mLock == NULL)
+	{
+		return false;
+	}//End if
+
+	xSemaphoreTake(mLock, portMAX_DELAY);
+	const bool ok = (mCount > 0);
+	if(ok)
+	{
+		memcpy(pSample, &mRing[(mHead + SYS_STATS_RING_SIZE - 1) % SYS_STATS_RING_SIZE], sizeof(sysStatsSample_t));
+	}//End if
+	xSemaphoreGive(mLock);
+	return ok;
+}//End sysStats_GetLatest
+
+/*
+ * ***********************************************************************
+ * @brief       sysStats_GetSummary
+ * @param       pUptimeS - Uptime of the newest sample, seconds
+ * 				pInternalFree, pInternalMin - Internal heap free and lowest free
+ * 				pPsramFree - PSRAM heap free
+ * 				pDropped - Frames dropped by the frame bus, full mailboxes
+ * 				and no free slot together
+ * 				pDeepest - Frames waiting in the fullest mailbox
+ * @return      false if no sample was taken yet
+ * @details     For the SYST command
+ **************************************************************************/
+bool sysStats_GetSummary(uint32_t* pUptimeS, uint32_t* pInternalFree, uint32_t* pInternalMin, uint32_t* pPsramFree, uint32_t* pDropped, uint8_t* pDeepest)
+{
+	if(mLock == NULL)
+	{
+		return false;
+	}//End if
+
+	xSemaphoreTake(mLock, portMAX_DELAY);
+	const bool ok = (mCount > 0);
+	if(ok)
+	{
+		const sysStatsSample_t* pSample = &mRing[(mHead + SYS_STATS_RING_SIZE - 1) % SYS_STATS_RING_SIZE];
+		*pUptimeS = pSample->mTimeMs / 1000;
+		*pInternalFree = pSample->mHeapFree[SYS_HEAP_INTERNAL];
+		*pInternalMin = pSample->mHeapMin[SYS_HEAP_INTERNAL];
+		*pPsramFree = pSample->mHeapFree[SYS_HEAP_PSRAM];
+		*pDropped = pSample->mBus.mDropped + pSample->mBus.mNoSlot;
+		*pDeepest = pSample->mBus.mDeepest;
+	}//End if
+	xSemaphoreGive(mLock);
+	return ok;
+}//End sysStats_GetSummary
+
+/*
+ * ***********************************************************************
+ * @brief       sysStats_GetTask
+ * @param       pName - Task name
+ * 				pCpuPermille - CPU share of the task in the newest sample
+ * 				pStackFree - Lowest free stack of the task, bytes
+ * @return      false if the task was not in the newest sample
+ **************************************************************************/
+bool sysStats_GetTask(const char* pName, uint16_t* pCpuPermille, uint16_t* pStackFree)
+{
+	bool found = false;
+
+	if(mLock == NULL)
+	{
+		return false;
+	}//End if
+
+	xSemaphoreTake(mLock, portMAX_DELAY);
+	if(mCount > 0)
+	{
+		const sysStatsSample_t* pSample = &mRing[(mHead + SYS_STATS_RING_SIZE - 1) % SYS_STATS_RING_SIZE];
+		for(uint8_t i = 0; i < pSample->mTaskCount && !found; i++)
+		{
+			if(strncmp(pSample->mTask[i].mName, pName, configMAX_TASK_NAME_LEN) == 0)
+			{
+				*pCpuPermille = pSample->mTask[i].mCpuPermille;
+				*pStackFree = pSample->mTask[i].mStackFree;
+				found = true;
+			}//End if
+		}//End for
+	}//End if
+	xSemaphoreGive(mLock);
+	return found;
+}//End sysStats_GetTask
+
+/*
+ * ***********************************************************************
+ * @brief       sysStats_Sample
+ * @param       None
+ * @return      None
+ * @details     Take a sample into mWork, then append it to the ring
+ **************************************************************************/
+static void sysStats_Sample(void)
+{
+	mWork.mTimeMs = (uint32_t)(esp_timer_get_time() / 1000);
+	for(uint8_t i = 0; i < SYS_HEAP_COUNT; i++)
+	{
+		mWork.mHeapFree[i] = heap_caps_get_free_size(mHeapCaps[i]);
+		mWork.mHeapMin[i] = heap_caps_get_minimum_free_size(mHeapCaps[i]);
+		mWork.mHeapLargest[i] = heap_caps_get_largest_free_block(mHeapCaps[i]);
+	}//End for
+	framePool_GetBusStats(&mWork.mBus);
+	senxorGetFrameJitter(&mWork.mCapture, true);
+	senxorGetRecovery(&mWork.mRecovery);
+	frameClassifier_GetStats(&mWork.mClassify, true);
+	sysStats_SampleTasks(&mWork);
+
+	xSemaphoreTake(mLock, portMAX_DELAY);
+	memcpy(&mRing[mHead], &mWork, sizeof(mWork));
+	mHead = (mHead + 1) % SYS_STATS_RING_SIZE;
+	if(mCount < SYS_STATS_RING_SIZE)
+	{
+		++mCount;
+	}//End if
+	xSemaphoreGive(mLock);
+}//End sysStats_Sample
+
+/*
+ * ***********************************************************************
+ * @brief       sysStats_SampleTasks
+ * @param       pSample - Sample to fill the tasks of
+ * @return      None
+ * @details     CPU shares are taken over the run time since the previous
+ * 				sample, a task started in between counts from its start.
+ * 				With more than SYS_STATS_MAX_TASKS tasks no task is sampled.
+ **************************************************************************/
+static void sysStats_SampleTasks(sysStatsSample_t* pSample)
+{
+	configRUN_TIME_COUNTER_TYPE total = 0;
+	const UBaseType_t count = uxTaskGetSystemState(mStatus, SYS_STATS_MAX_TASKS, &total);
+
+	pSample->mTaskCount = 0;
+	pSample->mIdlePermille = 0;
+	if(count == 0)
+	{
+		ESP_LOGW(SYSSTATTAG, SYS_STATS_WARN_TASKS, (unsigned int)uxTaskGetNumberOfTasks(), SYS_STATS_MAX_TASKS);
+		return;
+	}//End if
+
+	const uint64_t elapsed = (uint64_t)(configRUN_TIME_COUNTER_TYPE)(total - mPrevTotal) * portNUM_PROCESSORS;
+	for(UBaseType_t i = 0; i < count; i++)
+	{
+		configRUN_TIME_COUNTER_TYPE prev = 0;
+		for(uint8_t j = 0; j < mPrevCount; j++)
+		{
+			if(mPrevHandle[j] == mStatus[i].xHandle)
+			{
+				prev = mPrevRunTime[j];
+				break;
+			}//End if
+		}//End for
+
+		sysTaskStats_t* pTask = &pSample->mTask[i];
+		const configRUN_TIME_COUNTER_TYPE run = mStatus[i].ulRunTimeCounter - prev;
+		pTask->mCpuPermille = (elapsed == 0) ? 0 : (uint16_t)(((uint64_t)run * 1000) / elapsed);
+		strlcpy(pTask->mName, mStatus[i].pcTaskName, sizeof(pTask->mName));
+		pTask->mStackFree = (uint16_t)mStatus[i].usStackHighWaterMark;
+		pTask->mPriority = (uint8_t)mStatus[i].uxCurrentPriority;
+		pTask->mState = (uint8_t)mStatus[i].eCurrentState;
+		for(BaseType_t core = 0; core < portNUM_PROCESSORS; core++)
+		{
+			if(mStatus[i].xHandle == xTaskGetIdleTaskHandleForCore(core))
+			{
+				pSample->mIdlePermille += pTask->mCpuPermille;
+			}//End if
+		}//End for
+
+		mPrevHandle[i] = mStatus[i].xHandle;
+		mPrevRunTime[i] = mStatus[i].ulRunTimeCounter;
+	}//End for
+	pSample->mTaskCount = (uint8_t)count;
+	mPrevCount = (uint8_t)count;
+	mPrevTotal = total;
+}//End sysStats_SampleTasks
+
+/*
+ * ***********************************************************************
+ * @brief       sysStats_RegisterUri
+ * @param       None
+ * @return      None
+ * @details     Serve SYS_STATS_URI on the REST server, in Wi-Fi mode only
+ **************************************************************************/
+static void sysStats_RegisterUri(void)
+{
+	httpd_handle_t server = getRestServerHandler();
+	if(server == NULL)
+	{
+		ESP_LOGW(SYSSTATTAG, SYS_STATS_WARN_NO_SERVER);
+		return;
+	}//End if
+
+	const httpd_uri_t statsUri = {
+		.uri = SYS_STATS_URI,
+		.method = HTTP_GET,
+		.handler = sysStats_GetHandler,
+		.user_ctx = NULL
+	};
+	const esp_err_t err = httpd_register_uri_handler(server, &statsUri);
+	if(err != ESP_OK)
+	{
+		ESP_LOGE(SYSSTATTAG, SYS_STATS_ERR_REGISTER, esp_err_to_name(err));
+	}//End if
+}//End sysStats_RegisterUri
+
+/*
+ * ***********************************************************************
+ * @brief       sysStats_GetHandler
+ * @param       req - HTTP request
+ * @return      ESP_OK, ESP_FAIL if the client went away
+ * @details     Runs in the httpd task. The newest sample in full, the live
+ * 				frame mailboxes and a short history of every sample kept,
+ * 				oldest first, as JSON. The samples are copied first, so
+ * 				the sampler never waits for the client.
+ **************************************************************************/
+static esp_err_t sysStats_GetHandler(httpd_req_t *req)
+{
+	jsonWriter_t json;
+	uint16_t count = 0;
+
+	const bool isSampled = sysStats_GetLatest(&mReply);					//Copies under the lock, the reply is sent without it
+	xSemaphoreTake(mLock, portMAX_DELAY);
+	for(; count < mCount; count++)
+	{
+		const sysStatsSample_t* pSample = &mRing[(mHead + SYS_STATS_RING_SIZE - mCount + count) % SYS_STATS_RING_SIZE];
+		mHistory[count] = (sysStatsHistory_t){
+			.mTimeMs = pSample->mTimeMs,
+			.mInternalFree = pSample->mHeapFree[SYS_HEAP_INTERNAL],
+			.mPsramFree = pSample->mHeapFree[SYS_HEAP_PSRAM],
+			.mDropped = pSample->mBus.mDropped + pSample->mBus.mNoSlot,
+			.mJitterUs = pSample->mCapture.mStdDevUs,
+			.mIntervalMaxUs = pSample->mCapture.mMaxUs,
+			.mIdlePermille = pSample->mIdlePermille
+		};
+	}//End for
+	xSemaphoreGive(mLock);
+
+	restServer_JsonBegin(&json, req);
+	jsonBeginObject(&json, NULL);
+	jsonAddInt(&json, "period_ms", SYS_STATS_PERIOD_MS);
+
+	if(isSampled)
+	{
+		const sysStatsSample_t* pSample = &mReply;
+		jsonAddInt(&json, "uptime_ms", pSample->mTimeMs);
+		jsonAddFloat(&json, "cpu_busy_pct", (1000 - pSample->mIdlePermille) / 10.0, 1);
+
+		jsonBeginArray(&json, "tasks");
+		for(uint8_t i = 0; i < pSample->mTaskCount; i++)
+		{
+			jsonBeginObject(&json, NULL);
+			jsonAddString(&json, "name", pSample->mTask[i].mName);
+			jsonAddFloat(&json, "cpu_pct", pSample->mTask[i].mCpuPermille / 10.0, 1);
+			jsonAddInt(&json, "stack_free", pSample->mTask[i].mStackFree);
+			jsonAddInt(&json, "priority", pSample->mTask[i].mPriority);
+			jsonAddInt(&json, "state", pSample->mTask[i].mState);
+			jsonEndObject(&json);
+		}//End for
+		jsonEndArray(&json);
+
+		jsonBeginObject(&json, "heap");
+		for(uint8_t i = 0; i < SYS_HEAP_COUNT; i++)
+		{
+			jsonBeginObject(&json, mHeapName[i]);
+			jsonAddInt(&json, "free", pSample->mHeapFree[i]);
+			jsonAddInt(&json, "min", pSample->mHeapMin[i]);
+			jsonAddInt(&json, "largest", pSample->mHeapLargest[i]);
+			jsonEndObject(&json);
+		}//End for
+		jsonEndObject(&json);
+
+		jsonBeginObject(&json, "frame_bus");
+		jsonAddInt(&json, "subscribers", pSample->mBus.mSubscribers);
+		jsonAddInt(&json, "slots_used", pSample->mBus.mSlotsUsed);
+		jsonAddInt(&json, "deepest", pSample->mBus.mDeepest);
+		jsonAddInt(&json, "dropped", pSample->mBus.mDropped);
+		jsonAddInt(&json, "no_slot", pSample->mBus.mNoSlot);
+		jsonEndObject(&json);
+
+		jsonBeginObject(&json, "capture");
+		jsonAddString(&json, "profile", SCHED_PROFILE_NAME);
+		jsonAddInt(&json, "intervals", pSample->mCapture.mIntervals);
+		jsonAddInt(&json, "interval_avg_us", pSample->mCapture.mAvgUs);
+		jsonAddInt(&json, "interval_min_us", pSample->mCapture.mMinUs);
+		jsonAddInt(&json, "interval_max_us", pSample->mCapture.mMaxUs);
+		jsonAddInt(&json, "jitter_us", pSample->mCapture.mStdDevUs);
+		jsonAddInt(&json, "analytics_skipped", pSample->mCapture.mSkipped);
+		jsonEndObject(&json);
+
+		jsonBeginObject(&json, "recovery");
+		jsonAddInt(&json, "errors", pSample->mRecovery.mErrors);
+		jsonAddInt(&json, "last_error", pSample->mRecovery.mLastError);
+		jsonAddInt(&json, "resyncs", pSample->mRecovery.mLevel[SXR_RECOVER_RESYNC - 1]);
+		jsonAddInt(&json, "spi_restarts", pSample->mRecovery.mLevel[SXR_RECOVER_SPI - 1]);
+		jsonAddInt(&json, "reinits", pSample->mRecovery.mLevel[SXR_RECOVER_REINIT - 1]);
+		jsonAddInt(&json, "last_us", pSample->mRecovery.mLastUs);
+		jsonAddInt(&json, "max_us", pSample->mRecovery.mMaxUs);
+		jsonAddInt(&json, "spi_clock_hz", pSample->mRecovery.mSpiClockHz);
+		jsonEndObject(&json);
+
+#if CONFIG_MI_CLASSIFY_EN
+		jsonBeginObject(&json, "classify");
+		jsonAddInt(&json, "inferences", pSample->mClassify.mInferences);
+		jsonAddInt(&json, "busy", pSample->mClassify.mBusy);
+		jsonAddInt(&json, "avg_us", pSample->mClassify.mAvgUs);
+		jsonAddInt(&json, "max_us", pSample->mClassify.mMaxUs);
+		jsonAddInt(&json, "last_us", pSample->mClassify.mLastUs);
+		jsonEndObject(&json);
+#endif
+	}//End if
+
+	jsonBeginArray(&json, "history");
+	for(uint16_t k = 0; k < count; k++)
+	{
+		const sysStatsHistory_t* pEntry = &mHistory[k];
+		jsonBeginObject(&json, NULL);
+		jsonAddInt(&json, "t_ms", pEntry->mTimeMs);
+		jsonAddFloat(&json, "cpu_busy_pct", (1000 - pEntry->mIdlePermille) / 10.0, 1);
+		jsonAddInt(&json, "internal_free", pEntry->mInternalFree);
+		jsonAddInt(&json, "psram_free", pEntry->mPsramFree);
+		jsonAddInt(&json, "dropped", pEntry->mDropped);
+		jsonAddInt(&json, "jitter_us", pEntry->mJitterUs);
+		jsonAddInt(&json, "interval_max_us", pEntry->mIntervalMaxUs);
+		jsonEndObject(&json);
+	}//End for
+	jsonEndArray(&json);
+
+	jsonBeginArray(&json, "mailboxes");										//Live, not sampled
+	for(frameSubscriber_t sub = 0; sub < FRAME_BUS_MAX_SUBSCRIBERS; sub++)
+	{
+		const char* pName;
+		uint8_t queued, depth;
+		uint32_t dropped;
+		if(framePool_GetMailboxStats(sub, &pName, &queued, &depth, &dropped))
+		{
+			jsonBeginObject(&json, NULL);
+			jsonAddString(&json, "name", (pName != NULL) ? pName : "");
+			jsonAddInt(&json, "queued", queued);
+			jsonAddInt(&json, "depth", depth);
+			jsonAddInt(&json, "dropped", dropped);
+			jsonEndObject(&json);
+		}//End if
+	}//End for
+	jsonEndArray(&json);
+	jsonEndObject(&json);
+
+	return restServer_JsonEnd(&json, req);
+}//End sysStats_GetHandler
+
+#else
+
+bool sysStats_GetLatest(sysStatsSample_t* pSample)
+{
+	(void)pSample;
+	return false;
+}//End sysStats_GetLatest
+
+bool sysStats_GetSummary(uint32_t* pUptimeS, uint32_t* pInternalFree, uint32_t* pInternalMin, uint32_t* pPsramFree, uint32_t* pDropped, uint8_t* pDeepest)
+{
+	return false;
+}//End sysStats_GetSummary
+
+bool sysStats_GetTask(const char* pName, uint16_t* pCpuPermille, uint16_t* pStackFree)
+{
+	return false;
+}//End sysStats_GetTask
+
+#endif
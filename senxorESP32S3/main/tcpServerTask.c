@@ -1,20 +1,26 @@
 /*****************************************************************************
  * @file     tcpServerTask.c
- * @version  1.5
+ * @version  1.16
  * @brief    TCP server main task. Provide functions for handling socket flow.
  * @date	 17 Jul 2022
  * @author	 Meridian Innovations
  ******************************************************************************/
 #include <stdint.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdbool.h>
 #include <sys/param.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <freertos/semphr.h>
 #include <esp_system.h>
 #include <esp_event.h>
 #include <esp_log.h>
 #include <esp_netif.h>
+#include <esp_timer.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <esp_vfs_eventfd.h>
 
 #include <lwip/err.h>
 #include <lwip/sockets.h>
@@ -22,18 +28,36 @@
 #include <lwip/netdb.h>
 
 #include "DrvSPIHost.h"
+#include "DrvWLAN.h"
 #include "SenXorLib.h"
 #include "ledCtrlTask.h"
 #include "tcpServerTask.h"
+#include "framePool.h"
+#include "LatencyTrace.h"
+#include "bootTimeline.h"
+#include "memProfile.h"
+#include "schedProfile.h"
+#include "protoSchema.h"
+
+//The clients are generated from protocolSchema.json, fail the build if the wire format moved away from it
+PROTO_CHECK_STREAM_HEADER(tcpStreamHeader_t);
+PROTO_CHECK_STREAM_SHAPE(tcpStreamShape_t);
+PROTO_CHECK_FRAME_STATS(frameStats_t);
+PROTO_CHECK_BLOB_RECORD(blobRecord_t);
+PROTO_CHECK_BLOB_ENTRY(blobEntry_t);
+PROTO_CHECK_UDP_CHUNK_HEADER(udpChunkHeader_t);
+PROTO_CHECK_STREAM_FLAG(TCP_STREAM_FLAG_);
+PROTO_CHECK_STREAM_ENCODING(TCP_STREAM_ENC_);
+_Static_assert(TCP_STREAM_MAGIC == PROTO_MAGIC_STREAM && UDP_CHUNK_MAGIC == PROTO_MAGIC_UDP_CHUNK &&
+		UDP_HELLO_MAGIC == PROTO_MAGIC_UDP_HELLO && UDP_BYE_MAGIC == PROTO_MAGIC_UDP_BYE, "Magic differs from protocolSchema.json");
 
 //public:
-extern QueueHandle_t senxorFrameQueue;
 TaskHandle_t tcpServerTaskHandle = NULL;						//TCP server handler
 
 //private:
 //Buffers - command handling moved to cmdServerTask
 EXT_RAM_BSS_ATTR static uint8_t 	mRxBuff[16];					//Small buffer for disconnect detection
-EXT_RAM_BSS_ATTR static uint8_t 	mTxBuff[PACKET_SIZE];			//Buffer holding the thermal data
+MEM_HOT_ATTR static uint8_t 	mTxBuff[PACKET_SIZE];			//Buffer holding the thermal data
 
 static uint16_t mMemcpySize = 0;
 static uint16_t mMemcpyOffset = 12;
@@ -41,10 +65,16 @@ static uint16_t mTxPacketSize = 0;
 static uint16_t mTxSize = PACKET_SIZE;
 
 //Sockets file descriptors
-static int connect_sock = 0;									//Client Socket file descriptor. TCP Only
-static int server_sock = 0;										//Server Socket file descriptor
+static int server_sock = -1;										//Server Socket file descriptor
+
+//Clients
+static tcpClient_t mClients[TCP_MAX_CLIENTS];					//Stream clients. mSock < 0 if the entry is free
+static uint8_t mClientCount = 0;								//Number of connected clients
+static SemaphoreHandle_t mClientMutex = NULL;					//Guards mClients against the stats and command readers
+static int mWakeFd = -1;										//eventfd signalled by the frame bus, wakes up select()
 
 //Configuration variables
+static int frameTos = TCP_FRAME_TOS;							//IP TOS byte of the frame sockets
 #ifdef CONFIG_MI_SER_MODE_TCP
 //TCP
 static int keepAlive = KEEPALIVE_EN;							//TCP keep alive value
@@ -52,23 +82,74 @@ static int keepIdle = KEEPALIVE_IDLE;							//TCP keep idle value
 static int keepInterval = KEEPALIVE_INTERVAL;					//TCP keep alive interval
 static int keepCount = KEEPALIVE_COUNT;							//TCP keep alive count
 #endif
-//IP Addresses
-struct sockaddr_storage dest_addr;								//Destination address
 #ifdef CONFIG_MI_SER_MODE_UDP
-struct sockaddr_storage source_addr; 							// Large enough for both IPv4 or IPv6
+//UDP
+EXT_RAM_BSS_ATTR static uint8_t 	mUdpDatagram[UDP_DATAGRAM_SIZE];	//Chunk being sent
+#if CONFIG_MI_UDP_MULTICAST
+static struct sockaddr_in mMcastAddr;							//Group every viewer listens to
+#endif
 #endif
-static TaskHandle_t tcpServerRecvTaskHandle = NULL;				//TCP receive task handler
+//IP Addresses
+struct sockaddr_storage dest_addr;								//Destination address
 //flags
-static bool isClientConnected = false;							//Indicates if a client is connected to the server
+static bool isClientConnected = false;							//Indicates if at least one client is connected to the server
 static bool isServerUp = false;									//Indicates if the server is running
 static bool isFirstRun = true;									//Indicates if it is the first time the server started up
+//Delta coding state, one reference and output buffer per client
+EXT_RAM_BSS_ATTR static uint16_t mRefFrame[TCP_MAX_CLIENTS][TCP_FRAME_PIXELS];	//Last frame sent to each client
+EXT_RAM_BSS_ATTR static uint8_t mEncBuff[TCP_MAX_CLIENTS][TCP_FRAME_PIXELS * 2];	//Encoded payload being sent
+MEM_HOT_ATTR static uint8_t mDeltaBuff[TCP_FRAME_PIXELS * 2];				//Delta stage output ahead of the LZ stage
+//Stream settings and shaping, requests by client address and images shared by clients of the same shape
+static const tcpStreamShape_t mFullFrame = { .mDecimation = 1, .mRateDiv = 1 };	//Unshaped stream
+static tcpStreamRequest_t mStreamReq[TCP_MAX_CLIENTS];						//SFMT, SCRC and SHAP requests, cleared when the last client leaves
+static tcpShapeCache_t mShapeCache[TCP_MAX_CLIENTS];							//One entry per distinct shape at most
+EXT_RAM_BSS_ATTR static uint16_t mShapeBuff[TCP_MAX_CLIENTS][TCP_IMAGE_PIXELS];	//Pooled image of each cache entry
+
+static void tcpServerLoadFrame(tcpClient_t* pClient, senxorFrame* pFrame);
+static const uint16_t* tcpServerShapeFrame(const tcpClient_t* pClient, const senxorFrame* pFrame);
+static size_t tcpServerPackFrame(const senxorFrame* pFrame, const uint16_t* pImage, const size_t pixels, const uint8_t encoding, uint8_t* pOut, const size_t outMax);
+static void tcpServerApplyRequest(const uint8_t idx);
+static int8_t tcpServerFindRequest(const char* pAddr);
+static int tcpServerUpdateRequest(const uint8_t entry);
+#if CONFIG_MI_LINK_ADAPT_EN
+static void tcpServerAdaptLinks(void);
+#endif
+static int8_t tcpServerShapeSlot(const uint8_t idx);
+static void tcpServerStartStream(void);
+static void tcpServerCloseClient(const uint8_t idx);
+#if CONFIG_MI_SER_MODE_TCP
+static void tcpServerServiceClient(const uint8_t idx);
+static void tcpServerAccept(void);
+static void tcpServerPollClient(const uint8_t idx);
+#endif
+#if CONFIG_MI_SER_MODE_UDP
+static void tcpServerServiceUdpClient(const uint8_t idx);
+static void tcpServerUdpReceive(void);
+static void tcpServerUdpJoin(const struct sockaddr_in* pFrom);
+static int8_t tcpServerUdpFind(const struct sockaddr_in* pPeer);
+static void tcpServerUdpExpire(void);
+#endif
 
 /*
  * ***********************************************************************
  * @brief       tcpServerTask
  * @param       None
  * @return      None
- * @details     Task for handling TCP request
+ * @details     Task for handling TCP request.
+ * 				A single select() loop owns the whole connection lifecycle:
+ * 				it wakes up on a new connection, on a client socket becoming
+ * 				readable or failing, on a blocked client becoming writable,
+ * 				and on mWakeFd when the frame bus has a new frame. A closed
+ * 				or reset connection, or one dropped by TCP keepalive, is
+ * 				seen by the next select() and closed at once, so capture
+ * 				stops within milliseconds of the last client leaving.
+ * 				Every client has its own frame mailbox that keeps the newest
+ * 				frame only. A client is served only when its socket can take
+ * 				more data, so a slow client drops its own frames while the
+ * 				others keep up.
+ * 				In UDP mode every viewer, or the multicast group, is a client
+ * 				and frames are sent as datagram chunks. Viewer hellos are
+ * 				read and silent viewers expired by the same loop.
  **************************************************************************/
 void tcpServerTask(void * pvParameters)
 {
@@ -76,70 +157,760 @@ void tcpServerTask(void * pvParameters)
 
 	ESP_LOGI(TCPTAG,TCP_INIT_INFO,xPortGetCoreID());
 	tcpServer_InitThermalBuff();
-	tcpServerStart();
 
-	// Create receive task - handles connection lifecycle (accept, disconnect detection)
-	ESP_LOGI(TCPTAG, "Creating tcpServerRecvTask...");
-	BaseType_t res = xTaskCreate(tcpServerRecvTask, "tcpRecvTask", 4096, NULL, 4, &tcpServerRecvTaskHandle);
-	ESP_LOGI(TCPTAG, "tcpRecvTask result: %s", res == pdPASS ? "Success" : "Fail");
+	mClientMutex = xSemaphoreCreateMutex();
+	for(uint8_t i = 0; i < TCP_MAX_CLIENTS; i++)
+	{
+		mClients[i].mSock = -1;
+		mClients[i].mFrameSub = FRAME_BUS_INVALID_ID;
+		mClients[i].mShapeSlot = -1;
+	}//End for
+
+	const esp_vfs_eventfd_config_t eventfdConfig = ESP_VFS_EVENTD_CONFIG_DEFAULT();
+	const esp_err_t err = esp_vfs_eventfd_register(&eventfdConfig);
+	if(err == ESP_OK || err == ESP_ERR_INVALID_STATE)							//Already registered by another component
+	{
+		mWakeFd = eventfd(0, 0);
+	}//End if
+	if(mWakeFd < 0)
+	{
+		ESP_LOGE(TCPTAG, TCP_ERR_WAKE_FD, errno, strerror(errno));
+	}//End if
 
-	uint16_t* senxorDataPtr = NULL;
+	tcpServerStart();
+	tcpServerRestart(0);
 
 	for(;;)
 	{
-		if(xQueueReceive(senxorFrameQueue, &senxorDataPtr, portMAX_DELAY) && isClientConnected)
+		fd_set readSet;
+		fd_set writeSet;
+		fd_set errSet;
+		FD_ZERO(&readSet);
+		FD_ZERO(&writeSet);
+		FD_ZERO(&errSet);
+		int maxSock = -1;
+		uint32_t waitMs = TCP_IDLE_WAIT_MS;
+
+		if(mWakeFd >= 0)
 		{
-			tcpServerSend((uint8_t*)senxorDataPtr, 80 * 64 * sizeof(uint16_t));  // 10240 bytes
-			isFirstRun = false;
+			FD_SET(mWakeFd, &readSet);
+			maxSock = mWakeFd;
 		}
-		vTaskDelay(1);
-	}
+		else
+		{
+			waitMs = TCP_SEND_POLL_MS;												//No wake up on frames, poll the mailboxes
+		}//End if-else
+		if(isServerUp && server_sock >= 0)
+		{
+			FD_SET(server_sock, &readSet);
+			maxSock = MAX(maxSock, server_sock);
+		}//End if
+
+		xSemaphoreTake(mClientMutex, portMAX_DELAY);
+		for(uint8_t i = 0; i < TCP_MAX_CLIENTS; i++)
+		{
+			if(mClients[i].mSock < 0)
+			{
+				continue;
+			}//End if
+#if CONFIG_MI_SER_MODE_TCP
+			FD_SET(mClients[i].mSock, &readSet);									//Closed by the peer
+			FD_SET(mClients[i].mSock, &errSet);										//Reset, or dropped by keepalive
+			if(mClients[i].mTxFrame != NULL)
+			{
+				FD_SET(mClients[i].mSock, &writeSet);								//Room for the rest of the frame
+			}//End if
+			maxSock = MAX(maxSock, mClients[i].mSock);
+#else
+			if(mClients[i].mTxFrame != NULL)
+			{
+				waitMs = (mClients[i].mBlockedSinceUs != 0) ? MIN(waitMs, portTICK_PERIOD_MS) : 0;	//Wait for lwIP to free its buffers
+			}//End if
+#endif
+		}//End for
+		xSemaphoreGive(mClientMutex);
+
+		struct timeval timeout = { .tv_sec = waitMs / 1000, .tv_usec = (waitMs % 1000) * 1000 };
+		const int ready = (maxSock < 0) ? 0 : select(maxSock + 1, &readSet, &writeSet, &errSet, &timeout);
+		if(ready < 0)
+		{
+			ESP_LOGE(TCPTAG, TCP_ERR_SELECT, errno, strerror(errno));
+			vTaskDelay(pdMS_TO_TICKS(100));
+			continue;
+		}
+		else if(maxSock < 0)
+		{
+			vTaskDelay(pdMS_TO_TICKS(waitMs));
+		}//End if-else
+
+		if(mWakeFd >= 0 && FD_ISSET(mWakeFd, &readSet))
+		{
+			uint64_t count;
+			read(mWakeFd, &count, sizeof(count));								//Clear the frame bus wake up
+		}//End if
+
+#if CONFIG_MI_SER_MODE_TCP
+		if(isServerUp && server_sock >= 0 && FD_ISSET(server_sock, &readSet))
+		{
+			tcpServerAccept();
+		}//End if
+#else
+		if(isServerUp && server_sock >= 0 && FD_ISSET(server_sock, &readSet))
+		{
+			tcpServerUdpReceive();
+		}//End if
+		tcpServerUdpExpire();
+#endif
+
+		xSemaphoreTake(mClientMutex, portMAX_DELAY);
+#if CONFIG_MI_LINK_ADAPT_EN
+		tcpServerAdaptLinks();
+#endif
+#if CONFIG_MI_SER_MODE_TCP
+		for(uint8_t i = 0; i < TCP_MAX_CLIENTS; i++)
+		{
+			if(mClients[i].mSock >= 0 && (FD_ISSET(mClients[i].mSock, &readSet) || FD_ISSET(mClients[i].mSock, &errSet)))
+			{
+				tcpServerPollClient(i);
+			}//End if
+		}//End for
+#endif
+
+		//Give idle clients the newest frame
+		for(uint8_t i = 0; i < TCP_MAX_CLIENTS; i++)
+		{
+			if(mClients[i].mSock >= 0 && mClients[i].mTxFrame == NULL)
+			{
+				tcpServerLoadFrame(&mClients[i], framePool_TryReceive(mClients[i].mFrameSub));
+			}//End if
+		}//End for
+
+		for(uint8_t i = 0; i < TCP_MAX_CLIENTS; i++)
+		{
+			if(mClients[i].mSock < 0 || mClients[i].mTxFrame == NULL)
+			{
+				continue;
+			}//End if
+#if CONFIG_MI_SER_MODE_TCP
+			if(mClients[i].mBlockedSinceUs != 0 && !FD_ISSET(mClients[i].mSock, &writeSet))
+			{
+				continue;															//Still blocked
+			}//End if
+			tcpServerServiceClient(i);
+#else
+			tcpServerServiceUdpClient(i);
+#endif
+		}//End for
+		xSemaphoreGive(mClientMutex);
+	}//End for
 
 }//End tcpServerTask
 
 /*
  * ***********************************************************************
- * @brief       tcpServerRecvTask
+ * @brief       tcpServerLoadFrame
+ * @param       pClient - Client to load
+ * 				pFrame - Frame to send next, NULL to leave the client idle
+ * @return      None
+ * @details     Prepare the client for sending a new frame. The stream format
+ * 				and encoding are latched here so a change never splits a
+ * 				frame. Delta frames are coded against the last frame sent to
+ * 				this client, so frames skipped by its mailbox do not matter.
+ * 				A keyframe is sent every TCP_KEYFRAME_INTERVAL frames and
+ * 				whenever the encoding changes. A frame that does not shrink
+ * 				is sent raw, which is a keyframe too.
+ * 				A lossy stream (UDP) always uses the v2 format and sends
+ * 				keyframes only, so a lost frame never breaks the next one.
+ * 				A client with a SHAP rate divisor releases the frames it
+ * 				skips and stays idle. In the v2 format a shaped client gets
+ * 				the pooled image of its window instead of the full frame.
+ * 				Bit packed frames are keyframes of the image only, with the
+ * 				header words the clients use.
+ **************************************************************************/
+static void tcpServerLoadFrame(tcpClient_t* pClient, senxorFrame* pFrame)
+{
+	pClient->mTxFrame = pFrame;
+	pClient->mTxOffset = 0;
+	pClient->mTxHeaderLen = 0;
+
+	if(pFrame == NULL)
+	{
+		return;
+	}//End if
+
+	if(pClient->mShape.mRateDiv > 1)
+	{
+		if(pClient->mNextSeq != 0 && (int32_t)(pFrame->mSeq - pClient->mNextSeq) < 0)
+		{
+			framePool_Release(pFrame);											//Not due yet
+			pClient->mTxFrame = NULL;
+			return;
+		}//End if
+		pClient->mNextSeq = pFrame->mSeq + pClient->mShape.mRateDiv;
+	}//End if
+	bootTimelineMark(BOOT_MARK_FIRST_SEND);
+
+	pClient->mTxPayload = (const uint8_t*)pFrame->mFrame;
+	pClient->mTxPayloadLen = sizeof(pFrame->mFrame);
+
+	if(pClient->mFormat != TCP_STREAM_V2 && !TCP_STREAM_LOSSY)
+	{
+		return;
+	}//End if
+
+	const uint8_t idx = (uint8_t)(pClient - mClients);
+	const bool isShaped = (pClient->mShapeSlot >= 0);
+	const uint16_t* pPixels = isShaped ? tcpServerShapeFrame(pClient, pFrame) : pFrame->mFrame;
+	const size_t pixels = isShaped ? (size_t)pClient->mShape.mOutWidth * pClient->mShape.mOutHeight : TCP_FRAME_PIXELS;
+	const size_t rawLen = pixels * sizeof(pPixels[0]);
+	const bool isCompressed = linkAdapt_GetMode(&pClient->mLink)->mCompress && (pClient->mEncoding == TCP_STREAM_ENC_RAW16 || pClient->mEncoding == TCP_STREAM_ENC_DELTA);
+	const uint8_t requested = isCompressed ? TCP_STREAM_ENC_DELTA_LZ : pClient->mEncoding;	//Link adaptation may trade CPU for bandwidth
+	const bool isDelta = (requested == TCP_STREAM_ENC_DELTA || requested == TCP_STREAM_ENC_DELTA_LZ);
+	uint8_t encoding = requested;
+	bool isKey = TCP_STREAM_LOSSY || !pClient->mRefValid || pClient->mRefEncoding != requested || pClient->mFramesSinceKey >= TCP_KEYFRAME_INTERVAL;
+	const uint16_t* pRef = isKey ? NULL : mRefFrame[idx];
+	size_t len = 0;
+
+	if(requested == TCP_STREAM_ENC_DELTA)
+	{
+		len = frameCodec_EncodeDelta(pPixels, pRef, pixels, mEncBuff[idx], rawLen);
+	}
+	else if(requested == TCP_STREAM_ENC_DELTA_LZ)
+	{
+		const size_t deltaLen = frameCodec_EncodeDelta(pPixels, pRef, pixels, mDeltaBuff, sizeof(mDeltaBuff));
+		if(deltaLen > 0)
+		{
+			len = frameCodec_CompressLZ(mDeltaBuff, deltaLen, mEncBuff[idx], rawLen);
+		}//End if
+	}
+	else if(requested != TCP_STREAM_ENC_RAW16)
+	{
+		const uint16_t* pImage = isShaped ? pPixels : &pFrame->mFrame[TCP_IMAGE_OFFSET];
+		len = tcpServerPackFrame(pFrame, pImage, isShaped ? pixels : TCP_IMAGE_PIXELS, requested, mEncBuff[idx], rawLen);
+		isKey = true;															//Packed frames stand alone
+	}//End if-else
+
+	if(requested != TCP_STREAM_ENC_RAW16)
+	{
+		if(len > 0)
+		{
+			pClient->mTxPayload = mEncBuff[idx];
+			pClient->mTxPayloadLen = (uint16_t)len;
+		}
+		else
+		{
+			encoding = TCP_STREAM_ENC_RAW16;									//No gain, send it raw
+			isKey = true;
+		}//End if-else
+
+		if(isDelta)
+		{
+			memcpy(mRefFrame[idx], pPixels, rawLen);
+			pClient->mFramesSinceKey = isKey ? 0 : (pClient->mFramesSinceKey + 1);
+		}//End if
+	}
+	else
+	{
+		isKey = true;
+	}//End if-else
+
+	if(isShaped && encoding == TCP_STREAM_ENC_RAW16)
+	{
+		memcpy(mEncBuff[idx], pPixels, rawLen);									//The shared image may be pooled again before this one is sent
+		pClient->mTxPayload = mEncBuff[idx];
+		pClient->mTxPayloadLen = (uint16_t)rawLen;
+	}//End if
+
+	pClient->mRefValid = isDelta;
+	pClient->mRefEncoding = requested;
+
+	const uint16_t blobLen = blobTrack_GetRecord(&pClient->mTxHeader.mBlobs);	//Last analysed frame, see its mSeq
+	const uint16_t headerLen = offsetof(tcpStreamHeader_t, mBlobs) + blobLen;
+
+	pClient->mTxHeader.mMagic = TCP_STREAM_MAGIC;
+	pClient->mTxHeader.mVersion = TCP_STREAM_V2;
+	pClient->mTxHeader.mEncoding = encoding;
+	pClient->mTxHeader.mHeaderLen = headerLen;
+	pClient->mTxHeader.mSeq = pFrame->mSeq;
+	pClient->mTxHeader.mTimestampUs = (uint64_t)pFrame->mTimestampUs;
+	pClient->mTxHeader.mPayloadLen = pClient->mTxPayloadLen;
+	pClient->mTxHeader.mFlags = (isKey ? TCP_STREAM_FLAG_KEYFRAME : 0) | TCP_STREAM_FLAG_STATS;
+	memset(pClient->mTxHeader.mReserved, 0, sizeof(pClient->mTxHeader.mReserved));
+	pClient->mTxHeader.mStats = pFrame->mStats;
+	pClient->mTxHeader.mPayloadCrc = 0;
+	pClient->mTxHeader.mShape = pClient->mShape;
+	pClient->mTxHeader.mUtcUs = 0;
+	const int64_t utcOffsetUs = Drv_WLAN_getUtcOffsetUs();
+	if(utcOffsetUs != 0)
+	{
+		pClient->mTxHeader.mUtcUs = (uint64_t)(pFrame->mTimestampUs + utcOffsetUs);	//Offset of the latest SNTP sync
+		pClient->mTxHeader.mFlags |= TCP_STREAM_FLAG_UTC;
+	}//End if
+	if(isShaped)
+	{
+		pClient->mTxHeader.mFlags |= TCP_STREAM_FLAG_SHAPED;
+	}//End if
+	if(blobLen > 0)
+	{
+		pClient->mTxHeader.mFlags |= TCP_STREAM_FLAG_BLOBS;
+	}//End if
+	if(pClient->mIntegrity == CRC_MODE_CRC32)
+	{
+		pClient->mTxHeader.mPayloadCrc = Drv_Crc_Crc32(0, pClient->mTxPayload, pClient->mTxPayloadLen);	//ROM table CRC, cheap next to the encoders
+		pClient->mTxHeader.mFlags |= TCP_STREAM_FLAG_CRC32;
+	}//End if
+	pClient->mTxHeaderLen = headerLen;
+}//End tcpServerLoadFrame
+
+/*
+ * ***********************************************************************
+ * @brief       tcpServerPackFrame
+ * @param       pFrame - Frame to send
+ * 				pImage - Image pixels of the frame, or its shaped image
+ * 				pixels - Number of image pixels
+ * 				encoding - TCP_STREAM_ENC_PACK12, _PACK14 or _PACK8
+ * 				pOut - Output buffer
+ * 				outMax - Size of the output buffer
+ * @return      Payload size, 0 if it does not fit in outMax
+ * @details     The first TCP_PACK_HEADER_WORDS header words, then the
+ * 				image packed by frameCodec_PackBits. The rest of the two
+ * 				header rows is not sent.
+ **************************************************************************/
+static size_t tcpServerPackFrame(const senxorFrame* pFrame, const uint16_t* pImage, const size_t pixels, const uint8_t encoding, uint8_t* pOut, const size_t outMax)
+{
+	const size_t headerLen = TCP_PACK_HEADER_WORDS * sizeof(pFrame->mFrame[0]);
+	const uint8_t bits = (encoding == TCP_STREAM_ENC_PACK12) ? 12 : ((encoding == TCP_STREAM_ENC_PACK14) ? 14 : 8);
+
+	if(outMax <= headerLen)
+	{
+		return 0;
+	}//End if
+
+	const size_t len = frameCodec_PackBits(pImage, pixels, bits, pOut + headerLen, outMax - headerLen);
+	if(len == 0)
+	{
+		return 0;
+	}//End if
+	memcpy(pOut, pFrame->mFrame, headerLen);
+	return headerLen + len;
+}//End tcpServerPackFrame
+
+/*
+ * ***********************************************************************
+ * @brief       tcpServerShapeFrame
+ * @param       pClient - Shaped client
+ * 				pFrame - Frame to shape
+ * @return      Pooled image of the client window
+ * @details     The image is pooled by the first client of a shape to load
+ * 				the frame, the others reuse it. Caller must hold mClientMutex.
+ **************************************************************************/
+static const uint16_t* tcpServerShapeFrame(const tcpClient_t* pClient, const senxorFrame* pFrame)
+{
+	const tcpStreamShape_t* pShape = &pClient->mShape;
+	tcpShapeCache_t* pCache = &mShapeCache[pClient->mShapeSlot];
+	uint16_t* pImage = mShapeBuff[pClient->mShapeSlot];
+
+	if(!pCache->mValid || pCache->mSeq != pFrame->mSeq)
+	{
+		frameCodec_PoolMax(&pFrame->mFrame[TCP_IMAGE_OFFSET], SENXOR_FRAME_WIDTH, pShape->mX, pShape->mY, pShape->mWidth, pShape->mHeight, pShape->mDecimation, pImage);
+		pCache->mSeq = pFrame->mSeq;
+		pCache->mValid = true;
+	}//End if
+	return pImage;
+}//End tcpServerShapeFrame
+
+/*
+ * ***********************************************************************
+ * @brief       tcpServerApplyRequest
+ * @param       idx - Client index
+ * @return      None
+ * @details     Give a client the format, integrity check and shape
+ * 				requested for its address, or the v1 full frame stream if
+ * 				there is none. The
+ * 				shape is reduced further by the level of its link
+ * 				adaptation. The next frame is a keyframe.
+ * 				Caller must hold mClientMutex.
+ **************************************************************************/
+static void tcpServerApplyRequest(const uint8_t idx)
+{
+	tcpClient_t* pClient = &mClients[idx];
+
+	pClient->mFormat = TCP_STREAM_V1;
+	pClient->mEncoding = TCP_STREAM_ENC_RAW16;
+	pClient->mIntegrity = CRC_MODE_SUM16;
+	pClient->mShape = mFullFrame;
+	for(uint8_t i = 0; i < TCP_MAX_CLIENTS; i++)
+	{
+		if(mStreamReq[i].mAddr[0] != '\0' && !strcmp(mStreamReq[i].mAddr, pClient->mAddr))
+		{
+			pClient->mFormat = mStreamReq[i].mFormat;
+			pClient->mEncoding = mStreamReq[i].mEncoding;
+			pClient->mIntegrity = mStreamReq[i].mIntegrity;
+			pClient->mShape = mStreamReq[i].mShape;
+			break;
+		}//End if
+	}//End for
+
+	// Link adaptation only ever lowers the rate and resolution requested
+	const linkMode_t* pMode = linkAdapt_GetMode(&pClient->mLink);
+	pClient->mShape.mRateDiv = MIN(pClient->mShape.mRateDiv * pMode->mRateDiv, TCP_SHAPE_MAX_RATE_DIV);
+	if(pMode->mDecimation > pClient->mShape.mDecimation)
+	{
+		if(pClient->mShape.mWidth == 0)
+		{
+			pClient->mShape.mWidth = SENXOR_FRAME_WIDTH;
+			pClient->mShape.mHeight = SENXOR_FRAME_HEIGHT;
+		}//End if
+		pClient->mShape.mDecimation = pMode->mDecimation;
+		pClient->mShape.mOutWidth = (pClient->mShape.mWidth + pClient->mShape.mDecimation - 1) / pClient->mShape.mDecimation;
+		pClient->mShape.mOutHeight = (pClient->mShape.mHeight + pClient->mShape.mDecimation - 1) / pClient->mShape.mDecimation;
+	}//End if
+
+	pClient->mShapeSlot = (pClient->mShape.mWidth != 0) ? tcpServerShapeSlot(idx) : -1;
+	pClient->mNextSeq = 0;
+	pClient->mRefValid = false;
+}//End tcpServerApplyRequest
+
+/*
+ * ***********************************************************************
+ * @brief       tcpServerFindRequest
+ * @param       pAddr - Client address
+ * @return      Request entry of the address, a new one if it has none,
+ * 				-1 if every entry is taken
+ * @details     A new entry asks for the v1 full frame stream.
+ * 				Caller must hold mClientMutex.
+ **************************************************************************/
+static int8_t tcpServerFindRequest(const char* pAddr)
+{
+	int8_t entry = -1;
+
+	for(uint8_t i = 0; i < TCP_MAX_CLIENTS; i++)
+	{
+		if(!strcmp(mStreamReq[i].mAddr, pAddr))
+		{
+			return i;
+		}
+		else if(entry < 0 && mStreamReq[i].mAddr[0] == '\0')
+		{
+			entry = i;
+		}//End if-else
+	}//End for
+
+	if(entry >= 0)
+	{
+		strlcpy(mStreamReq[entry].mAddr, pAddr, sizeof(mStreamReq[entry].mAddr));
+		mStreamReq[entry].mFormat = TCP_STREAM_V1;
+		mStreamReq[entry].mEncoding = TCP_STREAM_ENC_RAW16;
+		mStreamReq[entry].mIntegrity = CRC_MODE_SUM16;
+		mStreamReq[entry].mShape = mFullFrame;
+	}//End if
+	return entry;
+}//End tcpServerFindRequest
+
+/*
+ * ***********************************************************************
+ * @brief       tcpServerUpdateRequest
+ * @param       entry - Request entry just changed
+ * @return      Number of stream clients connected from its address
+ * @details     Apply the request to the clients of its address. An entry
+ * 				back to the v1 full frame stream is freed.
+ * 				Caller must hold mClientMutex.
+ **************************************************************************/
+static int tcpServerUpdateRequest(const uint8_t entry)
+{
+	tcpStreamRequest_t* pReq = &mStreamReq[entry];
+	char addr[sizeof(pReq->mAddr)];
+	int count = 0;
+
+	strlcpy(addr, pReq->mAddr, sizeof(addr));
+	if(pReq->mFormat == TCP_STREAM_V1 && pReq->mIntegrity == CRC_MODE_SUM16 && pReq->mShape.mWidth == 0 && pReq->mShape.mRateDiv == 1)
+	{
+		memset(pReq, 0, sizeof(*pReq));											//Nothing requested
+	}//End if
+
+	for(uint8_t i = 0; i < TCP_MAX_CLIENTS; i++)
+	{
+		if(mClients[i].mSock >= 0 && !strcmp(mClients[i].mAddr, addr))
+		{
+			tcpServerApplyRequest(i);
+			++count;
+		}//End if
+	}//End for
+	return count;
+}//End tcpServerUpdateRequest
+
+#if CONFIG_MI_LINK_ADAPT_EN
+/*
+ * ***********************************************************************
+ * @brief       tcpServerAdaptLinks
  * @param       None
  * @return      None
- * @details     Wait for client connect
+ * @details     Feed every client's send backlog and the Wi-Fi signal to its
+ * 				link adaptation, and reshape the clients whose level changed.
+ * 				The signal is read once a period. Caller must hold
+ * 				mClientMutex.
  **************************************************************************/
-void tcpServerRecvTask(void* pvParameters)
+static void tcpServerAdaptLinks(void)
 {
-	ESP_LOGI(TCPTAG, ">>>> tcpServerRecvTask started (disconnect detection only)");
+	static int64_t rssiAtUs = 0;
+	static int8_t rssi = LINK_RSSI_NONE;
+	const int64_t now = esp_timer_get_time();
 
-	// This task owns the connection lifecycle - do initial accept
-	tcpServerRestart(0);
+	if(now - rssiAtUs >= (int64_t)LINK_ADAPT_PERIOD_MS * 1000)
+	{
+		rssi = linkAdapt_GetRssi();
+		rssiAtUs = now;
+	}//End if
 
-	for(;;)
+	for(uint8_t i = 0; i < TCP_MAX_CLIENTS; i++)
 	{
-		// If not connected, wait for new connection
-		if (!isClientConnected)
+		tcpClient_t* pClient = &mClients[i];
+		if(pClient->mSock < 0)
 		{
-			ESP_LOGI(TCPTAG, "Waiting for frame client connection...");
-			tcpServerRestart(0);
 			continue;
-		}
+		}//End if
+
+		const uint64_t blockedUs = pClient->mBlockedUs + ((pClient->mBlockedSinceUs != 0) ? (uint64_t)(now - pClient->mBlockedSinceUs) : 0);
+		const int64_t pendingUs = (pClient->mTxFrame != NULL) ? now - pClient->mTxFrame->mTimestampUs : 0;
+		if(linkAdapt_Update(&pClient->mLink, blockedUs, pendingUs, rssi, pClient->mAddr))
+		{
+			tcpServerApplyRequest(i);
+		}//End if
+	}//End for
+}//End tcpServerAdaptLinks
+#endif
+
+/*
+ * ***********************************************************************
+ * @brief       tcpServerShapeSlot
+ * @param       idx - Client index, mShape already set
+ * @return      Shape cache entry of the client
+ * @details     Share the entry of another client with the same window and
+ * 				decimation, the rate divisor does not change the image.
+ * 				Otherwise take an entry no client uses. There are as many
+ * 				entries as clients, so one is always free.
+ * 				Caller must hold mClientMutex.
+ **************************************************************************/
+static int8_t tcpServerShapeSlot(const uint8_t idx)
+{
+	const size_t shapeLen = offsetof(tcpStreamShape_t, mRateDiv);				//Window and decimation
+
+	for(uint8_t i = 0; i < TCP_MAX_CLIENTS; i++)
+	{
+		if(i != idx && mClients[i].mSock >= 0 && mClients[i].mShapeSlot >= 0 &&
+		   memcmp(&mClients[i].mShape, &mClients[idx].mShape, shapeLen) == 0)
+		{
+			return mClients[i].mShapeSlot;
+		}//End if
+	}//End for
+
+	for(int8_t slot = 0; slot < TCP_MAX_CLIENTS; slot++)
+	{
+		bool isUsed = false;
+		for(uint8_t i = 0; i < TCP_MAX_CLIENTS; i++)
+		{
+			isUsed |= (i != idx && mClients[i].mSock >= 0 && mClients[i].mShapeSlot == slot);
+		}//End for
+		if(!isUsed)
+		{
+			mShapeCache[slot].mValid = false;
+			return slot;
+		}//End if
+	}//End for
+	return -1;
+}//End tcpServerShapeSlot
 
-		// Just detect disconnect - commands are handled by cmdServerTask on port 3334
-		// Use non-blocking read to check if socket is still alive
-		int len = recv(connect_sock, mRxBuff, sizeof(mRxBuff), MSG_DONTWAIT);
-		if (len == 0) {
-			// Client closed connection gracefully
-			ESP_LOGW(TCPTAG, "Frame client disconnected");
-			isClientConnected = false;
-			Acces_Write_Reg(0xB1, 0x00);  // Stop streaming
-		} else if (len < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
-			// Error (not just "would block")
-			ESP_LOGW(TCPTAG, "Frame client connection error: %d", errno);
-			isClientConnected = false;
-			Acces_Write_Reg(0xB1, 0x00);  // Stop streaming
+#if CONFIG_MI_SER_MODE_TCP
+/*
+ * ***********************************************************************
+ * @brief       tcpServerServiceClient
+ * @param       idx - Client index
+ * @return      None
+ * @details     Send state machine of one client.
+ * 				Writes as much of the pending header and frame as the socket
+ * 				takes and resumes from the same offset on the next writable
+ * 				event. Once a frame is complete the newest frame in the
+ * 				mailbox is picked up, older frames have already been dropped
+ * 				by the latest-only mailbox. Caller must hold mClientMutex.
+ **************************************************************************/
+static void tcpServerServiceClient(const uint8_t idx)
+{
+	tcpClient_t* pClient = &mClients[idx];
+
+	while(pClient->mSock >= 0 && pClient->mTxFrame != NULL)
+	{
+		const size_t headerLen = pClient->mTxHeaderLen;
+		const size_t totalLen = headerLen + pClient->mTxPayloadLen;
+		const uint8_t* pData;
+		size_t len;
+
+		if(pClient->mTxOffset < headerLen)
+		{
+			pData = (const uint8_t*)&pClient->mTxHeader + pClient->mTxOffset;
+			len = headerLen - pClient->mTxOffset;
 		}
-		// If len > 0, client sent data - ignore it (commands should go to port 3334)
+		else
+		{
+			pData = pClient->mTxPayload + (pClient->mTxOffset - headerLen);
+			len = totalLen - pClient->mTxOffset;
+		}//End if-else
+
+		const int sent = tcpServerSend(idx, pData, len);
+
+		if(sent < 0)
+		{
+			return;																//Client closed by tcpServerSend
+		}//End if
+
+		const int64_t now = esp_timer_get_time();
+		if(sent == 0)
+		{
+			if(pClient->mBlockedSinceUs == 0)
+			{
+				pClient->mBlockedSinceUs = now;									//Send buffer full, wait for writable
+			}//End if
+			return;
+		}//End if
+
+		if(pClient->mBlockedSinceUs != 0)
+		{
+			pClient->mBlockedUs += (uint64_t)(now - pClient->mBlockedSinceUs);
+			pClient->mBlockedSinceUs = 0;
+		}//End if
+
+		pClient->mTxOffset += sent;
+		pClient->mBytesSent += sent;
+
+		if(pClient->mTxOffset >= totalLen)
+		{
+			LATENCY_TRACE(LAT_STAGE_NET_SEND, pClient->mTxFrame->mSeq);
+			linkAdapt_FrameSent(&pClient->mLink, esp_timer_get_time() - pClient->mTxFrame->mTimestampUs);
+			framePool_Release(pClient->mTxFrame);								//Return frame to pool
+			++pClient->mFramesSent;
+			isFirstRun = false;
+			tcpServerLoadFrame(pClient, framePool_TryReceive(pClient->mFrameSub));	//Continue with the newest frame, if any
+		}//End if
+	}//End while
+}//End tcpServerServiceClient
+#endif
+
+#if CONFIG_MI_SER_MODE_UDP
+/*
+ * ***********************************************************************
+ * @brief       tcpServerServiceUdpClient
+ * @param       idx - Client index
+ * @return      None
+ * @details     Send state machine of one UDP viewer.
+ * 				The header and frame are split into udpChunkHeader_t
+ * 				datagrams of at most UDP_DATAGRAM_SIZE bytes. A frame the
+ * 				stack cannot take within UDP_CHUNK_STALL_MS is abandoned,
+ * 				the viewer drops the incomplete frame and gets the newest
+ * 				one instead. Caller must hold mClientMutex.
+ **************************************************************************/
+static void tcpServerServiceUdpClient(const uint8_t idx)
+{
+	tcpClient_t* pClient = &mClients[idx];
+	udpChunkHeader_t* pChunk = (udpChunkHeader_t*)mUdpDatagram;
+
+	while(pClient->mSock >= 0 && pClient->mTxFrame != NULL)
+	{
+		const size_t headerLen = pClient->mTxHeaderLen;
+		const size_t totalLen = headerLen + pClient->mTxPayloadLen;
+		size_t pos = pClient->mTxOffset;
+		const size_t len = MIN(UDP_CHUNK_DATA, totalLen - pos);
+		uint8_t* pOut = mUdpDatagram + sizeof(udpChunkHeader_t);
+		size_t remain = len;
+
+		pChunk->mMagic = UDP_CHUNK_MAGIC;
+		pChunk->mFrameId = pClient->mTxHeader.mSeq;
+		pChunk->mChunkIdx = (uint16_t)(pos / UDP_CHUNK_DATA);
+		pChunk->mChunkCount = (uint16_t)((totalLen + UDP_CHUNK_DATA - 1) / UDP_CHUNK_DATA);
+		pChunk->mFrameLen = (uint32_t)totalLen;
+
+		if(pos < headerLen)
+		{
+			const size_t part = MIN(remain, headerLen - pos);
+			memcpy(pOut, (const uint8_t*)&pClient->mTxHeader + pos, part);
+			pOut += part;
+			pos += part;
+			remain -= part;
+		}//End if
+		memcpy(pOut, pClient->mTxPayload + (pos - headerLen), remain);
+
+		const int sent = tcpServerSend(idx, mUdpDatagram, sizeof(udpChunkHeader_t) + len);
+		const int64_t now = esp_timer_get_time();
+
+		if(sent == 0)
+		{
+			if(pClient->mBlockedSinceUs == 0)
+			{
+				pClient->mBlockedSinceUs = now;									//No buffer in the stack, retry shortly
+			}
+			else if((now - pClient->mBlockedSinceUs) >= (int64_t)UDP_CHUNK_STALL_MS * 1000)
+			{
+				pClient->mBlockedUs += (uint64_t)(now - pClient->mBlockedSinceUs);
+				pClient->mBlockedSinceUs = 0;
+				framePool_Release(pClient->mTxFrame);							//Latency over completeness
+				tcpServerLoadFrame(pClient, framePool_TryReceive(pClient->mFrameSub));
+			}//End if-else
+			return;
+		}//End if
+
+		if(pClient->mBlockedSinceUs != 0)
+		{
+			pClient->mBlockedUs += (uint64_t)(now - pClient->mBlockedSinceUs);
+			pClient->mBlockedSinceUs = 0;
+		}//End if
+
+		if(sent < 0)
+		{
+			framePool_Release(pClient->mTxFrame);								//Viewer unreachable, skip this frame
+			tcpServerLoadFrame(pClient, NULL);
+			return;
+		}//End if
+
+		pClient->mTxOffset += len;
+		pClient->mBytesSent += sent;
 
-		vTaskDelay(pdMS_TO_TICKS(100));  // Check every 100ms
+		if(pClient->mTxOffset >= totalLen)
+		{
+			LATENCY_TRACE(LAT_STAGE_NET_SEND, pClient->mTxFrame->mSeq);
+			linkAdapt_FrameSent(&pClient->mLink, esp_timer_get_time() - pClient->mTxFrame->mTimestampUs);
+			framePool_Release(pClient->mTxFrame);								//Return frame to pool
+			++pClient->mFramesSent;
+			isFirstRun = false;
+			tcpServerLoadFrame(pClient, framePool_TryReceive(pClient->mFrameSub));	//Continue with the newest frame, if any
+		}//End if
+	}//End while
+}//End tcpServerServiceUdpClient
+#endif
+
+#if CONFIG_MI_SER_MODE_TCP
+/*
+ * ***********************************************************************
+ * @brief       tcpServerPollClient
+ * @param       idx - Client index
+ * @return      None
+ * @details     Handle a readable or failed client socket. Stream clients
+ * 				do not send anything, commands go to cmdServerTask, so
+ * 				this is an orderly close, a reset or a keepalive timeout.
+ * 				Stray data is read and ignored. Caller must hold mClientMutex.
+ **************************************************************************/
+static void tcpServerPollClient(const uint8_t idx)
+{
+	const int len = recv(mClients[idx].mSock, mRxBuff, sizeof(mRxBuff), MSG_DONTWAIT);
+	if(len == 0)
+	{
+		ESP_LOGW(TCPTAG, TCP_CLIENT_LEFT, mClients[idx].mAddr);				//Closed by the client
+		tcpServerCloseClient(idx);
 	}
-}//End tcpServerRecvTask
+	else if(len < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+	{
+		ESP_LOGW(TCPTAG, TCP_WARN_CLIENT_ERR, mClients[idx].mAddr, errno, strerror(errno));
+		tcpServerCloseClient(idx);
+	}//End if-else
+}//End tcpServerPollClient
+#endif
 
 /*
  * ***********************************************************************
@@ -177,9 +948,12 @@ void tcpServerStart(void)
 	{
 		//If the socket cannot be created, TCP server will shutdown immediately
 		ESP_LOGE(TCPTAG, TCP_ERR_CREATE,errno,strerror(errno));
-		tcpServerShutdown();														//Shutdown server and delete TCP Server task
+		tcpServerShutdown();														//Shutdown server
 	}
 
+	int opt = 1;
+	setsockopt(server_sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));		//Allow quick rebind after a restart
+
 	/*
 	 *  Phrase 2 - Socket binding
 	 */
@@ -187,7 +961,7 @@ void tcpServerStart(void)
 	{
 		//If the socket cannot be binded, server will shutdown immediately
 		ESP_LOGE(TCPTAG, TCP_ERR_BLIND, errno,strerror(errno));
-		tcpServerShutdown();														//Shutdown server and delete TCP Server task
+		tcpServerShutdown();														//Shutdown server
 	}
 
 	ESP_LOGI(TCPTAG, TCP_BIND, PORT);
@@ -208,17 +982,17 @@ void tcpServerStart(void)
  * ***********************************************************************
  * @brief       tcpServerRestart
  * @param       isFullRestart -
- * 				0: Listen and wait for connection again without a full restart
+ * 				0: Drop all clients and listen for connections again
+ * 				   without a full restart
  * 				1: Perform a full restart of the server. This will reset all the
  * 				flags and close
  * @return      None
- * @details     Restart TCP server
- * 				This function wait until a client is connected.
+ * @details     Restart TCP server.
+ * 				This function does not wait for a client, connections are
+ * 				accepted by the tcpServerTask loop.
  **************************************************************************/
 void tcpServerRestart(const bool isFullRestart)
 {
-	char addr_str[128];
-	isClientConnected = false;														//Clear client connected flag
 	isServerUp = false;																//Clear server on flag
 
 	/* If a full restart is required.
@@ -234,68 +1008,34 @@ void tcpServerRestart(const bool isFullRestart)
 		return;
 	}
 
+	xSemaphoreTake(mClientMutex, portMAX_DELAY);
+	for(uint8_t i = 0; i < TCP_MAX_CLIENTS; i++)
+	{
+		if(mClients[i].mSock >= 0)
+		{
+			ESP_LOGW(TCPTAG,TCP_WARN_SOCK_EXIST);
+			ESP_LOGI(TCPTAG,TCP_SOCK_CLE TCP_SOCK_INFO, mClients[i].mSock);
+			tcpServerCloseClient(i);
+		}//End if
+	}//End for
+	xSemaphoreGive(mClientMutex);
+
 #if CONFIG_MI_SER_MODE_TCP
-	int status = listen(server_sock, 1);
 	/*
 	 * Phrase 3 - Enable server to listen a socket
 	 */
+	int status = listen(server_sock, TCP_MAX_CLIENTS);
 	if (status != 0)
 	{
 		//If the socket cannot be listened, TCP server will shutdown immediately
 		ESP_LOGE(TCPTAG, TCP_ERR_LISTEN, server_sock,errno,strerror(errno));
-		tcpServerShutdown();														//Shutdown server													//Delete TCP Server task
+		tcpServerShutdown();														//Shutdown server
 	}
 
 	ESP_LOGI(TCPTAG, TCP_LIS_INFO,PORT);
 #if CONFIG_MI_LED_EN
 	ledCtrlSingleSet(YELLOW_LED,LED_ON,500);
 #endif
-	struct sockaddr_storage source_addr; 											//Large enough for both IPv4 or IPv6
-	socklen_t addr_len = sizeof(source_addr);										//Length of address
-
-	/*
-	 * Phrase 4 - Wait until a client connects
-	 * Wait for connection. THIS IS A BLOCKING OPERATION.
-	 * Once a client connects, it will unblock once a client is connected.
-	 */
-	if(connect_sock !=0 )
-	{
-		ESP_LOGW(TCPTAG,TCP_WARN_SOCK_EXIST);
-		ESP_LOGI(TCPTAG,TCP_SOCK_CLE TCP_SOCK_INFO, connect_sock);
-		close(connect_sock);
-	}//End if
-	connect_sock = accept(server_sock, (struct sockaddr *)&source_addr, &addr_len);
-
-	if (connect_sock >= 0) {
-		// Mark client connected
-		isClientConnected = true;
-		
-		// Start thermal streaming
-		Acces_Write_Reg(0xB1, 0x03);  // <-- this triggers the sensor to start pushing frames
-		ESP_LOGI(TCPTAG, "Client connected, stream started automatically.");
-	}else if (connect_sock < 0)
-	{
-		//If there is an error while accepting a connection, TCP server will close the socket
-
-		ESP_LOGI(TCPTAG, "Client Disconnected");
-		ESP_LOGE(TCPTAG, TCP_ERR_ACCEPT, errno,strerror(errno));
-		close(connect_sock);
-
-		isClientConnected = false;
-	}
-
-	// Set tcp keepalive option
-	setsockopt(connect_sock, SOL_SOCKET, SO_KEEPALIVE, &keepAlive, sizeof(int));		//Configuring TCP keep alive value
-	setsockopt(connect_sock, IPPROTO_TCP, TCP_KEEPIDLE, &keepIdle, sizeof(int));		//Configuring TCP keep alive idle value
-	setsockopt(connect_sock, IPPROTO_TCP, TCP_KEEPINTVL, &keepInterval, sizeof(int));	//Configuring TCP keep alive interval
-	setsockopt(connect_sock, IPPROTO_TCP, TCP_KEEPCNT, &keepCount, sizeof(int));		//Configuring TCP keep alive count
-
-	// Convert IP address to string
-	if (source_addr.ss_family == PF_INET)
-	{
-		inet_ntoa_r(((struct sockaddr_in *)&source_addr)->sin_addr, addr_str, sizeof(addr_str) - 1);
-	}//End if
-
 #endif
 
 	/*
@@ -303,7 +1043,7 @@ void tcpServerRestart(const bool isFullRestart)
 	 */
 #if CONFIG_MI_SER_MODE_UDP
 
-	if(server_sock < 1)
+	if(server_sock > 0)
 	{
 		close(server_sock);
 	}//End if
@@ -313,10 +1053,11 @@ void tcpServerRestart(const bool isFullRestart)
 	{
 		//If the socket cannot be created, TCP server will shutdown immediately
 		ESP_LOGE(TCPTAG, TCP_ERR_CREATE,errno,strerror(errno));
-		tcpServerShutdown();														//Shutdown server and delete TCP Server task
+		tcpServerShutdown();														//Shutdown server
 	}//End if
+	setsockopt(server_sock, IPPROTO_IP, IP_TOS, &frameTos, sizeof(int));			//WMM access category of the frames
 
-    int status = bind(server_sock, (struct sockaddr *)&dest_addr, sizeof(dest_addr));
+    int status = bind(server_sock, (struct sockaddr *)&dest_addr, sizeof(dest_addr));		//Viewers send their hello to this port
     if (status < 0)
     {
     	ESP_LOGE(TCPTAG, TCP_ERR_ACCEPT, errno,strerror(errno));
@@ -327,64 +1068,411 @@ void tcpServerRestart(const bool isFullRestart)
     	ESP_LOGI(TCPTAG, "Socket bound, port %d", PORT);
     }//End if-else
 
+	// Sends never block, a full stack is retried by tcpServerServiceUdpClient
+	fcntl(server_sock, F_SETFL, fcntl(server_sock, F_GETFL, 0) | O_NONBLOCK);
+
+#if CONFIG_MI_UDP_MULTICAST
+	const uint8_t ttl = UDP_MCAST_TTL;
+	setsockopt(server_sock, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+	memset(&mMcastAddr, 0, sizeof(mMcastAddr));
+	mMcastAddr.sin_family = AF_INET;
+	mMcastAddr.sin_port = htons(PORT);
+	inet_aton(UDP_MCAST_ADDR, &mMcastAddr.sin_addr);
+	ESP_LOGI(TCPTAG, TCP_UDP_MCAST, UDP_MCAST_ADDR, PORT);
 #endif
-	ESP_LOGI(TCPTAG, TCP_ACCPET, addr_str);
-	isServerUp = true;
+
 #if CONFIG_MI_LED_EN
 	ledCtrlSingleSet(GREEN_LED,LED_ON,0);
 #endif
+#endif
+	isServerUp = true;
 }//End tcpServerRestart
 
+#if CONFIG_MI_SER_MODE_TCP
+/*
+ * ***********************************************************************
+ * @brief       tcpServerAccept
+ * @param       None
+ * @return      None
+ * @details     Accept a pending connection and give it a free client
+ * 				entry. The connection is closed if the server is full.
+ * 				Capture is started when the first client connects.
+ **************************************************************************/
+static void tcpServerAccept(void)
+{
+	struct sockaddr_storage source_addr; 											//Large enough for both IPv4 or IPv6
+	socklen_t addr_len = sizeof(source_addr);										//Length of address
+	char addr_str[16] = "?";
+
+	/*
+	 * Phrase 4 - Accept the client
+	 * The listening socket is readable, so this does not block.
+	 */
+	int sock = accept(server_sock, (struct sockaddr *)&source_addr, &addr_len);
+	if (sock < 0)
+	{
+		ESP_LOGE(TCPTAG, TCP_ERR_ACCEPT, errno,strerror(errno));
+		return;
+	}//End if
+
+	// Convert IP address to string
+	if (source_addr.ss_family == PF_INET)
+	{
+		inet_ntoa_r(((struct sockaddr_in *)&source_addr)->sin_addr, addr_str, sizeof(addr_str) - 1);
+	}//End if
+
+	xSemaphoreTake(mClientMutex, portMAX_DELAY);
+
+	int8_t idx = -1;
+	for(uint8_t i = 0; i < TCP_MAX_CLIENTS; i++)
+	{
+		if(mClients[i].mSock < 0)
+		{
+			idx = i;
+			break;
+		}//End if
+	}//End for
+
+	frameSubscriber_t sub = FRAME_BUS_INVALID_ID;
+	if(idx >= 0)
+	{
+		sub = framePool_Subscribe("tcp", 1, FRAME_POLICY_LATEST_ONLY, NULL);
+		framePool_SetWakeFd(sub, mWakeFd);
+	}//End if
+
+	if(idx < 0 || sub == FRAME_BUS_INVALID_ID)
+	{
+		xSemaphoreGive(mClientMutex);
+		ESP_LOGW(TCPTAG, TCP_WARN_FULL, addr_str, TCP_MAX_CLIENTS);
+		close(sock);
+		return;
+	}//End if
+
+	// Set tcp keepalive option
+	setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, &keepAlive, sizeof(int));			//Configuring TCP keep alive value
+	setsockopt(sock, IPPROTO_TCP, TCP_KEEPIDLE, &keepIdle, sizeof(int));			//Configuring TCP keep alive idle value
+	setsockopt(sock, IPPROTO_TCP, TCP_KEEPINTVL, &keepInterval, sizeof(int));		//Configuring TCP keep alive interval
+	setsockopt(sock, IPPROTO_TCP, TCP_KEEPCNT, &keepCount, sizeof(int));			//Configuring TCP keep alive count
+	setsockopt(sock, IPPROTO_IP, IP_TOS, &frameTos, sizeof(int));					//WMM access category of the frames
+
+	// Writes never block, partial writes are resumed by tcpServerServiceClient
+	fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+
+	mClients[idx].mSock = sock;
+	mClients[idx].mFrameSub = sub;
+	tcpServerLoadFrame(&mClients[idx], NULL);
+	mClients[idx].mRefValid = false;
+	mClients[idx].mFramesSinceKey = 0;
+	mClients[idx].mFramesSent = 0;
+	mClients[idx].mBytesSent = 0;
+	mClients[idx].mBlockedUs = 0;
+	mClients[idx].mBlockedSinceUs = 0;
+	strlcpy(mClients[idx].mAddr, addr_str, sizeof(mClients[idx].mAddr));
+	linkAdapt_Reset(&mClients[idx].mLink, 0);
+	tcpServerApplyRequest(idx);
+	++mClientCount;
+	tcpServerStartStream();
+
+	xSemaphoreGive(mClientMutex);
+
+	ESP_LOGI(TCPTAG, TCP_ACCPET, addr_str);
+	ESP_LOGI(TCPTAG, TCP_CLIENT_INFO, mClientCount, TCP_MAX_CLIENTS);
+}//End tcpServerAccept
+#endif
+
+#if CONFIG_MI_SER_MODE_UDP
+/*
+ * ***********************************************************************
+ * @brief       tcpServerUdpReceive
+ * @param       None
+ * @return      None
+ * @details     Read one viewer datagram. UDP_HELLO_MAGIC joins or keeps
+ * 				the viewer alive, UDP_BYE_MAGIC removes it. Anything else
+ * 				is ignored. With multicast a goodbye is left to the
+ * 				timeout, other viewers may still be watching the group.
+ **************************************************************************/
+static void tcpServerUdpReceive(void)
+{
+	struct sockaddr_in from;
+	socklen_t fromLen = sizeof(from);
+	uint32_t magic = 0;
+
+	const int len = recvfrom(server_sock, mRxBuff, sizeof(mRxBuff), MSG_DONTWAIT, (struct sockaddr *)&from, &fromLen);
+	if(len < (int)sizeof(magic) || from.sin_family != AF_INET)
+	{
+		return;
+	}//End if
+	memcpy(&magic, mRxBuff, sizeof(magic));
+
+	xSemaphoreTake(mClientMutex, portMAX_DELAY);
+	if(magic == UDP_HELLO_MAGIC)
+	{
+		tcpServerUdpJoin(&from);
+	}//End if
+#if !CONFIG_MI_UDP_MULTICAST
+	if(magic == UDP_BYE_MAGIC)
+	{
+		const int8_t idx = tcpServerUdpFind(&from);
+		if(idx >= 0)
+		{
+			ESP_LOGI(TCPTAG, TCP_UDP_VIEWER_LEFT, mClients[idx].mAddr, ntohs(mClients[idx].mPeer.sin_port));
+			tcpServerCloseClient(idx);
+		}//End if
+	}//End if
+#endif
+	xSemaphoreGive(mClientMutex);
+}//End tcpServerUdpReceive
+
+/*
+ * ***********************************************************************
+ * @brief       tcpServerUdpJoin
+ * @param       pFrom - Address the hello came from
+ * @return      None
+ * @details     Refresh a known viewer or give a new one a free client
+ * 				entry. With multicast all viewers share the entry of the
+ * 				group, so frames are sent once whatever the number of
+ * 				viewers. Caller must hold mClientMutex.
+ **************************************************************************/
+static void tcpServerUdpJoin(const struct sockaddr_in* pFrom)
+{
+#if CONFIG_MI_UDP_MULTICAST
+	const struct sockaddr_in* pPeer = &mMcastAddr;
+#else
+	const struct sockaddr_in* pPeer = pFrom;
+#endif
+	char addr_str[16] = "?";
+	int8_t idx = tcpServerUdpFind(pPeer);
+
+	if(idx >= 0)
+	{
+		mClients[idx].mLastSeenUs = esp_timer_get_time();
+		return;
+	}//End if
+
+	inet_ntoa_r(pFrom->sin_addr, addr_str, sizeof(addr_str) - 1);
+	for(uint8_t i = 0; i < TCP_MAX_CLIENTS; i++)
+	{
+		if(mClients[i].mSock < 0)
+		{
+			idx = i;
+			break;
+		}//End if
+	}//End for
+
+	frameSubscriber_t sub = FRAME_BUS_INVALID_ID;
+	if(idx >= 0)
+	{
+		sub = framePool_Subscribe("udp", 1, FRAME_POLICY_LATEST_ONLY, NULL);
+		framePool_SetWakeFd(sub, mWakeFd);
+	}//End if
+
+	if(idx < 0 || sub == FRAME_BUS_INVALID_ID)
+	{
+		ESP_LOGW(TCPTAG, TCP_WARN_FULL, addr_str, TCP_MAX_CLIENTS);
+		return;
+	}//End if
+
+	mClients[idx].mSock = server_sock;										//Shared by every viewer
+	mClients[idx].mFrameSub = sub;
+	mClients[idx].mPeer = *pPeer;
+	mClients[idx].mLastSeenUs = esp_timer_get_time();
+	tcpServerLoadFrame(&mClients[idx], NULL);
+	mClients[idx].mRefValid = false;
+	mClients[idx].mFramesSinceKey = 0;
+	mClients[idx].mFramesSent = 0;
+	mClients[idx].mBytesSent = 0;
+	mClients[idx].mBlockedUs = 0;
+	mClients[idx].mBlockedSinceUs = 0;
+	inet_ntoa_r(pPeer->sin_addr, mClients[idx].mAddr, sizeof(mClients[idx].mAddr) - 1);
+	linkAdapt_Reset(&mClients[idx].mLink, 0);
+	tcpServerApplyRequest(idx);
+	++mClientCount;
+	tcpServerStartStream();
+
+	ESP_LOGI(TCPTAG, TCP_UDP_VIEWER_JOIN, addr_str, ntohs(pFrom->sin_port));
+	ESP_LOGI(TCPTAG, TCP_CLIENT_INFO, mClientCount, TCP_MAX_CLIENTS);
+}//End tcpServerUdpJoin
+
+/*
+ * ***********************************************************************
+ * @brief       tcpServerUdpFind
+ * @param       pPeer - Viewer address and port
+ * @return      Client index, -1 if unknown
+ * @details     Caller must hold mClientMutex
+ **************************************************************************/
+static int8_t tcpServerUdpFind(const struct sockaddr_in* pPeer)
+{
+	for(uint8_t i = 0; i < TCP_MAX_CLIENTS; i++)
+	{
+		if(mClients[i].mSock >= 0 &&
+		   mClients[i].mPeer.sin_addr.s_addr == pPeer->sin_addr.s_addr &&
+		   mClients[i].mPeer.sin_port == pPeer->sin_port)
+		{
+			return i;
+		}//End if
+	}//End for
+	return -1;
+}//End tcpServerUdpFind
+
+/*
+ * ***********************************************************************
+ * @brief       tcpServerUdpExpire
+ * @param       None
+ * @return      None
+ * @details     Remove viewers that sent no hello for UDP_VIEWER_TIMEOUT_MS.
+ * 				Capture is stopped when the last one goes.
+ **************************************************************************/
+static void tcpServerUdpExpire(void)
+{
+	const int64_t now = esp_timer_get_time();
+
+	xSemaphoreTake(mClientMutex, portMAX_DELAY);
+	for(uint8_t i = 0; i < TCP_MAX_CLIENTS; i++)
+	{
+		if(mClients[i].mSock >= 0 && (now - mClients[i].mLastSeenUs) >= (int64_t)UDP_VIEWER_TIMEOUT_MS * 1000)
+		{
+			ESP_LOGW(TCPTAG, TCP_UDP_VIEWER_LEFT, mClients[i].mAddr, ntohs(mClients[i].mPeer.sin_port));
+			tcpServerCloseClient(i);
+		}//End if
+	}//End for
+	xSemaphoreGive(mClientMutex);
+}//End tcpServerUdpExpire
+#endif
+
+/*
+ * ***********************************************************************
+ * @brief       tcpServerStartStream
+ * @param       None
+ * @return      None
+ * @details     The first client takes the capture reference of the
+ * 				TCP stream. Caller must hold mClientMutex.
+ **************************************************************************/
+static void tcpServerStartStream(void)
+{
+	if(isClientConnected)
+	{
+		return;
+	}//End if
+
+	// Mark client connected
+	isClientConnected = true;
+	senxorAcquireCapture();
+	ESP_LOGI(TCPTAG, "Client connected, stream started automatically.");
+#if CONFIG_MI_LED_EN
+	ledCtrlSingleSet(GREEN_LED,LED_ON,0);
+#endif
+}//End tcpServerStartStream
+
+/*
+ * ***********************************************************************
+ * @brief       tcpServerCloseClient
+ * @param       idx - Client index
+ * @return      None
+ * @details     Close a client connection and release its frame mailbox.
+ * 				The last client drops the capture reference.
+ * 				UDP viewers share the server socket, which stays open.
+ * 				Caller must hold mClientMutex.
+ **************************************************************************/
+static void tcpServerCloseClient(const uint8_t idx)
+{
+	if(mClients[idx].mSock < 0)
+	{
+		return;
+	}//End if
+
+#if CONFIG_MI_SER_MODE_TCP
+	close(mClients[idx].mSock);
+#endif
+	framePool_Release(mClients[idx].mTxFrame);							//Drop the partially sent frame
+	mClients[idx].mTxFrame = NULL;
+	framePool_Unsubscribe(mClients[idx].mFrameSub);
+	mClients[idx].mSock = -1;
+	mClients[idx].mFrameSub = FRAME_BUS_INVALID_ID;
+	mClients[idx].mShapeSlot = -1;
+
+	if(mClientCount > 0)
+	{
+		--mClientCount;
+	}//End if
+
+	if(mClientCount == 0 && isClientConnected)
+	{
+		isClientConnected = false;
+		memset(mStreamReq, 0, sizeof(mStreamReq));							//Next clients start in the legacy format, unshaped
+		senxorReleaseCapture();
+#if CONFIG_MI_LED_EN
+		ledCtrlSingleSet(YELLOW_LED,LED_ON,500);
+#endif
+	}//End if
+}//End tcpServerCloseClient
+
 /*
  * ***********************************************************************
  * @brief       tcpServerShutdown
  * @param       None
  * @return      None
- * @details     Shutdown server and release the socket
+ * @details     Shutdown server and release the socket.
+ * 				tcpServerTask keeps running and waits for frames only
+ * 				until the server is started again.
  **************************************************************************/
 void tcpServerShutdown(void)
 {
 	ESP_LOGI(TCPTAG, TCP_SER_SHUTDOWN);
+	for(uint8_t i = 0; i < TCP_MAX_CLIENTS; i++)
+	{
+		tcpServerCloseClient(i);			//Release sockets that connect to server
+	}//End for
 	isClientConnected = false;
 	shutdown(server_sock, 0);				//Shutdown all the connections
-	close(connect_sock);					//Release socket that connects to server
 	close(server_sock);						//Release socket that are listening by server
+	server_sock = -1;
 	isServerUp = false;
 	isFirstRun = true;
-	vTaskDelete(tcpServerRecvTaskHandle);	//Remove task finally
 }//End tcpServerShutdown
 
 
 /*
  * ***********************************************************************
  * @brief       tcpServerSend
- * @param       data - 8 bits data
+ * @param       idx - Client index
+ * 				data - 8 bits data
 				t - Size of the data to be sent (in bytes)
- * @return      No. of bytes sent. -1 if error is occurred
- * @details     Send data via TCP/IP
+ * @return      No. of bytes accepted by the socket, 0 if the socket would
+ * 				block, -1 if error is occurred
+ * @details     Send data to one client via TCP/IP without blocking.
+ * 				The client is dropped on any error other than a full send
+ * 				buffer. In UDP mode data is one datagram to the viewer, a
+ * 				viewer is only dropped by its timeout.
+ * 				Caller must hold mClientMutex.
  **************************************************************************/
-int tcpServerSend(const uint8_t* data, const size_t t)
+int tcpServerSend(const uint8_t idx, const uint8_t* data, const size_t t)
 {
 	// Don't attempt send if not connected
-	if (!isClientConnected)
+	if (idx >= TCP_MAX_CLIENTS || mClients[idx].mSock < 0)
 	{
 		return -1;
 	}
 
 #if CONFIG_MI_SER_MODE_TCP
-	const int err = write(connect_sock, data, t);
+	const int err = send(mClients[idx].mSock, data, t, MSG_DONTWAIT);
 #endif
 
 #if CONFIG_MI_SER_MODE_UDP
-	const int err = sendto(server_sock, data, t, 0, (struct sockaddr *)&source_addr, sizeof(source_addr));
+	const int err = sendto(server_sock, data, t, 0, (struct sockaddr *)&mClients[idx].mPeer, sizeof(mClients[idx].mPeer));
 #endif
 
 	if(err < 0)
 	{
-		ESP_LOGE(TCPTAG, TCP_ERR_TRANS, connect_sock, errno, strerror(errno));
-		isClientConnected = false;
-		Acces_Write_Reg(0xB1, 0x00);  // Stop streaming
-		// Don't call tcpServerRestart here - recv task owns the connection lifecycle
+		if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR || (TCP_STREAM_LOSSY && errno == ENOMEM))
+		{
+			return 0;						//Try again once writable
+		}//End if
+
+		ESP_LOGE(TCPTAG, TCP_ERR_TRANS, mClients[idx].mSock, errno, strerror(errno));
+#if CONFIG_MI_SER_MODE_TCP
+		tcpServerCloseClient(idx);
+#endif
+		return -1;
 	}
 	return err;
 
@@ -394,7 +1482,7 @@ int tcpServerSend(const uint8_t* data, const size_t t)
  * ***********************************************************************
  * @brief       tcpServerGetIsClientConnected
  * @param       None
- * @return      isClientConnected - True if a client is connected.
+ * @return      isClientConnected - True if at least one client is connected.
 				False otherwise
  * @details		Return isClientConnected
  **************************************************************************/
@@ -403,6 +1491,206 @@ bool tcpServerGetIsClientConnected(void)
 	return isClientConnected;
 }//End tcpServerGetIsClientConnected
 
+/*
+ * ***********************************************************************
+ * @brief       tcpServerGetClientCount
+ * @param       None
+ * @return      Number of connected stream clients
+ * @details		None
+ **************************************************************************/
+uint8_t tcpServerGetClientCount(void)
+{
+	return mClientCount;
+}//End tcpServerGetClientCount
+
+/*
+ * ***********************************************************************
+ * @brief       tcpServerGetClientStats
+ * @param       idx - Client index (0 to TCP_MAX_CLIENTS - 1)
+ * 				pBytesSent - Output, bytes sent (wraps at 4 GB)
+ * 				pFramesSent - Output, complete frames sent
+ * 				pFramesDropped - Output, frames skipped because the client was behind
+ * 				pBlockedMs - Output, time spent blocked on a full send buffer
+ * @return      True if a client is connected at this index
+ * @details		Snapshot of the per-client send counters
+ **************************************************************************/
+bool tcpServerGetClientStats(const uint8_t idx, uint32_t* pBytesSent, uint32_t* pFramesSent, uint32_t* pFramesDropped, uint32_t* pBlockedMs)
+{
+	if(idx >= TCP_MAX_CLIENTS || mClientMutex == NULL)
+	{
+		return false;
+	}//End if
+
+	xSemaphoreTake(mClientMutex, portMAX_DELAY);
+	const tcpClient_t* pClient = &mClients[idx];
+	const bool isConnected = (pClient->mSock >= 0);
+	if(isConnected)
+	{
+		uint64_t blockedUs = pClient->mBlockedUs;
+		if(pClient->mBlockedSinceUs != 0)
+		{
+			blockedUs += (uint64_t)(esp_timer_get_time() - pClient->mBlockedSinceUs);	//Still blocked
+		}//End if
+
+		*pBytesSent = (uint32_t)pClient->mBytesSent;
+		*pFramesSent = pClient->mFramesSent;
+		*pFramesDropped = framePool_GetDropCount(pClient->mFrameSub);
+		*pBlockedMs = (uint32_t)(blockedUs / 1000);
+	}//End if
+	xSemaphoreGive(mClientMutex);
+
+	return isConnected;
+}//End tcpServerGetClientStats
+
+/*
+ * ***********************************************************************
+ * @brief       tcpServerSetStreamFormat
+ * @param       pAddr - Address of the stream clients to switch
+ * 				pFormat - In: TCP_STREAM_V1 or TCP_STREAM_V2. Out: the
+ * 				format as applied
+ * 				pEncoding - In: tcpStreamEncoding_t of the v2 payload.
+ * 				Out: the encoding as applied
+ * @return      Number of stream clients switched now, -1 if no request
+ * 				entry is free
+ * @details     Select the format of the frame stream of the clients
+ * 				connected from pAddr, now and later. Other clients keep
+ * 				theirs, every address starts in TCP_STREAM_V1. Takes effect
+ * 				from the next frame each client starts, with a keyframe.
+ * 				Requests are cleared when the last stream client
+ * 				disconnects. The v1 format has no header and is always raw.
+ * 				Multicast viewers share the datagrams of the group, which
+ * 				any address selects the format of.
+ **************************************************************************/
+int tcpServerSetStreamFormat(const char* pAddr, uint8_t* pFormat, uint8_t* pEncoding)
+{
+	const bool isV2 = (*pFormat == TCP_STREAM_V2);
+
+	*pEncoding = (isV2 && *pEncoding < TCP_STREAM_ENC_COUNT) ? *pEncoding : TCP_STREAM_ENC_RAW16;
+	*pFormat = isV2 ? TCP_STREAM_V2 : TCP_STREAM_V1;
+	if(pAddr == NULL || pAddr[0] == '\0' || mClientMutex == NULL)
+	{
+		return -1;
+	}//End if
+#if CONFIG_MI_UDP_MULTICAST
+	pAddr = UDP_MCAST_ADDR;														//Entry of the group viewers
+#endif
+
+	xSemaphoreTake(mClientMutex, portMAX_DELAY);
+	const int8_t entry = tcpServerFindRequest(pAddr);
+	int count = -1;
+	if(entry >= 0)
+	{
+		mStreamReq[entry].mFormat = *pFormat;
+		mStreamReq[entry].mEncoding = *pEncoding;
+		count = tcpServerUpdateRequest(entry);
+	}//End if
+	xSemaphoreGive(mClientMutex);
+
+	return count;
+}//End tcpServerSetStreamFormat
+
+/*
+ * ***********************************************************************
+ * @brief       tcpServerSetStreamIntegrity
+ * @param       pAddr - Address of the stream clients to switch
+ * 				pMode - In: crcMode_t of the v2 payload. Out: the mode as
+ * 				applied
+ * @return      Number of stream clients switched now, -1 if no request
+ * 				entry is free
+ * @details     CRC_MODE_CRC32 adds the payload CRC32 to every v2 header
+ * 				sent to the clients connected from pAddr, now and later.
+ * 				Takes effect from the next frame each client starts.
+ * 				Requests are cleared when the last stream client
+ * 				disconnects. Multicast viewers share one entry, as with
+ * 				tcpServerSetStreamFormat.
+ **************************************************************************/
+int tcpServerSetStreamIntegrity(const char* pAddr, uint8_t* pMode)
+{
+	*pMode = (*pMode < CRC_MODE_COUNT) ? *pMode : CRC_MODE_SUM16;
+	if(pAddr == NULL || pAddr[0] == '\0' || mClientMutex == NULL)
+	{
+		return -1;
+	}//End if
+#if CONFIG_MI_UDP_MULTICAST
+	pAddr = UDP_MCAST_ADDR;														//Entry of the group viewers
+#endif
+
+	xSemaphoreTake(mClientMutex, portMAX_DELAY);
+	const int8_t entry = tcpServerFindRequest(pAddr);
+	int count = -1;
+	if(entry >= 0)
+	{
+		mStreamReq[entry].mIntegrity = *pMode;
+		count = tcpServerUpdateRequest(entry);
+	}//End if
+	xSemaphoreGive(mClientMutex);
+
+	return count;
+}//End tcpServerSetStreamIntegrity
+
+/*
+ * ***********************************************************************
+ * @brief       tcpServerSetStreamShape
+ * @param       pAddr - Address of the stream clients to shape
+ * 				pShape - In: x, y, width, height, decimation, rate divisor.
+ * 				Out: the shape as applied. Width 0 selects the whole image,
+ * 				and with decimation 1 the unshaped full frame.
+ * @return      Number of stream clients shaped now, -1 if the shape is invalid
+ * @details     Crop, max-pool and rate divisor of the stream clients
+ * 				connected from pAddr, now and later. Every distinct window
+ * 				is pooled once per frame whatever the number of clients.
+ * 				Takes effect from the next frame each client starts, with a
+ * 				keyframe. Pixel shaping needs the v2 format, the rate divisor
+ * 				applies to both. Requests are cleared when the last stream
+ * 				client disconnects. Multicast viewers share the group entry,
+ * 				which no client address matches.
+ **************************************************************************/
+int tcpServerSetStreamShape(const char* pAddr, uint8_t* pShape)
+{
+	tcpStreamShape_t shape = { .mX = pShape[0], .mY = pShape[1], .mWidth = pShape[2], .mHeight = pShape[3], .mDecimation = pShape[4], .mRateDiv = pShape[5] };
+
+	if(pAddr == NULL || pAddr[0] == '\0' || mClientMutex == NULL ||
+	   (shape.mDecimation != 1 && shape.mDecimation != 2 && shape.mDecimation != 4) ||
+	   shape.mRateDiv == 0 || shape.mRateDiv > TCP_SHAPE_MAX_RATE_DIV)
+	{
+		return -1;
+	}//End if
+
+	if(shape.mWidth == 0)
+	{
+		const bool isFullFrame = (shape.mDecimation == 1);
+		shape.mX = 0;
+		shape.mY = 0;
+		shape.mWidth = isFullFrame ? 0 : SENXOR_FRAME_WIDTH;
+		shape.mHeight = isFullFrame ? 0 : SENXOR_FRAME_HEIGHT;
+	}
+	else if(shape.mHeight == 0 || (uint16_t)shape.mX + shape.mWidth > SENXOR_FRAME_WIDTH || (uint16_t)shape.mY + shape.mHeight > SENXOR_FRAME_HEIGHT)
+	{
+		return -1;
+	}//End if-else
+	shape.mOutWidth = (shape.mWidth + shape.mDecimation - 1) / shape.mDecimation;
+	shape.mOutHeight = (shape.mHeight + shape.mDecimation - 1) / shape.mDecimation;
+
+	xSemaphoreTake(mClientMutex, portMAX_DELAY);
+	const int8_t entry = tcpServerFindRequest(pAddr);
+	if(entry < 0)
+	{
+		xSemaphoreGive(mClientMutex);
+		return -1;																//One request per client address
+	}//End if
+	mStreamReq[entry].mShape = shape;
+	const int count = tcpServerUpdateRequest(entry);
+	xSemaphoreGive(mClientMutex);
+
+	pShape[0] = shape.mX;
+	pShape[1] = shape.mY;
+	pShape[2] = shape.mWidth;
+	pShape[3] = shape.mHeight;
+	pShape[4] = shape.mDecimation;
+	pShape[5] = shape.mRateDiv;
+	return count;
+}//End tcpServerSetStreamShape
+
 /******************************************************************************
  * @brief       tcpServer_InitThermalBuff
  * @param       pSenxorType - Enum as defined in SenxorType
@@ -414,7 +1702,7 @@ void tcpServer_InitThermalBuff(void)
 	memset(mTxBuff,0,PACKET_SIZE);
 	mMemcpySize = 80 * 64;
 	mTxSize = 10256;
-	mTxPacketSize = mTxSize; 
+	mTxPacketSize = mTxSize;
 	mMemcpyOffset = 12+80*2; 				//(80 words + 4 words)
 
 	// Using 10248 (0x2808) byte packet
@@ -0,0 +1,221 @@
+/*****************************************************************************
+ * @file     temporalFilter.c
+ * @version  1.00
+ * @brief    Per-pixel temporal noise filter of the thermal image.
+ * @date	 15 Oct 2026
+ * @details	 Runs in senxorTask after the bad pixel correction and before
+ * 			 the copy and the analytics, so the stream, the ROIs, the
+ * 			 quadrants and the logs all see the filtered image. Two modes:
+ *
+ * 			 EWMA keeps every pixel with TFILTER_FRAC_BITS fraction bits and
+ * 			 moves it by alpha/256 of the difference to the new value. Without
+ * 			 the fraction bits a small alpha would leave the output stuck up
+ * 			 to 128/alpha counts away from a steady input.
+ *
+ * 			 BOX keeps the last N images in a PSRAM ring and a running sum
+ * 			 per pixel, so each frame costs one add and one subtract per
+ * 			 pixel whatever N is. Until N frames have arrived the mean is
+ * 			 taken over the frames there are.
+ *
+ * 			 The per-pixel state is 32 bit and read and written by every
+ * 			 frame, so it stays in internal RAM (20 kB). The PIE lanes are 16
+ * 			 bit and hold neither the EWMA fraction bits nor a box sum, the
+ * 			 loops are plain C. A new mode or parameter, or a gap longer than
+ * 			 TFILTER_RESEED_US, restarts the filter from the next frame.
+ ******************************************************************************/
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_attr.h>
+
+#include "temporalFilter.h"
+
+#if CONFIG_MI_TFILTER_EN
+
+//private:
+static uint32_t mState[TFILTER_PIXELS];								//EWMA value or box sum, internal RAM
+EXT_RAM_BSS_ATTR static uint16_t mHistory[TFILTER_MAX_FRAMES][TFILTER_PIXELS];	//Box ring, only one image is touched per frame
+static uint8_t mHead = 0;												//Ring slot of the oldest image
+static uint8_t mFill = 0;												//Images in the ring
+static int64_t mLastUs = 0;												//Time of the previous frame
+
+static portMUX_TYPE mLock = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t mMode = TFILTER_DEFAULT_MODE;							//Written by the command tasks
+static uint8_t mAlpha = TFILTER_DEFAULT_ALPHA;
+static uint8_t mFrames = TFILTER_DEFAULT_FRAMES;
+static bool mReseed = true;
+
+static void temporalFilter_Ewma(uint16_t* pImage, const uint8_t alpha, const bool seed);
+static void temporalFilter_Box(uint16_t* pImage, const uint8_t frames, const bool seed);
+
+/*
+ * ***********************************************************************
+ * @brief       temporalFilter_Process
+ * @param       pImage - Image of the frame, header rows removed, filtered in place
+ * @return      None
+ * @details     Called by senxorTask for every frame, after pixelMap_Process
+ **************************************************************************/
+void temporalFilter_Process(uint16_t* pImage)
+{
+	taskENTER_CRITICAL(&mLock);
+	const uint8_t mode = mMode;
+	const uint8_t alpha = mAlpha;
+	const uint8_t frames = mFrames;
+	bool seed = mReseed;
+	mReseed = false;
+	taskEXIT_CRITICAL(&mLock);
+
+	const int64_t nowUs = esp_timer_get_time();
+	seed = seed || (nowUs - mLastUs > TFILTER_RESEED_US);
+	mLastUs = nowUs;
+
+	if (mode == TFILTER_MODE_EWMA)
+	{
+		temporalFilter_Ewma(pImage, alpha, seed);
+	}
+	else if (mode == TFILTER_MODE_BOX)
+	{
+		temporalFilter_Box(pImage, frames, seed);
+	}//End if
+}//End temporalFilter_Process
+
+/*
+ * ***********************************************************************
+ * @brief       temporalFilter_ReadRegister
+ * @param       regAddr - Register address (REG_TFILT_FIRST-REG_TFILT_LAST)
+ * @return      Register value
+ **************************************************************************/
+uint16_t temporalFilter_ReadRegister(const uint8_t regAddr)
+{
+	switch (regAddr)
+	{
+		case REG_TFILT_MODE:
+			return mMode;
+		case REG_TFILT_ALPHA:
+			return mAlpha;
+		case REG_TFILT_FRAMES:
+			return mFrames;
+		default:
+			return 0;
+	}//End switch
+}//End temporalFilter_ReadRegister
+
+/*
+ * ***********************************************************************
+ * @brief       temporalFilter_WriteRegister
+ * @param       regAddr - Register address (REG_TFILT_FIRST-REG_TFILT_LAST)
+ * 				value - Value to write
+ * @return      None
+ * @details     Out of range values are ignored. Not persisted, the
+ * 				Kconfig defaults apply after a reboot.
+ **************************************************************************/
+void temporalFilter_WriteRegister(const uint8_t regAddr, const uint8_t value)
+{
+	taskENTER_CRITICAL(&mLock);
+	if (regAddr == REG_TFILT_MODE && value < TFILTER_MODE_COUNT)
+	{
+		mMode = value;
+		mReseed = true;
+	}
+	else if (regAddr == REG_TFILT_ALPHA && value > 0)
+	{
+		mAlpha = value;
+	}
+	else if (regAddr == REG_TFILT_FRAMES && value >= 2 && value <= TFILTER_MAX_FRAMES)
+	{
+		mFrames = value;
+		mReseed = true;
+	}//End if
+	taskEXIT_CRITICAL(&mLock);
+
+	ESP_LOGI(TFILTERTAG, TFILTER_INFO_MODE, mMode, mAlpha, mFrames);
+}//End temporalFilter_WriteRegister
+
+/*
+ * ***********************************************************************
+ * @brief       temporalFilter_Ewma
+ * @param       pImage - Image, filtered in place
+ * 				alpha - Weight of the new image, 1/256 units
+ * 				seed - Start over from this image
+ * @return      None
+ * @details     s += (x - s) * alpha / 256, rounded, on TFILTER_FRAC_BITS
+ * 				fixed point. The product stays below 2^28.
+ **************************************************************************/
+static void temporalFilter_Ewma(uint16_t* pImage, const uint8_t alpha, const bool seed)
+{
+	if (seed)
+	{
+		for (uint16_t i = 0; i < TFILTER_PIXELS; i++)
+		{
+			mState[i] = (uint32_t)pImage[i] << TFILTER_FRAC_BITS;
+		}//End for
+		return;
+	}//End if
+
+	const int32_t a = alpha;
+	for (uint16_t i = 0; i < TFILTER_PIXELS; i++)
+	{
+		const int32_t diff = (int32_t)((uint32_t)pImage[i] << TFILTER_FRAC_BITS) - (int32_t)mState[i];
+		const uint32_t s = mState[i] + (uint32_t)((diff * a + 128) >> 8);
+		mState[i] = s;
+		pImage[i] = (uint16_t)((s + (1 << (TFILTER_FRAC_BITS - 1))) >> TFILTER_FRAC_BITS);
+	}//End for
+}//End temporalFilter_Ewma
+
+/*
+ * ***********************************************************************
+ * @brief       temporalFilter_Box
+ * @param       pImage - Image, filtered in place
+ * 				frames - Length of the average, 2-TFILTER_MAX_FRAMES
+ * 				seed - Start over from this image
+ * @return      None
+ * @details     The oldest image leaves the sum once the ring is full. The
+ * 				mean is a multiply by the rounded up reciprocal of the count,
+ * 				exact for sums below 2^32 / count.
+ **************************************************************************/
+static void temporalFilter_Box(uint16_t* pImage, const uint8_t frames, const bool seed)
+{
+	if (seed)
+	{
+		memset(mState, 0, sizeof(mState));
+		mHead = 0;
+		mFill = 0;
+	}//End if
+
+	uint16_t* pSlot = mHistory[mHead];
+	const uint16_t drop = (mFill == frames) ? 0xFFFF : 0x0000;				//Mask of the image leaving the sum
+	mFill = (mFill < frames) ? mFill + 1 : mFill;
+	mHead = (mHead + 1 < frames) ? mHead + 1 : 0;
+
+	const uint32_t half = mFill / 2;
+	const uint64_t recip = (0x100000000ULL + mFill - 1) / mFill;
+	for (uint16_t i = 0; i < TFILTER_PIXELS; i++)
+	{
+		const uint32_t s = mState[i] + pImage[i] - (pSlot[i] & drop);
+		mState[i] = s;
+		pSlot[i] = pImage[i];
+		pImage[i] = (uint16_t)(((s + half) * recip) >> 32);
+	}//End for
+}//End temporalFilter_Box
+
+#else
+
+void temporalFilter_Process(uint16_t* pImage)
+{
+	(void)pImage;
+}//End temporalFilter_Process
+
+uint16_t temporalFilter_ReadRegister(const uint8_t regAddr)
+{
+	(void)regAddr;
+	return 0;
+}//End temporalFilter_ReadRegister
+
+void temporalFilter_WriteRegister(const uint8_t regAddr, const uint8_t value)
+{
+	(void)regAddr;
+	(void)value;
+}//End temporalFilter_WriteRegister
+
+#endif
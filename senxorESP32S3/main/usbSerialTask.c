@@ -1,34 +1,78 @@
 /*****************************************************************************
  * @file     usbSerialTask.c
- * @version  1.00
+ * @version  1.10
  * @brief    USB CDC Task
  * @date	 23 Apr 2024
  * @author	 Meridian Innovations
  ******************************************************************************/
 #include "usbSerialTask.h"
 #include "SenXorLib.h"
+#include "framePool.h"
+#include "LatencyTrace.h"
+#include "frameRecorder.h"
 #include "class/cdc/cdc_device.h"
 #include "projdefs.h"
+#include "esp_cpu.h"
+#include "freertos/semphr.h"
+#include <sys/param.h>
 
 //public:
-extern QueueHandle_t senxorFrameQueue;
 TaskHandle_t usbSerialTaskHandle = NULL;						//TCP server handler
 
 //private:
 EXT_RAM_BSS_ATTR static uint8_t 	mCDCRxbuf[CONFIG_TINYUSB_CDC_RX_BUFSIZE + 1];
 EXT_RAM_BSS_ATTR static uint8_t 	mAckBuff[CONFIG_TINYUSB_CDC_RX_BUFSIZE];			//Buffer for returning data to host
-EXT_RAM_BSS_ATTR static uint8_t 	mFrameTxBuff[USB_TX_SIZE];							//Buffer holding the thermal data
 EXT_RAM_BSS_ATTR static cmdPhaser	cmdPhaserObj;														//Command phaser object
+static uint8_t 	mTxHead[USB_TX_HEAD_SIZE];							//Delimiter, length, command and the unused leading rows
+static uint8_t 	mTxTail[USB_TX_TAIL_SIZE + 1];						//Integrity check text, +1 for sprintf terminator
+static SemaphoreHandle_t mTxMutex = NULL;							//Keeps acks out of the middle of a frame packet
 
 static uint16_t mAckSize = 0;
-static uint16_t mMemcpySize = 0;
-static uint16_t mMemcpyOffset = 12;
 static uint8_t mTxErr = 0;
 static uint16_t mTxSize = USB_TX_SIZE;
-static uint16_t mTxSizeRemain = USB_TX_SIZE % CONFIG_TINYUSB_CDC_TX_BUFSIZE;
-static uint16_t mTxPacketSize = 0;
+static uint16_t mTxTailSize = 4;
+static uint8_t mIntegrity = CRC_MODE_SUM16;						//Integrity check of the frame packet being sent
+static volatile uint8_t mIntegrityReq = CRC_MODE_SUM16;			//Integrity check requested by SCRC, applied between frames
+#if CONFIG_MI_REC_EN
+static volatile bool mIsBulkReq = false;							//RECD clip pending, sent by the USB task
+static uint32_t mBulkOffset = 0;
+static uint32_t mBulkLen = 0;
+#endif
+
+static uint32_t mStatFrames = 0;									//Frames sent since the last statistics log
+static uint32_t mStatBytes = 0;									//Bytes queued since the last statistics log
+static uint32_t mStatDrops = 0;									//Frames dropped by the task since the last statistics log
+static uint32_t mStatPoolDrops = 0;								//Frame bus drop count at the last statistics log
+static TickType_t mStatStart = 0;
 
 static void usbSerialTask_Init(void);
+static void usbSerialTask_SetPacketSize(void);
+static void usbSerialTask_PrepareFrame(const senxorFrame* pFrame);
+static void usbSerialTask_SendFrame(const senxorFrame* pFrame);
+static void usbSerialTask_LogStats(const frameSubscriber_t frameSub);
+#if CONFIG_MI_REC_EN
+static bool usbSerialTask_WaitTxRoom(const uint32_t size, const frameSubscriber_t frameSub);
+static void usbSerialTask_SendClip(const frameSubscriber_t frameSub);
+#endif
+#if CONFIG_MI_CRC_BENCH
+static void usbSerialTask_CrcBenchmark(const senxorFrame* pFrame);
+#endif
+
+/*
+ * ***********************************************************************
+ * @brief       tud_cdc_tx_complete_cb
+ * @param       itf - CDC port
+ * @return      None
+ * @details     TinyUSB callback, a bulk IN transfer has completed and
+ * 				TX FIFO space was freed. Wakes the USB task waiting for room.
+ **************************************************************************/
+void tud_cdc_tx_complete_cb(uint8_t itf)
+{
+	if(usbSerialTaskHandle != NULL)
+	{
+		xTaskNotifyGive(usbSerialTaskHandle);
+	}// End if
+}// tud_cdc_tx_complete_cb
 
 /*
  * ***********************************************************************
@@ -70,17 +114,34 @@ static void tinyusb_cdc_rx_callback(int itf, cdcacm_event_t *event)
 	*	Therefore any data received from USB less than 12 bytes is rejected
 	*	alongside missing the delimiter character 'X' for data longer than 12 bytes
 	*/
+#if CONFIG_MI_REC_EN
+	if(mIsBulkReq)
+	{
+		ESP_LOGW(USBTaskTAG, USBTASK_WARN_BULK_BUSY);				//The host reads the clip before it sends more
+		return;
+	}// End if
+#endif
+
 	if(rx_size > 12)
 	{
 		cmdParser_PharseCmd(&cmdPhaserObj, mCDCRxbuf, rx_size);
 		mAckSize = cmdParser_CommitCmd(&cmdPhaserObj, mAckBuff);
 		if(mAckSize != 0)
 		{
+			xSemaphoreTake(mTxMutex, portMAX_DELAY);					//USB task only holds it while queueing
 			tinyusb_cdcacm_write_queue(itf, mAckBuff, mAckSize);
 #if CONFIG_MI_EVK_USB_RX_DBG
 			ESP_LOGI(USBTaskTAG, "mAckBuff %s:", mAckBuff);
 #endif
 			tinyusb_cdcacm_write_flush(itf, 0);			// No blocking here
+			xSemaphoreGive(mTxMutex);
+#if CONFIG_MI_REC_EN
+			if(cmdParser_GetBulkRange(mAckBuff, mAckSize, &mBulkOffset, &mBulkLen))
+			{
+				mIsBulkReq = true;										//Too long for this callback, the USB task sends the clip
+				xTaskNotifyGive(usbSerialTaskHandle);
+			}// End if
+#endif
 		}
 		cmdParser_Init(&cmdPhaserObj);
 	}
@@ -97,40 +158,88 @@ static void tinyusb_cdc_rx_callback(int itf, cdcacm_event_t *event)
  * @brief       usbSerialTask
  * @param       pvParameters - Task arguments
  * @return      None
- * @details     USB Serial Task
+ * @details     USB Serial Task. The TinyUSB TX FIFO is the second buffer:
+ * 				while frame N drains from it, frame N+1 is received and its
+ * 				integrity check computed. Frame N+1 is queued once the FIFO
+ * 				has room for the whole packet, a newer frame arriving in the
+ * 				meantime replaces it (drop oldest).
  **************************************************************************/
 void usbSerialTask(void * pvParameters)
 {
-	esp_err_t tEspErr = ESP_OK;
     senxorFrame *pSenxorFrameRecObj;
     usbSerialTask_Init();
+	const frameSubscriber_t frameSub = framePool_Subscribe("usb", 2, FRAME_POLICY_DROP_OLDEST, xTaskGetCurrentTaskHandle());
 	
+#if CONFIG_MI_CRC_BENCH
+	bool isBenchDone = false;
+#endif
+
+	mStatStart = xTaskGetTickCount();
     for(;;)
     {
-        if(xQueueReceive(senxorFrameQueue, &pSenxorFrameRecObj, portMAX_DELAY))
+        pSenxorFrameRecObj = framePool_Receive(frameSub, pdMS_TO_TICKS(USB_STATS_PERIOD_MS));
+#if CONFIG_MI_REC_EN
+		if(mIsBulkReq)
+		{
+			if(pSenxorFrameRecObj != NULL)
+			{
+				framePool_Release(pSenxorFrameRecObj);													//No frames in the middle of a clip
+				pSenxorFrameRecObj = NULL;
+				++mStatDrops;
+			}// End if
+			usbSerialTask_SendClip(frameSub);
+		}// End if
+#endif
+        if(pSenxorFrameRecObj != NULL)
         {
-			memcpy(mFrameTxBuff+mMemcpyOffset, pSenxorFrameRecObj->mFrame, mMemcpySize*sizeof(uint16_t));		//Copy received object to buffer
-			sprintf((char *)&mFrameTxBuff[mTxSize - 4], "%04X", getCRC(mFrameTxBuff+4,mTxSize-4));
-			
-			tinyusb_cdcacm_write_queue(TINYUSB_CDC_ACM_0,mFrameTxBuff,mTxPacketSize);
-			tEspErr = tinyusb_cdcacm_write_flush(TINYUSB_CDC_ACM_0, pdMS_TO_TICKS(5000));			// Give 100ms for transfer
-			if(tEspErr != ESP_OK)
+			if(mIntegrity != mIntegrityReq)
 			{
-				ESP_LOGE(USBTaskTAG, USBTASK_ERR_FLUSH_BUFF, esp_err_to_name(tEspErr));
-				++mTxErr;
+				mIntegrity = mIntegrityReq;
+				usbSerialTask_SetPacketSize();																	//Packet grows by 4 bytes with CRC32
 			}// End if
-				
-			if(mTxSizeRemain > 0)
+#if CONFIG_MI_CRC_BENCH
+			if(!isBenchDone)
 			{
-				tinyusb_cdcacm_write_queue(TINYUSB_CDC_ACM_0,mFrameTxBuff+mTxPacketSize,mTxSizeRemain);
-				tEspErr = tinyusb_cdcacm_write_flush(TINYUSB_CDC_ACM_0, pdMS_TO_TICKS(5000));			// Give 100ms for transfer
-				if(tEspErr != ESP_OK)
+				usbSerialTask_CrcBenchmark(pSenxorFrameRecObj);
+				isBenchDone = true;
+			}// End if
+#endif
+			usbSerialTask_PrepareFrame(pSenxorFrameRecObj);													//Overlaps with the previous frame draining
+
+			const TickType_t tWaitStart = xTaskGetTickCount();
+			while(tud_cdc_n_write_available(TINYUSB_CDC_ACM_0) < mTxSize)
+			{
+				ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(USB_TX_WAIT_MS));										//TX complete or new frame
+
+				senxorFrame* pNewer = framePool_TryReceive(frameSub);
+				if(pNewer != NULL)
 				{
-					ESP_LOGI(USBTaskTAG,USBTASK_INFO_REMAIN_BYTES, mTxSizeRemain);
-					ESP_LOGE(USBTaskTAG, USBTASK_ERR_FLUSH_BUFF, esp_err_to_name(tEspErr));
-					++mTxErr;
+					framePool_Release(pSenxorFrameRecObj);														//Drop oldest
+					pSenxorFrameRecObj = pNewer;
+					usbSerialTask_PrepareFrame(pSenxorFrameRecObj);
+					++mStatDrops;
 				}// End if
-			}  // End if
+
+				if((xTaskGetTickCount() - tWaitStart) >= pdMS_TO_TICKS(USB_TX_STALL_MS))
+				{
+					if(tud_cdc_n_connected(TINYUSB_CDC_ACM_0))
+					{
+						ESP_LOGW(USBTaskTAG, USBTASK_WARN_TX_STALL, tud_cdc_n_write_available(TINYUSB_CDC_ACM_0));
+						++mTxErr;																				//No port open is not an error
+					}// End if
+					framePool_Release(pSenxorFrameRecObj);
+					pSenxorFrameRecObj = NULL;
+					++mStatDrops;
+					break;
+				}// End if
+			}// End while
+
+			if(pSenxorFrameRecObj != NULL)
+			{
+				usbSerialTask_SendFrame(pSenxorFrameRecObj);
+				framePool_Release(pSenxorFrameRecObj);															//Copied into the TX FIFO
+				mTxErr = 0;
+			}// End if
         }// End if
 		if(mTxErr == 5)
 		{
@@ -138,7 +247,10 @@ void usbSerialTask(void * pvParameters)
 			Acces_Write_Reg(0xB0,0);
 			mTxErr = 0;
 		}
-        vTaskDelay(1);
+		if((xTaskGetTickCount() - mStatStart) >= pdMS_TO_TICKS(USB_STATS_PERIOD_MS))
+		{
+			usbSerialTask_LogStats(frameSub);
+		}// End if
     }// End for
 }// usbSerialTask
 
@@ -155,6 +267,8 @@ static void usbSerialTask_Init(void)
     acmCfgObj.cdc_port = TINYUSB_CDC_ACM_0;
     acmCfgObj.callback_rx = &tinyusb_cdc_rx_callback;
 
+	mTxMutex = xSemaphoreCreateMutex();								//Before the RX callback can run
+	usbSerialTaskHandle = xTaskGetCurrentTaskHandle();				//Woken by tud_cdc_tx_complete_cb
     Drv_USB_CDC_Init(&acmCfgObj);
 	cmdParser_Init(&cmdPhaserObj);
 	ESP_LOGI(USBTaskTAG, USBTASK_INFO_INIT, xPortGetCoreID());
@@ -172,41 +286,272 @@ static void usbSerialTask_Init(void)
 void usbSerialTask_InitThermalBuff(void)
 {
 	memset(mAckBuff,0,CONFIG_TINYUSB_CDC_RX_BUFSIZE);
-	memset(mFrameTxBuff,0,USB_TX_SIZE);                         // Initialise Frame buffers
-	mMemcpySize = 80*64;
-
-	mTxSize = 10256;
-	mTxPacketSize = mTxSize; 
-	mMemcpyOffset = 12+80*2; 				//(80 words + 4 words)
+	memset(mTxHead,0,USB_TX_HEAD_SIZE);                         // Unused leading rows are sent as zeros
+	memset(mTxTail,0,sizeof(mTxTail));
 	
-	// Using 10248 (0x2808) byte packet
-	mFrameTxBuff[0]=' ';
-	mFrameTxBuff[1]=' ';
-	mFrameTxBuff[2]=' ';
-	mFrameTxBuff[3]='#';
-	mFrameTxBuff[4]='2';
-	mFrameTxBuff[5]='8';
-	mFrameTxBuff[6]='0';
-	mFrameTxBuff[7]='8';
-	mFrameTxBuff[8]='G';
-	mFrameTxBuff[9]='F';
-	mFrameTxBuff[10]='R';
-	mFrameTxBuff[11]='A';
-	// CRC
-	mFrameTxBuff[mTxSize-4]='X';
-	mFrameTxBuff[mTxSize-3]='X';
-	mFrameTxBuff[mTxSize-2]='X';
-	mFrameTxBuff[mTxSize-1]='X';
-
-	// Determine if the frame size exceed the limit of CDC buffer size
-	if(mTxSize > CONFIG_TINYUSB_CDC_TX_BUFSIZE)
+	mTxHead[0]=' ';
+	mTxHead[1]=' ';
+	mTxHead[2]=' ';
+	mTxHead[3]='#';
+	mTxHead[8]='G';
+	mTxHead[9]='F';
+	mTxHead[10]='R';
+	mTxHead[11]='A';
+	usbSerialTask_SetPacketSize();
+}// usbSerialTask_InitThermalBuff
+
+ /******************************************************************************
+ * @brief       usbSerialTask_SetPacketSize
+ * @param       none
+ * @return      none
+ * @details     Size and length field of the GFRA packet for the integrity check in use.
+ * 				10248 (0x2808) byte packet with a 4 digit sum, 10252 (0x280C) with an 8 digit CRC32
+ *****************************************************************************/
+static void usbSerialTask_SetPacketSize(void)
+{
+	const bool isCrc32 = (mIntegrity == CRC_MODE_CRC32);
+
+	mTxTailSize = isCrc32 ? 8 : 4;
+	mTxSize = USB_TX_HEAD_SIZE + USB_TX_FRAME_BYTES + mTxTailSize;
+	mTxHead[4]='2';
+	mTxHead[5]='8';
+	mTxHead[6]='0';
+	mTxHead[7]=isCrc32 ? 'C' : '8';
+	ESP_LOGI(USBTaskTAG, USBTASK_INFO_INTEGRITY, isCrc32 ? "CRC32" : "sum16");
+}// usbSerialTask_SetPacketSize
+
+ /******************************************************************************
+ * @brief       usbSerialTask_PrepareFrame
+ * @param       pFrame - Frame to be sent
+ * @return      none
+ * @details     Integrity check of the GFRA packet into mTxTail, chained over
+ * 				the head and the frame so the frame is never copied
+ *****************************************************************************/
+static void usbSerialTask_PrepareFrame(const senxorFrame* pFrame)
+{
+	const uint8_t* pData = (const uint8_t*)pFrame->mFrame;
+
+	if(mIntegrity == CRC_MODE_CRC32)
 	{
-		mTxSizeRemain = mTxSize%CONFIG_TINYUSB_CDC_TX_BUFSIZE;				// Determine the remaining bytes
-		mTxPacketSize = CONFIG_TINYUSB_CDC_TX_BUFSIZE;							// Limiting the transfer size
+		uint32_t tCrc = Drv_Crc_Crc32(0, mTxHead+4, USB_TX_HEAD_SIZE-4);
+		tCrc = Drv_Crc_Crc32(tCrc, pData, USB_TX_FRAME_BYTES);
+		sprintf((char *)mTxTail, "%08lX", (unsigned long)tCrc);								//Length, command and data
 	}
 	else
 	{
-		mTxSizeRemain = 0;
+		const uint16_t tSum = getCRC(mTxHead+4, USB_TX_HEAD_SIZE-4) + getCRC(pData, USB_TX_FRAME_BYTES);
+		sprintf((char *)mTxTail, "%04X", tSum);
 	}// End if-else
-				
-}// usbSerialTask_InitThermalBuff
+}// usbSerialTask_PrepareFrame
+
+ /******************************************************************************
+ * @brief       usbSerialTask_SendFrame
+ * @param       pFrame - Frame to be sent
+ * @return      none
+ * @details     Queue the head, the frame straight from the pool slot and the
+ * 				integrity check, then start the transfer without waiting.
+ * 				The caller makes sure the TX FIFO has room for mTxSize bytes.
+ *****************************************************************************/
+static void usbSerialTask_SendFrame(const senxorFrame* pFrame)
+{
+	size_t tQueued = 0;
+
+	xSemaphoreTake(mTxMutex, portMAX_DELAY);
+	tQueued += tinyusb_cdcacm_write_queue(TINYUSB_CDC_ACM_0, mTxHead, USB_TX_HEAD_SIZE);
+	tQueued += tinyusb_cdcacm_write_queue(TINYUSB_CDC_ACM_0, (const uint8_t*)pFrame->mFrame, USB_TX_FRAME_BYTES);
+	tQueued += tinyusb_cdcacm_write_queue(TINYUSB_CDC_ACM_0, mTxTail, mTxTailSize);
+	const esp_err_t tEspErr = tinyusb_cdcacm_write_flush(TINYUSB_CDC_ACM_0, 0);			// No blocking here
+	xSemaphoreGive(mTxMutex);
+
+	if(tEspErr != ESP_OK)
+	{
+		ESP_LOGE(USBTaskTAG, USBTASK_ERR_FLUSH_BUFF, esp_err_to_name(tEspErr));
+	}
+	else
+	{
+		LATENCY_TRACE(LAT_STAGE_USB_SEND, pFrame->mSeq);
+	}// End if-else
+
+	++mStatFrames;
+	mStatBytes += tQueued;
+}// usbSerialTask_SendFrame
+
+ /******************************************************************************
+ * @brief       usbSerialTask_LogStats
+ * @param       frameSub - Frame bus subscriber of the task
+ * @return      none
+ * @details     Log and reset the throughput counters. Drops include frames
+ * 				replaced in the mailbox and frames dropped while waiting for
+ * 				TX FIFO space.
+ *****************************************************************************/
+static void usbSerialTask_LogStats(const frameSubscriber_t frameSub)
+{
+	const uint32_t tElapsedMs = pdTICKS_TO_MS(xTaskGetTickCount() - mStatStart);
+	const uint32_t tPoolDrops = framePool_GetDropCount(frameSub);
+
+	if(mStatFrames > 0 || mStatDrops > 0 || tPoolDrops != mStatPoolDrops)
+	{
+		const uint32_t tFps10 = (uint32_t)(((uint64_t)mStatFrames * 10000) / tElapsedMs);
+		ESP_LOGI(USBTaskTAG, USBTASK_INFO_STATS, (unsigned long)mStatFrames, (unsigned long)(tFps10 / 10), (unsigned long)(tFps10 % 10),
+				(unsigned long)(((uint64_t)mStatBytes * 1000) / 1024 / tElapsedMs), (unsigned long)(mStatDrops + tPoolDrops - mStatPoolDrops));
+	}// End if
+
+	mStatFrames = 0;
+	mStatBytes = 0;
+	mStatDrops = 0;
+	mStatPoolDrops = tPoolDrops;
+	mStatStart = xTaskGetTickCount();
+}// usbSerialTask_LogStats
+
+#if CONFIG_MI_REC_EN
+ /******************************************************************************
+ * @brief       usbSerialTask_WaitTxRoom
+ * @param       size - Bytes about to be queued
+ * 				frameSub - Frame bus subscriber of the task
+ * @return      false if the host stopped reading
+ * @details     Waits for TX FIFO room like a frame does, frames arriving in
+ * 				the meantime are dropped
+ *****************************************************************************/
+static bool usbSerialTask_WaitTxRoom(const uint32_t size, const frameSubscriber_t frameSub)
+{
+	const TickType_t tWaitStart = xTaskGetTickCount();
+
+	while(tud_cdc_n_write_available(TINYUSB_CDC_ACM_0) < size)
+	{
+		ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(USB_TX_WAIT_MS));											//TX complete or new frame
+
+		senxorFrame* pFrame = framePool_TryReceive(frameSub);
+		if(pFrame != NULL)
+		{
+			framePool_Release(pFrame);
+			++mStatDrops;
+		}// End if
+
+		if((xTaskGetTickCount() - tWaitStart) >= pdMS_TO_TICKS(USB_TX_STALL_MS))
+		{
+			return false;
+		}// End if
+	}// End while
+
+	return true;
+}// usbSerialTask_WaitTxRoom
+
+ /******************************************************************************
+ * @brief       usbSerialTask_SendClip
+ * @param       frameSub - Frame bus subscriber of the task
+ * @return      none
+ * @details     Stream the clip granted by the RECD ack straight from the
+ * 				recorder ring, then its CRC32 as 8 hex digits. Ends the
+ * 				download, also when the host stops reading.
+ *****************************************************************************/
+static void usbSerialTask_SendClip(const frameSubscriber_t frameSub)
+{
+	static const uint8_t tZeros[USB_BULK_FILL_SIZE] = {0};
+	uint32_t tOffset = mBulkOffset;
+	uint32_t tLen = mBulkLen;
+	uint32_t tCrc = 0;
+
+	while(tLen > 0)
+	{
+		const uint8_t* pData = NULL;
+		size_t tSpan = frameRecorderGetClipSpan(tOffset, &pData);
+
+		if(tSpan == 0)
+		{
+			pData = tZeros;																					//Keep the promised length, the CRC shows it
+			tSpan = sizeof(tZeros);
+		}// End if
+		tSpan = MIN(tSpan, MIN(tLen, USB_BULK_CHUNK));
+
+		if(!usbSerialTask_WaitTxRoom(tSpan, frameSub))
+		{
+			ESP_LOGW(USBTaskTAG, USBTASK_WARN_BULK_STALL, (unsigned long)tLen);
+			break;
+		}// End if
+
+		xSemaphoreTake(mTxMutex, portMAX_DELAY);
+		tinyusb_cdcacm_write_queue(TINYUSB_CDC_ACM_0, pData, tSpan);
+		tinyusb_cdcacm_write_flush(TINYUSB_CDC_ACM_0, 0);
+		xSemaphoreGive(mTxMutex);
+
+		tCrc = Drv_Crc_Crc32(tCrc, pData, tSpan);
+		tOffset += tSpan;
+		tLen -= tSpan;
+		mStatBytes += tSpan;
+	}// End while
+
+	if(tLen == 0 && usbSerialTask_WaitTxRoom(8, frameSub))
+	{
+		sprintf((char *)mTxTail, "%08lX", (unsigned long)tCrc);												//No frame is pending, mTxTail is free
+		xSemaphoreTake(mTxMutex, portMAX_DELAY);
+		tinyusb_cdcacm_write_queue(TINYUSB_CDC_ACM_0, mTxTail, 8);
+		tinyusb_cdcacm_write_flush(TINYUSB_CDC_ACM_0, 0);
+		xSemaphoreGive(mTxMutex);
+	}// End if
+
+	frameRecorderEndDownload();
+	mIsBulkReq = false;
+}// usbSerialTask_SendClip
+#endif
+
+ /******************************************************************************
+ * @brief       usbSerialSetIntegrity
+ * @param       mode - crcMode_t of the GFRA packets
+ * @return      none
+ * @details     Applied from the next frame, the host switches its check when
+ * 				the GFRA length field changes
+ *****************************************************************************/
+void usbSerialSetIntegrity(const uint8_t mode)
+{
+	mIntegrityReq = (mode < CRC_MODE_COUNT) ? mode : CRC_MODE_SUM16;
+}// usbSerialSetIntegrity
+
+ /******************************************************************************
+ * @brief       usbSerialGetIntegrity
+ * @param       none
+ * @return      crcMode_t requested for the GFRA packets
+ * @details     None
+ *****************************************************************************/
+uint8_t usbSerialGetIntegrity(void)
+{
+	return mIntegrityReq;
+}// usbSerialGetIntegrity
+
+#if CONFIG_MI_CRC_BENCH
+ /******************************************************************************
+ * @brief       usbSerialTask_CrcBenchmark
+ * @param       pFrame - Live frame to be checked
+ * @return      none
+ * @details     Time every integrity check over the data of a live frame
+ * 				and log the CPU cycles per frame
+ *****************************************************************************/
+static void usbSerialTask_CrcBenchmark(const senxorFrame* pFrame)
+{
+	const uint8_t* pData = (const uint8_t*)pFrame->mFrame;
+	const uint16_t tLen = USB_TX_FRAME_BYTES;
+	volatile uint32_t tSink = 0;											//Keeps the results alive
+
+	uint32_t tStart = esp_cpu_get_cycle_count();
+	for(uint8_t i = 0; i < USB_CRC_BENCH_RUNS; i++)
+	{
+		tSink += getCRC(pData, tLen);
+	}// End for
+	const uint32_t tSumCycles = (esp_cpu_get_cycle_count() - tStart) / USB_CRC_BENCH_RUNS;
+
+	tStart = esp_cpu_get_cycle_count();
+	for(uint8_t i = 0; i < USB_CRC_BENCH_RUNS; i++)
+	{
+		tSink += getCRC16(pData, tLen);
+	}// End for
+	const uint32_t tCrc16Cycles = (esp_cpu_get_cycle_count() - tStart) / USB_CRC_BENCH_RUNS;
+
+	tStart = esp_cpu_get_cycle_count();
+	for(uint8_t i = 0; i < USB_CRC_BENCH_RUNS; i++)
+	{
+		tSink += Drv_Crc_Crc32(0, pData, tLen);
+	}// End for
+	const uint32_t tCrc32Cycles = (esp_cpu_get_cycle_count() - tStart) / USB_CRC_BENCH_RUNS;
+
+	ESP_LOGI(USBTaskTAG, USBTASK_INFO_CRC_BENCH, tLen, (unsigned long)tSumCycles, (unsigned long)tCrc16Cycles, (unsigned long)tCrc32Cycles);
+}// usbSerialTask_CrcBenchmark
+#endif
@@ -0,0 +1,371 @@
+/*****************************************************************************
+ * @file     usbVendorTask.c
+ * @version  1.02
+ * @brief    Frame stream on the bulk IN endpoint of the USB vendor interface.
+ * @date	 15 Oct 2026
+ * @details	 The CDC port frames every packet as text and is shared with the
+ * 			 command acks. The vendor interface only carries frames, in the
+ * 			 binary v2 format of the TCP stream: a tcpStreamHeader_t, then the
+ * 			 raw 80 x 64 frame. Commands stay on the CDC port. A reader
+ * 			 writes SXHI to the bulk OUT endpoint to start the stream and
+ * 			 SXBY to stop it; a reader that stops reading is dropped.
+ *
+ * 			 The TinyUSB TX FIFO is the double buffer. The task copies in half
+ * 			 a FIFO at a time and the stack sends it as one transfer while the
+ * 			 task waits on tud_vendor_tx_cb, so the task wakes a few times per
+ * 			 frame instead of once per packet. The header and CRC of the next
+ * 			 frame are made while the end of the last one drains.
+ ******************************************************************************/
+#include <string.h>
+#include <stddef.h>
+#include <sys/param.h>
+#include <esp_log.h>
+
+#include "SenXorLib.h"
+#include "framePool.h"
+#include "senxorTask.h"
+#include "tcpServerTask.h"
+#include "usbSerialTask.h"
+#include "usbVendorTask.h"
+#include "blobTrack.h"
+#include "LatencyTrace.h"
+#include "Drv_CRC.h"
+#include "DrvWLAN.h"
+#include "class/vendor/vendor_device.h"
+
+#if CONFIG_MI_USB_VENDOR_EN
+
+#define USB_VENDOR_BATCH			MAX(CFG_TUD_VENDOR_TX_BUFSIZE / 2, 64)		//Smallest copy into the FIFO, except the end of a frame
+#define USB_VENDOR_PAYLOAD			(TCP_FRAME_PIXELS * sizeof(uint16_t))		//Raw frame as captured
+
+//private:
+static TaskHandle_t mTaskHandle = NULL;
+static volatile bool mActive = false;								//Reader sent SXHI
+static uint8_t mRxBuff[USB_VENDOR_MSG_LEN];							//Message being read from the bulk OUT endpoint
+static uint8_t mRxLen = 0;
+static tcpStreamHeader_t mTxHeader;									//Header of the frame being sent
+static uint16_t mTxHeaderLen = 0;
+
+static uint32_t mStatFrames = 0;									//Frames sent since the last statistics log
+static uint32_t mStatBytes = 0;									//Bytes queued since the last statistics log
+static uint32_t mStatDrops = 0;									//Frames replaced while waiting for the FIFO
+static uint32_t mStatCuts = 0;										//Frames abandoned part way
+static uint32_t mStatPoolDrops = 0;								//Frame bus drop count at the last statistics log
+static TickType_t mStatStart = 0;
+
+static void usbVendorTask_ReadHost(void);
+static void usbVendorTask_SetActive(const bool active);
+static void usbVendorTask_LoadFrame(const senxorFrame* pFrame);
+static bool usbVendorTask_Write(const uint8_t* pData, const uint32_t len, uint32_t* pSent);
+static void usbVendorTask_SendFrame(const senxorFrame* pFrame);
+static void usbVendorTask_LogStats(const frameSubscriber_t frameSub);
+
+/*
+ * ***********************************************************************
+ * @brief       tud_vendor_tx_cb
+ * @param       itf - Vendor interface
+ * 				sent_bytes - Bytes of the completed transfer
+ * @return      None
+ * @details     TinyUSB callback, a bulk IN transfer has completed and TX
+ * 				FIFO space was freed. Wakes the task waiting for room.
+ **************************************************************************/
+void tud_vendor_tx_cb(uint8_t itf, uint32_t sent_bytes)
+{
+	if(mTaskHandle != NULL)
+	{
+		xTaskNotifyGive(mTaskHandle);
+	}//End if
+}//End tud_vendor_tx_cb
+
+/*
+ * ***********************************************************************
+ * @brief       usbVendorTask
+ * @param       pvParameters - Not used
+ * @return      None
+ * @details     Sends the newest frame whenever the reader has taken the
+ * 				last one. Frames are released unread while no reader is
+ * 				attached.
+ **************************************************************************/
+void usbVendorTask(void *pvParameters)
+{
+	mTaskHandle = xTaskGetCurrentTaskHandle();
+	const frameSubscriber_t frameSub = framePool_Subscribe("usbv", 2, FRAME_POLICY_DROP_OLDEST, mTaskHandle);
+	ESP_LOGI(USBVTAG, USBV_INFO_INIT, xPortGetCoreID(), CFG_TUD_VENDOR_TX_BUFSIZE);
+
+	mStatStart = xTaskGetTickCount();
+	for(;;)
+	{
+		senxorFrame* pFrame = framePool_Receive(frameSub, pdMS_TO_TICKS(USB_VENDOR_POLL_MS));
+		usbVendorTask_ReadHost();
+		if(pFrame != NULL && !mActive)
+		{
+			framePool_Release(pFrame);
+			pFrame = NULL;
+		}//End if
+
+		if(pFrame != NULL)
+		{
+			// Newer frames replace this one until the FIFO has room for its header
+			usbVendorTask_LoadFrame(pFrame);
+			const TickType_t tWaitStart = xTaskGetTickCount();
+			while(tud_vendor_n_write_available(USB_VENDOR_ITF) < MIN(USB_VENDOR_BATCH, mTxHeaderLen))
+			{
+				ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(USB_VENDOR_WAIT_MS));					//TX complete or new frame
+				senxorFrame* pNewer = framePool_TryReceive(frameSub);
+				if(pNewer != NULL)
+				{
+					framePool_Release(pFrame);
+					pFrame = pNewer;
+					usbVendorTask_LoadFrame(pFrame);
+					++mStatDrops;
+				}//End if
+				if(!tud_vendor_n_mounted(USB_VENDOR_ITF) || (xTaskGetTickCount() - tWaitStart) >= pdMS_TO_TICKS(USB_VENDOR_STALL_MS))
+				{
+					framePool_Release(pFrame);													//Reader gone without SXBY
+					pFrame = NULL;
+					usbVendorTask_SetActive(false);
+					break;
+				}//End if
+			}//End while
+		}//End if
+
+		if(pFrame != NULL)
+		{
+			usbVendorTask_SendFrame(pFrame);
+			framePool_Release(pFrame);															//Copied into the TX FIFO
+		}//End if
+
+		if((xTaskGetTickCount() - mStatStart) >= pdMS_TO_TICKS(USB_VENDOR_STATS_PERIOD_MS))
+		{
+			usbVendorTask_LogStats(frameSub);
+		}//End if
+	}//End for
+}//End usbVendorTask
+
+/*
+ * ***********************************************************************
+ * @brief       usbVendorGetIsClientConnected
+ * @param       None
+ * @return      True while a reader takes the vendor stream
+ **************************************************************************/
+bool usbVendorGetIsClientConnected(void)
+{
+	return mActive;
+}//End usbVendorGetIsClientConnected
+
+/*
+ * ***********************************************************************
+ * @brief       usbVendorTask_ReadHost
+ * @param       None
+ * @return      None
+ * @details     Reads the 4 byte messages of the reader from the bulk OUT
+ * 				endpoint. Unplugging ends the stream like SXBY.
+ **************************************************************************/
+static void usbVendorTask_ReadHost(void)
+{
+	if(!tud_vendor_n_mounted(USB_VENDOR_ITF))
+	{
+		mRxLen = 0;
+		usbVendorTask_SetActive(false);
+		return;
+	}//End if
+
+	while(tud_vendor_n_available(USB_VENDOR_ITF) > 0)
+	{
+		mRxLen += tud_vendor_n_read(USB_VENDOR_ITF, &mRxBuff[mRxLen], USB_VENDOR_MSG_LEN - mRxLen);
+		if(mRxLen < USB_VENDOR_MSG_LEN)
+		{
+			break;
+		}//End if
+
+		if(memcmp(mRxBuff, USB_VENDOR_MSG_HELLO, USB_VENDOR_MSG_LEN) == 0)
+		{
+			usbVendorTask_SetActive(true);
+		}
+		else if(memcmp(mRxBuff, USB_VENDOR_MSG_BYE, USB_VENDOR_MSG_LEN) == 0)
+		{
+			usbVendorTask_SetActive(false);
+		}//End if-else
+		mRxLen = 0;
+	}//End while
+}//End usbVendorTask_ReadHost
+
+/*
+ * ***********************************************************************
+ * @brief       usbVendorTask_SetActive
+ * @param       active - Reader attached
+ * @return      None
+ * @details     The attached reader holds a capture reference
+ **************************************************************************/
+static void usbVendorTask_SetActive(const bool active)
+{
+	if(mActive == active)
+	{
+		return;
+	}//End if
+
+	mActive = active;
+	ESP_LOGI(USBVTAG, active ? USBV_INFO_JOIN : USBV_INFO_LEFT);
+	if(active)
+	{
+		senxorAcquireCapture();
+	}
+	else
+	{
+		senxorReleaseCapture();
+	}//End if-else
+}//End usbVendorTask_SetActive
+
+/*
+ * ***********************************************************************
+ * @brief       usbVendorTask_LoadFrame
+ * @param       pFrame - Frame to send
+ * @return      None
+ * @details     v2 header of a raw frame. The CRC32 follows the integrity
+ * 				check chosen for the CDC stream with SCRC.
+ **************************************************************************/
+static void usbVendorTask_LoadFrame(const senxorFrame* pFrame)
+{
+	const uint16_t blobLen = blobTrack_GetRecord(&mTxHeader.mBlobs);
+	mTxHeaderLen = offsetof(tcpStreamHeader_t, mBlobs) + blobLen;
+
+	mTxHeader.mMagic = TCP_STREAM_MAGIC;
+	mTxHeader.mVersion = TCP_STREAM_V2;
+	mTxHeader.mEncoding = TCP_STREAM_ENC_RAW16;
+	mTxHeader.mHeaderLen = mTxHeaderLen;
+	mTxHeader.mSeq = pFrame->mSeq;
+	mTxHeader.mTimestampUs = (uint64_t)pFrame->mTimestampUs;
+	mTxHeader.mPayloadLen = USB_VENDOR_PAYLOAD;
+	mTxHeader.mFlags = TCP_STREAM_FLAG_KEYFRAME | TCP_STREAM_FLAG_STATS | ((blobLen > 0) ? TCP_STREAM_FLAG_BLOBS : 0);
+	memset(mTxHeader.mReserved, 0, sizeof(mTxHeader.mReserved));
+	mTxHeader.mStats = pFrame->mStats;
+	mTxHeader.mPayloadCrc = 0;
+	memset(&mTxHeader.mShape, 0, sizeof(mTxHeader.mShape));
+	mTxHeader.mUtcUs = 0;
+	const int64_t utcOffsetUs = Drv_WLAN_getUtcOffsetUs();
+	if(utcOffsetUs != 0)
+	{
+		mTxHeader.mUtcUs = (uint64_t)(pFrame->mTimestampUs + utcOffsetUs);
+		mTxHeader.mFlags |= TCP_STREAM_FLAG_UTC;
+	}//End if
+	if(usbSerialGetIntegrity() == CRC_MODE_CRC32)
+	{
+		mTxHeader.mPayloadCrc = Drv_Crc_Crc32(0, (const uint8_t*)pFrame->mFrame, USB_VENDOR_PAYLOAD);
+		mTxHeader.mFlags |= TCP_STREAM_FLAG_CRC32;
+	}//End if
+}//End usbVendorTask_LoadFrame
+
+/*
+ * ***********************************************************************
+ * @brief       usbVendorTask_Write
+ * @param       pData - Bytes to send
+ * 				len - Number of bytes
+ * 				pSent - In and out, bytes of the frame queued so far
+ * @return      False if the host stopped reading
+ * @details     Copies into the TX FIFO once at least USB_VENDOR_BATCH
+ * 				bytes are free, and starts the transfer of each copy.
+ **************************************************************************/
+static bool usbVendorTask_Write(const uint8_t* pData, const uint32_t len, uint32_t* pSent)
+{
+	uint32_t done = 0;
+	TickType_t tWaitStart = xTaskGetTickCount();
+
+	while(done < len)
+	{
+		const uint32_t avail = tud_vendor_n_write_available(USB_VENDOR_ITF);
+		if(avail >= MIN(USB_VENDOR_BATCH, len - done))
+		{
+			const uint32_t queued = tud_vendor_n_write(USB_VENDOR_ITF, pData + done, MIN(avail, len - done));
+			tud_vendor_n_write_flush(USB_VENDOR_ITF);
+			done += queued;
+			*pSent += queued;
+			if(queued > 0)
+			{
+				tWaitStart = xTaskGetTickCount();
+				continue;
+			}//End if
+		}//End if
+
+		ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(USB_VENDOR_WAIT_MS));
+		if(!tud_vendor_n_mounted(USB_VENDOR_ITF) || (xTaskGetTickCount() - tWaitStart) >= pdMS_TO_TICKS(USB_VENDOR_STALL_MS))
+		{
+			return false;
+		}//End if
+	}//End while
+
+	return true;
+}//End usbVendorTask_Write
+
+/*
+ * ***********************************************************************
+ * @brief       usbVendorTask_SendFrame
+ * @param       pFrame - Frame to send, loaded by usbVendorTask_LoadFrame
+ * @return      None
+ * @details     The header, then the frame straight from its pool slot.
+ * 				A frame cut part way is not resent, the host finds the
+ * 				next one by its magic.
+ **************************************************************************/
+static void usbVendorTask_SendFrame(const senxorFrame* pFrame)
+{
+	uint32_t sent = 0;
+
+	if(usbVendorTask_Write((const uint8_t*)&mTxHeader, mTxHeaderLen, &sent)
+			&& usbVendorTask_Write((const uint8_t*)pFrame->mFrame, USB_VENDOR_PAYLOAD, &sent))
+	{
+		LATENCY_TRACE(LAT_STAGE_USB_SEND, pFrame->mSeq);
+		++mStatFrames;
+	}
+	else
+	{
+		if(tud_vendor_n_mounted(USB_VENDOR_ITF))
+		{
+			ESP_LOGW(USBVTAG, USBV_WARN_STALL, (unsigned long)sent, (unsigned long)(mTxHeaderLen + USB_VENDOR_PAYLOAD));
+			++mStatCuts;															//Unplugging is not a cut
+		}//End if
+		usbVendorTask_SetActive(false);
+	}//End if-else
+
+	mStatBytes += sent;
+}//End usbVendorTask_SendFrame
+
+/*
+ * ***********************************************************************
+ * @brief       usbVendorTask_LogStats
+ * @param       frameSub - Frame bus subscriber of the task
+ * @return      None
+ * @details     Log and reset the throughput counters
+ **************************************************************************/
+static void usbVendorTask_LogStats(const frameSubscriber_t frameSub)
+{
+	const uint32_t tElapsedMs = pdTICKS_TO_MS(xTaskGetTickCount() - mStatStart);
+	const uint32_t tPoolDrops = framePool_GetDropCount(frameSub);
+
+	if(mStatFrames > 0 || mStatCuts > 0)
+	{
+		const uint32_t tFps10 = (uint32_t)(((uint64_t)mStatFrames * 10000) / tElapsedMs);
+		ESP_LOGI(USBVTAG, USBV_INFO_STATS, (unsigned long)mStatFrames, (unsigned long)(tFps10 / 10), (unsigned long)(tFps10 % 10),
+				(unsigned long)(((uint64_t)mStatBytes * 1000) / 1024 / tElapsedMs), (unsigned long)(mStatDrops + tPoolDrops - mStatPoolDrops),
+				(unsigned long)mStatCuts);
+	}//End if
+
+	mStatFrames = 0;
+	mStatBytes = 0;
+	mStatDrops = 0;
+	mStatCuts = 0;
+	mStatPoolDrops = tPoolDrops;
+	mStatStart = xTaskGetTickCount();
+}//End usbVendorTask_LogStats
+
+#else
+
+void usbVendorTask(void *pvParameters)
+{
+	vTaskDelete(NULL);
+}//End usbVendorTask
+
+bool usbVendorGetIsClientConnected(void)
+{
+	return false;
+}//End usbVendorGetIsClientConnected
+
+#endif
@@ -0,0 +1,284 @@
+/*****************************************************************************
+ * @file     wsStreamTask.c
+ * @version  1.01
+ * @brief    WebSocket frame stream served by the REST server on /stream.
+ * @date	 14 Oct 2026
+ * @details	 Every viewer gets its own latest-only frame mailbox. The httpd
+ * 			 task only runs the handshake and drops whatever a viewer sends.
+ * 			 Frames are sent from wsStreamTask through
+ * 			 httpd_ws_send_frame_async, so a slow viewer never holds up the
+ * 			 httpd task or the REST endpoints.
+ *
+ * 			 Each binary message is the 80 x 62 image (little endian uint16,
+ * 			 header row removed), the same message the Node bridge forwards,
+ * 			 so the browser page works against the ESP32 directly.
+ ******************************************************************************/
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_log.h>
+#include <esp_http_server.h>
+#include <sdkconfig.h>
+
+#include "SenXorLib.h"
+#include "restServer.h"
+#include "tcpServerTask.h"
+#include "wsStreamTask.h"
+#include "LatencyTrace.h"
+
+#if CONFIG_MI_WS_STREAM_EN
+
+//private:
+static wsClient_t mClients[WS_MAX_CLIENTS];
+static uint8_t mClientCount = 0;
+static SemaphoreHandle_t mClientMutex = NULL;						//Guards mClients between httpd and wsStreamTask
+static TaskHandle_t mTaskHandle = NULL;
+static uint8_t mRxBuff[WS_RX_MAX];									//Viewer messages, read and dropped
+
+static esp_err_t wsStream_Handler(httpd_req_t *req);
+static esp_err_t wsStream_AddClient(httpd_req_t *req);
+static void wsStream_RemoveClient(const uint8_t idx);
+static void wsStream_SendFrames(httpd_handle_t server);
+
+/*
+ * ***********************************************************************
+ * @brief       wsStreamTask
+ * @param       pvParameters - Not used
+ * @return      None
+ * @details     Register /stream on the REST server and send the newest
+ * 				frame to every viewer as it is published.
+ **************************************************************************/
+void wsStreamTask(void *pvParameters)
+{
+	mTaskHandle = xTaskGetCurrentTaskHandle();
+	mClientMutex = xSemaphoreCreateMutex();
+	for(uint8_t i = 0; i < WS_MAX_CLIENTS; i++)
+	{
+		mClients[i].mFd = -1;
+		mClients[i].mFrameSub = FRAME_BUS_INVALID_ID;
+		mClients[i].mFramesSent = 0;
+	}//End for
+
+	httpd_handle_t server = getRestServerHandler();
+	if(server == NULL)
+	{
+		ESP_LOGE(WSTAG, WS_ERR_NO_SERVER);
+		vTaskDelete(NULL);
+	}//End if
+
+	const httpd_uri_t streamUri = {
+		.uri = WS_STREAM_URI,
+		.method = HTTP_GET,
+		.handler = wsStream_Handler,
+		.user_ctx = NULL,
+		.is_websocket = true
+	};
+	const esp_err_t err = httpd_register_uri_handler(server, &streamUri);
+	if(err != ESP_OK)
+	{
+		ESP_LOGE(WSTAG, WS_ERR_REGISTER, WS_STREAM_URI, esp_err_to_name(err));
+		vTaskDelete(NULL);
+	}//End if
+	ESP_LOGI(WSTAG, WS_INFO_START, WS_STREAM_URI, WS_MAX_CLIENTS);
+
+	for(;;)
+	{
+		ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(WS_STREAM_WAIT_MS));		//Woken by the frame bus or a new viewer
+		wsStream_SendFrames(server);
+	}//End for
+}//End wsStreamTask
+
+/*
+ * ***********************************************************************
+ * @brief       wsStreamGetIsClientConnected
+ * @param       None
+ * @return      true if at least one viewer is connected
+ * @details     None
+ **************************************************************************/
+bool wsStreamGetIsClientConnected(void)
+{
+	return mClientCount > 0;
+}//End wsStreamGetIsClientConnected
+
+/*
+ * ***********************************************************************
+ * @brief       wsStream_Handler
+ * @param       req - Request
+ * @return      ESP_OK, or an error to have httpd close the session
+ * @details     Runs in the httpd task. GET is the handshake, anything
+ * 				else is a message from the viewer, which is dropped.
+ * 				PING and CLOSE are answered by httpd itself.
+ **************************************************************************/
+static esp_err_t wsStream_Handler(httpd_req_t *req)
+{
+	if(req->method == HTTP_GET)
+	{
+		return wsStream_AddClient(req);
+	}//End if
+
+	httpd_ws_frame_t pkt;
+	memset(&pkt, 0, sizeof(pkt));
+	esp_err_t err = httpd_ws_recv_frame(req, &pkt, 0);						//Length only
+	if(err != ESP_OK || pkt.len == 0)
+	{
+		return err;
+	}//End if
+
+	if(pkt.len > sizeof(mRxBuff))
+	{
+		return ESP_FAIL;													//Viewers have nothing to say, close it
+	}//End if
+
+	pkt.payload = mRxBuff;
+	return httpd_ws_recv_frame(req, &pkt, sizeof(mRxBuff));
+}//End wsStream_Handler
+
+/*
+ * ***********************************************************************
+ * @brief       wsStream_AddClient
+ * @param       req - Handshake request
+ * @return      ESP_OK, ESP_FAIL if every viewer slot is taken
+ * @details     Subscribe the new viewer to the frame bus. The first
+ * 				viewer starts capture, unless a TCP or BLE client or the
+ * 				recorder already did.
+ **************************************************************************/
+static esp_err_t wsStream_AddClient(httpd_req_t *req)
+{
+	const int fd = httpd_req_to_sockfd(req);
+	esp_err_t err = ESP_FAIL;
+
+	xSemaphoreTake(mClientMutex, portMAX_DELAY);
+	for(uint8_t i = 0; i < WS_MAX_CLIENTS; i++)
+	{
+		if(mClients[i].mFd == fd)
+		{
+			wsStream_RemoveClient(i);										//Socket reused before the old session was noticed closed
+		}//End if
+	}//End for
+
+	for(uint8_t i = 0; i < WS_MAX_CLIENTS; i++)
+	{
+		if(mClients[i].mFd >= 0)
+		{
+			continue;
+		}//End if
+
+		const frameSubscriber_t sub = framePool_Subscribe("ws", 1, FRAME_POLICY_LATEST_ONLY, mTaskHandle);
+		if(sub == FRAME_BUS_INVALID_ID)
+		{
+			break;
+		}//End if
+
+		mClients[i].mFrameSub = sub;
+		mClients[i].mFramesSent = 0;
+		mClients[i].mFd = fd;
+		if(mClientCount++ == 0)
+		{
+			senxorAcquireCapture();
+		}//End if
+		ESP_LOGI(WSTAG, WS_INFO_JOIN, i, fd);
+		err = ESP_OK;
+		break;
+	}//End for
+	xSemaphoreGive(mClientMutex);
+
+	if(err != ESP_OK)
+	{
+		ESP_LOGW(WSTAG, WS_WARN_FULL, fd);
+	}//End if
+	return err;
+}//End wsStream_AddClient
+
+/*
+ * ***********************************************************************
+ * @brief       wsStream_RemoveClient
+ * @param       idx - Viewer index
+ * @return      None
+ * @details     Release the frame mailbox of a viewer. The last viewer
+ * 				drops the capture reference of the WebSocket stream.
+ * 				Caller must hold mClientMutex.
+ **************************************************************************/
+static void wsStream_RemoveClient(const uint8_t idx)
+{
+	ESP_LOGI(WSTAG, WS_INFO_LEFT, idx, mClients[idx].mFd, (unsigned)mClients[idx].mFramesSent, (unsigned)framePool_GetDropCount(mClients[idx].mFrameSub));
+
+	framePool_Unsubscribe(mClients[idx].mFrameSub);
+	mClients[idx].mFrameSub = FRAME_BUS_INVALID_ID;
+	mClients[idx].mFd = -1;
+
+	if(mClientCount > 0 && --mClientCount == 0)
+	{
+		senxorReleaseCapture();
+	}//End if
+}//End wsStream_RemoveClient
+
+/*
+ * ***********************************************************************
+ * @brief       wsStream_SendFrames
+ * @param       server - REST server handle
+ * @return      None
+ * @details     Drop viewers whose session httpd has closed, then queue the
+ * 				newest frame of every other viewer. The send runs outside
+ * 				the mutex so a handshake never waits for a slow viewer.
+ **************************************************************************/
+static void wsStream_SendFrames(httpd_handle_t server)
+{
+	for(uint8_t i = 0; i < WS_MAX_CLIENTS; i++)
+	{
+		xSemaphoreTake(mClientMutex, portMAX_DELAY);
+		const int fd = mClients[i].mFd;
+		const frameSubscriber_t sub = mClients[i].mFrameSub;
+		if(fd >= 0 && httpd_ws_get_fd_info(server, fd) != HTTPD_WS_CLIENT_WEBSOCKET)
+		{
+			wsStream_RemoveClient(i);										//Session closed by httpd
+		}//End if
+		xSemaphoreGive(mClientMutex);
+
+		if(fd < 0 || mClients[i].mFd != fd)
+		{
+			continue;
+		}//End if
+
+		senxorFrame* frame = framePool_TryReceive(sub);
+		if(frame == NULL)
+		{
+			continue;
+		}//End if
+
+		httpd_ws_frame_t pkt;
+		memset(&pkt, 0, sizeof(pkt));
+		pkt.final = true;
+		pkt.type = HTTPD_WS_TYPE_BINARY;
+		pkt.payload = (uint8_t*)&frame->mFrame[WS_IMAGE_OFFSET];
+		pkt.len = WS_IMAGE_PIXELS * sizeof(frame->mFrame[0]);
+
+		const esp_err_t err = httpd_ws_send_frame_async(server, fd, &pkt);
+		if(err == ESP_OK)
+		{
+			LATENCY_TRACE(LAT_STAGE_NET_SEND, frame->mSeq);
+			framePool_Release(frame);
+			++mClients[i].mFramesSent;
+			continue;
+		}//End if
+		framePool_Release(frame);
+
+		ESP_LOGW(WSTAG, WS_WARN_SEND, i, esp_err_to_name(err));
+		xSemaphoreTake(mClientMutex, portMAX_DELAY);
+		if(mClients[i].mFd == fd)
+		{
+			wsStream_RemoveClient(i);
+		}//End if
+		xSemaphoreGive(mClientMutex);
+		httpd_sess_trigger_close(server, fd);
+	}//End for
+}//End wsStream_SendFrames
+
+#else
+
+bool wsStreamGetIsClientConnected(void)
+{
+	return false;
+}//End wsStreamGetIsClientConnected
+
+#endif
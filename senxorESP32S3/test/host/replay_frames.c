@@ -0,0 +1,808 @@
+/*****************************************************************************
+ * @file     replay_frames.c
+ * @version  1.00
+ * @brief    Host replay of recorded frames through the frame processing code
+ * @date	 15 Oct 2026
+ * @details	 Decodes a clip in the RECD format (raw, delta and delta + LZ
+ * 			 records) and runs every frame through quadrantMax_Calculate,
+ * 			 Update_min_max_header, COnvert_Image_Transfer_Format in every
+ * 			 unit mode, Get_Max and AutoGain, built for the host against the
+ * 			 shims in shim/. Every output is compared with the golden file,
+ * 			 then every function is timed over the clip.
+ *
+ * 			 The clip is taken as 0.1 K raw units, 0xB9 bit 7 clear, with
+ * 			 automatic gain (PRESET_AUTO). quadrantMax_Calculate is all of
+ * 			 quadrant_Calculate but the hand over to Combustion BLE.
+ *
+ * 			 replay_frames <clip> <golden>				check and time
+ * 			 replay_frames <clip> <golden> --write		rewrite the golden outputs
+ * 			 replay_frames <clip> --synth				write the synthetic clip
+ ******************************************************************************/
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+
+#include "SenXorLib.h"
+#include "Customer_Interface.h"
+#include "AutoGain.h"
+#include "quadrantMax.h"
+#include "frameCodec.h"
+#include "senxorShim.h"
+
+#define REPLAY_WIDTH				80
+#define REPLAY_HEIGHT				64									//Header rows included
+#define REPLAY_FRAME_PIXELS			(REPLAY_WIDTH * REPLAY_HEIGHT)
+#define REPLAY_HEADER_ROWS			2
+#define REPLAY_IMAGE_PIXELS			(REPLAY_WIDTH * (REPLAY_HEIGHT - REPLAY_HEADER_ROWS))
+#define REPLAY_MAX_FRAMES			4096
+#define REPLAY_CLIP_MAGIC			0x43525853							//"SXRC" in little endian
+#define REPLAY_CLIP_HEADER_SIZE		28
+#define REPLAY_RECORD_HEADER_SIZE	16
+#define REPLAY_ENC_RAW16			0x00
+#define REPLAY_ENC_DELTA			0x01
+#define REPLAY_ENC_DELTA_LZ			0x02
+#define REPLAY_DELTA_MAX			(REPLAY_FRAME_PIXELS * 3 + 16)		//Worst case delta payload
+#define REPLAY_TIMING_RUNS			20									//Passes over the clip per timed function
+#define REPLAY_MAX_FAILURES			20									//Mismatches printed
+
+#define REPLAY_BURNERS				{ { 10, 8 }, { 70, 12 }, { 20, 45 }, { 60, 50 } }	//x, y of burners A to D
+
+#define SYNTH_FRAMES				30
+#define SYNTH_KEYFRAME_INTERVAL		25									//CONFIG_MI_REC_KEYFRAME_INTERVAL
+#define SYNTH_BACKGROUND			2981								//25 C in 0.1 K
+#define SYNTH_DEAD_PIXEL			(REPLAY_WIDTH * 12 + 70)			//Stuck hot pixel of the image
+#define SYNTH_DEAD_VALUE			12000
+
+// Text of the outputs of a replay, one line per result
+typedef struct replayOut{
+	char* pText;
+	size_t mLen;
+	size_t mSize;
+}replayOut_t;
+
+// A function timed over the clip
+typedef struct replayTimer{
+	const char* pName;
+	void (*pRun)(const uint16_t* pFrame);
+}replayTimer_t;
+
+extern uint16_t minTemp;
+extern uint16_t maxTemp;
+extern uint8_t FrameCount;
+extern const uint8_t MaxFrame;
+extern uint8_t Gain_Switch_Completed;
+extern int Pix_Max;
+extern int Pix_Cnt;
+
+// Called by the SenXorLib, not declared in a header
+void COnvert_Image_Transfer_Format(uint16_t* buffer, int l_FrameSize);
+void Update_min_max_header(uint16_t* buffer, int l_FrameSize);
+int Get_Max(const uint16_t* Frame, int start, int stop);
+
+static const uint8_t ReplayModes[] = { 1, 2, 4, 5, 6 };				//MCU_REG_31 modes that convert
+
+static uint16_t* ReplayFrames = NULL;
+static uint32_t ReplayFrameCount = 0;
+static uint16_t ReplayBuffer[REPLAY_FRAME_PIXELS];
+static volatile uint32_t ReplaySink = 0;								//Keeps timed results alive
+
+/******************************************************************************
+ * @brief       replay_GetU16 / replay_GetU32
+ * @param       p - little endian field
+ * @return      Field value
+ *****************************************************************************/
+static uint16_t replay_GetU16(const uint8_t* p)
+{
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t replay_GetU32(const uint8_t* p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void replay_PutU16(uint8_t* p, uint16_t value)
+{
+	p[0] = (uint8_t)value;
+	p[1] = (uint8_t)(value >> 8);
+}
+
+static void replay_PutU32(uint8_t* p, uint32_t value)
+{
+	replay_PutU16(p, (uint16_t)value);
+	replay_PutU16(p + 2, (uint16_t)(value >> 16));
+}
+
+/******************************************************************************
+ * @brief       replay_DecodeLZ
+ * @param       pIn / len - LZ block, pOut / outMax - output buffer
+ * @return      Decoded size, 0 if the block is corrupt
+ * @details     Inverse of frameCodec_CompressLZ, LZ4 block layout
+ *****************************************************************************/
+static size_t replay_DecodeLZ(const uint8_t* pIn, size_t len, uint8_t* pOut, size_t outMax)
+{
+	size_t in = 0;
+	size_t out = 0;
+
+	while (in < len)
+	{
+		const uint8_t token = pIn[in++];
+		size_t litLen = token >> 4;
+		if(litLen == 15)
+		{
+			uint8_t more;
+			do
+			{
+				if(in >= len)
+				{
+					return 0;
+				}
+				more = pIn[in++];
+				litLen += more;
+			} while (more == 255);
+		}
+		if(in + litLen > len || out + litLen > outMax)
+		{
+			return 0;
+		}
+		memcpy(&pOut[out], &pIn[in], litLen);
+		in += litLen;
+		out += litLen;
+		if(in == len)
+		{
+			break;													//Last sequence, literals only
+		}
+
+		if(in + 2 > len)
+		{
+			return 0;
+		}
+		const size_t offset = replay_GetU16(&pIn[in]);
+		in += 2;
+		size_t matchLen = (token & 0x0F);
+		if(matchLen == 15)
+		{
+			uint8_t more;
+			do
+			{
+				if(in >= len)
+				{
+					return 0;
+				}
+				more = pIn[in++];
+				matchLen += more;
+			} while (more == 255);
+		}
+		matchLen += FRAME_CODEC_LZ_MIN_MATCH;
+		if(offset == 0 || offset > out || out + matchLen > outMax)
+		{
+			return 0;
+		}
+		for (size_t i = 0; i < matchLen; i++, out++)
+		{
+			pOut[out] = pOut[out - offset];							//Overlapping copy on purpose
+		}
+	}
+	return out;
+}
+
+/******************************************************************************
+ * @brief       replay_GetVarint
+ * @param       pIn / len - input, pPos - position, advanced
+ * @param       pValue - decoded value
+ * @return      false if the varint runs past the input
+ *****************************************************************************/
+static bool replay_GetVarint(const uint8_t* pIn, size_t len, size_t* pPos, uint32_t* pValue)
+{
+	uint32_t value = 0;
+
+	for (int shift = 0; shift < 35; shift += 7)
+	{
+		if(*pPos >= len)
+		{
+			return false;
+		}
+		const uint8_t byte = pIn[(*pPos)++];
+		value |= (uint32_t)(byte & 0x7F) << shift;
+		if((byte & 0x80) == 0)
+		{
+			*pValue = value;
+			return true;
+		}
+	}
+	return false;
+}
+
+/******************************************************************************
+ * @brief       replay_DecodeDelta
+ * @param       pIn / len - delta payload, pRef - previous frame, NULL for a keyframe
+ * @param       pOut - decoded frame, REPLAY_FRAME_PIXELS
+ * @return      false if the payload is corrupt
+ * @details     Inverse of frameCodec_EncodeDelta
+ *****************************************************************************/
+static bool replay_DecodeDelta(const uint8_t* pIn, size_t len, const uint16_t* pRef, uint16_t* pOut)
+{
+	size_t pos = 0;
+	size_t i = 0;
+	uint16_t predict = 0;
+
+	while (pos < len)
+	{
+		uint32_t value;
+		uint32_t run = 1;
+		uint16_t delta = 0;
+
+		if(pIn[pos] == 0x00)
+		{
+			pos++;
+			if(!replay_GetVarint(pIn, len, &pos, &run))
+			{
+				return false;
+			}
+			run++;
+		}
+		else
+		{
+			if(!replay_GetVarint(pIn, len, &pos, &value) || value > 0xFFFF)
+			{
+				return false;
+			}
+			delta = (uint16_t)((value >> 1) ^ ((value & 1) ? 0xFFFF : 0x0000));
+		}
+
+		if(i + run > REPLAY_FRAME_PIXELS)
+		{
+			return false;
+		}
+		for (; run > 0; run--, i++)
+		{
+			if(pRef != NULL)
+			{
+				predict = pRef[i];
+			}
+			pOut[i] = (uint16_t)(predict + delta);
+			predict = pOut[i];
+		}
+	}
+	return i == REPLAY_FRAME_PIXELS;
+}
+
+/******************************************************************************
+ * @brief       replay_LoadClip
+ * @param       pPath - clip in the RECD format
+ * @return      0 on success
+ * @details     Decodes every record into ReplayFrames
+ *****************************************************************************/
+static int replay_LoadClip(const char* pPath)
+{
+	static uint8_t delta[REPLAY_DELTA_MAX];
+	FILE* pFile = fopen(pPath, "rb");
+	uint8_t* pClip;
+	long size;
+
+	if(pFile == NULL)
+	{
+		perror(pPath);
+		return 1;
+	}
+	fseek(pFile, 0, SEEK_END);
+	size = ftell(pFile);
+	fseek(pFile, 0, SEEK_SET);
+	pClip = malloc((size_t)size);
+	if(pClip == NULL || size < REPLAY_CLIP_HEADER_SIZE || fread(pClip, 1, (size_t)size, pFile) != (size_t)size)
+	{
+		printf("FAIL cannot read %s\n", pPath);
+		fclose(pFile);
+		free(pClip);
+		return 1;
+	}
+	fclose(pFile);
+
+	const uint32_t frames = replay_GetU32(&pClip[8]);
+	if(replay_GetU32(pClip) != REPLAY_CLIP_MAGIC || pClip[6] != REPLAY_WIDTH || pClip[7] != REPLAY_HEIGHT
+			|| frames == 0 || frames > REPLAY_MAX_FRAMES)
+	{
+		printf("FAIL %s is not a %dx%d clip\n", pPath, REPLAY_WIDTH, REPLAY_HEIGHT);
+		free(pClip);
+		return 1;
+	}
+
+	ReplayFrames = malloc((size_t)frames * REPLAY_FRAME_PIXELS * sizeof(uint16_t));
+	size_t pos = pClip[5];
+	for (ReplayFrameCount = 0; ReplayFrameCount < frames; ReplayFrameCount++)
+	{
+		uint16_t* pFrame = &ReplayFrames[(size_t)ReplayFrameCount * REPLAY_FRAME_PIXELS];
+		const uint16_t* pRef = (ReplayFrameCount > 0) ? pFrame - REPLAY_FRAME_PIXELS : NULL;
+		bool ok = false;
+
+		if(pos + REPLAY_RECORD_HEADER_SIZE > (size_t)size)
+		{
+			break;
+		}
+		const size_t len = replay_GetU16(&pClip[pos]);
+		const uint8_t encoding = pClip[pos + 2];
+		const bool isKey = (pClip[pos + 3] & 0x01) != 0;
+		const uint8_t* pPayload = &pClip[pos + REPLAY_RECORD_HEADER_SIZE];
+		pos += REPLAY_RECORD_HEADER_SIZE + len;
+		if(pos > (size_t)size || (!isKey && pRef == NULL))
+		{
+			break;
+		}
+
+		if(encoding == REPLAY_ENC_RAW16 && len == REPLAY_FRAME_PIXELS * sizeof(uint16_t))
+		{
+			for (int i = 0; i < REPLAY_FRAME_PIXELS; i++)
+			{
+				pFrame[i] = replay_GetU16(&pPayload[i * 2]);
+			}
+			ok = true;
+		}
+		else if(encoding == REPLAY_ENC_DELTA)
+		{
+			ok = replay_DecodeDelta(pPayload, len, isKey ? NULL : pRef, pFrame);
+		}
+		else if(encoding == REPLAY_ENC_DELTA_LZ)
+		{
+			const size_t deltaLen = replay_DecodeLZ(pPayload, len, delta, sizeof(delta));
+			ok = (deltaLen > 0) && replay_DecodeDelta(delta, deltaLen, isKey ? NULL : pRef, pFrame);
+		}
+		if(!ok)
+		{
+			break;
+		}
+	}
+	free(pClip);
+
+	if(ReplayFrameCount != frames)
+	{
+		printf("FAIL record %u of %s is corrupt\n", ReplayFrameCount, pPath);
+		return 1;
+	}
+	return 0;
+}
+
+/******************************************************************************
+ * @brief       replay_Synth
+ * @param       pPath - clip to write
+ * @return      0 on success
+ * @details     A room at 25 C with a gradient, a stuck pixel, sparse noise and
+ * 				a spot heating from 60 C to 330 C, so AutoGain goes through
+ * 				every gain. Records are coded like frameRecorder_Append.
+ *****************************************************************************/
+static int replay_Synth(const char* pPath)
+{
+	static uint16_t frame[REPLAY_FRAME_PIXELS];
+	static uint16_t ref[REPLAY_FRAME_PIXELS];
+	static uint8_t delta[REPLAY_DELTA_MAX];
+	static uint8_t lz[REPLAY_DELTA_MAX];
+	uint8_t header[REPLAY_CLIP_HEADER_SIZE] = { 0 };
+	uint32_t seed = 1;
+	FILE* pFile = fopen(pPath, "wb");
+
+	if(pFile == NULL)
+	{
+		perror(pPath);
+		return 1;
+	}
+
+	replay_PutU32(&header[0], REPLAY_CLIP_MAGIC);
+	header[4] = 1;
+	header[5] = REPLAY_CLIP_HEADER_SIZE;
+	header[6] = REPLAY_WIDTH;
+	header[7] = REPLAY_HEIGHT;
+	replay_PutU32(&header[8], SYNTH_FRAMES);
+	fwrite(header, 1, sizeof(header), pFile);
+
+	for (int f = 0; f < SYNTH_FRAMES; f++)
+	{
+		const int spot = 3331 + f * 2700 / (SYNTH_FRAMES - 1);			//60 C to 330 C
+		const int cx = 20 + f;
+		const int cy = 40 - f / 2;
+
+		memset(frame, 0, sizeof(frame));
+		frame[1] = (uint16_t)f;											//Frame counter
+		frame[2] = (uint16_t)(30315 + f);								//Chip temperature, 0.01 K
+		for (int y = 0; y < REPLAY_HEIGHT - REPLAY_HEADER_ROWS; y++)
+		{
+			for (int x = 0; x < REPLAY_WIDTH; x++)
+			{
+				const int d2 = (x - cx) * (x - cx) + (y - cy) * (y - cy);
+				int value = SYNTH_BACKGROUND + (x + y) / 8;
+				if(d2 < 25)
+				{
+					value += (spot - SYNTH_BACKGROUND) * (25 - d2) / 25;
+				}
+				seed = seed * 1103515245u + 12345u;
+				if(((seed >> 16) & 15) == 0)
+				{
+					value += ((seed >> 20) & 1) ? 1 : -1;
+				}
+				frame[REPLAY_WIDTH * REPLAY_HEADER_ROWS + y * REPLAY_WIDTH + x] = (uint16_t)value;
+			}
+		}
+		frame[REPLAY_WIDTH * REPLAY_HEADER_ROWS + SYNTH_DEAD_PIXEL] = SYNTH_DEAD_VALUE;
+
+		bool isKey = (f % SYNTH_KEYFRAME_INTERVAL) == 0;
+		const uint8_t* pPayload = delta;
+		uint8_t record[REPLAY_RECORD_HEADER_SIZE] = { 0 };
+		uint8_t encoding = REPLAY_ENC_DELTA;
+		size_t len = frameCodec_EncodeDelta(frame, isKey ? NULL : ref, REPLAY_FRAME_PIXELS, delta, sizeof(delta));
+		const size_t lzLen = frameCodec_CompressLZ(delta, len, lz, len - 1);
+		if(lzLen > 0)
+		{
+			pPayload = lz;
+			len = lzLen;
+			encoding = REPLAY_ENC_DELTA_LZ;
+		}
+		memcpy(ref, frame, sizeof(ref));
+
+		replay_PutU16(&record[0], (uint16_t)len);
+		record[2] = encoding;
+		record[3] = isKey ? 0x01 : 0x00;
+		replay_PutU32(&record[4], (uint32_t)f);
+		replay_PutU32(&record[8], (uint32_t)f * 40000u);				//25 fps
+		fwrite(record, 1, sizeof(record), pFile);
+		fwrite(pPayload, 1, len, pFile);
+	}
+
+	fclose(pFile);
+	return 0;
+}
+
+/******************************************************************************
+ * @brief       replay_Printf
+ * @param       pOut - outputs, pFormat - one line
+ * @return      NONE
+ *****************************************************************************/
+static void __attribute__((format(printf, 2, 3))) replay_Printf(replayOut_t* pOut, const char* pFormat, ...)
+{
+	va_list args;
+
+	if(pOut->mSize - pOut->mLen < 256)
+	{
+		pOut->mSize = (pOut->mSize == 0) ? 65536 : pOut->mSize * 2;
+		pOut->pText = realloc(pOut->pText, pOut->mSize);
+	}
+	va_start(args, pFormat);
+	pOut->mLen += (size_t)vsnprintf(&pOut->pText[pOut->mLen], pOut->mSize - pOut->mLen, pFormat, args);
+	va_end(args);
+}
+
+/******************************************************************************
+ * @brief       replay_Hash
+ * @param       pPixels / count - converted pixels
+ * @return      FNV-1a of the pixels, little endian bytes
+ *****************************************************************************/
+static uint32_t replay_Hash(const uint16_t* pPixels, int count)
+{
+	uint32_t hash = 2166136261u;
+
+	for (int i = 0; i < count; i++)
+	{
+		hash = (hash ^ (pPixels[i] & 0xFF)) * 16777619u;
+		hash = (hash ^ (pPixels[i] >> 8)) * 16777619u;
+	}
+	return hash;
+}
+
+/******************************************************************************
+ * @brief       replay_Reset
+ * @param       NONE
+ * @return      NONE
+ * @details     Registers of a SenXor in continuous capture with automatic gain
+ *****************************************************************************/
+static void replay_Reset(void)
+{
+	senxorShim_Reset();
+	Acces_Write_Reg(0xB1, B1_START_CAPTURE | B1_SINGLE_CONT);
+	Acces_Write_Reg(0xB4, 1);											//No firmware averaging
+	Acces_Write_Reg(0xB9, PRESET_AUTO);
+	Customer_InvalidateTgain();
+	Customer_Interface_Write_Registers(0x30, 0x01);						//Median filter on, Update_min_max_header scans
+}
+
+/******************************************************************************
+ * @brief       replay_SetQuadrant
+ * @param       pData - quadrant data, xsplit, ysplit - split of the frame
+ * @return      NONE
+ * @details     Outputs cleared, burners at REPLAY_BURNERS
+ *****************************************************************************/
+static void replay_SetQuadrant(quadrantData_t* pData, uint8_t xsplit, uint8_t ysplit)
+{
+	static const uint8_t burners[4][2] = REPLAY_BURNERS;
+
+	memset(pData, 0, sizeof(*pData));
+	pData->Xsplit = xsplit;
+	pData->Ysplit = ysplit;
+	pData->Aburnerx = burners[0][0];
+	pData->Aburnery = burners[0][1];
+	pData->Bburnerx = burners[1][0];
+	pData->Bburnery = burners[1][1];
+	pData->Cburnerx = burners[2][0];
+	pData->Cburnery = burners[2][1];
+	pData->Dburnerx = burners[3][0];
+	pData->Dburnery = burners[3][1];
+}
+
+/******************************************************************************
+ * @brief       replay_Frame
+ * @param       index - frame of the clip, pOut - outputs
+ * @return      Number of quadrant maxima that differ from quadrantMax_Scalar
+ *****************************************************************************/
+static int replay_Frame(uint32_t index, replayOut_t* pOut)
+{
+	const uint16_t* pFrame = &ReplayFrames[(size_t)index * REPLAY_FRAME_PIXELS];
+	const uint16_t* pImage = pFrame + REPLAY_WIDTH * REPLAY_HEADER_ROWS;
+	const uint8_t splits[2][2] = {
+		{ 40, 31 },														//DEFAULT_XSPLIT, DEFAULT_YSPLIT
+		{ (uint8_t)(index * 7 % (REPLAY_WIDTH + 1)), (uint8_t)(index * 5 % (REPLAY_HEIGHT - 1)) },
+	};
+	int failures = 0;
+
+	for (int s = 0; s < 2; s++)
+	{
+		uint16_t scalar[4];
+		uint16_t simd[4];
+		quadrantMax_Scalar(pImage, splits[s][0], splits[s][1], scalar);
+		quadrantMax_Simd(pImage, splits[s][0], splits[s][1], simd);
+		if(memcmp(scalar, simd, sizeof(scalar)) != 0)
+		{
+			printf("FAIL frame %u split %u/%u: quadrantMax_Simd differs from quadrantMax_Scalar\n", index, splits[s][0], splits[s][1]);
+			failures++;
+		}
+		replay_Printf(pOut, "Q %u %u %u %u %u %u %u\n", index, splits[s][0], splits[s][1], simd[0], simd[1], simd[2], simd[3]);
+
+		quadrantData_t quadrant;
+		replay_SetQuadrant(&quadrant, splits[s][0], splits[s][1]);
+		quadrantMax_Calculate(pImage, &quadrant);
+		if((quadrant.Amax != simd[0]) || (quadrant.Bmax != simd[1]) || (quadrant.Cmax != simd[2]) || (quadrant.Dmax != simd[3]))
+		{
+			printf("FAIL frame %u split %u/%u: quadrantMax_Calculate maxima differ from quadrantMax_Simd\n", index, splits[s][0], splits[s][1]);
+			failures++;
+		}
+		replay_Printf(pOut, "A %u %u %u %u %u %u %u %u %u %u %u\n", index, splits[s][0], splits[s][1],
+				quadrant.Acenter, quadrant.Bcenter, quadrant.Ccenter, quadrant.Dcenter,
+				quadrant.Aburnert, quadrant.Bburnert, quadrant.Cburnert, quadrant.Dburnert);
+	}
+
+	memcpy(ReplayBuffer, pImage, REPLAY_IMAGE_PIXELS * sizeof(uint16_t));
+	minTemp = 0;
+	maxTemp = 0;
+	Update_min_max_header(ReplayBuffer, REPLAY_IMAGE_PIXELS);
+	const uint16_t frameMin = minTemp;
+	const uint16_t frameMax = maxTemp;
+	replay_Printf(pOut, "M %u %u %u\n", index, frameMin, frameMax);
+
+	for (size_t m = 0; m < sizeof(ReplayModes); m++)
+	{
+		Customer_Interface_Write_Registers(0x31, ReplayModes[m]);
+		memcpy(ReplayBuffer, pImage, REPLAY_IMAGE_PIXELS * sizeof(uint16_t));
+		minTemp = frameMin;
+		maxTemp = frameMax;
+		COnvert_Image_Transfer_Format(ReplayBuffer, REPLAY_IMAGE_PIXELS);
+		replay_Printf(pOut, "C %u %u %u %u %08X\n", index, ReplayModes[m], minTemp, maxTemp,
+				replay_Hash(ReplayBuffer, REPLAY_IMAGE_PIXELS));
+	}
+	Customer_Interface_Write_Registers(0x31, 0);
+
+	memcpy(TransmitFrame->TXBuf, pFrame, REPLAY_FRAME_PIXELS * sizeof(uint16_t));
+	const int top = Get_Max(TransmitFrame->TXBuf, FRAMEWIDTH_BUF * 2 + 12, Pix_Cnt);
+	FrameCount = MaxFrame + 1;											//Settled, every frame takes the automatic gain path
+	AutoGain();
+	replay_Printf(pOut, "G %u %d %d %u %02X %02X %02X\n", index, top, Pix_Max, Gain_Switch_Completed,
+			Acces_Read_Reg(0x08), Acces_Read_Reg(0x0A), Acces_Read_Reg(0xB9));
+	return failures;
+}
+
+/******************************************************************************
+ * @brief       replay_Run
+ * @param       pOut - outputs of every frame
+ * @return      Number of failures
+ *****************************************************************************/
+static int replay_Run(replayOut_t* pOut)
+{
+	int failures = 0;
+
+	replay_Reset();
+	replay_Printf(pOut, "# Written by replay_frames --write, %u frames\n", ReplayFrameCount);
+	replay_Printf(pOut, "# Q frame xsplit ysplit maxA maxB maxC maxD\n");
+	replay_Printf(pOut, "# A frame xsplit ysplit centerA centerB centerC centerD burnerA burnerB burnerC burnerD\n");
+	replay_Printf(pOut, "# M frame min max\n");
+	replay_Printf(pOut, "# C frame mode min max fnv1a\n");
+	replay_Printf(pOut, "# G frame Get_Max Pix_Max Gain_Switch_Completed 0x08 0x0A 0xB9\n");
+	for (uint32_t f = 0; f < ReplayFrameCount; f++)
+	{
+		failures += replay_Frame(f, pOut);
+	}
+	return failures;
+}
+
+/******************************************************************************
+ * @brief       replay_Compare
+ * @param       pPath - golden outputs, pOut - outputs of this run
+ * @return      Number of lines that differ
+ * @details     Comment lines are skipped on both sides
+ *****************************************************************************/
+static int replay_Compare(const char* pPath, const replayOut_t* pOut)
+{
+	FILE* pFile = fopen(pPath, "r");
+	const char* pNext = pOut->pText;
+	const char* pEnd = pOut->pText + pOut->mLen;
+	char line[256];
+	int failures = 0;
+	int lines = 0;
+
+	if(pFile == NULL)
+	{
+		perror(pPath);
+		return 1;
+	}
+
+	while (fgets(line, sizeof(line), pFile) != NULL)
+	{
+		if(line[0] == '#' || line[0] == '\n')
+		{
+			continue;
+		}
+		while (pNext < pEnd && *pNext == '#')
+		{
+			pNext = strchr(pNext, '\n') + 1;
+		}
+		const char* pEol = (pNext < pEnd) ? strchr(pNext, '\n') + 1 : pEnd;
+		if(pNext >= pEnd || strlen(line) != (size_t)(pEol - pNext) || memcmp(line, pNext, strlen(line)) != 0)
+		{
+			if(failures < REPLAY_MAX_FAILURES)
+			{
+				printf("FAIL expected %s     got %.*s", line, (int)(pEol - pNext), (pNext < pEnd) ? pNext : "(none)\n");
+			}
+			failures++;
+		}
+		pNext = pEol;
+		lines++;
+	}
+	fclose(pFile);
+
+	if(pNext < pEnd || lines == 0)
+	{
+		printf("FAIL %s has %d results, the replay more\n", pPath, lines);
+		failures++;
+	}
+	printf("%u frames, %d results, %d differ\n", ReplayFrameCount, lines, failures);
+	return failures;
+}
+
+static void replay_TimeQuadrantScalar(const uint16_t* pFrame)
+{
+	uint16_t max[4];
+	quadrantMax_Scalar(pFrame + REPLAY_WIDTH * REPLAY_HEADER_ROWS, 40, 31, max);
+	ReplaySink += max[0];
+}
+
+static void replay_TimeQuadrantSimd(const uint16_t* pFrame)
+{
+	uint16_t max[4];
+	quadrantMax_Simd(pFrame + REPLAY_WIDTH * REPLAY_HEADER_ROWS, 40, 31, max);
+	ReplaySink += max[0];
+}
+
+static void replay_TimeQuadrant(const uint16_t* pFrame)
+{
+	quadrantData_t quadrant;
+	replay_SetQuadrant(&quadrant, 40, 31);
+	quadrantMax_Calculate(pFrame + REPLAY_WIDTH * REPLAY_HEADER_ROWS, &quadrant);
+	ReplaySink += quadrant.Amax + quadrant.Aburnert;
+}
+
+static void replay_TimeMinMax(const uint16_t* pFrame)
+{
+	Update_min_max_header(ReplayBuffer, REPLAY_IMAGE_PIXELS);
+	ReplaySink += minTemp + pFrame[0];
+}
+
+static void replay_TimeConvert(const uint16_t* pFrame)
+{
+	COnvert_Image_Transfer_Format(ReplayBuffer, REPLAY_IMAGE_PIXELS);
+	ReplaySink += ReplayBuffer[0] + pFrame[0];
+}
+
+static void replay_TimeGetMax(const uint16_t* pFrame)
+{
+	ReplaySink += (uint32_t)Get_Max(pFrame, FRAMEWIDTH_BUF * 2 + 12, Pix_Cnt);
+}
+
+static void replay_TimeAutoGain(const uint16_t* pFrame)
+{
+	(void)pFrame;
+	FrameCount = MaxFrame + 1;
+	AutoGain();
+}
+
+/******************************************************************************
+ * @brief       replay_Time
+ * @param       NONE
+ * @return      NONE
+ * @details     Wall time of every function over REPLAY_TIMING_RUNS passes of
+ * 				the clip. COnvert_Image_Transfer_Format converts to Celsius a
+ * 				copy of the frame made outside the timed call.
+ *****************************************************************************/
+static void replay_Time(void)
+{
+	static const replayTimer_t timers[] = {
+		{ "quadrantMax_Scalar", replay_TimeQuadrantScalar },
+		{ "quadrantMax_Simd", replay_TimeQuadrantSimd },
+		{ "quadrantMax_Calculate", replay_TimeQuadrant },
+		{ "Update_min_max_header", replay_TimeMinMax },
+		{ "COnvert_Image_Transfer_Format", replay_TimeConvert },
+		{ "Get_Max", replay_TimeGetMax },
+		{ "AutoGain", replay_TimeAutoGain },
+	};
+
+	replay_Reset();
+	Customer_Interface_Write_Registers(0x31, 1);
+	for (size_t t = 0; t < sizeof(timers) / sizeof(timers[0]); t++)
+	{
+		uint64_t totalNs = 0;
+		for (int r = 0; r < REPLAY_TIMING_RUNS; r++)
+		{
+			for (uint32_t f = 0; f < ReplayFrameCount; f++)
+			{
+				const uint16_t* pFrame = &ReplayFrames[(size_t)f * REPLAY_FRAME_PIXELS];
+				struct timespec start, end;
+
+				memcpy(ReplayBuffer, pFrame + REPLAY_WIDTH * REPLAY_HEADER_ROWS, REPLAY_IMAGE_PIXELS * sizeof(uint16_t));
+				memcpy(TransmitFrame->TXBuf, pFrame, REPLAY_FRAME_PIXELS * sizeof(uint16_t));
+				clock_gettime(CLOCK_MONOTONIC, &start);
+				timers[t].pRun(pFrame);
+				clock_gettime(CLOCK_MONOTONIC, &end);
+				totalNs += (uint64_t)((end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec));
+			}
+		}
+		printf("%-30s %8llu ns/frame\n", timers[t].pName,
+				(unsigned long long)(totalNs / ((uint64_t)REPLAY_TIMING_RUNS * ReplayFrameCount)));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	replayOut_t out = { 0 };
+	int failures;
+
+	if(argc < 3)
+	{
+		printf("Usage: %s <clip> <golden> [--write] | %s <clip> --synth\n", argv[0], argv[0]);
+		return 2;
+	}
+	if(strcmp(argv[2], "--synth") == 0)
+	{
+		return replay_Synth(argv[1]);
+	}
+	if(replay_LoadClip(argv[1]) != 0)
+	{
+		return 1;
+	}
+
+	failures = replay_Run(&out);
+	if(argc > 3 && strcmp(argv[3], "--write") == 0)
+	{
+		FILE* pFile = fopen(argv[2], "w");
+		if(pFile == NULL)
+		{
+			perror(argv[2]);
+			return 1;
+		}
+		fwrite(out.pText, 1, out.mLen, pFile);
+		fclose(pFile);
+		return (failures == 0) ? 0 : 1;
+	}
+
+	failures += replay_Compare(argv[2], &out);
+	replay_Time();
+	free(out.pText);
+	free(ReplayFrames);
+	return (failures == 0) ? 0 : 1;
+}
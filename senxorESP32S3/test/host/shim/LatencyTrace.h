@@ -0,0 +1,13 @@
+/*****************************************************************************
+ * @file     LatencyTrace.h
+ * @version  1.00
+ * @brief    Host shim, the replay times the functions itself
+ ******************************************************************************/
+#ifndef TEST_HOST_SHIM_LATENCYTRACE_H_
+#define TEST_HOST_SHIM_LATENCYTRACE_H_
+
+#define LATENCY_TRACE(stage, seq)
+#define LATENCY_FUNC_BEGIN(func)
+#define LATENCY_FUNC_END(func)
+
+#endif /* TEST_HOST_SHIM_LATENCYTRACE_H_ */
@@ -0,0 +1,16 @@
+/*****************************************************************************
+ * @file     MCU_Dependent.h
+ * @version  1.00
+ * @brief    Host shim, the drivers are left out
+ ******************************************************************************/
+#ifndef TEST_HOST_SHIM_MCU_DEPENDENT_H_
+#define TEST_HOST_SHIM_MCU_DEPENDENT_H_
+#include <stdlib.h>
+#include "SenXorLib.h"
+
+#define MALLOC_CAP_SPIRAM					0
+#define heap_caps_malloc(size, caps)		malloc(size)
+
+void Drv_SPI_Host_PDMA_Disable(void);
+
+#endif /* TEST_HOST_SHIM_MCU_DEPENDENT_H_ */
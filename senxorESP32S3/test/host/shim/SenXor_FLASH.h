@@ -0,0 +1,9 @@
+/*****************************************************************************
+ * @file     SenXor_FLASH.h
+ * @version  1.00
+ * @brief    Host shim, nothing of the flash is used by the replayed functions
+ ******************************************************************************/
+#ifndef TEST_HOST_SHIM_SENXOR_FLASH_H_
+#define TEST_HOST_SHIM_SENXOR_FLASH_H_
+
+#endif /* TEST_HOST_SHIM_SENXOR_FLASH_H_ */
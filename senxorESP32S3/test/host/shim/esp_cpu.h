@@ -0,0 +1,16 @@
+/*****************************************************************************
+ * @file     esp_cpu.h
+ * @version  1.00
+ * @brief    Host shim of the CPU cycle counter
+ * @details	 The replay times calls with clock_gettime, no cycle counter here.
+ ******************************************************************************/
+#ifndef TEST_HOST_SHIM_ESP_CPU_H_
+#define TEST_HOST_SHIM_ESP_CPU_H_
+#include <stdint.h>
+
+static inline uint32_t esp_cpu_get_cycle_count(void)
+{
+	return 0;
+}
+
+#endif /* TEST_HOST_SHIM_ESP_CPU_H_ */
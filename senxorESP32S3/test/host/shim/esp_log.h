@@ -0,0 +1,16 @@
+/*****************************************************************************
+ * @file     esp_log.h
+ * @version  1.00
+ * @brief    Host shim of the IDF log
+ ******************************************************************************/
+#ifndef TEST_HOST_SHIM_ESP_LOG_H_
+#define TEST_HOST_SHIM_ESP_LOG_H_
+#include <stdio.h>
+
+#define ESP_LOGE(tag, format, ...)	printf("E %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...)	printf("W %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...)	printf("I %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...)	do {} while (0)
+#define ESP_LOGV(tag, format, ...)	do {} while (0)
+
+#endif /* TEST_HOST_SHIM_ESP_LOG_H_ */
@@ -0,0 +1,16 @@
+/*****************************************************************************
+ * @file     FreeRTOS.h
+ * @version  1.00
+ * @brief    Host shim of the FreeRTOS critical sections
+ * @details	 The replay is single threaded, the locks do nothing.
+ ******************************************************************************/
+#ifndef TEST_HOST_SHIM_FREERTOS_H_
+#define TEST_HOST_SHIM_FREERTOS_H_
+
+typedef int portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED	0
+#define portENTER_CRITICAL(mux)			((void)(mux))
+#define portEXIT_CRITICAL(mux)			((void)(mux))
+
+#endif /* TEST_HOST_SHIM_FREERTOS_H_ */
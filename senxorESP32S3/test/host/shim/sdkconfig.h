@@ -0,0 +1,10 @@
+/*****************************************************************************
+ * @file     sdkconfig.h
+ * @version  1.00
+ * @brief    Host shim, no Kconfig option set
+ * @details	 Not an ESP32-S3 either, so quadrantMax.c builds its scalar path.
+ ******************************************************************************/
+#ifndef TEST_HOST_SHIM_SDKCONFIG_H_
+#define TEST_HOST_SHIM_SDKCONFIG_H_
+
+#endif /* TEST_HOST_SHIM_SDKCONFIG_H_ */
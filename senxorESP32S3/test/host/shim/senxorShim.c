@@ -0,0 +1,115 @@
+/*****************************************************************************
+ * @file     senxorShim.c
+ * @version  1.00
+ * @brief    Host shim of the SenXorLib and imageProcessingLib symbols
+ * @date	 15 Oct 2026
+ * @details	 The SenXor registers are a plain array, so the replay can set
+ * 			 0xB9 and read back what AutoGain wrote. The filters of the
+ * 			 prebuilt imageProcessingLib are not replayed and do nothing.
+ ******************************************************************************/
+#include <stdint.h>
+#include <string.h>
+
+#include "SenXorLib.h"
+#include "Customer_Interface.h"
+#include "imageProcessingLib.h"
+#include "senxorShim.h"
+
+MCU_REG MCU_REGISTER;
+
+static Transmit_FrameBuf_struct ShimTransmitFrame;
+Transmit_FrameBuf_struct* TransmitFrame = &ShimTransmitFrame;
+
+static uint8_t ShimRegisters[SHIM_REGISTER_COUNT];
+static uint32_t ShimWrites = 0;
+
+/******************************************************************************
+ * @brief       senxorShim_Reset
+ * @param       NONE
+ * @return      NONE
+ * @details     Clear the registers and the transmit frame
+ *****************************************************************************/
+void senxorShim_Reset(void)
+{
+	memset(ShimRegisters, 0, sizeof(ShimRegisters));
+	memset(&ShimTransmitFrame, 0, sizeof(ShimTransmitFrame));
+	ShimWrites = 0;
+}
+
+/******************************************************************************
+ * @brief       senxorShim_GetWrites
+ * @param       NONE
+ * @return      Register writes since senxorShim_Reset
+ *****************************************************************************/
+uint32_t senxorShim_GetWrites(void)
+{
+	return ShimWrites;
+}
+
+uint8_t Acces_Read_Reg(int Address)
+{
+	return ShimRegisters[Address & (SHIM_REGISTER_COUNT - 1)];
+}
+
+void Acces_Write_Reg(int Address, uint8_t Data)
+{
+	ShimRegisters[Address & (SHIM_REGISTER_COUNT - 1)] = Data;
+	ShimWrites++;
+}
+
+void GetTransmitFrameBuffer(void)
+{
+}
+
+void Drv_SPI_Host_PDMA_Disable(void)
+{
+}
+
+void MEDIAN_ImagePRocessing(uint16_t* ProcessDataFrame_TXBuf, uint16_t l_FrameSize)
+{
+	(void)ProcessDataFrame_TXBuf;
+	(void)l_FrameSize;
+}
+
+void MEDIAN_Initialize(uint8_t MedianFilterEnable, uint8_t MkernelSize, uint16_t* Filter_result)
+{
+	(void)MedianFilterEnable;
+	(void)MkernelSize;
+	(void)Filter_result;
+}
+
+void STARK_Initialize(uint8_t Stark_Control, uint8_t FilterControl, uint8_t STARK_Setting, uint8_t STARK_grad, uint8_t STARK_scale, uint8_t kernelSize, uint16_t* Filter_result, uint16_t* STARKbuff)
+{
+	(void)Stark_Control;
+	(void)FilterControl;
+	(void)STARK_Setting;
+	(void)STARK_grad;
+	(void)STARK_scale;
+	(void)kernelSize;
+	(void)Filter_result;
+	(void)STARKbuff;
+}
+
+void STARK_ImagePRocessing(uint16_t* buffer, int l_FrameSize, uint16_t* Frame_min, uint16_t* Frame_max, uint16_t Tgain, uint16_t module_type)
+{
+	(void)buffer;
+	(void)l_FrameSize;
+	(void)Frame_min;
+	(void)Frame_max;
+	(void)Tgain;
+	(void)module_type;
+}
+
+void KXMS_stabilizer(uint16_t* arr, int l_FrameSize, uint16_t* Frame_min, uint16_t* Frame_max)
+{
+	(void)arr;
+	(void)l_FrameSize;
+	(void)Frame_min;
+	(void)Frame_max;
+}
+
+void KXMS_Initialize(uint8_t KXMS_used, uint8_t Roll_used)
+{
+	(void)KXMS_used;
+	(void)Roll_used;
+}
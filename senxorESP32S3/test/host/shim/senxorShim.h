@@ -0,0 +1,17 @@
+/*****************************************************************************
+ * @file     senxorShim.h
+ * @version  1.00
+ * @brief    Header file for senxorShim.c
+ * @date	 15 Oct 2026
+ ******************************************************************************/
+#ifndef TEST_HOST_SHIM_SENXORSHIM_H_
+#define TEST_HOST_SHIM_SENXORSHIM_H_
+#include <stdint.h>
+
+#define SHIM_REGISTER_COUNT			256									//SenXor register addresses, power of 2
+
+void senxorShim_Reset(void);
+
+uint32_t senxorShim_GetWrites(void);
+
+#endif /* TEST_HOST_SHIM_SENXORSHIM_H_ */
@@ -0,0 +1,12 @@
+/*****************************************************************************
+ * @file     senxorTask.h
+ * @version  1.00
+ * @brief    Host shim, the frame size quadrantMax.c needs from the task
+ ******************************************************************************/
+#ifndef TEST_HOST_SHIM_SENXORTASK_H_
+#define TEST_HOST_SHIM_SENXORTASK_H_
+
+#define SENXOR_FRAME_WIDTH  80
+#define SENXOR_FRAME_HEIGHT 62
+
+#endif /* TEST_HOST_SHIM_SENXORTASK_H_ */
@@ -0,0 +1,6 @@
+/*****************************************************************************
+ * @file     version.h
+ * @version  1.00
+ * @brief    Host shim, Customer_Interface.c includes Version.h by this name
+ ******************************************************************************/
+#include "../../../components/Applications/include/Version.h"
@@ -0,0 +1,319 @@
+/*****************************************************************************
+ * @file     test_protocol.c
+ * @version  1.00
+ * @brief    Host test of the generated packet codec and layouts
+ * @date	 15 Oct 2026
+ * @details	 Decodes every packet and layout of vectors/protocol.txt with the
+ * 			 protoSchema.h functions, encodes them again and compares the
+ * 			 bytes. The vectors are written by genProtocol.js straight from
+ * 			 protocolSchema.json, protocolTest.js and the Swift client check
+ * 			 the same file. Then prints the time of the codec.
+ *
+ * 			 test_protocol <vectors>
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "protoSchema.h"
+
+#define TEST_LINE_LEN				4096
+#define TEST_MAX_BYTES				512
+#define TEST_MAX_VALUES				128
+#define TEST_TIMED_RUNS				1000000
+
+/******************************************************************************
+ * @brief       test_ReadHex
+ * @param       pText - hex bytes, pOut - bytes, maxLen - size of pOut
+ * @return      Number of bytes, -1 on a bad digit
+ *****************************************************************************/
+static int test_ReadHex(const char* pText, uint8_t* pOut, const size_t maxLen)
+{
+	size_t len = 0;
+	uint32_t value;
+
+	if(strcmp(pText, "-") == 0)
+	{
+		return 0;
+	}
+	for (; pText[0] != 0 && pText[1] != 0 && len < maxLen; pText += 2)
+	{
+		if(!protoHex_Read((const uint8_t*)pText, 2, &value))
+		{
+			return -1;
+		}
+		pOut[len++] = (uint8_t)value;
+	}
+	return (pText[0] == 0) ? (int)len : -1;
+}
+
+/******************************************************************************
+ * @brief       test_Packet
+ * @param       pLine - "<command> <checksum> <data hex> <packet hex>"
+ * @return      Number of failures
+ * @details     Checksum 0: none, 1: computed, 2: wrong
+ *****************************************************************************/
+static int test_Packet(char* pLine)
+{
+	static uint8_t data[TEST_MAX_BYTES];
+	static uint8_t packet[TEST_MAX_BYTES + 3];
+	static uint8_t encoded[TEST_MAX_BYTES + 1];
+	char* pCmd = strtok(pLine, " \n");
+	char* pSum = strtok(NULL, " \n");
+	char* pData = strtok(NULL, " \n");
+	char* pPacket = strtok(NULL, " \n");
+	protoPacket_t decoded = { 0 };
+
+	if(pPacket == NULL || strlen(pCmd) != 4)
+	{
+		printf("FAIL malformed packet vector\n");
+		return 1;
+	}
+
+	const int sum = atoi(pSum);
+	const int dataLen = test_ReadHex(pData, data, sizeof(data));
+	const int packetLen = test_ReadHex(pPacket, packet, sizeof(packet));
+	if(dataLen < 0 || packetLen < 0)
+	{
+		printf("FAIL %s: bad hex\n", pCmd);
+		return 1;
+	}
+
+	// Every prefix of the packet is incomplete, the whole of it decodes
+	for (int len = 0; len < packetLen; len++)
+	{
+		if(protoPacket_Decode(packet, (size_t)len, &decoded) != 0)
+		{
+			printf("FAIL %s: %d of %d bytes not incomplete\n", pCmd, len, packetLen);
+			return 1;
+		}
+	}
+	if(protoPacket_Decode(packet, (size_t)packetLen, &decoded) != packetLen ||
+			decoded.mCmd != PROTO_CMD_CODE((const uint8_t*)pCmd) ||
+			decoded.mDataLen != (uint32_t)dataLen || memcmp(decoded.pData, data, (size_t)dataLen) != 0)
+	{
+		printf("FAIL %s: decoded packet differs\n", pCmd);
+		return 1;
+	}
+	if(decoded.mSumSent != (sum != 0) || decoded.mSumValid != (sum != 2))
+	{
+		printf("FAIL %s: checksum %d decoded as sent %d valid %d\n", pCmd, sum, decoded.mSumSent, decoded.mSumValid);
+		return 1;
+	}
+
+	// Encoding the data again gives the same bytes, the wrong checksum excepted
+	memcpy(&encoded[PROTO_PACKET_DATA], data, (size_t)dataLen);
+	const size_t len = protoPacket_Encode(encoded, decoded.mCmd, (size_t)dataLen, sum == 1);
+	if(sum != 2 && (len != (size_t)packetLen || memcmp(encoded, packet, len) != 0 || encoded[len] != 0))
+	{
+		printf("FAIL %s: encoded packet differs\n", pCmd);
+		return 1;
+	}
+
+	// Found behind garbage
+	memmove(&packet[3], packet, (size_t)packetLen);
+	memcpy(packet, "#  ", 3);
+	if(protoPacket_Find(packet, (size_t)packetLen + 3, 0) != 3 || protoPacket_Decode(packet, (size_t)packetLen + 3, &decoded) != -1)
+	{
+		printf("FAIL %s: packet not found behind garbage\n", pCmd);
+		return 1;
+	}
+	return 0;
+}
+
+/******************************************************************************
+ * @brief       test_Field
+ * @param       pField - get function, index - array index
+ * 				value - decoded value, expected - vector value
+ * @return      1 if they differ
+ *****************************************************************************/
+static int test_Field(const char* pField, const uint32_t index, const uint64_t value, const uint64_t expected)
+{
+	if(value != expected)
+	{
+		printf("FAIL %s(%u): %llu, expected %llu\n", pField, index, (unsigned long long)value, (unsigned long long)expected);
+		return 1;
+	}
+	return 0;
+}
+
+// Check each field of the layout in pBytes and set it in pEncoded, in schema order
+#define TEST_SCALAR(get, set, type) \
+	failures += test_Field(#get, 0, get(pBytes), pValues[k]); \
+	set(pEncoded, (type)pValues[k++]);
+#define TEST_ARRAY(get, set, type, count) \
+	for (uint32_t i = 0; i < (count); i++) { \
+		failures += test_Field(#get, i, get(pBytes, i), pValues[k]); \
+		set(pEncoded, i, (type)pValues[k++]); \
+	}
+#define TEST_LAYOUT(name, FIELDS, SIZE) \
+	if(strcmp(pName, #name) == 0) { \
+		size = (SIZE); \
+		if((size_t)len == size && count >= TEST_FIELD_COUNT(FIELDS)) { \
+			FIELDS(TEST_SCALAR, TEST_ARRAY) \
+		} \
+	}
+#define TEST_COUNT_SCALAR(get, set, type)			+ 1
+#define TEST_COUNT_ARRAY(get, set, type, count)	+ (count)
+#define TEST_FIELD_COUNT(FIELDS)					(0 FIELDS(TEST_COUNT_SCALAR, TEST_COUNT_ARRAY))
+
+/******************************************************************************
+ * @brief       test_Layout
+ * @param       pLine - "<name> <bytes hex> <values>"
+ * @return      Number of failures
+ *****************************************************************************/
+static int test_Layout(char* pLine)
+{
+	static uint8_t bytes[TEST_MAX_BYTES];
+	static uint8_t encoded[TEST_MAX_BYTES];
+	static uint64_t values[TEST_MAX_VALUES];
+	const uint8_t* pBytes = bytes;
+	uint8_t* pEncoded = encoded;
+	const uint64_t* pValues = values;
+	const char* pName = strtok(pLine, " \n");
+	const char* pHex = strtok(NULL, " \n");
+	size_t count = 0;
+	size_t size = 0;
+	size_t k = 0;
+	int failures = 0;
+
+	for (char* pValue = strtok(NULL, " \n"); pValue != NULL && count < TEST_MAX_VALUES; pValue = strtok(NULL, " \n"))
+	{
+		values[count++] = strtoull(pValue, NULL, 10);
+	}
+	const int len = (pHex != NULL) ? test_ReadHex(pHex, bytes, sizeof(bytes)) : -1;
+	if(len < 0)
+	{
+		printf("FAIL %s: bad hex\n", pName);
+		return 1;
+	}
+
+	memset(encoded, 0, sizeof(encoded));
+	PROTO_LAYOUTS(TEST_LAYOUT)
+
+	if(size == 0 || (size_t)len != size || k != count)
+	{
+		printf("FAIL %s: %d bytes and %zu values, layout of %zu bytes and %zu values\n", pName, len, count, size, k);
+		return failures + 1;
+	}
+	if(memcmp(encoded, bytes, size) != 0)
+	{
+		printf("FAIL %s: encoded layout differs\n", pName);
+		failures++;
+	}
+	return failures;
+}
+
+/******************************************************************************
+ * @brief       test_Elapsed
+ * @param       pStart / pEnd - monotonic times
+ * @return      ns per run of TEST_TIMED_RUNS
+ *****************************************************************************/
+static unsigned long long test_Elapsed(const struct timespec* pStart, const struct timespec* pEnd)
+{
+	const long long ns = (pEnd->tv_sec - pStart->tv_sec) * 1000000000LL + (pEnd->tv_nsec - pStart->tv_nsec);
+	return (unsigned long long)ns / TEST_TIMED_RUNS;
+}
+
+/******************************************************************************
+ * @brief       test_Throughput
+ * @param       NONE
+ * @return      NONE
+ * @details     Time of the codec on a 4 register RRSE reply and a stream header
+ *****************************************************************************/
+static void test_Throughput(void)
+{
+	static uint8_t packet[64];
+	static uint8_t header[PROTO_STREAM_HEADER_SIZE];
+	static const char data[] = "C0C1C2C30BB8C40FA0";
+	struct timespec start, end;
+	protoPacket_t decoded = { 0 };
+	volatile uint64_t sink = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (uint32_t i = 0; i < TEST_TIMED_RUNS; i++)
+	{
+		memcpy(&packet[PROTO_PACKET_DATA], data, sizeof(data) - 1);
+		sink += protoPacket_Encode(packet, PROTO_CMD_RRSE, sizeof(data) - 1, true);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	printf("%-30s %8llu ns/packet\n", "protoPacket_Encode", test_Elapsed(&start, &end));
+
+	const size_t len = protoPacket_Encode(packet, PROTO_CMD_RRSE, sizeof(data) - 1, true);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (uint32_t i = 0; i < TEST_TIMED_RUNS; i++)
+	{
+		sink += (uint64_t)protoPacket_Decode(packet, len, &decoded) + decoded.mSumValid;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	printf("%-30s %8llu ns/packet\n", "protoPacket_Decode", test_Elapsed(&start, &end));
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (uint32_t i = 0; i < TEST_TIMED_RUNS; i++)
+	{
+		protoStreamHeader_SetSeq(header, i);
+		protoStreamHeader_SetTimestampUs(header, (uint64_t)i << 20);
+		protoStreamHeader_SetPayloadLen(header, i & 0x3FFF);
+		sink += protoStreamHeader_GetSeq(header) + protoStreamHeader_GetTimestampUs(header) + protoStreamHeader_GetPayloadLen(header);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	printf("%-30s %8llu ns/header\n", "protoStreamHeader set + get", test_Elapsed(&start, &end));
+	(void)sink;
+}
+
+/******************************************************************************
+ * @brief       test_Check
+ * @param       pPath - vector file
+ * @return      Number of failures
+ *****************************************************************************/
+static int test_Check(const char* pPath)
+{
+	FILE* pFile = fopen(pPath, "r");
+	static char line[TEST_LINE_LEN];
+	int failures = 0;
+	int vectors = 0;
+
+	if(pFile == NULL)
+	{
+		perror(pPath);
+		return 1;
+	}
+
+	while (fgets(line, sizeof(line), pFile) != NULL)
+	{
+		if(strncmp(line, "packet ", 7) == 0)
+		{
+			failures += test_Packet(&line[7]);
+			vectors++;
+		}
+		else if(strncmp(line, "layout ", 7) == 0)
+		{
+			failures += test_Layout(&line[7]);
+			vectors++;
+		}
+	}
+	fclose(pFile);
+
+	if(vectors == 0)
+	{
+		printf("FAIL no vectors in %s\n", pPath);
+		failures++;
+	}
+	printf("%d vectors, %d failures\n", vectors, failures);
+	return failures;
+}
+
+int main(int argc, char** argv)
+{
+	if(argc < 2)
+	{
+		printf("Usage: %s <vectors>\n", argv[0]);
+		return 2;
+	}
+	const int failures = test_Check(argv[1]);
+	test_Throughput();
+	return (failures == 0) ? 0 : 1;
+}
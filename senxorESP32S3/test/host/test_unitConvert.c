@@ -0,0 +1,372 @@
+/*****************************************************************************
+ * @file     test_unitConvert.c
+ * @version  1.00
+ * @brief    Host test of the unit conversion against committed vectors
+ * @date	 15 Oct 2026
+ * @details	 Replays vectors/unitConvert.txt through UnitConvert.c built for
+ * 			 the host, and checks every raw value of every mode against the
+ * 			 float code it replaced. The vectors are written from that float
+ * 			 code, so they hold the output of the old conversion.
+ *
+ * 			 test_unitConvert <vectors>			check
+ * 			 test_unitConvert <vectors> --write	rewrite the vectors
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "UnitConvert.h"
+
+#define TEST_FUSED_PIXELS			16
+#define TEST_FUSED_PATCHES			3
+
+union FP16_union {
+  float           fp;            /* Floating-point value */
+  unsigned long   ul;           /* Unsigned long value */
+};
+
+// One fused pass: correction and bad pixels with the conversion
+typedef struct testFused{
+	uint8_t mMode;
+	uint8_t mTgain;
+	bool mCorr;
+	uint16_t mRaw[TEST_FUSED_PIXELS];
+	convCorr_t mMap[TEST_FUSED_PIXELS];
+	uint16_t mPatches;
+	pixPatch_t mPatch[TEST_FUSED_PATCHES];
+	uint16_t mMin;
+	uint16_t mMax;
+}testFused_t;
+
+static const uint8_t TestModes[] = { 1, 2, 4, 5, 6 };
+static const uint8_t TestTgains[] = { 0x00, UNIT_TGAIN_HIGH_RES };
+
+static const uint16_t TestValues[] = {
+	0, 1, 2, 5, 9, 10, 99, 100, 1000,
+	2730, 2731, 2732, 2733, 2931, 3731, 5000,
+	27314, 27315, 27316, 29315, 31015, 37315, 40000,
+	50000, 60000, 65534, 65535
+};
+
+static const testFused_t TestFused[] = {
+	{ 1, 0x00, true,
+	  { 2931, 2932, 2933, 2934, 2935, 2936, 2937, 2938, 2939, 2940, 2941, 2942, 2943, 2944, 2945, 10 },
+	  { { 16384, 0 }, { 16384, 5 }, { 16384, -5 }, { 18022, 0 }, { 14746, 0 }, { 16384, 0 }, { 16384, 0 }, { 16384, 0 },
+	    { 16384, 0 }, { 16384, 0 }, { 16384, 0 }, { 16384, 0 }, { 32767, 32767 }, { 16384, -32768 }, { 16384, 0 }, { 16384, 0 } },
+	  3, { { 2, 1 }, { 6, 9 }, { 15, 14 } },
+	  2931, 2945 },
+	{ 5, UNIT_TGAIN_HIGH_RES, true,
+	  { 29315, 29316, 29317, 29318, 29319, 29320, 29321, 29322, 29323, 29324, 29325, 29326, 29327, 29328, 29329, 29330 },
+	  { { 16384, 0 }, { 16384, 10 }, { 16300, 0 }, { 16500, -3 }, { 16384, 0 }, { 16384, 0 }, { 16384, 0 }, { 16384, 0 },
+	    { 16384, 0 }, { 16384, 0 }, { 16384, 0 }, { 16384, 0 }, { 16384, 0 }, { 16384, 0 }, { 16384, 0 }, { 16384, 0 } },
+	  1, { { 0, 4 } },
+	  29315, 29330 },
+	{ 0, 0x00, false,
+	  { 3000, 3001, 3002, 3003, 3004, 3005, 3006, 3007, 3008, 3009, 3010, 3011, 3012, 3013, 3014, 3015 },
+	  { { 0 } },
+	  2, { { 3, 2 }, { 4, 8 } },
+	  3000, 3015 },
+	{ 2, 0x00, false,
+	  { 3000, 3001, 3002, 3003, 3004, 3005, 3006, 3007, 3008, 3009, 3010, 3011, 3012, 3013, 3014, 3015 },
+	  { { 0 } },
+	  2, { { 3, 2 }, { 4, 8 } },
+	  3000, 3015 },
+};
+
+/******************************************************************************
+ * @brief       test_LegacyConvert
+ * @param       value - raw pixel, mode - MCU_REG_31, Tgain - register 0xB9
+ * @return      Converted pixel
+ * @details     One pixel of the float code UnitConvert.c replaced, as it was
+ * 				in COnvert_Image_Transfer_Format. Do not tidy it up.
+ *****************************************************************************/
+static uint16_t test_LegacyConvert(uint16_t value, uint8_t mode, uint8_t Tgain)
+{
+	uint16_t buffer[1] = { value };
+	int i = 0;
+  	float temp_res_divide=10 ;
+
+	union FP16_union temp_data_f16 ;
+	float temp_data ;
+
+	float Celsius_Scale = 273.15;
+
+	if((Tgain&0x80) == 0x80)
+	{
+		temp_res_divide=100 ;
+	}
+	switch(mode)
+	{
+		case 1:
+			temp_data = buffer[i]/temp_res_divide;
+			temp_data = (temp_data - Celsius_Scale)*temp_res_divide;
+			buffer[i]= (int)temp_data;
+		break;
+		case 2:
+			temp_data = buffer[i]/temp_res_divide;
+			temp_data = (float)(((temp_data - Celsius_Scale) * 9/5) + 32)*temp_res_divide;
+			buffer[i]= (int)temp_data;
+		break;
+		case 4:
+			temp_data_f16.fp = buffer[i]/temp_res_divide;
+			buffer[i]= (uint16_t)temp_data_f16.ul;
+		break;
+		case 5:
+			temp_data = buffer[i]/temp_res_divide;
+			temp_data_f16.fp = (temp_data - Celsius_Scale);
+			buffer[i]= (uint16_t)temp_data_f16.ul;
+		break;
+		case 6:
+			temp_data = buffer[i]/10.0;
+			temp_data_f16.fp = (float)(((temp_data - Celsius_Scale) * 9/5) + 32);
+			buffer[i]= (uint16_t)temp_data_f16.ul;
+		break;
+	}
+	return buffer[i];
+}
+
+/******************************************************************************
+ * @brief       test_LegacyFused
+ * @param       pCase - test case, pOut - converted frame
+ * 				pMin / pMax - converted header min and max
+ * @return      NONE
+ * @details     The stages one after the other: correction, header min and
+ * 				max of the corrected good pixels, the float conversion, then
+ * 				every bad pixel copied from its replacement
+ *****************************************************************************/
+static void test_LegacyFused(const testFused_t* pCase, uint16_t* pOut, uint16_t* pMin, uint16_t* pMax)
+{
+	uint16_t minT = 0xFFFF;
+	uint16_t maxT = 0;
+	uint16_t p = 0;
+
+	*pMin = pCase->mMin;
+	*pMax = pCase->mMax;
+	for (int i = 0; i < TEST_FUSED_PIXELS; i++)
+	{
+		int32_t value = pCase->mRaw[i];
+		if(pCase->mCorr)
+		{
+			value = (int32_t)(((uint32_t)value * pCase->mMap[i].mGain + (CONV_GAIN_UNITY >> 1)) >> CONV_GAIN_SHIFT) + pCase->mMap[i].mOffset;
+			value = (value < 0) ? 0 : (value > 0xFFFF) ? 0xFFFF : value;
+		}
+		if(p < pCase->mPatches && pCase->mPatch[p].mDst == i)
+		{
+			p++;
+		}
+		else
+		{
+			minT = (value < minT) ? value : minT;
+			maxT = (value > maxT) ? value : maxT;
+		}
+		pOut[i] = (uint16_t)value;
+	}
+	if(pCase->mCorr)
+	{
+		*pMin = minT;
+		*pMax = maxT;
+	}
+
+	for (int i = 0; i < TEST_FUSED_PIXELS; i++)
+	{
+		pOut[i] = test_LegacyConvert(pOut[i], pCase->mMode, pCase->mTgain);	// Kelvin stays as it is
+	}
+	*pMin = test_LegacyConvert(*pMin, pCase->mMode, pCase->mTgain);
+	*pMax = test_LegacyConvert(*pMax, pCase->mMode, pCase->mTgain);
+	for (p = 0; p < pCase->mPatches; p++)
+	{
+		pOut[pCase->mPatch[p].mDst] = pOut[pCase->mPatch[p].mSrc];
+	}
+}
+
+/******************************************************************************
+ * @brief       test_Fused
+ * @param       pCase - test case, pOut - converted frame
+ * 				pMin / pMax - converted header min and max
+ * @return      NONE
+ *****************************************************************************/
+static void test_Fused(const testFused_t* pCase, uint16_t* pOut, uint16_t* pMin, uint16_t* pMax)
+{
+	memcpy(pOut, pCase->mRaw, sizeof(pCase->mRaw));
+	*pMin = pCase->mMin;
+	*pMax = pCase->mMax;
+	UnitConvert_Fused(pOut, TEST_FUSED_PIXELS, UnitConvert_GetScale(pCase->mMode, pCase->mTgain),
+			pCase->mCorr ? pCase->mMap : NULL, pCase->mPatch, pCase->mPatches, pMin, pMax);
+}
+
+/******************************************************************************
+ * @brief       test_Write
+ * @param       pPath - vector file
+ * @return      0 on success
+ * @details     Vectors of the float code, not of UnitConvert.c
+ *****************************************************************************/
+static int test_Write(const char* pPath)
+{
+	FILE* pFile = fopen(pPath, "w");
+	if(pFile == NULL)
+	{
+		perror(pPath);
+		return 1;
+	}
+
+	fprintf(pFile, "# Written by test_unitConvert --write from the float code UnitConvert.c replaced\n");
+	fprintf(pFile, "# V mode tgain raw converted\n");
+	for (size_t m = 0; m < sizeof(TestModes); m++)
+	{
+		for (size_t t = 0; t < sizeof(TestTgains); t++)
+		{
+			for (size_t v = 0; v < sizeof(TestValues) / sizeof(TestValues[0]); v++)
+			{
+				fprintf(pFile, "V %u 0x%02X %u %u\n", TestModes[m], TestTgains[t], TestValues[v],
+						test_LegacyConvert(TestValues[v], TestModes[m], TestTgains[t]));
+			}
+		}
+	}
+
+	fprintf(pFile, "# F case min max converted[%d]\n", TEST_FUSED_PIXELS);
+	for (size_t c = 0; c < sizeof(TestFused) / sizeof(TestFused[0]); c++)
+	{
+		uint16_t out[TEST_FUSED_PIXELS];
+		uint16_t min, max;
+		test_LegacyFused(&TestFused[c], out, &min, &max);
+		fprintf(pFile, "F %zu %u %u", c, min, max);
+		for (int i = 0; i < TEST_FUSED_PIXELS; i++)
+		{
+			fprintf(pFile, " %u", out[i]);
+		}
+		fprintf(pFile, "\n");
+	}
+
+	fclose(pFile);
+	return 0;
+}
+
+/******************************************************************************
+ * @brief       test_Check
+ * @param       pPath - vector file
+ * @return      Number of failures
+ *****************************************************************************/
+static int test_Check(const char* pPath)
+{
+	FILE* pFile = fopen(pPath, "r");
+	char line[512];
+	int failures = 0;
+	int vectors = 0;
+
+	if(pFile == NULL)
+	{
+		perror(pPath);
+		return 1;
+	}
+
+	while (fgets(line, sizeof(line), pFile) != NULL)
+	{
+		unsigned mode, tgain, raw, expected;
+		unsigned c, min, max;
+		int used;
+
+		if(sscanf(line, "V %u %x %u %u", &mode, &tgain, &raw, &expected) == 4)
+		{
+			uint16_t value = (uint16_t)raw;
+			uint16_t unused = 0;
+			UnitConvert_Frame(&value, 1, UnitConvert_GetScale(mode, tgain), &unused, &unused);
+			if(value != expected)
+			{
+				printf("FAIL mode %u tgain 0x%02X raw %u: %u, expected %u\n", mode, tgain, raw, value, expected);
+				failures++;
+			}
+			vectors++;
+		}
+		else if(sscanf(line, "F %u %u %u%n", &c, &min, &max, &used) == 3 && c < sizeof(TestFused) / sizeof(TestFused[0]))
+		{
+			uint16_t out[TEST_FUSED_PIXELS];
+			uint16_t outMin, outMax;
+			const char* pNext = line + used;
+
+			test_Fused(&TestFused[c], out, &outMin, &outMax);
+			if(outMin != min || outMax != max)
+			{
+				printf("FAIL fused %u: min %u max %u, expected %u %u\n", c, outMin, outMax, min, max);
+				failures++;
+			}
+			for (int i = 0; i < TEST_FUSED_PIXELS; i++)
+			{
+				if(sscanf(pNext, "%u%n", &expected, &used) != 1 || out[i] != expected)
+				{
+					printf("FAIL fused %u pixel %d: %u\n", c, i, out[i]);
+					failures++;
+					break;
+				}
+				pNext += used;
+			}
+			vectors++;
+		}
+	}
+	fclose(pFile);
+
+	if(vectors == 0)
+	{
+		printf("FAIL no vectors in %s\n", pPath);
+		failures++;
+	}
+
+	// Every raw value of every mode, as a frame pixel and as the header min and max
+	for (size_t m = 0; m < sizeof(TestModes); m++)
+	{
+		for (size_t t = 0; t < sizeof(TestTgains); t++)
+		{
+			static uint16_t frame[UNIT_RAW_VALUES];
+			const unitScale_t* pScale = UnitConvert_GetScale(TestModes[m], TestTgains[t]);
+			int differ = 0;
+
+			for (uint32_t raw = 0; raw < UNIT_RAW_VALUES; raw++)
+			{
+				frame[raw] = (uint16_t)raw;
+			}
+			uint16_t min = 0;
+			uint16_t max = 0xFFFF;
+			UnitConvert_Frame(frame, UNIT_RAW_VALUES, pScale, &min, &max);
+
+			for (uint32_t raw = 0; raw < UNIT_RAW_VALUES; raw++)
+			{
+				const uint16_t legacy = test_LegacyConvert((uint16_t)raw, TestModes[m], TestTgains[t]);
+				if(frame[raw] != legacy)
+				{
+					if(differ < 5)
+					{
+						printf("FAIL mode %u tgain 0x%02X raw %u: %u, float code %u\n", TestModes[m], TestTgains[t], raw, frame[raw], legacy);
+					}
+					differ++;
+				}
+			}
+			if(min != test_LegacyConvert(0, TestModes[m], TestTgains[t]) || max != test_LegacyConvert(0xFFFF, TestModes[m], TestTgains[t]))
+			{
+				printf("FAIL mode %u tgain 0x%02X: header min and max differ from the float code\n", TestModes[m], TestTgains[t]);
+				differ++;
+			}
+			if(differ > 0)
+			{
+				printf("FAIL mode %u tgain 0x%02X: %d raw values differ from the float code\n", TestModes[m], TestTgains[t], differ);
+			}
+			failures += differ;
+		}
+	}
+
+	printf("%d vectors, %d failures\n", vectors, failures);
+	return failures;
+}
+
+int main(int argc, char** argv)
+{
+	if(argc < 2)
+	{
+		printf("Usage: %s <vectors> [--write]\n", argv[0]);
+		return 2;
+	}
+	if(argc > 2 && strcmp(argv[2], "--write") == 0)
+	{
+		return test_Write(argv[1]);
+	}
+	return (test_Check(argv[1]) == 0) ? 0 : 1;
+}